@@ -0,0 +1,45 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+package com.intel.webrtc.base;
+import java.nio.ByteBuffer;
+/**
+* Frame generator handing native-memory frames to the capturer without a
+* JNI copy.
+* <p>
+* The capturer owns a pool of direct ByteBuffers wrapping the same native
+* memory the encoder reads, and passes one to generateNextFrame for each
+* capture cycle. Implementations write pixel data straight into the
+* buffer; no Java byte array is involved, so the frame crosses JNI as a
+* pointer instead of a copy. The buffer belongs to the capturer's pool
+* and must not be kept beyond the call - mirroring the pooled-buffer
+* recycling contract of the C++ VideoFrameGeneratorInterface.
+*/
+public interface DirectBufferFrameGenerator {
+    /**
+    * Generates one frame into native memory.
+    * @param buffer, a direct ByteBuffer owned by the capturer's pool. Its
+    *        capacity is at least getNextFrameSize(). Write frame data from
+    *        position zero; do not retain the buffer after returning.
+    * @return the number of bytes written, or 0 to skip this capture cycle.
+    */
+    int generateNextFrame(final ByteBuffer buffer);
+    /**
+    * @return the size in bytes of the next frame, used to select a pool
+    *         buffer with sufficient capacity.
+    */
+    int getNextFrameSize();
+    /**
+    * @return frame width in pixels.
+    */
+    int getWidth();
+    /**
+    * @return frame height in pixels.
+    */
+    int getHeight();
+    /**
+    * @return frames per second this generator produces.
+    */
+    int getFps();
+}
@@ -0,0 +1,68 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_AUDIOFRAMERING_H_
+#define OWT_BASE_AUDIOFRAMERING_H_
+#include <memory>
+#include <string.h>
+#include "webrtc/rtc_base/atomicops.h"
+#include "webrtc/rtc_base/constructormagic.h"
+namespace owt {
+namespace base {
+// Fixed-capacity single-producer/single-consumer ring of equally sized
+// audio frames. Producer and consumer synchronize only through two atomic
+// positions, so neither side ever takes a lock or blocks on the handoff.
+// One thread may produce and one thread may consume concurrently; any other
+// use is not supported.
+class AudioFrameRing {
+ public:
+  AudioFrameRing(size_t frame_size, size_t capacity)
+      : frame_size_(frame_size),
+        capacity_(capacity),
+        storage_(new uint8_t[frame_size * capacity]),
+        write_pos_(0),
+        read_pos_(0) {}
+  // Producer side: returns the next slot to fill, or nullptr when the ring
+  // is full. The slot is not visible to the consumer until CommitWrite.
+  uint8_t* BeginWrite() {
+    int write = write_pos_;
+    int read = rtc::AtomicOps::AcquireLoad(&read_pos_);
+    if (write - read >= static_cast<int>(capacity_))
+      return nullptr;
+    return storage_.get() + (write % capacity_) * frame_size_;
+  }
+  // Publishes the slot returned by the last BeginWrite.
+  void CommitWrite() {
+    rtc::AtomicOps::ReleaseStore(&write_pos_, write_pos_ + 1);
+  }
+  // Consumer side: copies the oldest frame into |dest| and frees its slot.
+  // Returns false when the ring is empty.
+  bool Read(uint8_t* dest) {
+    int read = read_pos_;
+    int write = rtc::AtomicOps::AcquireLoad(&write_pos_);
+    if (read == write)
+      return false;
+    memcpy(dest, storage_.get() + (read % capacity_) * frame_size_,
+           frame_size_);
+    rtc::AtomicOps::ReleaseStore(&read_pos_, read + 1);
+    return true;
+  }
+  // Number of slots the producer may currently fill. Only meaningful when
+  // called from the producer thread.
+  size_t FreeSlots() const {
+    int write = write_pos_;
+    int read = rtc::AtomicOps::AcquireLoad(&read_pos_);
+    return capacity_ - static_cast<size_t>(write - read);
+  }
+  size_t frame_size() const { return frame_size_; }
+ private:
+  const size_t frame_size_;
+  const size_t capacity_;
+  std::unique_ptr<uint8_t[]> storage_;
+  volatile int write_pos_;
+  volatile int read_pos_;
+  RTC_DISALLOW_COPY_AND_ASSIGN(AudioFrameRing);
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_AUDIOFRAMERING_H_
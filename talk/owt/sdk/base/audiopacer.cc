@@ -0,0 +1,98 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include <algorithm>
+#include <limits>
+#include "webrtc/rtc_base/timeutils.h"
+#include "webrtc/system_wrappers/include/sleep.h"
+#include "talk/owt/sdk/base/audiopacer.h"
+#include "talk/owt/sdk/include/cpp/owt/base/connectionstats.h"
+namespace owt {
+namespace base {
+// Audio delivery cadence.
+static const int64_t kPacingIntervalUs = 10000;
+// Scheduler noise below this is expected; anything above counts as a late
+// wakeup.
+static const int64_t kLateWakeupToleranceUs = 2000;
+AudioPacer* AudioPacer::Instance() {
+  static AudioPacer* const pacer = new AudioPacer();
+  return pacer;
+}
+AudioPacer::AudioPacer() {
+  thread_.reset(
+      new rtc::PlatformThread(PacerThreadFunc, this, "owt_audio_pacer"));
+  thread_->Start();
+  thread_->SetPriority(rtc::kRealtimePriority);
+}
+void AudioPacer::AddClient(Client* client) {
+  rtc::CritScope cs(&lock_);
+  ClientEntry entry;
+  entry.client = client;
+  entry.next_deadline_us = rtc::TimeMicros();
+  entry.late_wakeup_count = 0;
+  entry.max_drift_us = 0;
+  clients_.push_back(entry);
+}
+void AudioPacer::RemoveClient(Client* client) {
+  rtc::CritScope cs(&lock_);
+  for (auto it = clients_.begin(); it != clients_.end(); ++it) {
+    if (it->client == client) {
+      clients_.erase(it);
+      break;
+    }
+  }
+}
+bool AudioPacer::PacerThreadFunc(void* pacer) {
+  return static_cast<AudioPacer*>(pacer)->Process();
+}
+// Services every client whose absolute deadline is due, then sleeps until
+// the earliest upcoming deadline. Deadlines advance on the cadence grid so
+// wakeup latency does not accumulate into drift. Callbacks run under
+// |lock_|, which is what lets RemoveClient guarantee no callback is in
+// flight after it returns.
+bool AudioPacer::Process() {
+  int64_t sleep_us = kPacingIntervalUs;
+  {
+    rtc::CritScope cs(&lock_);
+    if (!clients_.empty()) {
+      int64_t now_us = rtc::TimeMicros();
+      int64_t earliest_us = std::numeric_limits<int64_t>::max();
+      for (auto& entry : clients_) {
+        if (entry.next_deadline_us <= now_us) {
+          int64_t drift_us = now_us - entry.next_deadline_us;
+          if (drift_us > kLateWakeupToleranceUs)
+            entry.late_wakeup_count++;
+          entry.max_drift_us = std::max(entry.max_drift_us, drift_us);
+          entry.client->DeliverAudioFrame();
+          entry.next_deadline_us += kPacingIntervalUs;
+          now_us = rtc::TimeMicros();
+          if (entry.next_deadline_us <= now_us) {
+            // Fell a whole interval behind; realign instead of bursting.
+            entry.next_deadline_us +=
+                (now_us - entry.next_deadline_us) / kPacingIntervalUs *
+                    kPacingIntervalUs +
+                kPacingIntervalUs;
+          }
+        }
+        earliest_us = std::min(earliest_us, entry.next_deadline_us);
+      }
+      sleep_us = std::max<int64_t>(0, earliest_us - now_us);
+    }
+  }
+  if (sleep_us > 0)
+    webrtc::SleepMs(static_cast<int>((sleep_us + 999) / 1000));
+  return true;
+}
+std::vector<AudioCapturePacingReport> AudioCapturePacingStats::GetReports() {
+  std::vector<AudioCapturePacingReport> reports;
+  AudioPacer* pacer = AudioPacer::Instance();
+  rtc::CritScope cs(&pacer->lock_);
+  for (auto& entry : pacer->clients_) {
+    reports.push_back(AudioCapturePacingReport(
+        entry.late_wakeup_count, entry.max_drift_us / 1000,
+        entry.client->DeliveryUnderruns()));
+  }
+  return reports;
+}
+}  // namespace base
+}  // namespace owt
@@ -0,0 +1,55 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_AUDIOPACER_H_
+#define OWT_BASE_AUDIOPACER_H_
+#include <memory>
+#include <vector>
+#include "webrtc/rtc_base/criticalsection.h"
+#include "webrtc/rtc_base/platform_thread.h"
+namespace owt {
+namespace base {
+// Process-wide pacing thread that drives 10ms audio delivery for every
+// customized audio capturer in the process. One high-priority thread
+// services all registered clients against per-client absolute deadlines,
+// replacing one mostly idle sleep-loop thread per capturer.
+class AudioPacer {
+ public:
+  // Callback invoked every 10ms on the pacer thread. Implementations must
+  // not block; frame production happens elsewhere.
+  class Client {
+   public:
+    virtual void DeliverAudioFrame() = 0;
+    // Number of deliveries the client skipped because no frame was ready.
+    // Read from the stats path; implementations keep it wait free.
+    virtual int64_t DeliveryUnderruns() const { return 0; }
+    virtual ~Client() {}
+  };
+  // Returns the process-wide pacer, started on first use.
+  static AudioPacer* Instance();
+  // Registers |client| for 10ms-cadence callbacks. Context: any thread.
+  void AddClient(Client* client);
+  // Unregisters |client|. No callback on it is in flight once this
+  // returns. Context: any thread.
+  void RemoveClient(Client* client);
+ private:
+  struct ClientEntry {
+    Client* client;
+    int64_t next_deadline_us;
+    // Pacing health counters, written only on the pacer thread.
+    int64_t late_wakeup_count;
+    int64_t max_drift_us;
+  };
+  // Snapshots per-client counters for AudioCapturePacingStats::GetReports.
+  friend class AudioCapturePacingStats;
+  AudioPacer();
+  static bool PacerThreadFunc(void* pacer);
+  bool Process();
+  std::unique_ptr<rtc::PlatformThread> thread_;
+  rtc::CriticalSection lock_;
+  std::vector<ClientEntry> clients_;
+  RTC_DISALLOW_COPY_AND_ASSIGN(AudioPacer);
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_AUDIOPACER_H_
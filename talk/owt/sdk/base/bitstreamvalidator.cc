@@ -0,0 +1,139 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "talk/owt/sdk/base/bitstreamvalidator.h"
+#include <utility>
+#include "talk/owt/sdk/base/naluscanner.h"
+#include "webrtc/modules/include/module_common_types.h"
+#include "webrtc/rtc_base/logging.h"
+namespace owt {
+namespace base {
+namespace {
+// Frames queued while this many are already waiting are skipped; the
+// validator samples rather than stalls when it falls behind.
+const size_t kMaxQueuedFrames = 8;
+// H.264 NALU types.
+const int kH264NaluIdr = 5;
+const int kH264NaluSps = 7;
+const int kH264NaluPps = 8;
+// H.265 NALU types.
+const int kH265NaluIdrWRadl = 19;
+const int kH265NaluIdrNLp = 20;
+const int kH265NaluSps = 33;
+const int kH265NaluPps = 34;
+}  // namespace
+std::string ValidateAnnexBFrame(webrtc::VideoCodecType codec,
+                                const uint8_t* data,
+                                size_t size,
+                                bool* parameter_sets_seen) {
+  if (data == nullptr || size == 0) {
+    return "empty frame";
+  }
+  // The same vectorized scan the packetizer uses; one fragment per NALU.
+  webrtc::RTPFragmentationHeader header;
+  int32_t nalu_count = ScanNaluFragments(data, size, &header);
+  if (nalu_count == 0) {
+    return "no Annex-B start code found";
+  }
+  bool h265 = codec == webrtc::kVideoCodecH265;
+  bool sps_in_frame = false;
+  bool pps_in_frame = false;
+  for (int32_t i = 0; i < nalu_count; i++) {
+    size_t offset = header.fragmentationOffset[i];
+    size_t length = header.fragmentationLength[i];
+    if (length == 0) {
+      return "empty NALU at index " + std::to_string(i);
+    }
+    uint8_t first_byte = data[offset];
+    if ((first_byte & 0x80) != 0) {
+      return "forbidden_zero_bit set in NALU at index " + std::to_string(i);
+    }
+    int nalu_type = h265 ? (first_byte >> 1) & 0x3F : first_byte & 0x1F;
+    bool is_sps = h265 ? nalu_type == kH265NaluSps : nalu_type == kH264NaluSps;
+    bool is_pps = h265 ? nalu_type == kH265NaluPps : nalu_type == kH264NaluPps;
+    bool is_idr = h265 ? (nalu_type == kH265NaluIdrWRadl ||
+                          nalu_type == kH265NaluIdrNLp)
+                       : nalu_type == kH264NaluIdr;
+    if (is_sps) {
+      sps_in_frame = true;
+    } else if (is_pps) {
+      pps_in_frame = true;
+    } else if (is_idr) {
+      if (sps_in_frame && pps_in_frame) {
+        *parameter_sets_seen = true;
+      }
+      if (!*parameter_sets_seen) {
+        return "IDR NALU before any SPS/PPS";
+      }
+    }
+  }
+  if (sps_in_frame && pps_in_frame) {
+    *parameter_sets_seen = true;
+  }
+  return "";
+}
+BitstreamValidator::BitstreamValidator()
+    : running_(true),
+      worker_started_(false),
+      parameter_sets_seen_(false),
+      frames_skipped_(0) {}
+BitstreamValidator::~BitstreamValidator() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+    wake_.notify_all();
+  }
+  if (worker_started_) {
+    worker_.join();
+  }
+}
+void BitstreamValidator::Submit(VideoEncoderInterface* producer,
+                                webrtc::VideoCodecType codec,
+                                const uint8_t* data,
+                                size_t size) {
+  if (producer == nullptr || data == nullptr || size == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (queue_.size() >= kMaxQueuedFrames) {
+    frames_skipped_++;
+    if (frames_skipped_ % 100 == 1) {
+      RTC_LOG(LS_WARNING) << "Bitstream validation falling behind; skipped "
+                          << frames_skipped_ << " frames so far.";
+    }
+    return;
+  }
+  QueuedFrame frame;
+  frame.producer = producer;
+  frame.codec = codec;
+  frame.data.assign(data, data + size);
+  queue_.push_back(std::move(frame));
+  // The worker exists only once a frame has actually been submitted.
+  if (!worker_started_) {
+    worker_started_ = true;
+    worker_ = std::thread(&BitstreamValidator::ValidationLoop, this);
+  }
+  wake_.notify_one();
+}
+void BitstreamValidator::ValidationLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (running_) {
+    if (queue_.empty()) {
+      wake_.wait(lock);
+      continue;
+    }
+    QueuedFrame frame = std::move(queue_.front());
+    queue_.pop_front();
+    lock.unlock();
+    std::string defect = ValidateAnnexBFrame(
+        frame.codec, frame.data.data(), frame.data.size(),
+        &parameter_sets_seen_);
+    if (!defect.empty()) {
+      RTC_LOG(LS_ERROR) << "Injected bitstream failed validation: " << defect;
+      frame.producer->OnBitstreamValidationError(defect);
+    }
+    lock.lock();
+  }
+}
+}  // namespace base
+}  // namespace owt
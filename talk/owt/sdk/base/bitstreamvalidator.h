@@ -0,0 +1,72 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_BITSTREAMVALIDATOR_H_
+#define OWT_BASE_BITSTREAMVALIDATOR_H_
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "talk/owt/sdk/include/cpp/owt/base/videoencoderinterface.h"
+#include "webrtc/common_types.h"
+// Off-hot-path validation of injected encoded bitstreams. The encode
+// proxy only scans for start codes to build fragmentation, so a
+// malformed customer bitstream is discovered as a decode failure on the
+// far side, long after the producing frame. When enabled, each frame is
+// copied onto a per-publication worker thread that checks Annex-B
+// well-formedness - start codes, NALU lengths, the forbidden bit - and
+// tracks that parameter sets arrive before the first IDR. The first
+// defect in a frame is reported straight back to the producing
+// VideoEncoderInterface, so a bad encoder is caught on the frame that
+// produced the damage. The hot path pays one memcpy per frame while
+// validation is on, and nothing when it is off.
+namespace owt {
+namespace base {
+// Checks one Annex-B access unit. |parameter_sets_seen| carries the
+// SPS/PPS state across frames of one stream: it is set once both have
+// been observed and read to require them before the first IDR. Returns
+// an empty string when the frame is well-formed, otherwise a
+// description of the first defect. Exposed separately from the threaded
+// wrapper for testing.
+std::string ValidateAnnexBFrame(webrtc::VideoCodecType codec,
+                                const uint8_t* data,
+                                size_t size,
+                                bool* parameter_sets_seen);
+class BitstreamValidator {
+ public:
+  BitstreamValidator();
+  // Joins the worker; queued frames that have not been validated yet
+  // are dropped.
+  ~BitstreamValidator();
+  // Queues a copy of one encoded frame for validation. |producer|
+  // receives OnBitstreamValidationError calls and must stay valid for
+  // the validator's lifetime. Frames arriving while the queue is full
+  // are skipped, so a slow validation pass samples instead of stalling
+  // the encode path.
+  void Submit(VideoEncoderInterface* producer,
+              webrtc::VideoCodecType codec,
+              const uint8_t* data,
+              size_t size);
+
+ private:
+  struct QueuedFrame {
+    VideoEncoderInterface* producer;
+    webrtc::VideoCodecType codec;
+    std::vector<uint8_t> data;
+  };
+  void ValidationLoop();
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::deque<QueuedFrame> queue_;
+  bool running_;
+  bool worker_started_;
+  // SPS/PPS presence for the single stream this validator watches.
+  bool parameter_sets_seen_;
+  uint64_t frames_skipped_;
+  std::thread worker_;
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_BITSTREAMVALIDATOR_H_
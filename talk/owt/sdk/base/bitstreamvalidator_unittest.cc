@@ -0,0 +1,77 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "talk/owt/sdk/base/bitstreamvalidator.h"
+#include <vector>
+#include "testing/gtest/include/gtest/gtest.h"
+namespace owt {
+namespace base {
+namespace {
+// Appends one Annex-B NALU with a long start code and the given header
+// byte.
+void AppendNalu(std::vector<uint8_t>* stream,
+                uint8_t header_byte,
+                size_t payload_size) {
+  const uint8_t start_code[] = {0, 0, 0, 1};
+  stream->insert(stream->end(), start_code, start_code + 4);
+  stream->push_back(header_byte);
+  stream->insert(stream->end(), payload_size, 0xAA);
+}
+}  // namespace
+TEST(BitstreamValidatorTest, AcceptsWellFormedH264Keyframe) {
+  std::vector<uint8_t> frame;
+  AppendNalu(&frame, 0x67, 8);  // SPS
+  AppendNalu(&frame, 0x68, 4);  // PPS
+  AppendNalu(&frame, 0x65, 64);  // IDR
+  bool parameter_sets_seen = false;
+  EXPECT_EQ(ValidateAnnexBFrame(webrtc::kVideoCodecH264, frame.data(),
+                                frame.size(), &parameter_sets_seen),
+            "");
+  EXPECT_TRUE(parameter_sets_seen);
+  // A delta frame after the keyframe is fine.
+  std::vector<uint8_t> delta;
+  AppendNalu(&delta, 0x41, 32);  // non-IDR slice
+  EXPECT_EQ(ValidateAnnexBFrame(webrtc::kVideoCodecH264, delta.data(),
+                                delta.size(), &parameter_sets_seen),
+            "");
+}
+TEST(BitstreamValidatorTest, RejectsIdrBeforeParameterSets) {
+  std::vector<uint8_t> frame;
+  AppendNalu(&frame, 0x65, 64);  // IDR with no SPS/PPS anywhere
+  bool parameter_sets_seen = false;
+  EXPECT_NE(ValidateAnnexBFrame(webrtc::kVideoCodecH264, frame.data(),
+                                frame.size(), &parameter_sets_seen),
+            "");
+  EXPECT_FALSE(parameter_sets_seen);
+}
+TEST(BitstreamValidatorTest, RejectsMissingStartCodeAndForbiddenBit) {
+  const uint8_t garbage[] = {0x12, 0x34, 0x56, 0x78};
+  bool parameter_sets_seen = false;
+  EXPECT_NE(ValidateAnnexBFrame(webrtc::kVideoCodecH264, garbage,
+                                sizeof(garbage), &parameter_sets_seen),
+            "");
+  std::vector<uint8_t> frame;
+  AppendNalu(&frame, 0x67, 8);
+  AppendNalu(&frame, 0xE5, 16);  // forbidden_zero_bit set
+  EXPECT_NE(ValidateAnnexBFrame(webrtc::kVideoCodecH264, frame.data(),
+                                frame.size(), &parameter_sets_seen),
+            "");
+  EXPECT_NE(ValidateAnnexBFrame(webrtc::kVideoCodecH264, nullptr, 0,
+                                &parameter_sets_seen),
+            "");
+}
+#ifndef DISABLE_H265
+TEST(BitstreamValidatorTest, TracksH265ParameterSets) {
+  std::vector<uint8_t> frame;
+  AppendNalu(&frame, 33 << 1, 8);  // SPS
+  AppendNalu(&frame, 34 << 1, 4);  // PPS
+  AppendNalu(&frame, 19 << 1, 64);  // IDR_W_RADL
+  bool parameter_sets_seen = false;
+  EXPECT_EQ(ValidateAnnexBFrame(webrtc::kVideoCodecH265, frame.data(),
+                                frame.size(), &parameter_sets_seen),
+            "");
+  EXPECT_TRUE(parameter_sets_seen);
+}
+#endif
+}  // namespace base
+}  // namespace owt
@@ -0,0 +1,245 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <utility>
+#include "talk/owt/sdk/include/cpp/owt/base/columnarstats.h"
+namespace owt {
+namespace base {
+namespace {
+void AppendU32(std::vector<uint8_t>* out, uint32_t value) {
+  out->push_back(static_cast<uint8_t>(value));
+  out->push_back(static_cast<uint8_t>(value >> 8));
+  out->push_back(static_cast<uint8_t>(value >> 16));
+  out->push_back(static_cast<uint8_t>(value >> 24));
+}
+void AppendI32(std::vector<uint8_t>* out, int32_t value) {
+  AppendU32(out, static_cast<uint32_t>(value));
+}
+void AppendI64(std::vector<uint8_t>* out, int64_t value) {
+  uint64_t bits = static_cast<uint64_t>(value);
+  for (int shift = 0; shift < 64; shift += 8) {
+    out->push_back(static_cast<uint8_t>(bits >> shift));
+  }
+}
+void PatchU32(std::vector<uint8_t>* out, size_t at, uint32_t value) {
+  (*out)[at] = static_cast<uint8_t>(value);
+  (*out)[at + 1] = static_cast<uint8_t>(value >> 8);
+  (*out)[at + 2] = static_cast<uint8_t>(value >> 16);
+  (*out)[at + 3] = static_cast<uint8_t>(value >> 24);
+}
+// Deduplicating string table; offsets are blob relative.
+class StringBlob {
+ public:
+  std::pair<uint32_t, uint32_t> Add(const std::string& text) {
+    auto it = offsets_.find(text);
+    if (it == offsets_.end()) {
+      it = offsets_.emplace(text, static_cast<uint32_t>(blob_.size())).first;
+      blob_.append(text);
+    }
+    return std::make_pair(it->second, static_cast<uint32_t>(text.size()));
+  }
+  const std::string& blob() const { return blob_; }
+
+ private:
+  std::string blob_;
+  std::map<std::string, uint32_t> offsets_;
+};
+// One flattened report row: the session it belongs to and the report.
+template <typename Report>
+using ReportRows = std::vector<std::pair<uint32_t, const Report*>>;
+template <typename Report>
+void AppendSessionIndexColumn(std::vector<uint8_t>* out,
+                              const ReportRows<Report>& rows) {
+  for (const auto& row : rows) {
+    AppendU32(out, row.first);
+  }
+}
+template <typename Report, typename Getter>
+void AppendI32Column(std::vector<uint8_t>* out,
+                     const ReportRows<Report>& rows,
+                     Getter get) {
+  for (const auto& row : rows) {
+    AppendI32(out, static_cast<int32_t>(get(*row.second)));
+  }
+}
+template <typename Report, typename Getter>
+void AppendI64Column(std::vector<uint8_t>* out,
+                     const ReportRows<Report>& rows,
+                     Getter get) {
+  for (const auto& row : rows) {
+    AppendI64(out, get(*row.second));
+  }
+}
+template <typename Report>
+void AppendCodecColumn(std::vector<uint8_t>* out,
+                       const ReportRows<Report>& rows,
+                       StringBlob* blob) {
+  for (const auto& row : rows) {
+    std::pair<uint32_t, uint32_t> ref = blob->Add(row.second->codec_name);
+    AppendU32(out, ref.first);
+    AppendU32(out, ref.second);
+  }
+}
+}  // namespace
+const uint32_t ColumnarStatsWriter::kFormatVersion;
+std::vector<uint8_t> ColumnarStatsWriter::Serialize(
+    const std::unordered_map<std::string, std::shared_ptr<ConnectionStats>>&
+        snapshot) {
+  // Sessions are sorted by id so consecutive exports line up row for row
+  // while the session set is stable.
+  std::vector<const std::pair<const std::string,
+                              std::shared_ptr<ConnectionStats>>*>
+      sessions;
+  sessions.reserve(snapshot.size());
+  for (const auto& entry : snapshot) {
+    if (entry.second != nullptr) {
+      sessions.push_back(&entry);
+    }
+  }
+  std::sort(sessions.begin(), sessions.end(),
+            [](const std::pair<const std::string,
+                               std::shared_ptr<ConnectionStats>>* a,
+               const std::pair<const std::string,
+                               std::shared_ptr<ConnectionStats>>* b) {
+              return a->first < b->first;
+            });
+  ReportRows<AudioSenderReport> audio_send_rows;
+  ReportRows<AudioReceiverReport> audio_recv_rows;
+  ReportRows<VideoSenderReport> video_send_rows;
+  ReportRows<VideoReceiverReport> video_recv_rows;
+  for (uint32_t i = 0; i < sessions.size(); i++) {
+    const ConnectionStats& stats = *sessions[i]->second;
+    for (const auto& report : stats.audio_sender_reports)
+      audio_send_rows.push_back(std::make_pair(i, report.get()));
+    for (const auto& report : stats.audio_receiver_reports)
+      audio_recv_rows.push_back(std::make_pair(i, report.get()));
+    for (const auto& report : stats.video_sender_reports)
+      video_send_rows.push_back(std::make_pair(i, report.get()));
+    for (const auto& report : stats.video_receiver_reports)
+      video_recv_rows.push_back(std::make_pair(i, report.get()));
+  }
+  StringBlob blob;
+  std::vector<uint8_t> buffer;
+  buffer.reserve(64 + sessions.size() * 40 +
+                 (audio_send_rows.size() + audio_recv_rows.size()) * 40 +
+                 (video_send_rows.size() + video_recv_rows.size()) * 80);
+  buffer.push_back('O');
+  buffer.push_back('W');
+  buffer.push_back('T');
+  buffer.push_back('C');
+  AppendU32(&buffer, kFormatVersion);
+  AppendI64(&buffer,
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch())
+                .count());
+  AppendU32(&buffer, static_cast<uint32_t>(sessions.size()));
+  AppendU32(&buffer, static_cast<uint32_t>(audio_send_rows.size()));
+  AppendU32(&buffer, static_cast<uint32_t>(audio_recv_rows.size()));
+  AppendU32(&buffer, static_cast<uint32_t>(video_send_rows.size()));
+  AppendU32(&buffer, static_cast<uint32_t>(video_recv_rows.size()));
+  // Blob offset and size are known only once all columns are written.
+  size_t blob_header_at = buffer.size();
+  AppendU32(&buffer, 0);
+  AppendU32(&buffer, 0);
+  for (const auto* session : sessions) {
+    std::pair<uint32_t, uint32_t> ref = blob.Add(session->first);
+    AppendU32(&buffer, ref.first);
+    AppendU32(&buffer, ref.second);
+  }
+  // Audio sender group.
+  AppendSessionIndexColumn(&buffer, audio_send_rows);
+  AppendI64Column(&buffer, audio_send_rows,
+                  [](const AudioSenderReport& r) { return r.bytes_sent; });
+  AppendI32Column(&buffer, audio_send_rows,
+                  [](const AudioSenderReport& r) { return r.packets_sent; });
+  AppendI32Column(&buffer, audio_send_rows,
+                  [](const AudioSenderReport& r) { return r.packets_lost; });
+  AppendI64Column(&buffer, audio_send_rows, [](const AudioSenderReport& r) {
+    return r.round_trip_time;
+  });
+  AppendCodecColumn(&buffer, audio_send_rows, &blob);
+  // Audio receiver group.
+  AppendSessionIndexColumn(&buffer, audio_recv_rows);
+  AppendI64Column(&buffer, audio_recv_rows,
+                  [](const AudioReceiverReport& r) { return r.bytes_rcvd; });
+  AppendI32Column(&buffer, audio_recv_rows,
+                  [](const AudioReceiverReport& r) { return r.packets_rcvd; });
+  AppendI32Column(&buffer, audio_recv_rows,
+                  [](const AudioReceiverReport& r) { return r.packets_lost; });
+  AppendI32Column(&buffer, audio_recv_rows, [](const AudioReceiverReport& r) {
+    return r.estimated_delay;
+  });
+  AppendCodecColumn(&buffer, audio_recv_rows, &blob);
+  // Video sender group.
+  AppendSessionIndexColumn(&buffer, video_send_rows);
+  AppendI64Column(&buffer, video_send_rows,
+                  [](const VideoSenderReport& r) { return r.bytes_sent; });
+  AppendI32Column(&buffer, video_send_rows,
+                  [](const VideoSenderReport& r) { return r.packets_sent; });
+  AppendI32Column(&buffer, video_send_rows,
+                  [](const VideoSenderReport& r) { return r.packets_lost; });
+  AppendI32Column(&buffer, video_send_rows,
+                  [](const VideoSenderReport& r) { return r.fir_count; });
+  AppendI32Column(&buffer, video_send_rows,
+                  [](const VideoSenderReport& r) { return r.pli_count; });
+  AppendI32Column(&buffer, video_send_rows,
+                  [](const VideoSenderReport& r) { return r.nack_count; });
+  AppendI32Column(&buffer, video_send_rows, [](const VideoSenderReport& r) {
+    return static_cast<int32_t>(r.frame_resolution_sent.width);
+  });
+  AppendI32Column(&buffer, video_send_rows, [](const VideoSenderReport& r) {
+    return static_cast<int32_t>(r.frame_resolution_sent.height);
+  });
+  AppendI32Column(&buffer, video_send_rows,
+                  [](const VideoSenderReport& r) { return r.framerate_sent; });
+  AppendI32Column(&buffer, video_send_rows, [](const VideoSenderReport& r) {
+    return r.last_adapt_reason;
+  });
+  AppendI32Column(&buffer, video_send_rows,
+                  [](const VideoSenderReport& r) { return r.adapt_changes; });
+  AppendI64Column(&buffer, video_send_rows, [](const VideoSenderReport& r) {
+    return r.round_trip_time;
+  });
+  AppendCodecColumn(&buffer, video_send_rows, &blob);
+  // Video receiver group.
+  AppendSessionIndexColumn(&buffer, video_recv_rows);
+  AppendI64Column(&buffer, video_recv_rows,
+                  [](const VideoReceiverReport& r) { return r.bytes_rcvd; });
+  AppendI32Column(&buffer, video_recv_rows,
+                  [](const VideoReceiverReport& r) { return r.packets_rcvd; });
+  AppendI32Column(&buffer, video_recv_rows,
+                  [](const VideoReceiverReport& r) { return r.packets_lost; });
+  AppendI32Column(&buffer, video_recv_rows,
+                  [](const VideoReceiverReport& r) { return r.fir_count; });
+  AppendI32Column(&buffer, video_recv_rows,
+                  [](const VideoReceiverReport& r) { return r.pli_count; });
+  AppendI32Column(&buffer, video_recv_rows,
+                  [](const VideoReceiverReport& r) { return r.nack_count; });
+  AppendI32Column(&buffer, video_recv_rows, [](const VideoReceiverReport& r) {
+    return static_cast<int32_t>(r.frame_resolution_rcvd.width);
+  });
+  AppendI32Column(&buffer, video_recv_rows, [](const VideoReceiverReport& r) {
+    return static_cast<int32_t>(r.frame_resolution_rcvd.height);
+  });
+  AppendI32Column(&buffer, video_recv_rows, [](const VideoReceiverReport& r) {
+    return r.framerate_rcvd;
+  });
+  AppendI32Column(&buffer, video_recv_rows, [](const VideoReceiverReport& r) {
+    return r.framerate_output;
+  });
+  AppendI32Column(&buffer, video_recv_rows,
+                  [](const VideoReceiverReport& r) { return r.delay; });
+  AppendI32Column(&buffer, video_recv_rows,
+                  [](const VideoReceiverReport& r) { return r.jitter; });
+  AppendCodecColumn(&buffer, video_recv_rows, &blob);
+  PatchU32(&buffer, blob_header_at, static_cast<uint32_t>(buffer.size()));
+  PatchU32(&buffer, blob_header_at + 4,
+           static_cast<uint32_t>(blob.blob().size()));
+  buffer.insert(buffer.end(), blob.blob().begin(), blob.blob().end());
+  return buffer;
+}
+}  // namespace base
+}  // namespace owt
@@ -0,0 +1,95 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "talk/owt/sdk/base/configurationsnapshot.h"
+#include <cstdio>
+#include <cstring>
+#include "webrtc/rtc_base/logging.h"
+namespace owt {
+namespace base {
+namespace {
+const uint32_t kMagic = 0x4F575443;  // "OWTC"
+const uint32_t kVersion = 1;
+const size_t kHeaderBytes = 16;
+const size_t kEntryBytes = 16;
+// Entries are bounded so a corrupt count cannot drive a huge
+// allocation before the size check catches it.
+const uint32_t kMaxEntries = 1024;
+uint32_t ReadU32(const uint8_t* at) {
+  uint32_t value;
+  memcpy(&value, at, sizeof(value));
+  return value;
+}
+int64_t ReadI64(const uint8_t* at) {
+  int64_t value;
+  memcpy(&value, at, sizeof(value));
+  return value;
+}
+}  // namespace
+bool ParseConfigurationSnapshot(
+    const uint8_t* data,
+    size_t size,
+    std::vector<ConfigurationSnapshotEntry>* entries) {
+  if (data == nullptr || entries == nullptr || size < kHeaderBytes) {
+    return false;
+  }
+  if (ReadU32(data) != kMagic) {
+    RTC_LOG(LS_ERROR) << "Configuration snapshot carries a wrong magic.";
+    return false;
+  }
+  if (ReadU32(data + 4) != kVersion) {
+    RTC_LOG(LS_ERROR) << "Unsupported configuration snapshot version "
+                      << ReadU32(data + 4);
+    return false;
+  }
+  uint32_t count = ReadU32(data + 8);
+  if (count > kMaxEntries || ReadU32(data + 12) != 0) {
+    return false;
+  }
+  if (size < kHeaderBytes + static_cast<size_t>(count) * kEntryBytes) {
+    RTC_LOG(LS_ERROR) << "Configuration snapshot is truncated.";
+    return false;
+  }
+  std::vector<ConfigurationSnapshotEntry> parsed;
+  parsed.reserve(count);
+  for (uint32_t i = 0; i < count; i++) {
+    const uint8_t* record = data + kHeaderBytes + i * kEntryBytes;
+    if (ReadU32(record + 4) != 0) {
+      return false;
+    }
+    ConfigurationSnapshotEntry entry;
+    entry.key = ReadU32(record);
+    entry.value = ReadI64(record + 8);
+    parsed.push_back(entry);
+  }
+  entries->swap(parsed);
+  return true;
+}
+bool ReadConfigurationSnapshot(
+    const std::string& path,
+    std::vector<ConfigurationSnapshotEntry>* entries) {
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    RTC_LOG(LS_WARNING) << "Configuration snapshot " << path
+                        << " cannot be opened.";
+    return false;
+  }
+  fseek(file, 0, SEEK_END);
+  long file_size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  if (file_size <= 0 ||
+      static_cast<size_t>(file_size) >
+          kHeaderBytes + static_cast<size_t>(kMaxEntries) * kEntryBytes) {
+    fclose(file);
+    return false;
+  }
+  std::vector<uint8_t> image(static_cast<size_t>(file_size));
+  size_t read = fread(image.data(), 1, image.size(), file);
+  fclose(file);
+  if (read != image.size()) {
+    return false;
+  }
+  return ParseConfigurationSnapshot(image.data(), image.size(), entries);
+}
+}  // namespace base
+}  // namespace owt
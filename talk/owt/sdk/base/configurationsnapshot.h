@@ -0,0 +1,68 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_CONFIGURATIONSNAPSHOT_H_
+#define OWT_BASE_CONFIGURATIONSNAPSHOT_H_
+#include <cstdint>
+#include <string>
+#include <vector>
+// Reader for the startup configuration snapshot file. The file is a
+// flat binary table - a fixed header followed by key/value records -
+// so loading it is one bulk read and a bounds-checked scan, with no
+// parsing allocations beyond the returned vector. Deployment tooling
+// writes the file; GlobalConfiguration::LoadConfigurationSnapshot
+// applies known keys to the same static fields every steady-state
+// lookup already reads, so a deployed snapshot adds zero per-lookup
+// cost.
+//
+// Layout, all fields little-endian:
+//   uint32 magic      'OWTC' (0x4F575443)
+//   uint32 version    currently 1
+//   uint32 entry_count
+//   uint32 reserved   must be zero
+// followed by entry_count records of:
+//   uint32 key        see ConfigurationSnapshotKey
+//   uint32 reserved   must be zero
+//   int64  value
+// Unknown keys are preserved by the reader and skipped by the applier,
+// so a newer tool can ship keys an older SDK ignores.
+namespace owt {
+namespace base {
+// Stable key identifiers; values are wire format and must not be
+// renumbered.
+enum class ConfigurationSnapshotKey : uint32_t {
+  kVideoHardwareAccelerationEnabled = 1,
+  kHardwareEncoderPreset = 2,
+  kGpuSurfaceBudgetMB = 3,
+  kCodecThreadAffinityMask = 4,
+  kCaptureThreadAffinityMask = 5,
+  kCodecAdapterIndex = 6,
+  kDecodeThreadPoolSize = 7,
+  kSoftwareFallbackThreadCount = 8,
+  kSharedCaptureThreadEnabled = 9,
+  kPeerConnectionFactoryCount = 10,
+  kLatestFrameRenderingEnabled = 11,
+  kKeyFrameRequestCoalescingWindowMs = 12,
+  kEncodedVideoTemporalLayers = 13,
+  kEncodedBitstreamValidationEnabled = 14,
+  kVideoFreezeThresholdMs = 15,
+  kAudioProcessingBypassedForCustomizedInput = 16,
+  kInjectedAudioSilenceSuppressionEnabled = 17,
+  kD3D11CameraCaptureEnabled = 18,
+  kSoftwareFallbackPreset = 19,
+};
+struct ConfigurationSnapshotEntry {
+  uint32_t key;
+  int64_t value;
+};
+// Parses an in-memory snapshot image. Returns false when the header or
+// any record is malformed; |entries| is untouched on failure.
+bool ParseConfigurationSnapshot(const uint8_t* data,
+                                size_t size,
+                                std::vector<ConfigurationSnapshotEntry>* entries);
+// Reads and parses the snapshot file at |path| in one bulk read.
+bool ReadConfigurationSnapshot(const std::string& path,
+                               std::vector<ConfigurationSnapshotEntry>* entries);
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_CONFIGURATIONSNAPSHOT_H_
@@ -0,0 +1,85 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "talk/owt/sdk/base/configurationsnapshot.h"
+#include <cstring>
+#include <vector>
+#include "testing/gtest/include/gtest/gtest.h"
+namespace owt {
+namespace base {
+namespace {
+void AppendU32(std::vector<uint8_t>* out, uint32_t value) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+  out->insert(out->end(), bytes, bytes + sizeof(value));
+}
+void AppendI64(std::vector<uint8_t>* out, int64_t value) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+  out->insert(out->end(), bytes, bytes + sizeof(value));
+}
+std::vector<uint8_t> BuildSnapshot(
+    const std::vector<ConfigurationSnapshotEntry>& entries) {
+  std::vector<uint8_t> image;
+  AppendU32(&image, 0x4F575443);  // magic
+  AppendU32(&image, 1);           // version
+  AppendU32(&image, static_cast<uint32_t>(entries.size()));
+  AppendU32(&image, 0);
+  for (const ConfigurationSnapshotEntry& entry : entries) {
+    AppendU32(&image, entry.key);
+    AppendU32(&image, 0);
+    AppendI64(&image, entry.value);
+  }
+  return image;
+}
+}  // namespace
+TEST(ConfigurationSnapshotTest, ParsesEntriesInOrder) {
+  std::vector<ConfigurationSnapshotEntry> written = {
+      {static_cast<uint32_t>(
+           ConfigurationSnapshotKey::kPeerConnectionFactoryCount),
+       4},
+      {static_cast<uint32_t>(ConfigurationSnapshotKey::kGpuSurfaceBudgetMB),
+       512},
+      {9999, -7},  // unknown key travels through the parser untouched
+  };
+  std::vector<uint8_t> image = BuildSnapshot(written);
+  std::vector<ConfigurationSnapshotEntry> parsed;
+  ASSERT_TRUE(ParseConfigurationSnapshot(image.data(), image.size(), &parsed));
+  ASSERT_EQ(parsed.size(), written.size());
+  for (size_t i = 0; i < written.size(); i++) {
+    EXPECT_EQ(parsed[i].key, written[i].key);
+    EXPECT_EQ(parsed[i].value, written[i].value);
+  }
+}
+TEST(ConfigurationSnapshotTest, RejectsBadHeaderAndTruncation) {
+  std::vector<ConfigurationSnapshotEntry> written = {
+      {static_cast<uint32_t>(ConfigurationSnapshotKey::kGpuSurfaceBudgetMB),
+       256},
+  };
+  std::vector<uint8_t> image = BuildSnapshot(written);
+  std::vector<ConfigurationSnapshotEntry> parsed;
+  // Wrong magic.
+  std::vector<uint8_t> bad_magic = image;
+  bad_magic[0] ^= 0xFF;
+  EXPECT_FALSE(
+      ParseConfigurationSnapshot(bad_magic.data(), bad_magic.size(), &parsed));
+  // Unsupported version.
+  std::vector<uint8_t> bad_version = image;
+  bad_version[4] = 9;
+  EXPECT_FALSE(ParseConfigurationSnapshot(bad_version.data(),
+                                          bad_version.size(), &parsed));
+  // Count claims more records than the file holds.
+  std::vector<uint8_t> truncated = image;
+  truncated.resize(truncated.size() - 8);
+  EXPECT_FALSE(
+      ParseConfigurationSnapshot(truncated.data(), truncated.size(), &parsed));
+  EXPECT_FALSE(ParseConfigurationSnapshot(nullptr, 0, &parsed));
+  // |parsed| was never touched by the failures above.
+  EXPECT_TRUE(parsed.empty());
+}
+TEST(ConfigurationSnapshotTest, EmptySnapshotIsValid) {
+  std::vector<uint8_t> image = BuildSnapshot({});
+  std::vector<ConfigurationSnapshotEntry> parsed = {{1, 1}};
+  ASSERT_TRUE(ParseConfigurationSnapshot(image.data(), image.size(), &parsed));
+  EXPECT_TRUE(parsed.empty());
+}
+}  // namespace base
+}  // namespace owt
@@ -1,13 +1,30 @@
 // Copyright (C) <2018> Intel Corporation
 //
 // SPDX-License-Identifier: Apache-2.0
+#include <algorithm>
 #include "talk/owt/sdk/base/customizedaudiocapturer.h"
+#include "talk/owt/sdk/include/cpp/owt/base/globalconfiguration.h"
 #include "webrtc/rtc_base/checks.h"
 #include "webrtc/rtc_base/logging.h"
 #include "webrtc/system_wrappers/include/sleep.h"
 using namespace rtc;
 namespace owt {
 namespace base {
+// Depth of the generator-to-delivery ring. Enough to absorb a slow
+// GenerateFramesForNext10Ms without starving delivery, small enough to cap
+// added latency at a few frames.
+static const size_t kAudioRingCapacityIn10MsFrames = 8;
+// Frames requested from the generator per wakeup. Half the ring, so a batch
+// can always complete while delivery drains the other half.
+static const uint32_t kAudioBatchIn10MsFrames = 4;
+// A frame whose mean absolute amplitude stays below this counts as silent.
+// 16 of 32767 is around -66 dBFS, well under any audible program material
+// but above dither and low-level generator noise.
+static const int kSilenceMeanAbsAmplitude = 16;
+// Consecutive silent frames before delivery is suppressed. 300ms keeps
+// ordinary speech pauses flowing, so suppression only engages on streams
+// that have actually gone quiet.
+static const int kSilenceHangoverFrames = 30;
 CustomizedAudioCapturer::CustomizedAudioCapturer(
     std::unique_ptr<AudioFrameGeneratorInterface> frame_generator)
     : frame_generator_(std::move(frame_generator)),
@@ -17,10 +34,11 @@ CustomizedAudioCapturer::CustomizedAudioCapturer(
       recording_sample_rate_(0),
       recording_channel_number_(0),
       recording_(false),
-      last_call_record_millis_(0),
-      clock_(Clock::GetRealTimeClock()),
-      need_sleep_ms_(0),
-      real_sleep_ms_(0) {}
+      underrun_count_(0),
+      silence_suppression_enabled_(
+          GlobalConfiguration::GetInjectedAudioSilenceSuppressionEnabled()),
+      silent_streak_(0),
+      suppressing_(false) {}
 CustomizedAudioCapturer::~CustomizedAudioCapturer() {}
 int32_t CustomizedAudioCapturer::ActiveAudioLayer(
     AudioDeviceModule::AudioLayer& audioLayer) const {
@@ -106,6 +124,10 @@ int32_t CustomizedAudioCapturer::InitRecording() {
       recording_frames_in_10ms_ * recording_channel_number_ * 2;
   recording_buffer_.reset(static_cast<uint8_t*>(webrtc::AlignedMalloc<uint8_t>(
       recording_buffer_size_ * sizeof(uint8_t), 16)));
+  audio_ring_.reset(new AudioFrameRing(recording_buffer_size_,
+                                       kAudioRingCapacityIn10MsFrames));
+  batch_buffer_.reset(
+      new uint8_t[recording_buffer_size_ * kAudioBatchIn10MsFrames]);
   if (audio_buffer_) {
     audio_buffer_->SetRecordingChannels(frame_generator_->GetChannelNumber());
     audio_buffer_->SetRecordingSampleRate(frame_generator_->GetSampleRate());
@@ -129,10 +151,14 @@ bool CustomizedAudioCapturer::Playing() const {
 }
 int32_t CustomizedAudioCapturer::StartRecording() {
   recording_ = true;
-  const char* thread_name = "webrtc_audio_module_capture_thread";
-  thread_rec_.reset(new rtc::PlatformThread(RecThreadFunc, this, thread_name));
-  thread_rec_->Start();
-  thread_rec_->SetPriority(rtc::kRealtimePriority);
+  const char* gen_thread_name = "owt_audio_frame_generator_thread";
+  thread_gen_.reset(
+      new rtc::PlatformThread(GenThreadFunc, this, gen_thread_name));
+  thread_gen_->Start();
+  thread_gen_->SetPriority(rtc::kHighPriority);
+  // Delivery is driven by the process-wide pacer thread shared by all
+  // customized audio capturers.
+  AudioPacer::Instance()->AddClient(this);
   return 0;
 }
 int32_t CustomizedAudioCapturer::StopRecording() {
@@ -140,9 +166,10 @@ int32_t CustomizedAudioCapturer::StopRecording() {
     rtc::CritScope lock(&crit_sect_);
     recording_ = false;
   }
-  if (thread_rec_) {
-    thread_rec_->Stop();
-    thread_rec_.reset();
+  AudioPacer::Instance()->RemoveClient(this);
+  if (thread_gen_) {
+    thread_gen_->Stop();
+    thread_gen_.reset();
   }
   return 0;
 }
@@ -250,48 +277,104 @@ void CustomizedAudioCapturer::AttachAudioBuffer(
 bool CustomizedAudioCapturer::PlayThreadFunc(void* pThis) {
   return false;
 }
-bool CustomizedAudioCapturer::RecThreadFunc(void* pThis) {
-  return (static_cast<CustomizedAudioCapturer*>(pThis)->RecThreadProcess());
-}
-bool CustomizedAudioCapturer::RecThreadProcess() {
+// Producer side of |audio_ring_|: requests a batch of 10ms frames per
+// wakeup and keeps the ring filled ahead of the delivery deadline, so the
+// per-frame virtual call and wakeup overhead is amortized across the batch.
+// Context: thread_gen_.
+bool CustomizedAudioCapturer::GenThreadProcess() {
   if (!recording_) {
     return false;
   }
-  uint64_t current_time = clock_->CurrentNtpInMilliseconds();
-  crit_sect_.Enter();
-  if (last_call_record_millis_ == 0 ||
-      (int64_t)(current_time - last_call_record_millis_) >= need_sleep_ms_) {
-    if (frame_generator_->GenerateFramesForNext10Ms(
-            recording_buffer_.get(),
-            static_cast<uint32_t>(recording_buffer_size_)) !=
-        static_cast<uint32_t>(recording_buffer_size_)) {
-      crit_sect_.Leave();
-      //RTC_DCHECK(false);
-      SleepMs(1);
-      RTC_LOG(LS_ERROR) << "Get audio frames failed.";
-      return true;
-    }
-    // Sample rate and channel number cannot be changed on the fly.
-    audio_buffer_->SetRecordedBuffer(
-        recording_buffer_.get(), recording_frames_in_10ms_);  // Buffer copied here
-    last_call_record_millis_ = current_time;
-    crit_sect_.Leave();
-    audio_buffer_->DeliverRecordedData();
-    crit_sect_.Enter();
+  uint32_t free_slots = static_cast<uint32_t>(audio_ring_->FreeSlots());
+  if (free_slots == 0) {
+    // Ring is full; we are a full ring ahead of delivery.
+    SleepMs(2);
+    return true;
+  }
+  uint32_t frame_count = std::min(free_slots, kAudioBatchIn10MsFrames);
+  uint32_t batch_capacity =
+      frame_count * static_cast<uint32_t>(recording_buffer_size_);
+  uint32_t written = frame_generator_->GenerateFramesForNextNx10Ms(
+      batch_buffer_.get(), batch_capacity, frame_count);
+  if (written == 0 || written % recording_buffer_size_ != 0) {
+    SleepMs(1);
+    RTC_LOG(LS_ERROR) << "Get audio frames failed.";
+    return true;
   }
-  crit_sect_.Leave();
-  int64_t cost_ms = clock_->CurrentNtpInMilliseconds() - current_time;
-  need_sleep_ms_ = 10 - cost_ms + need_sleep_ms_ - real_sleep_ms_;
-  if (need_sleep_ms_ > 0) {
-    current_time = clock_->CurrentNtpInMilliseconds();
-    SleepMs(need_sleep_ms_);
-    real_sleep_ms_ = clock_->CurrentNtpInMilliseconds() - current_time;
-  } else {
-    RTC_LOG(LS_WARNING) << "Cost too much time to get audio frames. This may "
-                       "leads to large latency";
-    real_sleep_ms_ = 0;
+  uint32_t frames_written =
+      written / static_cast<uint32_t>(recording_buffer_size_);
+  for (uint32_t i = 0; i < frames_written; i++) {
+    uint8_t* slot = audio_ring_->BeginWrite();
+    if (!slot)
+      break;
+    memcpy(slot, batch_buffer_.get() + i * recording_buffer_size_,
+           recording_buffer_size_);
+    audio_ring_->CommitWrite();
   }
   return true;
-};
+}
+bool CustomizedAudioCapturer::GenThreadFunc(void* pThis) {
+  return (static_cast<CustomizedAudioCapturer*>(pThis)->GenThreadProcess());
+}
+// Consumer side of |audio_ring_|. Runs every 10ms on the shared pacer
+// thread, which owns the delivery cadence; this only moves one frame from
+// the ring into the audio buffer and must not block.
+void CustomizedAudioCapturer::DeliverAudioFrame() {
+  if (!recording_ || !audio_buffer_) {
+    return;
+  }
+  // Frames are handed over from the generator thread through the
+  // lock-free ring, so delivery never blocks on frame production.
+  if (!audio_ring_->Read(recording_buffer_.get())) {
+    rtc::AtomicOps::Increment(&underrun_count_);
+    RTC_LOG(LS_WARNING) << "Audio frame ring underrun.";
+    return;
+  }
+  if (silence_suppression_enabled_) {
+    if (IsSilentFrame(recording_buffer_.get())) {
+      if (silent_streak_ < kSilenceHangoverFrames) {
+        silent_streak_++;
+      } else if (!suppressing_) {
+        suppressing_ = true;
+        RTC_LOG(LS_INFO) << "Injected audio went silent; suppressing "
+                            "delivery until the next non-silent frame.";
+      }
+      if (suppressing_) {
+        // Nothing reaches the audio buffer, so audio processing and the
+        // encoder see no frames for this stream; with DTX negotiated the
+        // far end expects the gap.
+        return;
+      }
+    } else {
+      silent_streak_ = 0;
+      if (suppressing_) {
+        // Resume on the very first non-silent frame; it is delivered below.
+        suppressing_ = false;
+        RTC_LOG(LS_INFO) << "Injected audio resumed; delivering again.";
+      }
+    }
+  }
+  // Sample rate and channel number cannot be changed on the fly.
+  audio_buffer_->SetRecordedBuffer(
+      recording_buffer_.get(), recording_frames_in_10ms_);  // Buffer copied here
+  audio_buffer_->DeliverRecordedData();
+}
+int64_t CustomizedAudioCapturer::DeliveryUnderruns() const {
+  return rtc::AtomicOps::AcquireLoad(&underrun_count_);
+}
+// One pass of 16-bit absolute sums over a 10ms frame; a few hundred
+// additions at most, cheap enough to run on every delivery.
+bool CustomizedAudioCapturer::IsSilentFrame(const uint8_t* frame) const {
+  const int16_t* samples = reinterpret_cast<const int16_t*>(frame);
+  size_t sample_count = recording_frames_in_10ms_ * recording_channel_number_;
+  if (sample_count == 0) {
+    return false;
+  }
+  int64_t sum = 0;
+  for (size_t i = 0; i < sample_count; i++) {
+    sum += samples[i] < 0 ? -static_cast<int64_t>(samples[i]) : samples[i];
+  }
+  return sum < static_cast<int64_t>(sample_count) * kSilenceMeanAbsAmplitude;
+}
 }
 }
@@ -8,7 +8,8 @@
 #include "webrtc/rtc_base/memory/aligned_malloc.h"
 #include "webrtc/rtc_base/platform_thread.h"
 #include "webrtc/modules/audio_device/audio_device_generic.h"
-#include "webrtc/system_wrappers/include/clock.h"
+#include "talk/owt/sdk/base/audioframering.h"
+#include "talk/owt/sdk/base/audiopacer.h"
 #include "talk/owt/sdk/include/cpp/owt/base/framegeneratorinterface.h"
 namespace owt {
 namespace base {
@@ -16,7 +17,8 @@ using namespace webrtc;
 // This is a customized audio device which retrieves audio from a
 // AudioFrameGenerator implementation as its microphone.
 // CustomizedAudioCapturer is not able to output audio.
-class CustomizedAudioCapturer : public AudioDeviceGeneric {
+class CustomizedAudioCapturer : public AudioDeviceGeneric,
+                                public AudioPacer::Client {
  public:
   // Constructs a customized audio device with |frame_generator|. It will read
   // audio from |frame_generator|.
@@ -96,11 +98,17 @@ class CustomizedAudioCapturer : public AudioDeviceGeneric {
   // Delay information and control
   int32_t PlayoutDelay(uint16_t& delayMS) const override;
   void AttachAudioBuffer(AudioDeviceBuffer* audioBuffer) override;
+  // AudioPacer::Client implementation. Called every 10ms on the shared
+  // pacer thread; consumes one frame from |audio_ring_| and delivers it.
+  void DeliverAudioFrame() override;
+  int64_t DeliveryUnderruns() const override;
  private:
-  static bool RecThreadFunc(void*);
+  static bool GenThreadFunc(void*);
   static bool PlayThreadFunc(void*);
-  bool RecThreadProcess();
+  bool GenThreadProcess();
   bool PlayThreadProcess();
+  // Cheap mean-absolute-amplitude check over one 10ms frame.
+  bool IsSilentFrame(const uint8_t* frame) const;
   std::unique_ptr<AudioFrameGeneratorInterface> frame_generator_;
   AudioDeviceBuffer* audio_buffer_;
   std::unique_ptr<uint8_t[], webrtc::AlignedFreeDeleter>
@@ -110,12 +118,25 @@ class CustomizedAudioCapturer : public AudioDeviceGeneric {
   int recording_sample_rate_;
   int recording_channel_number_;
   size_t recording_buffer_size_;
-  std::unique_ptr<rtc::PlatformThread> thread_rec_;
+  // Generator thread fills |audio_ring_| ahead of the delivery deadline;
+  // the shared pacer thread consumes it lock free, so the 10ms delivery
+  // path never waits on frame production.
+  std::unique_ptr<rtc::PlatformThread> thread_gen_;
+  std::unique_ptr<AudioFrameRing> audio_ring_;
+  // Arena handed to the generator's batched API before frames are split
+  // into ring slots.
+  std::unique_ptr<uint8_t[]> batch_buffer_;
   bool recording_;
-  uint64_t last_call_record_millis_;
-  Clock* clock_;
-  int64_t need_sleep_ms_;
-  int64_t real_sleep_ms_;
+  // Deliveries skipped because the ring was empty; bumped wait free on the
+  // pacer thread, read from the stats path.
+  volatile int underrun_count_;
+  // Silence suppression state, touched only on the pacer thread. After
+  // |silent_streak_| reaches the hangover, frames stop being handed to the
+  // audio buffer, which skips audio processing and encode for this stream;
+  // the first non-silent frame resumes delivery immediately.
+  bool silence_suppression_enabled_;
+  int silent_streak_;
+  bool suppressing_;
 };
 }
 }
@@ -1,6 +1,8 @@
 // Copyright (C) <2018> Intel Corporation
 //
 // SPDX-License-Identifier: Apache-2.0
+#include <algorithm>
+#include <limits>
 #include "webrtc/rtc_base/criticalsection.h"
 #include "webrtc/rtc_base/logging.h"
 #include "webrtc/rtc_base/memory/aligned_malloc.h"
@@ -10,6 +12,15 @@
 #include "talk/owt/sdk/base/customizedframescapturer.h"
 #include "talk/owt/sdk/base/customizedencoderbufferhandle.h"
 #include "talk/owt/sdk/base/nativehandlebuffer.h"
+#if defined(WEBRTC_WIN)
+#include "talk/owt/sdk/base/win/d3dnativeframe.h"
+#include "talk/owt/sdk/base/win/threadaffinity.h"
+#endif
+#include "owt/base/globalconfiguration.h"
+#include "talk/owt/sdk/base/overloadgovernor.h"
+#include "talk/owt/sdk/base/pipelinelatencytracer.h"
+#include "talk/owt/sdk/base/memoryaccounting.h"
+#include "talk/owt/sdk/base/queuedepthgauges.h"
 using namespace rtc;
 namespace owt {
 namespace base {
@@ -21,31 +32,92 @@ class CustomizedFramesCapturer::CustomizedFramesThread
     : public rtc::Thread,
       public rtc::MessageHandler {
  public:
-  explicit CustomizedFramesThread(CustomizedFramesCapturer* capturer, int fps)
-      : capturer_(capturer), finished_(false) {
-    waiting_time_ms = 1000 / fps;
-  }
+  CustomizedFramesThread() : finished_(false) {}
   virtual ~CustomizedFramesThread() { Stop(); }
+  // Returns the process-wide capture thread multiplexing all capturers when
+  // GlobalConfiguration enables the shared capture thread. Created and
+  // started on first use, and kept alive for later capturers.
+  static CustomizedFramesThread* SharedThread() {
+    static CustomizedFramesThread* const shared_thread = []() {
+      CustomizedFramesThread* thread = new CustomizedFramesThread();
+      thread->Start();
+      return thread;
+    }();
+    return shared_thread;
+  }
+  // Registers a capturer to be paced at |fps|. Its first frame is read
+  // immediately. Context: any thread.
+  void AddCapturer(CustomizedFramesCapturer* capturer, int fps) {
+    rtc::CritScope cs(&crit_);
+    CaptureEntry entry;
+    entry.capturer = capturer;
+    entry.frame_interval_us = 1000000 / fps;
+    entry.next_frame_time_us = rtc::TimeMicros();
+    entry.frame_index = 0;
+    capturers_.push_back(entry);
+    // Wake the pump so the new capturer's deadline is taken into account.
+    Post(RTC_FROM_HERE, this);
+  }
+  // Unregisters a capturer. Holding |crit_| guarantees no ReadFrame on the
+  // capturer is in flight when this returns. Context: any thread.
+  void RemoveCapturer(CustomizedFramesCapturer* capturer) {
+    rtc::CritScope cs(&crit_);
+    for (auto it = capturers_.begin(); it != capturers_.end(); ++it) {
+      if (it->capturer == capturer) {
+        capturers_.erase(it);
+        break;
+      }
+    }
+  }
   // Override virtual method of parent Thread. Context: Worker Thread.
   virtual void Run() {
-    // Read the first frame and start the message pump. The pump runs until
-    // Stop() is called externally or Quit() is called by OnMessage().
-    if (capturer_) {
-      capturer_->ReadFrame();
-      rtc::Thread::Current()->Post(RTC_FROM_HERE, this);
-      rtc::Thread::Current()->ProcessMessages(kForever);
-    }
+#if defined(WEBRTC_WIN)
+    // Pinning here covers both the shared thread and dedicated threads.
+    ApplyThreadAffinityMask(
+        GlobalConfiguration::GetCaptureThreadAffinityMask());
+#endif
+    rtc::Thread::Current()->ProcessMessages(kForever);
     rtc::CritScope cs(&crit_);
     finished_ = true;
   }
-  // Override virtual method of parent MessageHandler. Context: Worker Thread.
+  // Services all capturers whose absolute deadline is due, then re-arms the
+  // pump for the earliest upcoming deadline. Pacing against absolute
+  // deadlines keeps message-loop latency and ReadFrame cost from
+  // accumulating into drift. Override virtual method of parent
+  // MessageHandler. Context: Worker Thread.
   virtual void OnMessage(rtc::Message* /*pmsg*/) {
-    if (capturer_) {
-      capturer_->ReadFrame();
-      rtc::Thread::Current()->PostDelayed(RTC_FROM_HERE, waiting_time_ms, this);
-    } else {
-      rtc::Thread::Current()->Quit();
+    // ReadFrame runs under |crit_| so RemoveCapturer can never return while
+    // a frame for that capturer is still being generated.
+    rtc::CritScope cs(&crit_);
+    if (capturers_.empty())
+      return;  // Re-armed by the next AddCapturer.
+    int64_t now_us = rtc::TimeMicros();
+    int64_t earliest_us = std::numeric_limits<int64_t>::max();
+    // Under overload the governor raises the divisor and the pump skips
+    // generator cycles instead of renegotiating framerates; cadence
+    // stays on the grid so recovery is seamless.
+    int frame_divisor = OverloadGovernor::CaptureFrameDivisor();
+    for (auto& entry : capturers_) {
+      if (entry.next_frame_time_us <= now_us) {
+        entry.frame_index++;
+        if (frame_divisor <= 1 || entry.frame_index % frame_divisor == 0)
+          entry.capturer->ReadFrame();
+        entry.next_frame_time_us += entry.frame_interval_us;
+        now_us = rtc::TimeMicros();
+        if (entry.next_frame_time_us <= now_us) {
+          // Fell behind by one or more intervals; realign to the cadence
+          // grid instead of bursting frames to catch up.
+          entry.next_frame_time_us +=
+              (now_us - entry.next_frame_time_us) / entry.frame_interval_us *
+                  entry.frame_interval_us +
+              entry.frame_interval_us;
+        }
+      }
+      earliest_us = std::min(earliest_us, entry.next_frame_time_us);
     }
+    int delay_ms = static_cast<int>(
+        std::max<int64_t>(0, earliest_us - now_us + 500) / 1000);
+    rtc::Thread::Current()->PostDelayed(RTC_FROM_HERE, delay_ms, this);
   }
   // Check if Run() is finished.
   bool Finished() const {
@@ -53,10 +125,17 @@ class CustomizedFramesCapturer::CustomizedFramesThread
     return finished_;
   }
  private:
-  CustomizedFramesCapturer* capturer_;
+  struct CaptureEntry {
+    CustomizedFramesCapturer* capturer;
+    int64_t frame_interval_us;
+    int64_t next_frame_time_us;
+    // Count of elapsed cadence slots, used by the overload governor's
+    // frame divisor to pick which slots actually read a frame.
+    int64_t frame_index;
+  };
   mutable rtc::CriticalSection crit_;
+  std::vector<CaptureEntry> capturers_;
   bool finished_;
-  int waiting_time_ms;
   RTC_DISALLOW_COPY_AND_ASSIGN(CustomizedFramesThread);
 };
 /////////////////////////////////////////////////////////////////////
@@ -64,33 +143,44 @@ class CustomizedFramesCapturer::CustomizedFramesThread
 /////////////////////////////////////////////////////////////////////
 const char* CustomizedFramesCapturer::kRawFrameDeviceName =
     "CustomizedFramesGenerator";
+// Upper bound of pooled frame buffers per capturer. Large enough to keep
+// capture and encode overlapped, small enough to bound memory per stream.
+static const size_t kFrameBufferPoolSize = 4;
 CustomizedFramesCapturer::CustomizedFramesCapturer(
     std::unique_ptr<VideoFrameGeneratorInterface> raw_frameGenerator)
     : frame_generator_(std::move(raw_frameGenerator)),
       encoder_(nullptr),
       frames_generator_thread(nullptr),
+      owns_frames_thread_(true),
       width_(frame_generator_->GetWidth()),
       height_(frame_generator_->GetHeight()),
       fps_(frame_generator_->GetFps()),
       bitrate_kbps_(0),
       frame_type_(frame_generator_->GetType()),
       frame_buffer_capacity_(0),
-      frame_buffer_(nullptr),
-      async_invoker_(nullptr) {}
+      accounted_frame_pool_bytes_(0),
+      frame_buffer_pool_(false, kFrameBufferPoolSize),
+      frame_buffer_(nullptr) {}
 CustomizedFramesCapturer::CustomizedFramesCapturer(
     int width, int height, int fps, int bitrate_kbps, VideoEncoderInterface* encoder)
     : frame_generator_(nullptr),
       encoder_(encoder),
       frames_generator_thread(nullptr),
+      owns_frames_thread_(true),
       width_(width),
       height_(height),
       fps_(fps),
       bitrate_kbps_(bitrate_kbps),
       frame_buffer_capacity_(0),
-      frame_buffer_(nullptr),
-      async_invoker_(nullptr) {}
+      accounted_frame_pool_bytes_(0),
+      frame_buffer_pool_(false, kFrameBufferPoolSize),
+      frame_buffer_(nullptr) {}
 CustomizedFramesCapturer::~CustomizedFramesCapturer() {
   Stop();
+  if (accounted_frame_pool_bytes_ > 0) {
+    MemoryAccounting::Release("capturer.frame_buffers",
+                              accounted_frame_pool_bytes_);
+  }
   frame_generator_.reset(nullptr);
   // encoder is created by app. And needs to be freed by
   // application. mark it to nullptr to avoid ReadFrame
@@ -112,18 +202,23 @@ cricket::CaptureState CustomizedFramesCapturer::Start(
     return CS_FAILED;
   }
   SetCaptureFormat(&capture_format);
-  worker_thread_ = rtc::Thread::Current();
-  RTC_DCHECK(!async_invoker_);
-  async_invoker_.reset(new rtc::AsyncInvoker());
-  // Create a thread to generate frames.
-  frames_generator_thread = new CustomizedFramesThread(this, fps_);
+  // Register with the shared capture thread when configured to multiplex
+  // capturers, otherwise create a dedicated thread to generate frames.
+  if (GlobalConfiguration::GetSharedCaptureThreadEnabled()) {
+    owns_frames_thread_ = false;
+    frames_generator_thread = CustomizedFramesThread::SharedThread();
+    frames_generator_thread->AddCapturer(this, fps_);
+    RTC_LOG(LS_INFO) << "Yuv Frame Generator on shared capture thread";
+    return CS_RUNNING;
+  }
+  owns_frames_thread_ = true;
+  frames_generator_thread = new CustomizedFramesThread();
   bool ret = frames_generator_thread->Start();
   if (ret) {
+    frames_generator_thread->AddCapturer(this, fps_);
     RTC_LOG(LS_INFO) << "Yuv Frame Generator started";
     return CS_RUNNING;
   } else {
-    async_invoker_.reset();
-    worker_thread_ = nullptr;
     RTC_LOG(LS_ERROR) << "Yuv Frame Generator failed to start";
     return CS_FAILED;
   }
@@ -133,14 +228,15 @@ bool CustomizedFramesCapturer::IsRunning() {
 }
 void CustomizedFramesCapturer::Stop() {
   if (frames_generator_thread) {
-    frames_generator_thread->Quit();
-    delete frames_generator_thread;
+    frames_generator_thread->RemoveCapturer(this);
+    if (owns_frames_thread_) {
+      frames_generator_thread->Quit();
+      delete frames_generator_thread;
+    }
     frames_generator_thread = nullptr;
     RTC_LOG(LS_INFO) << "Yuv Frame Generator stopped";
   }
   SetCaptureFormat(nullptr);
-  worker_thread_ = nullptr;
-  async_invoker_.reset();
 }
 bool CustomizedFramesCapturer::GetPreferredFourccs(
     std::vector<uint32_t>* fourccs) {
@@ -157,36 +253,174 @@ int CustomizedFramesCapturer::I420DataSize(int height,
   return stride_y * height + (stride_u + stride_v) * ((height + 1) / 2);
 }
 void CustomizedFramesCapturer::AdjustFrameBuffer(uint32_t size) {
-  if (size > frame_buffer_capacity_ || !frame_buffer_) {
-    RTC_LOG(LS_VERBOSE) << "Allocate new memory for frame buffer.";
-    width_ = frame_generator_->GetWidth();
-    height_ = frame_generator_->GetHeight();
-    int stride_y = width_;
-    int stride_uv = (width_ + 1) / 2;
-    frame_buffer_= webrtc::I420Buffer::Create(width_, height_, stride_y, stride_uv, stride_uv);
-    frame_buffer_capacity_ =
-        I420DataSize(height_, stride_y, stride_uv, stride_uv);
-    if (frame_buffer_capacity_ < size) {
-      RTC_LOG(LS_ERROR) << "User provides invalid data size. Expected size: "
-                    << frame_buffer_capacity_ << ", user wants: " << size;
+  width_ = frame_generator_->GetWidth();
+  height_ = frame_generator_->GetHeight();
+  // The pool hands back a released buffer of matching size when one is
+  // available and only allocates when the ring is exhausted, so steady-state
+  // capture is allocation free and a resolution change simply drains the old
+  // buffers out of the pool.
+  frame_buffer_ = frame_buffer_pool_.CreateBuffer(width_, height_);
+  // The pool has no depth counter, so the gauge is binary: 1 while the
+  // encoder holds every pooled buffer and capture cycles are dropping,
+  // 0 once a buffer frees up. A watermark of 1 tells ops the backlog sat
+  // between capture and encode.
+  if (!frame_buffer_) {
+    QueueDepthGauges::Set("capturer.frame_pool_exhausted", 1);
+    RTC_LOG(LS_WARNING)
+        << "All pooled frame buffers in flight; dropping capture cycle.";
+    frame_buffer_capacity_ = 0;
+    return;
+  }
+  QueueDepthGauges::Set("capturer.frame_pool_exhausted", 0);
+  frame_buffer_capacity_ =
+      I420DataSize(height_, frame_buffer_->StrideY(), frame_buffer_->StrideU(),
+                   frame_buffer_->StrideV());
+  // Report the pool's steady-state footprint as one allocation: the pool
+  // retains up to kFrameBufferPoolSize buffers of the current size.
+  uint64_t pool_bytes =
+      static_cast<uint64_t>(frame_buffer_capacity_) * kFrameBufferPoolSize;
+  if (pool_bytes != accounted_frame_pool_bytes_) {
+    if (accounted_frame_pool_bytes_ > 0) {
+      MemoryAccounting::Release("capturer.frame_buffers",
+                                accounted_frame_pool_bytes_);
     }
+    MemoryAccounting::Add("capturer.frame_buffers", pool_bytes);
+    accounted_frame_pool_bytes_ = pool_bytes;
+  }
+  if (frame_buffer_capacity_ < size) {
+    RTC_LOG(LS_ERROR) << "User provides invalid data size. Expected size: "
+                  << frame_buffer_capacity_ << ", user wants: " << size;
   }
 }
-// Executed in the context of CustomizedFramesThread.
+// Executed in the context of CustomizedFramesThread. Frames are handed to
+// OnFrame directly from here: the broadcaster under VideoCapturer serializes
+// sinks with its own lock, so delivery needs no per-frame post to another
+// thread and the capture cadence never queues behind a busy message loop.
 void CustomizedFramesCapturer::ReadFrame() {
-  // Signal the previously read frame to downstream in worker_thread.
+  int64_t capture_start_ms = rtc::TimeMillis();
   rtc::CritScope lock(&lock_);
+  // Application-stamped frames keep their source time; the engine
+  // translates the generator's clock onto its own while preserving
+  // spacing, so downstream RTP timestamps track the source events.
+  int64_t generator_time_ms = -1;
   if (frame_generator_ != nullptr) {
+    generator_time_ms = frame_generator_->GetNextFrameTimestampMs();
+  }
+  if (frame_generator_ != nullptr &&
+      frame_type_ == VideoFrameGeneratorInterface::NV12) {
+    // NV12 frames stay NV12 end to end; the hardware encoder reads the
+    // planes from the native handle without an I420 round trip.
+    width_ = frame_generator_->GetWidth();
+    height_ = frame_generator_->GetHeight();
     auto frame_size = frame_generator_->GetNextFrameSize();
-    AdjustFrameBuffer(frame_size);
+    rtc::scoped_refptr<NV12NativeBuffer> nv12_buffer =
+        new rtc::RefCountedObject<NV12NativeBuffer>(width_, height_);
+    if (frame_generator_->GenerateNextFrame(
+            nv12_buffer->MutableData(), nv12_buffer->capacity()) !=
+        frame_size) {
+      RTC_DCHECK(false);
+      RTC_LOG(LS_ERROR) << "Failed to get NV12 video frame.";
+      return;
+    }
+    PipelineLatencyTracer::Record(PipelineLatencyTracer::kCapture,
+                                  rtc::TimeMillis() - capture_start_ms);
+    webrtc::VideoFrame capture_frame(
+        nv12_buffer, 0,
+        generator_time_ms >= 0 ? generator_time_ms : rtc::TimeMillis(),
+        webrtc::kVideoRotation_0);
+    OnFrame(capture_frame, width_, height_);
+    return;
+  }
+#if defined(WEBRTC_WIN)
+  if (frame_generator_ != nullptr &&
+      frame_type_ == VideoFrameGeneratorInterface::D3D11Handle) {
+    // The generator hands over a texture reference instead of pixels.
+    width_ = frame_generator_->GetWidth();
+    height_ = frame_generator_->GetHeight();
+    D3D11ImageHandle handle;
     if (frame_generator_->GenerateNextFrame(
+            reinterpret_cast<uint8_t*>(&handle), sizeof(handle)) !=
+        sizeof(handle)) {
+      RTC_DCHECK(false);
+      RTC_LOG(LS_ERROR) << "Failed to get D3D11 texture frame.";
+      return;
+    }
+    handle.width_ = width_;
+    handle.height_ = height_;
+    rtc::scoped_refptr<D3D11HandleBuffer> d3d11_buffer =
+        new rtc::RefCountedObject<D3D11HandleBuffer>(handle);
+    webrtc::VideoFrame capture_frame(
+        d3d11_buffer, 0,
+        generator_time_ms >= 0 ? generator_time_ms : rtc::TimeMillis(),
+        webrtc::kVideoRotation_0);
+    OnFrame(capture_frame, width_, height_);
+    return;
+  }
+#endif
+#if defined(WEBRTC_IOS) || defined(WEBRTC_MAC)
+  if (frame_generator_ != nullptr &&
+      frame_type_ == VideoFrameGeneratorInterface::CVPixelBufferHandle) {
+    // The generator hands over a retained CVPixelBuffer instead of
+    // pixels; the wrapping buffer releases it after encoding.
+    width_ = frame_generator_->GetWidth();
+    height_ = frame_generator_->GetHeight();
+    CVPixelBufferRef pixel_buffer = nullptr;
+    uint32_t written = frame_generator_->GenerateNextFrame(
+        reinterpret_cast<uint8_t*>(&pixel_buffer), sizeof(pixel_buffer));
+    if (written == 0) {
+      // The generator has no frame this cycle.
+      return;
+    }
+    if (written != sizeof(pixel_buffer) || pixel_buffer == nullptr) {
+      RTC_LOG(LS_ERROR) << "Failed to get CVPixelBuffer frame.";
+      return;
+    }
+    PipelineLatencyTracer::Record(PipelineLatencyTracer::kCapture,
+                                  rtc::TimeMillis() - capture_start_ms);
+    rtc::scoped_refptr<CVPixelBufferNativeBuffer> cv_buffer =
+        new rtc::RefCountedObject<CVPixelBufferNativeBuffer>(pixel_buffer,
+                                                             width_, height_);
+    webrtc::VideoFrame capture_frame(
+        cv_buffer, 0,
+        generator_time_ms >= 0 ? generator_time_ms : rtc::TimeMillis(),
+        webrtc::kVideoRotation_0);
+    OnFrame(capture_frame, width_, height_);
+    return;
+  }
+#endif
+  if (frame_generator_ != nullptr) {
+    auto frame_size = frame_generator_->GetNextFrameSize();
+    AdjustFrameBuffer(frame_size);
+    if (!frame_buffer_)
+      return;
+    if (frame_generator_->SupportsPlaneSetGeneration()) {
+      // Zero-copy path: hand the generator the writable planes of the buffer
+      // delivered downstream, so no intermediate copy is made.
+      VideoFramePlaneSet planes;
+      planes.data_y = frame_buffer_->MutableDataY();
+      planes.data_u = frame_buffer_->MutableDataU();
+      planes.data_v = frame_buffer_->MutableDataV();
+      planes.stride_y = frame_buffer_->StrideY();
+      planes.stride_u = frame_buffer_->StrideU();
+      planes.stride_v = frame_buffer_->StrideV();
+      planes.width = width_;
+      planes.height = height_;
+      if (!frame_generator_->GenerateNextFrame(planes)) {
+        RTC_LOG(LS_WARNING) << "Generator skipped in-place video frame.";
+        return;
+      }
+    } else if (frame_generator_->GenerateNextFrame(
             frame_buffer_->MutableDataY(), frame_buffer_capacity_) != frame_size) {
       RTC_DCHECK(false);
       RTC_LOG(LS_ERROR) << "Failed to get video frame.";
       return;
     }
-    webrtc::VideoFrame capture_frame(frame_buffer_, 0, rtc::TimeMillis(),
-                                  webrtc::kVideoRotation_0);
+    PipelineLatencyTracer::Record(PipelineLatencyTracer::kCapture,
+                                  rtc::TimeMillis() - capture_start_ms);
+    webrtc::VideoFrame capture_frame(
+        frame_buffer_, 0,
+        generator_time_ms >= 0 ? generator_time_ms : rtc::TimeMillis(),
+        webrtc::kVideoRotation_0);
     OnFrame(capture_frame, width_, height_);
   } else if (encoder_ != nullptr) { // video encoder interface used. Pass the encoder information.
     CustomizedEncoderBufferHandle* encoder_context = new CustomizedEncoderBufferHandle;
@@ -9,11 +9,10 @@
 #include <memory>
 #endif
 #include "webrtc/api/video/i420_buffer.h"
+#include "webrtc/common_video/include/i420_buffer_pool.h"
 #include "webrtc/media/base/videocapturer.h"
 #include "webrtc/rtc_base/stream.h"
 #include "webrtc/rtc_base/stringutils.h"
-#include "webrtc/rtc_base/bind.h"
-#include "webrtc/rtc_base/asyncinvoker.h"
 #include "webrtc/rtc_base/criticalsection.h"
 #include "owt/base/framegeneratorinterface.h"
 #include "owt/base/videoencoderinterface.h"
@@ -39,8 +38,9 @@ class CustomizedFramesCapturer : public VideoCapturer {
   virtual bool GetPreferredFourccs(std::vector<uint32_t>* fourccs) override;
   // Read a frame and determine how long to wait for the next frame.
   virtual void ReadFrame();
-  // Adjust |frame_buffer_|'s capacity to store frame data. |frame_buffer_|'s
-  // capacity should be greater or equal to |size|.
+  // Acquire a pooled buffer for the next frame and make sure its capacity is
+  // greater or equal to |size|. The buffer is recycled into the pool once
+  // all downstream references to it are released.
   virtual void AdjustFrameBuffer(uint32_t size);
  private:
   class CustomizedFramesThread;  // Forward declaration, defined in .cc.
@@ -48,16 +48,25 @@ class CustomizedFramesCapturer : public VideoCapturer {
   std::unique_ptr<VideoFrameGeneratorInterface> frame_generator_;
   VideoEncoderInterface* encoder_;
   CustomizedFramesThread* frames_generator_thread;
+  // False when attached to the process-wide shared capture thread, which is
+  // never torn down by an individual capturer.
+  bool owns_frames_thread_;
   int width_;
   int height_;
   int fps_;
   int bitrate_kbps_;
   VideoFrameGeneratorInterface::VideoFrameCodec frame_type_;
   uint32_t frame_buffer_capacity_;
-  rtc::scoped_refptr<webrtc::I420Buffer> frame_buffer_; // Reuseable buffer for video frames.
+  // Frame pool bytes currently reported to MemoryAccounting; updated when
+  // the pool's buffer size changes so accounting survives capacity
+  // adjustments and the failed-allocation path.
+  uint64_t accounted_frame_pool_bytes_;
+  // Fixed-size ring of pre-allocated buffers recycled by ref-count, so the
+  // capture thread never waits for the previous frame to be consumed and
+  // resolution changes do not trigger reallocation storms.
+  webrtc::I420BufferPool frame_buffer_pool_;
+  rtc::scoped_refptr<webrtc::I420Buffer> frame_buffer_; // Buffer of the frame being read.
   // Consider to use NativeHandleBuffer if you want to support encoded frame.
-  rtc::Thread* worker_thread_;  // Set in Start(), unset in Stop();
-  std::unique_ptr<rtc::AsyncInvoker> async_invoker_;
   rtc::CriticalSection lock_;
   RTC_DISALLOW_COPY_AND_ASSIGN(CustomizedFramesCapturer);
 };
@@ -1,6 +1,10 @@
 // Copyright (C) <2018> Intel Corporation
 //
 // SPDX-License-Identifier: Apache-2.0
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include "webrtc/api/video/video_frame.h"
@@ -9,27 +13,157 @@
 #include "webrtc/modules/video_coding/include/video_codec_interface.h"
 #include "webrtc/modules/video_coding/include/video_error_codes.h"
 #include "webrtc/rtc_base/buffer.h"
+#include "webrtc/rtc_base/timeutils.h"
+#include "talk/owt/sdk/base/pipelinelatencytracer.h"
 #include "webrtc/rtc_base/checks.h"
 #include "webrtc/rtc_base/logging.h"
+#include "talk/owt/sdk/base/bitstreamvalidator.h"
 #include "talk/owt/sdk/base/customizedencoderbufferhandle.h"
 #include "talk/owt/sdk/base/customizedvideoencoderproxy.h"
+#include "talk/owt/sdk/base/encodedstreamrecorder.h"
+#include "talk/owt/sdk/base/localloopback.h"
+#include "talk/owt/sdk/base/naluscanner.h"
+#include "talk/owt/sdk/include/cpp/owt/base/globalconfiguration.h"
 #include "talk/owt/sdk/base/nativehandlebuffer.h"
 #include "talk/owt/sdk/include/cpp/owt/base/commontypes.h"
-// H.264 start code length.
-#define H264_SC_LENGTH 4
-// Maximum allowed NALUs in one output frame.
-#define MAX_NALUS_PERFRAME 32
 using namespace rtc;
 namespace owt {
 namespace base {
+// One application encoder shared by every proxy bound to the same injected
+// stream. The application's VideoEncoderInterface is a pull source: each
+// EncodeOneFrame call drains the next encoded frame, so publishing one
+// stream to two channels must not pull twice. The first proxy to bind makes
+// the single Copy(); once more than one proxy is attached, each trigger
+// frame is encoded once and the same ref-counted bitstream is handed to
+// every proxy's packetizer, halving encode cost for dual-homed publishing.
+class SharedEncoderSource {
+ public:
+  // Returns the source for |original|, creating it on first use. Sources
+  // are registered process-wide so proxies belonging to different
+  // PeerConnections find each other.
+  static std::shared_ptr<SharedEncoderSource> Acquire(
+      VideoEncoderInterface* original) {
+    // Leaked on purpose; proxies come and go for the process lifetime.
+    static std::mutex* const registry_mutex = new std::mutex();
+    static std::map<VideoEncoderInterface*,
+                    std::weak_ptr<SharedEncoderSource>>* const registry =
+        new std::map<VideoEncoderInterface*,
+                     std::weak_ptr<SharedEncoderSource>>();
+    std::lock_guard<std::mutex> lock(*registry_mutex);
+    std::shared_ptr<SharedEncoderSource> source;
+    auto it = registry->find(original);
+    if (it != registry->end())
+      source = it->second.lock();
+    if (!source) {
+      source.reset(new SharedEncoderSource(original));
+      (*registry)[original] = source;
+    }
+    source->consumers_++;
+    return source;
+  }
+  ~SharedEncoderSource() {
+    if (encoder_) {
+      encoder_->Release();
+      delete encoder_;
+    }
+  }
+  // Called by a proxy that no longer encodes; destruction happens when the
+  // last proxy drops its reference.
+  void Detach() { consumers_--; }
+  bool HasMultipleConsumers() const { return consumers_.load() > 1; }
+  // Copies and initializes the application encoder once; later callers
+  // reuse the instance the first one built.
+  VideoEncoderInterface* EnsureInitialized(const Resolution& resolution,
+                                           uint32_t fps,
+                                           uint32_t bitrate_kbps,
+                                           VideoCodec codec) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (init_attempted_)
+      return encoder_;
+    init_attempted_ = true;
+    encoder_ = original_->Copy();
+    if (encoder_ == nullptr) {
+      RTC_LOG(LS_ERROR) << "Fail to duplicate video encoder";
+      return nullptr;
+    }
+    if (!encoder_->InitEncoderContext(resolution, fps, bitrate_kbps, codec)) {
+      RTC_LOG(LS_ERROR) << "Failed to init external encoder context";
+      delete encoder_;
+      encoder_ = nullptr;
+    }
+    return encoder_;
+  }
+#if !defined(WEBRTC_ANDROID)
+  // Pulls the next encoded frame once per trigger frame and hands the same
+  // buffer to every attached proxy. |trigger| is the broadcast frame that
+  // drove this Encode call; the cache holds a reference to it so the buffer
+  // identity used as the cache key cannot be recycled while the entry is
+  // live. A keyframe request bypasses the cache, so both channels pick up
+  // the fresh keyframe.
+  std::shared_ptr<std::vector<uint8_t>> EncodeShared(
+      const rtc::scoped_refptr<webrtc::VideoFrameBuffer>& trigger,
+      bool request_key_frame) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!encoder_)
+      return nullptr;
+    if (!request_key_frame && cached_bitstream_ &&
+        cached_trigger_.get() == trigger.get())
+      return cached_bitstream_;
+    std::shared_ptr<std::vector<uint8_t>> bitstream(new std::vector<uint8_t>());
+    if (encoder_->SupportsZeroCopyEncoding()) {
+      // The lease is single-consumer, so in fan-out mode it is copied once
+      // here and recycled immediately instead of being copied per channel.
+      EncodedFrameHandle frame_handle = {nullptr, 0, 0};
+      if (!encoder_->EncodeOneFrameZeroCopy(frame_handle, request_key_frame) ||
+          frame_handle.data == nullptr)
+        return nullptr;
+      bitstream->assign(frame_handle.data,
+                        frame_handle.data + frame_handle.size);
+      encoder_->RecycleEncodedFrame(frame_handle.buffer_id);
+    } else if (!encoder_->EncodeOneFrame(*bitstream, request_key_frame)) {
+      return nullptr;
+    }
+    cached_trigger_ = trigger;
+    cached_bitstream_ = bitstream;
+    return bitstream;
+  }
+#endif
+ private:
+  explicit SharedEncoderSource(VideoEncoderInterface* original)
+      : original_(original),
+        encoder_(nullptr),
+        init_attempted_(false),
+        consumers_(0) {}
+  VideoEncoderInterface* const original_;
+  std::mutex mutex_;
+  VideoEncoderInterface* encoder_;
+  bool init_attempted_;
+  std::atomic<int> consumers_;
+  rtc::scoped_refptr<webrtc::VideoFrameBuffer> cached_trigger_;
+  std::shared_ptr<std::vector<uint8_t>> cached_bitstream_;
+};
 CustomizedVideoEncoderProxy::CustomizedVideoEncoderProxy(
     webrtc::VideoCodecType type)
-    : callback_(nullptr), external_encoder_(nullptr) {
+    : callback_(nullptr),
+      bitrate_(0),
+      external_encoder_(nullptr),
+      last_key_frame_forwarded_ms_(0),
+      key_frame_requests_received_(0),
+      key_frame_requests_forwarded_(0) {
   codec_type_ = type;
   picture_id_ = 0;
 }
 CustomizedVideoEncoderProxy::~CustomizedVideoEncoderProxy() {
-  if (external_encoder_) {
+  // The validation worker holds a raw pointer to the encoder; join it
+  // before the encoder can be deleted below.
+  bitstream_validator_.reset();
+  if (shared_source_) {
+    // The encoder copy belongs to the shared source; the last proxy
+    // dropping its reference destroys it.
+    shared_source_->Detach();
+    shared_source_ = nullptr;
+    external_encoder_ = nullptr;
+  } else if (external_encoder_) {
     delete external_encoder_;
     external_encoder_ = nullptr;
   }
@@ -44,12 +178,25 @@ int CustomizedVideoEncoderProxy::InitEncode(
   height_ = codec_settings->height;
   bitrate_ = codec_settings->startBitrate * 1000;
   picture_id_ = static_cast<uint16_t>(rand()) & 0x7FFF;
+  // Only Annex-B streams have the structure the validator checks.
+#ifndef DISABLE_H265
+  bool annex_b = codec_type_ == webrtc::kVideoCodecH264 ||
+                 codec_type_ == webrtc::kVideoCodecH265;
+#else
+  bool annex_b = codec_type_ == webrtc::kVideoCodecH264;
+#endif
+  if (annex_b && GlobalConfiguration::GetEncodedBitstreamValidationEnabled()) {
+    bitstream_validator_.reset(new BitstreamValidator());
+  }
   return WEBRTC_VIDEO_CODEC_OK;
 }
 int CustomizedVideoEncoderProxy::Encode(
     const webrtc::VideoFrame& input_image,
     const webrtc::CodecSpecificInfo* codec_specific_info,
     const std::vector<webrtc::FrameType>* frame_types) {
+  PipelineLatencyTracer::Record(
+      PipelineLatencyTracer::kCustomEncode,
+      rtc::TimeMillis() - input_image.render_time_ms());
   // Get the videoencoderinterface instance from the input video frame.
   CustomizedEncoderBufferHandle* encoder_buffer_handle =
       reinterpret_cast<CustomizedEncoderBufferHandle*>(
@@ -60,11 +207,6 @@ int CustomizedVideoEncoderProxy::Encode(
       encoder_buffer_handle->encoder != nullptr) {
     // First time we get passed in encoder impl. Initialize it. Use codec
     // settings in the natvie handle instead of that passed uplink.
-    external_encoder_ = encoder_buffer_handle->encoder->Copy();
-    if (external_encoder_ == nullptr) {
-      RTC_LOG(LS_ERROR) << "Fail to duplicate video encoder";
-      return WEBRTC_VIDEO_CODEC_ERROR;
-    }
     size_t width = encoder_buffer_handle->width;
     size_t height = encoder_buffer_handle->height;
     uint32_t fps = encoder_buffer_handle->fps;
@@ -88,9 +230,16 @@ int CustomizedVideoEncoderProxy::Encode(
       return WEBRTC_VIDEO_CODEC_ERROR;
     }
     Resolution resolution(static_cast<int>(width), static_cast<int>(height));
-    if (!external_encoder_->InitEncoderContext(resolution, fps, bitrate_kbps,
-                                               media_codec)) {
-      RTC_LOG(LS_ERROR) << "Failed to init external encoder context";
+    // Proxies created from the same injected stream attach to one
+    // process-wide source and share a single encoder copy, so publishing
+    // the stream to several channels encodes each frame once.
+    shared_source_ =
+        SharedEncoderSource::Acquire(encoder_buffer_handle->encoder);
+    external_encoder_ = shared_source_->EnsureInitialized(
+        resolution, fps, bitrate_kbps, media_codec);
+    if (external_encoder_ == nullptr) {
+      shared_source_->Detach();
+      shared_source_ = nullptr;
       return WEBRTC_VIDEO_CODEC_ERROR;
     }
   } else if (encoder_buffer_handle != nullptr &&
@@ -113,7 +262,6 @@ int CustomizedVideoEncoderProxy::Encode(
 #endif
       return WEBRTC_VIDEO_CODEC_ERROR;
   }
-  std::vector<uint8_t> buffer;
   bool request_key_frame = false;
   if (frame_types) {
     for (auto frame_type : *frame_types) {
@@ -123,6 +271,8 @@ int CustomizedVideoEncoderProxy::Encode(
       }
     }
   }
+  if (request_key_frame && !AllowKeyFrameRequest())
+    request_key_frame = false;
 #ifdef WEBRTC_ANDROID
   uint8_t* data_ptr = nullptr;
   uint32_t data_size = 0;
@@ -134,15 +284,42 @@ int CustomizedVideoEncoderProxy::Encode(
   }
   webrtc::EncodedImage encodedframe(data_ptr, data_size, data_size);
 #else
+  uint8_t* data_ptr = nullptr;
+  uint32_t data_size = 0;
+  EncodedFrameHandle frame_handle = {nullptr, 0, 0};
+  std::shared_ptr<std::vector<uint8_t>> shared_bitstream;
+  bool zero_copy =
+      external_encoder_ && external_encoder_->SupportsZeroCopyEncoding();
   if (external_encoder_) {
-    if (!external_encoder_->EncodeOneFrame(buffer, request_key_frame))
-      return WEBRTC_VIDEO_CODEC_ERROR;
+    if (shared_source_ && shared_source_->HasMultipleConsumers()) {
+      // Fan-out: one pull per trigger frame, shared with the other attached
+      // proxies. The shared_ptr keeps the bytes alive through
+      // OnEncodedImage below.
+      shared_bitstream = shared_source_->EncodeShared(
+          input_image.video_frame_buffer(), request_key_frame);
+      if (!shared_bitstream)
+        return WEBRTC_VIDEO_CODEC_ERROR;
+      data_ptr = shared_bitstream->data();
+      data_size = static_cast<uint32_t>(shared_bitstream->size());
+      zero_copy = false;
+    } else if (zero_copy) {
+      if (!external_encoder_->EncodeOneFrameZeroCopy(frame_handle,
+                                                     request_key_frame) ||
+          frame_handle.data == nullptr)
+        return WEBRTC_VIDEO_CODEC_ERROR;
+      data_ptr = frame_handle.data;
+      data_size = static_cast<uint32_t>(frame_handle.size);
+    } else {
+      encode_buffer_.clear();
+      if (!external_encoder_->EncodeOneFrame(encode_buffer_, request_key_frame))
+        return WEBRTC_VIDEO_CODEC_ERROR;
+      data_ptr = encode_buffer_.data();
+      data_size = static_cast<uint32_t>(encode_buffer_.size());
+    }
   }
-  std::unique_ptr<uint8_t[]> data(new uint8_t[buffer.size()]);
-  uint8_t* data_ptr = data.get();
-  uint32_t data_size = static_cast<uint32_t>(buffer.size());
-  std::copy(buffer.begin(), buffer.end(), data_ptr);
-  webrtc::EncodedImage encodedframe(data_ptr, buffer.size(), buffer.size());
+  // OnEncodedImage packetizes synchronously, so the bitstream only needs to
+  // stay valid until the callback returns; neither path copies it first.
+  webrtc::EncodedImage encodedframe(data_ptr, data_size, data_size);
 #endif
   encodedframe._encodedWidth = input_image.width();
   encodedframe._encodedHeight = input_image.height();
@@ -195,9 +372,9 @@ int CustomizedVideoEncoderProxy::Encode(
     info.codecSpecific.VP9.spatial_idx = kNoSpatialIdx;
     info.codecSpecific.VP9.temporal_idx = kNoTemporalIdx;
   }
-  // Generate a header describing a single fragment.
-  webrtc::RTPFragmentationHeader header;
-  memset(&header, 0, sizeof(header));
+  // Generate a header describing a single fragment. The member header is
+  // reused so its arrays are not reallocated per frame.
+  webrtc::RTPFragmentationHeader& header = frag_header_;
   if (codec_type_ == webrtc::kVideoCodecVP8 ||
       codec_type_ == webrtc::kVideoCodecVP9) {
     header.VerifyAndAllocateFragmentationHeader(1);
@@ -212,37 +389,44 @@ int CustomizedVideoEncoderProxy::Encode(
   } else if (codec_type_ == webrtc::kVideoCodecH264) {
 #endif
     // For H.264/H.265 search for start codes.
-    int32_t scPositions[MAX_NALUS_PERFRAME + 1] = {};
-    size_t scLengths[MAX_NALUS_PERFRAME + 1] = {};
-    int32_t scPositionsLength = 0;
-    int32_t scPosition = 0;
-    while (scPositionsLength < MAX_NALUS_PERFRAME) {
-      size_t scLength = 0;
-      int32_t naluPosition = NextNaluPosition(
-          data_ptr + scPosition, data_size - scPosition, &scLength);
-      if (naluPosition < 0) {
-        break;
-      }
-      scPosition += naluPosition;
-      scPositions[scPositionsLength++] = scPosition;
-      scLengths[scPositionsLength - 1] = static_cast<int32_t>(scLength);
-      scPosition += static_cast<int32_t>(scLength);
-    }
-    if (scPositionsLength == 0) {
+    if (ScanNaluFragments(data_ptr, data_size, &header) == 0) {
       RTC_LOG(LS_ERROR) << "Start code is not found for H264/H265 codec!";
+      // Fast reject: the producer hears about the bad frame right here
+      // instead of through a far-side decode failure.
+      if (external_encoder_)
+        external_encoder_->OnBitstreamValidationError(
+            "no Annex-B start code found");
+#ifndef WEBRTC_ANDROID
+      if (zero_copy)
+        external_encoder_->RecycleEncodedFrame(frame_handle.buffer_id);
+#endif
       return WEBRTC_VIDEO_CODEC_ERROR;
     }
-    scPositions[scPositionsLength] = data_size;
-    header.VerifyAndAllocateFragmentationHeader(scPositionsLength);
-    for (int i = 0; i < scPositionsLength; i++) {
-      header.fragmentationOffset[i] = scPositions[i] + scLengths[i];
-      header.fragmentationLength[i] =
-          scPositions[i + 1] - header.fragmentationOffset[i];
-      header.fragmentationPlType[i] = 0;
-      header.fragmentationTimeDiff[i] = 0;
-    }
+    // The deeper per-NALU checks run on the validator's thread against a
+    // copy, so the encode path only pays the memcpy.
+    if (bitstream_validator_)
+      bitstream_validator_->Submit(external_encoder_, codec_type_, data_ptr,
+                                   data_size);
   }
   const auto result = callback_->OnEncodedImage(encodedframe, &info, &header);
+  // The recording tap reads the same bitstream buffer the callback just
+  // packetized, before it is recycled below.
+  if (EncodedStreamRecorder::Active()) {
+    EncodedStreamRecorder::Record(codec_type_, encodedframe._timeStamp,
+                                  encodedframe.capture_time_ms_,
+                                  encodedframe._frameType == kVideoFrameKey,
+                                  data_ptr, data_size);
+  }
+  if (LocalLoopbackSender::Active()) {
+    LocalLoopbackSender::Deliver(encodedframe._timeStamp,
+                                 encodedframe._frameType == kVideoFrameKey,
+                                 data_ptr, data_size);
+  }
+#ifndef WEBRTC_ANDROID
+  // The frame has been packetized; hand the buffer back for reuse.
+  if (zero_copy)
+    external_encoder_->RecycleEncodedFrame(frame_handle.buffer_id);
+#endif
   if (result.error != webrtc::EncodedImageCallback::Result::Error::OK) {
     RTC_LOG(LS_ERROR) << "Deliver encoded frame callback failed: "
                       << result.error;
@@ -250,6 +434,24 @@ int CustomizedVideoEncoderProxy::Encode(
   }
   return WEBRTC_VIDEO_CODEC_OK;
 }
+// Decides whether a keyframe request is forwarded to the encoder. During
+// loss bursts several requests arrive back to back; requests landing inside
+// the configured window are collapsed into the one already forwarded.
+bool CustomizedVideoEncoderProxy::AllowKeyFrameRequest() {
+  key_frame_requests_received_++;
+  int window_ms = GlobalConfiguration::GetKeyFrameRequestCoalescingWindowMs();
+  int64_t now_ms = rtc::TimeMillis();
+  if (window_ms > 0 && key_frame_requests_forwarded_ > 0 &&
+      now_ms - last_key_frame_forwarded_ms_ < window_ms) {
+    RTC_LOG(LS_INFO) << "Coalesced keyframe request; forwarded "
+                     << key_frame_requests_forwarded_ << " of "
+                     << key_frame_requests_received_ << " requests.";
+    return false;
+  }
+  last_key_frame_forwarded_ms_ = now_ms;
+  key_frame_requests_forwarded_++;
+  return true;
+}
 int CustomizedVideoEncoderProxy::RegisterEncodeCompleteCallback(
     webrtc::EncodedImageCallback* callback) {
   callback_ = callback;
@@ -269,46 +471,12 @@ bool CustomizedVideoEncoderProxy::SupportsNativeHandle() const {
 }
 int CustomizedVideoEncoderProxy::Release() {
   callback_ = nullptr;
-  if (external_encoder_ != nullptr) {
+  // A shared encoder may still serve other proxies; it is released when
+  // the last proxy detaches from its source.
+  if (external_encoder_ != nullptr && !shared_source_) {
     external_encoder_->Release();
   }
   return WEBRTC_VIDEO_CODEC_OK;
 }
-int32_t CustomizedVideoEncoderProxy::NextNaluPosition(uint8_t* buffer,
-                                                      size_t buffer_size,
-                                                      size_t* sc_length) {
-  if (buffer_size < H264_SC_LENGTH) {
-    return -1;
-  }
-  uint8_t* head = buffer;
-  // Set end buffer pointer to 4 bytes before actual buffer end so we can
-  // access head[1], head[2] and head[3] in a loop without buffer overrun.
-  uint8_t* end = buffer + buffer_size - H264_SC_LENGTH;
-  while (head < end) {
-    if (head[0]) {
-      head++;
-      continue;
-    }
-    if (head[1]) {  // got 00xx
-      head += 2;
-      continue;
-    }
-    if (head[2]) {  // got 0000xx
-      if (head[2] == 0x01) {
-        *sc_length = 3;
-        return (int32_t)(head - buffer);
-      }
-      head += 3;
-      continue;
-    }
-    if (head[3] != 0x01) {  // got 000000xx
-      head++;               // xx != 1, continue searching.
-      continue;
-    }
-    *sc_length = 4;
-    return (int32_t)(head - buffer);
-  }
-  return -1;
-}
 }  // namespace base
 }  // namespace owt
@@ -3,11 +3,16 @@
 // SPDX-License-Identifier: Apache-2.0
 #ifndef OWT_BASE_ENCODEDVIDEOENCODER_H_
 #define OWT_BASE_ENCODEDVIDEOENCODER_H_
+#include <atomic>
+#include <memory>
 #include <vector>
 #include "webrtc/api/video_codecs/video_encoder.h"
+#include "webrtc/modules/include/module_common_types.h"
 #include "talk/owt/sdk/include/cpp/owt/base/videoencoderinterface.h"
 namespace owt {
 namespace base {
+class BitstreamValidator;
+class SharedEncoderSource;
 class CustomizedVideoEncoderProxy : public webrtc::VideoEncoder {
  public:
   CustomizedVideoEncoderProxy(webrtc::VideoCodecType type);
@@ -25,16 +30,38 @@ class CustomizedVideoEncoderProxy : public webrtc::VideoEncoder {
   bool SupportsNativeHandle() const override;
   int Release() override;
  private:
-  // Search for H.264 start codes.
-  int32_t NextNaluPosition(uint8_t* buffer, size_t buffer_size, size_t* sc_length);
+  // Returns false when a keyframe request lands in the coalescing window
+  // and should not reach the encoder. Also maintains the IDR counters.
+  bool AllowKeyFrameRequest();
   webrtc::EncodedImageCallback* callback_;
-  int32_t bitrate_;  // Bitrate in bits per second.
+  // Bitrate in bits per second. SetRates stores it from the bandwidth
+  // estimator's thread while the encode path runs elsewhere, so the
+  // publish is an atomic store rather than a lock.
+  std::atomic<int32_t> bitrate_;
   int32_t width_;
   int32_t height_;
   // int count_;
   webrtc::VideoCodecType codec_type_;
   uint16_t picture_id_;
   VideoEncoderInterface* external_encoder_;
+  // Set when |external_encoder_| is owned by a fan-out source shared with
+  // other proxies publishing the same injected stream; null when this
+  // proxy owns a private encoder copy.
+  std::shared_ptr<SharedEncoderSource> shared_source_;
+  // Reused across frames; its fragment arrays only grow, so the steady
+  // state encode path performs no allocation for the header.
+  webrtc::RTPFragmentationHeader frag_header_;
+  // Reused bitstream buffer for encoders on the copying EncodeOneFrame
+  // path; cleared per frame but keeps its capacity, so the copy is the
+  // only per-frame cost left on that path.
+  std::vector<uint8_t> encode_buffer_;
+  int64_t last_key_frame_forwarded_ms_;
+  int64_t key_frame_requests_received_;
+  int64_t key_frame_requests_forwarded_;
+  // Optional side-thread bitstream validation
+  // (GlobalConfiguration::SetEncodedBitstreamValidationEnabled); null
+  // when validation is off or the codec is not an Annex-B stream.
+  std::unique_ptr<BitstreamValidator> bitstream_validator_;
 };
 }
 }
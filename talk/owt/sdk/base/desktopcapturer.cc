@@ -1,6 +1,7 @@
 // Copyright (C) <2018> Intel Corporation
 //
 // SPDX-License-Identifier: Apache-2.0
+#include <algorithm>
 #include <iostream>
 #include "libyuv/convert.h"
 #include "webrtc/rtc_base/bytebuffer.h"
@@ -10,9 +11,15 @@
 #include "webrtc/rtc_base/thread.h"
 #include "webrtc/system_wrappers/include/clock.h"
 #include "talk/owt/sdk/base/desktopcapturer.h"
+#include "talk/owt/sdk/base/modulelogging.h"
+#include "talk/owt/sdk/base/screencontentmonitor.h"
 using namespace rtc;
 namespace owt {
 namespace base {
+// Delivery interval while the captured screen is static. Dashboards and
+// other mostly idle content drop to 5fps instead of re-encoding identical
+// frames at the full capture rate.
+static const int64_t kStaticFrameIntervalMs = 200;
 ///////////////////////////////////////////////////////////////////////
 // Definition of private class BasicScreenCaptureThread that periodically
 // generates frames.
@@ -67,6 +74,7 @@ BasicScreenCapturer::BasicScreenCapturer(webrtc::DesktopCaptureOptions options)
     : screen_capture_thread_(nullptr),
       width_(0),
       height_(0),
+      last_frame_delivery_ms_(0),
       frame_buffer_capacity_(0),
       frame_buffer_(nullptr),
       async_invoker_(nullptr),
@@ -121,6 +129,8 @@ void BasicScreenCapturer::Stop() {
     screen_capture_thread_ = NULL;
     RTC_LOG(LS_INFO) << "Screen capture thread stopped";
   }
+  // The next capture session starts its classification from scratch.
+  ScreenContentMonitor::Reset();
   SetCaptureFormat(NULL);
   worker_thread_ = nullptr;
   async_invoker_.reset();
@@ -140,7 +150,8 @@ int BasicScreenCapturer::I420DataSize(int height,
 }
 void BasicScreenCapturer::AdjustFrameBuffer(int32_t width, int32_t height) {
   if (width_ != width || height != height_ || !frame_buffer_) {
-    RTC_LOG(LS_VERBOSE) << "Allocate new memory for frame buffer.";
+    OWT_MODULE_LOG(kBase, kVerbose)
+        << "Allocate new memory for frame buffer.";
     width_ = width;
     height_ = height;
     int stride_y = width_;
@@ -177,15 +188,75 @@ void BasicScreenCapturer::OnCaptureResult(
     return;
   }
   // The captured frame is of memory layout ABRG. convert it to I420 as
-  // required.
+  // required. Only regions reported dirty by the underlying capturer are
+  // converted; the rest of |frame_buffer_| still holds up-to-date pixels
+  // from previous frames.
+  bool full_frame = (width_ != frame_width || height_ != frame_height ||
+                     !frame_buffer_);
   AdjustFrameBuffer(frame_width, frame_height);
-  libyuv::ARGBToI420(frame_data_rgba, frame_stride,
-                     frame_buffer_->MutableDataY(), frame_buffer_->StrideY(),
-                     frame_buffer_->MutableDataU(), frame_buffer_->StrideU(),
-                     frame_buffer_->MutableDataV(), frame_buffer_->StrideV(),
-                     frame_width, frame_height);
+  const webrtc::DesktopRegion& updated_region = frame->updated_region();
+  // Feed the content classifier with the dirty-area fraction; the
+  // region is already in hand, so this costs one pass over its rects.
+  if (full_frame) {
+    ScreenContentMonitor::ReportFrame(1.0);
+  } else {
+    int64_t updated_area = 0;
+    for (webrtc::DesktopRegion::Iterator it(updated_region); !it.IsAtEnd();
+         it.Advance()) {
+      webrtc::DesktopRect rect = it.rect();
+      updated_area +=
+          static_cast<int64_t>(rect.width()) * rect.height();
+    }
+    ScreenContentMonitor::ReportFrame(
+        static_cast<double>(updated_area) /
+        (static_cast<double>(frame_width) * frame_height));
+  }
+  if (!full_frame && updated_region.is_empty()) {
+    // Screen content unchanged. Keep signaling the cached frame at a low
+    // rate so downstream pacing and rate control still see a live stream,
+    // but skip the conversion and most of the encodes.
+    int64_t now_ms = rtc::TimeMillis();
+    if (now_ms - last_frame_delivery_ms_ < kStaticFrameIntervalMs)
+      return;
+    webrtc::VideoFrame cached_frame(frame_buffer_, 0, now_ms,
+                                    webrtc::kVideoRotation_0);
+    last_frame_delivery_ms_ = now_ms;
+    OnFrame(cached_frame, frame_width, frame_height);
+    return;
+  }
+  if (full_frame) {
+    libyuv::ARGBToI420(frame_data_rgba, frame_stride,
+                       frame_buffer_->MutableDataY(), frame_buffer_->StrideY(),
+                       frame_buffer_->MutableDataU(), frame_buffer_->StrideU(),
+                       frame_buffer_->MutableDataV(), frame_buffer_->StrideV(),
+                       frame_width, frame_height);
+  } else {
+    for (webrtc::DesktopRegion::Iterator it(updated_region); !it.IsAtEnd();
+         it.Advance()) {
+      webrtc::DesktopRect rect = it.rect();
+      // Align the rectangle to even boundaries so chroma subsampling lines
+      // up, and clamp it to the frame.
+      int x = rect.left() & ~1;
+      int y = rect.top() & ~1;
+      int right = std::min(frame_width, (rect.right() + 1) & ~1);
+      int bottom = std::min(frame_height, (rect.bottom() + 1) & ~1);
+      if (right <= x || bottom <= y)
+        continue;
+      libyuv::ARGBToI420(
+          frame_data_rgba + y * frame_stride + x * 4, frame_stride,
+          frame_buffer_->MutableDataY() + y * frame_buffer_->StrideY() + x,
+          frame_buffer_->StrideY(),
+          frame_buffer_->MutableDataU() + (y / 2) * frame_buffer_->StrideU() +
+              x / 2,
+          frame_buffer_->StrideU(),
+          frame_buffer_->MutableDataV() + (y / 2) * frame_buffer_->StrideV() +
+              x / 2,
+          frame_buffer_->StrideV(), right - x, bottom - y);
+    }
+  }
   webrtc::VideoFrame capturedFrame(frame_buffer_, 0, rtc::TimeMillis(),
                                    webrtc::kVideoRotation_0);
+  last_frame_delivery_ms_ = rtc::TimeMillis();
   OnFrame(capturedFrame, frame_width, frame_height);
 }
 }  // namespace base
@@ -83,6 +83,9 @@ class BasicScreenCapturer : public BasicDesktopCapturer {
   BasicScreenCaptureThread* screen_capture_thread_;
   int width_;
   int height_;
+  // Time the last frame was signaled downstream; used to throttle delivery
+  // when the captured screen content is unchanged.
+  int64_t last_frame_delivery_ms_;
   uint32_t frame_buffer_capacity_;
   rtc::scoped_refptr<webrtc::I420Buffer>
       frame_buffer_;  // Reuseable buffer for video frames.
@@ -1,16 +1,65 @@
 // Copyright (C) <2018> Intel Corporation
 //
 // SPDX-License-Identifier: Apache-2.0
+#include <mutex>
+#include <unordered_map>
 #include "talk/owt/sdk/include/cpp/owt/base/deviceutils.h"
 #include "webrtc/rtc_base/arraysize.h"
 #include "webrtc/rtc_base/logging.h"
+#include "webrtc/rtc_base/timeutils.h"
 #include "webrtc/media/base/videocapturer.h"
 #include "webrtc/modules/video_capture/video_capture_factory.h"
 #include "webrtc/media/engine/webrtcvideocapturerfactory.h"
 using namespace rtc;
 namespace owt {
 namespace base {
+namespace {
+// Cached enumeration results. Device pickers poll these APIs while OS
+// enumeration costs 50-200 ms with several cameras attached, so results
+// are served from here until the cache ages out or the application
+// invalidates it from its own hot-plug notification. Guarded by |mutex|.
+struct DeviceInfoCache {
+  std::mutex mutex;
+  int64_t timestamp_ms = 0;
+  bool ids_valid = false;
+  std::vector<std::string> ids;
+  std::unordered_map<std::string, std::vector<Resolution>> resolutions;
+};
+const int64_t kDeviceInfoCacheTtlMs = 5000;
+// Leaked on purpose to stay valid during static destruction.
+DeviceInfoCache& Cache() {
+  static DeviceInfoCache* cache = new DeviceInfoCache();
+  return *cache;
+}
+// Caller must hold the cache mutex. Empties the cache when it is older
+// than the TTL.
+void ExpireCache(DeviceInfoCache& cache) {
+  if (rtc::TimeMillis() - cache.timestamp_ms < kDeviceInfoCacheTtlMs)
+    return;
+  cache.ids_valid = false;
+  cache.ids.clear();
+  cache.resolutions.clear();
+}
+// Caller must hold the cache mutex. Stamps the cache when its first
+// entry after expiry is stored.
+void TouchCache(DeviceInfoCache& cache) {
+  if (!cache.ids_valid && cache.resolutions.empty())
+    cache.timestamp_ms = rtc::TimeMillis();
+}
+}  // namespace
+void DeviceUtils::InvalidateCachedDeviceInfo() {
+  DeviceInfoCache& cache = Cache();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  cache.ids_valid = false;
+  cache.ids.clear();
+  cache.resolutions.clear();
+}
 std::vector<std::string> DeviceUtils::VideoCapturerIds() {
+  DeviceInfoCache& cache = Cache();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  ExpireCache(cache);
+  if (cache.ids_valid)
+    return cache.ids;
   std::vector<std::string> device_ids;
   std::unique_ptr<webrtc::VideoCaptureModule::DeviceInfo> info(
       webrtc::VideoCaptureFactory::CreateDeviceInfo());
@@ -27,10 +76,19 @@ std::vector<std::string> DeviceUtils::VideoCapturerIds() {
       }
     }
   }
+  TouchCache(cache);
+  cache.ids = device_ids;
+  cache.ids_valid = true;
   return device_ids;
 }
 std::vector<Resolution> DeviceUtils::VideoCapturerSupportedResolutions(
     const std::string& id) {
+  DeviceInfoCache& cache = Cache();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  ExpireCache(cache);
+  auto cached = cache.resolutions.find(id);
+  if (cached != cache.resolutions.end())
+    return cached->second;
   std::vector<Resolution> resolutions;
   webrtc::VideoCaptureCapability capability;
   std::unique_ptr<webrtc::VideoCaptureModule::DeviceInfo> info(
@@ -76,6 +134,8 @@ std::vector<Resolution> DeviceUtils::VideoCapturerSupportedResolutions(
       }
     }
   }
+  TouchCache(cache);
+  cache.resolutions[id] = resolutions;
   return resolutions;
 }
 }
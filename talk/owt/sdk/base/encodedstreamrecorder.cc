@@ -0,0 +1,284 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "talk/owt/sdk/base/encodedstreamrecorder.h"
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "talk/owt/sdk/base/videoplaneops.h"
+#include "webrtc/common_types.h"
+#include "webrtc/rtc_base/logging.h"
+#include "webrtc/rtc_base/timeutils.h"
+namespace owt {
+namespace base {
+namespace {
+// Segments roll at this size so a crash loses at most one partially
+// written segment and readers can prune old segments by file.
+const size_t kSegmentBytes = 64 * 1024 * 1024;
+// Stream buffer handed to the CRT. Large sequential writes flushed in
+// megabyte chunks approach raw disk throughput without the alignment
+// constraints direct I/O would put on variable-size frames.
+const size_t kStreamBufferBytes = 1 * 1024 * 1024;
+// Frames queued ahead of the writer before Record starts dropping. At
+// typical bitrates this covers multiple seconds of stalled disk.
+const size_t kMaxQueuedFrames = 64;
+// Payload buffers kept for reuse once the writer is done with them.
+const size_t kMaxPooledBuffers = 16;
+const uint32_t kFileMagic = 0x5254574f;  // "OWTR" little-endian.
+const uint32_t kFileVersion = 1;
+const uint32_t kFlagKeyFrame = 1;
+
+#pragma pack(push, 1)
+struct FileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t record_header_size;
+  uint32_t reserved;
+  int64_t start_time_ms;
+  uint8_t padding[8];
+};
+struct RecordHeader {
+  uint32_t payload_size;
+  uint32_t codec_fourcc;
+  uint32_t rtp_timestamp;
+  uint32_t flags;
+  int64_t capture_time_ms;
+  int64_t write_time_ms;
+};
+#pragma pack(pop)
+static_assert(sizeof(FileHeader) == 32, "File header must stay 32 bytes.");
+static_assert(sizeof(RecordHeader) == 32, "Record header must stay 32 bytes.");
+
+uint32_t CodecFourcc(int codec_type) {
+  switch (codec_type) {
+    case webrtc::kVideoCodecVP8:
+      return 0x20385056;  // "VP8 "
+    case webrtc::kVideoCodecVP9:
+      return 0x20395056;  // "VP9 "
+    case webrtc::kVideoCodecH264:
+      return 0x34363248;  // "H264"
+#ifndef DISABLE_H265
+    case webrtc::kVideoCodecH265:
+      return 0x35363248;  // "H265"
+#endif
+    default:
+      return 0x4e4b4e55;  // "UNKN"
+  }
+}
+
+struct QueuedFrame {
+  RecordHeader header;
+  std::vector<uint8_t> payload;
+};
+
+class Recorder {
+ public:
+  explicit Recorder(const std::string& directory)
+      : directory_(directory),
+        start_time_ms_(rtc::TimeMillis()),
+        segment_index_(0),
+        segment_bytes_(0),
+        segment_(nullptr),
+        stopped_(false),
+        dropped_frames_(0) {}
+
+  bool Start() {
+    if (!OpenSegment())
+      return false;
+    writer_thread_ = std::thread(&Recorder::WriterLoop, this);
+    return true;
+  }
+
+  void Stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopped_ = true;
+    }
+    wake_.notify_one();
+    writer_thread_.join();
+    if (segment_ != nullptr) {
+      fclose(segment_);
+      segment_ = nullptr;
+    }
+    RTC_LOG(LS_INFO) << "Encoded stream recording stopped: "
+                     << segment_index_ + 1 << " segment(s), "
+                     << dropped_frames_ << " frame(s) dropped.";
+  }
+
+  void Record(int codec_type,
+              uint32_t rtp_timestamp,
+              int64_t capture_time_ms,
+              bool is_keyframe,
+              const uint8_t* data,
+              size_t size) {
+    // The encoders own their bitstream buffers and reuse them once the
+    // delivery callback returns, so the frame is copied once onto a
+    // pooled buffer here; everything after this line is off the encode
+    // thread.
+    QueuedFrame frame;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stopped_)
+        return;
+      if (queue_.size() >= kMaxQueuedFrames) {
+        ++dropped_frames_;
+        return;
+      }
+      if (!buffer_pool_.empty()) {
+        frame.payload.swap(buffer_pool_.back());
+        buffer_pool_.pop_back();
+      }
+    }
+    // The payload copy runs on the encode thread; stream large frames
+    // past the cache so recording does not evict the encoder's working
+    // set.
+    frame.payload.resize(size);
+    CopyVideoBuffer(frame.payload.data(), data, size);
+    frame.header.payload_size = static_cast<uint32_t>(size);
+    frame.header.codec_fourcc = CodecFourcc(codec_type);
+    frame.header.rtp_timestamp = rtp_timestamp;
+    frame.header.flags = is_keyframe ? kFlagKeyFrame : 0;
+    frame.header.capture_time_ms = capture_time_ms;
+    frame.header.write_time_ms = rtc::TimeMillis();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stopped_ || queue_.size() >= kMaxQueuedFrames) {
+        ++dropped_frames_;
+        return;
+      }
+      queue_.push_back(std::move(frame));
+    }
+    wake_.notify_one();
+  }
+
+ private:
+  bool OpenSegment() {
+    char name[64];
+    snprintf(name, sizeof(name), "/owt-rec-%lld-%04u.owtr",
+             static_cast<long long>(start_time_ms_), segment_index_);
+    std::string path = directory_ + name;
+    segment_ = fopen(path.c_str(), "wb");
+    if (segment_ == nullptr) {
+      RTC_LOG(LS_ERROR) << "Failed to create recording segment " << path;
+      return false;
+    }
+    setvbuf(segment_, nullptr, _IOFBF, kStreamBufferBytes);
+    FileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = kFileMagic;
+    header.version = kFileVersion;
+    header.record_header_size = sizeof(RecordHeader);
+    header.start_time_ms = start_time_ms_;
+    fwrite(&header, sizeof(header), 1, segment_);
+    segment_bytes_ = sizeof(header);
+    return true;
+  }
+
+  void WriterLoop() {
+    std::deque<QueuedFrame> batch;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock, [this] { return !queue_.empty() || stopped_; });
+        if (queue_.empty() && stopped_)
+          return;
+        batch.swap(queue_);
+      }
+      for (QueuedFrame& frame : batch) {
+        if (segment_bytes_ + sizeof(RecordHeader) + frame.payload.size() >
+                kSegmentBytes &&
+            segment_bytes_ > sizeof(FileHeader)) {
+          fclose(segment_);
+          segment_ = nullptr;
+          ++segment_index_;
+          if (!OpenSegment())
+            return;
+        }
+        if (segment_ == nullptr)
+          continue;
+        fwrite(&frame.header, sizeof(frame.header), 1, segment_);
+        fwrite(frame.payload.data(), 1, frame.payload.size(), segment_);
+        segment_bytes_ += sizeof(frame.header) + frame.payload.size();
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (buffer_pool_.size() < kMaxPooledBuffers) {
+          frame.payload.clear();
+          buffer_pool_.push_back(std::move(frame.payload));
+        }
+      }
+      batch.clear();
+    }
+  }
+
+  const std::string directory_;
+  const int64_t start_time_ms_;
+  uint32_t segment_index_;
+  size_t segment_bytes_;
+  FILE* segment_;
+  std::thread writer_thread_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::deque<QueuedFrame> queue_;
+  std::vector<std::vector<uint8_t>> buffer_pool_;
+  bool stopped_;
+  uint64_t dropped_frames_;
+};
+
+std::mutex g_recorder_mutex;
+Recorder* g_recorder = nullptr;
+std::atomic<bool> g_active(false);
+}  // namespace
+
+bool EncodedStreamRecorder::Start(const std::string& directory) {
+  std::lock_guard<std::mutex> lock(g_recorder_mutex);
+  if (g_recorder != nullptr)
+    return true;
+  Recorder* recorder = new Recorder(directory);
+  if (!recorder->Start()) {
+    delete recorder;
+    return false;
+  }
+  g_recorder = recorder;
+  g_active.store(true, std::memory_order_release);
+  RTC_LOG(LS_INFO) << "Encoded stream recording started in " << directory;
+  return true;
+}
+
+void EncodedStreamRecorder::Stop() {
+  Recorder* recorder = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(g_recorder_mutex);
+    if (g_recorder == nullptr)
+      return;
+    g_active.store(false, std::memory_order_release);
+    recorder = g_recorder;
+    g_recorder = nullptr;
+  }
+  recorder->Stop();
+  delete recorder;
+}
+
+bool EncodedStreamRecorder::Active() {
+  return g_active.load(std::memory_order_acquire);
+}
+
+void EncodedStreamRecorder::Record(int codec_type,
+                                   uint32_t rtp_timestamp,
+                                   int64_t capture_time_ms,
+                                   bool is_keyframe,
+                                   const uint8_t* data,
+                                   size_t size) {
+  if (data == nullptr || size == 0)
+    return;
+  std::lock_guard<std::mutex> lock(g_recorder_mutex);
+  if (g_recorder == nullptr)
+    return;
+  g_recorder->Record(codec_type, rtp_timestamp, capture_time_ms, is_keyframe,
+                     data, size);
+}
+}  // namespace base
+}  // namespace owt
@@ -0,0 +1,51 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_ENCODEDSTREAMRECORDER_H_
+#define OWT_BASE_ENCODEDSTREAMRECORDER_H_
+#include <string>
+#include "webrtc/rtc_base/basictypes.h"
+namespace owt {
+namespace base {
+// Process-wide tap on encoder output for always-on local recording. The
+// encoders hand every delivered frame to Record after OnEncodedImage; a
+// dedicated writer thread appends the frames to rolling segment files, so
+// recording costs the encode path one buffer copy and one queue push per
+// frame instead of a second encode pipeline.
+//
+// Segment file layout: a 32-byte file header (magic "OWTR", version,
+// record-header size, start time), then back-to-back records, each a
+// 32-byte record header (payload size, codec fourcc, RTP timestamp,
+// flags, capture and write times) followed by the raw bitstream payload.
+// Segments roll at a fixed size; a reader concatenates them in name
+// order. Frames from concurrently published streams are interleaved in
+// delivery order and separated by codec fourcc and RTP timestamp.
+//
+// Record never blocks the encode thread: when the writer falls behind a
+// bounded queue, frames are dropped and counted rather than queued
+// without limit.
+class EncodedStreamRecorder {
+ public:
+  // Starts recording into |directory|, which must already exist. Returns
+  // false when the first segment file cannot be created. Calling Start
+  // while recording is active is a no-op returning true.
+  static bool Start(const std::string& directory);
+  // Stops recording, flushes and closes the current segment, and joins
+  // the writer thread. Safe to call when recording is not active.
+  static void Stop();
+  // Whether a recording session is active. Encoders check this before
+  // assembling a Record call so the disabled path costs one atomic load.
+  static bool Active();
+  // Queues one encoded frame for persistence. |codec_type| is a
+  // webrtc::VideoCodecType value; |data| must stay valid for the
+  // duration of the call only.
+  static void Record(int codec_type,
+                     uint32_t rtp_timestamp,
+                     int64_t capture_time_ms,
+                     bool is_keyframe,
+                     const uint8_t* data,
+                     size_t size);
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_ENCODEDSTREAMRECORDER_H_
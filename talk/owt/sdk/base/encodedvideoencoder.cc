@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include "talk/owt/sdk/base/encodedvideoencoder.h"
+#include "talk/owt/sdk/include/cpp/owt/base/globalconfiguration.h"
 #include "webrtc/rtc_base/checks.h"
 #include "webrtc/rtc_base/logging.h"
 #include "webrtc/rtc_base/buffer.h"
@@ -17,7 +18,7 @@
 // Maximum allowed NALUs in one output frame.
 #define MAX_NALUS_PERFRAME 32
 EncodedVideoEncoder::EncodedVideoEncoder(webrtc::VideoCodecType type)
-    : callback_(nullptr) {
+    : callback_(nullptr), tl0_pic_idx_(0), temporal_pattern_idx_(0) {
   codecType_ = type;
   picture_id_ = 0;
 }
@@ -80,9 +81,30 @@ int EncodedVideoEncoder::Encode(
     info.codecSpecific.VP8.pictureId = picture_id_;
     info.codecSpecific.VP8.nonReference = false;
     info.codecSpecific.VP8.simulcastIdx = 0;
-    info.codecSpecific.VP8.temporalIdx = webrtc::kNoTemporalIdx;
-    info.codecSpecific.VP8.layerSync = false;
-    info.codecSpecific.VP8.tl0PicIdx = webrtc::kNoTl0PicIdx;
+    int temporal_layers =
+        owt::base::GlobalConfiguration::GetEncodedVideoTemporalLayers();
+    if (temporal_layers == 2 || temporal_layers == 3) {
+      // Standard temporal cadence: {0,1} for two layers, {0,2,1,2} for
+      // three. The pre-encoded stream must have been produced with the
+      // same pattern; we only annotate it so an SFU can drop upper layers.
+      static const int kTwoLayerPattern[2] = {0, 1};
+      static const int kThreeLayerPattern[4] = {0, 2, 1, 2};
+      int pattern_size = (temporal_layers == 2) ? 2 : 4;
+      int position = static_cast<int>(temporal_pattern_idx_ % pattern_size);
+      int temporal_idx = (temporal_layers == 2) ? kTwoLayerPattern[position]
+                                                : kThreeLayerPattern[position];
+      if (temporal_idx == 0)
+        tl0_pic_idx_++;
+      info.codecSpecific.VP8.temporalIdx = temporal_idx;
+      // The first enhancement frame after a base frame references it only.
+      info.codecSpecific.VP8.layerSync = temporal_idx != 0 && position == 1;
+      info.codecSpecific.VP8.tl0PicIdx = tl0_pic_idx_;
+      temporal_pattern_idx_++;
+    } else {
+      info.codecSpecific.VP8.temporalIdx = webrtc::kNoTemporalIdx;
+      info.codecSpecific.VP8.layerSync = false;
+      info.codecSpecific.VP8.tl0PicIdx = webrtc::kNoTl0PicIdx;
+    }
     info.codecSpecific.VP8.keyIdx = webrtc::kNoKeyIdx;
     picture_id_ = (picture_id_ + 1) & 0x7FFF;
   }
@@ -31,6 +31,10 @@ class EncodedVideoEncoder : public webrtc::VideoEncoder {
   // int count_;
   webrtc::VideoCodecType codecType_;
   uint16_t picture_id_;
+  // Temporal annotation state for pre-encoded VP8 input; only advanced when
+  // GlobalConfiguration announces more than one temporal layer.
+  int16_t tl0_pic_idx_;
+  int64_t temporal_pattern_idx_;
   // FILE * fd;
 };      // EncodedVideoEncoder
 #endif  // WOOGEEN_BASE_ENCODEDVIDEOENCODER_H_
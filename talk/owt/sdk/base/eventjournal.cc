@@ -0,0 +1,140 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include "talk/owt/sdk/base/eventjournal.h"
+#include "webrtc/rtc_base/logging.h"
+#include "webrtc/rtc_base/timeutils.h"
+#if defined(WEBRTC_WIN)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+namespace owt {
+namespace base {
+namespace {
+const uint32_t kJournalVersion = 1;
+const int kDefaultRecordCapacity = 4096;
+// Header and record are both 64 bytes so records never straddle a cache
+// line and the layout is stable for offline readers.
+struct JournalHeader {
+  char magic[4];  // "OWTJ"
+  uint32_t version;
+  uint32_t record_size;
+  uint32_t record_capacity;
+  std::atomic<uint64_t> next_sequence;
+  uint8_t reserved[40];
+};
+struct JournalRecord {
+  // Claiming sequence plus one, written after the payload. Zero (the
+  // fresh-file value) and any value whose slot does not match mark the
+  // record invalid, which covers both unwritten and torn slots.
+  std::atomic<uint64_t> sequence;
+  int64_t timestamp_ms;
+  uint32_t kind;
+  int32_t value;
+  char tag[40];
+};
+static_assert(sizeof(JournalHeader) == 64, "Journal header must be 64 bytes.");
+static_assert(sizeof(JournalRecord) == 64, "Journal record must be 64 bytes.");
+struct Mapping {
+  JournalHeader* header;
+  JournalRecord* records;
+};
+// Published once by Open; never unmapped so appends racing with process
+// teardown stay safe. The leak is intentional.
+std::atomic<Mapping*> g_mapping(nullptr);
+std::mutex g_open_mutex;
+// Maps |size| bytes of |path| read-write and shared, creating or
+// overwriting the file. Returns nullptr on failure.
+void* MapJournalFile(const std::string& path, size_t size) {
+#if defined(WEBRTC_WIN)
+  HANDLE file =
+      CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                  FILE_SHARE_READ, nullptr, CREATE_ALWAYS,
+                  FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return nullptr;
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, 0,
+                                      static_cast<DWORD>(size), nullptr);
+  if (mapping == nullptr) {
+    CloseHandle(file);
+    return nullptr;
+  }
+  void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+  // The view keeps both handles' objects alive; close the handles so the
+  // only reference left is the mapping itself.
+  CloseHandle(mapping);
+  CloseHandle(file);
+  return view;
+#else
+  int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    return nullptr;
+  if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    close(fd);
+    return nullptr;
+  }
+  void* view =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  return view == MAP_FAILED ? nullptr : view;
+#endif
+}
+}  // namespace
+bool EventJournal::Open(const std::string& path, int record_capacity) {
+  std::lock_guard<std::mutex> lock(g_open_mutex);
+  if (g_mapping.load(std::memory_order_relaxed) != nullptr) {
+    RTC_LOG(LS_WARNING) << "Event journal is already open.";
+    return false;
+  }
+  uint32_t capacity = record_capacity > 0
+                          ? static_cast<uint32_t>(record_capacity)
+                          : static_cast<uint32_t>(kDefaultRecordCapacity);
+  size_t size = sizeof(JournalHeader) + capacity * sizeof(JournalRecord);
+  void* view = MapJournalFile(path, size);
+  if (view == nullptr) {
+    RTC_LOG(LS_ERROR) << "Failed to map event journal at " << path;
+    return false;
+  }
+  JournalHeader* header = static_cast<JournalHeader*>(view);
+  memcpy(header->magic, "OWTJ", 4);
+  header->version = kJournalVersion;
+  header->record_size = sizeof(JournalRecord);
+  header->record_capacity = capacity;
+  header->next_sequence.store(0, std::memory_order_relaxed);
+  Mapping* mapping = new Mapping;
+  mapping->header = header;
+  mapping->records = reinterpret_cast<JournalRecord*>(header + 1);
+  g_mapping.store(mapping, std::memory_order_release);
+  RTC_LOG(LS_INFO) << "Event journal mapped at " << path << " with "
+                   << capacity << " records.";
+  return true;
+}
+void EventJournal::Append(uint32_t kind, int32_t value, const char* tag) {
+  Mapping* mapping = g_mapping.load(std::memory_order_acquire);
+  if (mapping == nullptr)
+    return;
+  uint64_t sequence =
+      mapping->header->next_sequence.fetch_add(1, std::memory_order_relaxed);
+  JournalRecord& record =
+      mapping->records[sequence % mapping->header->record_capacity];
+  // Invalidate the slot before reusing it so a crash mid-write leaves a
+  // detectably torn record instead of a stale-but-plausible one.
+  record.sequence.store(0, std::memory_order_relaxed);
+  record.timestamp_ms = rtc::TimeMillis();
+  record.kind = kind;
+  record.value = value;
+  size_t tag_length = tag != nullptr ? strlen(tag) : 0;
+  if (tag_length > sizeof(record.tag))
+    tag_length = sizeof(record.tag);
+  memcpy(record.tag, tag, tag_length);
+  memset(record.tag + tag_length, 0, sizeof(record.tag) - tag_length);
+  record.sequence.store(sequence + 1, std::memory_order_release);
+}
+}  // namespace base
+}  // namespace owt
@@ -0,0 +1,50 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_EVENTJOURNAL_H_
+#define OWT_BASE_EVENTJOURNAL_H_
+#include <cstdint>
+#include <string>
+// Crash-safe event journal for post-mortem analysis. Key subsystems
+// append fixed-size records to a memory-mapped ring file, so when the
+// process dies the most recent state transitions are still on disk for
+// offline tooling; the kernel writes dirty pages of a shared file
+// mapping back even after an abnormal exit. Appends are wait-free: a
+// writer claims a slot with one atomic increment and never blocks, so
+// the journal is safe to leave on in production. The journal is off
+// until GlobalConfiguration::OpenEventJournal maps a file.
+//
+// File layout: a 64-byte header (magic "OWTJ", format version, record
+// size, record capacity, the 64-bit next sequence number) followed by
+// |record_capacity| 64-byte records. A record stores its claiming
+// sequence number plus one, written last, so a reader can drop slots
+// that were torn mid-write or never written; slot index is
+// (sequence - 1) % capacity, which recovers append order.
+namespace owt {
+namespace base {
+class EventJournal {
+ public:
+  // Record kinds; the value field of a record depends on the kind.
+  enum EventKind : uint32_t {
+    // P2P session state transition; value is the new SessionState.
+    kSessionStateChange = 1,
+    // ICE connection state change; value is the new IceConnectionState.
+    kIceConnectionChange = 2,
+    // Hardware decoder pipeline reset; value is unused.
+    kDecoderReset = 3,
+    // Watchdog-detected thread stall; value is the stall duration in
+    // milliseconds and the tag names the thread.
+    kThreadStall = 4,
+  };
+  // Maps |path| as a ring of |record_capacity| records, creating or
+  // overwriting the file. Returns false when the file cannot be mapped
+  // or a journal is already open. The mapping lives until process exit.
+  static bool Open(const std::string& path, int record_capacity);
+  // Appends one record; a no-op until Open succeeds. |tag| carries
+  // short context such as a session id and is truncated to fit the
+  // fixed record; pass "" when there is none.
+  static void Append(uint32_t kind, int32_t value, const char* tag);
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_EVENTJOURNAL_H_
@@ -1,49 +1,127 @@
 // Copyright (C) <2018> Intel Corporation
 //
 // SPDX-License-Identifier: Apache-2.0
+#include <atomic>
+#include <functional>
 #include <future>
+#include <memory>
 #include <thread>
+#include <tuple>
 #include <vector>
+#include "webrtc/rtc_base/checks.h"
+#include "webrtc/rtc_base/logging.h"
 #include "webrtc/rtc_base/task_queue.h"
+#include "talk/owt/sdk/base/tracelog.h"
 #ifndef OWT_BASE_EVENTTRIGGER_H_
 #define OWT_BASE_EVENTTRIGGER_H_
 namespace owt {
 namespace base {
+// A task queue dedicated to a single observer. Events for different
+// observers run on different queues, so one slow observer callback only
+// delays its own events instead of every event in the process. The queue
+// tracks its depth; when an observer falls more than |kMaxPendingEvents|
+// behind, further events for it are dropped with a warning instead of
+// growing the backlog without bound.
+class ObserverEventQueue final {
+ public:
+  explicit ObserverEventQueue(const char* queue_name)
+      : pending_events_(0), queue_(new rtc::TaskQueue(queue_name)) {}
+  template <typename C>
+  void PostEvent(C task) {
+    int depth = pending_events_.fetch_add(1) + 1;
+    if (depth > kMaxPendingEvents) {
+      pending_events_.fetch_sub(1);
+      RTC_LOG(LS_WARNING) << "Observer event queue overloaded with " << depth
+                          << " pending events. Dropping event.";
+      return;
+    }
+    std::atomic<int>* pending_events = &pending_events_;
+    queue_->PostTask([task, pending_events] {
+      task();
+      pending_events->fetch_sub(1);
+    });
+  }
+  /// Number of events posted but not yet handled by the observer.
+  int PendingEvents() const { return pending_events_.load(); }
+
+ private:
+  static const int kMaxPendingEvents = 512;
+  std::atomic<int> pending_events_;
+  // Declared last so it is destroyed first; destruction blocks on the
+  // running task and drops pending ones, which still touch
+  // |pending_events_|.
+  std::unique_ptr<rtc::TaskQueue> queue_;
+};
 /* @brief Functions for event execution
  * @details This class provide several static functions to execute event on its
  * observer asynchronously.
  */
 class EventTrigger final {
  public:
-  template <typename O, typename A, typename F>
-  static void OnEvent0(std::vector<O, A> const& observers,
-                       std::shared_ptr<rtc::TaskQueue> queue,
-                       F func) {
+  // Posts |func| with |args| to every observer. The arguments are stored
+  // once in a shared immutable pack instead of being copied into a bind
+  // object per observer, so deep payloads (streams, message strings) are
+  // captured a single time no matter how many observers are registered.
+  // Move-only payloads can be passed with std::move; observers then see
+  // the shared instance by reference.
+  template <typename O, typename A, typename F, typename... Args>
+  static void OnEvent(std::vector<O, A> const& observers,
+                      std::shared_ptr<rtc::TaskQueue> queue,
+                      F func,
+                      Args&&... args) {
+    typedef std::tuple<typename std::decay<Args>::type...> Pack;
+    auto pack = std::make_shared<const Pack>(std::forward<Args>(args)...);
     for (auto it = observers.begin(); it != observers.end(); ++it) {
-      auto f = std::bind(func, *it);
-      queue->PostTask([f] { f(); });
+      O observer = *it;
+      queue->PostTask([func, observer, pack] {
+        OWT_TRACE_SCOPE("EventTrigger.Dispatch");
+        Invoke(func, observer, *pack,
+               typename MakeIndexSequence<sizeof...(Args)>::Type());
+      });
     }
   }
-  template <typename O, typename A, typename F, typename T1>
-  static void OnEvent1(std::vector<O, A> const& observers,
-                       std::shared_ptr<rtc::TaskQueue> queue,
-                       F func,
-                       T1 arg1) {
-    for (auto it = observers.begin(); it != observers.end(); ++it) {
-      auto f = std::bind(func, *it, arg1);
-      queue->PostTask([f] { f(); });
+  // Variant delivering to per-observer queues. |queues| must be aligned
+  // with |observers|: observer i receives the event on queues[i].
+  template <typename O, typename A, typename F, typename... Args>
+  static void OnEvent(
+      std::vector<O, A> const& observers,
+      std::vector<std::shared_ptr<ObserverEventQueue>> const& queues,
+      F func,
+      Args&&... args) {
+    RTC_DCHECK_EQ(observers.size(), queues.size());
+    typedef std::tuple<typename std::decay<Args>::type...> Pack;
+    auto pack = std::make_shared<const Pack>(std::forward<Args>(args)...);
+    size_t i = 0;
+    for (auto it = observers.begin(); it != observers.end(); ++it, ++i) {
+      O observer = *it;
+      queues[i]->PostEvent([func, observer, pack] {
+        OWT_TRACE_SCOPE("EventTrigger.Dispatch");
+        Invoke(func, observer, *pack,
+               typename MakeIndexSequence<sizeof...(Args)>::Type());
+      });
     }
   }
-  template <typename O, typename A, typename F, typename T1, typename T2>
-  static void OnEvent2(std::vector<O, A> const& observers,
-                       std::shared_ptr<rtc::TaskQueue> queue,
-                       F func,
-                       T1 arg1,
-                       T2 arg2) {
-    for (auto it = observers.begin(); it != observers.end(); ++it) {
-      auto f = std::bind(func, *it, arg1, arg2);
-      queue->PostTask([f] { f(); });
-    }
+
+ private:
+  // Minimal compile-time index sequence; the toolchain baseline predates
+  // std::index_sequence.
+  template <size_t...>
+  struct IndexSequence {};
+  template <size_t N, size_t... I>
+  struct MakeIndexSequence : MakeIndexSequence<N - 1, N - 1, I...> {};
+  template <size_t... I>
+  struct MakeIndexSequence<0, I...> {
+    typedef IndexSequence<I...> Type;
+  };
+  // Invokes the member function with references into the shared pack;
+  // std::bind unwraps reference_wrapper observers and std::ref avoids
+  // copying the arguments into the bind object.
+  template <typename F, typename O, typename Pack, size_t... I>
+  static void Invoke(const F& func,
+                     const O& observer,
+                     const Pack& pack,
+                     IndexSequence<I...>) {
+    std::bind(func, observer, std::ref(std::get<I>(pack))...)();
   }
 };
 }
@@ -7,11 +7,18 @@ namespace base {
 Exception::Exception()
     : Exception(ExceptionType::kUnknown, "Unknown exception.") {}
 Exception::Exception(const ExceptionType& type, const std::string& message)
-    : type_(type), message_(message) {}
+    : type_(type), literal_message_(nullptr), message_(message) {}
+Exception::Exception(const ExceptionType& type, const char* message)
+    : type_(type), literal_message_(message) {}
 ExceptionType Exception::Type() const {
   return type_;
 }
+int Exception::Code() const {
+  return static_cast<int>(type_);
+}
 std::string Exception::Message() const {
+  if (literal_message_ != nullptr)
+    return literal_message_;
   return message_;
 }
 }
@@ -1,20 +1,85 @@
 // Copyright (C) <2018> Intel Corporation
 //
 // SPDX-License-Identifier: Apache-2.0
+#include <cstddef>
+#include <mutex>
+#include <vector>
 #include "talk/owt/sdk/base/functionalobserver.h"
 namespace owt {
 namespace base {
+namespace {
+// Fixed-size block recycler backing the SDP observers' operator new. The
+// offer/answer path allocates a handful of short-lived ref-counted
+// observers per negotiation; returning their blocks to a capped free list
+// keeps that path off the global allocator. Each pool only ever sees one
+// allocation size (the concrete RefCountedObject<Observer>), recorded in
+// a header so foreign sizes fall back to plain new/delete.
+class RecycledObserverPool {
+ public:
+  void* Allocate(size_t size) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (block_size_ == 0)
+        block_size_ = size;
+      if (size == block_size_ && !free_blocks_.empty()) {
+        char* block = free_blocks_.back();
+        free_blocks_.pop_back();
+        return block + kHeaderSize;
+      }
+    }
+    char* block = static_cast<char*>(::operator new(size + kHeaderSize));
+    *reinterpret_cast<size_t*>(block) = size;
+    return block + kHeaderSize;
+  }
+  void Release(void* ptr) {
+    char* block = static_cast<char*>(ptr) - kHeaderSize;
+    size_t size = *reinterpret_cast<size_t*>(block);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (size == block_size_ && free_blocks_.size() < kMaxFreeBlocks) {
+        free_blocks_.push_back(block);
+        return;
+      }
+    }
+    ::operator delete(block);
+  }
+ private:
+  // Large enough to keep the payload aligned for any observer member.
+  static const size_t kHeaderSize = alignof(std::max_align_t);
+  static const size_t kMaxFreeBlocks = 32;
+  std::mutex mutex_;
+  size_t block_size_ = 0;
+  std::vector<char*> free_blocks_;
+};
+// Leaked on purpose so observers released during static destruction
+// still have a pool to return to.
+RecycledObserverPool& CreateSessionDescriptionObserverPool() {
+  static RecycledObserverPool* pool = new RecycledObserverPool();
+  return *pool;
+}
+RecycledObserverPool& SetSessionDescriptionObserverPool() {
+  static RecycledObserverPool* pool = new RecycledObserverPool();
+  return *pool;
+}
+}  // namespace
 FunctionalCreateSessionDescriptionObserver::
     FunctionalCreateSessionDescriptionObserver(
         std::function<void(webrtc::SessionDescriptionInterface*)> on_success,
         std::function<void(const std::string&)> on_failure)
-    : on_success_(on_success), on_failure_(on_failure) {}
+    : on_success_(std::move(on_success)),
+      on_failure_(std::move(on_failure)) {}
 rtc::scoped_refptr<FunctionalCreateSessionDescriptionObserver>
 FunctionalCreateSessionDescriptionObserver::Create(
     std::function<void(webrtc::SessionDescriptionInterface*)> on_success,
     std::function<void(const std::string&)> on_failure) {
   return new rtc::RefCountedObject<FunctionalCreateSessionDescriptionObserver>(
-      on_success, on_failure);
+      std::move(on_success), std::move(on_failure));
+}
+void* FunctionalCreateSessionDescriptionObserver::operator new(size_t size) {
+  return CreateSessionDescriptionObserverPool().Allocate(size);
+}
+void FunctionalCreateSessionDescriptionObserver::operator delete(void* ptr) {
+  CreateSessionDescriptionObserverPool().Release(ptr);
 }
 void FunctionalCreateSessionDescriptionObserver::OnSuccess(
     webrtc::SessionDescriptionInterface* desc) {
@@ -32,13 +97,20 @@ FunctionalSetSessionDescriptionObserver::
     FunctionalSetSessionDescriptionObserver(
         std::function<void()> on_success,
         std::function<void(const std::string&)> on_failure)
-    : on_success_(on_success), on_failure_(on_failure) {}
+    : on_success_(std::move(on_success)),
+      on_failure_(std::move(on_failure)) {}
 rtc::scoped_refptr<FunctionalSetSessionDescriptionObserver>
 FunctionalSetSessionDescriptionObserver::Create(
     std::function<void()> on_success,
     std::function<void(const std::string&)> on_failure) {
   return new rtc::RefCountedObject<FunctionalSetSessionDescriptionObserver>(
-      on_success, on_failure);
+      std::move(on_success), std::move(on_failure));
+}
+void* FunctionalSetSessionDescriptionObserver::operator new(size_t size) {
+  return SetSessionDescriptionObserverPool().Allocate(size);
+}
+void FunctionalSetSessionDescriptionObserver::operator delete(void* ptr) {
+  SetSessionDescriptionObserverPool().Release(ptr);
 }
 void FunctionalSetSessionDescriptionObserver::OnSuccess() {
   if (on_success_ != nullptr) {
@@ -61,6 +133,35 @@ rtc::scoped_refptr<FunctionalStatsObserver> FunctionalStatsObserver::Create(
 void FunctionalStatsObserver::OnComplete(const webrtc::StatsReports& reports) {
   if (on_complete_ != nullptr) {
     std::shared_ptr<ConnectionStats> connection_stats(new ConnectionStats());
+    // Count the report types first so every report vector is sized once
+    // instead of regrowing while the snapshot is filled. Stats are polled
+    // periodically, so the avoided reallocations add up.
+    size_t audio_receiver_count = 0;
+    size_t audio_sender_count = 0;
+    size_t video_receiver_count = 0;
+    size_t video_sender_count = 0;
+    for (const auto* report : reports) {
+      switch (GetReportType(report)) {
+        case REPORT_AUDIO_RECEIVER:
+          audio_receiver_count++;
+          break;
+        case REPORT_AUDIO_SENDER:
+          audio_sender_count++;
+          break;
+        case REPORT_VIDEO_RECEIVER:
+          video_receiver_count++;
+          break;
+        case REPORT_VIDEO_SENDER:
+          video_sender_count++;
+          break;
+        default:
+          break;
+      }
+    }
+    connection_stats->audio_receiver_reports.reserve(audio_receiver_count);
+    connection_stats->audio_sender_reports.reserve(audio_sender_count);
+    connection_stats->video_receiver_reports.reserve(video_receiver_count);
+    connection_stats->video_sender_reports.reserve(video_sender_count);
     int32_t adapt_reason = static_cast<int32_t>(VideoSenderReport::AdaptReason::kUnknown);
     for (const auto* report : reports) {
       ReportType report_type = GetReportType(report);
@@ -81,6 +182,9 @@ void FunctionalStatsObserver::OnComplete(const webrtc::StatsReports& reports) {
                 GetValue<int>(
                     &webrtc::StatsReport::Value::int_val, report,
                     webrtc::StatsReport::kStatsValueNameCurrentDelayMs, 0),
+                GetValue<int>(
+                    &webrtc::StatsReport::Value::int_val, report,
+                    webrtc::StatsReport::kStatsValueNameAudioOutputLevel, 0),
                 GetValue<std::string>(
                     &webrtc::StatsReport::Value::string_val, report,
                     webrtc::StatsReport::kStatsValueNameCodecName, "")));
@@ -233,6 +337,29 @@ void FunctionalStatsObserver::OnComplete(const webrtc::StatsReports& reports) {
             GetValue<int>(&webrtc::StatsReport::Value::int_val, report,
                           webrtc::StatsReport::kStatsValueNameRetransmitBitrate,
                           0);
+        connection_stats->video_bandwidth_stats.target_encoding_bitrate =
+            GetValue<int>(&webrtc::StatsReport::Value::int_val, report,
+                          webrtc::StatsReport::kStatsValueNameTargetEncBitrate,
+                          0);
+        connection_stats->video_bandwidth_stats.actual_encoding_bitrate =
+            GetValue<int>(&webrtc::StatsReport::Value::int_val, report,
+                          webrtc::StatsReport::kStatsValueNameActualEncBitrate,
+                          0);
+        connection_stats->video_bandwidth_stats.pacer_queue_delay_ms =
+            static_cast<int32_t>(GetValue<int64_t>(
+                &webrtc::StatsReport::Value::int64_val, report,
+                webrtc::StatsReport::kStatsValueNameBucketDelay, 0));
+        // The engine does not report padding directly; whatever part of
+        // the transmit rate is neither media nor retransmission is
+        // padding.
+        {
+          int32_t padding =
+              connection_stats->video_bandwidth_stats.transmit_bitrate -
+              connection_stats->video_bandwidth_stats.retransmit_bitrate -
+              connection_stats->video_bandwidth_stats.actual_encoding_bitrate;
+          connection_stats->video_bandwidth_stats.padding_bitrate =
+              padding > 0 ? padding : 0;
+        }
         break;
       }
       default:
@@ -19,6 +19,10 @@ class FunctionalCreateSessionDescriptionObserver
   static rtc::scoped_refptr<FunctionalCreateSessionDescriptionObserver> Create(
       std::function<void(webrtc::SessionDescriptionInterface*)> on_success,
       std::function<void(const std::string&)> on_failure);
+  // Every SDP operation allocates one of these; storage comes from a
+  // recycled block pool instead of the global allocator.
+  static void* operator new(size_t size);
+  static void operator delete(void* ptr);
   virtual void OnSuccess(webrtc::SessionDescriptionInterface* desc);
   virtual void OnFailure(const std::string& error);
  protected:
@@ -37,6 +41,9 @@ class FunctionalSetSessionDescriptionObserver
   static rtc::scoped_refptr<FunctionalSetSessionDescriptionObserver> Create(
       std::function<void()> on_success,
       std::function<void(const std::string&)> on_failure);
+  // See FunctionalCreateSessionDescriptionObserver::operator new.
+  static void* operator new(size_t size);
+  static void operator delete(void* ptr);
   virtual void OnSuccess();
   virtual void OnFailure(const std::string& error);
  protected:
@@ -1,16 +1,221 @@
 // Copyright (C) <2018> Intel Corporation
 //
 // SPDX-License-Identifier: Apache-2.0
+#include <thread>
+#include "owt/base/deviceutils.h"
 #include "owt/base/globalconfiguration.h"
+#include "talk/owt/sdk/base/configurationsnapshot.h"
+#include "talk/owt/sdk/base/encodedstreamrecorder.h"
+#include "talk/owt/sdk/base/eventjournal.h"
+#include "talk/owt/sdk/base/overloadgovernor.h"
+#include "talk/owt/sdk/base/peerconnectiondependencyfactory.h"
+#include "talk/owt/sdk/base/queuedepthgauges.h"
+#include "talk/owt/sdk/base/threadwatchdog.h"
+#include "talk/owt/sdk/base/tracelog.h"
+#include "talk/owt/sdk/base/videofreezedetector.h"
+#include "webrtc/rtc_base/logging.h"
+#if defined(WEBRTC_WIN)
+#include "talk/owt/sdk/base/win/msdkvideobase.h"
+#endif
 namespace owt {
 namespace base {
+void GlobalConfiguration::Prewarm() {
+  // Get() is mutex guarded and idempotent, so racing with a concurrent
+  // first connection is safe; whichever side arrives second reuses the
+  // instance the first one built.
+  std::thread([]() {
+    PeerConnectionDependencyFactory::Get();
+    // Warm the device enumeration cache as well so the first device
+    // picker opens instantly.
+    DeviceUtils::VideoCapturerIds();
+#if defined(WEBRTC_WIN)
+    // Codec factories enumerate lazily, so the Media SDK dispatcher and
+    // session are not touched until the first video session; load them
+    // here so that session finds them ready.
+    MSDKFactory::Get();
+#endif
+  }).detach();
+}
+bool GlobalConfiguration::LoadConfigurationSnapshot(const std::string& path) {
+  std::vector<ConfigurationSnapshotEntry> entries;
+  if (!ReadConfigurationSnapshot(path, &entries)) {
+    return false;
+  }
+  for (const ConfigurationSnapshotEntry& entry : entries) {
+    int64_t value = entry.value;
+    switch (static_cast<ConfigurationSnapshotKey>(entry.key)) {
+      case ConfigurationSnapshotKey::kVideoHardwareAccelerationEnabled:
+        SetVideoHardwareAccelerationEnabled(value != 0);
+        break;
+      case ConfigurationSnapshotKey::kHardwareEncoderPreset:
+        if (value >= static_cast<int64_t>(
+                         HardwareEncoderPreset::kQualityStreaming) &&
+            value <= static_cast<int64_t>(
+                         HardwareEncoderPreset::kUltraLowLatency)) {
+          SetHardwareEncoderPreset(
+              static_cast<HardwareEncoderPreset>(value));
+        }
+        break;
+      case ConfigurationSnapshotKey::kGpuSurfaceBudgetMB:
+        SetGpuSurfaceBudgetMB(static_cast<int>(value));
+        break;
+      case ConfigurationSnapshotKey::kCodecThreadAffinityMask:
+        SetCodecThreadAffinityMask(static_cast<uint64_t>(value));
+        break;
+      case ConfigurationSnapshotKey::kCaptureThreadAffinityMask:
+        SetCaptureThreadAffinityMask(static_cast<uint64_t>(value));
+        break;
+      case ConfigurationSnapshotKey::kCodecAdapterIndex:
+        SetCodecAdapterIndex(static_cast<int>(value));
+        break;
+      case ConfigurationSnapshotKey::kDecodeThreadPoolSize:
+        SetDecodeThreadPoolSize(static_cast<int>(value));
+        break;
+      case ConfigurationSnapshotKey::kSoftwareFallbackThreadCount:
+        SetSoftwareFallbackThreadCount(static_cast<int>(value));
+        break;
+      case ConfigurationSnapshotKey::kSharedCaptureThreadEnabled:
+        SetSharedCaptureThreadEnabled(value != 0);
+        break;
+      case ConfigurationSnapshotKey::kPeerConnectionFactoryCount:
+        SetPeerConnectionFactoryCount(static_cast<int>(value));
+        break;
+      case ConfigurationSnapshotKey::kLatestFrameRenderingEnabled:
+        SetLatestFrameRenderingEnabled(value != 0);
+        break;
+      case ConfigurationSnapshotKey::kKeyFrameRequestCoalescingWindowMs:
+        SetKeyFrameRequestCoalescingWindowMs(static_cast<int>(value));
+        break;
+      case ConfigurationSnapshotKey::kEncodedVideoTemporalLayers:
+        SetEncodedVideoTemporalLayers(static_cast<int>(value));
+        break;
+      case ConfigurationSnapshotKey::kEncodedBitstreamValidationEnabled:
+        SetEncodedBitstreamValidationEnabled(value != 0);
+        break;
+      case ConfigurationSnapshotKey::kVideoFreezeThresholdMs:
+        SetVideoFreezeThreshold(static_cast<int>(value));
+        break;
+      case ConfigurationSnapshotKey::
+          kAudioProcessingBypassedForCustomizedInput:
+        SetAudioProcessingBypassedForCustomizedInput(value != 0);
+        break;
+      case ConfigurationSnapshotKey::kInjectedAudioSilenceSuppressionEnabled:
+        SetInjectedAudioSilenceSuppressionEnabled(value != 0);
+        break;
+      case ConfigurationSnapshotKey::kD3D11CameraCaptureEnabled:
+        SetD3D11CameraCaptureEnabled(value != 0);
+        break;
+      case ConfigurationSnapshotKey::kSoftwareFallbackPreset:
+        if (value >= static_cast<int64_t>(SoftwareEncoderPreset::kBalanced) &&
+            value <= static_cast<int64_t>(SoftwareEncoderPreset::kQuality)) {
+          SetSoftwareFallbackPreset(static_cast<SoftwareEncoderPreset>(value));
+        }
+        break;
+      default:
+        // A newer tool may ship keys this SDK does not know yet.
+        RTC_LOG(LS_INFO) << "Skipping unknown configuration snapshot key "
+                         << entry.key;
+        break;
+    }
+  }
+  return true;
+}
+void GlobalConfiguration::SetTraceLogEnabled(bool enabled) {
+  TraceLog::SetEnabled(enabled);
+}
+bool GlobalConfiguration::ExportTraceLog(const std::string& path) {
+  return TraceLog::ExportToFile(path);
+}
+void GlobalConfiguration::SetQueueDepthThresholdCallback(
+    int depth,
+    std::function<void(const std::string& gauge, int depth)> callback) {
+  QueueDepthGauges::SetThresholdCallback(depth, std::move(callback));
+}
+void GlobalConfiguration::SetVideoFreezeThreshold(int threshold_ms) {
+  VideoFreezeDetector::SetFreezeThreshold(threshold_ms);
+}
+bool GlobalConfiguration::OpenEventJournal(const std::string& path,
+                                           int record_capacity) {
+  return EventJournal::Open(path, record_capacity);
+}
+void GlobalConfiguration::StartThreadWatchdog(
+    int stall_threshold_ms,
+    std::function<void(const std::string& thread_name,
+                       const std::string& last_checkpoint,
+                       int stalled_ms)> callback) {
+  ThreadWatchdog::Start(
+      stall_threshold_ms,
+      [callback](const ThreadWatchdog::StallReport& report) {
+        if (callback) {
+          callback(report.thread_name, report.section, report.stalled_ms);
+        }
+      });
+}
+void GlobalConfiguration::StopThreadWatchdog() {
+  ThreadWatchdog::Stop();
+}
+void GlobalConfiguration::StartOverloadGovernor(
+    int encode_p99_overload_ms,
+    std::function<void(int level)> on_level_changed) {
+  OverloadGovernorPolicy policy;
+  if (encode_p99_overload_ms > 0) {
+    policy.encode_p99_overload_ms = encode_p99_overload_ms;
+    policy.encode_p99_recover_ms = encode_p99_overload_ms / 2;
+  }
+  OverloadGovernor::Start(policy, std::move(on_level_changed));
+}
+void GlobalConfiguration::StopOverloadGovernor() {
+  OverloadGovernor::Stop();
+}
+bool GlobalConfiguration::StartEncodedFrameRecording(
+    const std::string& directory) {
+  return EncodedStreamRecorder::Start(directory);
+}
+void GlobalConfiguration::StopEncodedFrameRecording() {
+  EncodedStreamRecorder::Stop();
+}
 #if defined(WEBRTC_WIN)
 // Enable hardware acceleration by default is on.
 bool GlobalConfiguration::hardware_acceleration_enabled_ = true;
+// Cameras are captured into system memory by default.
+bool GlobalConfiguration::d3d11_camera_capture_enabled_ = false;
+// Hardware encoders favor quality over latency by default.
+HardwareEncoderPreset GlobalConfiguration::hardware_encoder_preset_ =
+    HardwareEncoderPreset::kQualityStreaming;
+// GPU surface pools are uncapped by default.
+int GlobalConfiguration::gpu_surface_budget_mb_ = 0;
+int GlobalConfiguration::decoded_frame_scaling_width_ = 0;
+int GlobalConfiguration::decoded_frame_scaling_height_ = 0;
+// Threads are left to the scheduler unless the application opts in.
+uint64_t GlobalConfiguration::codec_thread_affinity_mask_ = 0;
+uint64_t GlobalConfiguration::capture_thread_affinity_mask_ = 0;
+// Sessions balance across adapters unless pinned.
+int GlobalConfiguration::codec_adapter_index_ = -1;
+// Four shared decoder lanes by default.
+int GlobalConfiguration::decode_thread_pool_size_ = 4;
+// Software fallback encoders thread by core count at engine defaults.
+int GlobalConfiguration::software_fallback_thread_count_ = 0;
+SoftwareEncoderPreset GlobalConfiguration::software_fallback_preset_ =
+    SoftwareEncoderPreset::kBalanced;
 #endif
 bool GlobalConfiguration::encoded_frame_ = false;
+// Each capturer owns a dedicated pacing thread by default.
+bool GlobalConfiguration::shared_capture_thread_ = false;
+int GlobalConfiguration::pc_factory_count_ = 1;
+// Frames are delivered to renderers synchronously by default.
+bool GlobalConfiguration::latest_frame_rendering_enabled_ = false;
 std::unique_ptr<AudioFrameGeneratorInterface>
     GlobalConfiguration::audio_frame_generator_ = nullptr;
+// Generator-sourced audio traverses audio processing by default.
+bool GlobalConfiguration::customized_audio_processing_bypassed_ = false;
+// Silent generator-sourced frames keep encoding by default.
+bool GlobalConfiguration::injected_audio_silence_suppression_enabled_ = false;
+// Keyframe requests are forwarded unchanged by default.
+int GlobalConfiguration::key_frame_request_coalescing_window_ms_ = 0;
+// Pre-encoded input signals no temporal structure by default.
+int GlobalConfiguration::encoded_video_temporal_layers_ = 1;
+// Injected bitstreams are trusted by default.
+bool GlobalConfiguration::encoded_bitstream_validation_enabled_ = false;
 #if defined(WEBRTC_WIN) || defined(WEBRTC_LINUX)
 std::unique_ptr<VideoDecoderInterface>
     GlobalConfiguration::video_decoder_ = nullptr;
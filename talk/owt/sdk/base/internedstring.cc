@@ -0,0 +1,52 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include <mutex>
+#include <unordered_map>
+#include "talk/owt/sdk/include/cpp/owt/base/internedstring.h"
+namespace owt {
+namespace base {
+namespace {
+// The pool holds weak references so interned values are freed once the
+// last holder drops them; expired entries are swept when the pool grows
+// past this bound, which keeps the sweep off every Intern call.
+const size_t kSweepThreshold = 4096;
+struct Pool {
+  std::mutex mutex;
+  std::unordered_map<std::string, std::weak_ptr<const std::string>> entries;
+};
+Pool& GetPool() {
+  // Leaked on purpose; interned values may be created during shutdown.
+  static Pool* pool = new Pool();
+  return *pool;
+}
+}  // namespace
+InternedString InternedString::Intern(const std::string& value) {
+  Pool& pool = GetPool();
+  std::lock_guard<std::mutex> lock(pool.mutex);
+  auto it = pool.entries.find(value);
+  if (it != pool.entries.end()) {
+    std::shared_ptr<const std::string> live = it->second.lock();
+    if (live) {
+      return InternedString(std::move(live));
+    }
+  }
+  if (pool.entries.size() >= kSweepThreshold) {
+    for (auto entry = pool.entries.begin(); entry != pool.entries.end();) {
+      if (entry->second.expired()) {
+        entry = pool.entries.erase(entry);
+      } else {
+        ++entry;
+      }
+    }
+  }
+  std::shared_ptr<const std::string> shared(new std::string(value));
+  pool.entries[value] = shared;
+  return InternedString(std::move(shared));
+}
+const std::string& InternedString::str() const {
+  static const std::string empty;
+  return value_ ? *value_ : empty;
+}
+}  // namespace base
+}  // namespace owt
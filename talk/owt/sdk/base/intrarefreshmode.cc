@@ -0,0 +1,21 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include <atomic>
+#include "talk/owt/sdk/base/intrarefreshmode.h"
+namespace owt {
+namespace base {
+namespace {
+std::atomic<int> g_active_publications(0);
+}  // namespace
+void IntraRefreshMode::AddPublication() {
+  g_active_publications.fetch_add(1, std::memory_order_relaxed);
+}
+void IntraRefreshMode::RemovePublication() {
+  g_active_publications.fetch_sub(1, std::memory_order_relaxed);
+}
+bool IntraRefreshMode::Active() {
+  return g_active_publications.load(std::memory_order_relaxed) > 0;
+}
+}  // namespace base
+}  // namespace owt
@@ -0,0 +1,23 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_INTRAREFRESHMODE_H_
+#define OWT_BASE_INTRAREFRESHMODE_H_
+// Process-wide count of active publications that requested gradual
+// decoder refresh (PublishOptions::intra_refresh). Hardware encoders
+// are created by codec factories without publication identity, so they
+// cannot be configured per publication; instead they read this count at
+// initialization and replace periodic IDR frames with an intra-refresh
+// sweep while any such publication is live.
+namespace owt {
+namespace base {
+class IntraRefreshMode {
+ public:
+  static void AddPublication();
+  static void RemovePublication();
+  // True while at least one intra-refresh publication is active.
+  static bool Active();
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_INTRAREFRESHMODE_H_
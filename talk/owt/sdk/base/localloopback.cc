@@ -0,0 +1,132 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "talk/owt/sdk/base/localloopback.h"
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <vector>
+#include "webrtc/rtc_base/logging.h"
+namespace owt {
+namespace base {
+namespace {
+// Ring space for the loopback segment. A few dozen high-bitrate frames;
+// the consumer is on the same machine and expected to keep up.
+const size_t kLoopbackRingBytes = 8 * 1024 * 1024;
+// Per-record metadata travelling ahead of the bitstream payload.
+struct FrameHeader {
+  uint32_t rtp_timestamp;
+  uint32_t is_keyframe;
+};
+struct SenderState {
+  std::mutex mutex;
+  std::unique_ptr<ShmRingBuffer> ring;
+  std::vector<uint8_t> scratch;
+};
+SenderState& GetSenderState() {
+  // Leaked on purpose; encoders may deliver during static destruction.
+  static SenderState* state = new SenderState();
+  return *state;
+}
+std::atomic<bool> g_sender_active(false);
+}  // namespace
+bool LocalLoopbackSender::Start(const std::string& segment_name) {
+  SenderState& state = GetSenderState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  if (state.ring) {
+    RTC_LOG(LS_WARNING) << "Loopback sender already active; one session at "
+                           "a time.";
+    return false;
+  }
+  state.ring = ShmRingBuffer::Create(segment_name, kLoopbackRingBytes);
+  if (!state.ring) {
+    return false;
+  }
+  g_sender_active.store(true, std::memory_order_release);
+  RTC_LOG(LS_INFO) << "Local loopback sender started on segment "
+                   << segment_name;
+  return true;
+}
+void LocalLoopbackSender::Stop() {
+  SenderState& state = GetSenderState();
+  g_sender_active.store(false, std::memory_order_release);
+  std::lock_guard<std::mutex> lock(state.mutex);
+  if (state.ring && state.ring->dropped_records() > 0) {
+    RTC_LOG(LS_WARNING) << "Loopback session dropped "
+                        << state.ring->dropped_records() << " frames.";
+  }
+  state.ring.reset();
+}
+bool LocalLoopbackSender::Active() {
+  return g_sender_active.load(std::memory_order_acquire);
+}
+void LocalLoopbackSender::Deliver(uint32_t rtp_timestamp,
+                                  bool is_keyframe,
+                                  const uint8_t* data,
+                                  size_t size) {
+  if (data == nullptr || size == 0) {
+    return;
+  }
+  SenderState& state = GetSenderState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  if (!state.ring) {
+    return;
+  }
+  FrameHeader header;
+  header.rtp_timestamp = rtp_timestamp;
+  header.is_keyframe = is_keyframe ? 1 : 0;
+  // One contiguous record per frame; the scratch buffer keeps its
+  // capacity across frames.
+  state.scratch.resize(sizeof(header) + size);
+  memcpy(state.scratch.data(), &header, sizeof(header));
+  memcpy(state.scratch.data() + sizeof(header), data, size);
+  state.ring->Write(state.scratch.data(), state.scratch.size());
+}
+LocalLoopbackReceiver::LocalLoopbackReceiver() : running_(false) {}
+LocalLoopbackReceiver::~LocalLoopbackReceiver() {
+  Stop();
+}
+bool LocalLoopbackReceiver::Start(const std::string& segment_name,
+                                  FrameCallback callback) {
+  if (running_.load() || !callback) {
+    return false;
+  }
+  ring_ = ShmRingBuffer::Open(segment_name);
+  if (!ring_) {
+    return false;
+  }
+  callback_ = std::move(callback);
+  running_.store(true);
+  poller_ = std::thread(&LocalLoopbackReceiver::PollLoop, this);
+  RTC_LOG(LS_INFO) << "Local loopback receiver attached to segment "
+                   << segment_name;
+  return true;
+}
+void LocalLoopbackReceiver::Stop() {
+  if (!running_.exchange(false)) {
+    return;
+  }
+  poller_.join();
+  ring_.reset();
+}
+void LocalLoopbackReceiver::PollLoop() {
+  std::vector<uint8_t> record;
+  while (running_.load(std::memory_order_relaxed)) {
+    if (!ring_->Read(&record)) {
+      // An empty ring is the steady state between frames; a short sleep
+      // keeps delivery latency well under a frame interval without
+      // spinning a core.
+      std::this_thread::sleep_for(std::chrono::microseconds(250));
+      continue;
+    }
+    if (record.size() <= sizeof(FrameHeader)) {
+      continue;
+    }
+    FrameHeader header;
+    memcpy(&header, record.data(), sizeof(header));
+    callback_(record.data() + sizeof(header), record.size() - sizeof(header),
+              header.rtp_timestamp, header.is_keyframe != 0);
+  }
+}
+}  // namespace base
+}  // namespace owt
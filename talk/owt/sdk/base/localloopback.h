@@ -0,0 +1,67 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_LOCALLOOPBACK_H_
+#define OWT_BASE_LOCALLOOPBACK_H_
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include "talk/owt/sdk/base/shmringbuffer.h"
+// Same-host encoded-frame loopback. When publisher and subscriber run
+// in separate processes on one machine, looping through the network
+// stack costs milliseconds and a redundant decode; this pair hands the
+// already-encoded frames across a shared memory ring instead. The
+// sender is a process-wide tap next to EncodedStreamRecorder on the
+// encoder output path - every delivered frame is copied into the ring
+// while a loopback session is active, an atomic load when it is not.
+// The receiver polls the ring on its own thread and hands each frame to
+// a callback. Segment names are negotiated by P2PClient over the
+// regular signaling channel; opening the named segment is the
+// authoritative same-machine check.
+namespace owt {
+namespace base {
+class LocalLoopbackSender {
+ public:
+  // Creates the shared memory segment and starts mirroring encoder
+  // output into it. Returns false when the segment cannot be created.
+  static bool Start(const std::string& segment_name);
+  // Stops mirroring and removes the segment.
+  static void Stop();
+  // Whether a loopback session is active; encoders check this before
+  // assembling a Deliver call.
+  static bool Active();
+  // Mirrors one encoded frame into the ring. |data| must stay valid for
+  // the duration of the call only; a full ring drops the frame.
+  static void Deliver(uint32_t rtp_timestamp,
+                      bool is_keyframe,
+                      const uint8_t* data,
+                      size_t size);
+};
+class LocalLoopbackReceiver {
+ public:
+  // |data| is only valid inside the callback. The callback runs on the
+  // receiver's poll thread and must not block.
+  using FrameCallback = std::function<void(const uint8_t* data,
+                                           size_t size,
+                                           uint32_t rtp_timestamp,
+                                           bool is_keyframe)>;
+  LocalLoopbackReceiver();
+  ~LocalLoopbackReceiver();
+  // Opens the negotiated segment and starts the poll thread. Returns
+  // false when the segment does not exist, which a negotiating client
+  // treats as "not the same machine".
+  bool Start(const std::string& segment_name, FrameCallback callback);
+  void Stop();
+
+ private:
+  void PollLoop();
+  std::unique_ptr<ShmRingBuffer> ring_;
+  FrameCallback callback_;
+  std::atomic<bool> running_;
+  std::thread poller_;
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_LOCALLOOPBACK_H_
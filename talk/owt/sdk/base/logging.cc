@@ -41,10 +41,29 @@ void Logging::LogToFileRotate(LoggingSeverity severity, std::string& dir, size_t
   min_severity_ = severity;
   std::shared_ptr<CallSessionRotatingLogSink> log_sink = CallSessionRotatingLogSink::Create(dir, max_log_size);
   log_sink->Init();
+  // File writes happen on the sink's writer thread so media threads only
+  // pay for a queue append per message; the writer packs messages into
+  // page-sized writes.
+  log_sink->EnableAsyncWrites();
   rtc::LogMessage::AddLogToStream(log_sink.get(), logging_severity_map[static_cast<int>(severity)]);
 }
 LoggingSeverity Logging::Severity() {
   return min_severity_;
 }
+// Modules log everything their severity allows by default; the global
+// severity remains the only gate until a module is tuned down.
+LoggingSeverity Logging::module_severity_[kLoggingModuleCount] = {
+    LoggingSeverity::kSensitive, LoggingSeverity::kSensitive,
+    LoggingSeverity::kSensitive, LoggingSeverity::kSensitive};
+void Logging::ModuleSeverity(LoggingModule module, LoggingSeverity severity) {
+  module_severity_[static_cast<int>(module)] = severity;
+}
+LoggingSeverity Logging::ModuleSeverity(LoggingModule module) {
+  return module_severity_[static_cast<int>(module)];
+}
+bool Logging::ModuleEnabled(LoggingModule module, LoggingSeverity severity) {
+  return static_cast<int>(severity) >=
+         static_cast<int>(module_severity_[static_cast<int>(module)]);
+}
 }
 }
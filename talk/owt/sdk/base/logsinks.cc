@@ -15,6 +15,10 @@
 namespace owt {
 namespace base {
 using namespace rtc;
+// Writer batches are flushed in chunks of this size.
+static const size_t kLogWriteChunkSize = 4096;
+// Bound on messages waiting for the writer thread.
+static const size_t kMaxQueuedLogMessages = 8192;
 RotatingLogSink::RotatingLogSink(const std::string& log_dir_path,
                                          const std::string& log_prefix,
                                          size_t max_log_size,
@@ -25,18 +29,92 @@ RotatingLogSink::RotatingLogSink(const std::string& log_dir_path,
                                                  num_log_files)) {
 }
 RotatingLogSink::RotatingLogSink(FileRotatingStream* stream)
-    : stream_(stream) {
+    : stream_(stream),
+      async_(false),
+      dropped_messages_(0),
+      writer_stop_(false) {
   RTC_DCHECK(stream);
 }
 RotatingLogSink::~RotatingLogSink() {
+  if (writer_thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(queue_mutex_);
+      writer_stop_ = true;
+    }
+    queue_wake_.notify_one();
+    // The writer drains everything still queued before it exits.
+    writer_thread_.join();
+  }
 }
 void RotatingLogSink::OnLogMessage(const std::string& message) {
+  if (async_) {
+    {
+      std::lock_guard<std::mutex> lock(queue_mutex_);
+      if (pending_messages_.size() >= kMaxQueuedLogMessages) {
+        dropped_messages_++;
+        return;
+      }
+      pending_messages_.push_back(message);
+    }
+    queue_wake_.notify_one();
+    return;
+  }
   if (stream_->GetState() != SS_OPEN) {
     std::cerr << "Init() must be called before adding this sink." << std::endl;
     return;
   }
   stream_->WriteAll(message.c_str(), message.size(), nullptr, nullptr);
 }
+void RotatingLogSink::EnableAsyncWrites() {
+  if (async_)
+    return;
+  async_ = true;
+  writer_thread_ = std::thread(&RotatingLogSink::WriterLoop, this);
+}
+void RotatingLogSink::WriterLoop() {
+  std::vector<std::string> batch;
+  while (true) {
+    size_t dropped = 0;
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex_);
+      queue_wake_.wait(lock, [this] {
+        return writer_stop_ || !pending_messages_.empty();
+      });
+      if (pending_messages_.empty() && writer_stop_)
+        return;
+      batch.swap(pending_messages_);
+      dropped = dropped_messages_;
+      dropped_messages_ = 0;
+    }
+    WriteBatch(batch, dropped);
+    batch.clear();
+  }
+}
+void RotatingLogSink::WriteBatch(const std::vector<std::string>& batch,
+                                 size_t dropped_messages) {
+  if (stream_->GetState() != SS_OPEN) {
+    std::cerr << "Init() must be called before adding this sink." << std::endl;
+    return;
+  }
+  // Pack messages into page-sized writes; one syscall per chunk instead
+  // of one per message.
+  std::string chunk;
+  chunk.reserve(kLogWriteChunkSize);
+  for (const auto& message : batch) {
+    if (!chunk.empty() && chunk.size() + message.size() > kLogWriteChunkSize) {
+      stream_->WriteAll(chunk.c_str(), chunk.size(), nullptr, nullptr);
+      chunk.clear();
+    }
+    chunk += message;
+  }
+  if (dropped_messages > 0) {
+    chunk += "[logging] dropped " + std::to_string(dropped_messages) +
+             " messages under overload\n";
+  }
+  if (!chunk.empty()) {
+    stream_->WriteAll(chunk.c_str(), chunk.size(), nullptr, nullptr);
+  }
+}
 bool RotatingLogSink::Init() {
   return stream_->Open();
 }
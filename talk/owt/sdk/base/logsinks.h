@@ -10,8 +10,12 @@
 // This file is borrowed from webrtc/rtc_base/logsinks.h
 #ifndef OWT_BASE_LOGSINKS_H_
 #define OWT_BASE_LOGSINKS_H_
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 #include "webrtc/rtc_base/constructormagic.h"
 #include "webrtc/rtc_base/filerotatingstream.h"
 #include "webrtc/rtc_base/logging.h"
@@ -36,10 +40,29 @@ class RotatingLogSink : public LogSink {
   virtual bool Init();
   // Disables buffering on the underlying stream.
   bool DisableBuffering();
+  // Routes messages through a dedicated writer thread instead of writing
+  // on the logging thread. Messages are queued and flushed in page-sized
+  // chunks, so threads emitting logs only pay for a queue append. The
+  // queue is bounded; under sustained overload messages are dropped and
+  // the drop count is recorded in the log. Call once, before the sink is
+  // added to the log stream.
+  void EnableAsyncWrites();
  protected:
   explicit RotatingLogSink(FileRotatingStream* stream);
  private:
+  // Runs on |writer_thread_|; drains the queue until asked to stop.
+  void WriterLoop();
+  // Writes one drained batch, packing messages into page-sized chunks.
+  void WriteBatch(const std::vector<std::string>& batch,
+                  size_t dropped_messages);
   std::unique_ptr<FileRotatingStream> stream_;
+  bool async_;
+  std::vector<std::string> pending_messages_;
+  size_t dropped_messages_;
+  std::mutex queue_mutex_;
+  std::condition_variable queue_wake_;
+  std::thread writer_thread_;
+  bool writer_stop_;
   RTC_DISALLOW_COPY_AND_ASSIGN(RotatingLogSink);
 };
 // Log sink that uses a OWTFileRotatingStream to write to disk.
@@ -0,0 +1,21 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include <atomic>
+#include "talk/owt/sdk/base/lowlatencymode.h"
+namespace owt {
+namespace base {
+namespace {
+std::atomic<int> g_active_subscriptions(0);
+}  // namespace
+void LowLatencyMode::AddSubscription() {
+  g_active_subscriptions.fetch_add(1, std::memory_order_relaxed);
+}
+void LowLatencyMode::RemoveSubscription() {
+  g_active_subscriptions.fetch_sub(1, std::memory_order_relaxed);
+}
+bool LowLatencyMode::Active() {
+  return g_active_subscriptions.load(std::memory_order_relaxed) > 0;
+}
+}  // namespace base
+}  // namespace owt
@@ -0,0 +1,23 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_LOWLATENCYMODE_H_
+#define OWT_BASE_LOWLATENCYMODE_H_
+// Process-wide count of active low-latency subscriptions
+// (SubscribeOptions::low_latency). Hardware decoders and renderers are
+// created by codec factories without subscription identity, so they
+// cannot be configured per subscription; instead they read this count
+// and apply their latency-over-smoothness settings while any
+// low-latency subscription is live.
+namespace owt {
+namespace base {
+class LowLatencyMode {
+ public:
+  static void AddSubscription();
+  static void RemoveSubscription();
+  // True while at least one low-latency subscription is active.
+  static bool Active();
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_LOWLATENCYMODE_H_
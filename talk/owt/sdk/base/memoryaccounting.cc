@@ -0,0 +1,64 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include <map>
+#include <mutex>
+#include "talk/owt/sdk/base/memoryaccounting.h"
+#include "webrtc/rtc_base/logging.h"
+namespace owt {
+namespace base {
+namespace {
+struct CategoryCounters {
+  CategoryCounters() : bytes(0), allocations(0) {}
+  uint64_t bytes;
+  uint64_t allocations;
+};
+struct Registry {
+  std::mutex mutex;
+  // Ordered so snapshots list categories deterministically.
+  std::map<std::string, CategoryCounters> categories;
+};
+Registry& GetRegistry() {
+  // Leaked on purpose; allocation sites may report during static
+  // destruction of other objects.
+  static Registry* registry = new Registry();
+  return *registry;
+}
+}  // namespace
+void MemoryAccounting::Add(const std::string& category, uint64_t bytes) {
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  CategoryCounters& counters = registry.categories[category];
+  counters.bytes += bytes;
+  counters.allocations++;
+}
+void MemoryAccounting::Release(const std::string& category, uint64_t bytes) {
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  CategoryCounters& counters = registry.categories[category];
+  if (counters.bytes < bytes || counters.allocations == 0) {
+    RTC_LOG(LS_WARNING) << "Unbalanced memory accounting release for "
+                        << category;
+    counters.bytes = 0;
+    counters.allocations = 0;
+    return;
+  }
+  counters.bytes -= bytes;
+  counters.allocations--;
+}
+std::vector<MemoryStatsEntry> MemoryAccounting::Snapshot() {
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  std::vector<MemoryStatsEntry> entries;
+  entries.reserve(registry.categories.size());
+  for (const auto& category : registry.categories) {
+    MemoryStatsEntry entry;
+    entry.category = category.first;
+    entry.bytes = category.second.bytes;
+    entry.allocations = category.second.allocations;
+    entries.push_back(entry);
+  }
+  return entries;
+}
+}  // namespace base
+}  // namespace owt
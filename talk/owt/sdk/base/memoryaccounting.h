@@ -0,0 +1,29 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_MEMORYACCOUNTING_H_
+#define OWT_BASE_MEMORYACCOUNTING_H_
+#include <string>
+#include <vector>
+#include "talk/owt/sdk/include/cpp/owt/base/memorystats.h"
+namespace owt {
+namespace base {
+// Process-wide registry of SDK memory grouped by subsystem. Allocation
+// sites report their allocations and releases here; clients expose a
+// snapshot through GetMemoryStats so a node's footprint can be
+// attributed without a heap profiler. Categories are created on first
+// use and counters stay at zero after everything is released, so a
+// snapshot always lists every subsystem that ever allocated.
+class MemoryAccounting {
+ public:
+  // Records one allocation of |bytes| in |category|.
+  static void Add(const std::string& category, uint64_t bytes);
+  // Records the release of one allocation of |bytes| from |category|.
+  // |bytes| must match the value passed to Add.
+  static void Release(const std::string& category, uint64_t bytes);
+  // Returns the current counters for all categories.
+  static std::vector<MemoryStatsEntry> Snapshot();
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_MEMORYACCOUNTING_H_
@@ -0,0 +1,39 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_MODULELOGGING_H_
+#define OWT_BASE_MODULELOGGING_H_
+#include "talk/owt/sdk/include/cpp/owt/base/logging.h"
+#include "webrtc/rtc_base/logging.h"
+// Module-tagged logging for SDK hot paths.
+//
+// OWT_MODULE_LOG(kVideoCodec, kVerbose) << ...; behaves like RTC_LOG but
+// is additionally gated on the module's runtime severity
+// (Logging::ModuleSeverity) and on a compile-time floor: statements whose
+// severity is below OWT_MIN_COMPILED_LOG_SEVERITY are dead code, so
+// release builds pay nothing for verbose statements left in per-frame
+// loops. The floor defaults to kInfo in release builds and kSensitive
+// (everything compiled) otherwise; override it on the compiler command
+// line with the integer value of an owt::base::LoggingSeverity member.
+#ifndef OWT_MIN_COMPILED_LOG_SEVERITY
+#if defined(NDEBUG)
+#define OWT_MIN_COMPILED_LOG_SEVERITY 3 /* LoggingSeverity::kInfo */
+#else
+#define OWT_MIN_COMPILED_LOG_SEVERITY 1 /* LoggingSeverity::kSensitive */
+#endif
+#endif
+// Maps owt severity names onto the rtc severities RTC_LOG_V expects.
+#define OWT_RTC_SEVERITY_kSensitive rtc::LS_SENSITIVE
+#define OWT_RTC_SEVERITY_kVerbose rtc::LS_VERBOSE
+#define OWT_RTC_SEVERITY_kInfo rtc::LS_INFO
+#define OWT_RTC_SEVERITY_kWarning rtc::LS_WARNING
+#define OWT_RTC_SEVERITY_kError rtc::LS_ERROR
+#define OWT_MODULE_LOG(module, severity)                         \
+  if (static_cast<int>(owt::base::LoggingSeverity::severity) <   \
+      OWT_MIN_COMPILED_LOG_SEVERITY) {                           \
+  } else if (!owt::base::Logging::ModuleEnabled(                 \
+                 owt::base::LoggingModule::module,               \
+                 owt::base::LoggingSeverity::severity)) {        \
+  } else                                                         \
+    RTC_LOG_V(OWT_RTC_SEVERITY_##severity)
+#endif  // OWT_BASE_MODULELOGGING_H_
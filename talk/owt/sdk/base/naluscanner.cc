@@ -0,0 +1,103 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "talk/owt/sdk/base/naluscanner.h"
+#include "webrtc/typedefs.h"
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+#include <emmintrin.h>
+#endif
+// H.264/H.265 start code length.
+#define NALU_SC_LENGTH 4
+namespace owt {
+namespace base {
+// Returns the offset of the next start code in |buffer|, or -1 when there
+// is none. |sc_length| receives the start code size (3 or 4 bytes).
+static int32_t NextStartCode(const uint8_t* buffer,
+                             size_t buffer_size,
+                             size_t* sc_length) {
+  if (buffer_size < NALU_SC_LENGTH) {
+    return -1;
+  }
+  const uint8_t* head = buffer;
+  // Set end buffer pointer to 4 bytes before actual buffer end so we can
+  // access head[1], head[2] and head[3] in a loop without buffer overrun.
+  const uint8_t* end = buffer + buffer_size - NALU_SC_LENGTH;
+  while (head < end) {
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+    // Every start code begins with a zero byte, so 16-byte blocks holding
+    // no zero at all can be skipped wholesale instead of byte by byte. This
+    // is where the scan spends its time on high-bitrate payload.
+    while (end - head >= 16) {
+      __m128i block =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(head));
+      int zero_mask =
+          _mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_setzero_si128()));
+      if (zero_mask != 0)
+        break;
+      head += 16;
+    }
+    if (head >= end)
+      break;
+#endif
+    if (head[0]) {
+      head++;
+      continue;
+    }
+    if (head[1]) {  // got 00xx
+      head += 2;
+      continue;
+    }
+    if (head[2]) {  // got 0000xx
+      if (head[2] == 0x01) {
+        *sc_length = 3;
+        return (int32_t)(head - buffer);
+      }
+      head += 3;
+      continue;
+    }
+    if (head[3] != 0x01) {  // got 000000xx
+      head++;               // xx != 1, continue searching.
+      continue;
+    }
+    *sc_length = 4;
+    return (int32_t)(head - buffer);
+  }
+  return -1;
+}
+int32_t ScanNaluFragments(const uint8_t* buffer,
+                          size_t buffer_size,
+                          webrtc::RTPFragmentationHeader* header) {
+  int32_t sc_positions[kMaxNalusPerFrame + 1] = {};
+  size_t sc_lengths[kMaxNalusPerFrame + 1] = {};
+  int32_t nalu_count = 0;
+  int32_t sc_position = 0;
+  while (nalu_count < kMaxNalusPerFrame) {
+    size_t sc_length = 0;
+    int32_t nalu_position = NextStartCode(
+        buffer + sc_position, buffer_size - sc_position, &sc_length);
+    if (nalu_position < 0) {
+      break;
+    }
+    sc_position += nalu_position;
+    sc_positions[nalu_count] = sc_position;
+    sc_lengths[nalu_count] = sc_length;
+    nalu_count++;
+    sc_position += static_cast<int32_t>(sc_length);
+  }
+  if (nalu_count == 0) {
+    return 0;
+  }
+  sc_positions[nalu_count] = static_cast<int32_t>(buffer_size);
+  header->VerifyAndAllocateFragmentationHeader(nalu_count);
+  for (int32_t i = 0; i < nalu_count; i++) {
+    header->fragmentationOffset[i] =
+        sc_positions[i] + static_cast<int32_t>(sc_lengths[i]);
+    header->fragmentationLength[i] =
+        sc_positions[i + 1] - header->fragmentationOffset[i];
+    header->fragmentationPlType[i] = 0;
+    header->fragmentationTimeDiff[i] = 0;
+  }
+  return nalu_count;
+}
+}  // namespace base
+}  // namespace owt
@@ -0,0 +1,21 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_NALUSCANNER_H_
+#define OWT_BASE_NALUSCANNER_H_
+#include "webrtc/modules/include/module_common_types.h"
+namespace owt {
+namespace base {
+// Maximum allowed NALUs in one output frame.
+const int32_t kMaxNalusPerFrame = 32;
+// Scans an Annex-B bitstream for 00 00 01 / 00 00 00 01 start codes and
+// fills |header| with one fragment per NALU in a single pass, using a
+// vectorized scan on x86. At most kMaxNalusPerFrame NALUs are emitted.
+// Returns the number of NALUs found; 0 when the stream holds no start code,
+// in which case |header| is left untouched.
+int32_t ScanNaluFragments(const uint8_t* buffer,
+                          size_t buffer_size,
+                          webrtc::RTPFragmentationHeader* header);
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_NALUSCANNER_H_
@@ -6,16 +6,28 @@
 #include "api/video/video_frame_buffer.h"
 #include "rtc_base/checks.h"
 #include "rtc_base/scoped_ref_ptr.h"
+#if defined(WEBRTC_IOS) || defined(WEBRTC_MAC)
+#include <CoreVideo/CVPixelBuffer.h>
+#endif
 namespace owt {
 namespace base {
 using namespace webrtc;
 class NativeHandleBuffer : public VideoFrameBuffer{
  public:
+   // Tells consumers on the encode path what native_handle() points at,
+   // so they can branch without guessing at the pointee type.
+   enum HandleType {
+     kUnspecified = 0,
+     kNV12HostMemory,
+     kD3D11Texture,
+     kCVPixelBuffer,
+   };
    NativeHandleBuffer(void* native_handle, int width, int height)
     :native_handle_(native_handle)
     ,width_(width)
     ,height_(height) {}
    Type type() const override { return Type::kNative; }
+   virtual HandleType handle_type() const { return kUnspecified; }
    int width() const override { return width_; }
    int height() const override { return height_; }
    rtc::scoped_refptr<I420BufferInterface> ToI420() override {
@@ -29,6 +41,61 @@ class NativeHandleBuffer : public VideoFrameBuffer{
    const int width_;
    const int height_;
 };
+// Describes one NV12 frame held in system memory. Passed as the native
+// handle of a kNative frame buffer so a hardware encoder expecting NV12
+// input can read the planes directly, without an I420 round trip.
+struct NV12ImageHandle {
+  uint8_t* data_y;
+  uint8_t* data_uv;
+  int stride_y;
+  int stride_uv;
+};
+// VideoFrameBuffer carrying an NV12 frame. Owns its pixel storage;
+// native_handle() returns an NV12ImageHandle describing the two planes.
+class NV12NativeBuffer : public NativeHandleBuffer {
+ public:
+  NV12NativeBuffer(int width, int height)
+      : NativeHandleBuffer(&image_handle_, width, height),
+        data_(new uint8_t[width * height * 3 / 2]) {
+    image_handle_.data_y = data_;
+    image_handle_.data_uv = data_ + width * height;
+    image_handle_.stride_y = width;
+    image_handle_.stride_uv = width;
+  }
+  virtual ~NV12NativeBuffer() { delete[] data_; }
+  HandleType handle_type() const override { return kNV12HostMemory; }
+  // Start address of the contiguous Y plus UV storage, for frame sources
+  // that fill the buffer as one blob.
+  uint8_t* MutableData() { return data_; }
+  uint32_t capacity() const { return width() * height() * 3 / 2; }
+ private:
+  NV12ImageHandle image_handle_;
+  uint8_t* data_;
+};
+#if defined(WEBRTC_IOS) || defined(WEBRTC_MAC)
+// VideoFrameBuffer carrying a CVPixelBuffer by reference. The
+// constructor adopts a +1 reference handed over by the frame source and
+// releases it when the frame leaves the pipeline, so IOSurface-backed
+// frames travel to the VideoToolbox encoder without their planes ever
+// being copied. native_handle() returns the CVPixelBufferRef.
+class CVPixelBufferNativeBuffer : public NativeHandleBuffer {
+ public:
+  CVPixelBufferNativeBuffer(CVPixelBufferRef pixel_buffer,
+                            int width,
+                            int height)
+      : NativeHandleBuffer(pixel_buffer, width, height),
+        pixel_buffer_(pixel_buffer) {}
+  ~CVPixelBufferNativeBuffer() override {
+    if (pixel_buffer_ != nullptr) {
+      CVPixelBufferRelease(pixel_buffer_);
+    }
+  }
+  HandleType handle_type() const override { return kCVPixelBuffer; }
+
+ private:
+  CVPixelBufferRef pixel_buffer_;
+};
+#endif
 }  // namespace base
 }  // namespace owt
 #endif  // OWT_NATIVE_HANDLE_BUFFER_H_
@@ -0,0 +1,140 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include <thread>
+#include "talk/owt/sdk/base/networkchangenotifier.h"
+#include "webrtc/rtc_base/logging.h"
+#include "webrtc/rtc_base/timeutils.h"
+#if defined(WEBRTC_WIN)
+#include <winsock2.h>
+#include <iphlpapi.h>
+#include <windows.h>
+#elif defined(WEBRTC_LINUX) && !defined(WEBRTC_ANDROID)
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+namespace owt {
+namespace base {
+namespace {
+// Interface changes arrive in bursts (address removed, link down, new
+// address, routes); one restart covers the whole burst.
+const int64_t kCoalesceIntervalMs = 1000;
+}  // namespace
+
+NetworkChangeNotifier::NetworkChangeNotifier()
+    : next_id_(0), monitor_started_(false), last_notify_ms_(0) {}
+
+NetworkChangeNotifier* NetworkChangeNotifier::Get() {
+  // Leaked on purpose; the monitor thread runs for the process lifetime.
+  static NetworkChangeNotifier* const notifier = new NetworkChangeNotifier();
+  return notifier;
+}
+
+int NetworkChangeNotifier::AddCallback(Callback callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  int id = next_id_++;
+  callbacks_[id] = std::move(callback);
+  StartMonitorLocked();
+  return id;
+}
+
+void NetworkChangeNotifier::RemoveCallback(int id) {
+  // Callbacks are invoked under |mutex_|, so taking it here blocks until
+  // an in-flight invocation returns.
+  std::lock_guard<std::mutex> lock(mutex_);
+  callbacks_.erase(id);
+}
+
+void NetworkChangeNotifier::StartMonitorLocked() {
+  if (monitor_started_) {
+    return;
+  }
+  monitor_started_ = true;
+  // |this| is the process-lifetime singleton, so the detached thread can
+  // never outlive it.
+  std::thread([this] { MonitorLoop(); }).detach();
+}
+
+void NetworkChangeNotifier::NotifyChange() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  int64_t now_ms = rtc::TimeMillis();
+  if (now_ms - last_notify_ms_ < kCoalesceIntervalMs) {
+    return;
+  }
+  last_notify_ms_ = now_ms;
+  RTC_LOG(LS_INFO) << "Network change detected; notifying "
+                   << callbacks_.size() << " listeners.";
+  for (auto& entry : callbacks_) {
+    entry.second();
+  }
+}
+
+#if defined(WEBRTC_WIN)
+void NetworkChangeNotifier::MonitorLoop() {
+  OVERLAPPED overlap = {};
+  overlap.hEvent = ::CreateEventW(nullptr, FALSE, FALSE, nullptr);
+  if (!overlap.hEvent) {
+    RTC_LOG(LS_ERROR) << "Failed to create network change event.";
+    return;
+  }
+  while (true) {
+    HANDLE handle = nullptr;
+    DWORD result = ::NotifyAddrChange(&handle, &overlap);
+    if (result != NO_ERROR && ::GetLastError() != ERROR_IO_PENDING) {
+      RTC_LOG(LS_ERROR) << "NotifyAddrChange failed: " << ::GetLastError();
+      break;
+    }
+    if (::WaitForSingleObject(overlap.hEvent, INFINITE) != WAIT_OBJECT_0) {
+      break;
+    }
+    NotifyChange();
+  }
+  ::CloseHandle(overlap.hEvent);
+}
+#elif defined(WEBRTC_LINUX) && !defined(WEBRTC_ANDROID)
+void NetworkChangeNotifier::MonitorLoop() {
+  int fd = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
+  if (fd < 0) {
+    RTC_LOG(LS_ERROR) << "Failed to open netlink socket.";
+    return;
+  }
+  struct sockaddr_nl addr = {};
+  addr.nl_family = AF_NETLINK;
+  addr.nl_groups =
+      RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+  if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+    RTC_LOG(LS_ERROR) << "Failed to bind netlink socket.";
+    close(fd);
+    return;
+  }
+  char buffer[4096];
+  while (true) {
+    ssize_t length = recv(fd, buffer, sizeof(buffer), 0);
+    if (length < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    for (struct nlmsghdr* header =
+             reinterpret_cast<struct nlmsghdr*>(buffer);
+         NLMSG_OK(header, static_cast<size_t>(length));
+         header = NLMSG_NEXT(header, length)) {
+      if (header->nlmsg_type == RTM_NEWADDR ||
+          header->nlmsg_type == RTM_DELADDR ||
+          header->nlmsg_type == RTM_NEWLINK ||
+          header->nlmsg_type == RTM_DELLINK) {
+        NotifyChange();
+        break;
+      }
+    }
+  }
+  close(fd);
+}
+#else
+void NetworkChangeNotifier::MonitorLoop() {}
+#endif
+}  // namespace base
+}  // namespace owt
@@ -0,0 +1,47 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_NETWORKCHANGENOTIFIER_H_
+#define OWT_BASE_NETWORKCHANGENOTIFIER_H_
+#include <functional>
+#include <map>
+#include <mutex>
+namespace owt {
+namespace base {
+// Process-wide watcher for network interface changes on desktop
+// platforms, where WebRTC has no network monitor and a NIC change is
+// only discovered when ICE times out, tens of seconds later. Clients
+// register a callback and trigger an ICE restart from it, so sessions
+// fail over as soon as the OS reports the change.
+//
+// The platform watcher (address change notifications on Windows, a
+// netlink socket on Linux) runs on one background thread started with
+// the first callback. Callbacks run on that thread and must not block;
+// bursts of OS events are coalesced so a flapping interface does not
+// trigger a restart storm. On platforms without a watcher registration
+// succeeds and nothing ever fires.
+class NetworkChangeNotifier {
+ public:
+  using Callback = std::function<void()>;
+  /// The process-wide instance.
+  static NetworkChangeNotifier* Get();
+  /// Registers |callback| and returns an id for RemoveCallback.
+  int AddCallback(Callback callback);
+  /// Unregisters a callback. Blocks while the callback is running, so
+  /// after return the callback is never invoked again.
+  void RemoveCallback(int id);
+
+ private:
+  NetworkChangeNotifier();
+  void StartMonitorLocked();
+  void MonitorLoop();
+  void NotifyChange();
+  std::mutex mutex_;
+  std::map<int, Callback> callbacks_;
+  int next_id_;
+  bool monitor_started_;
+  int64_t last_notify_ms_;
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_NETWORKCHANGENOTIFIER_H_
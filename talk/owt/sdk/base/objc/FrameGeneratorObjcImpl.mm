@@ -1,6 +1,7 @@
 // Copyright (C) <2018> Intel Corporation
 //
 // SPDX-License-Identifier: Apache-2.0
+#import <cstring>
 #import <vector>
 #import "talk/owt/sdk/base/objc/FrameGeneratorObjcImpl.h"
 namespace owt {
@@ -27,6 +28,12 @@ int VideoFrameGeneratorObjcImpl::GetFps() {
 }
 VideoFrameGeneratorInterface::VideoFrameCodec
 VideoFrameGeneratorObjcImpl::GetType() {
+  // A generator that vends CVPixelBuffers is consumed by reference; the
+  // capturer never asks it for raw bytes.
+  if ([objc_generator_ respondsToSelector:@selector(nextPixelBuffer)]) {
+    return owt::base::VideoFrameGeneratorInterface::VideoFrameCodec::
+        CVPixelBufferHandle;
+  }
   return owt::base::VideoFrameGeneratorInterface::VideoFrameCodec::I420;
 }
 uint32_t VideoFrameGeneratorObjcImpl::GetNextFrameSize(){
@@ -40,6 +47,19 @@ uint32_t VideoFrameGeneratorObjcImpl::GetNextFrameSize(){
 uint32_t VideoFrameGeneratorObjcImpl::GenerateNextFrame(
     uint8_t* buffer,
     const uint32_t capacity) {
+  if ([objc_generator_ respondsToSelector:@selector(nextPixelBuffer)]) {
+    // Hand over the retained reference instead of pixel data; the
+    // capturer wraps it and releases it after encoding.
+    if (capacity < sizeof(CVPixelBufferRef)) {
+      return 0;
+    }
+    CVPixelBufferRef pixel_buffer = [objc_generator_ nextPixelBuffer];
+    if (pixel_buffer == nullptr) {
+      return 0;
+    }
+    memcpy(buffer, &pixel_buffer, sizeof(pixel_buffer));
+    return sizeof(pixel_buffer);
+  }
   return [objc_generator_ nextFrame:buffer capacity:capacity];
 }
 }
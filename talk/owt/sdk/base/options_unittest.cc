@@ -0,0 +1,58 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "talk/owt/sdk/include/cpp/owt/base/options.h"
+#include <utility>
+#include "talk/owt/sdk/include/cpp/owt/conference/subscribeoptions.h"
+#include "testing/gtest/include/gtest/gtest.h"
+namespace owt {
+namespace base {
+namespace {
+PublishOptions MakePublishOptions() {
+  PublishOptions options;
+  options.video.push_back(VideoEncodingParameters(
+      VideoCodecParameters(VideoCodec::kH264, "42e01f"), 2000, true));
+  options.audio.push_back(AudioEncodingParameters(
+      AudioCodecParameters(AudioCodec::kOpus, 2, 48000), 64));
+  return options;
+}
+}  // namespace
+TEST(OptionsCopyAuditTest, CopyIsCountedAndMoveIsNot) {
+  PublishOptions options = MakePublishOptions();
+  OptionsCopyAudit::Reset();
+  PublishOptions copied(options);
+#if !defined(NDEBUG)
+  EXPECT_EQ(OptionsCopyAudit::Count(), 1u);
+#else
+  EXPECT_EQ(OptionsCopyAudit::Count(), 0u);
+#endif
+  OptionsCopyAudit::Reset();
+  PublishOptions moved(std::move(options));
+  EXPECT_EQ(OptionsCopyAudit::Count(), 0u);
+  EXPECT_EQ(moved.video.size(), 1u);
+}
+TEST(OptionsCopyAuditTest, MoveTransfersEncodingVectors) {
+  PublishOptions options = MakePublishOptions();
+  const VideoEncodingParameters* video_data = options.video.data();
+  PublishOptions moved(std::move(options));
+  EXPECT_EQ(moved.video.data(), video_data);
+  EXPECT_TRUE(options.video.empty());
+}
+TEST(OptionsCopyAuditTest, SubscribeOptionsCopyIsCounted) {
+  owt::conference::SubscribeOptions options;
+  options.video.codecs.push_back(
+      VideoCodecParameters(VideoCodec::kVp8, ""));
+  OptionsCopyAudit::Reset();
+  owt::conference::SubscribeOptions copied(options);
+#if !defined(NDEBUG)
+  EXPECT_EQ(OptionsCopyAudit::Count(), 1u);
+#else
+  EXPECT_EQ(OptionsCopyAudit::Count(), 0u);
+#endif
+  OptionsCopyAudit::Reset();
+  owt::conference::SubscribeOptions moved(std::move(options));
+  EXPECT_EQ(OptionsCopyAudit::Count(), 0u);
+  EXPECT_EQ(moved.video.codecs.size(), 1u);
+}
+}  // namespace base
+}  // namespace owt
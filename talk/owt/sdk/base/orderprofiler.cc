@@ -0,0 +1,121 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "talk/owt/sdk/base/orderprofiler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#if !defined(WEBRTC_WIN)
+#include <dlfcn.h>
+#endif
+
+// Everything in this file runs inside the instrumentation callback and
+// must not itself be instrumented, or the first call would recurse.
+#if defined(__clang__) || defined(__GNUC__)
+#define OWT_NO_INSTRUMENT __attribute__((no_instrument_function))
+#else
+#define OWT_NO_INSTRUMENT
+#endif
+
+namespace owt {
+namespace base {
+namespace {
+// Upper bound on distinct functions the log holds; the SDK plus the
+// parts of webrtc a startup exercises fit comfortably. Later first
+// calls are dropped, which only truncates the tail of the orderfile.
+const size_t kMaxFunctions = 1 << 16;
+// Open-addressed set of already-seen entry addresses, sized at twice
+// the log so probing stays short. Insertion is a CAS; both the set and
+// the order log are append-only, so recording needs no locks.
+const size_t kSeenSlots = kMaxFunctions * 2;
+std::atomic<void*> g_seen[kSeenSlots];
+void* g_order[kMaxFunctions];
+std::atomic<size_t> g_count;
+
+OWT_NO_INSTRUMENT bool MarkSeen(void* fn) {
+  size_t slot = (reinterpret_cast<size_t>(fn) >> 4) % kSeenSlots;
+  for (size_t probes = 0; probes < kSeenSlots; probes++) {
+    void* current = g_seen[slot].load(std::memory_order_relaxed);
+    if (current == fn)
+      return false;
+    if (current == nullptr) {
+      void* expected = nullptr;
+      if (g_seen[slot].compare_exchange_strong(expected, fn,
+                                               std::memory_order_relaxed)) {
+        return true;
+      }
+      if (expected == fn)
+        return false;
+    }
+    slot = (slot + 1) % kSeenSlots;
+  }
+  return false;  // Set full; stop recording new functions.
+}
+
+OWT_NO_INSTRUMENT void DumpAtExit() {
+  const char* path = getenv("OWT_ORDER_PROFILE");
+  if (path != nullptr && path[0] != '\0') {
+    OrderProfiler::Dump(path);
+  }
+}
+
+// Registers the exit dump without requiring any call from the
+// application; Dump remains available for scoping by hand.
+struct ExitDumpRegistrar {
+  OWT_NO_INSTRUMENT ExitDumpRegistrar() { atexit(DumpAtExit); }
+};
+ExitDumpRegistrar g_exit_dump_registrar;
+}  // namespace
+
+bool OrderProfiler::Dump(const std::string& path) {
+#if defined(WEBRTC_WIN)
+  // Symbolization and ordered linking are wired up for lld; the MSVC
+  // toolchain would need /ORDER with decorated names instead.
+  (void)path;
+  return false;
+#else
+  FILE* file = fopen(path.c_str(), "w");
+  if (file == nullptr)
+    return false;
+  size_t count = g_count.load(std::memory_order_acquire);
+  if (count > kMaxFunctions)
+    count = kMaxFunctions;
+  for (size_t i = 0; i < count; i++) {
+    Dl_info info;
+    if (dladdr(g_order[i], &info) != 0 && info.dli_sname != nullptr) {
+      fprintf(file, "%s\n", info.dli_sname);
+    }
+  }
+  fclose(file);
+  return true;
+#endif
+}
+
+void OrderProfiler::Reset() {
+  // Racy resets tolerate concurrent recording; a function recorded while
+  // the set is being cleared is at worst logged twice, and the linker
+  // takes the first occurrence.
+  g_count.store(0, std::memory_order_relaxed);
+  for (size_t i = 0; i < kSeenSlots; i++) {
+    g_seen[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
+}  // namespace base
+}  // namespace owt
+
+extern "C" {
+OWT_NO_INSTRUMENT void __cyg_profile_func_enter(void* fn, void* caller);
+OWT_NO_INSTRUMENT void __cyg_profile_func_exit(void* fn, void* caller);
+
+void __cyg_profile_func_enter(void* fn, void* /*caller*/) {
+  using namespace owt::base;
+  if (!MarkSeen(fn))
+    return;
+  size_t index = g_count.fetch_add(1, std::memory_order_acq_rel);
+  if (index < kMaxFunctions) {
+    g_order[index] = fn;
+  }
+}
+
+void __cyg_profile_func_exit(void* /*fn*/, void* /*caller*/) {}
+}
@@ -0,0 +1,33 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_ORDERPROFILER_H_
+#define OWT_BASE_ORDERPROFILER_H_
+#include <string>
+// Startup code-order profiler, compiled in only for owt_order_profiling
+// builds (see talk/owt/BUILD.gn). The compiler instruments every SDK
+// function entry; the first call of each function appends its address
+// to a wait-free log, so the log holds the functions of the exercised
+// scenario in first-execution order. Dumping it after the startup path
+// (join plus first subscribe) yields a symbol ordering file that the
+// linker consumes through the owt_orderfile argument, clustering the
+// startup path at the front of the binary and cutting the cold-start
+// page faults of walking a large SDK image.
+namespace owt {
+namespace base {
+class OrderProfiler {
+ public:
+  // Writes the symbols recorded so far, one per line in first-call
+  // order, in the form lld's --symbol-ordering-file expects. Addresses
+  // that cannot be resolved to a symbol are skipped. Returns false when
+  // the file cannot be written. The profile also dumps automatically at
+  // process exit to the path in OWT_ORDER_PROFILE when that environment
+  // variable is set.
+  static bool Dump(const std::string& path);
+  // Clears the recorded order, e.g. to scope the profile to a phase
+  // that starts later than process launch.
+  static void Reset();
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_ORDERPROFILER_H_
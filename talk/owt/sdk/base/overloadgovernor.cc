@@ -0,0 +1,207 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "talk/owt/sdk/base/overloadgovernor.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "owt/base/globalconfiguration.h"
+#include "talk/owt/sdk/base/pipelinelatencytracer.h"
+#include "talk/owt/sdk/base/threadloadmonitor.h"
+#include "webrtc/rtc_base/logging.h"
+namespace owt {
+namespace base {
+namespace {
+struct GovernorState {
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::thread monitor;
+  bool running = false;
+  OverloadGovernorPolicy policy;
+  std::function<void(int level)> callback;
+  int overloaded_polls = 0;
+  int recovered_polls = 0;
+#if defined(WEBRTC_WIN)
+  // Preset in effect before the governor first stepped it down; restored
+  // when the governor leaves kLevelReducedQuality or stops.
+  HardwareEncoderPreset saved_preset = HardwareEncoderPreset::kQualityStreaming;
+#endif
+  std::atomic<int> level{OverloadGovernor::kLevelNormal};
+  std::atomic<int> divisor{1};
+};
+GovernorState* State() {
+  // Leaked on purpose; codec threads may read the level during shutdown.
+  static GovernorState* state = new GovernorState();
+  return state;
+}
+// Applies the side effects of moving from |old_level| to |new_level|.
+// Context: monitor thread, |mutex| held.
+void ApplyLevelLocked(GovernorState* state, int old_level, int new_level) {
+#if defined(WEBRTC_WIN)
+  if (old_level < OverloadGovernor::kLevelReducedQuality &&
+      new_level >= OverloadGovernor::kLevelReducedQuality) {
+    state->saved_preset = GlobalConfiguration::GetHardwareEncoderPreset();
+    GlobalConfiguration::SetHardwareEncoderPreset(
+        HardwareEncoderPreset::kUltraLowLatency);
+  } else if (old_level >= OverloadGovernor::kLevelReducedQuality &&
+             new_level < OverloadGovernor::kLevelReducedQuality) {
+    GlobalConfiguration::SetHardwareEncoderPreset(state->saved_preset);
+  }
+#endif
+  int divisor = 1;
+  if (new_level >= OverloadGovernor::kLevelShedPublications) {
+    divisor = 4;
+  } else if (new_level >= OverloadGovernor::kLevelReducedFramerate) {
+    divisor = 2;
+  }
+  state->divisor.store(divisor, std::memory_order_relaxed);
+  state->level.store(new_level, std::memory_order_relaxed);
+  RTC_LOG(LS_WARNING) << "Overload governor level " << old_level << " -> "
+                      << new_level << ", capture divisor " << divisor;
+}
+// One poll of the SDK instrumentation. Returns true when the process
+// looks overloaded under |policy|.
+bool SampleOverloaded(const OverloadGovernorPolicy& policy) {
+  int64_t encode_p99_ms = 0;
+  for (const PipelineStageReport& report :
+       PipelineLatencyTracer::GetReports()) {
+    if (report.sample_count == 0)
+      continue;
+    if (report.stage == "custom_encode" || report.stage == "hardware_encode") {
+      if (report.p99_latency_ms > encode_p99_ms)
+        encode_p99_ms = report.p99_latency_ms;
+    }
+  }
+  if (encode_p99_ms > policy.encode_p99_overload_ms)
+    return true;
+  for (const ThreadLoadEntry& entry : ThreadLoadMonitor::Snapshot()) {
+    if (entry.utilization > policy.thread_utilization_overload)
+      return true;
+  }
+  return false;
+}
+// Like SampleOverloaded but with the recovery bound, so the two
+// thresholds form the hysteresis band.
+bool SampleRecovered(const OverloadGovernorPolicy& policy) {
+  int64_t encode_p99_ms = 0;
+  for (const PipelineStageReport& report :
+       PipelineLatencyTracer::GetReports()) {
+    if (report.sample_count == 0)
+      continue;
+    if (report.stage == "custom_encode" || report.stage == "hardware_encode") {
+      if (report.p99_latency_ms > encode_p99_ms)
+        encode_p99_ms = report.p99_latency_ms;
+    }
+  }
+  if (encode_p99_ms >= policy.encode_p99_recover_ms)
+    return false;
+  for (const ThreadLoadEntry& entry : ThreadLoadMonitor::Snapshot()) {
+    if (entry.utilization > policy.thread_utilization_overload)
+      return false;
+  }
+  return true;
+}
+void MonitorLoop(GovernorState* state) {
+  std::unique_lock<std::mutex> lock(state->mutex);
+  while (state->running) {
+    OverloadGovernorPolicy policy = state->policy;
+    state->wake.wait_for(lock,
+                         std::chrono::milliseconds(policy.poll_interval_ms));
+    if (!state->running)
+      break;
+    bool overloaded;
+    bool recovered;
+    {
+      // Instrumentation reads take their own locks; do not hold ours.
+      lock.unlock();
+      overloaded = SampleOverloaded(policy);
+      recovered = !overloaded && SampleRecovered(policy);
+      lock.lock();
+      if (!state->running)
+        break;
+    }
+    int level = state->level.load(std::memory_order_relaxed);
+    if (overloaded) {
+      state->recovered_polls = 0;
+      if (++state->overloaded_polls >= policy.escalate_intervals &&
+          level < OverloadGovernor::kLevelShedPublications) {
+        state->overloaded_polls = 0;
+        ApplyLevelLocked(state, level, level + 1);
+        auto callback = state->callback;
+        // The callback runs unlocked so it may call back into the
+        // governor, e.g. Stop() from a shutdown path.
+        lock.unlock();
+        if (callback)
+          callback(level + 1);
+        lock.lock();
+      }
+    } else if (recovered) {
+      state->overloaded_polls = 0;
+      if (++state->recovered_polls >= policy.recover_intervals &&
+          level > OverloadGovernor::kLevelNormal) {
+        state->recovered_polls = 0;
+        ApplyLevelLocked(state, level, level - 1);
+        auto callback = state->callback;
+        lock.unlock();
+        if (callback)
+          callback(level - 1);
+        lock.lock();
+      }
+    } else {
+      // Inside the hysteresis band; hold the current level and both
+      // counters so a slow drift does not accumulate into a step.
+      state->overloaded_polls = 0;
+      state->recovered_polls = 0;
+    }
+  }
+}
+}  // namespace
+void OverloadGovernor::Start(const OverloadGovernorPolicy& policy,
+                             std::function<void(int level)> on_level_changed) {
+  GovernorState* state = State();
+  std::thread previous;
+  {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->policy = policy;
+    state->callback = std::move(on_level_changed);
+    if (state->running)
+      return;
+    previous = std::move(state->monitor);
+    state->running = true;
+    state->overloaded_polls = 0;
+    state->recovered_polls = 0;
+  }
+  if (previous.joinable())
+    previous.join();
+  std::lock_guard<std::mutex> lock(state->mutex);
+  state->monitor = std::thread([state] { MonitorLoop(state); });
+}
+void OverloadGovernor::Stop() {
+  GovernorState* state = State();
+  std::thread monitor;
+  {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    if (!state->running)
+      return;
+    state->running = false;
+    int level = state->level.load(std::memory_order_relaxed);
+    if (level != kLevelNormal) {
+      ApplyLevelLocked(state, level, kLevelNormal);
+    }
+    state->callback = nullptr;
+    monitor = std::move(state->monitor);
+    state->wake.notify_all();
+  }
+  if (monitor.joinable())
+    monitor.join();
+}
+int OverloadGovernor::CurrentLevel() {
+  return State()->level.load(std::memory_order_relaxed);
+}
+int OverloadGovernor::CaptureFrameDivisor() {
+  return State()->divisor.load(std::memory_order_relaxed);
+}
+}  // namespace base
+}  // namespace owt
@@ -0,0 +1,79 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_OVERLOADGOVERNOR_H_
+#define OWT_BASE_OVERLOADGOVERNOR_H_
+#include <functional>
+namespace owt {
+namespace base {
+// Thresholds and hysteresis for the overload governor. Escalation and
+// recovery are both counted in consecutive polls, so a single noisy
+// sample moves nothing; recovery is deliberately slower than
+// escalation to keep the governor from oscillating around a threshold.
+struct OverloadGovernorPolicy {
+  OverloadGovernorPolicy()
+      : poll_interval_ms(1000),
+        encode_p99_overload_ms(80),
+        encode_p99_recover_ms(40),
+        thread_utilization_overload(0.90),
+        escalate_intervals(3),
+        recover_intervals(10) {}
+  // Interval between polls of the pipeline instrumentation.
+  int poll_interval_ms;
+  // Escalate while p99 capture-to-encode latency exceeds this value.
+  int encode_p99_overload_ms;
+  // Recover while p99 capture-to-encode latency stays below this value.
+  int encode_p99_recover_ms;
+  // Escalate while any watched engine thread is busier than this
+  // fraction of a core, regardless of encode latency.
+  double thread_utilization_overload;
+  // Consecutive overloaded polls before stepping one level up.
+  int escalate_intervals;
+  // Consecutive recovered polls before stepping one level down.
+  int recover_intervals;
+};
+// Sheds encode load by policy when the process approaches saturation,
+// instead of letting frame latency collapse until external monitoring
+// reacts. The governor polls the SDK's own instrumentation - the
+// pipeline latency rings and the engine thread load monitor - and walks
+// a ladder of shedding levels with hysteresis. Each level keeps the
+// actions of the levels below it:
+//   kLevelNormal            nothing shed.
+//   kLevelReducedQuality    hardware encoder preset dropped to the
+//                           fastest one (applies to encoders created
+//                           from then on); restored on recovery.
+//   kLevelReducedFramerate  injected capture delivers every second
+//                           frame, halving generator-sourced encode
+//                           load without renegotiation.
+//   kLevelShedPublications  capture drops to every fourth frame and
+//                           the level callback asks the application to
+//                           suspend publications it can live without
+//                           (thumbnails); the SDK cannot pick those
+//                           itself.
+// The level callback fires on every level change, from the governor's
+// monitor thread.
+class OverloadGovernor {
+ public:
+  enum Level : int {
+    kLevelNormal = 0,
+    kLevelReducedQuality,
+    kLevelReducedFramerate,
+    kLevelShedPublications,
+  };
+  // Starts the governor's monitor thread. A second Start replaces the
+  // policy and callback. |on_level_changed| may be null.
+  static void Start(const OverloadGovernorPolicy& policy,
+                    std::function<void(int level)> on_level_changed);
+  // Stops monitoring, restores the encoder preset and returns capture
+  // pacing to normal.
+  static void Stop();
+  // Current shedding level; kLevelNormal when the governor is stopped.
+  static int CurrentLevel();
+  // Capture pacing divisor for the current level: the injected frame
+  // pump delivers every Nth frame. 1 at normal load. Read by
+  // CustomizedFramesCapturer's pacing thread each cycle.
+  static int CaptureFrameDivisor();
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_OVERLOADGOVERNOR_H_
@@ -5,13 +5,15 @@
 #include "webrtc/rtc_base/logging.h"
 #include "talk/owt/sdk/base/peerconnectionchannel.h"
 #include "talk/owt/sdk/base/sdputils.h"
+#include "talk/owt/sdk/base/tracelog.h"
+#include "talk/owt/sdk/include/cpp/owt/base/globalconfiguration.h"
 using namespace rtc;
 namespace owt {
 namespace base {
 PeerConnectionChannel::PeerConnectionChannel(
     PeerConnectionChannelConfiguration configuration)
     : pc_thread_(nullptr),
-      configuration_(configuration),
+      configuration_(std::move(configuration)),
       factory_(nullptr),
       peer_connection_(nullptr) {
 }
@@ -25,7 +27,7 @@ PeerConnectionChannel::~PeerConnectionChannel() {
 bool PeerConnectionChannel::InitializePeerConnection() {
   RTC_LOG(LS_INFO) << "Initialize PeerConnection.";
   if (factory_.get() == nullptr)
-    factory_ = PeerConnectionDependencyFactory::Get();
+    factory_ = PeerConnectionDependencyFactory::GetForNewChannel();
   offer_answer_options_ =
       webrtc::PeerConnectionInterface::RTCOfferAnswerOptions();
   offer_answer_options_.offer_to_receive_audio = true;
@@ -54,6 +56,15 @@ bool PeerConnectionChannel::InitializePeerConnection() {
 }
 void PeerConnectionChannel::ApplyBitrateSettings() {
   RTC_CHECK(peer_connection_);
+  // The connection-level cap feeds the send-side bandwidth allocator,
+  // which sets the pacer's budget; it is the per-connection handle this
+  // engine revision exposes over how fast bursts drain onto the wire.
+  if (configuration_.max_pacing_bitrate_bps > 0) {
+    webrtc::PeerConnectionInterface::BitrateParameters bitrate;
+    bitrate.max_bitrate_bps =
+        absl::optional<int>(configuration_.max_pacing_bitrate_bps);
+    peer_connection_->SetBitrate(bitrate);
+  }
   std::vector<rtc::scoped_refptr<webrtc::RtpSenderInterface>> senders =
       peer_connection_->GetSenders();
   if (senders.size() == 0) {
@@ -100,6 +111,9 @@ PeerConnectionInterface::SignalingState PeerConnectionChannel::SignalingState()
   return peer_connection_->signaling_state();
 }
 void PeerConnectionChannel::OnMessage(rtc::Message* msg) {
+  // Landing point of every operation posted across to |pc_thread_|;
+  // traced so queueing delay on the hop shows up between events.
+  OWT_TRACE_SCOPE("PeerConnectionChannel.OnMessage");
   RTC_CHECK(peer_connection_);
   if (peer_connection_->signaling_state() ==
       webrtc::PeerConnectionInterface::SignalingState::kClosed) {
@@ -139,9 +153,11 @@ void PeerConnectionChannel::OnMessage(rtc::Message* msg) {
       rtc::TypedMessageData<std::string>* param =
           static_cast<rtc::TypedMessageData<std::string>*>(msg->pdata);
       webrtc::DataChannelInit config;
-      data_channel_ =
+      ConfigureDataChannel(param->data(), &config);
+      rtc::scoped_refptr<webrtc::DataChannelInterface> data_channel =
           peer_connection_->CreateDataChannel(param->data(), &config);
-      data_channel_->RegisterObserver(this);
+      data_channel->RegisterObserver(this);
+      OnDataChannelCreated(param->data(), data_channel);
       RTC_LOG(LS_INFO) << "Created data channel.";
       delete param;
       break;
@@ -161,16 +177,30 @@ void PeerConnectionChannel::OnMessage(rtc::Message* msg) {
         audio_codecs.push_back(audio_enc_param.codec.name);
       }
       sdp_string = SdpUtils::SetPreferAudioCodecs(
-          sdp_string, audio_codecs);
+          sdp_string, audio_codecs, &negotiation_arena_);
+      if (GlobalConfiguration::GetInjectedAudioSilenceSuppressionEnabled()) {
+        // Silence-suppressed capture starves the encoder during quiet
+        // stretches; DTX tells the far end to expect the gaps.
+        sdp_string = SdpUtils::EnableOpusDtx(sdp_string, &negotiation_arena_);
+      }
       std::vector<VideoCodec> video_codecs;
       for (auto& video_enc_param : configuration_.video) {
         video_codecs.push_back(video_enc_param.codec.name);
       }
       sdp_string = SdpUtils::SetPreferVideoCodecs(
-          sdp_string, video_codecs);
+          sdp_string, video_codecs, &negotiation_arena_);
+      if (configuration_.simulcast_layer_count > 1 &&
+          desc->type() == webrtc::SessionDescriptionInterface::kOffer) {
+        sdp_string = SdpUtils::AddSimulcastLayers(
+            sdp_string, configuration_.simulcast_layer_count,
+            &negotiation_arena_);
+      }
       webrtc::SessionDescriptionInterface* new_desc(
           webrtc::CreateSessionDescription(desc->type(), sdp_string, nullptr));
       peer_connection_->SetLocalDescription(param->observer, new_desc);
+      // The munged SDP has been copied into |new_desc|; everything the
+      // chain above drew from the arena can go in one sweep.
+      negotiation_arena_.Reset();
       delete param;
       break;
     }
@@ -198,6 +228,24 @@ void PeerConnectionChannel::OnMessage(rtc::Message* msg) {
       delete param;
       break;
     }
+    case kMessageTypeBatchSetRemoteIceCandidates: {
+      // Applies a whole staged candidate set in one connection-thread
+      // hop instead of one message per candidate. The connection copies
+      // each candidate, so the batch owns and releases them here.
+      rtc::TypedMessageData<std::vector<webrtc::IceCandidateInterface*>*>*
+          param = static_cast<rtc::TypedMessageData<
+              std::vector<webrtc::IceCandidateInterface*>*>*>(msg->pdata);
+      std::vector<webrtc::IceCandidateInterface*>* candidates = param->data();
+      for (webrtc::IceCandidateInterface* candidate : *candidates) {
+        if (!peer_connection_->AddIceCandidate(candidate)) {
+          RTC_LOG(LS_WARNING) << "Failed to apply a staged remote candidate.";
+        }
+        delete candidate;
+      }
+      delete candidates;
+      delete param;
+      break;
+    }
     case kMessageTypeAddStream: {
       rtc::ScopedRefMessageData<MediaStreamInterface>* param =
           static_cast<rtc::ScopedRefMessageData<MediaStreamInterface>*>(
@@ -308,6 +356,10 @@ void PeerConnectionChannel::OnNetworksChanged(){
   RTC_LOG(LS_INFO) << "PeerConnectionChannel::OnNetworksChanged.";
 }
 PeerConnectionChannelConfiguration::PeerConnectionChannelConfiguration()
-    : RTCConfiguration() {}
+    : RTCConfiguration(),
+      simulcast_layer_count(1),
+      intra_refresh(false),
+      max_pacing_bitrate_bps(0),
+      bandwidth_priority(1) {}
 }
 }
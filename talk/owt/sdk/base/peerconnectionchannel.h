@@ -8,6 +8,7 @@
 #include "webrtc/rtc_base/third_party/sigslot/sigslot.h"
 #include "talk/owt/sdk/base/peerconnectiondependencyfactory.h"
 #include "talk/owt/sdk/base/mediaconstraintsimpl.h"
+#include "talk/owt/sdk/base/scopedarena.h"
 #include "talk/owt/sdk/base/functionalobserver.h"
 #include "talk/owt/sdk/include/cpp/owt/base/commontypes.h"
 namespace rtc {
@@ -53,6 +54,19 @@ struct PeerConnectionChannelConfiguration
   explicit PeerConnectionChannelConfiguration();
   std::vector<VideoEncodingParameters> video;
   std::vector<AudioEncodingParameters> audio;
+  /// Number of simulcast send layers offered for video; 1 disables
+  /// simulcast munging.
+  int simulcast_layer_count;
+  /// The publication asked for gradual decoder refresh instead of
+  /// periodic IDR frames (PublishOptions::intra_refresh).
+  bool intra_refresh;
+  /// Cap on the connection's total send rate in bits per second
+  /// (PublishOptions::max_pacing_bitrate_bps); zero keeps the engine
+  /// default.
+  int max_pacing_bitrate_bps;
+  /// Relative weight used when the client splits the uplink estimate
+  /// between concurrent publications (PublishOptions::bandwidth_priority).
+  int bandwidth_priority;
   /// Indicate whether this PeerConnection is used for sending encoded frame.
   bool encoded_video_frame_;
 };
@@ -100,6 +114,19 @@ class PeerConnectionChannel : public rtc::MessageHandler,
   // conflict.
   virtual void OnDataChannelStateChange(){};
   virtual void OnDataChannelMessage(const webrtc::DataBuffer& buffer){};
+  virtual void OnDataChannelBufferedAmountChange(uint64_t previous_amount){};
+  // Called before a data channel is created so subclasses can adjust
+  // |config| (e.g. reliability) for the given label.
+  virtual void ConfigureDataChannel(const std::string& label,
+                                    webrtc::DataChannelInit* config){};
+  // Called after a data channel is created locally. The default keeps the
+  // single-channel behavior; subclasses managing several channels can
+  // route by label.
+  virtual void OnDataChannelCreated(
+      const std::string& label,
+      rtc::scoped_refptr<webrtc::DataChannelInterface> data_channel) {
+    data_channel_ = data_channel;
+  }
   // CreateSessionDescriptionObserver
   virtual void OnCreateSessionDescriptionSuccess(
       webrtc::SessionDescriptionInterface* desc);
@@ -118,6 +145,7 @@ class PeerConnectionChannel : public rtc::MessageHandler,
     kMessageTypeSetLocalDescription,
     kMessageTypeSetRemoteDescription,
     kMessageTypeSetRemoteIceCandidate,
+    kMessageTypeBatchSetRemoteIceCandidates,
     kMessageTypeAddStream,
     kMessageTypeRemoveStream,
     kMessageTypeClosePeerConnection,
@@ -132,12 +160,19 @@ class PeerConnectionChannel : public rtc::MessageHandler,
   rtc::scoped_refptr<webrtc::DataChannelInterface> data_channel_;
   MediaConstraintsImpl media_constraints_;
   webrtc::PeerConnectionInterface::RTCOfferAnswerOptions offer_answer_options_;
+  // Backs the transient strings of the SDP munging chain in one
+  // negotiation step; reset wholesale once the munged description is
+  // handed to the PeerConnection. Only touched on |pc_thread_|.
+  ScopedArena negotiation_arena_;
  private:
   // DataChannelObserver
   virtual void OnStateChange() override { OnDataChannelStateChange(); }
   virtual void OnMessage(const webrtc::DataBuffer& buffer) override {
     OnDataChannelMessage(buffer);
   };
+  virtual void OnBufferedAmountChange(uint64_t previous_amount) override {
+    OnDataChannelBufferedAmountChange(previous_amount);
+  };
   // |factory_| is got from PeerConnectionDependencyFactory::Get() which is
   // shared among all PeerConnectionChannels.
   rtc::scoped_refptr<PeerConnectionDependencyFactory> factory_;
@@ -2,9 +2,12 @@
 //
 // SPDX-License-Identifier: Apache-2.0
 #include <iostream>
+#if !defined(OWT_RECEIVE_ONLY)
 #include "talk/owt/sdk/base/customizedaudiodevicemodule.h"
 #include "talk/owt/sdk/base/encodedvideoencoderfactory.h"
+#endif
 #include "talk/owt/sdk/base/peerconnectiondependencyfactory.h"
+#include "talk/owt/sdk/base/threadloadmonitor.h"
 #include "webrtc/api/audio_codecs/builtin_audio_decoder_factory.h"
 #include "webrtc/api/audio_codecs/builtin_audio_encoder_factory.h"
 #include "webrtc/rtc_base/bind.h"
@@ -17,7 +20,10 @@
 #include "webrtc/system_wrappers/include/field_trial_default.h"
 #if defined(WEBRTC_WIN)
 #include "talk/owt/sdk/base/win/msdkvideodecoderfactory.h"
+#if !defined(OWT_RECEIVE_ONLY)
 #include "talk/owt/sdk/base/win/msdkvideoencoderfactory.h"
+#endif
+#include "talk/owt/sdk/base/win/threadaffinity.h"
 #elif defined(WEBRTC_IOS)
 #include "talk/owt/sdk/base/ios/networkmonitorios.h"
 #include "talk/owt/sdk/base/objc/ObjcVideoCodecFactory.h"
@@ -40,6 +46,9 @@ PeerConnectionThread::~PeerConnectionThread() {
 }
 rtc::scoped_refptr<PeerConnectionDependencyFactory>
     PeerConnectionDependencyFactory::dependency_factory_;
+std::vector<rtc::scoped_refptr<PeerConnectionDependencyFactory>>
+    PeerConnectionDependencyFactory::factory_pool_;
+size_t PeerConnectionDependencyFactory::next_factory_index_ = 0;
 std::mutex PeerConnectionDependencyFactory::get_pc_dependency_factory_mutex_;
 PeerConnectionDependencyFactory::PeerConnectionDependencyFactory()
     : pc_thread_(new PeerConnectionThread),
@@ -79,6 +88,35 @@ PeerConnectionDependencyFactory* PeerConnectionDependencyFactory::Get() {
   }
   return dependency_factory_.get();
 }
+PeerConnectionDependencyFactory*
+PeerConnectionDependencyFactory::GetForNewChannel() {
+  int count = GlobalConfiguration::GetPeerConnectionFactoryCount();
+  if (count <= 1) {
+    return Get();
+  }
+  std::lock_guard<std::mutex> lock(get_pc_dependency_factory_mutex_);
+  if (!dependency_factory_.get()) {
+    dependency_factory_ =
+        new rtc::RefCountedObject<PeerConnectionDependencyFactory>();
+    dependency_factory_->CreatePeerConnectionFactory();
+  }
+  if (factory_pool_.empty()) {
+    // |dependency_factory_| serves both as pool member zero and as the
+    // instance Get() hands to local stream creation, so capture sources
+    // keep working with a pool configured.
+    factory_pool_.push_back(dependency_factory_);
+    for (int i = 1; i < count; i++) {
+      rtc::scoped_refptr<PeerConnectionDependencyFactory> factory =
+          new rtc::RefCountedObject<PeerConnectionDependencyFactory>();
+      factory->CreatePeerConnectionFactory();
+      factory_pool_.push_back(factory);
+    }
+  }
+  PeerConnectionDependencyFactory* factory =
+      factory_pool_[next_factory_index_ % factory_pool_.size()].get();
+  next_factory_index_++;
+  return factory;
+}
 const scoped_refptr<PeerConnectionFactoryInterface>&
 PeerConnectionDependencyFactory::GetPeerConnectionFactory() {
   if (!pc_factory_.get())
@@ -108,6 +146,22 @@ void PeerConnectionDependencyFactory::
   RTC_CHECK(worker_thread->Start() && signaling_thread->Start() &&
             network_thread->Start())
       << "Failed to start threads";
+  // The trio is otherwise invisible in production; load probes tie API
+  // latency spikes to the thread that is saturated.
+  ThreadLoadMonitor::Watch(signaling_thread, "signaling_thread");
+  ThreadLoadMonitor::Watch(worker_thread, "worker_thread");
+  ThreadLoadMonitor::Watch(network_thread, "network_thread");
+#if defined(WEBRTC_WIN)
+  // The worker thread runs the media pipeline between capture and the
+  // codecs, so it follows the codec placement policy. Signaling and
+  // network threads touch little frame data and are left unpinned.
+  uint64_t affinity_mask = GlobalConfiguration::GetCodecThreadAffinityMask();
+  if (affinity_mask != 0) {
+    worker_thread->Invoke<void>(RTC_FROM_HERE, [affinity_mask] {
+      ApplyThreadAffinityMask(affinity_mask);
+    });
+  }
+#endif
 #if defined(WEBRTC_IOS)
   // Use webrtc::VideoEn(De)coderFactory on iOS.
   std::unique_ptr<VideoEncoderFactory> encoder_factory;
@@ -119,9 +173,11 @@ void PeerConnectionDependencyFactory::
   std::unique_ptr<cricket::WebRtcVideoDecoderFactory> decoder_factory;
 #if defined(WEBRTC_WIN)
   if (render_hardware_acceleration_enabled_) {
+#if !defined(OWT_RECEIVE_ONLY)
     if (!encoded_frame_) {
       encoder_factory.reset(new MSDKVideoEncoderFactory());
     }
+#endif
     if (!GlobalConfiguration::GetCustomizedVideoDecoderEnabled()) {
       decoder_factory.reset(new MSDKVideoDecoderFactory());
     }
@@ -131,10 +187,12 @@ void PeerConnectionDependencyFactory::
     decoder_factory.reset(new CustomizedVideoDecoderFactory(
         GlobalConfiguration::GetCustomizedVideoDecoder()));
   }
+#if !defined(OWT_RECEIVE_ONLY)
   // Encoded video frame enabled
   if (encoded_frame_) {
     encoder_factory.reset(new EncodedVideoEncoderFactory());
   }
+#endif
 #else
 #error "Unsupported platform."
 #endif
@@ -142,6 +200,7 @@ void PeerConnectionDependencyFactory::
   // if adm is nullptr, voe_base will initilize it with the default internal
   // adm.
   rtc::scoped_refptr<AudioDeviceModule> adm;
+#if !defined(OWT_RECEIVE_ONLY)
   if (GlobalConfiguration::GetCustomizedAudioInputEnabled()) {
     // Create ADM on worker thred as RegisterAudioCallback is invoked there.
     adm = worker_thread->Invoke<rtc::scoped_refptr<AudioDeviceModule>>(
@@ -150,6 +209,7 @@ void PeerConnectionDependencyFactory::
                     CreateCustomizedAudioDeviceModuleOnCurrentThread,
                     this));
   }
+#endif
 #if defined(WEBRTC_IOS)
   pc_factory_ = webrtc::CreatePeerConnectionFactory(
       network_thread, worker_thread, signaling_thread, adm,
@@ -227,6 +287,16 @@ PeerConnectionDependencyFactory::CreateLocalAudioTrack(const std::string& id) {
   aec_enabled = GlobalConfiguration::GetAECEnabled();
   agc_enabled = GlobalConfiguration::GetAGCEnabled();
   ns_enabled = GlobalConfiguration::GetNSEnabled();
+  // Generator-sourced audio is machine generated; when bypass is requested
+  // it skips audio processing entirely instead of paying AEC/AGC/NS cost.
+  bool processing_bypassed =
+      GlobalConfiguration::GetCustomizedAudioInputEnabled() &&
+      GlobalConfiguration::GetAudioProcessingBypassedForCustomizedInput();
+  if (processing_bypassed) {
+    aec_enabled = false;
+    agc_enabled = false;
+    ns_enabled = false;
+  }
   if (!aec_enabled || !agc_enabled || !ns_enabled) {
     cricket::AudioOptions options;
     options.echo_cancellation = absl::optional<bool>(aec_enabled ? true : false);
@@ -234,6 +304,12 @@ PeerConnectionDependencyFactory::CreateLocalAudioTrack(const std::string& id) {
     options.noise_suppression = absl::optional<bool>(ns_enabled ? true : false);
     options.residual_echo_detector =
         absl::optional<bool>(aec_enabled ? true : false);
+    if (processing_bypassed) {
+      options.highpass_filter = absl::optional<bool>(false);
+      options.typing_detection = absl::optional<bool>(false);
+      options.experimental_agc = absl::optional<bool>(false);
+      options.experimental_ns = absl::optional<bool>(false);
+    }
     scoped_refptr<webrtc::AudioSourceInterface> audio_source =
         CreateAudioSource(options);
     return pc_thread_
@@ -298,10 +374,12 @@ void PeerConnectionDependencyFactory::CreateNetworkMonitorOnCurrentThread() {
   }
 #endif
 }
+#if !defined(OWT_RECEIVE_ONLY)
 scoped_refptr<webrtc::AudioDeviceModule>
 PeerConnectionDependencyFactory::CreateCustomizedAudioDeviceModuleOnCurrentThread() {
   return CustomizedAudioDeviceModule::Create(
      GlobalConfiguration::GetAudioFrameGenerator());
 }
+#endif
 }
 }
@@ -4,6 +4,7 @@
 #ifndef OWT_BASE_PEERCONNECTIONDEPENDENCYFACTORY_H_
 #define OWT_BASE_PEERCONNECTIONDEPENDENCYFACTORY_H_
 #include <mutex>
+#include <vector>
 #include "webrtc/api/peerconnectioninterface.h"
 #include "webrtc/api/mediastreaminterface.h"
 #include "webrtc/rtc_base/bind.h"
@@ -33,6 +34,11 @@ class PeerConnectionDependencyFactory : public rtc::RefCountInterface {
   // Get a PeerConnectionDependencyFactory instance. It doesn't create a new
   // instance. It always return the same instance.
   static PeerConnectionDependencyFactory* Get();
+  // Get the factory instance a new channel should use. When
+  // GlobalConfiguration::SetPeerConnectionFactoryCount is above one, this
+  // returns pool members round-robin so channels spread across several sets
+  // of WebRTC worker threads; otherwise it behaves like Get().
+  static PeerConnectionDependencyFactory* GetForNewChannel();
   rtc::scoped_refptr<webrtc::PeerConnectionInterface> CreatePeerConnection(
       const webrtc::PeerConnectionInterface::RTCConfiguration& config,
       webrtc::PeerConnectionObserver* observer);
@@ -71,10 +77,17 @@ class PeerConnectionDependencyFactory : public rtc::RefCountInterface {
       const webrtc::PeerConnectionInterface::RTCConfiguration& config,
       webrtc::PeerConnectionObserver* observer);
   void CreateNetworkMonitorOnCurrentThread();
+#if !defined(OWT_RECEIVE_ONLY)
   rtc::scoped_refptr<webrtc::AudioDeviceModule> CreateCustomizedAudioDeviceModuleOnCurrentThread();
+#endif
   scoped_refptr<PeerConnectionFactoryInterface> pc_factory_;
   static scoped_refptr<PeerConnectionDependencyFactory>
       dependency_factory_;  // Get() always return this instance.
+  // Additional factory instances when a pool is configured. Guarded by
+  // |get_pc_dependency_factory_mutex_|, as is |next_factory_index_|.
+  static std::vector<scoped_refptr<PeerConnectionDependencyFactory>>
+      factory_pool_;
+  static size_t next_factory_index_;
   Thread*
       pc_thread_;  // This thread performs all operations on pcfactory and pc.
   Thread* callback_thread_;  // This thread performs all callbacks.
@@ -0,0 +1,49 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include <algorithm>
+#include "webrtc/rtc_base/atomicops.h"
+#include "talk/owt/sdk/base/pipelinelatencytracer.h"
+namespace owt {
+namespace base {
+// Samples kept per stage. Power of two so the ring index is a mask.
+static const int kRingSize = 1024;
+static const char* const kStageNames[PipelineLatencyTracer::kStageCount] = {
+    "capture", "custom_encode", "hardware_encode", "render"};
+struct StageRing {
+  volatile int write_count;
+  int64_t samples[kRingSize];
+};
+static StageRing g_stage_rings[PipelineLatencyTracer::kStageCount];
+void PipelineLatencyTracer::Record(Stage stage, int64_t latency_ms) {
+  if (stage < 0 || stage >= kStageCount)
+    return;
+  StageRing& ring = g_stage_rings[stage];
+  // The increment reserves a slot; the store itself is unsynchronized and a
+  // reader may observe a torn or stale sample, which only perturbs the
+  // percentiles by one sample.
+  int index = rtc::AtomicOps::Increment(&ring.write_count) - 1;
+  ring.samples[index & (kRingSize - 1)] = latency_ms;
+}
+std::vector<PipelineStageReport> PipelineLatencyTracer::GetReports() {
+  std::vector<PipelineStageReport> reports;
+  for (int stage = 0; stage < kStageCount; stage++) {
+    StageRing& ring = g_stage_rings[stage];
+    int count = rtc::AtomicOps::AcquireLoad(&ring.write_count);
+    int valid = std::min(count, kRingSize);
+    if (valid == 0)
+      continue;
+    std::vector<int64_t> snapshot(ring.samples, ring.samples + valid);
+    std::sort(snapshot.begin(), snapshot.end());
+    int64_t p50 = snapshot[valid / 2];
+    int64_t p99 = snapshot[std::min(valid - 1, valid * 99 / 100)];
+    reports.push_back(
+        PipelineStageReport(kStageNames[stage], p50, p99, count));
+  }
+  return reports;
+}
+std::vector<PipelineStageReport> PipelineLatencyStats::GetStageReports() {
+  return PipelineLatencyTracer::GetReports();
+}
+}  // namespace base
+}  // namespace owt
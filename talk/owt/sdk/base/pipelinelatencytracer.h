@@ -0,0 +1,38 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_PIPELINELATENCYTRACER_H_
+#define OWT_BASE_PIPELINELATENCYTRACER_H_
+#include <stdint.h>
+#include <vector>
+#include "owt/base/connectionstats.h"
+namespace owt {
+namespace base {
+// Collects per-stage latency samples from the media pipeline into
+// fixed-size lock-free ring buffers. Recording is a single atomic
+// increment plus an array store, cheap enough to stay enabled in
+// production; percentiles are computed only when a report is requested
+// through PipelineLatencyStats in the public API.
+class PipelineLatencyTracer {
+ public:
+  enum Stage : int {
+    // Time spent generating or converting one captured frame.
+    kCapture = 0,
+    // Capture-to-encode delay seen by the customized encoder proxy.
+    kCustomEncode,
+    // Capture-to-encode delay seen by the hardware encoder.
+    kHardwareEncode,
+    // Capture-to-render delay seen by the local renderer sink.
+    kRender,
+    kStageCount,
+  };
+  // Records one latency sample for |stage|. Safe to call from any thread;
+  // samples may be dropped under concurrent writes to the same stage, which
+  // is acceptable for percentile reporting.
+  static void Record(Stage stage, int64_t latency_ms);
+  // Builds p50/p99 reports over the samples currently held in each ring.
+  static std::vector<PipelineStageReport> GetReports();
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_PIPELINELATENCYTRACER_H_
@@ -0,0 +1,82 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include <map>
+#include <mutex>
+#include "talk/owt/sdk/base/queuedepthgauges.h"
+namespace owt {
+namespace base {
+namespace {
+struct Gauge {
+  Gauge() : depth(0), high_watermark(0), above_threshold(false) {}
+  int depth;
+  int high_watermark;
+  // Arms the threshold callback: it fires on the upward crossing only and
+  // re-arms when the gauge drains below the threshold.
+  bool above_threshold;
+};
+struct Registry {
+  Registry() : threshold(0) {}
+  std::mutex mutex;
+  // Ordered so snapshots list gauges deterministically.
+  std::map<std::string, Gauge> gauges;
+  int threshold;
+  QueueDepthGauges::ThresholdCallback callback;
+};
+Registry& GetRegistry() {
+  // Leaked on purpose; reporting sites may run during static destruction
+  // of other objects.
+  static Registry* registry = new Registry();
+  return *registry;
+}
+}  // namespace
+void QueueDepthGauges::Set(const std::string& gauge, int depth) {
+  Registry& registry = GetRegistry();
+  ThresholdCallback crossed;
+  {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    Gauge& entry = registry.gauges[gauge];
+    entry.depth = depth;
+    if (depth > entry.high_watermark) {
+      entry.high_watermark = depth;
+    }
+    if (registry.callback && registry.threshold > 0) {
+      if (depth >= registry.threshold && !entry.above_threshold) {
+        entry.above_threshold = true;
+        crossed = registry.callback;
+      } else if (depth < registry.threshold) {
+        entry.above_threshold = false;
+      }
+    }
+  }
+  // Invoked outside the lock so the callback may call Snapshot().
+  if (crossed) {
+    crossed(gauge, depth);
+  }
+}
+std::vector<QueueDepthEntry> QueueDepthGauges::Snapshot() {
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  std::vector<QueueDepthEntry> entries;
+  entries.reserve(registry.gauges.size());
+  for (const auto& gauge : registry.gauges) {
+    QueueDepthEntry entry;
+    entry.gauge = gauge.first;
+    entry.depth = gauge.second.depth;
+    entry.high_watermark = gauge.second.high_watermark;
+    entries.push_back(entry);
+  }
+  return entries;
+}
+void QueueDepthGauges::SetThresholdCallback(int depth,
+                                            ThresholdCallback callback) {
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.threshold = depth;
+  registry.callback = std::move(callback);
+  for (auto& gauge : registry.gauges) {
+    gauge.second.above_threshold = false;
+  }
+}
+}  // namespace base
+}  // namespace owt
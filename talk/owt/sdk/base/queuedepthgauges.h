@@ -0,0 +1,34 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_QUEUEDEPTHGAUGES_H_
+#define OWT_BASE_QUEUEDEPTHGAUGES_H_
+#include <functional>
+#include <string>
+#include <vector>
+#include "talk/owt/sdk/include/cpp/owt/base/queuestats.h"
+namespace owt {
+namespace base {
+// Process-wide registry of pipeline queue depths. Producing and consuming
+// sites report the depth after each transition; clients pull a snapshot
+// through GetQueueDepthStats so growing latency can be localized to the
+// stage whose queue is backing up (codec surface pools, the renderer
+// mailbox, the capturer's frame pool) without attaching a profiler. An
+// optional callback fires when any gauge reaches a configured depth from
+// below, re-arming once the gauge drains under it again.
+class QueueDepthGauges {
+ public:
+  using ThresholdCallback =
+      std::function<void(const std::string& gauge, int depth)>;
+  // Reports the current depth of |gauge|, creating it on first use.
+  static void Set(const std::string& gauge, int depth);
+  // Returns current depth and high watermark for all gauges.
+  static std::vector<QueueDepthEntry> Snapshot();
+  // Fires |callback| whenever a gauge reaches |depth| from below. The
+  // callback runs on the reporting media thread and must not block; pass
+  // a null callback to disable.
+  static void SetThresholdCallback(int depth, ThresholdCallback callback);
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_QUEUEDEPTHGAUGES_H_
@@ -0,0 +1,30 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include <mutex>
+#include "talk/owt/sdk/base/roihint.h"
+namespace owt {
+namespace base {
+namespace {
+std::mutex g_region_mutex;
+RoiHint::Region g_region;
+bool g_region_set = false;
+}  // namespace
+void RoiHint::Set(const Region& region) {
+  std::lock_guard<std::mutex> lock(g_region_mutex);
+  g_region = region;
+  g_region_set = true;
+}
+void RoiHint::Clear() {
+  std::lock_guard<std::mutex> lock(g_region_mutex);
+  g_region_set = false;
+}
+bool RoiHint::Get(Region* region) {
+  std::lock_guard<std::mutex> lock(g_region_mutex);
+  if (!g_region_set)
+    return false;
+  *region = g_region;
+  return true;
+}
+}  // namespace base
+}  // namespace owt
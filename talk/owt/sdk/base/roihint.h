@@ -0,0 +1,36 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_ROIHINT_H_
+#define OWT_BASE_ROIHINT_H_
+// Region-of-interest hint handed from the application to the video
+// encoder (LocalStream::SetRegionOfInterest). Applications such as
+// shared whiteboards know which screen region is changing; the hardware
+// encoder attaches the region to every submitted frame so bits
+// concentrate where change happens. Hardware encoders are created by
+// codec factories without stream identity, so the hint is process-wide:
+// the encoder reads the current region at submission time rather than
+// receiving it attached to an individual frame.
+namespace owt {
+namespace base {
+class RoiHint {
+ public:
+  struct Region {
+    // Pixel bounds within the captured frame; the encoder clamps them
+    // to the coded picture and aligns them to its block grid.
+    int left;
+    int top;
+    int right;
+    int bottom;
+    // QP delta applied inside the region; negative values spend more
+    // bits there at the cost of the rest of the picture.
+    int quality_delta;
+  };
+  static void Set(const Region& region);
+  static void Clear();
+  // Copies the current hint into |region|; false when none is set.
+  static bool Get(Region* region);
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_ROIHINT_H_
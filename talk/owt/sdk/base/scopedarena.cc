@@ -0,0 +1,64 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include <new>
+#include "talk/owt/sdk/base/scopedarena.h"
+namespace owt {
+namespace base {
+namespace {
+// Covers a typical SDP (a few KB) plus its split line table without
+// growing; an oversized negotiation just chains extra blocks.
+const size_t kBlockBytes = 16 * 1024;
+const size_t kAlignment = sizeof(void*) * 2;
+size_t AlignUp(size_t bytes) {
+  return (bytes + kAlignment - 1) & ~(kAlignment - 1);
+}
+}  // namespace
+ScopedArena::ScopedArena() : current_used_(0), bytes_used_(0) {
+  head_ = current_ = NewBlock(kBlockBytes);
+}
+ScopedArena::~ScopedArena() {
+  Block* block = head_;
+  while (block != nullptr) {
+    Block* next = block->next;
+    ::operator delete(block);
+    block = next;
+  }
+}
+ScopedArena::Block* ScopedArena::NewBlock(size_t capacity) {
+  Block* block =
+      static_cast<Block*>(::operator new(sizeof(Block) + capacity));
+  block->next = nullptr;
+  block->capacity = capacity;
+  return block;
+}
+void* ScopedArena::Allocate(size_t bytes) {
+  size_t size = AlignUp(bytes);
+  if (current_used_ + size > current_->capacity) {
+    if (current_->next == nullptr || current_->next->capacity < size) {
+      Block* block = NewBlock(size > kBlockBytes ? size : kBlockBytes);
+      block->next = current_->next;
+      current_->next = block;
+    }
+    current_ = current_->next;
+    current_used_ = 0;
+  }
+  char* data = reinterpret_cast<char*>(current_ + 1) + current_used_;
+  current_used_ += size;
+  bytes_used_ += size;
+  return data;
+}
+void ScopedArena::Reset() {
+  Block* overflow = head_->next;
+  while (overflow != nullptr) {
+    Block* next = overflow->next;
+    ::operator delete(overflow);
+    overflow = next;
+  }
+  head_->next = nullptr;
+  current_ = head_;
+  current_used_ = 0;
+  bytes_used_ = 0;
+}
+}  // namespace base
+}  // namespace owt
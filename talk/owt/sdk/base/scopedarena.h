@@ -0,0 +1,91 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_SCOPEDARENA_H_
+#define OWT_BASE_SCOPEDARENA_H_
+#include <cstddef>
+#include <string>
+#include <vector>
+namespace owt {
+namespace base {
+// Bump allocator for the transient objects of one negotiation step. The
+// SDP munging chain makes hundreds of short-lived line and attribute
+// copies per offer/answer; drawing them from one arena turns that churn
+// into pointer bumps released wholesale when the step settles. Not
+// thread safe; an arena belongs to the thread running the negotiation.
+class ScopedArena {
+ public:
+  ScopedArena();
+  ~ScopedArena();
+  // Returns |bytes| of uninitialized storage aligned for any scalar type.
+  void* Allocate(size_t bytes);
+  // Releases everything allocated since construction or the last Reset.
+  // The first block is kept so the next negotiation starts warm; blocks
+  // grown for an unusually large SDP are returned to the heap.
+  void Reset();
+  // Bytes handed out since construction or the last Reset.
+  size_t bytes_used() const { return bytes_used_; }
+
+ private:
+  struct Block {
+    Block* next;
+    size_t capacity;
+    // Block data follows this header.
+  };
+  static Block* NewBlock(size_t capacity);
+  Block* head_;
+  Block* current_;
+  size_t current_used_;
+  size_t bytes_used_;
+};
+// STL-compatible allocator over a ScopedArena. Deallocation is a no-op;
+// memory returns on ScopedArena::Reset. A default-constructed instance,
+// which container operations may create, falls back to the heap.
+template <typename T>
+class ArenaAllocator {
+ public:
+  typedef T value_type;
+  typedef T* pointer;
+  typedef const T* const_pointer;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  template <typename U>
+  struct rebind {
+    typedef ArenaAllocator<U> other;
+  };
+  ArenaAllocator() : arena_(nullptr) {}
+  explicit ArenaAllocator(ScopedArena* arena) : arena_(arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena()) {}
+  T* allocate(size_t n) {
+    if (arena_ != nullptr)
+      return static_cast<T*>(arena_->Allocate(n * sizeof(T)));
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+  void deallocate(T* p, size_t) {
+    if (arena_ == nullptr)
+      ::operator delete(p);
+  }
+  ScopedArena* arena() const { return arena_; }
+
+ private:
+  ScopedArena* arena_;
+};
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+  return a.arena() == b.arena();
+}
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+  return a.arena() != b.arena();
+}
+// Arena-backed containers used by the SDP munging chain.
+typedef std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>
+    ArenaString;
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_SCOPEDARENA_H_
@@ -0,0 +1,55 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "talk/owt/sdk/base/scopedarena.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/gmock/include/gmock/gmock.h"
+namespace owt {
+namespace base {
+TEST(ScopedArenaTest, AllocationsComeFromTheArena) {
+  ScopedArena arena;
+  void* first = arena.Allocate(100);
+  void* second = arena.Allocate(100);
+  EXPECT_NE(first, nullptr);
+  EXPECT_NE(second, nullptr);
+  EXPECT_NE(first, second);
+  EXPECT_GE(arena.bytes_used(), 200u);
+}
+TEST(ScopedArenaTest, ResetRewindsAndReusesTheFirstBlock) {
+  ScopedArena arena;
+  void* first = arena.Allocate(64);
+  arena.Reset();
+  EXPECT_EQ(arena.bytes_used(), 0u);
+  EXPECT_EQ(arena.Allocate(64), first);
+}
+TEST(ScopedArenaTest, GrowsPastTheFirstBlock) {
+  ScopedArena arena;
+  // Larger than one block, so the arena must chain.
+  for (int i = 0; i < 64; i++) {
+    EXPECT_NE(arena.Allocate(1024), nullptr);
+  }
+  arena.Reset();
+  EXPECT_EQ(arena.bytes_used(), 0u);
+}
+TEST(ScopedArenaTest, OversizedAllocationGetsItsOwnBlock) {
+  ScopedArena arena;
+  EXPECT_NE(arena.Allocate(128 * 1024), nullptr);
+}
+TEST(ScopedArenaTest, ArenaStringsUseArenaStorage) {
+  ScopedArena arena;
+  size_t before = arena.bytes_used();
+  ArenaString line("a=rtpmap:111 opus/48000/2 padding padding padding",
+                   ArenaAllocator<char>(&arena));
+  EXPECT_GT(arena.bytes_used(), before);
+  EXPECT_EQ(line.compare(0, 9, "a=rtpmap:"), 0);
+}
+TEST(ScopedArenaTest, DefaultAllocatorFallsBackToHeap) {
+  // Container operations may default-construct the allocator; such
+  // instances must stay usable without an arena.
+  ArenaAllocator<char> heap_backed;
+  char* data = heap_backed.allocate(32);
+  EXPECT_NE(data, nullptr);
+  heap_backed.deallocate(data, 32);
+}
+}  // namespace base
+}  // namespace owt
@@ -0,0 +1,82 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "talk/owt/sdk/base/screencontentmonitor.h"
+#include <atomic>
+#include <mutex>
+#include "webrtc/rtc_base/logging.h"
+namespace owt {
+namespace base {
+namespace {
+// Exponential average weight per reported frame; at 30fps the average
+// settles in roughly two seconds, so a sub-second scroll burst stays
+// below the motion mark.
+const double kSmoothingAlpha = 0.05;
+// Classification needs this many reports before leaving kUnknown.
+const int kWarmupFrames = 30;
+// Hysteresis band. Above the high mark the content is motion, below the
+// low mark it is static; in between the previous classification sticks,
+// so scrolling a document does not flip the encoder back and forth.
+const double kMotionThreshold = 0.30;
+const double kStaticThreshold = 0.05;
+struct MonitorState {
+  std::mutex mutex;
+  double smoothed_fraction = 0.0;
+  int frames_seen = 0;
+};
+MonitorState& GetState() {
+  static MonitorState* state = new MonitorState();
+  return *state;
+}
+// Read from the encode path every frame; kept outside the mutex.
+std::atomic<int> g_content_type(static_cast<int>(ScreenContentType::kUnknown));
+}  // namespace
+void ScreenContentMonitor::ReportFrame(double updated_area_fraction) {
+  if (updated_area_fraction < 0.0) {
+    updated_area_fraction = 0.0;
+  } else if (updated_area_fraction > 1.0) {
+    updated_area_fraction = 1.0;
+  }
+  MonitorState& state = GetState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  state.smoothed_fraction += kSmoothingAlpha *
+                             (updated_area_fraction - state.smoothed_fraction);
+  if (state.frames_seen < kWarmupFrames) {
+    state.frames_seen++;
+    return;
+  }
+  ScreenContentType current = static_cast<ScreenContentType>(
+      g_content_type.load(std::memory_order_relaxed));
+  ScreenContentType next = current;
+  if (state.smoothed_fraction > kMotionThreshold) {
+    next = ScreenContentType::kMotion;
+  } else if (state.smoothed_fraction < kStaticThreshold) {
+    next = ScreenContentType::kStatic;
+  } else if (current == ScreenContentType::kUnknown) {
+    // Inside the band with no history yet; call it static, the more
+    // common steady state for screen shares.
+    next = ScreenContentType::kStatic;
+  }
+  if (next != current) {
+    RTC_LOG(LS_INFO) << "Screen content classified as "
+                     << (next == ScreenContentType::kMotion ? "motion"
+                                                            : "static")
+                     << ", dirty area fraction "
+                     << state.smoothed_fraction;
+    g_content_type.store(static_cast<int>(next), std::memory_order_relaxed);
+  }
+}
+ScreenContentType ScreenContentMonitor::Current() {
+  return static_cast<ScreenContentType>(
+      g_content_type.load(std::memory_order_relaxed));
+}
+void ScreenContentMonitor::Reset() {
+  MonitorState& state = GetState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  state.smoothed_fraction = 0.0;
+  state.frames_seen = 0;
+  g_content_type.store(static_cast<int>(ScreenContentType::kUnknown),
+                       std::memory_order_relaxed);
+}
+}  // namespace base
+}  // namespace owt
@@ -0,0 +1,40 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_SCREENCONTENTMONITOR_H_
+#define OWT_BASE_SCREENCONTENTMONITOR_H_
+// Process-wide classification of captured screen content. Screen shares
+// alternate between static documents, where per-frame quality wins, and
+// embedded video playback, where temporal prediction at full frame rate
+// wins; a fixed encoder configuration is wrong for half the session. The
+// screen capturer reports the fraction of the frame area its underlying
+// capturer marked dirty - a statistic it already has in hand - and the
+// monitor smooths it into a static/motion classification with
+// hysteresis, so a page scroll does not flip the mode. Hardware
+// encoders are created by codec factories without capturer identity
+// (the same pattern as IntraRefreshMode), so the encoder polls the
+// classification per frame and reconfigures itself in place when it
+// settles on the other type.
+namespace owt {
+namespace base {
+enum class ScreenContentType : int {
+  kUnknown = 0,
+  // Mostly unchanged frames: documents, dashboards, code.
+  kStatic = 1,
+  // Most of the frame changes every capture: video playback, games.
+  kMotion = 2,
+};
+class ScreenContentMonitor {
+ public:
+  // Reports one captured frame. |updated_area_fraction| is the dirty
+  // area divided by the frame area, in [0, 1]; an unchanged frame
+  // reports 0. Called from the capture thread at the capture rate.
+  static void ReportFrame(double updated_area_fraction);
+  // Current classification; kUnknown until enough frames are seen.
+  static ScreenContentType Current();
+  // Returns to kUnknown; called when screen capture stops.
+  static void Reset();
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_SCREENCONTENTMONITOR_H_
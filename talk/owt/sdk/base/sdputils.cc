@@ -1,7 +1,11 @@
 // Copyright (C) <2018> Intel Corporation
 //
 // SPDX-License-Identifier: Apache-2.0
-#include <regex>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <vector>
 #include <unordered_map>
@@ -22,8 +26,123 @@ static const std::unordered_map<VideoCodec, const std::string, EnumClassHash>
                          {VideoCodec::kH264, "H264"},
                          {VideoCodec::kVp9, "VP9"},
                          {VideoCodec::kH265, "H265"}};
+namespace {
+// FNV-1a, the fingerprint used elsewhere for cached parse results.
+const uint64_t kFnvOffset = 1469598103934665603ull;
+const uint64_t kFnvPrime = 1099511628211ull;
+uint64_t FnvMix(uint64_t hash, const char* data, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    hash ^= static_cast<uint8_t>(data[i]);
+    hash *= kFnvPrime;
+  }
+  // Separator so adjacent inputs cannot shift into each other.
+  hash ^= 0xff;
+  hash *= kFnvPrime;
+  return hash;
+}
+// Memoized codec selections. Every channel in a large join reorders an
+// identical codec block: the server hands out the same rtpmap/fmtp
+// section for each session and the preference list is fixed per
+// configuration, so the selection is computed once and replayed. Keyed
+// by a fingerprint of the section's codec attributes plus the
+// preference list; per-session values (ufrag, fingerprints, ssrcs) are
+// not part of the key and any section that does differ simply misses.
+struct CodecSelectionEntry {
+  CodecSelectionEntry() : fingerprint(0) {}
+  uint64_t fingerprint;
+  std::vector<std::string> kept_payloads;
+};
+const size_t kCodecSelectionCacheSize = 16;
+std::vector<CodecSelectionEntry> codec_selection_cache;
+size_t codec_selection_index = 0;
+std::mutex codec_selection_mutex;
+bool LookupCodecSelection(uint64_t fingerprint,
+                          std::vector<std::string>* kept_payloads) {
+  std::lock_guard<std::mutex> lock(codec_selection_mutex);
+  for (auto& entry : codec_selection_cache) {
+    if (entry.fingerprint == fingerprint) {
+      *kept_payloads = entry.kept_payloads;
+      return true;
+    }
+  }
+  return false;
+}
+void StoreCodecSelection(uint64_t fingerprint,
+                         const std::vector<std::string>& kept_payloads) {
+  std::lock_guard<std::mutex> lock(codec_selection_mutex);
+  if (codec_selection_cache.size() < kCodecSelectionCacheSize) {
+    codec_selection_cache.push_back(CodecSelectionEntry());
+    codec_selection_cache.back().fingerprint = fingerprint;
+    codec_selection_cache.back().kept_payloads = kept_payloads;
+    return;
+  }
+  codec_selection_cache[codec_selection_index].fingerprint = fingerprint;
+  codec_selection_cache[codec_selection_index].kept_payloads = kept_payloads;
+  codec_selection_index = (codec_selection_index + 1) % kCodecSelectionCacheSize;
+}
+}  // namespace
+// Returns |line| without its trailing CR/LF, keeping the line's
+// allocator so arena-backed lines yield arena-backed copies.
+template <typename StringType>
+static StringType TrimLineEnding(const StringType& line) {
+  size_t end = line.size();
+  while (end > 0 && (line[end - 1] == '\n' || line[end - 1] == '\r'))
+    end--;
+  return StringType(line.data(), end, line.get_allocator());
+}
+static std::string ToLower(const std::string& s) {
+  std::string result(s);
+  for (auto& c : result)
+    c = static_cast<char>(tolower(c));
+  return result;
+}
+template <typename StringType>
+static bool HasPrefix(const StringType& line, const char* prefix) {
+  return line.compare(0, strlen(prefix), prefix) == 0;
+}
+// If |line| is an a=rtpmap:, a=fmtp: or a=rtcp-fb: attribute, returns its
+// payload type and stores the text after the payload type in |rest|;
+// returns an empty string otherwise. Payload types and codec names are
+// short enough for the small-string buffer, so plain std::string copies
+// of them allocate nothing.
+template <typename StringType>
+static std::string PayloadOfCodecAttribute(const StringType& line,
+                                           std::string* rest) {
+  size_t value_start;
+  if (HasPrefix(line, "a=rtpmap:"))
+    value_start = 9;
+  else if (HasPrefix(line, "a=fmtp:"))
+    value_start = 7;
+  else if (HasPrefix(line, "a=rtcp-fb:"))
+    value_start = 10;
+  else
+    return "";
+  size_t space = line.find(' ', value_start);
+  if (space == StringType::npos)
+    return "";
+  if (rest)
+    rest->assign(line.data() + space + 1, line.size() - space - 1);
+  return std::string(line.data() + value_start, space - value_start);
+}
+// Splits |sdp| into lines drawn from |arena|, keeping the line ending
+// attached to each line so the untouched parts round-trip byte for byte.
+static ArenaVector<ArenaString> SplitLines(const std::string& sdp,
+                                           ScopedArena* arena) {
+  ArenaVector<ArenaString> lines((ArenaAllocator<ArenaString>(arena)));
+  const ArenaAllocator<char> char_alloc(arena);
+  size_t pos = 0;
+  while (pos < sdp.size()) {
+    size_t eol = sdp.find('\n', pos);
+    size_t length =
+        eol == std::string::npos ? sdp.size() - pos : eol - pos + 1;
+    lines.push_back(ArenaString(sdp.data() + pos, length, char_alloc));
+    pos += length;
+  }
+  return lines;
+}
 std::string SdpUtils::SetPreferAudioCodecs(const std::string& original_sdp,
-                                          std::vector<AudioCodec>& codec) {
+                                           std::vector<AudioCodec>& codec,
+                                           ScopedArena* arena) {
   std::string cur_sdp(original_sdp);
   if (codec.size() == 0)
     return cur_sdp;
@@ -37,11 +156,12 @@ std::string SdpUtils::SetPreferAudioCodecs(const std::string& original_sdp,
     }
     codec_names.push_back(codec_it->second);
   }
-  cur_sdp = SdpUtils::SetPreferCodecs(cur_sdp, codec_names, true);
+  cur_sdp = SdpUtils::SetPreferCodecs(cur_sdp, codec_names, true, arena);
   return cur_sdp;
 }
 std::string SdpUtils::SetPreferVideoCodecs(const std::string& original_sdp,
-                                          std::vector<VideoCodec>& codec) {
+                                           std::vector<VideoCodec>& codec,
+                                           ScopedArena* arena) {
   std::string cur_sdp(original_sdp);
   if (codec.size() == 0)
     return cur_sdp;
@@ -55,119 +175,148 @@ std::string SdpUtils::SetPreferVideoCodecs(const std::string& original_sdp,
     }
     codec_names.push_back(codec_it->second);
   }
-  cur_sdp = SdpUtils::SetPreferCodecs(cur_sdp, codec_names, false);
+  cur_sdp = SdpUtils::SetPreferCodecs(cur_sdp, codec_names, false, arena);
   return cur_sdp;
 }
-std::vector<std::string> SdpUtils::GetCodecValues(const std::string& sdp,
-    std::string& codec_name,
-    bool is_audio) {
-  std::vector<std::string> codec_values;
-  std::string sdp_current(sdp);
-  std::regex reg_rtp_map(
-      "a=rtpmap:(\\d+) " + codec_name + "\\/\\d+(?=[\r]?[\n]?)",
-      std::regex_constants::icase);
-  std::smatch rtp_map_match;
-  while (std::regex_search(sdp_current, rtp_map_match, reg_rtp_map)) {
-    codec_values.push_back(rtp_map_match[1]);
-    sdp_current = rtp_map_match.suffix();
-  }
-  return codec_values;
-}
 // Remove non-prefer codecs out of the list. Keeping red and ulpfec,
 // assuming the binding to original codec is out-of-bound.
 // Keeping corresponding rtx payloads. Reorder m-line according to
 // the reverse order of input codec names.
-// TODO: unify to std::regex impl for Linux builds.
+// The SDP is split into lines once; the target m-section is indexed in a
+// single pass (rtpmaps and rtx apt bindings), then the output is built in
+// one more pass that rewrites the m-line and skips attribute lines of
+// dropped payload types. This replaces per-codec regex scans over the
+// whole SDP, which dominated offer/answer CPU time with many channels.
+// The selection itself is memoized per codec-block fingerprint (see
+// CodecSelectionEntry above), so repeat negotiations skip the indexing
+// pass and go straight to the rewrite.
 std::string SdpUtils::SetPreferCodecs(const std::string& sdp,
     std::vector<std::string>& codec_names,
-    bool is_audio) {
-  // Search all rtx maps in the sdp.
-  std::regex reg_fmtp_apt(
-      "a=fmtp:(\\d+) apt=(\\d+)(?=[\r]?[\n]?)",
-      std::regex_constants::icase);
-  std::smatch rtx_map_match;
-  // Key is the rtx payload type, value is the original payload type.
-  std::unordered_map<std::string, std::string> rtx_maps;
-  std::string current_sdp = sdp;
-  while (std::regex_search(current_sdp, rtx_map_match, reg_fmtp_apt)) {
-    rtx_maps.insert({ rtx_map_match.str(1), rtx_map_match.str(2) });
-    current_sdp = rtx_map_match.suffix();
+    bool is_audio,
+    ScopedArena* arena) {
+  // Callers without an arena (tests, external users) get a private one
+  // released when the call returns.
+  std::unique_ptr<ScopedArena> local_arena;
+  if (arena == nullptr) {
+    local_arena.reset(new ScopedArena());
+    arena = local_arena.get();
   }
-  std::vector<std::string> kept_codec_values;
-  if (!is_audio) {
-    // Get red and ulpfec payload type if any.
-    bool has_red = false, has_ulpfec = false;
-    std::regex reg_red_map(
-        "a=rtpmap:(\\d+) red\\/\\d+(?=[\r]?[\n]?)",
-        std::regex_constants::icase);
-    std::smatch red_map_match;
-    std::string red_codec_value;
-    auto search_result = std::regex_search(sdp, red_map_match, reg_red_map);
-    if (search_result && red_map_match.size() != 0) {
-      red_codec_value = red_map_match[1];
-      has_red = true;
-    }
-    std::regex reg_ulpfec_map(
-        "a=rtpmap:(\\d+) ulpfec\\/\\d+(?=[\r]?[\n]?)",
-        std::regex_constants::icase);
-    std::smatch ulpfec_map_match;
-    std::string ulpfec_codec_value;
-    search_result = std::regex_search(sdp, ulpfec_map_match, reg_ulpfec_map);
-    if (search_result && ulpfec_map_match.size() != 0) {
-      ulpfec_codec_value = ulpfec_map_match[1];
-      has_ulpfec = true;
-    }
-    if (has_red) {
-      kept_codec_values.push_back(red_codec_value);
-      for (auto& rtx_value : rtx_maps) {
-        if (rtx_value.second == red_codec_value) {
-            kept_codec_values.push_back(rtx_value.first);
-        }
-      }
-    }
-    if (has_ulpfec) {
-      kept_codec_values.push_back(ulpfec_codec_value);
-      for (auto& rtx_value : rtx_maps) {
-        if (rtx_value.second == ulpfec_codec_value) {
-            kept_codec_values.push_back(rtx_value.first);
+  const std::string media_type = is_audio ? "audio" : "video";
+  const std::string m_line_prefix = "m=" + media_type + " ";
+  ArenaVector<ArenaString> lines = SplitLines(sdp, arena);
+  // Locate the m-line of the target media type and the end of its section.
+  size_t m_line_index = lines.size();
+  size_t section_end = lines.size();
+  for (size_t i = 0; i < lines.size(); i++) {
+    if (HasPrefix(lines[i], m_line_prefix.c_str())) {
+      m_line_index = i;
+      for (size_t j = i + 1; j < lines.size(); j++) {
+        if (HasPrefix(lines[j], "m=")) {
+          section_end = j;
+          break;
         }
       }
+      break;
     }
   }
-  for (auto& codec_name : codec_names) {
-    std::vector<std::string> codec_values = GetCodecValues(sdp, codec_name, is_audio);
-    for (auto& value : codec_values) {
-      // Input codec names are in reverse order, so the highest priortiy will be
-      // placed at the beginning.
-      kept_codec_values.insert(kept_codec_values.begin(), value);
-      for (auto& rtx_value : rtx_maps) {
-        if (rtx_value.second == value) {
-          kept_codec_values.push_back(rtx_value.first);
-        }
-      }
-    }
-  }
-  std::string media_type;
-  media_type = is_audio ? "audio" : "video";
-  std::regex reg_m_line("m=" + media_type + ".*(?=[\r]?[\n]?)");
-  std::smatch m_line_match;
-  auto search_result = std::regex_search(sdp, m_line_match, reg_m_line);
-  if (!search_result || m_line_match.size() == 0) {
+  if (m_line_index == lines.size()) {
     RTC_LOG(LS_WARNING) << "M-line is not found. SDP: " << sdp;
     return sdp;
   }
-  std::string m_line(m_line_match[0]);
-  // Split m_line into vector and put preferred codec in the first place.
+  ArenaString m_line = TrimLineEnding(lines[m_line_index]);
+  // The m-line items (media type, port, protocol, payload types) all fit
+  // the small-string buffer.
   std::vector<std::string> m_line_vector;
-  std::stringstream original_m_line_stream(m_line);
-  std::string item;
-  while (std::getline(original_m_line_stream, item, ' ')) {
-    m_line_vector.push_back(item);
+  size_t item_start = 0;
+  while (item_start <= m_line.size()) {
+    size_t space = m_line.find(' ', item_start);
+    size_t item_end = space == ArenaString::npos ? m_line.size() : space;
+    m_line_vector.push_back(
+        std::string(m_line.data() + item_start, item_end - item_start));
+    if (space == ArenaString::npos)
+      break;
+    item_start = space + 1;
   }
   if (m_line_vector.size() < 3) {
     RTC_LOG(LS_WARNING) << "Wrong SDP format description: " << m_line;
     return sdp;
   }
+  // Fingerprint everything the selection depends on: media type, the
+  // preference list, the m-line payload list and the section's codec
+  // attribute lines. Lines carrying per-session values are deliberately
+  // left out, so the same codec block fingerprints identically across
+  // the hundreds of near-identical negotiations a large join performs.
+  uint64_t fingerprint = kFnvOffset;
+  fingerprint = FnvMix(fingerprint, media_type.data(), media_type.size());
+  for (auto& codec_name : codec_names) {
+    fingerprint = FnvMix(fingerprint, codec_name.data(), codec_name.size());
+  }
+  fingerprint = FnvMix(fingerprint, m_line.data(), m_line.size());
+  for (size_t i = m_line_index + 1; i < section_end; i++) {
+    ArenaString line = TrimLineEnding(lines[i]);
+    if (HasPrefix(line, "a=rtpmap:") || HasPrefix(line, "a=fmtp:") ||
+        HasPrefix(line, "a=rtcp-fb:")) {
+      fingerprint = FnvMix(fingerprint, line.data(), line.size());
+    }
+  }
+  std::vector<std::string> kept_codec_values;
+  if (!LookupCodecSelection(fingerprint, &kept_codec_values)) {
+    // Index the section: payload type to lower-case codec name in order of
+    // appearance, and rtx payload type to the payload type it protects.
+    std::unordered_map<std::string, std::string> rtpmap_names;
+    std::vector<std::string> rtpmap_payload_order;
+    std::vector<std::pair<std::string, std::string>> rtx_maps;
+    for (size_t i = m_line_index + 1; i < section_end; i++) {
+      ArenaString line = TrimLineEnding(lines[i]);
+      std::string rest;
+      std::string payload = PayloadOfCodecAttribute(line, &rest);
+      if (payload.empty())
+        continue;
+      if (HasPrefix(line, "a=rtpmap:")) {
+        size_t slash = rest.find('/');
+        std::string name =
+            slash == std::string::npos ? rest : rest.substr(0, slash);
+        if (rtpmap_names.find(payload) == rtpmap_names.end()) {
+          rtpmap_names[payload] = ToLower(name);
+          rtpmap_payload_order.push_back(payload);
+        }
+      } else if (HasPrefix(line, "a=fmtp:") && HasPrefix(rest, "apt=")) {
+        rtx_maps.push_back(std::make_pair(payload, rest.substr(4)));
+      }
+    }
+    auto append_rtx_of = [&](const std::string& value) {
+      for (auto& rtx_value : rtx_maps) {
+        if (rtx_value.second == value) {
+          kept_codec_values.push_back(rtx_value.first);
+        }
+      }
+    };
+    if (!is_audio) {
+      // Keep red and ulpfec payload types if any.
+      for (const char* fec_name : {"red", "ulpfec"}) {
+        for (auto& payload : rtpmap_payload_order) {
+          if (rtpmap_names[payload] == fec_name) {
+            kept_codec_values.push_back(payload);
+            append_rtx_of(payload);
+            break;
+          }
+        }
+      }
+    }
+    for (auto& codec_name : codec_names) {
+      std::string lower_name = ToLower(codec_name);
+      for (auto& payload : rtpmap_payload_order) {
+        if (rtpmap_names[payload] != lower_name)
+          continue;
+        // Input codec names are in reverse order, so the highest priortiy will
+        // be placed at the beginning.
+        kept_codec_values.insert(kept_codec_values.begin(), payload);
+        append_rtx_of(payload);
+      }
+    }
+    StoreCodecSelection(fingerprint, kept_codec_values);
+  }
+  // Rewrite the m-line with the kept payload types in preference order.
   std::stringstream m_line_stream;
   for (int i = 0; i < 3; i++) {
     if (i < 2)
@@ -179,32 +328,227 @@ std::string SdpUtils::SetPreferCodecs(const std::string& sdp,
     m_line_stream << " " << codec_value;
   }
   RTC_LOG(LS_INFO) << "New m-line: " << m_line_stream.str();
-  std::string before_strip = std::regex_replace(sdp, reg_m_line, m_line_stream.str());
-  std::string after_strip = before_strip;
-  // Remove all a=fmtp:xx, a=rtpmap:xx and a=rtcp-fb:xx where xx is not in m-line,
-  // this includes the a=fmtp:xx apt:yy lines for rtx.
-  for (size_t i = 3, m_line_vector_size = m_line_vector.size(); i < m_line_vector_size; i++) {
-    if (std::find(kept_codec_values.begin(), kept_codec_values.end(),
-      m_line_vector[i]) == kept_codec_values.end()) {
-      std::string codec_value = m_line_vector[i];
-      std::regex reg_rtp_xx_map(
-          "a=rtpmap:" + codec_value + " .*\\r\\n",
-          std::regex_constants::icase);
-      after_strip = std::regex_replace(before_strip, reg_rtp_xx_map, "");
-      before_strip = after_strip;
-      std::regex reg_fmtp_xx_map(
-          "a=fmtp:" + codec_value + " .*\\r\\n",
-          std::regex_constants::icase);
-      after_strip = std::regex_replace(before_strip, reg_fmtp_xx_map, "");
-      before_strip = after_strip;
-      std::regex reg_rtcp_map(
-          "a=rtcp-fb:" + codec_value + " .*\\r\\n",
-          std::regex_constants::icase);
-      after_strip = std::regex_replace(before_strip, reg_rtcp_map, "");
-      before_strip = after_strip;
-    }
-  }
-  return after_strip;
+  std::string line_ending(lines[m_line_index].data() + m_line.size(),
+                          lines[m_line_index].size() - m_line.size());
+  // Build the output, dropping a=rtpmap/a=fmtp/a=rtcp-fb lines of payload
+  // types that were on the original m-line but are no longer kept.
+  std::string result;
+  result.reserve(sdp.size());
+  for (size_t i = 0; i < lines.size(); i++) {
+    if (i == m_line_index) {
+      result += m_line_stream.str();
+      result += line_ending;
+      continue;
+    }
+    if (i > m_line_index && i < section_end) {
+      std::string payload =
+          PayloadOfCodecAttribute(TrimLineEnding(lines[i]), nullptr);
+      if (!payload.empty() &&
+          std::find(m_line_vector.begin() + 3, m_line_vector.end(), payload) !=
+              m_line_vector.end() &&
+          std::find(kept_codec_values.begin(), kept_codec_values.end(),
+                    payload) == kept_codec_values.end()) {
+        continue;
+      }
+    }
+    result.append(lines[i].data(), lines[i].size());
+  }
+  return result;
+}
+std::string SdpUtils::EnableOpusDtx(const std::string& sdp,
+                                    ScopedArena* arena) {
+  std::unique_ptr<ScopedArena> local_arena;
+  if (arena == nullptr) {
+    local_arena.reset(new ScopedArena());
+    arena = local_arena.get();
+  }
+  ArenaVector<ArenaString> lines = SplitLines(sdp, arena);
+  size_t m_line_index = lines.size();
+  size_t section_end = lines.size();
+  for (size_t i = 0; i < lines.size(); i++) {
+    if (HasPrefix(lines[i], "m=audio ")) {
+      m_line_index = i;
+      for (size_t j = i + 1; j < lines.size(); j++) {
+        if (HasPrefix(lines[j], "m=")) {
+          section_end = j;
+          break;
+        }
+      }
+      break;
+    }
+  }
+  if (m_line_index == lines.size()) {
+    RTC_LOG(LS_WARNING) << "No audio section to enable Opus DTX in.";
+    return sdp;
+  }
+  // Collect the Opus payload types and note which of them already carry an
+  // fmtp line; their rtpmap line ending is reused for inserted lines.
+  std::vector<std::string> opus_payloads;
+  std::vector<std::string> opus_payloads_with_fmtp;
+  std::string line_ending("\r\n");
+  for (size_t i = m_line_index + 1; i < section_end; i++) {
+    ArenaString line = TrimLineEnding(lines[i]);
+    std::string rest;
+    std::string payload = PayloadOfCodecAttribute(line, &rest);
+    if (payload.empty())
+      continue;
+    if (HasPrefix(line, "a=rtpmap:")) {
+      size_t slash = rest.find('/');
+      std::string name =
+          slash == std::string::npos ? rest : rest.substr(0, slash);
+      if (ToLower(name) == "opus") {
+        opus_payloads.push_back(payload);
+        line_ending.assign(lines[i].data() + line.size(),
+                           lines[i].size() - line.size());
+      }
+    } else if (HasPrefix(line, "a=fmtp:") &&
+               std::find(opus_payloads.begin(), opus_payloads.end(),
+                         payload) != opus_payloads.end()) {
+      opus_payloads_with_fmtp.push_back(payload);
+    }
+  }
+  if (opus_payloads.empty()) {
+    return sdp;
+  }
+  std::string result;
+  result.reserve(sdp.size() + 64);
+  for (size_t i = 0; i < lines.size(); i++) {
+    if (i > m_line_index && i < section_end) {
+      ArenaString line = TrimLineEnding(lines[i]);
+      std::string rest;
+      std::string payload = PayloadOfCodecAttribute(line, &rest);
+      if (!payload.empty() &&
+          std::find(opus_payloads.begin(), opus_payloads.end(), payload) !=
+              opus_payloads.end()) {
+        if (HasPrefix(line, "a=fmtp:") &&
+            rest.find("usedtx=") == std::string::npos) {
+          result.append(line.data(), line.size());
+          result += ";usedtx=1";
+          result += line_ending;
+          continue;
+        }
+        if (HasPrefix(line, "a=rtpmap:") &&
+            std::find(opus_payloads_with_fmtp.begin(),
+                      opus_payloads_with_fmtp.end(),
+                      payload) == opus_payloads_with_fmtp.end()) {
+          result.append(lines[i].data(), lines[i].size());
+          result += "a=fmtp:" + payload + " usedtx=1";
+          result += line_ending;
+          continue;
+        }
+      }
+    }
+    result.append(lines[i].data(), lines[i].size());
+  }
+  return result;
+}
+// Retransmission stays bound to the original SSRC only; per-layer RTX
+// would need fresh FID pairs and buys little for the lower layers.
+std::string SdpUtils::AddSimulcastLayers(const std::string& sdp,
+                                         int layer_count,
+                                         ScopedArena* arena) {
+  if (layer_count <= 1)
+    return sdp;
+  std::unique_ptr<ScopedArena> local_arena;
+  if (arena == nullptr) {
+    local_arena.reset(new ScopedArena());
+    arena = local_arena.get();
+  }
+  ArenaVector<ArenaString> lines = SplitLines(sdp, arena);
+  size_t m_line_index = lines.size();
+  size_t section_end = lines.size();
+  for (size_t i = 0; i < lines.size(); i++) {
+    if (HasPrefix(lines[i], "m=video ")) {
+      m_line_index = i;
+      for (size_t j = i + 1; j < lines.size(); j++) {
+        if (HasPrefix(lines[j], "m=")) {
+          section_end = j;
+          break;
+        }
+      }
+      break;
+    }
+  }
+  if (m_line_index == lines.size()) {
+    RTC_LOG(LS_WARNING) << "No video section to add simulcast layers to.";
+    return sdp;
+  }
+  // The primary SSRC is the protected one of the first FID group, or the
+  // first a=ssrc in the section. Collect every SSRC in use so the new
+  // ones cannot collide.
+  std::string primary_ssrc;
+  std::vector<std::string> existing_ssrcs;
+  std::vector<std::string> primary_attributes;
+  std::string line_ending("\r\n");
+  for (size_t i = m_line_index + 1; i < section_end; i++) {
+    ArenaString line = TrimLineEnding(lines[i]);
+    if (HasPrefix(line, "a=ssrc-group:FID ")) {
+      if (primary_ssrc.empty()) {
+        size_t start = strlen("a=ssrc-group:FID ");
+        size_t space = line.find(' ', start);
+        size_t length =
+            (space == ArenaString::npos ? line.size() : space) - start;
+        primary_ssrc.assign(line.data() + start, length);
+      }
+    } else if (HasPrefix(line, "a=ssrc:")) {
+      size_t space = line.find(' ');
+      if (space == ArenaString::npos)
+        continue;
+      std::string ssrc(line.data() + 7, space - 7);
+      if (std::find(existing_ssrcs.begin(), existing_ssrcs.end(), ssrc) ==
+          existing_ssrcs.end()) {
+        existing_ssrcs.push_back(ssrc);
+      }
+      if (primary_ssrc.empty())
+        primary_ssrc = ssrc;
+      if (ssrc == primary_ssrc) {
+        primary_attributes.push_back(
+            std::string(line.data() + space + 1, line.size() - space - 1));
+        line_ending.assign(lines[i].data() + line.size(),
+                           lines[i].size() - line.size());
+      }
+    }
+  }
+  if (primary_ssrc.empty() || primary_attributes.empty()) {
+    RTC_LOG(LS_WARNING) << "No send SSRC to add simulcast layers to.";
+    return sdp;
+  }
+  uint64_t primary_value = strtoull(primary_ssrc.c_str(), nullptr, 10);
+  std::vector<std::string> layer_ssrcs;
+  layer_ssrcs.push_back(primary_ssrc);
+  uint64_t candidate = primary_value;
+  for (int layer = 1; layer < layer_count; layer++) {
+    do {
+      candidate = (candidate + 1) & 0xFFFFFFFFull;
+    } while (std::find(existing_ssrcs.begin(), existing_ssrcs.end(),
+                       std::to_string(candidate)) != existing_ssrcs.end());
+    layer_ssrcs.push_back(std::to_string(candidate));
+    existing_ssrcs.push_back(std::to_string(candidate));
+  }
+  std::stringstream addition;
+  addition << "a=ssrc-group:SIM";
+  for (auto& ssrc : layer_ssrcs) {
+    addition << " " << ssrc;
+  }
+  addition << line_ending;
+  for (size_t layer = 1; layer < layer_ssrcs.size(); layer++) {
+    for (auto& attribute : primary_attributes) {
+      addition << "a=ssrc:" << layer_ssrcs[layer] << " " << attribute
+               << line_ending;
+    }
+  }
+  std::string result;
+  result.reserve(sdp.size() + 256);
+  for (size_t i = 0; i < lines.size(); i++) {
+    if (i == section_end) {
+      result += addition.str();
+    }
+    result.append(lines[i].data(), lines[i].size());
+  }
+  if (section_end == lines.size()) {
+    result += addition.str();
+  }
+  return result;
 }
 }
 }
@@ -5,29 +5,55 @@
 #define OWT_BASE_SDPUTILS_H_
 #include <string>
 #include <vector>
+#include "talk/owt/sdk/base/scopedarena.h"
 #include "talk/owt/sdk/include/cpp/owt/base/commontypes.h"
 namespace owt {
 namespace base {
-/// This class provides utilities for SDP parsing and modification
+/// This class provides utilities for SDP parsing and modification.
+/// The transient line tables and attribute copies each call makes are
+/// drawn from |arena| when one is passed, so a caller running several
+/// passes over the same negotiation can release them wholesale with one
+/// ScopedArena::Reset; without an arena each call uses a private one.
 class SdpUtils {
  public:
   static std::string SetPreferAudioCodecs(const std::string& sdp,
-                                         std::vector<AudioCodec>& codec);
+                                          std::vector<AudioCodec>& codec,
+                                          ScopedArena* arena = nullptr);
   static std::string SetPreferVideoCodecs(const std::string& sdp,
-                                         std::vector<VideoCodec>& codec);
+                                          std::vector<VideoCodec>& codec,
+                                          ScopedArena* arena = nullptr);
+  /**
+   @brief Add simulcast send layers to the video section of a local offer.
+   @details Adds |layer_count| - 1 extra send SSRCs mirroring the cname
+   and msid of the original one and groups them with an a=ssrc-group:SIM
+   line, the legacy simulcast signaling SFUs act on. The original SSRC
+   stays the first layer. Returns the SDP unchanged when it carries no
+   video SSRC or |layer_count| is not above one.
+   */
+  static std::string AddSimulcastLayers(const std::string& sdp,
+                                        int layer_count,
+                                        ScopedArena* arena = nullptr);
+  /**
+   @brief Turn on Opus discontinuous transmission in the audio section.
+   @details Appends usedtx=1 to the fmtp line of every Opus payload type,
+   adding the fmtp line when the offer carries none, so the encoder stops
+   emitting full frames during silence. Returns the SDP unchanged when it
+   has no audio section or no Opus payload.
+   */
+  static std::string EnableOpusDtx(const std::string& sdp,
+                                   ScopedArena* arena = nullptr);
  private:
   /**
    @brief Replace SDP for preferred codec.
    @param sdp Original SDP.
    @param codec_names Codec names in SDP.
    @param is_audio True if prefer audio codec, false if prefer video codec.
+   @param arena Arena the transient copies are drawn from.
    */
   static std::string SetPreferCodecs(const std::string& sdp,
                                      std::vector<std::string>& codec_name,
-                                     bool is_audio);
-  static std::vector<std::string> GetCodecValues(const std::string& sdp,
-                                                 std::string& codec_name,
-                                                 bool is_audio);
+                                     bool is_audio,
+                                     ScopedArena* arena);
 };
 }
 }
@@ -0,0 +1,248 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "talk/owt/sdk/base/shmringbuffer.h"
+#include <atomic>
+#include <cstring>
+#if !defined(WEBRTC_WIN)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "webrtc/rtc_base/logging.h"
+namespace owt {
+namespace base {
+namespace {
+const uint32_t kMagic = 0x4F575452;  // "OWTR"
+// Record sizes are padded to this, so the length prefix never splits
+// across the wrap point.
+const size_t kAlign = 8;
+// Length prefix marking padding at the end of the ring; the reader
+// skips to offset zero when it sees it.
+const uint32_t kWrapMarker = 0xFFFFFFFF;
+size_t AlignUp(size_t value) {
+  return (value + kAlign - 1) & ~(kAlign - 1);
+}
+}  // namespace
+// Lives at the start of the mapped segment, shared by both processes.
+struct ShmRingBuffer::Header {
+  uint32_t magic;
+  uint32_t capacity;
+  // Byte offsets into the ring, modulo nothing: offsets wrap explicitly
+  // with kWrapMarker so a record is always contiguous.
+  std::atomic<uint64_t> head;  // next write offset, producer-owned.
+  std::atomic<uint64_t> tail;  // next read offset, consumer-owned.
+};
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t),
+              "atomics in shared memory must be plain words");
+ShmRingBuffer::ShmRingBuffer()
+    : header_(nullptr),
+      ring_(nullptr),
+      capacity_(0),
+      owner_(false),
+      dropped_records_(0),
+#if defined(WEBRTC_WIN)
+      mapping_(nullptr) {
+}
+#else
+      fd_(-1),
+      mapped_size_(0) {
+}
+#endif
+std::unique_ptr<ShmRingBuffer> ShmRingBuffer::Create(const std::string& name,
+                                                     size_t capacity) {
+  std::unique_ptr<ShmRingBuffer> buffer(new ShmRingBuffer());
+  if (!buffer->Map(name, capacity, true)) {
+    return nullptr;
+  }
+  buffer->header_->capacity = static_cast<uint32_t>(capacity);
+  buffer->header_->head.store(0, std::memory_order_relaxed);
+  buffer->header_->tail.store(0, std::memory_order_relaxed);
+  // The magic is published last so a concurrent Open never sees a
+  // half-initialized header.
+  reinterpret_cast<std::atomic<uint32_t>*>(&buffer->header_->magic)
+      ->store(kMagic, std::memory_order_release);
+  return buffer;
+}
+std::unique_ptr<ShmRingBuffer> ShmRingBuffer::Open(const std::string& name) {
+  std::unique_ptr<ShmRingBuffer> buffer(new ShmRingBuffer());
+  if (!buffer->Map(name, 0, false)) {
+    return nullptr;
+  }
+  if (reinterpret_cast<std::atomic<uint32_t>*>(&buffer->header_->magic)
+          ->load(std::memory_order_acquire) != kMagic) {
+    RTC_LOG(LS_ERROR) << "Shared memory segment " << name
+                      << " carries no ring buffer.";
+    return nullptr;
+  }
+  buffer->capacity_ = buffer->header_->capacity;
+  return buffer;
+}
+#if defined(WEBRTC_WIN)
+bool ShmRingBuffer::Map(const std::string& name, size_t capacity,
+                        bool create) {
+  size_t total = sizeof(Header) + capacity;
+  if (create) {
+    mapping_ = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr,
+                                  PAGE_READWRITE, 0,
+                                  static_cast<DWORD>(total), name.c_str());
+    if (mapping_ == nullptr || GetLastError() == ERROR_ALREADY_EXISTS) {
+      RTC_LOG(LS_ERROR) << "Failed to create shared memory segment " << name;
+      return false;
+    }
+  } else {
+    mapping_ = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+    if (mapping_ == nullptr) {
+      return false;
+    }
+  }
+  void* base = MapViewOfFile(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+  if (base == nullptr) {
+    CloseHandle(mapping_);
+    mapping_ = nullptr;
+    return false;
+  }
+  header_ = reinterpret_cast<Header*>(base);
+  ring_ = reinterpret_cast<uint8_t*>(base) + sizeof(Header);
+  capacity_ = capacity;
+  owner_ = create;
+  name_ = name;
+  return true;
+}
+ShmRingBuffer::~ShmRingBuffer() {
+  if (header_ != nullptr) {
+    UnmapViewOfFile(header_);
+  }
+  if (mapping_ != nullptr) {
+    CloseHandle(mapping_);
+  }
+}
+#else
+bool ShmRingBuffer::Map(const std::string& name, size_t capacity,
+                        bool create) {
+  std::string shm_name = "/" + name;
+  if (create) {
+    fd_ = shm_open(shm_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd_ < 0) {
+      RTC_LOG(LS_ERROR) << "Failed to create shared memory segment " << name;
+      return false;
+    }
+    mapped_size_ = sizeof(Header) + capacity;
+    if (ftruncate(fd_, mapped_size_) != 0) {
+      close(fd_);
+      fd_ = -1;
+      shm_unlink(shm_name.c_str());
+      return false;
+    }
+  } else {
+    fd_ = shm_open(shm_name.c_str(), O_RDWR, 0600);
+    if (fd_ < 0) {
+      return false;
+    }
+    struct stat st;
+    if (fstat(fd_, &st) != 0 ||
+        static_cast<size_t>(st.st_size) <= sizeof(Header)) {
+      close(fd_);
+      fd_ = -1;
+      return false;
+    }
+    mapped_size_ = st.st_size;
+  }
+  void* base = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_SHARED,
+                    fd_, 0);
+  if (base == MAP_FAILED) {
+    close(fd_);
+    fd_ = -1;
+    if (create) {
+      shm_unlink(shm_name.c_str());
+    }
+    return false;
+  }
+  header_ = reinterpret_cast<Header*>(base);
+  ring_ = reinterpret_cast<uint8_t*>(base) + sizeof(Header);
+  capacity_ = capacity;
+  owner_ = create;
+  name_ = name;
+  return true;
+}
+ShmRingBuffer::~ShmRingBuffer() {
+  if (header_ != nullptr) {
+    munmap(header_, mapped_size_);
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+  if (owner_) {
+    shm_unlink(("/" + name_).c_str());
+  }
+}
+#endif
+bool ShmRingBuffer::Write(const uint8_t* data, size_t size) {
+  if (data == nullptr || size == 0 || size > 0xFFFFFFF0u) {
+    return false;
+  }
+  size_t record = AlignUp(sizeof(uint32_t) + size);
+  uint64_t head = header_->head.load(std::memory_order_relaxed);
+  uint64_t tail = header_->tail.load(std::memory_order_acquire);
+  size_t used = static_cast<size_t>(head - tail);
+  size_t head_offset = static_cast<size_t>(head % capacity_);
+  size_t to_end = capacity_ - head_offset;
+  size_t needed = record;
+  bool wraps = to_end < record;
+  if (wraps) {
+    // The record would split; mark the remainder and start at zero.
+    needed = to_end + record;
+  }
+  // One record of headroom keeps head from catching up with tail.
+  if (used + needed + kAlign > capacity_) {
+    dropped_records_++;
+    return false;
+  }
+  if (wraps) {
+    if (to_end >= sizeof(uint32_t)) {
+      memcpy(ring_ + head_offset, &kWrapMarker, sizeof(uint32_t));
+    }
+    head += to_end;
+    head_offset = 0;
+  }
+  uint32_t size32 = static_cast<uint32_t>(size);
+  memcpy(ring_ + head_offset, &size32, sizeof(uint32_t));
+  memcpy(ring_ + head_offset + sizeof(uint32_t), data, size);
+  header_->head.store(head + record, std::memory_order_release);
+  return true;
+}
+bool ShmRingBuffer::Read(std::vector<uint8_t>* record) {
+  uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+  uint64_t head = header_->head.load(std::memory_order_acquire);
+  if (tail == head) {
+    return false;
+  }
+  size_t tail_offset = static_cast<size_t>(tail % capacity_);
+  size_t to_end = capacity_ - tail_offset;
+  uint32_t size32;
+  if (to_end < sizeof(uint32_t)) {
+    // Unmarked padding too small to hold a prefix; skip to the start.
+    header_->tail.store(tail + to_end, std::memory_order_release);
+    return Read(record);
+  }
+  memcpy(&size32, ring_ + tail_offset, sizeof(uint32_t));
+  if (size32 == kWrapMarker) {
+    header_->tail.store(tail + to_end, std::memory_order_release);
+    return Read(record);
+  }
+  if (size32 == 0 || sizeof(uint32_t) + size32 > to_end) {
+    // Corrupt prefix; resynchronize by draining to the writer's head.
+    RTC_LOG(LS_ERROR) << "Corrupt record in shared memory ring; dropping "
+                         "buffered data.";
+    header_->tail.store(head, std::memory_order_release);
+    return false;
+  }
+  record->assign(ring_ + tail_offset + sizeof(uint32_t),
+                 ring_ + tail_offset + sizeof(uint32_t) + size32);
+  header_->tail.store(tail + AlignUp(sizeof(uint32_t) + size32),
+                      std::memory_order_release);
+  return true;
+}
+}  // namespace base
+}  // namespace owt
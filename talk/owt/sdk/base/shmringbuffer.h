@@ -0,0 +1,64 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_SHMRINGBUFFER_H_
+#define OWT_BASE_SHMRINGBUFFER_H_
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#if defined(WEBRTC_WIN)
+#include <windows.h>
+#endif
+// Single-producer single-consumer ring buffer over a named shared
+// memory segment, carrying variable-size records between two processes
+// on one machine. The producer creates the segment and writes
+// length-prefixed records; the consumer opens it by name and reads them
+// in order. Head and tail are atomics in the mapped header, so a
+// record handover is two uncontended atomic operations and one memcpy
+// per side - no syscall, no lock. Writes never block: a record that
+// does not fit is dropped and counted, which is the right behavior for
+// a live media feed where the consumer is supposed to keep up.
+namespace owt {
+namespace base {
+class ShmRingBuffer {
+ public:
+  // Creates the named segment with |capacity| bytes of ring space and
+  // maps it as the producer. The segment is removed when the producer
+  // is destroyed. Returns null when the segment cannot be created.
+  static std::unique_ptr<ShmRingBuffer> Create(const std::string& name,
+                                               size_t capacity);
+  // Maps an existing segment as the consumer. Returns null when no
+  // segment with this name exists - which is also the authoritative
+  // same-machine check for the loopback negotiation.
+  static std::unique_ptr<ShmRingBuffer> Open(const std::string& name);
+  ~ShmRingBuffer();
+  // Appends one record. Returns false when the ring lacks space, in
+  // which case the record is dropped.
+  bool Write(const uint8_t* data, size_t size);
+  // Pops the oldest record into |record|. Returns false when the ring
+  // is empty.
+  bool Read(std::vector<uint8_t>* record);
+  // Records dropped by Write since creation; producer side only.
+  uint64_t dropped_records() const { return dropped_records_; }
+
+ private:
+  ShmRingBuffer();
+  bool Map(const std::string& name, size_t capacity, bool create);
+  struct Header;
+  Header* header_;
+  uint8_t* ring_;
+  size_t capacity_;
+  bool owner_;
+  std::string name_;
+  uint64_t dropped_records_;
+#if defined(WEBRTC_WIN)
+  HANDLE mapping_;
+#else
+  int fd_;
+  size_t mapped_size_;
+#endif
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_SHMRINGBUFFER_H_
@@ -0,0 +1,68 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "talk/owt/sdk/base/shmringbuffer.h"
+#include <cstring>
+#include <vector>
+#include "testing/gtest/include/gtest/gtest.h"
+namespace owt {
+namespace base {
+TEST(ShmRingBufferTest, RoundTripThroughSecondMapping) {
+  auto producer = ShmRingBuffer::Create("owt_shm_test_roundtrip", 4096);
+  ASSERT_TRUE(producer);
+  auto consumer = ShmRingBuffer::Open("owt_shm_test_roundtrip");
+  ASSERT_TRUE(consumer);
+  const uint8_t payload[] = {1, 2, 3, 4, 5};
+  EXPECT_TRUE(producer->Write(payload, sizeof(payload)));
+  std::vector<uint8_t> record;
+  ASSERT_TRUE(consumer->Read(&record));
+  ASSERT_EQ(record.size(), sizeof(payload));
+  EXPECT_EQ(memcmp(record.data(), payload, sizeof(payload)), 0);
+  EXPECT_FALSE(consumer->Read(&record));
+}
+TEST(ShmRingBufferTest, SurvivesManyWrapArounds) {
+  auto producer = ShmRingBuffer::Create("owt_shm_test_wrap", 1024);
+  ASSERT_TRUE(producer);
+  auto consumer = ShmRingBuffer::Open("owt_shm_test_wrap");
+  ASSERT_TRUE(consumer);
+  std::vector<uint8_t> record;
+  // Record sizes chosen so the ring wraps at varying offsets.
+  for (int i = 0; i < 5000; i++) {
+    uint8_t buf[130];
+    size_t size = 1 + (i * 37) % 128;
+    memset(buf, i & 0xFF, size);
+    ASSERT_TRUE(producer->Write(buf, size));
+    ASSERT_TRUE(consumer->Read(&record));
+    ASSERT_EQ(record.size(), size);
+    EXPECT_EQ(record[0], static_cast<uint8_t>(i & 0xFF));
+  }
+  EXPECT_EQ(producer->dropped_records(), 0u);
+}
+TEST(ShmRingBufferTest, DropsWhenFullAndDrainsWhatFit) {
+  auto producer = ShmRingBuffer::Create("owt_shm_test_full", 1024);
+  ASSERT_TRUE(producer);
+  auto consumer = ShmRingBuffer::Open("owt_shm_test_full");
+  ASSERT_TRUE(consumer);
+  uint8_t payload[200];
+  memset(payload, 0xCD, sizeof(payload));
+  int accepted = 0;
+  for (int i = 0; i < 50; i++) {
+    if (producer->Write(payload, sizeof(payload)))
+      accepted++;
+  }
+  EXPECT_LT(accepted, 50);
+  EXPECT_GT(producer->dropped_records(), 0u);
+  std::vector<uint8_t> record;
+  int drained = 0;
+  while (consumer->Read(&record)) {
+    EXPECT_EQ(record.size(), sizeof(payload));
+    drained++;
+  }
+  EXPECT_EQ(drained, accepted);
+}
+TEST(ShmRingBufferTest, OpenOfMissingSegmentFails) {
+  // This is the loopback negotiation's same-machine check.
+  EXPECT_FALSE(ShmRingBuffer::Open("owt_shm_test_missing"));
+}
+}  // namespace base
+}  // namespace owt
@@ -5,18 +5,24 @@
 #include "webrtc/media/base/videocapturer.h"
 #include "webrtc/media/engine/webrtcvideocapturerfactory.h"
 #include "webrtc/modules/video_capture/video_capture_factory.h"
+#if !defined(OWT_RECEIVE_ONLY)
 #include "webrtc/modules/desktop_capture/desktop_capture_options.h"
 #include "talk/owt/sdk/base/customizedframescapturer.h"
 #if defined(WEBRTC_WIN)
 #include "talk/owt/sdk/base/desktopcapturer.h"
 #endif
+#endif
 #include "talk/owt/sdk/base/mediaconstraintsimpl.h"
 #if defined(WEBRTC_IOS)
 #include "talk/owt/sdk/base/objc/ObjcVideoCapturerInterface.h"
 #endif
 #include "talk/owt/sdk/base/peerconnectiondependencyfactory.h"
+#include "talk/owt/sdk/base/roihint.h"
 #include "talk/owt/sdk/base/webrtcvideorendererimpl.h"
 #if defined(WEBRTC_WIN)
+#include "talk/owt/sdk/base/win/compositorrendererd3d11.h"
+#include "talk/owt/sdk/base/win/mfcameracapturer.h"
+#include "talk/owt/sdk/base/win/videorendererd3d11.h"
 #include "talk/owt/sdk/base/win/videorendererwin.h"
 #endif
 #include "talk/owt/sdk/include/cpp/owt/base/deviceutils.h"
@@ -30,6 +36,8 @@ Stream::Stream()
     : media_stream_(nullptr),
       renderer_impl_(nullptr),
       d3d9_renderer_impl_(nullptr),
+      d3d11_renderer_impl_(nullptr),
+      composited_sink_(nullptr),
       source_(AudioSourceInfo::kUnknown, VideoSourceInfo::kUnknown),
       ended_(false),
       id_("") {}
@@ -37,6 +45,8 @@ Stream::Stream(const std::string& id)
     : media_stream_(nullptr),
       renderer_impl_(nullptr),
       d3d9_renderer_impl_(nullptr),
+      d3d11_renderer_impl_(nullptr),
+      composited_sink_(nullptr),
       source_(AudioSourceInfo::kUnknown, VideoSourceInfo::kUnknown),
       ended_(false),
       id_(id) {}
@@ -61,6 +71,15 @@ MediaStreamInterface* Stream::MediaStream() const {
 }
 Stream::~Stream() {
   DetachVideoRenderer();
+  if (renderer_impl_ != nullptr) {
+    if (media_stream_ != nullptr) {
+      auto video_tracks = media_stream_->GetVideoTracks();
+      if (video_tracks.size() > 0)
+        video_tracks[0]->RemoveSink(renderer_impl_);
+    }
+    delete renderer_impl_;
+    renderer_impl_ = nullptr;
+  }
   if (media_stream_)
     media_stream_->Release();
 }
@@ -122,12 +141,18 @@ void Stream::AttachVideoRenderer(VideoRendererInterface& renderer){
     RTC_LOG(LS_WARNING) << "There are more than one video tracks, the first one "
                        "will be attachecd to renderer.";
   }
-  WebrtcVideoRendererImpl* old_renderer =
-      renderer_impl_ ? renderer_impl_ : nullptr;
-  renderer_impl_ = new WebrtcVideoRendererImpl(renderer);
+  // The sink and its buffer pool persist across attach/detach cycles;
+  // re-attaching on a layout change is a pointer swap inside the existing
+  // sink, so no frame is lost to a RemoveSink/AddSink gap and no
+  // conversion buffer is reallocated.
+  if (renderer_impl_ == nullptr) {
+    renderer_impl_ = new WebrtcVideoRendererImpl(renderer, Id());
+  } else {
+    renderer_impl_->SetRenderer(&renderer);
+  }
+  // Idempotent for an already registered sink; also covers the sink not
+  // yet being on this track after the media stream was replaced.
   video_tracks[0]->AddOrUpdateSink(renderer_impl_, rtc::VideoSinkWants());
-  if (old_renderer)
-    delete old_renderer;
   RTC_LOG(LS_INFO) << "Attached the stream to a renderer.";
 }
 #if defined(WEBRTC_WIN)
@@ -144,41 +169,75 @@ void Stream::AttachVideoRenderer(VideoRenderWindow& render_window) {
     RTC_LOG(LS_WARNING) << "There are more than one video tracks, the first one "
                        "will be attachecd to renderer.";
   }
-  WebrtcVideoRendererD3D9Impl* old_renderer =
-      d3d9_renderer_impl_ ? d3d9_renderer_impl_ : nullptr;
-  d3d9_renderer_impl_ =
-      new WebrtcVideoRendererD3D9Impl(render_window.GetWindowHandle());
-  video_tracks[0]->AddOrUpdateSink(d3d9_renderer_impl_, rtc::VideoSinkWants());
-  if (old_renderer)
-    delete old_renderer;
+  WebrtcVideoRendererD3D9Impl* old_d3d9_renderer = d3d9_renderer_impl_;
+  WebrtcVideoRendererD3D11Impl* old_d3d11_renderer = d3d11_renderer_impl_;
+  CompositedStreamSink* old_composited_sink = composited_sink_;
+  d3d9_renderer_impl_ = nullptr;
+  d3d11_renderer_impl_ = nullptr;
+  composited_sink_ = nullptr;
+  if (render_window.GetBackend() ==
+      VideoRenderWindow::Backend::kD3D11Composited) {
+    // All streams attached to this window handle share one compositor and
+    // one present per vsync.
+    composited_sink_ =
+        D3D11CompositorRenderer::GetForWindow(render_window.GetWindowHandle())
+            ->CreateSink();
+    video_tracks[0]->AddOrUpdateSink(composited_sink_, rtc::VideoSinkWants());
+  } else if (render_window.GetBackend() ==
+             VideoRenderWindow::Backend::kD3D11) {
+    d3d11_renderer_impl_ =
+        new WebrtcVideoRendererD3D11Impl(render_window.GetWindowHandle());
+    video_tracks[0]->AddOrUpdateSink(d3d11_renderer_impl_,
+                                     rtc::VideoSinkWants());
+  } else {
+    d3d9_renderer_impl_ =
+        new WebrtcVideoRendererD3D9Impl(render_window.GetWindowHandle());
+    video_tracks[0]->AddOrUpdateSink(d3d9_renderer_impl_,
+                                     rtc::VideoSinkWants());
+  }
+  if (old_d3d9_renderer)
+    delete old_d3d9_renderer;
+  if (old_d3d11_renderer)
+    delete old_d3d11_renderer;
+  if (old_composited_sink)
+    delete old_composited_sink;
   RTC_LOG(LS_INFO) << "Attached the stream to a renderer.";
 }
 #endif
 void Stream::DetachVideoRenderer() {
+  if (renderer_impl_ != nullptr) {
+    // The sink stays on the track and keeps its buffer pool warm; only
+    // the application pointer is cleared. Frames arriving while detached
+    // are dropped before conversion, and the next attach is a pointer
+    // swap. Full teardown happens when the stream is destroyed.
+    renderer_impl_->SetRenderer(nullptr);
+  }
 #if defined(WEBRTC_WIN)
+  // The window-backed renderers own their target surfaces, so those sinks
+  // are still torn down on detach.
   if (media_stream_ == nullptr ||
-      (renderer_impl_ == nullptr
-       && d3d9_renderer_impl_ == nullptr))
-    return;
-#else
-  if (media_stream_ == nullptr || renderer_impl_ == nullptr)
+      (d3d9_renderer_impl_ == nullptr
+       && d3d11_renderer_impl_ == nullptr
+       && composited_sink_ == nullptr))
     return;
-#endif
   auto video_tracks = media_stream_->GetVideoTracks();
   if(video_tracks.size() == 0)
     return;
-  // Detach from the first stream.
-  if (renderer_impl_ != nullptr) {
-    video_tracks[0]->RemoveSink(renderer_impl_);
-    delete renderer_impl_;
-    renderer_impl_ = nullptr;
-  }
-#if defined(WEBRTC_WIN)
   if (d3d9_renderer_impl_ != nullptr) {
     video_tracks[0]->RemoveSink(d3d9_renderer_impl_);
     delete d3d9_renderer_impl_;
     d3d9_renderer_impl_ = nullptr;
   }
+  if (d3d11_renderer_impl_ != nullptr) {
+    video_tracks[0]->RemoveSink(d3d11_renderer_impl_);
+    delete d3d11_renderer_impl_;
+    d3d11_renderer_impl_ = nullptr;
+  }
+  if (composited_sink_ != nullptr) {
+    video_tracks[0]->RemoveSink(composited_sink_);
+    delete composited_sink_;
+    composited_sink_ = nullptr;
+  }
 #endif
 }
 StreamSourceInfo Stream::Source() const {
@@ -329,7 +388,25 @@ LocalStream::LocalStream(
 #if !defined(WEBRTC_IOS)
     cricket::WebRtcVideoDeviceCapturerFactory factory;
     std::unique_ptr<cricket::VideoCapturer> capturer(nullptr);
-    if (!parameters.CameraId().empty()) {
+    bool native_capture = false;
+#if defined(WEBRTC_WIN)
+    if (!parameters.CameraId().empty() &&
+        GlobalConfiguration::GetD3D11CameraCaptureEnabled()) {
+      std::unique_ptr<MfCameraCapturer> mf_capturer = MfCameraCapturer::Create(
+          parameters.CameraId(), parameters.ResolutionWidth(),
+          parameters.ResolutionHeight(), parameters.Fps());
+      if (mf_capturer) {
+        mf_capturer->Init();
+        capturer = std::move(mf_capturer);
+        native_capture = true;
+      } else {
+        RTC_LOG(LS_WARNING)
+            << "D3D11 camera capture unavailable; falling back to system "
+               "memory capture.";
+      }
+    }
+#endif
+    if (!capturer && !parameters.CameraId().empty()) {
       // TODO(jianjun): When create capturer, we will compare ID first. If
       // failed, fallback to compare name. Comparing name is deprecated, remove
       // it when it is old enough.
@@ -343,34 +420,40 @@ LocalStream::LocalStream(
       error_code = static_cast<int>(ExceptionType::kLocalDeviceNotFound);
       return;
     }
-    // Check supported resolution
-    auto supported_resolution =
-        DeviceUtils::VideoCapturerSupportedResolutions(parameters.CameraId());
-    auto resolution_iterator = std::find(
-        supported_resolution.begin(), supported_resolution.end(),
-        Resolution(parameters.ResolutionWidth(), parameters.ResolutionHeight()));
-    if (resolution_iterator == supported_resolution.end()) {
-      RTC_LOG(LS_ERROR) << "Resolution " << parameters.ResolutionWidth() << "x"
-                    << parameters.ResolutionHeight()
-                    << " is not supported by video capturer "
-                    << parameters.CameraId();
-      error_code = static_cast<int>(ExceptionType::kLocalNotSupported);
-      return;
+    // Check supported resolution. The native capturer negotiated its exact
+    // mode with the device already, and constraint-driven adaptation cannot
+    // run on texture-backed frames, so both are skipped on that path.
+    if (!native_capture) {
+      auto supported_resolution =
+          DeviceUtils::VideoCapturerSupportedResolutions(parameters.CameraId());
+      auto resolution_iterator =
+          std::find(supported_resolution.begin(), supported_resolution.end(),
+                    Resolution(parameters.ResolutionWidth(),
+                               parameters.ResolutionHeight()));
+      if (resolution_iterator == supported_resolution.end()) {
+        RTC_LOG(LS_ERROR) << "Resolution " << parameters.ResolutionWidth()
+                          << "x" << parameters.ResolutionHeight()
+                          << " is not supported by video capturer "
+                          << parameters.CameraId();
+        error_code = static_cast<int>(ExceptionType::kLocalNotSupported);
+        return;
+      }
+      media_constraints_->SetMandatory(
+          webrtc::MediaConstraintsInterface::kMaxWidth,
+          std::to_string(parameters.ResolutionWidth()));
+      media_constraints_->SetMandatory(
+          webrtc::MediaConstraintsInterface::kMaxHeight,
+          std::to_string(parameters.ResolutionHeight()));
+      media_constraints_->SetMandatory(
+          webrtc::MediaConstraintsInterface::kMinWidth,
+          std::to_string(parameters.ResolutionWidth()));
+      media_constraints_->SetMandatory(
+          webrtc::MediaConstraintsInterface::kMinHeight,
+          std::to_string(parameters.ResolutionHeight()));
     }
-    media_constraints_->SetMandatory(
-        webrtc::MediaConstraintsInterface::kMaxWidth,
-        std::to_string(parameters.ResolutionWidth()));
-    media_constraints_->SetMandatory(
-        webrtc::MediaConstraintsInterface::kMaxHeight,
-        std::to_string(parameters.ResolutionHeight()));
-    media_constraints_->SetMandatory(
-        webrtc::MediaConstraintsInterface::kMinWidth,
-        std::to_string(parameters.ResolutionWidth()));
-    media_constraints_->SetMandatory(
-        webrtc::MediaConstraintsInterface::kMinHeight,
-        std::to_string(parameters.ResolutionHeight()));
     scoped_refptr<VideoTrackSourceInterface> source =
-        pcd_factory->CreateVideoSource(std::move(capturer), media_constraints_);
+        pcd_factory->CreateVideoSource(
+            std::move(capturer), native_capture ? nullptr : media_constraints_);
 #else
     capturer_ = ObjcVideoCapturerFactory::Create(parameters);
     if (!capturer_) {
@@ -423,6 +506,42 @@ void LocalStream::Close() {
   for (auto const& video_track : media_stream_->GetVideoTracks())
     media_stream_->RemoveTrack(video_track);
 }
+void LocalStream::ContentHint(VideoContentHint hint) {
+  RTC_CHECK(media_stream_);
+  webrtc::VideoTrackInterface::ContentHint track_hint =
+      webrtc::VideoTrackInterface::ContentHint::kNone;
+  switch (hint) {
+    case VideoContentHint::kMotion:
+      track_hint = webrtc::VideoTrackInterface::ContentHint::kFluid;
+      break;
+    case VideoContentHint::kDetail:
+      track_hint = webrtc::VideoTrackInterface::ContentHint::kDetailed;
+      break;
+    case VideoContentHint::kText:
+      track_hint = webrtc::VideoTrackInterface::ContentHint::kText;
+      break;
+    case VideoContentHint::kNone:
+      break;
+  }
+  for (auto const& video_track : media_stream_->GetVideoTracks())
+    video_track->set_content_hint(track_hint);
+}
+void LocalStream::SetRegionOfInterest(int left,
+                                      int top,
+                                      int right,
+                                      int bottom,
+                                      int quality_delta) {
+  RoiHint::Region region;
+  region.left = left;
+  region.top = top;
+  region.right = right;
+  region.bottom = bottom;
+  region.quality_delta = quality_delta;
+  RoiHint::Set(region);
+}
+void LocalStream::ClearRegionOfInterest() {
+  RoiHint::Clear();
+}
 #if defined(WEBRTC_WIN)
 LocalStream::LocalStream(
     std::shared_ptr<LocalDesktopStreamParameters> parameters,
@@ -436,6 +555,12 @@ LocalStream::LocalStream(
   Id(media_stream_id);
   scoped_refptr<MediaStreamInterface> stream =
       factory->CreateLocalMediaStream(media_stream_id);
+#if defined(OWT_RECEIVE_ONLY)
+  if (parameters->VideoEnabled()) {
+    RTC_LOG(LS_ERROR)
+        << "Screen capture is not compiled into this receive-only build.";
+  }
+#else
   std::unique_ptr<BasicDesktopCapturer> capturer(nullptr);
   if (parameters->VideoEnabled()) {
     webrtc::DesktopCaptureOptions options =
@@ -455,6 +580,7 @@ LocalStream::LocalStream(
         factory->CreateLocalVideoTrack(video_track_id, source);
     stream->AddTrack(video_track);
   }
+#endif
   if (parameters->AudioEnabled()) {
     std::string audio_track_id("AudioTrack-" + rtc::CreateRandomUuid());
     scoped_refptr<AudioTrackInterface> audio_track =
@@ -463,6 +589,9 @@ LocalStream::LocalStream(
   }
   media_stream_ = stream;
   media_stream_->AddRef();
+  // Screen content degrades into unreadable mush when resolution is
+  // dropped; default to preserving detail and let framerate give first.
+  ContentHint(VideoContentHint::kDetail);
 }
 #endif
 LocalStream::LocalStream(
@@ -478,6 +607,12 @@ LocalStream::LocalStream(
   Id(media_stream_id);
   scoped_refptr<MediaStreamInterface> stream =
       pcd_factory->CreateLocalMediaStream(media_stream_id);
+#if defined(OWT_RECEIVE_ONLY)
+  if (parameters->VideoEnabled()) {
+    RTC_LOG(LS_ERROR)
+        << "Video capture is not compiled into this receive-only build.";
+  }
+#else
   std::unique_ptr<CustomizedFramesCapturer> capturer(nullptr);
   if (parameters->VideoEnabled()) {
     capturer = std::unique_ptr<CustomizedFramesCapturer>(
@@ -490,6 +625,7 @@ LocalStream::LocalStream(
         pcd_factory->CreateLocalVideoTrack(video_track_id, source);
     stream->AddTrack(video_track);
   }
+#endif
   if (parameters->AudioEnabled()) {
     std::string audio_track_id("AudioTrack-" + rtc::CreateRandomUuid());
     scoped_refptr<AudioTrackInterface> audio_track =
@@ -498,6 +634,7 @@ LocalStream::LocalStream(
   }
   media_stream_ = stream;
   media_stream_->AddRef();
+  ContentHint(parameters->ContentHint());
 }
 LocalStream::LocalStream(
     std::shared_ptr<LocalCustomizedStreamParameters> parameters,
@@ -511,6 +648,12 @@ LocalStream::LocalStream(
   Id(media_stream_id);
   scoped_refptr<MediaStreamInterface> stream =
       pcd_factory->CreateLocalMediaStream(media_stream_id);
+#if defined(OWT_RECEIVE_ONLY)
+  if (parameters->VideoEnabled()) {
+    RTC_LOG(LS_ERROR)
+        << "Video capture is not compiled into this receive-only build.";
+  }
+#else
   std::unique_ptr<CustomizedFramesCapturer> capturer(nullptr);
   if (parameters->VideoEnabled()) {
     encoded_ = true;
@@ -528,6 +671,7 @@ LocalStream::LocalStream(
         pcd_factory->CreateLocalVideoTrack(video_track_id, source);
     stream->AddTrack(video_track);
   }
+#endif
   if (parameters->AudioEnabled()) {
     std::string audio_track_id("AudioTrack-" + rtc::CreateRandomUuid());
     scoped_refptr<AudioTrackInterface> audio_track =
@@ -536,6 +680,7 @@ LocalStream::LocalStream(
   }
   media_stream_ = stream;
   media_stream_->AddRef();
+  ContentHint(parameters->ContentHint());
 }
 RemoteStream::RemoteStream(MediaStreamInterface* media_stream,
                            const std::string& from)
@@ -555,6 +700,46 @@ RemoteStream::RemoteStream(const std::string& id, const std::string& from,
 std::string RemoteStream::Origin() {
   return origin_;
 }
+SubscriptionCapabilities RemoteStream::Capabilities() {
+  std::lock_guard<std::mutex> lock(capability_info_mutex_);
+  RunPendingCapabilityParse();
+  return subscription_capabilities_;
+}
+PublicationSettings RemoteStream::Settings() {
+  std::lock_guard<std::mutex> lock(capability_info_mutex_);
+  RunPendingCapabilityParse();
+  return publication_settings_;
+}
+void RemoteStream::Capabilities(
+    owt::base::SubscriptionCapabilities subscription_capabilities) {
+  std::lock_guard<std::mutex> lock(capability_info_mutex_);
+  // Settings may still be pending, so the parse cannot simply be dropped
+  // when one half is overwritten.
+  RunPendingCapabilityParse();
+  subscription_capabilities_ = subscription_capabilities;
+}
+void RemoteStream::Settings(PublicationSettings publication_settings) {
+  std::lock_guard<std::mutex> lock(capability_info_mutex_);
+  RunPendingCapabilityParse();
+  publication_settings_ = publication_settings;
+}
+void RemoteStream::RunPendingCapabilityParse() {
+  if (pending_capability_parser_ == nullptr) {
+    return;
+  }
+  std::function<void(RemoteStream&)> parser(
+      std::move(pending_capability_parser_));
+  pending_capability_parser_ = nullptr;
+  parser(*this);
+}
+void RemoteStream::AdoptCapabilityInfo(RemoteStream& other) {
+  // |other| is a freshly parsed stream that is not shared yet, so its
+  // members can be read without locking.
+  std::lock_guard<std::mutex> lock(capability_info_mutex_);
+  subscription_capabilities_ = other.subscription_capabilities_;
+  publication_settings_ = other.publication_settings_;
+  pending_capability_parser_ = std::move(other.pending_capability_parser_);
+}
 void RemoteStream::MediaStream(
     MediaStreamInterface* media_stream) {
   Stream::MediaStream(media_stream);
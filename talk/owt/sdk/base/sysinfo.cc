@@ -46,11 +46,14 @@ std::string SysInfo::OsVersion() {
   return std::string(info.release);
 }
 #endif  // WEBRTC_LINUX
-SysInfo SysInfo::GetInstance() {
-  SdkInfo sdk(SdkType(), kSdkVersion);
-  OsInfo os(OsName(), OsVersion());
-  RuntimeInfo runtime(kRuntimeName, kRuntimeVersion);
-  return SysInfo(sdk, os, runtime);
+const SysInfo& SysInfo::GetInstance() {
+  // Leaked on purpose so channels tearing down during static destruction
+  // can still read it.
+  static const SysInfo* instance =
+      new SysInfo(SdkInfo(SdkType(), kSdkVersion),
+                  OsInfo(OsName(), OsVersion()),
+                  RuntimeInfo(kRuntimeName, kRuntimeVersion));
+  return *instance;
 }
 SysInfo::SysInfo(const SdkInfo sdk_info,
                  const OsInfo os_info,
@@ -30,8 +30,10 @@ struct RuntimeInfo {
 /// System information.
 class SysInfo final{
  public:
-  /// Get system info.
-  static SysInfo GetInstance();
+  /// Get system info. The instance is built once and cached; OS name and
+  /// version cannot change while the process runs, and this is queried
+  /// for the user-agent block of every channel setup.
+  static const SysInfo& GetInstance();
   const SdkInfo sdk;
   const OsInfo os;
   const RuntimeInfo runtime;
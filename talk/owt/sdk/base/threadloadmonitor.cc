@@ -0,0 +1,164 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "talk/owt/sdk/base/threadloadmonitor.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include "webrtc/rtc_base/cpu_time.h"
+#include "webrtc/rtc_base/logging.h"
+#include "webrtc/rtc_base/thread.h"
+#include "webrtc/rtc_base/timeutils.h"
+namespace owt {
+namespace base {
+namespace {
+// One probe per watched thread per tick; matches the watchdog's tick so
+// both surfaces describe the same intervals.
+const int kTickIntervalMs = 500;
+// Weight of the newest probe in the smoothed queue delay.
+const double kLatencyAlpha = 0.2;
+// One watched thread. The tick thread posts the probe, the watched
+// thread runs OnMessage, and snapshots read the atomics; |last_cpu_ns_|
+// and |last_run_us_| are touched only from OnMessage on the watched
+// thread itself.
+class Probe : public rtc::MessageHandler {
+ public:
+  Probe(rtc::Thread* thread, const std::string& name)
+      : thread_(thread),
+        name_(name),
+        posted_at_us_(0),
+        last_latency_us_(0),
+        avg_latency_us_(0),
+        max_latency_us_(0),
+        utilization_permille_(-1),
+        last_cpu_ns_(-1),
+        last_run_us_(0) {}
+  void MaybePost() {
+    int64_t expected = 0;
+    // A probe still in flight means the thread has not drained the
+    // previous tick's message; posting another would only grow the
+    // backlog we are trying to measure.
+    if (!posted_at_us_.compare_exchange_strong(expected, rtc::TimeMicros(),
+                                               std::memory_order_relaxed)) {
+      return;
+    }
+    thread_->Post(RTC_FROM_HERE, this);
+  }
+  void OnMessage(rtc::Message* /*msg*/) override {
+    int64_t now_us = rtc::TimeMicros();
+    int64_t posted_us = posted_at_us_.exchange(0, std::memory_order_relaxed);
+    if (posted_us != 0) {
+      int64_t latency = now_us - posted_us;
+      last_latency_us_.store(latency, std::memory_order_relaxed);
+      int64_t avg = avg_latency_us_.load(std::memory_order_relaxed);
+      avg_latency_us_.store(
+          static_cast<int64_t>(avg + kLatencyAlpha * (latency - avg)),
+          std::memory_order_relaxed);
+      int64_t max = max_latency_us_.load(std::memory_order_relaxed);
+      if (latency > max) {
+        max_latency_us_.store(latency, std::memory_order_relaxed);
+      }
+    }
+    int64_t cpu_ns = rtc::GetThreadCpuTimeNanos();
+    if (cpu_ns >= 0 && last_cpu_ns_ >= 0 && now_us > last_run_us_) {
+      int64_t on_cpu_us = (cpu_ns - last_cpu_ns_) / 1000;
+      int64_t wall_us = now_us - last_run_us_;
+      int64_t permille = on_cpu_us * 1000 / wall_us;
+      if (permille > 1000) {
+        permille = 1000;
+      }
+      utilization_permille_.store(static_cast<int>(permille),
+                                  std::memory_order_relaxed);
+    }
+    last_cpu_ns_ = cpu_ns;
+    last_run_us_ = now_us;
+  }
+  ThreadLoadEntry Sample() {
+    ThreadLoadEntry entry;
+    entry.thread_name = name_;
+    int permille = utilization_permille_.load(std::memory_order_relaxed);
+    entry.utilization = permille < 0 ? -1.0 : permille / 1000.0;
+    entry.post_to_run_us = last_latency_us_.load(std::memory_order_relaxed);
+    entry.post_to_run_avg_us = avg_latency_us_.load(std::memory_order_relaxed);
+    // The worst delay resets each snapshot. A probe still queued is
+    // counted with its age so far, so saturation keeps the value
+    // growing between snapshots instead of freezing it.
+    int64_t max = max_latency_us_.exchange(0, std::memory_order_relaxed);
+    int64_t posted_us = posted_at_us_.load(std::memory_order_relaxed);
+    if (posted_us != 0) {
+      int64_t pending = rtc::TimeMicros() - posted_us;
+      if (pending > max) {
+        max = pending;
+      }
+    }
+    entry.post_to_run_max_us = max;
+    return entry;
+  }
+  const std::string& name() const { return name_; }
+
+ private:
+  rtc::Thread* thread_;
+  std::string name_;
+  std::atomic<int64_t> posted_at_us_;
+  std::atomic<int64_t> last_latency_us_;
+  std::atomic<int64_t> avg_latency_us_;
+  std::atomic<int64_t> max_latency_us_;
+  std::atomic<int> utilization_permille_;
+  int64_t last_cpu_ns_;
+  int64_t last_run_us_;
+};
+struct Registry {
+  Registry() : running(false) {}
+  std::mutex mutex;
+  std::vector<Probe*> probes;
+  bool running;
+  std::thread ticker;
+};
+Registry& GetRegistry() {
+  // Leaked on purpose; the watched threads outlive static destruction.
+  static Registry* registry = new Registry();
+  return *registry;
+}
+}  // namespace
+void ThreadLoadMonitor::TickLoop() {
+  Registry& registry = GetRegistry();
+  while (true) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(kTickIntervalMs));
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (Probe* probe : registry.probes) {
+      probe->MaybePost();
+    }
+  }
+}
+void ThreadLoadMonitor::Watch(rtc::Thread* thread, const std::string& name) {
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  int duplicates = 0;
+  for (Probe* probe : registry.probes) {
+    if (probe->name() == name ||
+        probe->name().compare(0, name.size() + 1, name + "#") == 0) {
+      duplicates++;
+    }
+  }
+  std::string unique_name =
+      duplicates == 0 ? name : name + "#" + std::to_string(duplicates + 1);
+  registry.probes.push_back(new Probe(thread, unique_name));
+  if (!registry.running) {
+    registry.running = true;
+    registry.ticker = std::thread(&ThreadLoadMonitor::TickLoop);
+    RTC_LOG(LS_INFO) << "Thread load monitor started.";
+  }
+}
+std::vector<ThreadLoadEntry> ThreadLoadMonitor::Snapshot() {
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  std::vector<ThreadLoadEntry> entries;
+  entries.reserve(registry.probes.size());
+  for (Probe* probe : registry.probes) {
+    entries.push_back(probe->Sample());
+  }
+  return entries;
+}
+}  // namespace base
+}  // namespace owt
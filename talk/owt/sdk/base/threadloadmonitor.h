@@ -0,0 +1,40 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_THREADLOADMONITOR_H_
+#define OWT_BASE_THREADLOADMONITOR_H_
+#include <string>
+#include <vector>
+#include "talk/owt/sdk/include/cpp/owt/base/threadstats.h"
+namespace rtc {
+class Thread;
+}
+// Load sampling for the factory's signaling/worker/network threads.
+// When Publish latency spikes, queue depths and stall reports tell us
+// that something is slow but not which thread is saturated. The monitor
+// posts one probe task to each watched thread per tick; the probe
+// measures its own queue delay - the same delay every Bind invoke and
+// posted callback on that thread experiences - and reads the thread's
+// CPU time, from which utilization over the interval follows. At most
+// one probe per thread is in flight, so a wedged thread accumulates one
+// pending message rather than a backlog, and its saturation shows up as
+// the pending probe's growing age. Cost is one no-op task per thread
+// per half second; clients pull samples through GetThreadLoadStats.
+namespace owt {
+namespace base {
+class ThreadLoadMonitor {
+ public:
+  // Starts probing |thread| under |name|; the first watch starts the
+  // monitor's tick thread. |thread| must outlive the process's use of
+  // the monitor; the factory's threads are never destroyed. A duplicate
+  // name gets a "#<n>" suffix so pool members stay distinguishable.
+  static void Watch(rtc::Thread* thread, const std::string& name);
+  // Returns the latest sample for every watched thread.
+  static std::vector<ThreadLoadEntry> Snapshot();
+
+ private:
+  static void TickLoop();
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_THREADLOADMONITOR_H_
@@ -0,0 +1,148 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "talk/owt/sdk/base/threadwatchdog.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "talk/owt/sdk/base/eventjournal.h"
+#include "talk/owt/sdk/base/tracelog.h"
+#include "webrtc/rtc_base/logging.h"
+namespace owt {
+namespace base {
+namespace {
+// How often the monitor scans the handles. Stall thresholds are rounded
+// up to a multiple of this.
+const int kTickIntervalMs = 500;
+struct Registry {
+  Registry() : stall_ticks(0), running(false) {}
+  std::mutex mutex;
+  std::vector<ThreadWatchdog::Handle*> handles;
+  ThreadWatchdog::StallCallback callback;
+  int stall_ticks;
+  bool running;
+  std::thread monitor;
+  std::condition_variable wake;
+};
+Registry& GetRegistry() {
+  // Leaked on purpose; check-ins may run during static destruction of
+  // other objects.
+  static Registry* registry = new Registry();
+  return *registry;
+}
+}  // namespace
+void ThreadWatchdog::MonitorLoop() {
+  Registry& registry = GetRegistry();
+  std::unique_lock<std::mutex> lock(registry.mutex);
+  while (registry.running) {
+    registry.wake.wait_for(lock, std::chrono::milliseconds(kTickIntervalMs));
+    if (!registry.running) {
+      break;
+    }
+    std::vector<ThreadWatchdog::StallReport> reports;
+    for (ThreadWatchdog::Handle* handle : registry.handles) {
+      uint64_t sequence = handle->sequence_.load(std::memory_order_relaxed);
+      bool active = handle->active_.load(std::memory_order_relaxed);
+      if (active && sequence == handle->last_seen_sequence_) {
+        handle->stalled_ticks_++;
+        if (handle->stalled_ticks_ >= registry.stall_ticks &&
+            !handle->reported_) {
+          handle->reported_ = true;
+          ThreadWatchdog::StallReport report;
+          report.thread_name = handle->name_;
+          const char* label = handle->label_.load(std::memory_order_relaxed);
+          report.section = label != nullptr ? label : "";
+          report.stalled_ms = handle->stalled_ticks_ * kTickIntervalMs;
+          reports.push_back(report);
+        }
+      } else {
+        handle->stalled_ticks_ = 0;
+        handle->reported_ = false;
+      }
+      handle->last_seen_sequence_ = sequence;
+    }
+    if (reports.empty()) {
+      continue;
+    }
+    ThreadWatchdog::StallCallback callback = registry.callback;
+    // Reported outside the lock so the callback may register threads or
+    // stop the watchdog.
+    lock.unlock();
+    for (const ThreadWatchdog::StallReport& report : reports) {
+      RTC_LOG(LS_ERROR) << "Thread " << report.thread_name
+                        << " has made no progress for " << report.stalled_ms
+                        << "ms inside " << report.section;
+      EventJournal::Append(EventJournal::kThreadStall, report.stalled_ms,
+                           report.thread_name.c_str());
+      OWT_TRACE_INSTANT("ThreadWatchdog.Stall");
+      if (callback) {
+        callback(report);
+      }
+    }
+    lock.lock();
+  }
+}
+ThreadWatchdog::Handle::Handle(const std::string& name)
+    : name_(name),
+      sequence_(0),
+      active_(false),
+      label_(nullptr),
+      last_seen_sequence_(0),
+      stalled_ticks_(0),
+      reported_(false) {}
+ThreadWatchdog::Handle* ThreadWatchdog::Register(const std::string& name) {
+  Registry& registry = GetRegistry();
+  Handle* handle = new Handle(name);
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.handles.push_back(handle);
+  return handle;
+}
+void ThreadWatchdog::Unregister(Handle* handle) {
+  if (handle == nullptr) {
+    return;
+  }
+  Registry& registry = GetRegistry();
+  {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto it = registry.handles.begin(); it != registry.handles.end();
+         ++it) {
+      if (*it == handle) {
+        registry.handles.erase(it);
+        break;
+      }
+    }
+  }
+  delete handle;
+}
+void ThreadWatchdog::Start(int stall_threshold_ms, StallCallback callback) {
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.callback = std::move(callback);
+  registry.stall_ticks =
+      (stall_threshold_ms + kTickIntervalMs - 1) / kTickIntervalMs;
+  if (registry.stall_ticks < 1) {
+    registry.stall_ticks = 1;
+  }
+  if (!registry.running) {
+    registry.running = true;
+    registry.monitor = std::thread(MonitorLoop);
+  }
+}
+void ThreadWatchdog::Stop() {
+  Registry& registry = GetRegistry();
+  std::thread monitor;
+  {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (!registry.running) {
+      return;
+    }
+    registry.running = false;
+    registry.wake.notify_all();
+    monitor = std::move(registry.monitor);
+  }
+  monitor.join();
+}
+}  // namespace base
+}  // namespace owt
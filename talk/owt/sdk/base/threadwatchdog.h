@@ -0,0 +1,103 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_THREADWATCHDOG_H_
+#define OWT_BASE_THREADWATCHDOG_H_
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+// Stall detection for the codec and signaling threads. A registered
+// thread wraps each unit of work in a ScopedWatchdogSection: entry bumps
+// a wait-free sequence counter and records the section label, exit
+// clears the active flag, so check-ins are cheap enough to stay on in
+// production. A monitor thread ticks at a fixed interval and compares
+// each handle's counter against the value it saw on the previous tick -
+// constant work per handle per tick. A handle that sits inside one
+// section without progressing for the stall threshold is reported once
+// per stall through a callback carrying the thread name, the section
+// label and how long the stall has lasted; the stall is also recorded
+// in the event journal and, when tracing is compiled in, as a trace
+// instant, so it survives a subsequent crash and shows up in captures.
+// Walking another thread's stack portably needs platform debug APIs, so
+// the section label stands in for a stack: it names the last checkpoint
+// the wedged thread passed.
+namespace owt {
+namespace base {
+class ThreadWatchdog {
+ public:
+  // One registered thread. Only the owning thread calls CheckIn and
+  // CheckOut; the monitor reads the counters with relaxed loads.
+  class Handle {
+   public:
+    // Marks the start of one unit of work. |label| must be a string
+    // literal; the pointer is stored, not the contents.
+    void CheckIn(const char* label) {
+      label_.store(label, std::memory_order_relaxed);
+      sequence_.fetch_add(1, std::memory_order_relaxed);
+      active_.store(true, std::memory_order_relaxed);
+    }
+    // Marks the end of the unit of work; an idle thread is never
+    // considered stalled.
+    void CheckOut() { active_.store(false, std::memory_order_relaxed); }
+
+   private:
+    friend class ThreadWatchdog;
+    explicit Handle(const std::string& name);
+    std::string name_;
+    std::atomic<uint64_t> sequence_;
+    std::atomic<bool> active_;
+    std::atomic<const char*> label_;
+    // Monitor-side state, touched only on the monitor thread.
+    uint64_t last_seen_sequence_;
+    int stalled_ticks_;
+    bool reported_;
+  };
+  struct StallReport {
+    // Name the thread registered under.
+    std::string thread_name;
+    // Label of the section the thread has not left; the last checkpoint
+    // it is known to have passed.
+    std::string section;
+    // Lower bound on how long the thread has made no progress.
+    int stalled_ms;
+  };
+  using StallCallback = std::function<void(const StallReport&)>;
+  // Registers a thread under |name|. The handle stays valid until
+  // Unregister; a handle that is never unregistered is reclaimed at
+  // process exit.
+  static Handle* Register(const std::string& name);
+  static void Unregister(Handle* handle);
+  // Starts the monitor. A handle inside one section for
+  // |stall_threshold_ms| without a check-in is reported; detection
+  // granularity is the internal tick interval. Restarting replaces the
+  // callback and threshold.
+  static void Start(int stall_threshold_ms, StallCallback callback);
+  // Stops the monitor thread; handles stay registered.
+  static void Stop();
+
+ private:
+  static void MonitorLoop();
+};
+// Brackets one unit of work on a registered thread. Null handles are
+// ignored so call sites need no registration check.
+class ScopedWatchdogSection {
+ public:
+  ScopedWatchdogSection(ThreadWatchdog::Handle* handle, const char* label)
+      : handle_(handle) {
+    if (handle_ != nullptr) {
+      handle_->CheckIn(label);
+    }
+  }
+  ~ScopedWatchdogSection() {
+    if (handle_ != nullptr) {
+      handle_->CheckOut();
+    }
+  }
+
+ private:
+  ThreadWatchdog::Handle* handle_;
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_THREADWATCHDOG_H_
@@ -0,0 +1,135 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "talk/owt/sdk/base/tracelog.h"
+#include "webrtc/rtc_base/logging.h"
+#include "webrtc/rtc_base/platform_thread_types.h"
+#include "webrtc/rtc_base/timeutils.h"
+namespace owt {
+namespace base {
+namespace {
+// Events kept per thread; the newest events overwrite the oldest once
+// the ring is full, so a capture always holds the most recent activity.
+const size_t kRingCapacity = 4096;
+struct TraceEvent {
+  const char* name;
+  int64_t timestamp_us;
+  int64_t duration_us;
+  char phase;  // 'X' for complete, 'i' for instant.
+};
+struct ThreadRing {
+  ThreadRing() : next(0), wrapped(false), tid(rtc::CurrentThreadId()) {
+    events.resize(kRingCapacity);
+  }
+  // Guards the ring against the exporting thread; uncontended in steady
+  // state since each ring has a single writer.
+  std::mutex mutex;
+  std::vector<TraceEvent> events;
+  size_t next;
+  bool wrapped;
+  rtc::PlatformThreadId tid;
+};
+struct TraceState {
+  std::atomic<bool> enabled;
+  std::mutex rings_mutex;
+  std::vector<std::shared_ptr<ThreadRing>> rings;
+  TraceState() : enabled(false) {}
+};
+TraceState& State() {
+  // Leaked on purpose; instrumented threads may record during shutdown.
+  static TraceState* state = new TraceState();
+  return *state;
+}
+ThreadRing& CurrentRing() {
+  static thread_local std::shared_ptr<ThreadRing> ring;
+  if (!ring) {
+    ring.reset(new ThreadRing());
+    TraceState& state = State();
+    std::lock_guard<std::mutex> lock(state.rings_mutex);
+    state.rings.push_back(ring);
+  }
+  return *ring;
+}
+void Record(const char* name,
+            char phase,
+            int64_t timestamp_us,
+            int64_t duration_us) {
+  ThreadRing& ring = CurrentRing();
+  std::lock_guard<std::mutex> lock(ring.mutex);
+  TraceEvent& event = ring.events[ring.next];
+  event.name = name;
+  event.timestamp_us = timestamp_us;
+  event.duration_us = duration_us;
+  event.phase = phase;
+  ring.next++;
+  if (ring.next == kRingCapacity) {
+    ring.next = 0;
+    ring.wrapped = true;
+  }
+}
+}  // namespace
+void TraceLog::SetEnabled(bool enabled) {
+  State().enabled.store(enabled);
+}
+bool TraceLog::Enabled() {
+  return State().enabled.load(std::memory_order_relaxed);
+}
+void TraceLog::RecordInstant(const char* name) {
+  if (!Enabled())
+    return;
+  Record(name, 'i', rtc::TimeMicros(), 0);
+}
+void TraceLog::RecordComplete(const char* name,
+                              int64_t start_us,
+                              int64_t duration_us) {
+  if (!Enabled())
+    return;
+  Record(name, 'X', start_us, duration_us);
+}
+bool TraceLog::ExportToFile(const std::string& path) {
+  std::ofstream file(path.c_str(), std::ios::out | std::ios::trunc);
+  if (!file.is_open()) {
+    RTC_LOG(LS_ERROR) << "Cannot open trace file: " << path;
+    return false;
+  }
+  TraceState& state = State();
+  file << "{\"traceEvents\":[";
+  bool first = true;
+  std::lock_guard<std::mutex> rings_lock(state.rings_mutex);
+  for (auto& ring : state.rings) {
+    std::lock_guard<std::mutex> lock(ring->mutex);
+    size_t count = ring->wrapped ? kRingCapacity : ring->next;
+    size_t start = ring->wrapped ? ring->next : 0;
+    for (size_t i = 0; i < count; i++) {
+      const TraceEvent& event =
+          ring->events[(start + i) % kRingCapacity];
+      if (!first)
+        file << ",";
+      first = false;
+      file << "{\"name\":\"" << event.name << "\",\"cat\":\"owt\",\"ph\":\""
+           << event.phase << "\",\"ts\":" << event.timestamp_us
+           << ",\"pid\":1,\"tid\":" << ring->tid;
+      if (event.phase == 'X')
+        file << ",\"dur\":" << event.duration_us;
+      file << "}";
+    }
+  }
+  file << "]}";
+  return file.good();
+}
+ScopedTraceEvent::ScopedTraceEvent(const char* name)
+    : name_(name), start_us_(TraceLog::Enabled() ? rtc::TimeMicros() : 0) {}
+ScopedTraceEvent::~ScopedTraceEvent() {
+  if (start_us_ != 0) {
+    TraceLog::RecordComplete(name_, start_us_,
+                             rtc::TimeMicros() - start_us_);
+  }
+}
+}  // namespace base
+}  // namespace owt
@@ -0,0 +1,58 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_TRACELOG_H_
+#define OWT_BASE_TRACELOG_H_
+#include <cstdint>
+#include <string>
+// Hot-path trace event collection. Events go into fixed-size per-thread
+// ring buffers and can be exported in chrome://tracing JSON format, so
+// cross-thread latency spikes can be inspected in the tracing UI instead
+// of with ad-hoc printf timing.
+//
+// The instrumentation macros are compiled out unless the SDK is built
+// with owt_enable_trace=true (gn arg), so default builds pay nothing on
+// the instrumented paths. When compiled in, recording is additionally
+// gated on GlobalConfiguration::SetTraceLogEnabled. Event names must be
+// string literals; the ring stores the pointer, not a copy.
+namespace owt {
+namespace base {
+class TraceLog {
+ public:
+  // Turns recording on or off. Buffers are kept across disable/enable so
+  // a capture can be stopped and exported afterwards.
+  static void SetEnabled(bool enabled);
+  static bool Enabled();
+  // Records a zero-duration event on the current thread.
+  static void RecordInstant(const char* name);
+  // Records a complete event of |duration_us| that started at |start_us|.
+  static void RecordComplete(const char* name,
+                             int64_t start_us,
+                             int64_t duration_us);
+  // Writes all buffered events to |path| as chrome://tracing JSON.
+  // Returns false when the file cannot be written.
+  static bool ExportToFile(const std::string& path);
+};
+// Emits one complete event spanning the enclosing scope.
+class ScopedTraceEvent {
+ public:
+  explicit ScopedTraceEvent(const char* name);
+  ~ScopedTraceEvent();
+
+ private:
+  const char* name_;
+  int64_t start_us_;
+};
+}  // namespace base
+}  // namespace owt
+#if defined(OWT_TRACE_ENABLED)
+#define OWT_TRACE_CONCAT_IMPL(a, b) a##b
+#define OWT_TRACE_CONCAT(a, b) OWT_TRACE_CONCAT_IMPL(a, b)
+#define OWT_TRACE_SCOPE(name) \
+  owt::base::ScopedTraceEvent OWT_TRACE_CONCAT(owt_trace_scope_, __LINE__)(name)
+#define OWT_TRACE_INSTANT(name) owt::base::TraceLog::RecordInstant(name)
+#else
+#define OWT_TRACE_SCOPE(name)
+#define OWT_TRACE_INSTANT(name)
+#endif
+#endif  // OWT_BASE_TRACELOG_H_
@@ -0,0 +1,98 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include <algorithm>
+#include <atomic>
+#include "talk/owt/sdk/base/videofreezedetector.h"
+#include "webrtc/rtc_base/timeutils.h"
+namespace owt {
+namespace base {
+namespace {
+// Bucket upper bounds with unit of millisecond; gaps above the last
+// bound land in the overflow bucket. 33 and 66 separate one and two
+// dropped intervals at 30 fps from real stalls.
+const int64_t kGapBoundsMs[] = {16, 33, 66, 100, 200, 500, 1000};
+// A gap this long is a stall the user can see. Overridable through
+// GlobalConfiguration::SetVideoFreezeThreshold.
+const int kDefaultFreezeThresholdMs = 500;
+std::atomic<int> freeze_threshold_ms(kDefaultFreezeThresholdMs);
+struct Registry {
+  std::mutex mutex;
+  std::vector<VideoFreezeDetector*> detectors;
+};
+Registry& GetRegistry() {
+  // Leaked on purpose; detectors inside codec instances may be destroyed
+  // during static destruction of other objects.
+  static Registry* registry = new Registry();
+  return *registry;
+}
+}  // namespace
+VideoFreezeDetector::VideoFreezeDetector(const std::string& stream_id,
+                                         const std::string& stage)
+    : stream_id_(stream_id),
+      stage_(stage),
+      last_frame_ms_(0),
+      freeze_count_(0),
+      max_gap_ms_(0) {
+  static_assert(
+      sizeof(kGapBoundsMs) / sizeof(kGapBoundsMs[0]) == kBucketCount - 1,
+      "Bucket bounds must leave exactly one overflow bucket.");
+  std::fill(gap_counts_, gap_counts_ + kBucketCount, 0);
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.detectors.push_back(this);
+}
+VideoFreezeDetector::~VideoFreezeDetector() {
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.detectors.erase(std::remove(registry.detectors.begin(),
+                                       registry.detectors.end(), this),
+                           registry.detectors.end());
+}
+void VideoFreezeDetector::RecordFrame() {
+  int64_t now_ms = rtc::TimeMillis();
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (last_frame_ms_ != 0) {
+    int64_t gap_ms = now_ms - last_frame_ms_;
+    int bucket = 0;
+    while (bucket < kBucketCount - 1 && gap_ms > kGapBoundsMs[bucket]) {
+      bucket++;
+    }
+    gap_counts_[bucket]++;
+    if (gap_ms >= freeze_threshold_ms.load(std::memory_order_relaxed)) {
+      freeze_count_++;
+    }
+    max_gap_ms_ = std::max(max_gap_ms_, gap_ms);
+  }
+  last_frame_ms_ = now_ms;
+}
+VideoFreezeReport VideoFreezeDetector::Report() const {
+  VideoFreezeReport report;
+  report.stage = stage_;
+  report.stream_id = stream_id_;
+  report.gap_bounds_ms.assign(kGapBoundsMs, kGapBoundsMs + kBucketCount - 1);
+  std::lock_guard<std::mutex> lock(mutex_);
+  report.gap_counts.assign(gap_counts_, gap_counts_ + kBucketCount);
+  report.freeze_count = freeze_count_;
+  report.max_gap_ms = max_gap_ms_;
+  return report;
+}
+std::vector<VideoFreezeReport> VideoFreezeDetector::ReportsForStream(
+    const std::string& stream_id) {
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  std::vector<VideoFreezeReport> reports;
+  for (VideoFreezeDetector* detector : registry.detectors) {
+    if (detector->stream_id_.empty() || detector->stream_id_ == stream_id) {
+      reports.push_back(detector->Report());
+    }
+  }
+  return reports;
+}
+void VideoFreezeDetector::SetFreezeThreshold(int threshold_ms) {
+  freeze_threshold_ms.store(
+      threshold_ms > 0 ? threshold_ms : kDefaultFreezeThresholdMs,
+      std::memory_order_relaxed);
+}
+}  // namespace base
+}  // namespace owt
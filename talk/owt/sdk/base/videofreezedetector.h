@@ -0,0 +1,50 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_VIDEOFREEZEDETECTOR_H_
+#define OWT_BASE_VIDEOFREEZEDETECTOR_H_
+#include <mutex>
+#include <string>
+#include <vector>
+#include "talk/owt/sdk/include/cpp/owt/base/connectionstats.h"
+namespace owt {
+namespace base {
+// Measures inter-frame gaps at one point of a receive pipeline and keeps
+// them in a fixed-bucket histogram, counting gaps at or above the freeze
+// threshold as freeze events. One detector lives inside each measuring
+// site (the renderer sink, the hardware decoder); recording is a clock
+// read and a bucket increment under an uncontended mutex. A process-wide
+// registry lets a session's stats collection pick up the reports for its
+// stream.
+class VideoFreezeDetector {
+ public:
+  // |stream_id| may be empty when the site cannot be tied to one stream;
+  // its report then appears in every session's statistics.
+  VideoFreezeDetector(const std::string& stream_id, const std::string& stage);
+  ~VideoFreezeDetector();
+  // Called once per delivered frame on the delivering thread.
+  void RecordFrame();
+  // Reports of all detectors matching |stream_id|, plus the ones not
+  // tied to any stream.
+  static std::vector<VideoFreezeReport> ReportsForStream(
+      const std::string& stream_id);
+  // Gap length at or above which a gap counts as a freeze event, with
+  // unit of millisecond. Applies to gaps recorded after the call; pass
+  // zero or a negative value to restore the default.
+  static void SetFreezeThreshold(int threshold_ms);
+
+ private:
+  // Seven bounded buckets plus the overflow bucket.
+  static const int kBucketCount = 8;
+  VideoFreezeReport Report() const;
+  const std::string stream_id_;
+  const std::string stage_;
+  mutable std::mutex mutex_;
+  int64_t last_frame_ms_;
+  int64_t gap_counts_[kBucketCount];
+  int64_t freeze_count_;
+  int64_t max_gap_ms_;
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_VIDEOFREEZEDETECTOR_H_
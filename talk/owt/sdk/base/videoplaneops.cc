@@ -0,0 +1,101 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "talk/owt/sdk/base/videoplaneops.h"
+#include <string.h>
+#include "webrtc/typedefs.h"
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+#include <emmintrin.h>
+#endif
+namespace owt {
+namespace base {
+namespace {
+// Streaming stores pay off only when the copied data is too large to
+// have stayed cached for the consumer anyway; below this a plain memcpy
+// wins because the destination is read back out of cache.
+const size_t kStreamingCopyBytes = 512 * 1024;
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+// Copies |size| bytes with non-temporal stores. The unaligned head and
+// the sub-block tail fall back to memcpy; everything in between moves in
+// 64-byte blocks that bypass the cache hierarchy.
+void StreamingCopy(uint8_t* dst, const uint8_t* src, size_t size) {
+  size_t head = (16 - (reinterpret_cast<uintptr_t>(dst) & 15)) & 15;
+  if (head > 0) {
+    if (head > size)
+      head = size;
+    memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    size -= head;
+  }
+  size_t blocks = size / 64;
+  for (size_t i = 0; i < blocks; i++) {
+    __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+    __m128i b2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+    __m128i b3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 48));
+    _mm_stream_si128(reinterpret_cast<__m128i*>(dst), b0);
+    _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 16), b1);
+    _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 32), b2);
+    _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 48), b3);
+    src += 64;
+    dst += 64;
+  }
+  // Make the streamed bytes visible before any other thread is handed
+  // the buffer.
+  _mm_sfence();
+  size -= blocks * 64;
+  if (size > 0) {
+    memcpy(dst, src, size);
+  }
+}
+#endif
+}  // namespace
+void CopyVideoBuffer(uint8_t* dst, const uint8_t* src, size_t size) {
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (size >= kStreamingCopyBytes) {
+    StreamingCopy(dst, src, size);
+    return;
+  }
+#endif
+  memcpy(dst, src, size);
+}
+void CopyVideoPlane(uint8_t* dst,
+                    int dst_stride,
+                    const uint8_t* src,
+                    int src_stride,
+                    int width,
+                    int height) {
+  if (dst_stride == width && src_stride == width) {
+    CopyVideoBuffer(dst, src, static_cast<size_t>(width) * height);
+    return;
+  }
+  for (int y = 0; y < height; y++) {
+    memcpy(dst, src, width);
+    dst += dst_stride;
+    src += src_stride;
+  }
+}
+void PackI420Frame(uint8_t* dst,
+                   int width,
+                   int height,
+                   const uint8_t* src_y,
+                   int stride_y,
+                   const uint8_t* src_u,
+                   int stride_u,
+                   const uint8_t* src_v,
+                   int stride_v) {
+  int chroma_width = (width + 1) / 2;
+  int chroma_height = (height + 1) / 2;
+  uint8_t* dst_y = dst;
+  uint8_t* dst_u = dst_y + static_cast<size_t>(width) * height;
+  uint8_t* dst_v =
+      dst_u + static_cast<size_t>(chroma_width) * chroma_height;
+  CopyVideoPlane(dst_y, width, src_y, stride_y, width, height);
+  CopyVideoPlane(dst_u, chroma_width, src_u, stride_u, chroma_width,
+                 chroma_height);
+  CopyVideoPlane(dst_v, chroma_width, src_v, stride_v, chroma_width,
+                 chroma_height);
+}
+}  // namespace base
+}  // namespace owt
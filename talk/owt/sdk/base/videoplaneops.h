@@ -0,0 +1,41 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_VIDEOPLANEOPS_H_
+#define OWT_BASE_VIDEOPLANEOPS_H_
+#include "webrtc/rtc_base/basictypes.h"
+namespace owt {
+namespace base {
+// Bulk copy helpers for frame-sized memory. Small copies go through
+// memcpy; on x86 a copy past the streaming threshold uses non-temporal
+// stores instead, so moving a full frame does not evict the working set
+// of the capture, encode or decode thread doing it. The copied bytes land
+// in memory, not cache, which is the right trade exactly when the copy is
+// larger than what the consumer could have kept cached anyway.
+// Copies |size| bytes from |src| to |dst|. The regions must not overlap.
+void CopyVideoBuffer(uint8_t* dst, const uint8_t* src, size_t size);
+// Copies a |width| x |height| pixel plane honoring the source and
+// destination strides. When both strides equal |width| the plane is
+// copied as one contiguous block through CopyVideoBuffer's dispatch.
+void CopyVideoPlane(uint8_t* dst,
+                    int dst_stride,
+                    const uint8_t* src,
+                    int src_stride,
+                    int width,
+                    int height);
+// Packs an I420 frame into a contiguous |dst| buffer laid out Y then U
+// then V with no stride padding, the layout handed to application
+// renderers. |dst| must hold width * height * 3 / 2 bytes (with chroma
+// dimensions rounded up for odd sizes).
+void PackI420Frame(uint8_t* dst,
+                   int width,
+                   int height,
+                   const uint8_t* src_y,
+                   int stride_y,
+                   const uint8_t* src_u,
+                   int stride_u,
+                   const uint8_t* src_v,
+                   int stride_v);
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_VIDEOPLANEOPS_H_
@@ -9,39 +9,238 @@
 #include <d3d9.h>
 #include <dxva2api.h>
 #endif
+#include "talk/owt/sdk/base/lowlatencymode.h"
+#include "talk/owt/sdk/base/pipelinelatencytracer.h"
+#include "talk/owt/sdk/base/queuedepthgauges.h"
+#include "talk/owt/sdk/base/videoplaneops.h"
 #include "talk/owt/sdk/base/webrtcvideorendererimpl.h"
 #if defined(WEBRTC_WIN)
 #include "talk/owt/sdk/base/win/d3dnativeframe.h"
 #endif
+#include "talk/owt/sdk/include/cpp/owt/base/globalconfiguration.h"
 #include "webrtc/common_video/libyuv/include/webrtc_libyuv.h"
 #include "webrtc/media/base/videocommon.h"
+#include "webrtc/rtc_base/logging.h"
 namespace owt {
 namespace base {
+// A RenderFrame call running longer than this is counted late; it is one
+// frame interval at 30 fps.
+static const int64_t kLateRenderThresholdMs = 33;
+VideoBufferPool::~VideoBufferPool() {
+  for (uint8_t* buffer : free_buffers_) {
+    delete[] buffer;
+  }
+}
+
+uint8_t* VideoBufferPool::Acquire(size_t size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (size != buffer_size_) {
+    for (uint8_t* buffer : free_buffers_) {
+      delete[] buffer;
+    }
+    free_buffers_.clear();
+    buffer_size_ = size;
+  }
+  if (!free_buffers_.empty()) {
+    uint8_t* buffer = free_buffers_.back();
+    free_buffers_.pop_back();
+    return buffer;
+  }
+  return new uint8_t[size];
+}
+
+void VideoBufferPool::Recycle(uint8_t* buffer, size_t size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Drop buffers from before a geometry change, and cap the pool so a
+  // burst of frames held by the application does not pin memory forever.
+  if (size != buffer_size_ || free_buffers_.size() >= kMaxPooledBuffers) {
+    delete[] buffer;
+    return;
+  }
+  free_buffers_.push_back(buffer);
+}
+
+WebrtcVideoRendererImpl::WebrtcVideoRendererImpl(
+    VideoRendererInterface& renderer,
+    const std::string& stream_id)
+    : renderer_(&renderer),
+      renders_in_flight_(0),
+      buffer_pool_(new VideoBufferPool()),
+      mailbox_enabled_(GlobalConfiguration::GetLatestFrameRenderingEnabled() ||
+                       LowLatencyMode::Active()),
+      mailbox_gauge_("renderer." + stream_id + ".mailbox_depth"),
+      freeze_detector_(stream_id, "render"),
+      delivery_stopped_(false),
+      dropped_frames_(0),
+      late_frames_(0) {
+  if (mailbox_enabled_)
+    delivery_thread_ = std::thread(&WebrtcVideoRendererImpl::DeliveryLoop, this);
+}
+
+WebrtcVideoRendererImpl::~WebrtcVideoRendererImpl() {
+  if (mailbox_enabled_) {
+    {
+      std::lock_guard<std::mutex> lock(mailbox_mutex_);
+      delivery_stopped_ = true;
+    }
+    mailbox_wake_.notify_one();
+    delivery_thread_.join();
+    RTC_LOG(LS_INFO) << "Renderer delivery stats: dropped "
+                     << DroppedFrameCount() << " stale frames, "
+                     << LateFrameCount() << " late renders.";
+  }
+}
+
+void WebrtcVideoRendererImpl::DeliveryLoop() {
+  while (true) {
+    std::unique_ptr<VideoBuffer> buffer;
+    {
+      std::unique_lock<std::mutex> lock(mailbox_mutex_);
+      mailbox_wake_.wait(
+          lock, [this] { return mailbox_ != nullptr || delivery_stopped_; });
+      if (delivery_stopped_)
+        return;
+      buffer = std::move(mailbox_);
+      QueueDepthGauges::Set(mailbox_gauge_, 0);
+    }
+    VideoRendererInterface* renderer = BeginRender();
+    if (renderer == nullptr) {
+      // Detached while the frame sat in the mailbox; the buffer returns
+      // to the pool through its recycler.
+      continue;
+    }
+    // A swap between ARGB and I420 renderers can leave one frame in the
+    // mailbox converted for the predecessor's format; drop it rather
+    // than hand a renderer the wrong pixel layout.
+    bool renderer_is_argb = renderer->Type() == VideoRendererType::kARGB;
+    if ((buffer->type == VideoBufferType::kARGB) != renderer_is_argb) {
+      EndRender();
+      continue;
+    }
+    int64_t start_ms = rtc::TimeMillis();
+    renderer->RenderFrame(std::move(buffer));
+    if (rtc::TimeMillis() - start_ms > kLateRenderThresholdMs)
+      late_frames_.fetch_add(1, std::memory_order_relaxed);
+    EndRender();
+  }
+}
+
+VideoRendererInterface* WebrtcVideoRendererImpl::BeginRender() {
+  // The increment happens before the load, so a detach that clears the
+  // pointer afterwards still waits for this delivery to finish.
+  renders_in_flight_.fetch_add(1, std::memory_order_acq_rel);
+  VideoRendererInterface* renderer = renderer_.load(std::memory_order_acquire);
+  if (renderer == nullptr)
+    renders_in_flight_.fetch_sub(1, std::memory_order_release);
+  return renderer;
+}
+
+void WebrtcVideoRendererImpl::EndRender() {
+  renders_in_flight_.fetch_sub(1, std::memory_order_release);
+}
+
+void WebrtcVideoRendererImpl::SetRenderer(VideoRendererInterface* renderer) {
+  renderer_.store(renderer, std::memory_order_release);
+  // Wait out deliveries pinned to the previous renderer so the caller
+  // may destroy it as soon as this returns. One frame hand-off at most.
+  while (renders_in_flight_.load(std::memory_order_acquire) > 0)
+    std::this_thread::yield();
+}
+
 void WebrtcVideoRendererImpl::OnFrame(const webrtc::VideoFrame& frame) {
+  VideoRendererInterface* renderer = BeginRender();
+  if (renderer == nullptr) {
+    // Detached; drop before any conversion work.
+    return;
+  }
+  freeze_detector_.RecordFrame();
+  PipelineLatencyTracer::Record(PipelineLatencyTracer::kRender,
+                                rtc::TimeMillis() - frame.render_time_ms());
   if (frame.video_frame_buffer()->type() ==
           webrtc::VideoFrameBuffer::Type::kNative) {
+#if defined(WEBRTC_WIN)
+    // Hardware-decoded frames stay on the GPU. A kNative renderer gets the
+    // decoder surface directly so the compositor samples it with zero
+    // copies; other renderer types never see these frames.
+    if (renderer->Type() == VideoRendererType::kNative) {
+      NativeHandleBuffer* native_buffer_impl =
+          static_cast<NativeHandleBuffer*>(frame.video_frame_buffer().get());
+      // Only decoder output carries a NativeD3DSurfaceHandle; capture-side
+      // native buffers (NV12 host memory, D3D11 textures) advertise their
+      // own handle types and are not renderable here.
+      if (native_buffer_impl->handle_type() !=
+          NativeHandleBuffer::kUnspecified) {
+        EndRender();
+        return;
+      }
+      NativeD3DSurfaceHandle* handle = reinterpret_cast<NativeD3DSurfaceHandle*>(
+          native_buffer_impl->native_handle());
+      if (handle != nullptr && handle->surface_ != nullptr) {
+        NativeVideoBuffer native_buffer;
+        native_buffer.surface = handle->surface_;
+        native_buffer.dev_manager = handle->dev_manager_;
+        native_buffer.dev_manager_reset_token = handle->dev_manager_reset_token_;
+        native_buffer.resolution = Resolution(handle->width_, handle->height_);
+        renderer->RenderNativeFrame(native_buffer);
+      }
+      // The handle travels one per frame and the sink owns deleting it,
+      // matching the internal D3D9 renderer.
+      delete handle;
+    }
+#endif
+    EndRender();
     return;
   }
-  VideoRendererType renderer_type = renderer_.Type();
+  VideoRendererType renderer_type = renderer->Type();
   if (renderer_type != VideoRendererType::kI420 &&
-      renderer_type != VideoRendererType::kARGB)
+      renderer_type != VideoRendererType::kARGB) {
+    EndRender();
     return;
+  }
   Resolution resolution(frame.width(), frame.height());
-  if (renderer_type == VideoRendererType::kARGB) {
-    uint8_t* buffer = new uint8_t[resolution.width * resolution.height * 4];
-    webrtc::ConvertFromI420(frame, webrtc::VideoType::kARGB, 0,
-                            static_cast<uint8_t*>(buffer));
-    std::unique_ptr<VideoBuffer> video_buffer(
-        new VideoBuffer{buffer, resolution, VideoBufferType::kARGB});
-    renderer_.RenderFrame(std::move(video_buffer));
+  bool is_argb = renderer_type == VideoRendererType::kARGB;
+  size_t buffer_size = is_argb
+                           ? resolution.width * resolution.height * 4
+                           : resolution.width * resolution.height * 3 / 2;
+  // Conversion targets come from the pool and return to it when the
+  // application destroys the VideoBuffer, so the steady state performs no
+  // allocation. The recycler holds the pool by reference count, keeping
+  // returns safe even after this renderer is torn down.
+  uint8_t* buffer = buffer_pool_->Acquire(buffer_size);
+  if (is_argb) {
+    webrtc::ConvertFromI420(frame, webrtc::VideoType::kARGB, 0, buffer);
   } else {
-    uint8_t* buffer = new uint8_t[resolution.width * resolution.height * 3 / 2];
-    webrtc::ConvertFromI420(frame, webrtc::VideoType::kI420, 0,
-                            static_cast<uint8_t*>(buffer));
-    std::unique_ptr<VideoBuffer> video_buffer(
-        new VideoBuffer{buffer, resolution, VideoBufferType::kI420});
-    renderer_.RenderFrame(std::move(video_buffer));
+    // I420 out is a pure repack of the decoded planes; the streaming copy
+    // keeps a full frame from flushing the delivery thread's cache.
+    rtc::scoped_refptr<webrtc::I420BufferInterface> i420 =
+        frame.video_frame_buffer()->ToI420();
+    PackI420Frame(buffer, frame.width(), frame.height(), i420->DataY(),
+                  i420->StrideY(), i420->DataU(), i420->StrideU(),
+                  i420->DataV(), i420->StrideV());
+  }
+  std::shared_ptr<VideoBufferPool> pool = buffer_pool_;
+  std::unique_ptr<VideoBuffer> video_buffer(new VideoBuffer{
+      buffer, resolution,
+      is_argb ? VideoBufferType::kARGB : VideoBufferType::kI420,
+      [pool, buffer_size](uint8_t* data) { pool->Recycle(data, buffer_size); },
+      frame.timestamp(), rtc::TimeMillis()});
+  if (mailbox_enabled_) {
+    // Publish into the single-slot mailbox. Replacing an undelivered
+    // frame returns its buffer to the pool through the recycler, so a
+    // stalled renderer costs freshness, not memory or queued latency.
+    {
+      std::lock_guard<std::mutex> lock(mailbox_mutex_);
+      if (mailbox_ != nullptr)
+        dropped_frames_.fetch_add(1, std::memory_order_relaxed);
+      mailbox_ = std::move(video_buffer);
+      QueueDepthGauges::Set(mailbox_gauge_, 1);
+    }
+    mailbox_wake_.notify_one();
+    EndRender();
+    return;
   }
+  renderer->RenderFrame(std::move(video_buffer));
+  EndRender();
 }
 }  // namespace base
 }  // namespace owt
@@ -3,21 +3,97 @@
 // SPDX-License-Identifier: Apache-2.0
 #ifndef OWT_BASE_WEBRTCVIDEORENDERERIMPL_H_
 #define OWT_BASE_WEBRTCVIDEORENDERERIMPL_H_
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "talk/owt/sdk/base/videofreezedetector.h"
 #include "webrtc/api/mediastreaminterface.h"
 #include "webrtc/api/video/video_sink_interface.h"
 #include "webrtc/api/video/video_frame.h"
 #include "talk/owt/sdk/include/cpp/owt/base/videorendererinterface.h"
 namespace owt {
 namespace base {
+// Recycles the frame-sized buffers handed to the application so
+// steady-state rendering allocates nothing. Buffers come back through the
+// VideoBuffer recycler when the application destroys the frame; the pool
+// is shared so returns are safe after the renderer itself is gone.
+class VideoBufferPool {
+ public:
+  ~VideoBufferPool();
+  // Returns a buffer of |size| bytes, reusing a returned one when the
+  // size still matches the current frame geometry.
+  uint8_t* Acquire(size_t size);
+  void Recycle(uint8_t* buffer, size_t size);
+
+ private:
+  static const size_t kMaxPooledBuffers = 4;
+  std::mutex mutex_;
+  // Size the pooled buffers were allocated with; a geometry change
+  // flushes the pool.
+  size_t buffer_size_ = 0;
+  std::vector<uint8_t*> free_buffers_;
+};
+
 class WebrtcVideoRendererImpl
     : public rtc::VideoSinkInterface<webrtc::VideoFrame> {
  public:
-  WebrtcVideoRendererImpl(VideoRendererInterface& renderer)
-      : renderer_(renderer) {}
+  // |stream_id| names this renderer's queue-depth gauge so backpressure
+  // reports point at the stream whose mailbox is backing up.
+  WebrtcVideoRendererImpl(VideoRendererInterface& renderer,
+                          const std::string& stream_id);
   virtual void OnFrame(const webrtc::VideoFrame& frame) override;
-  virtual ~WebrtcVideoRendererImpl() {}
+  virtual ~WebrtcVideoRendererImpl();
+  // Swaps the application renderer without touching the sink chain or
+  // the buffer pool, so re-attaching on layout changes neither drops the
+  // track sink nor reallocates conversion buffers. Waits out deliveries
+  // already in flight before returning, so the caller may destroy the
+  // previous renderer immediately. Null detaches; frames arriving while
+  // detached are dropped before conversion.
+  void SetRenderer(VideoRendererInterface* renderer);
+  // Frames that were replaced in the mailbox before the renderer took
+  // them. Zero unless latest-frame-wins delivery is enabled.
+  uint32_t DroppedFrameCount() const {
+    return dropped_frames_.load(std::memory_order_relaxed);
+  }
+  // Deliveries where the application's RenderFrame ran longer than one
+  // frame interval, i.e. moments the mailbox was protecting against.
+  uint32_t LateFrameCount() const {
+    return late_frames_.load(std::memory_order_relaxed);
+  }
+
  private:
-  VideoRendererInterface& renderer_;
+  // Runs on |delivery_thread_|; takes whatever frame currently sits in
+  // the mailbox and hands it to the application.
+  void DeliveryLoop();
+  // Pins the attached renderer for one delivery. Returns null when
+  // detached; every non-null return must be paired with EndRender.
+  VideoRendererInterface* BeginRender();
+  void EndRender();
+  // Swapped lock free by SetRenderer; delivery paths pin it through
+  // |renders_in_flight_| for the duration of one frame hand-off.
+  std::atomic<VideoRendererInterface*> renderer_;
+  std::atomic<int> renders_in_flight_;
+  std::shared_ptr<VideoBufferPool> buffer_pool_;
+  // Latest-frame-wins delivery (GlobalConfiguration::
+  // SetLatestFrameRenderingEnabled, or any active low-latency
+  // subscription): OnFrame publishes into a single mailbox slot instead
+  // of calling the application directly, so a slow RenderFrame costs
+  // freshness, never queued delay.
+  const bool mailbox_enabled_;
+  const std::string mailbox_gauge_;
+  // Inter-frame gaps at the sink, attributed to this renderer's stream.
+  VideoFreezeDetector freeze_detector_;
+  std::mutex mailbox_mutex_;
+  std::condition_variable mailbox_wake_;
+  std::unique_ptr<VideoBuffer> mailbox_;
+  bool delivery_stopped_;
+  std::atomic<uint32_t> dropped_frames_;
+  std::atomic<uint32_t> late_frames_;
+  std::thread delivery_thread_;
 };
 }
 }
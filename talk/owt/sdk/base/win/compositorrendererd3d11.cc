@@ -0,0 +1,528 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <math.h>
+
+#include "talk/owt/sdk/base/nativehandlebuffer.h"
+#include "talk/owt/sdk/base/win/compositorrendererd3d11.h"
+#include "talk/owt/sdk/base/win/d3dnativeframe.h"
+#include "webrtc/rtc_base/logging.h"
+
+// Solve conflict in FOURCC def with libyuv
+#ifdef FOURCC
+#undef FOURCC
+#endif
+#include "third_party/libyuv/include/libyuv.h"
+
+namespace owt {
+namespace base {
+
+// Upper bound on waiting for the swapchain to accept a present.
+static const DWORD kPresentWaitMs = 100;
+// Idle polling interval while no sink has produced a frame yet.
+static const DWORD kIdleSleepMs = 10;
+
+std::mutex D3D11CompositorRenderer::registry_mutex_;
+std::map<HWND, std::weak_ptr<D3D11CompositorRenderer>>
+    D3D11CompositorRenderer::registry_;
+
+CompositedStreamSink::CompositedStreamSink(
+    std::shared_ptr<D3D11CompositorRenderer> compositor)
+    : compositor_(compositor),
+      latest_texture_(nullptr),
+      upload_texture_(nullptr),
+      staging_texture_(nullptr),
+      upload_width_(0),
+      upload_height_(0),
+      interop_surface_(nullptr),
+      interop_texture_(nullptr),
+      interop_width_(0),
+      interop_height_(0) {
+  std::lock_guard<std::mutex> lock(compositor_->sinks_mutex_);
+  compositor_->sinks_.push_back(this);
+}
+
+CompositedStreamSink::~CompositedStreamSink() {
+  compositor_->RemoveSink(this);
+  ReleaseTextures();
+}
+
+void CompositedStreamSink::ReleaseTextures() {
+  std::lock_guard<std::mutex> lock(compositor_->device_mutex_);
+  latest_texture_ = nullptr;
+  if (staging_texture_) {
+    staging_texture_->Release();
+    staging_texture_ = nullptr;
+  }
+  if (upload_texture_) {
+    upload_texture_->Release();
+    upload_texture_ = nullptr;
+  }
+  if (interop_texture_) {
+    interop_texture_->Release();
+    interop_texture_ = nullptr;
+  }
+  if (interop_surface_) {
+    interop_surface_->Release();
+    interop_surface_ = nullptr;
+  }
+}
+
+ID3D11Texture2D* CompositedStreamSink::UploadSoftwareFrame(
+    const webrtc::VideoFrame& frame) {
+  ID3D11Device* device = compositor_->device_;
+  ID3D11DeviceContext* context = compositor_->context_;
+  int width = frame.width();
+  int height = frame.height();
+  if (!upload_texture_ || width != upload_width_ || height != upload_height_) {
+    if (upload_texture_) {
+      upload_texture_->Release();
+      upload_texture_ = nullptr;
+    }
+    if (staging_texture_) {
+      staging_texture_->Release();
+      staging_texture_ = nullptr;
+    }
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = width;
+    desc.Height = height;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = DXGI_FORMAT_NV12;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    if (FAILED(device->CreateTexture2D(&desc, nullptr, &upload_texture_))) {
+      RTC_LOG(LS_ERROR) << "Failed to allocate NV12 upload texture.";
+      return nullptr;
+    }
+    desc.Usage = D3D11_USAGE_STAGING;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    if (FAILED(device->CreateTexture2D(&desc, nullptr, &staging_texture_))) {
+      upload_texture_->Release();
+      upload_texture_ = nullptr;
+      return nullptr;
+    }
+    upload_width_ = width;
+    upload_height_ = height;
+  }
+  D3D11_MAPPED_SUBRESOURCE mapped;
+  if (FAILED(context->Map(staging_texture_, 0, D3D11_MAP_WRITE, 0, &mapped)))
+    return nullptr;
+  const webrtc::I420BufferInterface* i420 =
+      frame.video_frame_buffer()->GetI420();
+  uint8_t* dst_y = static_cast<uint8_t*>(mapped.pData);
+  uint8_t* dst_uv = dst_y + mapped.RowPitch * height;
+  libyuv::I420ToNV12(i420->DataY(), i420->StrideY(), i420->DataU(),
+                     i420->StrideU(), i420->DataV(), i420->StrideV(), dst_y,
+                     mapped.RowPitch, dst_uv, mapped.RowPitch, width, height);
+  context->Unmap(staging_texture_, 0);
+  context->CopyResource(upload_texture_, staging_texture_);
+  return upload_texture_;
+}
+
+ID3D11Texture2D* CompositedStreamSink::CopyD3D9Surface(
+    NativeD3DSurfaceHandle* handle) {
+  IDirect3DDeviceManager9* dev_manager = handle->dev_manager_;
+  HANDLE device_handle = nullptr;
+  HRESULT hr = dev_manager->OpenDeviceHandle(&device_handle);
+  if (FAILED(hr)) {
+    RTC_LOG(LS_ERROR) << "Failed to open the d3d device handle";
+    return nullptr;
+  }
+  IDirect3DDevice9* device9 = nullptr;
+  hr = dev_manager->LockDevice(device_handle, &device9, FALSE);
+  if (FAILED(hr)) {
+    RTC_LOG(LS_ERROR) << "Failed to lock device";
+    dev_manager->CloseDeviceHandle(device_handle);
+    return nullptr;
+  }
+  if (!interop_surface_ || handle->width_ != interop_width_ ||
+      handle->height_ != interop_height_) {
+    if (interop_texture_) {
+      interop_texture_->Release();
+      interop_texture_ = nullptr;
+    }
+    if (interop_surface_) {
+      interop_surface_->Release();
+      interop_surface_ = nullptr;
+    }
+    // Same shared-memory pairing as the single-stream D3D11 renderer: the
+    // decoder device writes the render target, the compositor device
+    // samples the texture opened from its share handle.
+    HANDLE shared_handle = nullptr;
+    hr = device9->CreateRenderTarget(
+        handle->width_, handle->height_, D3DFMT_X8R8G8B8, D3DMULTISAMPLE_NONE,
+        0, FALSE, &interop_surface_, &shared_handle);
+    if (SUCCEEDED(hr)) {
+      hr = compositor_->device_->OpenSharedResource(
+          shared_handle, __uuidof(ID3D11Texture2D),
+          reinterpret_cast<void**>(&interop_texture_));
+    }
+    if (FAILED(hr)) {
+      RTC_LOG(LS_ERROR) << "Failed to create shared interop target: " << hr;
+      if (interop_surface_) {
+        interop_surface_->Release();
+        interop_surface_ = nullptr;
+      }
+      interop_texture_ = nullptr;
+      dev_manager->UnlockDevice(device_handle, FALSE);
+      dev_manager->CloseDeviceHandle(device_handle);
+      return nullptr;
+    }
+    interop_width_ = handle->width_;
+    interop_height_ = handle->height_;
+  }
+  hr = device9->StretchRect(handle->surface_, nullptr, interop_surface_,
+                            nullptr, D3DTEXF_NONE);
+  dev_manager->UnlockDevice(device_handle, FALSE);
+  dev_manager->CloseDeviceHandle(device_handle);
+  if (FAILED(hr)) {
+    RTC_LOG(LS_ERROR) << "Failed to stretch the rectangle";
+    return nullptr;
+  }
+  return interop_texture_;
+}
+
+void CompositedStreamSink::OnFrame(const webrtc::VideoFrame& frame) {
+  if (compositor_->init_failed_)
+    return;
+  if (frame.video_frame_buffer()->type() ==
+      webrtc::VideoFrameBuffer::Type::kNative) {
+    NativeHandleBuffer* native_buffer = static_cast<NativeHandleBuffer*>(
+        frame.video_frame_buffer().get());
+    if (native_buffer->handle_type() != NativeHandleBuffer::kUnspecified) {
+      // Capture-side native buffers live on their producer's device and
+      // are not composited; this sink is for received streams.
+      return;
+    }
+    NativeD3DSurfaceHandle* handle = reinterpret_cast<NativeD3DSurfaceHandle*>(
+        native_buffer->native_handle());
+    if (!handle)
+      return;
+    {
+      std::lock_guard<std::mutex> lock(compositor_->device_mutex_);
+      ID3D11Texture2D* texture = CopyD3D9Surface(handle);
+      if (texture)
+        latest_texture_ = texture;
+    }
+    // The sink owns the per-frame handle, matching the window renderers.
+    delete handle;
+    return;
+  }
+  std::lock_guard<std::mutex> lock(compositor_->device_mutex_);
+  ID3D11Texture2D* texture = UploadSoftwareFrame(frame);
+  if (texture)
+    latest_texture_ = texture;
+}
+
+std::shared_ptr<D3D11CompositorRenderer> D3D11CompositorRenderer::GetForWindow(
+    HWND wnd) {
+  std::lock_guard<std::mutex> lock(registry_mutex_);
+  auto it = registry_.find(wnd);
+  if (it != registry_.end()) {
+    std::shared_ptr<D3D11CompositorRenderer> existing = it->second.lock();
+    if (existing)
+      return existing;
+    registry_.erase(it);
+  }
+  std::shared_ptr<D3D11CompositorRenderer> compositor(
+      new D3D11CompositorRenderer(wnd));
+  registry_[wnd] = compositor;
+  return compositor;
+}
+
+D3D11CompositorRenderer::D3D11CompositorRenderer(HWND wnd)
+    : wnd_(wnd),
+      init_failed_(false),
+      device_(nullptr),
+      context_(nullptr),
+      swap_chain_(nullptr),
+      frame_latency_waitable_(nullptr),
+      swap_chain_width_(0),
+      swap_chain_height_(0),
+      video_device_(nullptr),
+      video_context_(nullptr),
+      processor_enum_(nullptr),
+      processor_(nullptr),
+      max_streams_per_pass_(1),
+      stopped_(false) {
+  if (!InitDevice()) {
+    init_failed_ = true;
+    return;
+  }
+  render_thread_ = std::thread(&D3D11CompositorRenderer::RenderLoop, this);
+}
+
+D3D11CompositorRenderer::~D3D11CompositorRenderer() {
+  {
+    std::lock_guard<std::mutex> lock(sinks_mutex_);
+    stopped_ = true;
+  }
+  if (render_thread_.joinable())
+    render_thread_.join();
+  if (processor_)
+    processor_->Release();
+  if (processor_enum_)
+    processor_enum_->Release();
+  if (video_context_)
+    video_context_->Release();
+  if (video_device_)
+    video_device_->Release();
+  if (swap_chain_)
+    swap_chain_->Release();
+  if (context_)
+    context_->Release();
+  if (device_)
+    device_->Release();
+}
+
+bool D3D11CompositorRenderer::InitDevice() {
+  static const D3D_FEATURE_LEVEL feature_levels[] = {D3D_FEATURE_LEVEL_11_1,
+                                                     D3D_FEATURE_LEVEL_11_0};
+  HRESULT hr = D3D11CreateDevice(
+      nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr,
+      D3D11_CREATE_DEVICE_BGRA_SUPPORT | D3D11_CREATE_DEVICE_VIDEO_SUPPORT,
+      feature_levels, sizeof(feature_levels) / sizeof(feature_levels[0]),
+      D3D11_SDK_VERSION, &device_, nullptr, &context_);
+  if (FAILED(hr)) {
+    RTC_LOG(LS_ERROR) << "Failed to create compositor device: " << hr;
+    return false;
+  }
+  hr = device_->QueryInterface(__uuidof(ID3D11VideoDevice),
+                               reinterpret_cast<void**>(&video_device_));
+  if (FAILED(hr)) {
+    RTC_LOG(LS_ERROR) << "Compositor device exposes no video interface.";
+    return false;
+  }
+  hr = context_->QueryInterface(__uuidof(ID3D11VideoContext),
+                                reinterpret_cast<void**>(&video_context_));
+  if (FAILED(hr))
+    return false;
+  return true;
+}
+
+bool D3D11CompositorRenderer::EnsureSwapChain() {
+  RECT rect;
+  if (!GetClientRect(wnd_, &rect))
+    return false;
+  int width = rect.right - rect.left;
+  int height = rect.bottom - rect.top;
+  if (width <= 0 || height <= 0)
+    return false;
+  if (swap_chain_ && width == swap_chain_width_ &&
+      height == swap_chain_height_)
+    return true;
+  if (swap_chain_) {
+    HRESULT hr = swap_chain_->ResizeBuffers(
+        0, width, height, DXGI_FORMAT_UNKNOWN,
+        DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT);
+    if (FAILED(hr)) {
+      RTC_LOG(LS_ERROR) << "Failed to resize swapchain: " << hr;
+      return false;
+    }
+    swap_chain_width_ = width;
+    swap_chain_height_ = height;
+    return true;
+  }
+  IDXGIDevice* dxgi_device = nullptr;
+  HRESULT hr = device_->QueryInterface(__uuidof(IDXGIDevice),
+                                       reinterpret_cast<void**>(&dxgi_device));
+  if (FAILED(hr))
+    return false;
+  IDXGIAdapter* adapter = nullptr;
+  hr = dxgi_device->GetAdapter(&adapter);
+  dxgi_device->Release();
+  if (FAILED(hr))
+    return false;
+  IDXGIFactory2* factory = nullptr;
+  hr = adapter->GetParent(__uuidof(IDXGIFactory2),
+                          reinterpret_cast<void**>(&factory));
+  adapter->Release();
+  if (FAILED(hr))
+    return false;
+  DXGI_SWAP_CHAIN_DESC1 desc = {};
+  desc.Width = width;
+  desc.Height = height;
+  desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+  desc.SampleDesc.Count = 1;
+  desc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+  desc.BufferCount = 3;
+  desc.Scaling = DXGI_SCALING_STRETCH;
+  desc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+  desc.Flags = DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
+  IDXGISwapChain1* swap_chain1 = nullptr;
+  hr = factory->CreateSwapChainForHwnd(device_, wnd_, &desc, nullptr, nullptr,
+                                       &swap_chain1);
+  if (FAILED(hr)) {
+    desc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL;
+    hr = factory->CreateSwapChainForHwnd(device_, wnd_, &desc, nullptr,
+                                         nullptr, &swap_chain1);
+  }
+  factory->Release();
+  if (FAILED(hr)) {
+    RTC_LOG(LS_ERROR) << "Failed to create flip-model swapchain: " << hr;
+    return false;
+  }
+  hr = swap_chain1->QueryInterface(__uuidof(IDXGISwapChain2),
+                                   reinterpret_cast<void**>(&swap_chain_));
+  swap_chain1->Release();
+  if (FAILED(hr)) {
+    RTC_LOG(LS_ERROR) << "Waitable swapchain interface unavailable: " << hr;
+    return false;
+  }
+  swap_chain_->SetMaximumFrameLatency(1);
+  frame_latency_waitable_ = swap_chain_->GetFrameLatencyWaitableObject();
+  swap_chain_width_ = width;
+  swap_chain_height_ = height;
+  return true;
+}
+
+bool D3D11CompositorRenderer::EnsureProcessor() {
+  if (processor_)
+    return true;
+  // Per-stream source dimensions are set at blt time, so the processor is
+  // sized to the output once and survives any mix of stream resolutions.
+  D3D11_VIDEO_PROCESSOR_CONTENT_DESC desc = {};
+  desc.InputFrameFormat = D3D11_VIDEO_FRAME_FORMAT_PROGRESSIVE;
+  desc.InputWidth = swap_chain_width_;
+  desc.InputHeight = swap_chain_height_;
+  desc.OutputWidth = swap_chain_width_;
+  desc.OutputHeight = swap_chain_height_;
+  desc.Usage = D3D11_VIDEO_USAGE_PLAYBACK_NORMAL;
+  HRESULT hr =
+      video_device_->CreateVideoProcessorEnumerator(&desc, &processor_enum_);
+  if (FAILED(hr))
+    return false;
+  hr = video_device_->CreateVideoProcessor(processor_enum_, 0, &processor_);
+  if (FAILED(hr))
+    return false;
+  D3D11_VIDEO_PROCESSOR_CAPS caps = {};
+  if (SUCCEEDED(processor_enum_->GetVideoProcessorCaps(&caps))) {
+    max_streams_per_pass_ = caps.MaxInputStreams < caps.MaxStreamStates
+                                ? caps.MaxInputStreams
+                                : caps.MaxStreamStates;
+    if (max_streams_per_pass_ < 1)
+      max_streams_per_pass_ = 1;
+  }
+  return true;
+}
+
+void D3D11CompositorRenderer::RemoveSink(CompositedStreamSink* sink) {
+  std::lock_guard<std::mutex> lock(sinks_mutex_);
+  for (auto it = sinks_.begin(); it != sinks_.end(); ++it) {
+    if (*it == sink) {
+      sinks_.erase(it);
+      break;
+    }
+  }
+}
+
+void D3D11CompositorRenderer::RenderLoop() {
+  while (true) {
+    {
+      std::lock_guard<std::mutex> lock(sinks_mutex_);
+      if (stopped_)
+        return;
+    }
+    ComposeAndPresent();
+  }
+}
+
+void D3D11CompositorRenderer::ComposeAndPresent() {
+  std::lock_guard<std::mutex> sinks_lock(sinks_mutex_);
+  std::lock_guard<std::mutex> device_lock(device_mutex_);
+  std::vector<ID3D11Texture2D*> textures;
+  for (CompositedStreamSink* sink : sinks_) {
+    if (sink->latest_texture_)
+      textures.push_back(sink->latest_texture_);
+  }
+  if (textures.empty() || !EnsureSwapChain() || !EnsureProcessor()) {
+    Sleep(kIdleSleepMs);
+    return;
+  }
+  // Paces the loop to the display: the waitable signals once per vsync
+  // when the single queued present has been consumed.
+  if (frame_latency_waitable_)
+    WaitForSingleObjectEx(frame_latency_waitable_, kPresentWaitMs, FALSE);
+  ID3D11Texture2D* back_buffer = nullptr;
+  HRESULT hr = swap_chain_->GetBuffer(0, __uuidof(ID3D11Texture2D),
+                                      reinterpret_cast<void**>(&back_buffer));
+  if (FAILED(hr))
+    return;
+  D3D11_VIDEO_PROCESSOR_OUTPUT_VIEW_DESC output_view_desc = {};
+  output_view_desc.ViewDimension = D3D11_VPOV_DIMENSION_TEXTURE2D;
+  output_view_desc.Texture2D.MipSlice = 0;
+  ID3D11VideoProcessorOutputView* output_view = nullptr;
+  hr = video_device_->CreateVideoProcessorOutputView(
+      back_buffer, processor_enum_, &output_view_desc, &output_view);
+  if (FAILED(hr)) {
+    back_buffer->Release();
+    return;
+  }
+  D3D11_VIDEO_COLOR background = {};
+  background.RGBA.A = 1.0f;
+  video_context_->VideoProcessorSetOutputBackgroundColor(processor_, FALSE,
+                                                         &background);
+  // Uniform grid sized to the number of live streams.
+  size_t count = textures.size();
+  int columns = static_cast<int>(ceil(sqrt(static_cast<double>(count))));
+  int rows = static_cast<int>((count + columns - 1) / columns);
+  int cell_width = swap_chain_width_ / columns;
+  int cell_height = swap_chain_height_ / rows;
+  bool blt_failed = false;
+  for (size_t first = 0; first < count && !blt_failed;
+       first += max_streams_per_pass_) {
+    size_t pass_count = count - first < max_streams_per_pass_
+                            ? count - first
+                            : max_streams_per_pass_;
+    std::vector<ID3D11VideoProcessorInputView*> input_views;
+    std::vector<D3D11_VIDEO_PROCESSOR_STREAM> streams;
+    for (size_t i = 0; i < pass_count; ++i) {
+      D3D11_VIDEO_PROCESSOR_INPUT_VIEW_DESC input_view_desc = {};
+      input_view_desc.FourCC = 0;
+      input_view_desc.ViewDimension = D3D11_VPIV_DIMENSION_TEXTURE2D;
+      input_view_desc.Texture2D.MipSlice = 0;
+      ID3D11VideoProcessorInputView* input_view = nullptr;
+      hr = video_device_->CreateVideoProcessorInputView(
+          textures[first + i], processor_enum_, &input_view_desc, &input_view);
+      if (FAILED(hr)) {
+        blt_failed = true;
+        break;
+      }
+      input_views.push_back(input_view);
+      size_t slot = first + i;
+      RECT dest;
+      dest.left = static_cast<LONG>((slot % columns) * cell_width);
+      dest.top = static_cast<LONG>((slot / columns) * cell_height);
+      dest.right = dest.left + cell_width;
+      dest.bottom = dest.top + cell_height;
+      video_context_->VideoProcessorSetStreamDestRect(
+          processor_, static_cast<UINT>(i), TRUE, &dest);
+      D3D11_VIDEO_PROCESSOR_STREAM stream = {};
+      stream.Enable = TRUE;
+      stream.pInputSurface = input_view;
+      streams.push_back(stream);
+    }
+    if (!blt_failed) {
+      hr = video_context_->VideoProcessorBlt(
+          processor_, output_view, 0, static_cast<UINT>(streams.size()),
+          streams.data());
+      if (FAILED(hr)) {
+        RTC_LOG(LS_ERROR) << "Compositor VideoProcessorBlt failed: " << hr;
+        blt_failed = true;
+      }
+    }
+    for (auto* view : input_views)
+      view->Release();
+  }
+  output_view->Release();
+  back_buffer->Release();
+  if (!blt_failed) {
+    // All cells land in one present; sync interval 1 holds composition to
+    // one pass per vsync.
+    swap_chain_->Present(1, 0);
+  }
+}
+}  // namespace base
+}  // namespace owt
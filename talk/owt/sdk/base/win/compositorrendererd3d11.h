@@ -0,0 +1,105 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_WIN_COMPOSITORRENDERER_D3D11_H
+#define OWT_BASE_WIN_COMPOSITORRENDERER_D3D11_H
+#include <d3d9.h>
+#include <d3d11.h>
+#include <dxgi1_3.h>
+#include <dxva2api.h>
+#include <Windows.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "webrtc/api/video/video_frame.h"
+#include "webrtc/api/video/video_sink_interface.h"
+namespace owt {
+namespace base {
+struct NativeD3DSurfaceHandle;
+class D3D11CompositorRenderer;
+// One stream's connection to a compositor window. OnFrame lands the frame
+// in a texture on the compositor device - uploading software frames,
+// blitting hardware-decoded D3D9 surfaces through a shared render target -
+// and the compositor samples whatever texture is latest at the next
+// present. The sink never presents by itself.
+class CompositedStreamSink : public rtc::VideoSinkInterface<webrtc::VideoFrame> {
+ public:
+  explicit CompositedStreamSink(
+      std::shared_ptr<D3D11CompositorRenderer> compositor);
+  virtual void OnFrame(const webrtc::VideoFrame& frame) override;
+  virtual ~CompositedStreamSink();
+
+ private:
+  friend class D3D11CompositorRenderer;
+  ID3D11Texture2D* UploadSoftwareFrame(const webrtc::VideoFrame& frame);
+  ID3D11Texture2D* CopyD3D9Surface(NativeD3DSurfaceHandle* handle);
+  void ReleaseTextures();
+  std::shared_ptr<D3D11CompositorRenderer> compositor_;
+  // All members below are guarded by the compositor's device mutex, which
+  // also serializes the immediate context they are written through.
+  ID3D11Texture2D* latest_texture_;  // Aliases one of the textures below.
+  ID3D11Texture2D* upload_texture_;
+  ID3D11Texture2D* staging_texture_;
+  int upload_width_;
+  int upload_height_;
+  IDirect3DSurface9* interop_surface_;
+  ID3D11Texture2D* interop_texture_;
+  int interop_width_;
+  int interop_height_;
+};
+// Composites every stream attached to one window in a single video
+// processor pass and presents once per vsync through a waitable
+// flip-model swapchain, instead of one conversion and one present per
+// stream. Streams are placed on a uniform grid sized to the number of
+// attached sinks. Instances are shared per HWND and live as long as any
+// sink does.
+class D3D11CompositorRenderer
+    : public std::enable_shared_from_this<D3D11CompositorRenderer> {
+ public:
+  // Returns the compositor for |wnd|, creating it on first use.
+  static std::shared_ptr<D3D11CompositorRenderer> GetForWindow(HWND wnd);
+  // Creates a sink compositing into this window; caller owns the sink.
+  CompositedStreamSink* CreateSink();
+  ~D3D11CompositorRenderer();
+
+ private:
+  friend class CompositedStreamSink;
+  explicit D3D11CompositorRenderer(HWND wnd);
+  bool InitDevice();
+  bool EnsureSwapChain();
+  bool EnsureProcessor();
+  void RemoveSink(CompositedStreamSink* sink);
+  // Runs on |render_thread_|: composes all sinks with frames into the
+  // back buffer and presents, once per vsync.
+  void RenderLoop();
+  void ComposeAndPresent();
+
+  HWND wnd_;
+  bool init_failed_;
+  ID3D11Device* device_;
+  ID3D11DeviceContext* context_;
+  IDXGISwapChain2* swap_chain_;
+  HANDLE frame_latency_waitable_;
+  int swap_chain_width_;
+  int swap_chain_height_;
+  ID3D11VideoDevice* video_device_;
+  ID3D11VideoContext* video_context_;
+  ID3D11VideoProcessorEnumerator* processor_enum_;
+  ID3D11VideoProcessor* processor_;
+  // Largest number of streams one VideoProcessorBlt accepts; sinks beyond
+  // it are composed in additional passes before the single present.
+  UINT max_streams_per_pass_;
+  // Serializes the immediate context between sink uploads and composition.
+  std::mutex device_mutex_;
+  std::mutex sinks_mutex_;
+  std::vector<CompositedStreamSink*> sinks_;
+  bool stopped_;
+  std::thread render_thread_;
+  static std::mutex registry_mutex_;
+  static std::map<HWND, std::weak_ptr<D3D11CompositorRenderer>> registry_;
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_WIN_COMPOSITORRENDERER_D3D11_H
@@ -33,6 +33,7 @@ or https://software.intel.com/en-us/media-client-solutions-support.
 #include <functional>
 #include <iterator>
 #include "d3d11_allocator.h"
+#include "msdkmemorybudget.h"
 
 #define D3DFMT_NV12 (DXGI_FORMAT)MAKEFOURCC('N','V','1','2')
 #define D3DFMT_YV12 (DXGI_FORMAT)MAKEFOURCC('Y','V','1','2')
@@ -332,6 +333,8 @@ mfxStatus D3D11FrameAllocator::ReleaseResponse(mfxFrameAllocResponse *response)
         if (!sr.GetTexture())
             return MFX_ERR_NULL_PTR;
 
+        MSDKMemoryBudget::Get()->OnPoolReleased(response->mids[0]);
+
         sr.Release();
 
         //if texture is last it is possible to remove also all handles from map to reduce fragmentation
@@ -357,6 +360,17 @@ mfxStatus D3D11FrameAllocator::AllocImpl(mfxFrameAllocRequest *request, mfxFrame
        return MFX_ERR_UNSUPPORTED;
     }
 
+    // Refuse pools that would push process-wide surface memory past the
+    // configured budget, so overload fails here as a clean allocation
+    // error instead of exhausting GPU memory mid-stream.
+    if (!MSDKMemoryBudget::Get()->CanAllocate(request->Info.Width,
+                                              request->Info.Height,
+                                              request->Info.FourCC,
+                                              request->NumFrameSuggested))
+    {
+        return MFX_ERR_MEMORY_ALLOC;
+    }
+
     TextureResource newTexture;
 
     if (request->Info.FourCC == MFX_FOURCC_P8)
@@ -484,6 +498,10 @@ mfxStatus D3D11FrameAllocator::AllocImpl(mfxFrameAllocRequest *request, mfxFrame
     //fill map
     std::fill_n(std::back_inserter(m_memIdMap), request->NumFrameSuggested, --it_last);
 
+    MSDKMemoryBudget::Get()->OnPoolAllocated(
+        response->mids[0], request->Info.Width, request->Info.Height,
+        request->Info.FourCC, response->NumFrameActual);
+
     return MFX_ERR_NONE;
 }
 
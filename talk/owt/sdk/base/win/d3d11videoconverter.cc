@@ -0,0 +1,158 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "webrtc/rtc_base/logging.h"
+#include "talk/owt/sdk/base/win/d3d11videoconverter.h"
+namespace owt {
+namespace base {
+// Number of NV12 output textures cycled through while earlier frames are
+// still referenced downstream.
+static const size_t kOutputTextureRingSize = 4;
+D3D11VideoConverter::D3D11VideoConverter()
+    : device_(nullptr),
+      context_(nullptr),
+      video_device_(nullptr),
+      video_context_(nullptr),
+      processor_enum_(nullptr),
+      processor_(nullptr),
+      output_index_(0),
+      width_(0),
+      height_(0) {}
+D3D11VideoConverter::~D3D11VideoConverter() {
+  ReleaseOutputTextures();
+  if (processor_)
+    processor_->Release();
+  if (processor_enum_)
+    processor_enum_->Release();
+  if (video_context_)
+    video_context_->Release();
+  if (video_device_)
+    video_device_->Release();
+  if (context_)
+    context_->Release();
+  if (device_)
+    device_->Release();
+}
+bool D3D11VideoConverter::Init(ID3D11Device* device) {
+  if (!device)
+    return false;
+  device_ = device;
+  device_->AddRef();
+  device_->GetImmediateContext(&context_);
+  HRESULT hr = device_->QueryInterface(
+      __uuidof(ID3D11VideoDevice), reinterpret_cast<void**>(&video_device_));
+  if (FAILED(hr)) {
+    RTC_LOG(LS_WARNING) << "Device exposes no D3D11 video interface.";
+    return false;
+  }
+  hr = context_->QueryInterface(__uuidof(ID3D11VideoContext),
+                                reinterpret_cast<void**>(&video_context_));
+  if (FAILED(hr))
+    return false;
+  return true;
+}
+bool D3D11VideoConverter::EnsureProcessor(int width, int height) {
+  if (processor_ && width == width_ && height == height_)
+    return true;
+  if (processor_) {
+    processor_->Release();
+    processor_ = nullptr;
+  }
+  if (processor_enum_) {
+    processor_enum_->Release();
+    processor_enum_ = nullptr;
+  }
+  ReleaseOutputTextures();
+  D3D11_VIDEO_PROCESSOR_CONTENT_DESC desc = {};
+  desc.InputFrameFormat = D3D11_VIDEO_FRAME_FORMAT_PROGRESSIVE;
+  desc.InputWidth = width;
+  desc.InputHeight = height;
+  desc.OutputWidth = width;
+  desc.OutputHeight = height;
+  desc.Usage = D3D11_VIDEO_USAGE_PLAYBACK_NORMAL;
+  HRESULT hr =
+      video_device_->CreateVideoProcessorEnumerator(&desc, &processor_enum_);
+  if (FAILED(hr))
+    return false;
+  hr = video_device_->CreateVideoProcessor(processor_enum_, 0, &processor_);
+  if (FAILED(hr))
+    return false;
+  width_ = width;
+  height_ = height;
+  return true;
+}
+ID3D11Texture2D* D3D11VideoConverter::GetOutputTexture(int width, int height) {
+  if (output_textures_.size() == kOutputTextureRingSize) {
+    ID3D11Texture2D* texture = output_textures_[output_index_];
+    output_index_ = (output_index_ + 1) % kOutputTextureRingSize;
+    return texture;
+  }
+  D3D11_TEXTURE2D_DESC desc = {};
+  desc.Width = width;
+  desc.Height = height;
+  desc.MipLevels = 1;
+  desc.ArraySize = 1;
+  desc.Format = DXGI_FORMAT_NV12;
+  desc.SampleDesc.Count = 1;
+  desc.Usage = D3D11_USAGE_DEFAULT;
+  desc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+  ID3D11Texture2D* texture = nullptr;
+  if (FAILED(device_->CreateTexture2D(&desc, nullptr, &texture))) {
+    RTC_LOG(LS_ERROR) << "Failed to allocate NV12 output texture.";
+    return nullptr;
+  }
+  output_textures_.push_back(texture);
+  return texture;
+}
+void D3D11VideoConverter::ReleaseOutputTextures() {
+  for (auto* texture : output_textures_) {
+    texture->Release();
+  }
+  output_textures_.clear();
+  output_index_ = 0;
+}
+ID3D11Texture2D* D3D11VideoConverter::Convert(ID3D11Texture2D* source) {
+  rtc::CritScope cs(&lock_);
+  if (!video_device_ || !source)
+    return nullptr;
+  D3D11_TEXTURE2D_DESC source_desc;
+  source->GetDesc(&source_desc);
+  if (!EnsureProcessor(source_desc.Width, source_desc.Height))
+    return nullptr;
+  ID3D11Texture2D* output = GetOutputTexture(width_, height_);
+  if (!output)
+    return nullptr;
+  D3D11_VIDEO_PROCESSOR_INPUT_VIEW_DESC input_view_desc = {};
+  input_view_desc.FourCC = 0;
+  input_view_desc.ViewDimension = D3D11_VPIV_DIMENSION_TEXTURE2D;
+  input_view_desc.Texture2D.MipSlice = 0;
+  ID3D11VideoProcessorInputView* input_view = nullptr;
+  HRESULT hr = video_device_->CreateVideoProcessorInputView(
+      source, processor_enum_, &input_view_desc, &input_view);
+  if (FAILED(hr))
+    return nullptr;
+  D3D11_VIDEO_PROCESSOR_OUTPUT_VIEW_DESC output_view_desc = {};
+  output_view_desc.ViewDimension = D3D11_VPOV_DIMENSION_TEXTURE2D;
+  output_view_desc.Texture2D.MipSlice = 0;
+  ID3D11VideoProcessorOutputView* output_view = nullptr;
+  hr = video_device_->CreateVideoProcessorOutputView(
+      output, processor_enum_, &output_view_desc, &output_view);
+  if (FAILED(hr)) {
+    input_view->Release();
+    return nullptr;
+  }
+  D3D11_VIDEO_PROCESSOR_STREAM stream = {};
+  stream.Enable = TRUE;
+  stream.pInputSurface = input_view;
+  hr = video_context_->VideoProcessorBlt(processor_, output_view, 0, 1,
+                                         &stream);
+  input_view->Release();
+  output_view->Release();
+  if (FAILED(hr)) {
+    RTC_LOG(LS_ERROR) << "VideoProcessorBlt failed: " << hr;
+    return nullptr;
+  }
+  return output;
+}
+}  // namespace base
+}  // namespace owt
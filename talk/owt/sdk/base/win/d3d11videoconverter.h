@@ -0,0 +1,48 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_WIN_D3D11VIDEOCONVERTER_H_
+#define OWT_BASE_WIN_D3D11VIDEOCONVERTER_H_
+#include <d3d11.h>
+#include <vector>
+#include "webrtc/rtc_base/criticalsection.h"
+#include "webrtc/rtc_base/constructormagic.h"
+namespace owt {
+namespace base {
+// GPU color-space conversion stage for captured desktop/window frames.
+// Converts BGRA textures into NV12 textures with the D3D11 video processor,
+// so frames headed for the hardware encoder never need a CPU ARGB-to-I420
+// pass. The fixed-function video processor is used instead of a custom
+// compute shader; it is available on every GPU the MSDK encoder supports
+// and shares the same device management as D3D11FrameAllocator.
+class D3D11VideoConverter {
+ public:
+  D3D11VideoConverter();
+  ~D3D11VideoConverter();
+  // Initializes video device interfaces on |device|. Returns false when the
+  // device exposes no video processor; callers then keep the CPU path.
+  bool Init(ID3D11Device* device);
+  // Converts BGRA |source| into an NV12 texture of the same dimensions.
+  // The returned texture comes from an internal ring sized |pool_size| at
+  // Init and stays valid until the ring wraps. Returns nullptr on failure.
+  ID3D11Texture2D* Convert(ID3D11Texture2D* source);
+ private:
+  bool EnsureProcessor(int width, int height);
+  ID3D11Texture2D* GetOutputTexture(int width, int height);
+  void ReleaseOutputTextures();
+  ID3D11Device* device_;
+  ID3D11DeviceContext* context_;
+  ID3D11VideoDevice* video_device_;
+  ID3D11VideoContext* video_context_;
+  ID3D11VideoProcessorEnumerator* processor_enum_;
+  ID3D11VideoProcessor* processor_;
+  std::vector<ID3D11Texture2D*> output_textures_;
+  size_t output_index_;
+  int width_;
+  int height_;
+  rtc::CriticalSection lock_;
+  RTC_DISALLOW_COPY_AND_ASSIGN(D3D11VideoConverter);
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_WIN_D3D11VIDEOCONVERTER_H_
@@ -4,8 +4,10 @@
 #ifndef OWT_BASE_WIN_D3DNATIVEFRAME_H
 #define OWT_BASE_WIN_D3DNATIVEFRAME_H
 #include <d3d9.h>
+#include <d3d11.h>
 #include <dxva2api.h>
 #include "webrtc/common_video/include/video_frame_buffer.h"
+#include "talk/owt/sdk/base/nativehandlebuffer.h"
 namespace owt {
 namespace base {
 // structure that containts d3d9 device manager
@@ -17,6 +19,63 @@ struct NativeD3DSurfaceHandle {
   int width_;   // width of the frame passing from decoder
   int height_;  // height of the frame passing from decoder
 };
+// Structure that contains a d3d11 device and a texture produced by a GPU
+// frame source. Frames carrying this handle travel through the pipeline by
+// reference and never touch system memory.
+struct D3D11ImageHandle {
+  ID3D11Device* d3d11_device;
+  ID3D11Texture2D* texture;
+  int array_index;  // Subresource index when |texture| is a texture array.
+  int width_;   // width of the frame
+  int height_;  // height of the frame
+  // Optional synchronization for textures shared across devices or filled
+  // by GPU work still in flight when the frame is handed over. A producer
+  // that creates its texture with D3D11_RESOURCE_MISC_SHARED_KEYEDMUTEX
+  // attaches the mutex here; consumers then wait on |acquire_key| instead
+  // of the producer flushing the whole device, so stages overlap their GPU
+  // work. Null when producer and consumer share one immediate context and
+  // command order already serializes access.
+  IDXGIKeyedMutex* keyed_mutex;
+  uint64_t acquire_key;
+  uint64_t release_key;
+  // Waits until the producer's GPU work on the texture is visible, up to
+  // |timeout_ms|. Returns false when the wait timed out or the mutex was
+  // abandoned; the frame is stale and should be dropped. Always true when
+  // no mutex is attached.
+  bool AcquireSync(uint32_t timeout_ms) const {
+    if (!keyed_mutex)
+      return true;
+    return keyed_mutex->AcquireSync(acquire_key, timeout_ms) == S_OK;
+  }
+  // Hands the texture back to the producer once the consumer's GPU work
+  // on it is submitted. No-op when no mutex is attached.
+  void ReleaseSync() const {
+    if (keyed_mutex)
+      keyed_mutex->ReleaseSync(release_key);
+  }
+};
+// VideoFrameBuffer wrapping a D3D11ImageHandle. Owns the handle structure
+// and a reference on the texture, released together with the buffer.
+class D3D11HandleBuffer : public NativeHandleBuffer {
+ public:
+  explicit D3D11HandleBuffer(const D3D11ImageHandle& handle)
+      : NativeHandleBuffer(&image_handle_, handle.width_, handle.height_),
+        image_handle_(handle) {
+    if (image_handle_.texture)
+      image_handle_.texture->AddRef();
+    if (image_handle_.keyed_mutex)
+      image_handle_.keyed_mutex->AddRef();
+  }
+  virtual ~D3D11HandleBuffer() {
+    if (image_handle_.texture)
+      image_handle_.texture->Release();
+    if (image_handle_.keyed_mutex)
+      image_handle_.keyed_mutex->Release();
+  }
+  HandleType handle_type() const override { return kD3D11Texture; }
+ private:
+  D3D11ImageHandle image_handle_;
+};
 }
 }
 #endif  // OWT_BASE_WIN_D3DNATIVEFRAME_H
@@ -0,0 +1,137 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "talk/owt/sdk/base/win/decodethreadpool.h"
+#include "talk/owt/sdk/base/win/threadaffinity.h"
+#include "talk/owt/sdk/include/cpp/owt/base/globalconfiguration.h"
+#include "webrtc/rtc_base/checks.h"
+#include "webrtc/rtc_base/logging.h"
+
+namespace owt {
+namespace base {
+
+namespace {
+// A stream averaging above this per frame is treated as heavy and moved
+// to an empty lane when one exists. Roughly the cost of a software-ish
+// 1080p30 frame; thumbnails land one to two orders of magnitude below.
+const int64_t kHeavyDecodeTimeUs = 4000;
+}  // namespace
+
+std::mutex DecodeThreadPool::get_singleton_mutex;
+DecodeThreadPool* DecodeThreadPool::singleton = nullptr;
+
+DecodeThreadPool* DecodeThreadPool::Get() {
+  std::lock_guard<std::mutex> lock(get_singleton_mutex);
+  if (singleton == nullptr) {
+    singleton = new DecodeThreadPool();
+  }
+  return singleton;
+}
+
+DecodeThreadPool::DecodeThreadPool() {
+  int size = GlobalConfiguration::GetDecodeThreadPoolSize();
+  if (size < 1) {
+    size = 1;
+  }
+  uint64_t affinity_mask = GlobalConfiguration::GetCodecThreadAffinityMask();
+  for (int i = 0; i < size; i++) {
+    Lane lane;
+    lane.thread.reset(new rtc::Thread());
+    lane.thread->SetName("MSDKVideoDecoderLane", nullptr);
+    RTC_CHECK(lane.thread->Start()) << "Failed to start decoder lane";
+    if (affinity_mask != 0) {
+      lane.thread->Invoke<void>(RTC_FROM_HERE, [affinity_mask] {
+        ApplyThreadAffinityMask(affinity_mask);
+      });
+    }
+    lane.client_count = 0;
+    lane.load_us = 0;
+    lanes_.push_back(std::move(lane));
+  }
+}
+
+void DecodeThreadPool::AcquireLane(const void* client) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // A new decoder's cost is unknown; start it on the lane carrying the
+  // least measured load, client count breaking ties.
+  size_t best = 0;
+  for (size_t i = 1; i < lanes_.size(); i++) {
+    if (lanes_[i].load_us < lanes_[best].load_us ||
+        (lanes_[i].load_us == lanes_[best].load_us &&
+         lanes_[i].client_count < lanes_[best].client_count)) {
+      best = i;
+    }
+  }
+  lanes_[best].client_count++;
+  ClientInfo info;
+  info.lane = best;
+  info.average_decode_time_us = 0;
+  clients_[client] = info;
+}
+
+void DecodeThreadPool::ReleaseLane(const void* client) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = clients_.find(client);
+  if (it == clients_.end()) {
+    return;
+  }
+  Lane& lane = lanes_[it->second.lane];
+  lane.client_count--;
+  lane.load_us -= it->second.average_decode_time_us;
+  RTC_LOG(LS_INFO) << "Decoder lane " << it->second.lane
+                   << " released; stream averaged "
+                   << it->second.average_decode_time_us << "us per frame.";
+  clients_.erase(it);
+}
+
+rtc::Thread* DecodeThreadPool::LaneFor(const void* client) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = clients_.find(client);
+  if (it == clients_.end()) {
+    return nullptr;
+  }
+  return lanes_[it->second.lane].thread.get();
+}
+
+void DecodeThreadPool::ReportDecodeTime(const void* client,
+                                        int64_t decode_time_us) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = clients_.find(client);
+  if (it == clients_.end()) {
+    return;
+  }
+  ClientInfo& info = it->second;
+  lanes_[info.lane].load_us -= info.average_decode_time_us;
+  if (info.average_decode_time_us == 0) {
+    info.average_decode_time_us = decode_time_us;
+  } else {
+    info.average_decode_time_us +=
+        (decode_time_us - info.average_decode_time_us) / 8;
+  }
+  lanes_[info.lane].load_us += info.average_decode_time_us;
+  // A heavy stream sharing its lane moves to an empty one when available,
+  // leaving the shared lane to the cheap decoders. Rebalancing runs on
+  // the reporting stream's own decode thread, so an Invoke this stream
+  // has in flight cannot race the reassignment.
+  if (info.average_decode_time_us >= kHeavyDecodeTimeUs &&
+      lanes_[info.lane].client_count > 1) {
+    for (size_t i = 0; i < lanes_.size(); i++) {
+      if (lanes_[i].client_count == 0) {
+        lanes_[info.lane].client_count--;
+        lanes_[info.lane].load_us -= info.average_decode_time_us;
+        lanes_[i].client_count = 1;
+        lanes_[i].load_us = info.average_decode_time_us;
+        RTC_LOG(LS_INFO) << "Moved heavy stream ("
+                         << info.average_decode_time_us
+                         << "us per frame) from decoder lane " << info.lane
+                         << " to dedicated lane " << i << ".";
+        info.lane = i;
+        break;
+      }
+    }
+  }
+}
+
+}  // namespace base
+}  // namespace owt
@@ -0,0 +1,66 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef OWT_BASE_WIN_DECODETHREADPOOL_H_
+#define OWT_BASE_WIN_DECODETHREADPOOL_H_
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "webrtc/rtc_base/thread.h"
+
+namespace owt {
+namespace base {
+
+/// Shared pool of decoder codec threads. Each MSDKVideoDecoder used to
+/// start a private thread, so a client with many subscriptions paid one
+/// mostly idle thread (and stack) per stream. The pool owns a fixed set
+/// of lanes (GlobalConfiguration::SetDecodeThreadPoolSize) and assigns
+/// decoders to them by measured decode cost: a stream whose frames are
+/// expensive is steered toward a lane of its own, so its blocking
+/// re-Init on a resolution switch does not queue behind other streams,
+/// while cheap thumbnail streams pack onto shared lanes.
+class DecodeThreadPool {
+ public:
+  static DecodeThreadPool* Get();
+
+  /// Assigns |client| to the least loaded lane. The assignment holds
+  /// until ReleaseLane, apart from cost-driven rebalancing.
+  void AcquireLane(const void* client);
+  void ReleaseLane(const void* client);
+  /// Returns the thread of the lane |client| is currently assigned to,
+  /// or nullptr when the client holds no lane.
+  rtc::Thread* LaneFor(const void* client);
+  /// Records one frame's decode wall time for |client|. Feeds the
+  /// exponential average that drives lane load and rebalancing.
+  void ReportDecodeTime(const void* client, int64_t decode_time_us);
+
+ private:
+  DecodeThreadPool();
+
+  struct Lane {
+    std::unique_ptr<rtc::Thread> thread;
+    size_t client_count;
+    // Sum of the assigned clients' average decode times; the load the
+    // lane would carry if every client decoded one frame.
+    int64_t load_us;
+  };
+  struct ClientInfo {
+    size_t lane;
+    int64_t average_decode_time_us;
+  };
+
+  static std::mutex get_singleton_mutex;
+  static DecodeThreadPool* singleton;
+
+  std::mutex mutex_;
+  std::vector<Lane> lanes_;
+  std::map<const void*, ClientInfo> clients_;
+};
+
+}  // namespace base
+}  // namespace owt
+
+#endif  // OWT_BASE_WIN_DECODETHREADPOOL_H_
@@ -0,0 +1,289 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "webrtc/rtc_base/logging.h"
+#include "webrtc/rtc_base/thread.h"
+#include "webrtc/rtc_base/timeutils.h"
+#include "talk/owt/sdk/base/win/dxgidesktopcapturer.h"
+using namespace rtc;
+namespace owt {
+namespace base {
+// Desktop duplication delivers frames on demand; pace acquisition at 30fps
+// to match the basic capturer's cadence.
+static const int kDxgiCaptureFps = 30;
+// Number of GPU textures cycled through while earlier frames are still
+// referenced by the encoder.
+static const size_t kDxgiTexturePoolSize = 4;
+// Milliseconds AcquireNextFrame waits for a new desktop image before we
+// treat the screen as unchanged and skip this cycle.
+static const UINT kAcquireTimeoutMs = 10;
+///////////////////////////////////////////////////////////////////////
+// Definition of private class DxgiCaptureThread that periodically
+// acquires desktop images.
+///////////////////////////////////////////////////////////////////////
+class DxgiDesktopCapturer::DxgiCaptureThread : public rtc::Thread,
+                                               public rtc::MessageHandler {
+ public:
+  explicit DxgiCaptureThread(DxgiDesktopCapturer* capturer)
+      : capturer_(capturer), finished_(false) {
+    waiting_time_ms_ = 1000 / kDxgiCaptureFps;
+  }
+  virtual ~DxgiCaptureThread() { Stop(); }
+  // Override virtual method of parent Thread. Context: Capture Thread.
+  virtual void Run() {
+    if (capturer_) {
+      capturer_->CaptureFrame();
+      rtc::Thread::Current()->Post(RTC_FROM_HERE, this);
+      rtc::Thread::Current()->ProcessMessages(kForever);
+    }
+    rtc::CritScope cs(&crit_);
+    finished_ = true;
+  }
+  // Override virtual method of parent MessageHandler. Context: Capture
+  // Thread.
+  virtual void OnMessage(rtc::Message* /*pmsg*/) {
+    if (capturer_) {
+      capturer_->CaptureFrame();
+      rtc::Thread::Current()->PostDelayed(RTC_FROM_HERE, waiting_time_ms_,
+                                          this);
+    } else {
+      rtc::Thread::Current()->Quit();
+    }
+  }
+  // Check if Run() is finished.
+  bool Finished() const {
+    rtc::CritScope cs(&crit_);
+    return finished_;
+  }
+ private:
+  DxgiDesktopCapturer* capturer_;
+  mutable rtc::CriticalSection crit_;
+  bool finished_;
+  int waiting_time_ms_;
+  RTC_DISALLOW_COPY_AND_ASSIGN(DxgiCaptureThread);
+};
+/////////////////////////////////////////////////////////////////////
+// Implementation of class DxgiDesktopCapturer.
+/////////////////////////////////////////////////////////////////////
+DxgiDesktopCapturer::DxgiDesktopCapturer(webrtc::DesktopCaptureOptions options)
+    : capture_thread_(nullptr),
+      d3d11_device_(nullptr),
+      d3d11_context_(nullptr),
+      output_duplication_(nullptr),
+      pool_index_(0),
+      width_(0),
+      height_(0) {
+  if (!InitDuplication()) {
+    RTC_LOG(LS_WARNING) << "Desktop duplication unavailable.";
+    ReleaseDuplication();
+  }
+}
+DxgiDesktopCapturer::~DxgiDesktopCapturer() {
+  Stop();
+  ReleaseDuplication();
+}
+bool DxgiDesktopCapturer::InitDuplication() {
+  D3D_FEATURE_LEVEL feature_level;
+  HRESULT hr = D3D11CreateDevice(
+      nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr,
+      D3D11_CREATE_DEVICE_BGRA_SUPPORT, nullptr, 0, D3D11_SDK_VERSION,
+      &d3d11_device_, &feature_level, &d3d11_context_);
+  if (FAILED(hr))
+    return false;
+  IDXGIDevice* dxgi_device = nullptr;
+  hr = d3d11_device_->QueryInterface(__uuidof(IDXGIDevice),
+                                     reinterpret_cast<void**>(&dxgi_device));
+  if (FAILED(hr))
+    return false;
+  IDXGIAdapter* adapter = nullptr;
+  hr = dxgi_device->GetAdapter(&adapter);
+  dxgi_device->Release();
+  if (FAILED(hr))
+    return false;
+  IDXGIOutput* output = nullptr;
+  hr = adapter->EnumOutputs(0, &output);
+  adapter->Release();
+  if (FAILED(hr))
+    return false;
+  DXGI_OUTPUT_DESC output_desc;
+  output->GetDesc(&output_desc);
+  width_ = output_desc.DesktopCoordinates.right -
+           output_desc.DesktopCoordinates.left;
+  height_ = output_desc.DesktopCoordinates.bottom -
+            output_desc.DesktopCoordinates.top;
+  IDXGIOutput1* output1 = nullptr;
+  hr = output->QueryInterface(__uuidof(IDXGIOutput1),
+                              reinterpret_cast<void**>(&output1));
+  output->Release();
+  if (FAILED(hr))
+    return false;
+  hr = output1->DuplicateOutput(d3d11_device_, &output_duplication_);
+  output1->Release();
+  if (FAILED(hr))
+    return false;
+  nv12_converter_.reset(new D3D11VideoConverter());
+  if (!nv12_converter_->Init(d3d11_device_)) {
+    // Frames stay BGRA; consumers fall back to CPU conversion.
+    nv12_converter_.reset();
+  }
+  return true;
+}
+void DxgiDesktopCapturer::ReleaseDuplication() {
+  for (auto* texture : texture_pool_) {
+    texture->Release();
+  }
+  texture_pool_.clear();
+  if (output_duplication_) {
+    output_duplication_->Release();
+    output_duplication_ = nullptr;
+  }
+  if (d3d11_context_) {
+    d3d11_context_->Release();
+    d3d11_context_ = nullptr;
+  }
+  if (d3d11_device_) {
+    d3d11_device_->Release();
+    d3d11_device_ = nullptr;
+  }
+}
+void DxgiDesktopCapturer::Init() {
+  cricket::VideoFormat format(width_, height_,
+                              cricket::VideoFormat::kMinimumInterval,
+                              cricket::FOURCC_ARGB);
+  std::vector<cricket::VideoFormat> supported;
+  supported.push_back(format);
+  SetSupportedFormats(supported);
+}
+CaptureState DxgiDesktopCapturer::Start(
+    const cricket::VideoFormat& capture_format) {
+  if (IsRunning()) {
+    RTC_LOG(LS_ERROR) << "DXGI desktop capturer is already running";
+    return CS_FAILED;
+  }
+  if (!IsValid()) {
+    RTC_LOG(LS_ERROR) << "Desktop duplication not initialized";
+    return CS_FAILED;
+  }
+  SetCaptureFormat(&capture_format);
+  capture_thread_ = new DxgiCaptureThread(this);
+  if (capture_thread_->Start()) {
+    RTC_LOG(LS_INFO) << "DXGI capture thread started";
+    return CS_RUNNING;
+  }
+  RTC_LOG(LS_ERROR) << "DXGI capture thread failed to start";
+  return CS_FAILED;
+}
+bool DxgiDesktopCapturer::IsRunning() {
+  return capture_thread_ && !capture_thread_->Finished();
+}
+void DxgiDesktopCapturer::Stop() {
+  if (capture_thread_) {
+    capture_thread_->Quit();
+    delete capture_thread_;
+    capture_thread_ = nullptr;
+    RTC_LOG(LS_INFO) << "DXGI capture thread stopped";
+  }
+  SetCaptureFormat(nullptr);
+}
+bool DxgiDesktopCapturer::GetPreferredFourccs(std::vector<uint32_t>* fourccs) {
+  if (!fourccs)
+    return false;
+  fourccs->push_back(GetSupportedFormats()->at(0).fourcc);
+  return true;
+}
+ID3D11Texture2D* DxgiDesktopCapturer::GetPooledTexture() {
+  rtc::CritScope cs(&lock_);
+  // Cycle through a fixed ring of textures. A frame's texture may be
+  // overwritten if the consumer lags more than kDxgiTexturePoolSize frames
+  // behind, which at 30fps means >130ms of encoder backlog; dropping stale
+  // pixels in that case is preferable to allocating per frame.
+  if (texture_pool_.size() == kDxgiTexturePoolSize) {
+    ID3D11Texture2D* texture = texture_pool_[pool_index_];
+    pool_index_ = (pool_index_ + 1) % kDxgiTexturePoolSize;
+    return texture;
+  }
+  D3D11_TEXTURE2D_DESC desc = {};
+  desc.Width = width_;
+  desc.Height = height_;
+  desc.MipLevels = 1;
+  desc.ArraySize = 1;
+  desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+  desc.SampleDesc.Count = 1;
+  desc.Usage = D3D11_USAGE_DEFAULT;
+  desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+  ID3D11Texture2D* texture = nullptr;
+  if (FAILED(d3d11_device_->CreateTexture2D(&desc, nullptr, &texture))) {
+    RTC_LOG(LS_ERROR) << "Failed to allocate capture texture";
+    return nullptr;
+  }
+  texture_pool_.push_back(texture);
+  return texture;
+}
+void DxgiDesktopCapturer::CaptureFrame() {
+  if (!output_duplication_)
+    return;
+  DXGI_OUTDUPL_FRAME_INFO frame_info;
+  IDXGIResource* resource = nullptr;
+  HRESULT hr = output_duplication_->AcquireNextFrame(kAcquireTimeoutMs,
+                                                     &frame_info, &resource);
+  if (hr == DXGI_ERROR_WAIT_TIMEOUT) {
+    // Screen content unchanged; nothing to deliver this cycle.
+    return;
+  }
+  if (hr == DXGI_ERROR_ACCESS_LOST) {
+    // Mode switch or desktop change; rebuild the duplication interface.
+    RTC_LOG(LS_WARNING) << "Desktop duplication access lost; recreating.";
+    ReleaseDuplication();
+    if (!InitDuplication())
+      ReleaseDuplication();
+    return;
+  }
+  if (FAILED(hr)) {
+    RTC_LOG(LS_ERROR) << "AcquireNextFrame failed: " << hr;
+    return;
+  }
+  ID3D11Texture2D* desktop_texture = nullptr;
+  hr = resource->QueryInterface(__uuidof(ID3D11Texture2D),
+                                reinterpret_cast<void**>(&desktop_texture));
+  resource->Release();
+  if (FAILED(hr)) {
+    output_duplication_->ReleaseFrame();
+    return;
+  }
+  // Copy GPU-to-GPU into a pooled texture so the duplication frame can be
+  // released immediately; the pooled texture is what travels downstream.
+  ID3D11Texture2D* frame_texture = GetPooledTexture();
+  if (!frame_texture) {
+    desktop_texture->Release();
+    output_duplication_->ReleaseFrame();
+    return;
+  }
+  d3d11_context_->CopyResource(frame_texture, desktop_texture);
+  desktop_texture->Release();
+  output_duplication_->ReleaseFrame();
+  // Convert to NV12 on the GPU when the device supports it; the hardware
+  // encoder then imports the texture without any color space work on CPU.
+  if (nv12_converter_) {
+    ID3D11Texture2D* nv12_texture = nv12_converter_->Convert(frame_texture);
+    if (nv12_texture)
+      frame_texture = nv12_texture;
+  }
+  D3D11ImageHandle handle;
+  handle.d3d11_device = d3d11_device_;
+  handle.texture = frame_texture;
+  handle.array_index = 0;
+  handle.width_ = width_;
+  handle.height_ = height_;
+  // The encoder copies from the same immediate context that filled the
+  // texture, so command order alone serializes access.
+  handle.keyed_mutex = nullptr;
+  handle.acquire_key = 0;
+  handle.release_key = 0;
+  rtc::scoped_refptr<D3D11HandleBuffer> buffer =
+      new rtc::RefCountedObject<D3D11HandleBuffer>(handle);
+  webrtc::VideoFrame captured_frame(buffer, 0, rtc::TimeMillis(),
+                                    webrtc::kVideoRotation_0);
+  OnFrame(captured_frame, width_, height_);
+}
+}  // namespace base
+}  // namespace owt
@@ -0,0 +1,66 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_WIN_DXGIDESKTOPCAPTURER_H_
+#define OWT_BASE_WIN_DXGIDESKTOPCAPTURER_H_
+#include <d3d11.h>
+#include <dxgi1_2.h>
+#include <memory>
+#include <vector>
+#include "webrtc/rtc_base/criticalsection.h"
+#include "talk/owt/sdk/base/desktopcapturer.h"
+#include "talk/owt/sdk/base/win/d3d11videoconverter.h"
+#include "talk/owt/sdk/base/win/d3dnativeframe.h"
+namespace owt {
+namespace base {
+// Screen capturer built on IDXGIOutputDuplication. Captured desktop images
+// stay on the GPU as D3D11 textures and are delivered downstream wrapped in
+// D3D11HandleBuffer, so a 4K desktop stream consumed by the hardware encoder
+// never touches system memory. Falls back to BasicScreenCapturer at creation
+// time when desktop duplication is not available (e.g. RDP sessions).
+class DxgiDesktopCapturer : public BasicDesktopCapturer {
+ public:
+  explicit DxgiDesktopCapturer(webrtc::DesktopCaptureOptions options);
+  virtual ~DxgiDesktopCapturer();
+  virtual void Init() override;
+  // Override virtual methods of parent class VideoCapturer.
+  virtual CaptureState Start(
+      const cricket::VideoFormat& capture_format) override;
+  virtual void Stop() override;
+  virtual bool IsRunning() override;
+  virtual bool IsScreencast() const override { return true; }
+  // Returns false when desktop duplication could not be initialized; the
+  // caller should fall back to BasicScreenCapturer.
+  bool IsValid() const { return output_duplication_ != nullptr; }
+ protected:
+  // Override virtual methods of parent class VideoCapturer.
+  virtual bool GetPreferredFourccs(std::vector<uint32_t>* fourccs) override;
+ private:
+  class DxgiCaptureThread;  // Forward declaration, defined in .cc.
+  friend class DxgiCaptureThread;
+  bool InitDuplication();
+  void ReleaseDuplication();
+  // Acquires one desktop image, copies it into a pooled GPU texture and
+  // signals it downstream. Executed in the context of DxgiCaptureThread.
+  void CaptureFrame();
+  // Returns a pooled texture matching the desktop size, allocating when the
+  // pool is empty. Copying out of the duplication frame lets us release the
+  // duplication interface immediately so the OS can continue presenting.
+  ID3D11Texture2D* GetPooledTexture();
+  DxgiCaptureThread* capture_thread_;
+  ID3D11Device* d3d11_device_;
+  ID3D11DeviceContext* d3d11_context_;
+  IDXGIOutputDuplication* output_duplication_;
+  std::vector<ID3D11Texture2D*> texture_pool_;
+  size_t pool_index_;
+  // Converts captured BGRA textures to NV12 on the GPU when available, so
+  // the hardware encoder can consume frames without a CPU conversion.
+  std::unique_ptr<D3D11VideoConverter> nv12_converter_;
+  int width_;
+  int height_;
+  rtc::CriticalSection lock_;
+  RTC_DISALLOW_COPY_AND_ASSIGN(DxgiDesktopCapturer);
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_WIN_DXGIDESKTOPCAPTURER_H_
@@ -0,0 +1,452 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include <mfapi.h>
+#include <mferror.h>
+#include "webrtc/rtc_base/logging.h"
+#include "webrtc/rtc_base/thread.h"
+#include "webrtc/rtc_base/timeutils.h"
+#include "talk/owt/sdk/base/win/mfcameracapturer.h"
+#include "talk/owt/sdk/base/win/msdkmjpegdecoder.h"
+namespace owt {
+namespace base {
+// Number of GPU textures cycled through while earlier frames are still
+// referenced by the encoder.
+static const size_t kMfTexturePoolSize = 4;
+// Converts a UTF-8 device ID to the wide form Media Foundation reports.
+static std::wstring ToWideString(const std::string& str) {
+  if (str.empty())
+    return std::wstring();
+  int length =
+      MultiByteToWideChar(CP_UTF8, 0, str.c_str(),
+                          static_cast<int>(str.size()), nullptr, 0);
+  std::wstring wide(length, L'\0');
+  MultiByteToWideChar(CP_UTF8, 0, str.c_str(), static_cast<int>(str.size()),
+                      &wide[0], length);
+  return wide;
+}
+///////////////////////////////////////////////////////////////////////
+// Definition of private class MfCaptureThread that pulls samples from
+// the source reader. ReadSample blocks until the camera delivers, so the
+// loop needs no pacing of its own.
+///////////////////////////////////////////////////////////////////////
+class MfCameraCapturer::MfCaptureThread : public rtc::Thread {
+ public:
+  explicit MfCaptureThread(MfCameraCapturer* capturer)
+      : capturer_(capturer), quit_(false), finished_(false) {}
+  virtual ~MfCaptureThread() { Stop(); }
+  // Override virtual method of parent Thread. Context: Capture Thread.
+  virtual void Run() {
+    while (!IsQuitting() && capturer_) {
+      capturer_->CaptureFrame();
+    }
+    rtc::CritScope cs(&crit_);
+    finished_ = true;
+  }
+  void SetQuitting() {
+    rtc::CritScope cs(&crit_);
+    quit_ = true;
+  }
+  bool IsQuitting() const {
+    rtc::CritScope cs(&crit_);
+    return quit_;
+  }
+  // Check if Run() is finished.
+  bool Finished() const {
+    rtc::CritScope cs(&crit_);
+    return finished_;
+  }
+ private:
+  MfCameraCapturer* capturer_;
+  mutable rtc::CriticalSection crit_;
+  bool quit_;
+  bool finished_;
+  RTC_DISALLOW_COPY_AND_ASSIGN(MfCaptureThread);
+};
+/////////////////////////////////////////////////////////////////////
+// Implementation of class MfCameraCapturer.
+/////////////////////////////////////////////////////////////////////
+std::unique_ptr<MfCameraCapturer> MfCameraCapturer::Create(
+    const std::string& device_id,
+    int width,
+    int height,
+    int fps) {
+  std::unique_ptr<MfCameraCapturer> capturer(
+      new MfCameraCapturer(width, height, fps));
+  if (!capturer->InitCapture(device_id)) {
+    RTC_LOG(LS_WARNING) << "D3D11 camera capture unavailable for device "
+                        << device_id;
+    return nullptr;
+  }
+  return capturer;
+}
+MfCameraCapturer::MfCameraCapturer(int width, int height, int fps)
+    : capture_thread_(nullptr),
+      d3d11_device_(nullptr),
+      d3d11_context_(nullptr),
+      device_manager_(nullptr),
+      device_manager_reset_token_(0),
+      media_source_(nullptr),
+      source_reader_(nullptr),
+      pool_index_(0),
+      width_(width),
+      height_(height),
+      fps_(fps) {}
+MfCameraCapturer::~MfCameraCapturer() {
+  Stop();
+  ReleaseCapture();
+}
+bool MfCameraCapturer::InitCapture(const std::string& device_id) {
+  HRESULT hr = MFStartup(MF_VERSION, MFSTARTUP_LITE);
+  if (FAILED(hr))
+    return false;
+  // The reader's video processor needs a device created with video
+  // support; multithread protection is required because the reader's
+  // worker threads and the capture thread share the immediate context.
+  D3D_FEATURE_LEVEL feature_level;
+  hr = D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr,
+                         D3D11_CREATE_DEVICE_VIDEO_SUPPORT |
+                             D3D11_CREATE_DEVICE_BGRA_SUPPORT,
+                         nullptr, 0, D3D11_SDK_VERSION, &d3d11_device_,
+                         &feature_level, &d3d11_context_);
+  if (FAILED(hr))
+    return false;
+  ID3D10Multithread* multithread = nullptr;
+  if (SUCCEEDED(d3d11_device_->QueryInterface(
+          __uuidof(ID3D10Multithread),
+          reinterpret_cast<void**>(&multithread)))) {
+    multithread->SetMultithreadProtected(TRUE);
+    multithread->Release();
+  }
+  hr = MFCreateDXGIDeviceManager(&device_manager_reset_token_,
+                                 &device_manager_);
+  if (FAILED(hr))
+    return false;
+  hr = device_manager_->ResetDevice(d3d11_device_,
+                                    device_manager_reset_token_);
+  if (FAILED(hr))
+    return false;
+  // Find the capture device matching |device_id| by symbolic link first,
+  // friendly name second, mirroring the system memory capturer's lookup.
+  IMFAttributes* enum_attributes = nullptr;
+  hr = MFCreateAttributes(&enum_attributes, 1);
+  if (FAILED(hr))
+    return false;
+  enum_attributes->SetGUID(MF_DEVSOURCE_ATTRIBUTE_SOURCE_TYPE,
+                           MF_DEVSOURCE_ATTRIBUTE_SOURCE_TYPE_VIDCAP_GUID);
+  IMFActivate** devices = nullptr;
+  UINT32 device_count = 0;
+  hr = MFEnumDeviceSources(enum_attributes, &devices, &device_count);
+  enum_attributes->Release();
+  if (FAILED(hr) || device_count == 0) {
+    CoTaskMemFree(devices);
+    return false;
+  }
+  std::wstring wide_id = ToWideString(device_id);
+  IMFActivate* selected = nullptr;
+  for (UINT32 i = 0; i < device_count; i++) {
+    WCHAR* link = nullptr;
+    WCHAR* name = nullptr;
+    UINT32 length = 0;
+    devices[i]->GetAllocatedString(
+        MF_DEVSOURCE_ATTRIBUTE_SOURCE_TYPE_VIDCAP_SYMBOLIC_LINK, &link,
+        &length);
+    devices[i]->GetAllocatedString(MF_DEVSOURCE_ATTRIBUTE_FRIENDLY_NAME,
+                                   &name, &length);
+    bool matched = (link != nullptr && wide_id == link) ||
+                   (name != nullptr && wide_id == name);
+    CoTaskMemFree(link);
+    CoTaskMemFree(name);
+    if (matched) {
+      selected = devices[i];
+      break;
+    }
+  }
+  if (selected != nullptr) {
+    hr = selected->ActivateObject(__uuidof(IMFMediaSource),
+                                  reinterpret_cast<void**>(&media_source_));
+  }
+  for (UINT32 i = 0; i < device_count; i++) {
+    devices[i]->Release();
+  }
+  CoTaskMemFree(devices);
+  if (selected == nullptr || FAILED(hr))
+    return false;
+  // Advanced video processing lets the reader's GPU video processor hand
+  // out NV12 textures even when the camera produces YUY2 or MJPG.
+  IMFAttributes* reader_attributes = nullptr;
+  hr = MFCreateAttributes(&reader_attributes, 2);
+  if (FAILED(hr))
+    return false;
+  reader_attributes->SetUnknown(MF_SOURCE_READER_D3D_MANAGER,
+                                device_manager_);
+  reader_attributes->SetUINT32(
+      MF_SOURCE_READER_ENABLE_ADVANCED_VIDEO_PROCESSING, TRUE);
+  hr = MFCreateSourceReaderFromMediaSource(media_source_, reader_attributes,
+                                           &source_reader_);
+  reader_attributes->Release();
+  if (FAILED(hr))
+    return false;
+  IMFMediaType* media_type = nullptr;
+  hr = MFCreateMediaType(&media_type);
+  if (FAILED(hr))
+    return false;
+  media_type->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Video);
+  media_type->SetGUID(MF_MT_SUBTYPE, MFVideoFormat_NV12);
+  MFSetAttributeSize(media_type, MF_MT_FRAME_SIZE, width_, height_);
+  MFSetAttributeRatio(media_type, MF_MT_FRAME_RATE, fps_, 1);
+  hr = source_reader_->SetCurrentMediaType(
+      MF_SOURCE_READER_FIRST_VIDEO_STREAM, nullptr, media_type);
+  media_type->Release();
+  if (SUCCEEDED(hr)) {
+    return true;
+  }
+  // 4K USB cameras commonly expose only MJPEG at full resolution, which
+  // the reader's video processor cannot turn into NV12. Take the native
+  // MJPEG stream instead and decode it on the GPU with the Media SDK
+  // JPEG decoder.
+  hr = MFCreateMediaType(&media_type);
+  if (FAILED(hr))
+    return false;
+  media_type->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Video);
+  media_type->SetGUID(MF_MT_SUBTYPE, MFVideoFormat_MJPG);
+  MFSetAttributeSize(media_type, MF_MT_FRAME_SIZE, width_, height_);
+  MFSetAttributeRatio(media_type, MF_MT_FRAME_RATE, fps_, 1);
+  hr = source_reader_->SetCurrentMediaType(
+      MF_SOURCE_READER_FIRST_VIDEO_STREAM, nullptr, media_type);
+  media_type->Release();
+  if (FAILED(hr)) {
+    RTC_LOG(LS_WARNING) << "Camera cannot deliver NV12 or MJPEG " << width_
+                        << "x" << height_ << "@" << fps_
+                        << " through the reader.";
+    return false;
+  }
+  mjpeg_decoder_ = MSDKMjpegDecoder::Create(d3d11_device_);
+  if (!mjpeg_decoder_) {
+    RTC_LOG(LS_WARNING)
+        << "Camera only delivers MJPEG and hardware JPEG decode is "
+           "unavailable; falling back to system memory capture.";
+    return false;
+  }
+  RTC_LOG(LS_INFO) << "Camera delivers native MJPEG; decoding on the GPU.";
+  return true;
+}
+void MfCameraCapturer::ReleaseCapture() {
+  for (auto* texture : texture_pool_) {
+    texture->Release();
+  }
+  texture_pool_.clear();
+  if (source_reader_) {
+    source_reader_->Release();
+    source_reader_ = nullptr;
+  }
+  if (media_source_) {
+    media_source_->Shutdown();
+    media_source_->Release();
+    media_source_ = nullptr;
+  }
+  if (device_manager_) {
+    device_manager_->Release();
+    device_manager_ = nullptr;
+  }
+  if (d3d11_context_) {
+    d3d11_context_->Release();
+    d3d11_context_ = nullptr;
+  }
+  if (d3d11_device_) {
+    d3d11_device_->Release();
+    d3d11_device_ = nullptr;
+  }
+  MFShutdown();
+}
+void MfCameraCapturer::Init() {
+  cricket::VideoFormat format(width_, height_,
+                              cricket::VideoFormat::FpsToInterval(fps_),
+                              cricket::FOURCC_NV12);
+  std::vector<cricket::VideoFormat> supported;
+  supported.push_back(format);
+  SetSupportedFormats(supported);
+}
+cricket::CaptureState MfCameraCapturer::Start(
+    const cricket::VideoFormat& capture_format) {
+  if (IsRunning()) {
+    RTC_LOG(LS_ERROR) << "Media Foundation camera capturer is already running";
+    return cricket::CS_FAILED;
+  }
+  SetCaptureFormat(&capture_format);
+  capture_thread_ = new MfCaptureThread(this);
+  if (capture_thread_->Start()) {
+    RTC_LOG(LS_INFO) << "Media Foundation capture thread started";
+    return cricket::CS_RUNNING;
+  }
+  RTC_LOG(LS_ERROR) << "Media Foundation capture thread failed to start";
+  return cricket::CS_FAILED;
+}
+bool MfCameraCapturer::IsRunning() {
+  return capture_thread_ && !capture_thread_->Finished();
+}
+void MfCameraCapturer::Stop() {
+  if (capture_thread_) {
+    capture_thread_->SetQuitting();
+    // A blocked ReadSample returns once the reader is flushed.
+    if (source_reader_) {
+      source_reader_->Flush(MF_SOURCE_READER_FIRST_VIDEO_STREAM);
+    }
+    capture_thread_->Stop();
+    delete capture_thread_;
+    capture_thread_ = nullptr;
+    RTC_LOG(LS_INFO) << "Media Foundation capture thread stopped";
+  }
+  SetCaptureFormat(nullptr);
+}
+bool MfCameraCapturer::GetPreferredFourccs(std::vector<uint32_t>* fourccs) {
+  if (!fourccs)
+    return false;
+  fourccs->push_back(GetSupportedFormats()->at(0).fourcc);
+  return true;
+}
+ID3D11Texture2D* MfCameraCapturer::GetPooledTexture() {
+  rtc::CritScope cs(&lock_);
+  // Cycle through a fixed ring of textures. A frame's texture may be
+  // overwritten if the consumer lags more than kMfTexturePoolSize frames
+  // behind; dropping stale pixels in that case is preferable to
+  // allocating per frame.
+  if (texture_pool_.size() == kMfTexturePoolSize) {
+    ID3D11Texture2D* texture = texture_pool_[pool_index_];
+    pool_index_ = (pool_index_ + 1) % kMfTexturePoolSize;
+    return texture;
+  }
+  D3D11_TEXTURE2D_DESC desc = {};
+  desc.Width = width_;
+  desc.Height = height_;
+  desc.MipLevels = 1;
+  desc.ArraySize = 1;
+  desc.Format = DXGI_FORMAT_NV12;
+  desc.SampleDesc.Count = 1;
+  desc.Usage = D3D11_USAGE_DEFAULT;
+  desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+  ID3D11Texture2D* texture = nullptr;
+  if (FAILED(d3d11_device_->CreateTexture2D(&desc, nullptr, &texture))) {
+    RTC_LOG(LS_ERROR) << "Failed to allocate capture texture";
+    return nullptr;
+  }
+  texture_pool_.push_back(texture);
+  return texture;
+}
+void MfCameraCapturer::CaptureFrame() {
+  if (!source_reader_)
+    return;
+  DWORD stream_index = 0;
+  DWORD stream_flags = 0;
+  LONGLONG sample_time = 0;
+  IMFSample* sample = nullptr;
+  HRESULT hr = source_reader_->ReadSample(MF_SOURCE_READER_FIRST_VIDEO_STREAM,
+                                          0, &stream_index, &stream_flags,
+                                          &sample_time, &sample);
+  if (FAILED(hr)) {
+    RTC_LOG(LS_ERROR) << "ReadSample failed: " << hr;
+    if (capture_thread_) {
+      capture_thread_->SetQuitting();
+    }
+    return;
+  }
+  if ((stream_flags & MF_SOURCE_READERF_ENDOFSTREAM) != 0) {
+    RTC_LOG(LS_WARNING) << "Camera stream ended.";
+    if (capture_thread_) {
+      capture_thread_->SetQuitting();
+    }
+  }
+  if (sample == nullptr) {
+    // Flush, gap or stream tick; nothing to deliver this cycle.
+    return;
+  }
+  IMFMediaBuffer* media_buffer = nullptr;
+  hr = sample->GetBufferByIndex(0, &media_buffer);
+  if (FAILED(hr)) {
+    sample->Release();
+    return;
+  }
+  ID3D11Texture2D* sample_texture = nullptr;
+  UINT subresource_index = 0;
+  IMFDXGIBuffer* dxgi_buffer = nullptr;
+  hr = media_buffer->QueryInterface(__uuidof(IMFDXGIBuffer),
+                                    reinterpret_cast<void**>(&dxgi_buffer));
+  if (SUCCEEDED(hr)) {
+    hr = dxgi_buffer->GetResource(__uuidof(ID3D11Texture2D),
+                                  reinterpret_cast<void**>(&sample_texture));
+    if (SUCCEEDED(hr)) {
+      dxgi_buffer->GetSubresourceIndex(&subresource_index);
+    }
+    dxgi_buffer->Release();
+    media_buffer->Release();
+    if (FAILED(hr)) {
+      sample->Release();
+      return;
+    }
+  } else if (mjpeg_decoder_) {
+    // Native MJPEG samples arrive in system memory; decode on the GPU
+    // into an NV12 surface from the shared pool.
+    BYTE* bitstream = nullptr;
+    DWORD max_length = 0;
+    DWORD current_length = 0;
+    bool decoded = false;
+    if (SUCCEEDED(media_buffer->Lock(&bitstream, &max_length,
+                                     &current_length))) {
+      decoded = mjpeg_decoder_->Decode(bitstream, current_length,
+                                       &sample_texture, &subresource_index);
+      media_buffer->Unlock();
+    }
+    media_buffer->Release();
+    if (!decoded) {
+      // A corrupt sample; skip it and read the next one.
+      sample->Release();
+      return;
+    }
+    // The decoded texture stays owned by the shared allocator; take a
+    // reference so the release after the copy below is uniform with the
+    // reader path.
+    sample_texture->AddRef();
+  } else {
+    // The reader fell back to system memory; this device cannot sustain
+    // the GPU path, so stop instead of silently copying every frame.
+    RTC_LOG(LS_ERROR) << "Camera sample carries no D3D11 texture.";
+    media_buffer->Release();
+    sample->Release();
+    if (capture_thread_) {
+      capture_thread_->SetQuitting();
+    }
+    return;
+  }
+  // Copy GPU-to-GPU into a pooled texture so the sample goes back to the
+  // reader's allocator immediately; the pooled texture is what travels
+  // downstream.
+  ID3D11Texture2D* frame_texture = GetPooledTexture();
+  if (!frame_texture) {
+    sample_texture->Release();
+    sample->Release();
+    return;
+  }
+  d3d11_context_->CopySubresourceRegion(frame_texture, 0, 0, 0, 0,
+                                        sample_texture, subresource_index,
+                                        nullptr);
+  sample_texture->Release();
+  sample->Release();
+  D3D11ImageHandle handle;
+  handle.d3d11_device = d3d11_device_;
+  handle.texture = frame_texture;
+  handle.array_index = 0;
+  handle.width_ = width_;
+  handle.height_ = height_;
+  // The encoder copies from the same immediate context that filled the
+  // texture, so command order alone serializes access.
+  handle.keyed_mutex = nullptr;
+  handle.acquire_key = 0;
+  handle.release_key = 0;
+  rtc::scoped_refptr<D3D11HandleBuffer> buffer =
+      new rtc::RefCountedObject<D3D11HandleBuffer>(handle);
+  webrtc::VideoFrame captured_frame(buffer, 0, rtc::TimeMillis(),
+                                    webrtc::kVideoRotation_0);
+  OnFrame(captured_frame, width_, height_);
+}
+}  // namespace base
+}  // namespace owt
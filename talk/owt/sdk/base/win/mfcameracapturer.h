@@ -0,0 +1,89 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_WIN_MFCAMERACAPTURER_H_
+#define OWT_BASE_WIN_MFCAMERACAPTURER_H_
+#include <d3d11.h>
+#include <mfidl.h>
+#include <mfreadwrite.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "webrtc/media/base/videocapturer.h"
+#include "webrtc/rtc_base/criticalsection.h"
+#include "talk/owt/sdk/base/win/d3dnativeframe.h"
+namespace owt {
+namespace base {
+class MSDKMjpegDecoder;
+// Camera capturer built on the Media Foundation source reader with a DXGI
+// device manager attached, so camera frames arrive as D3D11 NV12 textures
+// and are delivered downstream wrapped in D3D11HandleBuffer. A stream
+// destined for the hardware encoder on the same GPU never touches system
+// memory; formats the camera cannot produce natively (YUY2, MJPG) are
+// converted to NV12 by the GPU video processor inside the reader. When
+// the reader cannot deliver NV12 at all - typical for 4K USB cameras
+// that only expose MJPEG at full resolution - the capturer takes the
+// camera's native MJPEG stream and decodes it with the Media SDK JPEG
+// decoder into NV12 surfaces on the same device, instead of falling
+// back to software decompression. Enabled
+// through GlobalConfiguration::SetD3D11CameraCaptureEnabled; creation
+// falls back to the system memory capturer when Media Foundation cannot
+// deliver textures for the device.
+class MfCameraCapturer : public cricket::VideoCapturer {
+ public:
+  // Returns a ready-to-start capturer for |device_id| (symbolic link or
+  // friendly name), or nullptr when the device was not found or D3D11
+  // capture could not be initialized.
+  static std::unique_ptr<MfCameraCapturer> Create(const std::string& device_id,
+                                                  int width,
+                                                  int height,
+                                                  int fps);
+  virtual ~MfCameraCapturer();
+  void Init();
+  // Override virtual methods of parent class VideoCapturer.
+  virtual cricket::CaptureState Start(
+      const cricket::VideoFormat& capture_format) override;
+  virtual void Stop() override;
+  virtual bool IsRunning() override;
+  virtual bool IsScreencast() const override { return false; }
+ protected:
+  // Override virtual methods of parent class VideoCapturer.
+  virtual bool GetPreferredFourccs(std::vector<uint32_t>* fourccs) override;
+ private:
+  class MfCaptureThread;  // Forward declaration, defined in .cc.
+  friend class MfCaptureThread;
+  MfCameraCapturer(int width, int height, int fps);
+  // Builds the D3D11 device, DXGI device manager and source reader for
+  // |device_id|. Returns false when any stage fails; ReleaseCapture then
+  // tears down whatever was built.
+  bool InitCapture(const std::string& device_id);
+  void ReleaseCapture();
+  // Blocks on the reader for the next sample, copies its texture into a
+  // pooled one and signals it downstream. Executed in the context of
+  // MfCaptureThread; pacing comes from the camera itself.
+  void CaptureFrame();
+  // Returns a pooled NV12 texture, allocating when the ring is not full.
+  // Copying out of the reader's sample releases it back to the reader
+  // immediately, keeping its internal allocator from starving.
+  ID3D11Texture2D* GetPooledTexture();
+  MfCaptureThread* capture_thread_;
+  // Hardware JPEG decode stage, present only when the reader delivers
+  // native MJPEG samples instead of NV12 textures.
+  std::unique_ptr<MSDKMjpegDecoder> mjpeg_decoder_;
+  ID3D11Device* d3d11_device_;
+  ID3D11DeviceContext* d3d11_context_;
+  IMFDXGIDeviceManager* device_manager_;
+  UINT device_manager_reset_token_;
+  IMFMediaSource* media_source_;
+  IMFSourceReader* source_reader_;
+  std::vector<ID3D11Texture2D*> texture_pool_;
+  size_t pool_index_;
+  int width_;
+  int height_;
+  int fps_;
+  rtc::CriticalSection lock_;
+  RTC_DISALLOW_COPY_AND_ASSIGN(MfCameraCapturer);
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_WIN_MFCAMERACAPTURER_H_
@@ -0,0 +1,143 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "msdkmemorybudget.h"
+
+#include "talk/owt/sdk/include/cpp/owt/base/globalconfiguration.h"
+#include "webrtc/rtc_base/logging.h"
+
+namespace owt {
+namespace base {
+
+std::mutex MSDKMemoryBudget::get_singleton_mutex_;
+MSDKMemoryBudget* MSDKMemoryBudget::singleton_ = nullptr;
+
+MSDKMemoryBudget* MSDKMemoryBudget::Get() {
+  std::lock_guard<std::mutex> lock(get_singleton_mutex_);
+  if (singleton_ == nullptr) {
+    singleton_ = new MSDKMemoryBudget();
+  }
+  return singleton_;
+}
+
+uint64_t MSDKMemoryBudget::SurfaceBytes(mfxU32 width,
+                                        mfxU32 height,
+                                        mfxU32 fourcc) {
+  uint64_t pixels = (uint64_t)width * height;
+  switch (fourcc) {
+    case MFX_FOURCC_NV12:
+    case MFX_FOURCC_YV12:
+      return pixels * 3 / 2;
+    case MFX_FOURCC_P010:
+      return pixels * 3;
+    case MFX_FOURCC_YUY2:
+      return pixels * 2;
+    case MFX_FOURCC_RGB4:
+      return pixels * 4;
+    case MFX_FOURCC_P8:
+      return pixels;
+    default:
+      // Unknown layouts are charged as 32bpp so the budget stays an
+      // upper bound.
+      return pixels * 4;
+  }
+}
+
+uint64_t MSDKMemoryBudget::BudgetBytes() const {
+  int budget_mb = GlobalConfiguration::GetGpuSurfaceBudgetMB();
+  return budget_mb > 0 ? (uint64_t)budget_mb * 1024 * 1024 : 0;
+}
+
+bool MSDKMemoryBudget::CanAllocate(mfxU32 width,
+                                   mfxU32 height,
+                                   mfxU32 fourcc,
+                                   mfxU16 num_frames) const {
+  uint64_t budget = BudgetBytes();
+  if (budget == 0) {
+    return true;
+  }
+  uint64_t bytes = SurfaceBytes(width, height, fourcc) * num_frames;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (allocated_bytes_ + bytes > budget) {
+    RTC_LOG(LS_WARNING) << "GPU surface budget exceeded: "
+                        << (allocated_bytes_ >> 20) << "MB in use, pool of "
+                        << num_frames << " " << width << "x" << height
+                        << " surfaces (" << (bytes >> 20)
+                        << "MB) refused against a budget of "
+                        << (budget >> 20) << "MB.";
+    return false;
+  }
+  return true;
+}
+
+void MSDKMemoryBudget::OnPoolAllocated(mfxMemId first_mid,
+                                       mfxU32 width,
+                                       mfxU32 height,
+                                       mfxU32 fourcc,
+                                       mfxU16 num_frames) {
+  uint64_t bytes = SurfaceBytes(width, height, fourcc) * num_frames;
+  std::lock_guard<std::mutex> lock(mutex_);
+  PoolRecord record;
+  record.width = (mfxU16)width;
+  record.height = (mfxU16)height;
+  record.surfaces = num_frames;
+  record.bytes = bytes;
+  pools_[first_mid] = record;
+  allocated_bytes_ += bytes;
+
+  uint32_t key = (width << 16) | height;
+  ResolutionStats& stats = resolutions_[key];
+  stats.width = (mfxU16)width;
+  stats.height = (mfxU16)height;
+  stats.allocated_surfaces += num_frames;
+  stats.allocated_bytes += bytes;
+  if (stats.allocated_surfaces > stats.peak_surfaces) {
+    stats.peak_surfaces = stats.allocated_surfaces;
+  }
+}
+
+void MSDKMemoryBudget::OnPoolReleased(mfxMemId first_mid) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = pools_.find(first_mid);
+  if (it == pools_.end()) {
+    return;
+  }
+  const PoolRecord& record = it->second;
+  allocated_bytes_ -= record.bytes;
+  uint32_t key = ((uint32_t)record.width << 16) | record.height;
+  auto res = resolutions_.find(key);
+  if (res != resolutions_.end()) {
+    res->second.allocated_surfaces -= record.surfaces;
+    res->second.allocated_bytes -= record.bytes;
+  }
+  pools_.erase(it);
+}
+
+void MSDKMemoryBudget::GetStats(
+    std::map<uint32_t, ResolutionStats>* stats) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  *stats = resolutions_;
+}
+
+// Defined here rather than in globalconfiguration.cc because the budget
+// accounting only exists in the Windows MSDK path.
+std::vector<GpuSurfacePoolStats> GlobalConfiguration::GetGpuSurfacePoolStats() {
+  std::map<uint32_t, MSDKMemoryBudget::ResolutionStats> records;
+  MSDKMemoryBudget::Get()->GetStats(&records);
+  std::vector<GpuSurfacePoolStats> stats;
+  stats.reserve(records.size());
+  for (auto it = records.rbegin(); it != records.rend(); ++it) {
+    GpuSurfacePoolStats entry;
+    entry.width = it->second.width;
+    entry.height = it->second.height;
+    entry.allocated_surfaces = it->second.allocated_surfaces;
+    entry.peak_surfaces = it->second.peak_surfaces;
+    entry.allocated_bytes = it->second.allocated_bytes;
+    stats.push_back(entry);
+  }
+  return stats;
+}
+
+}  // namespace base
+}  // namespace owt
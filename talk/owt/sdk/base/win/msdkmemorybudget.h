@@ -0,0 +1,86 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef OWT_BASE_WIN_MSDKMEMORYBUDGET_H_
+#define OWT_BASE_WIN_MSDKMEMORYBUDGET_H_
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+
+#include "mfxstructures.h"
+
+namespace owt {
+namespace base {
+
+/// Process-wide accounting of the GPU surface memory handed out by the
+/// MSDK frame allocators. Usage is tracked per resolution so a client
+/// packing many decodes onto one GPU can observe pool pressure before the
+/// driver runs out, and the optional budget set through
+/// GlobalConfiguration is enforced at allocation time: a pool that would
+/// push usage past the budget is refused, which the codec surfaces as an
+/// ordinary allocation failure instead of an opaque mid-stream error.
+class MSDKMemoryBudget {
+ public:
+  /// Per-resolution usage snapshot.
+  struct ResolutionStats {
+    mfxU16 width;
+    mfxU16 height;
+    int allocated_surfaces;
+    int peak_surfaces;
+    uint64_t allocated_bytes;
+  };
+
+  static MSDKMemoryBudget* Get();
+
+  /// Returns false when a pool of |num_frames| surfaces of the given
+  /// geometry would exceed the configured budget. Always true when no
+  /// budget is set.
+  bool CanAllocate(mfxU32 width,
+                   mfxU32 height,
+                   mfxU32 fourcc,
+                   mfxU16 num_frames) const;
+  /// Records a successfully allocated pool. |first_mid| keys the pool for
+  /// the matching OnPoolReleased call.
+  void OnPoolAllocated(mfxMemId first_mid,
+                       mfxU32 width,
+                       mfxU32 height,
+                       mfxU32 fourcc,
+                       mfxU16 num_frames);
+  void OnPoolReleased(mfxMemId first_mid);
+
+  /// Copies the per-resolution usage records into |stats|, largest
+  /// resolution first.
+  void GetStats(std::map<uint32_t, ResolutionStats>* stats) const;
+
+ private:
+  MSDKMemoryBudget() : allocated_bytes_(0) {}
+
+  // Approximate footprint of one surface from its fourcc; the driver may
+  // pad, so this intentionally rounds the budget check conservatively up.
+  static uint64_t SurfaceBytes(mfxU32 width, mfxU32 height, mfxU32 fourcc);
+  uint64_t BudgetBytes() const;
+
+  struct PoolRecord {
+    mfxU16 width;
+    mfxU16 height;
+    mfxU16 surfaces;
+    uint64_t bytes;
+  };
+
+  static MSDKMemoryBudget* singleton_;
+  static std::mutex get_singleton_mutex_;
+  mutable std::mutex mutex_;
+  // Live pools keyed by their first mid, which the allocator hands to
+  // both AllocImpl and ReleaseResponse.
+  std::map<mfxMemId, PoolRecord> pools_;
+  // Usage per resolution keyed by (width << 16) | height; entries persist
+  // after their pools are freed so peaks remain observable.
+  std::map<uint32_t, ResolutionStats> resolutions_;
+  uint64_t allocated_bytes_;
+};
+
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_WIN_MSDKMEMORYBUDGET_H_
@@ -0,0 +1,223 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "talk/owt/sdk/base/win/msdkmjpegdecoder.h"
+#include <string.h>
+#include "talk/owt/sdk/base/win/msdkvideobase.h"
+#include "webrtc/rtc_base/logging.h"
+
+namespace owt {
+namespace base {
+
+// Initial bitstream capacity. A 4K MJPEG sample is typically well under
+// a megabyte; FillBitstream grows the buffer if a camera proves
+// otherwise.
+static const mfxU32 kMjpegInitialBitstreamSize = 1024 * 1024;
+
+std::unique_ptr<MSDKMjpegDecoder> MSDKMjpegDecoder::Create(
+    ID3D11Device* device) {
+  if (device == nullptr)
+    return nullptr;
+  if (!MSDKFactory::Get()->QueryDecoderSupport(MFX_CODEC_JPEG)) {
+    RTC_LOG(LS_INFO) << "Platform cannot hardware-decode JPEG.";
+    return nullptr;
+  }
+  std::unique_ptr<MSDKMjpegDecoder> decoder(new MSDKMjpegDecoder(device));
+  if (!decoder->Init())
+    return nullptr;
+  return decoder;
+}
+
+MSDKMjpegDecoder::MSDKMjpegDecoder(ID3D11Device* device)
+    : device_(device),
+      m_mfxSession(nullptr),
+      m_pmfxDEC(nullptr),
+      m_pOutputSurfaces(nullptr),
+      inited_(false) {
+  MSDK_ZERO_MEMORY(m_mfxVideoParams);
+  MSDK_ZERO_MEMORY(m_mfxBS);
+  MSDK_ZERO_MEMORY(m_mfxResponse);
+}
+
+MSDKMjpegDecoder::~MSDKMjpegDecoder() {
+  Close();
+}
+
+bool MSDKMjpegDecoder::Init() {
+  MSDKFactory* factory = MSDKFactory::Get();
+  // The session lives on the capturer's device so decoded surfaces are
+  // directly copyable into the capturer's texture pool.
+  m_mfxSession = factory->CreateD3D11Session(device_);
+  if (!m_mfxSession)
+    return false;
+  m_pMFXAllocator = factory->GetSharedFrameAllocator(device_);
+  if (!m_pMFXAllocator) {
+    Close();
+    return false;
+  }
+  if (MFX_ERR_NONE != m_mfxSession->SetFrameAllocator(m_pMFXAllocator.get())) {
+    Close();
+    return false;
+  }
+  m_pmfxDEC = new MFXVideoDECODE(*m_mfxSession);
+  if (m_pmfxDEC == nullptr) {
+    Close();
+    return false;
+  }
+  m_mfxBS.Data = new mfxU8[kMjpegInitialBitstreamSize];
+  m_mfxBS.MaxLength = kMjpegInitialBitstreamSize;
+  return true;
+}
+
+void MSDKMjpegDecoder::Close() {
+  if (m_pmfxDEC != nullptr) {
+    m_pmfxDEC->Close();
+    MSDK_SAFE_DELETE(m_pmfxDEC);
+  }
+  surface_pool_.Clear();
+  MSDK_SAFE_DELETE_ARRAY(m_pOutputSurfaces);
+  if (m_pMFXAllocator && m_mfxResponse.NumFrameActual > 0) {
+    m_pMFXAllocator->Free(m_pMFXAllocator->pthis, &m_mfxResponse);
+    MSDK_ZERO_MEMORY(m_mfxResponse);
+  }
+  m_pMFXAllocator.reset();
+  if (m_mfxSession != nullptr) {
+    MSDKFactory* factory = MSDKFactory::Get();
+    if (factory) {
+      factory->DestroySession(m_mfxSession);
+    }
+    m_mfxSession = nullptr;
+  }
+  MSDK_SAFE_DELETE_ARRAY(m_mfxBS.Data);
+  MSDK_ZERO_MEMORY(m_mfxBS);
+  inited_ = false;
+}
+
+bool MSDKMjpegDecoder::FillBitstream(const uint8_t* data, size_t size) {
+  // Every MJPEG sample is a self-contained frame, so the bitstream never
+  // carries leftovers across calls.
+  if (size > m_mfxBS.MaxLength) {
+    mfxU32 new_size =
+        MSDK_MAX(m_mfxBS.MaxLength * 2, static_cast<mfxU32>(size));
+    mfxU8* new_data = new mfxU8[new_size];
+    MSDK_SAFE_DELETE_ARRAY(m_mfxBS.Data);
+    m_mfxBS.Data = new_data;
+    m_mfxBS.MaxLength = new_size;
+  }
+  memcpy(m_mfxBS.Data, data, size);
+  m_mfxBS.DataOffset = 0;
+  m_mfxBS.DataLength = static_cast<mfxU32>(size);
+  m_mfxBS.DataFlag = MFX_BITSTREAM_COMPLETE_FRAME;
+  return true;
+}
+
+bool MSDKMjpegDecoder::InitDecoderFromBitstream() {
+  m_mfxVideoParams.mfx.CodecId = MFX_CODEC_JPEG;
+  m_mfxVideoParams.IOPattern = MFX_IOPATTERN_OUT_VIDEO_MEMORY;
+  mfxStatus sts = m_pmfxDEC->DecodeHeader(&m_mfxBS, &m_mfxVideoParams);
+  if (MFX_ERR_NONE != sts) {
+    RTC_LOG(LS_ERROR) << "Failed to parse MJPEG headers: " << sts;
+    return false;
+  }
+  // The camera delivers NV12-convertible 4:2:2 or 4:2:0 scans; the JPEG
+  // decoder performs the color conversion on the GPU.
+  m_mfxVideoParams.mfx.FrameInfo.FourCC = MFX_FOURCC_NV12;
+  m_mfxVideoParams.mfx.FrameInfo.ChromaFormat = MFX_CHROMAFORMAT_YUV420;
+  mfxFrameAllocRequest request;
+  MSDK_ZERO_MEMORY(request);
+  sts = m_pmfxDEC->QueryIOSurf(&m_mfxVideoParams, &request);
+  if (MFX_WRN_PARTIAL_ACCELERATION == sts) {
+    sts = MFX_ERR_NONE;
+  }
+  if (MFX_ERR_NONE != sts) {
+    RTC_LOG(LS_ERROR) << "QueryIOSurf for MJPEG decode failed: " << sts;
+    return false;
+  }
+  sts = m_pMFXAllocator->Alloc(m_pMFXAllocator->pthis, &request,
+                               &m_mfxResponse);
+  if (MFX_ERR_NONE != sts) {
+    RTC_LOG(LS_ERROR) << "Failed to allocate MJPEG output surfaces: " << sts;
+    return false;
+  }
+  mfxU16 surface_count = m_mfxResponse.NumFrameActual;
+  m_pOutputSurfaces = new mfxFrameSurface1[surface_count];
+  for (mfxU16 i = 0; i < surface_count; i++) {
+    MSDK_ZERO_MEMORY(m_pOutputSurfaces[i]);
+    m_pOutputSurfaces[i].Info = m_mfxVideoParams.mfx.FrameInfo;
+    m_pOutputSurfaces[i].Data.MemId = m_mfxResponse.mids[i];
+  }
+  surface_pool_.Assign(m_pOutputSurfaces, surface_count);
+  surface_pool_.SetGaugeName("msdk.mjpeg_decode.locked_surfaces");
+  sts = m_pmfxDEC->Init(&m_mfxVideoParams);
+  if (MFX_WRN_PARTIAL_ACCELERATION == sts) {
+    sts = MFX_ERR_NONE;
+  }
+  if (MFX_ERR_NONE != sts) {
+    RTC_LOG(LS_ERROR) << "MJPEG decoder Init failed: " << sts;
+    return false;
+  }
+  return true;
+}
+
+bool MSDKMjpegDecoder::Decode(const uint8_t* data,
+                              size_t size,
+                              ID3D11Texture2D** texture,
+                              UINT* subresource) {
+  if (data == nullptr || size == 0 || texture == nullptr ||
+      subresource == nullptr) {
+    return false;
+  }
+  if (!FillBitstream(data, size))
+    return false;
+  if (!inited_) {
+    if (!InitDecoderFromBitstream())
+      return false;
+    inited_ = true;
+  }
+  mfxFrameSurface1* output_surface = nullptr;
+  mfxSyncPoint sync_point = nullptr;
+  mfxStatus sts = MFX_ERR_NONE;
+  while (true) {
+    mfxU16 free_idx = surface_pool_.WaitForFreeSurface(MSDK_SURFACE_WAIT_INTERVAL);
+    if (free_idx == MSDK_INVALID_SURF_IDX) {
+      RTC_LOG(LS_ERROR) << "No free surface for MJPEG decode.";
+      return false;
+    }
+    sts = m_pmfxDEC->DecodeFrameAsync(&m_mfxBS, &m_pOutputSurfaces[free_idx],
+                                      &output_surface, &sync_point);
+    if (MFX_WRN_DEVICE_BUSY == sts) {
+      MSDK_SLEEP(1);
+      continue;
+    }
+    if (MFX_ERR_MORE_SURFACE == sts) {
+      continue;
+    }
+    break;
+  }
+  if (sts < MFX_ERR_NONE || sync_point == nullptr) {
+    // A corrupt sample from the camera is not fatal; the caller skips
+    // the frame and reads the next one.
+    RTC_LOG(LS_WARNING) << "MJPEG decode failed for a sample: " << sts;
+    return false;
+  }
+  sts = m_mfxSession->SyncOperation(sync_point, MSDK_DEC_WAIT_INTERVAL);
+  surface_pool_.NotifySurfaceReleased();
+  if (MFX_ERR_NONE != sts) {
+    RTC_LOG(LS_WARNING) << "MJPEG decode sync failed: " << sts;
+    return false;
+  }
+  mfxHDLPair pair = {};
+  sts = m_pMFXAllocator->GetFrameHDL(output_surface->Data.MemId,
+                                     reinterpret_cast<mfxHDL*>(&pair));
+  if (MFX_ERR_NONE != sts || pair.first == nullptr) {
+    RTC_LOG(LS_ERROR) << "Cannot resolve decoded MJPEG surface texture.";
+    return false;
+  }
+  *texture = reinterpret_cast<ID3D11Texture2D*>(pair.first);
+  *subresource = static_cast<UINT>(reinterpret_cast<UINT_PTR>(pair.second));
+  return true;
+}
+
+}  // namespace base
+}  // namespace owt
@@ -0,0 +1,65 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef OWT_BASE_WIN_MSDKMJPEGDECODER_H_
+#define OWT_BASE_WIN_MSDKMJPEGDECODER_H_
+
+#include <d3d11.h>
+#include <memory>
+#include "talk/owt/sdk/base/win/d3d11_allocator.h"
+#include "talk/owt/sdk/base/win/msdksurfacepool.h"
+#include "mfxvideo++.h"
+
+namespace owt {
+namespace base {
+// Hardware MJPEG decoder for the camera capture path. High-resolution
+// USB cameras deliver MJPEG, which would otherwise be decompressed in
+// software before a frame ever reaches the encode pipeline. This decoder
+// runs the Media SDK JPEG decoder on the capturer's D3D11 device and
+// produces NV12 surfaces from the device's shared surface pool, so a
+// 4K MJPEG sample becomes an encoder-ready texture without touching the
+// CPU. One instance serves one capturer; Decode is synchronous and is
+// called from the capture thread, which is paced by the camera itself.
+class MSDKMjpegDecoder {
+ public:
+  // Returns a ready decoder sharing |device| with the capturer, or
+  // nullptr when the platform cannot hardware-decode JPEG. The decode
+  // pipeline itself is initialized from the first sample's headers.
+  static std::unique_ptr<MSDKMjpegDecoder> Create(ID3D11Device* device);
+  ~MSDKMjpegDecoder();
+  // Decodes one complete MJPEG frame. On success |texture| and
+  // |subresource| name the NV12 surface holding the decoded frame; the
+  // texture stays owned by the shared allocator and is valid until the
+  // next Decode call, so the caller must copy out of it before asking
+  // for the next frame. Returns false on a malformed sample or device
+  // failure.
+  bool Decode(const uint8_t* data,
+              size_t size,
+              ID3D11Texture2D** texture,
+              UINT* subresource);
+
+ private:
+  explicit MSDKMjpegDecoder(ID3D11Device* device);
+  bool Init();
+  // Parses the first sample's headers and allocates the output surface
+  // chain. Context: capture thread, inside the first Decode.
+  bool InitDecoderFromBitstream();
+  void Close();
+  // Copies |data| into |m_mfxBS| as one complete frame, growing the
+  // bitstream buffer when a sample outgrows it.
+  bool FillBitstream(const uint8_t* data, size_t size);
+  ID3D11Device* device_;
+  MFXVideoSession* m_mfxSession;
+  std::shared_ptr<D3D11FrameAllocator> m_pMFXAllocator;
+  MFXVideoDECODE* m_pmfxDEC;
+  mfxVideoParam m_mfxVideoParams;
+  mfxBitstream m_mfxBS;
+  mfxFrameSurface1* m_pOutputSurfaces;
+  mfxFrameAllocResponse m_mfxResponse;
+  MSDKSurfacePool surface_pool_;
+  bool inited_;
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_WIN_MSDKMJPEGDECODER_H_
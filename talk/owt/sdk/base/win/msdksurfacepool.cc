@@ -0,0 +1,84 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <chrono>
+#include "msdkcommon.h"
+#include "msdksurfacepool.h"
+#include "talk/owt/sdk/base/queuedepthgauges.h"
+
+namespace owt {
+namespace base {
+// Upper bound between re-scans of the Locked counters. The SDK unlocks some
+// surfaces internally with no notification, so waiters may not rely on
+// NotifySurfaceReleased() alone.
+static const int kRescanIntervalMs = 1;
+
+MSDKSurfacePool::MSDKSurfacePool() : surfaces_(nullptr), count_(0) {}
+
+void MSDKSurfacePool::Assign(mfxFrameSurface1* surfaces, mfxU16 count) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  surfaces_ = surfaces;
+  count_ = count;
+}
+
+void MSDKSurfacePool::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  surfaces_ = nullptr;
+  count_ = 0;
+}
+
+mfxU16 MSDKSurfacePool::WaitForFreeSurface(mfxU32 timeout_ms) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(timeout_ms);
+  ReportLockedDepthLocked();
+  for (;;) {
+    mfxU16 idx = FindFreeSurfaceIndex();
+    if (MSDK_INVALID_SURF_IDX != idx) {
+      return idx;
+    }
+    if (std::chrono::steady_clock::now() >= deadline) {
+      return MSDK_INVALID_SURF_IDX;
+    }
+    released_.wait_for(lock, std::chrono::milliseconds(kRescanIntervalMs));
+  }
+}
+
+void MSDKSurfacePool::NotifySurfaceReleased() {
+  released_.notify_all();
+}
+
+void MSDKSurfacePool::SetGaugeName(const std::string& name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  gauge_name_ = name;
+}
+
+// Reported once per acquisition, so the gauge tracks how deep into the
+// pool each frame has to reach; the watermark shows how close the codec
+// came to exhausting its surfaces.
+void MSDKSurfacePool::ReportLockedDepthLocked() const {
+  if (gauge_name_.empty() || !surfaces_) {
+    return;
+  }
+  int locked = 0;
+  for (mfxU16 i = 0; i < count_; i++) {
+    if (surfaces_[i].Data.Locked != 0) {
+      locked++;
+    }
+  }
+  QueueDepthGauges::Set(gauge_name_, locked);
+}
+
+mfxU16 MSDKSurfacePool::FindFreeSurfaceIndex() const {
+  if (surfaces_) {
+    for (mfxU16 i = 0; i < count_; i++) {
+      if (0 == surfaces_[i].Data.Locked) {
+        return i;
+      }
+    }
+  }
+  return MSDK_INVALID_SURF_IDX;
+}
+}  // namespace base
+}  // namespace owt
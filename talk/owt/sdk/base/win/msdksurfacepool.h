@@ -0,0 +1,52 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef OWT_BASE_WIN_MSDKSURFACEPOOL_H_
+#define OWT_BASE_WIN_MSDKSURFACEPOOL_H_
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include "mfxstructures.h"
+
+namespace owt {
+namespace base {
+// Tracks a codec's mfxFrameSurface1 array and lets the acquisition side
+// block on a condition variable instead of sleep-polling the Locked
+// counters. Completion sites call NotifySurfaceReleased() after syncing an
+// operation, which wakes a waiter immediately; a short timed re-scan covers
+// surfaces the SDK unlocks internally without any callback. Used by both
+// the MSDK encoder and decoder.
+class MSDKSurfacePool {
+ public:
+  MSDKSurfacePool();
+  // Attaches the pool to |surfaces|. The array stays owned by the codec and
+  // must outlive the pool or be detached with Clear() first.
+  void Assign(mfxFrameSurface1* surfaces, mfxU16 count);
+  // Detaches the pool from its surface array.
+  void Clear();
+  // Returns the index of an unlocked surface, waiting up to |timeout_ms|
+  // milliseconds for one to be released. Returns MSDK_INVALID_SURF_IDX when
+  // none frees up within the timeout.
+  mfxU16 WaitForFreeSurface(mfxU32 timeout_ms);
+  // Wakes waiters after a completed operation may have unlocked a surface.
+  void NotifySurfaceReleased();
+  // Names the queue-depth gauge this pool reports its locked-surface count
+  // under; the pool reports nothing until a name is set.
+  void SetGaugeName(const std::string& name);
+
+ private:
+  // Caller must hold |mutex_|.
+  mfxU16 FindFreeSurfaceIndex() const;
+  // Caller must hold |mutex_|.
+  void ReportLockedDepthLocked() const;
+  mfxFrameSurface1* surfaces_;
+  mfxU16 count_;
+  std::string gauge_name_;
+  std::mutex mutex_;
+  std::condition_variable released_;
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_WIN_MSDKSURFACEPOOL_H_
@@ -3,9 +3,14 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "atlbase.h"
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
 #include "d3d_allocator.h"
 #include "mfxdefs.h"
 #include "msdkvideobase.h"
+#include "talk/owt/sdk/include/cpp/owt/base/globalconfiguration.h"
 
 namespace owt {
 namespace base {
@@ -29,7 +34,29 @@ static bool isValidPluginUID(const mfxPluginUID* uid) {
           AreGuidsEqual(uid, &MFX_PLUGINID_HEVCE_GACC));
 }
 
-MSDKFactory::MSDKFactory() : main_session(nullptr), mfe_timeout(0) {}
+MSDKFactory::MSDKFactory()
+    : main_session(nullptr),
+      mfe_timeout(0),
+      d3d9_(nullptr),
+      d3d9_device_(nullptr),
+      d3d9_manager_(nullptr),
+      d3d9_reset_token_(0),
+      cap_cache_loaded_(false),
+      cap_revalidation_started_(false) {}
+
+// Bump when the cache file layout or probe semantics change; files with
+// another version are ignored and rewritten.
+static const char kCapCacheHeader[] = "owt-msdk-caps-v1";
+
+static std::string CapCachePath() {
+  char local_app_data[MAX_PATH] = {};
+  DWORD length = ::GetEnvironmentVariableA("LOCALAPPDATA", local_app_data,
+                                           MAX_PATH);
+  if (length == 0 || length >= MAX_PATH) {
+    return std::string();
+  }
+  return std::string(local_app_data) + "\\owt_msdk_codec_caps.txt";
+}
 
 bool MSDKFactory::Init() {
   main_session = InternalCreateSession();
@@ -84,28 +111,184 @@ MFXVideoSession* MSDKFactory::InternalCreateSession() {
   return session;
 }
 
+// Implementation values the dispatcher understands for each hardware
+// adapter, in adapter order.
+static const mfxIMPL kAdapterImpls[] = {MFX_IMPL_HARDWARE, MFX_IMPL_HARDWARE2,
+                                        MFX_IMPL_HARDWARE3,
+                                        MFX_IMPL_HARDWARE4};
+static const int kMaxAdapters =
+    static_cast<int>(sizeof(kAdapterImpls) / sizeof(kAdapterImpls[0]));
+
+MFXVideoSession* MSDKFactory::InternalCreateSessionOnAdapter(int adapter) {
+  if (adapter < 0 || adapter >= kMaxAdapters) {
+    return nullptr;
+  }
+  mfxVersion version = {{3, 1}};
+  MFXVideoSession* session = new MFXVideoSession();
+  if (session->Init(kAdapterImpls[adapter], &version) != MFX_ERR_NONE) {
+    delete session;
+    return nullptr;
+  }
+  return session;
+}
+
+void MSDKFactory::EnsureAdaptersEnumeratedLocked() {
+  if (!available_adapters_.empty()) {
+    return;
+  }
+  // Probing binds a throwaway session per implementation value; adapters
+  // beyond the first only pay this once, on the first real session.
+  for (int adapter = 0; adapter < kMaxAdapters; adapter++) {
+    MFXVideoSession* session = InternalCreateSessionOnAdapter(adapter);
+    if (session) {
+      available_adapters_.push_back(adapter);
+      session->Close();
+      delete session;
+    }
+  }
+  if (available_adapters_.empty()) {
+    // Keep the pre-enumeration behavior of binding to the default
+    // adapter rather than failing session creation outright.
+    available_adapters_.push_back(0);
+  }
+}
+
+int MSDKFactory::PickAdapterLocked() {
+  int override_adapter = GlobalConfiguration::GetCodecAdapterIndex();
+  if (override_adapter >= 0) {
+    for (int adapter : available_adapters_) {
+      if (adapter == override_adapter) {
+        return adapter;
+      }
+    }
+  }
+  // Live-session count is the utilization signal: codecs hold their
+  // session for their whole lifetime, so counts track concurrent load.
+  int best = available_adapters_[0];
+  for (int adapter : available_adapters_) {
+    if (adapter_session_counts_[adapter] < adapter_session_counts_[best]) {
+      best = adapter;
+    }
+  }
+  return best;
+}
+
+MFXVideoSession* MSDKFactory::AdapterMainSessionLocked(int adapter) {
+  // The default adapter's parent is the factory main session, so joining
+  // behavior there is unchanged from the single-GPU path.
+  if (adapter == 0) {
+    return main_session;
+  }
+  auto it = adapter_main_sessions_.find(adapter);
+  if (it != adapter_main_sessions_.end()) {
+    return it->second;
+  }
+  MFXVideoSession* parent = InternalCreateSessionOnAdapter(adapter);
+  if (parent) {
+    adapter_main_sessions_[adapter] = parent;
+  }
+  return parent;
+}
+
 MFXVideoSession* MSDKFactory::CreateSession() {
   mfxStatus sts = MFX_ERR_NONE;
-  MFXVideoSession* session = nullptr;
 
-  session = InternalCreateSession();
+  std::lock_guard<std::mutex> lock(device_mutex_);
+  EnsureAdaptersEnumeratedLocked();
+  int adapter = PickAdapterLocked();
 
+  MFXVideoSession* session = InternalCreateSessionOnAdapter(adapter);
   if (!session) {
     return nullptr;
   }
 
-  sts = main_session->JoinSession(*session);
+  MFXVideoSession* parent = AdapterMainSessionLocked(adapter);
+  if (!parent) {
+    session->Close();
+    delete session;
+    return nullptr;
+  }
+  sts = parent->JoinSession(*session);
   if (sts != MFX_ERR_NONE) {
     session->Close();
     delete session;
     return nullptr;
   }
 
+  session_adapters_[session] = adapter;
+  adapter_session_counts_[adapter]++;
+  return session;
+}
+
+MFXVideoSession* MSDKFactory::InternalCreateD3D11Session(
+    ID3D11Device* device) {
+  mfxStatus sts = MFX_ERR_NONE;
+  mfxIMPL impl = MFX_IMPL_HARDWARE_ANY | MFX_IMPL_VIA_D3D11;
+  mfxVersion version = {{3, 1}};
+
+  MFXVideoSession* session = new MFXVideoSession();
+  if (!session)
+    return nullptr;
+
+  sts = session->Init(impl, &version);
+  if (sts != MFX_ERR_NONE) {
+    delete session;
+    return nullptr;
+  }
+
+  // The device handle must be set before any component is initialized on
+  // the session so that encoding runs on the device owning the textures.
+  sts = session->SetHandle(MFX_HANDLE_D3D11_DEVICE, device);
+  if (sts != MFX_ERR_NONE) {
+    session->Close();
+    delete session;
+    return nullptr;
+  }
+
+  return session;
+}
+
+MFXVideoSession* MSDKFactory::CreateD3D11Session(ID3D11Device* device) {
+  MFXVideoSession* session = InternalCreateD3D11Session(device);
+  if (!session) {
+    return nullptr;
+  }
+
+  // Join the session to the device's parent session, mirroring what
+  // CreateSession() does with the main session, so work submitted by
+  // different codecs on the same device shares one scheduler. The parent
+  // never hosts a codec itself and lives as long as the factory.
+  MFXVideoSession* parent = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(device_mutex_);
+    auto it = d3d11_main_sessions_.find(device);
+    if (it != d3d11_main_sessions_.end()) {
+      parent = it->second;
+    } else {
+      parent = InternalCreateD3D11Session(device);
+      if (parent) {
+        d3d11_main_sessions_[device] = parent;
+      }
+    }
+  }
+  // A failed join is not fatal; the session still works standalone.
+  if (parent) {
+    parent->JoinSession(*session);
+  }
+
   return session;
 }
 
 void MSDKFactory::DestroySession(MFXVideoSession* session) {
   if (session) {
+    {
+      std::lock_guard<std::mutex> lock(device_mutex_);
+      auto it = session_adapters_.find(session);
+      if (it != session_adapters_.end()) {
+        adapter_session_counts_[it->second]--;
+        session_adapters_.erase(it);
+      }
+    }
     session->DisjoinSession();
     session->Close();
     delete session;
@@ -167,6 +350,235 @@ void MSDKFactory::UnloadMSDKPlugin(MFXVideoSession* session,
   }
 }
 
+// The session identity the cache is keyed by. The dispatcher reports the
+// implementation it bound (which accelerator) and the API level the driver
+// provides, both of which change when the GPU or driver does; a mismatch
+// invalidates every cached entry.
+std::string MSDKFactory::CapabilityCacheIdentity() {
+  mfxIMPL impl = 0;
+  mfxVersion version = {};
+  if (!main_session || main_session->QueryIMPL(&impl) != MFX_ERR_NONE ||
+      main_session->QueryVersion(&version) != MFX_ERR_NONE) {
+    return std::string();
+  }
+  std::ostringstream identity;
+  identity << "impl=" << impl << " api=" << version.Major << "."
+           << version.Minor;
+  return identity.str();
+}
+
+// Context: |cap_cache_mutex_| held.
+void MSDKFactory::EnsureCapabilityCacheLoaded() {
+  if (cap_cache_loaded_) {
+    return;
+  }
+  cap_cache_loaded_ = true;
+  std::string path = CapCachePath();
+  std::string identity = CapabilityCacheIdentity();
+  if (path.empty() || identity.empty()) {
+    return;
+  }
+  std::ifstream file(path);
+  if (!file) {
+    return;
+  }
+  std::string header, file_identity, line;
+  if (!std::getline(file, header) || header != kCapCacheHeader ||
+      !std::getline(file, file_identity) || file_identity != identity) {
+    return;
+  }
+  while (std::getline(file, line)) {
+    std::istringstream entry(line);
+    uint64_t key = 0;
+    int supported = 0;
+    if (entry >> key >> supported) {
+      cap_cache_[key] = supported != 0;
+    }
+  }
+}
+
+// Context: |cap_cache_mutex_| held.
+void MSDKFactory::StoreCapabilityCacheLocked() {
+  std::string path = CapCachePath();
+  std::string identity = CapabilityCacheIdentity();
+  if (path.empty() || identity.empty()) {
+    return;
+  }
+  std::ofstream file(path, std::ios::trunc);
+  if (!file) {
+    return;
+  }
+  file << kCapCacheHeader << "\n" << identity << "\n";
+  for (const auto& entry : cap_cache_) {
+    file << entry.first << " " << (entry.second ? 1 : 0) << "\n";
+  }
+}
+
+// Re-probes every cached entry once per process on a background thread,
+// so a cache gone stale without an identity change (driver feature
+// toggles, plugin installs) corrects itself for the next launch without
+// putting the probe back on the startup path.
+void MSDKFactory::StartCapabilityRevalidation() {
+  if (cap_revalidation_started_) {
+    return;
+  }
+  cap_revalidation_started_ = true;
+  // |this| is the process-lifetime singleton, so the detached thread can
+  // never outlive it.
+  std::thread([this] {
+    std::vector<uint64_t> keys;
+    {
+      std::lock_guard<std::mutex> lock(cap_cache_mutex_);
+      for (const auto& entry : cap_cache_) {
+        keys.push_back(entry.first);
+      }
+    }
+    bool changed = false;
+    for (uint64_t key : keys) {
+      bool supported = ProbeCodecSupport(static_cast<uint32_t>(key >> 1),
+                                         (key & 1) != 0);
+      std::lock_guard<std::mutex> lock(cap_cache_mutex_);
+      auto it = cap_cache_.find(key);
+      if (it != cap_cache_.end() && it->second != supported) {
+        it->second = supported;
+        changed = true;
+      }
+    }
+    if (changed) {
+      std::lock_guard<std::mutex> lock(cap_cache_mutex_);
+      StoreCapabilityCacheLocked();
+    }
+  }).detach();
+}
+
+bool MSDKFactory::QueryCodecSupport(uint32_t codec_id, bool is_encoder) {
+  uint64_t key = (static_cast<uint64_t>(codec_id) << 1) | (is_encoder ? 1 : 0);
+  {
+    std::lock_guard<std::mutex> lock(cap_cache_mutex_);
+    EnsureCapabilityCacheLoaded();
+    auto it = cap_cache_.find(key);
+    if (it != cap_cache_.end()) {
+      StartCapabilityRevalidation();
+      return it->second;
+    }
+  }
+  bool supported = ProbeCodecSupport(codec_id, is_encoder);
+  std::lock_guard<std::mutex> lock(cap_cache_mutex_);
+  cap_cache_[key] = supported;
+  StoreCapabilityCacheLocked();
+  return supported;
+}
+
+bool MSDKFactory::ProbeCodecSupport(uint32_t codec_id, bool is_encoder) {
+  mfxStatus sts = MFX_ERR_NONE;
+  mfxPluginUID plugin_id = {};
+
+  // Query on a throwaway session so loading a plugin for the probe does
+  // not disturb sessions with codecs already initialized on them.
+  MFXVideoSession* session = CreateSession();
+  if (!session) {
+    return false;
+  }
+
+  bool plugin_loaded =
+      is_encoder ? LoadEncoderPlugin(codec_id, session, &plugin_id)
+                 : LoadDecoderPlugin(codec_id, session, &plugin_id);
+  bool supported = false;
+  if (plugin_loaded) {
+    // With a null input the query reports whether the codec class exists
+    // on this platform at all; warnings about partial acceleration still
+    // count as supported.
+    mfxVideoParam param;
+    memset(&param, 0, sizeof(param));
+    param.mfx.CodecId = codec_id;
+    if (is_encoder) {
+      sts = MFXVideoENCODE_Query(*session, nullptr, &param);
+    } else {
+      sts = MFXVideoDECODE_Query(*session, nullptr, &param);
+    }
+    supported = (sts >= MFX_ERR_NONE);
+    UnloadMSDKPlugin(session, &plugin_id);
+  }
+
+  DestroySession(session);
+  return supported;
+}
+
+bool MSDKFactory::QueryEncoderSupport(uint32_t codec_id) {
+  return QueryCodecSupport(codec_id, true);
+}
+
+bool MSDKFactory::QueryDecoderSupport(uint32_t codec_id) {
+  return QueryCodecSupport(codec_id, false);
+}
+
+void MSDKFactory::PrewarmSession(uint32_t codec_id, bool is_encoder) {
+  auto& parked =
+      is_encoder ? prewarmed_encode_sessions_ : prewarmed_decode_sessions_;
+  {
+    std::lock_guard<std::mutex> lock(prewarm_mutex_);
+    if (parked.count(codec_id))
+      return;
+  }
+  MFXVideoSession* session = CreateSession();
+  if (!session)
+    return;
+  mfxPluginUID plugin_id = {};
+  bool loaded = is_encoder ? LoadEncoderPlugin(codec_id, session, &plugin_id)
+                           : LoadDecoderPlugin(codec_id, session, &plugin_id);
+  if (!loaded) {
+    DestroySession(session);
+    return;
+  }
+  MFXVideoSession* loser = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(prewarm_mutex_);
+    if (!parked.emplace(codec_id, std::make_pair(session, plugin_id)).second) {
+      // Raced with a concurrent prewarm for the same codec; keep the
+      // parked one and drop ours outside the lock.
+      loser = session;
+    }
+  }
+  if (loser != nullptr)
+    DestroySession(loser);
+}
+
+MFXVideoSession* MSDKFactory::TakePrewarmedSession(uint32_t codec_id,
+                                                   bool is_encoder,
+                                                   mfxPluginUID* plugin_id) {
+  auto& parked =
+      is_encoder ? prewarmed_encode_sessions_ : prewarmed_decode_sessions_;
+  std::lock_guard<std::mutex> lock(prewarm_mutex_);
+  auto it = parked.find(codec_id);
+  if (it == parked.end())
+    return nullptr;
+  MFXVideoSession* session = it->second.first;
+  if (plugin_id != nullptr)
+    *plugin_id = it->second.second;
+  parked.erase(it);
+  return session;
+}
+
+void MSDKFactory::PrewarmDecodeSession(uint32_t codec_id) {
+  PrewarmSession(codec_id, false);
+}
+
+MFXVideoSession* MSDKFactory::TakePrewarmedDecodeSession(
+    uint32_t codec_id,
+    mfxPluginUID* plugin_id) {
+  return TakePrewarmedSession(codec_id, false, plugin_id);
+}
+
+void MSDKFactory::PrewarmEncodeSession(uint32_t codec_id) {
+  PrewarmSession(codec_id, true);
+}
+
+MFXVideoSession* MSDKFactory::TakePrewarmedEncodeSession(
+    uint32_t codec_id,
+    mfxPluginUID* plugin_id) {
+  return TakePrewarmedSession(codec_id, true, plugin_id);
+}
+
 std::shared_ptr<D3DFrameAllocator> MSDKFactory::CreateFrameAllocator(
     IDirect3DDeviceManager9* d3d_manager) {
   mfxStatus sts = MFX_ERR_NONE;
@@ -183,6 +595,22 @@ std::shared_ptr<D3DFrameAllocator> MSDKFactory::CreateFrameAllocator(
   return pAllocator;
 }
 
+std::shared_ptr<D3D11FrameAllocator> MSDKFactory::CreateFrameAllocator(
+    ID3D11Device* device) {
+  mfxStatus sts = MFX_ERR_NONE;
+  D3D11AllocatorParams param;
+
+  param.pDevice = device;
+  std::shared_ptr<D3D11FrameAllocator> pAllocator =
+      std::make_shared<D3D11FrameAllocator>();
+  sts = pAllocator->Init(&param);
+  if (sts != MFX_ERR_NONE) {
+    return nullptr;
+  }
+
+  return pAllocator;
+}
+
 std::shared_ptr<SysMemFrameAllocator> MSDKFactory::CreateFrameAllocator() {
   mfxStatus sts = MFX_ERR_NONE;
 
@@ -195,5 +623,102 @@ std::shared_ptr<SysMemFrameAllocator> MSDKFactory::CreateFrameAllocator() {
 
   return pAllocator;
 }
+
+// Caller must hold |device_mutex_|.
+bool MSDKFactory::CreateD3DDevice() {
+  HRESULT hr = Direct3DCreate9Ex(D3D_SDK_VERSION, &d3d9_);
+  if (!d3d9_ || FAILED(hr))
+    return false;
+
+  D3DPRESENT_PARAMETERS present_params;
+  ZeroMemory(&present_params, sizeof(present_params));
+  HWND video_window = GetDesktopWindow();
+  if (video_window == nullptr) {
+    return false;
+  }
+  RECT r;
+  GetClientRect((HWND)video_window, &r);
+
+  present_params.BackBufferWidth = r.right - r.left;
+  present_params.BackBufferHeight = r.bottom - r.top;
+  present_params.BackBufferFormat = D3DFMT_X8R8G8B8; //Only apply this if we're rendering full screen
+  present_params.BackBufferCount = 1;
+  present_params.SwapEffect = D3DSWAPEFFECT_DISCARD;
+  present_params.hDeviceWindow = video_window;
+  present_params.FullScreen_RefreshRateInHz = D3DPRESENT_RATE_DEFAULT;
+  present_params.Flags = D3DPRESENTFLAG_LOCKABLE_BACKBUFFER|D3DPRESENTFLAG_VIDEO;
+  present_params.Windowed = TRUE;
+  present_params.PresentationInterval = D3DPRESENT_INTERVAL_ONE;
+  hr = d3d9_->CreateDeviceEx(
+        D3DADAPTER_DEFAULT,
+        D3DDEVTYPE_HAL,
+        (HWND)video_window,
+        D3DCREATE_SOFTWARE_VERTEXPROCESSING | D3DCREATE_MULTITHREADED | D3DCREATE_FPU_PRESERVE,
+        &present_params,
+        nullptr,
+        &d3d9_device_);
+  if (FAILED(hr))
+    return false;
+
+  hr = d3d9_device_->ResetEx(&present_params, nullptr);
+  if (FAILED(hr))
+    return false;
+  hr = d3d9_device_->Clear(0, nullptr, D3DCLEAR_TARGET, D3DCOLOR_XRGB(0, 0, 0), 1.0f, 0);
+  if (FAILED(hr))
+    return false;
+
+  UINT resetToken = 0;
+  hr = DXVA2CreateDirect3DDeviceManager9(&resetToken, &d3d9_manager_);
+  if (FAILED(hr))
+    return false;
+
+  hr = d3d9_manager_->ResetDevice(d3d9_device_, resetToken);
+  if (FAILED(hr))
+    return false;
+
+  d3d9_reset_token_ = resetToken;
+  return true;
+}
+
+IDirect3DDeviceManager9* MSDKFactory::GetD3D9DeviceManager(UINT* reset_token) {
+  std::lock_guard<std::mutex> lock(device_mutex_);
+  if (!d3d9_manager_) {
+    if (!CreateD3DDevice()) {
+      return nullptr;
+    }
+  }
+  if (reset_token) {
+    *reset_token = d3d9_reset_token_;
+  }
+  return d3d9_manager_;
+}
+
+std::shared_ptr<D3DFrameAllocator> MSDKFactory::GetSharedFrameAllocator() {
+  if (!GetD3D9DeviceManager(nullptr)) {
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> lock(device_mutex_);
+  if (!shared_d3d9_allocator_) {
+    shared_d3d9_allocator_ = CreateFrameAllocator(d3d9_manager_);
+  }
+  return shared_d3d9_allocator_;
+}
+
+std::shared_ptr<D3D11FrameAllocator> MSDKFactory::GetSharedFrameAllocator(
+    ID3D11Device* device) {
+  std::lock_guard<std::mutex> lock(device_mutex_);
+  auto it = d3d11_allocators_.find(device);
+  if (it != d3d11_allocators_.end()) {
+    std::shared_ptr<D3D11FrameAllocator> allocator = it->second.lock();
+    if (allocator) {
+      return allocator;
+    }
+  }
+  std::shared_ptr<D3D11FrameAllocator> allocator = CreateFrameAllocator(device);
+  if (allocator) {
+    d3d11_allocators_[device] = allocator;
+  }
+  return allocator;
+}
 }  // namespace base
 }  // namespace owt
\ No newline at end of file
@@ -7,9 +7,13 @@
 
 #pragma warning(disable : 4201)
 #include "d3d_allocator.h"
+#include "d3d11_allocator.h"
 #include <d3d9.h>
+#include <d3d11.h>
 #include <dxva2api.h>
 #include <dxva.h>
+#include <map>
+#include <vector>
 #include <mfxdefs.h>
 #include <mfxvideo++.h>
 #include <mfxplugin++.h>
@@ -29,8 +33,19 @@ class MSDKFactory {
 
   static MSDKFactory* Get();
 
+  /// Creates a session placed on a hardware adapter by the multi-GPU
+  /// policy: an explicit adapter from GlobalConfiguration when set,
+  /// otherwise the enumerated adapter with the fewest live sessions.
+  /// Sessions are joined to a per-adapter parent session, since joining
+  /// across adapters is invalid.
   MFXVideoSession* CreateSession();
 
+  /// Creates a session accelerated through D3D11 on |device|. Sessions on
+  /// the same device are joined to a per-device parent session so the GPU
+  /// scheduler can batch work across codecs; they are not joined to the
+  /// main session, which runs on a different accelerator context.
+  MFXVideoSession* CreateD3D11Session(ID3D11Device* device);
+
   void DestroySession(MFXVideoSession* session);
   
   MFXVideoSession* GetMainSession();
@@ -39,8 +54,46 @@ class MSDKFactory {
   bool LoadEncoderPlugin(uint32_t codec_id, MFXVideoSession* session, mfxPluginUID* plugin_id);
   void UnloadMSDKPlugin(MFXVideoSession* session, mfxPluginUID* plugin_id);
 
+  /// Queries whether the platform can hardware-encode |codec_id|, loading
+  /// the codec's plugin on a throwaway session if one is required.
+  /// Results are served from an on-disk cache keyed by the accelerator
+  /// identity when one exists, so repeated process launches skip the
+  /// device probe; cached results are revalidated once per process on a
+  /// background thread.
+  bool QueryEncoderSupport(uint32_t codec_id);
+  /// Queries whether the platform can hardware-decode |codec_id|. Cached
+  /// across launches like QueryEncoderSupport.
+  bool QueryDecoderSupport(uint32_t codec_id);
+
+  /// Speculatively creates a decode session with |codec_id|'s plugin
+  /// loaded and parks it, so the next hardware decoder for that codec
+  /// adopts it instead of paying session and plugin setup on its codec
+  /// thread. One session is parked per codec; redundant calls are no-ops.
+  void PrewarmDecodeSession(uint32_t codec_id);
+  /// Takes the session parked for |codec_id| when one exists;
+  /// |plugin_id| receives the loaded plugin. Returns nullptr otherwise.
+  MFXVideoSession* TakePrewarmedDecodeSession(uint32_t codec_id,
+                                              mfxPluginUID* plugin_id);
+  /// Encode-side counterpart of PrewarmDecodeSession; parks a session
+  /// with |codec_id|'s encoder plugin loaded.
+  void PrewarmEncodeSession(uint32_t codec_id);
+  /// Encode-side counterpart of TakePrewarmedDecodeSession.
+  MFXVideoSession* TakePrewarmedEncodeSession(uint32_t codec_id,
+                                              mfxPluginUID* plugin_id);
+
   static std::shared_ptr<D3DFrameAllocator> CreateFrameAllocator(IDirect3DDeviceManager9* d3d_manager);
+  static std::shared_ptr<D3D11FrameAllocator> CreateFrameAllocator(ID3D11Device* device);
   static std::shared_ptr<SysMemFrameAllocator> CreateFrameAllocator();
+
+  /// Returns the process-wide D3D9 device manager shared by hardware
+  /// codecs, creating the device on first use. |reset_token| receives the
+  /// manager's reset token when non-null. Returns nullptr on failure.
+  IDirect3DDeviceManager9* GetD3D9DeviceManager(UINT* reset_token);
+  /// Returns the D3D9 frame allocator shared by every codec on the shared
+  /// device manager, so surface pools are shared instead of per-codec.
+  std::shared_ptr<D3DFrameAllocator> GetSharedFrameAllocator();
+  /// Returns the D3D11 frame allocator shared by sessions on |device|.
+  std::shared_ptr<D3D11FrameAllocator> GetSharedFrameAllocator(ID3D11Device* device);
   void MFETimeout(uint32_t timeout);
   uint32_t MFETimeout();
  protected:
@@ -51,10 +104,59 @@ class MSDKFactory {
  private:
   bool CreateD3DDevice();
   bool ResetD3DDevice() { return false;}
+  MFXVideoSession* InternalCreateD3D11Session(ID3D11Device* device);
+  MFXVideoSession* InternalCreateSessionOnAdapter(int adapter);
+  // Multi-GPU session placement. Context: |device_mutex_| held.
+  void EnsureAdaptersEnumeratedLocked();
+  int PickAdapterLocked();
+  MFXVideoSession* AdapterMainSessionLocked(int adapter);
+  bool QueryCodecSupport(uint32_t codec_id, bool is_encoder);
+  bool ProbeCodecSupport(uint32_t codec_id, bool is_encoder);
+  // Capability cache persisted across launches. Guarded by
+  // |cap_cache_mutex_|; keys are (codec_id << 1 | is_encoder).
+  void EnsureCapabilityCacheLoaded();
+  void StoreCapabilityCacheLocked();
+  void StartCapabilityRevalidation();
+  std::string CapabilityCacheIdentity();
   static MSDKFactory* singleton;
   static std::mutex get_singleton_mutex;
-  MFXVideoSession* main_session;  
+  MFXVideoSession* main_session;
   uint32_t mfe_timeout;
+  // Shared accelerator state guarded by |device_mutex_|. The D3D9 device
+  // and its manager are created once and shared by every codec instance;
+  // D3D11 sessions get one parent session and one allocator per device.
+  std::mutex device_mutex_;
+  IDirect3D9Ex* d3d9_;
+  IDirect3DDevice9Ex* d3d9_device_;
+  IDirect3DDeviceManager9* d3d9_manager_;
+  UINT d3d9_reset_token_;
+  std::shared_ptr<D3DFrameAllocator> shared_d3d9_allocator_;
+  std::map<ID3D11Device*, MFXVideoSession*> d3d11_main_sessions_;
+  std::map<ID3D11Device*, std::weak_ptr<D3D11FrameAllocator>> d3d11_allocators_;
+  // Hardware adapters the dispatcher can bind sessions to, enumerated
+  // lazily on first session creation, and the live-session count per
+  // adapter that placement balances against. Guarded by |device_mutex_|.
+  std::vector<int> available_adapters_;
+  std::map<int, int> adapter_session_counts_;
+  std::map<int, MFXVideoSession*> adapter_main_sessions_;
+  std::map<MFXVideoSession*, int> session_adapters_;
+  // Sessions parked by PrewarmDecodeSession and PrewarmEncodeSession,
+  // keyed by codec id and guarded by |prewarm_mutex_|.
+  std::mutex prewarm_mutex_;
+  std::map<uint32_t, std::pair<MFXVideoSession*, mfxPluginUID>>
+      prewarmed_decode_sessions_;
+  std::map<uint32_t, std::pair<MFXVideoSession*, mfxPluginUID>>
+      prewarmed_encode_sessions_;
+  // Shared implementation behind the decode and encode prewarm entry
+  // points above.
+  void PrewarmSession(uint32_t codec_id, bool is_encoder);
+  MFXVideoSession* TakePrewarmedSession(uint32_t codec_id,
+                                        bool is_encoder,
+                                        mfxPluginUID* plugin_id);
+  std::mutex cap_cache_mutex_;
+  std::map<uint64_t, bool> cap_cache_;
+  bool cap_cache_loaded_;
+  bool cap_revalidation_started_;
 };
 }  // namespace base
 }  // namespace owt
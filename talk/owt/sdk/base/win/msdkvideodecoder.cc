@@ -5,12 +5,19 @@
 #include "d3d_allocator.h"
 #ifdef OWT_DEBUG_DEC
 #include <fstream>
+#include <thread>
 #endif
 #include "msdkvideobase.h"
+#include "talk/owt/sdk/base/eventjournal.h"
+#include "talk/owt/sdk/base/lowlatencymode.h"
 #include "talk/owt/sdk/base/nativehandlebuffer.h"
+#include "talk/owt/sdk/base/threadwatchdog.h"
+#include "talk/owt/sdk/include/cpp/owt/base/globalconfiguration.h"
 #include "talk/owt/sdk/base/win/d3dnativeframe.h"
+#include "talk/owt/sdk/base/win/decodethreadpool.h"
 #include "talk/owt/sdk/base/win/msdkvideodecoder.h"
 #include "webrtc/rtc_base/scoped_ref_ptr.h"
+#include "webrtc/rtc_base/timeutils.h"
 
 using namespace rtc;
 
@@ -20,7 +27,21 @@ enum { MSDK_MSG_HANDLE_INPUT = 0 };
 
 namespace owt {
 namespace base {
+// Bitstream buffer sizes are kept page aligned so growth lands on whole
+// pages instead of odd sizes that fragment the heap.
+static mfxU32 MSDKAlignBsSize(mfxU32 size) {
+  const mfxU32 kPageSize = 4096;
+  return (size + kPageSize - 1) & ~(kPageSize - 1);
+}
+
+// Number of decode operations allowed in flight on the hardware pipeline.
+// Values above one let the GPU decode frame k while completed frames are
+// delivered, instead of parking the decode thread on every sync point.
+static const mfxU16 kDecoderAsyncDepth = 4;
+
 int32_t MSDKVideoDecoder::Release() {
+    DiscardPendingOps();
+    CloseVpp();
     WipeMfxBitstream(&m_mfxBS);
     MSDK_SAFE_DELETE(m_pmfxDEC);
     if (m_mfxSession) {
@@ -31,6 +52,7 @@ int32_t MSDKVideoDecoder::Release() {
       }
     }
     m_pMFXAllocator.reset();
+    surface_pool_.Clear();
     MSDK_SAFE_DELETE_ARRAY(m_pInputSurfaces);
     inited_ = false;
     return WEBRTC_VIDEO_CODEC_OK;
@@ -41,16 +63,28 @@ MSDKVideoDecoder::MSDKVideoDecoder(webrtc::VideoCodecType type)
       inited_(false),
       width_(0),
       height_(0),
-      decoder_thread_(new rtc::Thread()) {
-  decoder_thread_->SetName("MSDKVideoDecoderThread", nullptr);
-  RTC_CHECK(decoder_thread_->Start())
-      << "Failed to start MSDK video decoder thread";
+      freeze_detector_("", "decode") {
+  // Lanes are shared across decoder instances; affinity pinning happens
+  // once per lane inside the pool.
+  DecodeThreadPool::Get()->AcquireLane(this);
   m_pmfxDEC = nullptr;
+  m_pmfxVPP = nullptr;
+  m_pVppSurfaces = nullptr;
+  m_nVppSurfNum = 0;
+  m_nextVppSurface = 0;
   MSDK_ZERO_MEMORY(m_mfxVideoParams);
   MSDK_ZERO_MEMORY(m_mfxResponse);
+  MSDK_ZERO_MEMORY(m_mfxVppParams);
+  MSDK_ZERO_MEMORY(m_mfxVppResponse);
   m_pInputSurfaces = nullptr;
+  d3d_manager = nullptr;
+  m_resetToken = 0;
   m_video_param_extracted = false;
   m_decBsOffset = 0;
+  m_bsHighWatermark = 0;
+  m_allocWidth = 0;
+  m_allocHeight = 0;
+  watchdog_handle_ = ThreadWatchdog::Register("msdk.decoder");
 #ifdef OWT_DEBUG_DEC
   input = fopen("input.bin", "wb");
 #endif
@@ -59,71 +93,17 @@ MSDKVideoDecoder::MSDKVideoDecoder(webrtc::VideoCodecType type)
 MSDKVideoDecoder::~MSDKVideoDecoder() {
   ntp_time_ms_.clear();
   timestamps_.clear();
-  if (decoder_thread_.get() != nullptr){
-    decoder_thread_->Stop();
-  }
+  DecodeThreadPool::Get()->ReleaseLane(this);
+  ThreadWatchdog::Unregister(watchdog_handle_);
+  watchdog_handle_ = nullptr;
 }
 
 void MSDKVideoDecoder::CheckOnCodecThread() {
-  RTC_CHECK(decoder_thread_.get() ==
+  RTC_CHECK(DecodeThreadPool::Get()->LaneFor(this) ==
             rtc::ThreadManager::Instance()->CurrentThread())
       << "Running on wrong thread!";
 }
 
-bool MSDKVideoDecoder::CreateD3DDevice() {
-  HRESULT hr = Direct3DCreate9Ex(D3D_SDK_VERSION, &m_pD3D9);
-  if (!m_pD3D9 || FAILED(hr))
-    return MFX_ERR_DEVICE_FAILED;
-
-  ZeroMemory(&present_params, sizeof(present_params));
-  HWND video_window = GetDesktopWindow();
-  if (video_window == nullptr){
-    return false;
-  }
-  RECT r;
-  GetClientRect((HWND)video_window, &r);
-
-  present_params.BackBufferWidth = r.right - r.left;
-  present_params.BackBufferHeight = r.bottom - r.top;
-  present_params.BackBufferFormat = D3DFMT_X8R8G8B8; //Only apply this if we're rendering full screen
-  present_params.BackBufferCount = 1;
-  present_params.SwapEffect = D3DSWAPEFFECT_DISCARD;
-  present_params.hDeviceWindow = video_window;
-  present_params.FullScreen_RefreshRateInHz = D3DPRESENT_RATE_DEFAULT;
-  present_params.Flags = D3DPRESENTFLAG_LOCKABLE_BACKBUFFER|D3DPRESENTFLAG_VIDEO;
-  present_params.Windowed = TRUE;
-  present_params.PresentationInterval = D3DPRESENT_INTERVAL_ONE;
-  hr = m_pD3D9->CreateDeviceEx(
-        D3DADAPTER_DEFAULT,
-        D3DDEVTYPE_HAL,
-        (HWND)video_window,
-        D3DCREATE_SOFTWARE_VERTEXPROCESSING | D3DCREATE_MULTITHREADED | D3DCREATE_FPU_PRESERVE,
-        &present_params,
-        nullptr,
-        &m_pD3DD9);
-  if (FAILED(hr))
-    return false;
-
-  hr = m_pD3DD9->ResetEx(&present_params, nullptr);
-  if (FAILED(hr))
-    return false;
-  hr = m_pD3DD9->Clear(0, nullptr, D3DCLEAR_TARGET, D3DCOLOR_XRGB(0, 0, 0), 1.0f, 0);
-  if (FAILED(hr))
-    return false;
-
-  UINT resetToken = 0;
-  hr = DXVA2CreateDirect3DDeviceManager9(&resetToken, &d3d_manager);
-  if (FAILED(hr))
-    return false;
-
-  hr = d3d_manager->ResetDevice(m_pD3DD9, resetToken);
-  if (FAILED(hr))
-    return false;
-
-  m_resetToken = resetToken;
-  return true;
-}
-
 int32_t MSDKVideoDecoder::InitDecode(const webrtc::VideoCodec* codecSettings, int32_t numberOfCores) {
 
   RTC_LOG(LS_ERROR) << "InitDecode enter";
@@ -139,11 +119,15 @@ int32_t MSDKVideoDecoder::InitDecode(const webrtc::VideoCodec* codecSettings, in
   if (&codec_ != codecSettings)
     codec_ = *codecSettings;
 
-  return decoder_thread_->Invoke<int32_t>(RTC_FROM_HERE,
-      Bind(&MSDKVideoDecoder::InitDecodeOnCodecThread, this));
+  // The lane is looked up per call: cost-driven rebalancing may have
+  // moved this decoder to another lane since the last Invoke.
+  return DecodeThreadPool::Get()->LaneFor(this)->Invoke<int32_t>(
+      RTC_FROM_HERE, Bind(&MSDKVideoDecoder::InitDecodeOnCodecThread, this));
 }
 
 int32_t MSDKVideoDecoder::Reset() {
+  EventJournal::Append(EventJournal::kDecoderReset, 0, "msdk");
+  DiscardPendingOps();
   m_pmfxDEC->Close();
   m_pmfxDEC = nullptr;
   delete m_pmfxDEC;
@@ -169,28 +153,41 @@ int32_t MSDKVideoDecoder::InitDecodeOnCodecThread() {
   uint32_t codec_id = MFX_CODEC_AVC;
 
   if (inited_) {
+    DiscardPendingOps();
+    CloseVpp();
     m_pmfxDEC->Close();
+    surface_pool_.Clear();
     MSDK_SAFE_DELETE_ARRAY(m_pInputSurfaces);
 
     if (m_pMFXAllocator) {
       m_pMFXAllocator->Free(m_pMFXAllocator->pthis, &m_mfxResponse);
     }
+    m_allocWidth = 0;
+    m_allocHeight = 0;
   } else {
     MSDKFactory* factory = MSDKFactory::Get();
-    m_mfxSession = factory->CreateSession();
-    if (!m_mfxSession) {
-      return  WEBRTC_VIDEO_CODEC_ERROR;
-    }
     if (codec_.codecType == webrtc::kVideoCodecVP8) {
       codec_id = MFX_CODEC_VP8;
     } else if (codec_.codecType == webrtc::kVideoCodecH265) {
       codec_id = MFX_CODEC_HEVC;
     }
-    if (!factory->LoadDecoderPlugin(codec_id, m_mfxSession, &m_pluginID)) {
-      return WEBRTC_VIDEO_CODEC_ERROR;
+    // Adopt a session parked by PrewarmDecodeResources when one exists;
+    // it already carries the codec's plugin.
+    m_mfxSession = factory->TakePrewarmedDecodeSession(codec_id, &m_pluginID);
+    if (!m_mfxSession) {
+      m_mfxSession = factory->CreateSession();
+      if (!m_mfxSession) {
+        return  WEBRTC_VIDEO_CODEC_ERROR;
+      }
+      if (!factory->LoadDecoderPlugin(codec_id, m_mfxSession, &m_pluginID)) {
+        return WEBRTC_VIDEO_CODEC_ERROR;
+      }
     }
 
-    if (!CreateD3DDevice()) {
+    // All decoders run on the factory's shared D3D9 device instead of one
+    // device per instance, so surface memory is pooled across codecs.
+    d3d_manager = factory->GetD3D9DeviceManager(&m_resetToken);
+    if (!d3d_manager) {
       return WEBRTC_VIDEO_CODEC_ERROR;
     }
 
@@ -199,7 +196,7 @@ int32_t MSDKVideoDecoder::InitDecodeOnCodecThread() {
     m_mfxSession->SetHandle(handle_type, dev_man_handle);
 
     // We're using D3D9 surface, so need to explicitly specify the D3D allocator
-    m_pMFXAllocator = MSDKFactory::CreateFrameAllocator(d3d_manager);
+    m_pMFXAllocator = factory->GetSharedFrameAllocator();
     if (nullptr == m_pMFXAllocator) {
       return WEBRTC_VIDEO_CODEC_ERROR;
     }
@@ -210,10 +207,18 @@ int32_t MSDKVideoDecoder::InitDecodeOnCodecThread() {
       return WEBRTC_VIDEO_CODEC_ERROR;
     }
 
-    // Prepare the bitstream
+    // Prepare the bitstream. Pre-size it from the negotiated bitrate: an
+    // IDR access unit after a loss-recovery request can approach a full
+    // second's worth of bits, and starting at that size avoids the
+    // realloc-and-copy that used to run on every oversized keyframe.
     MSDK_ZERO_MEMORY(m_mfxBS);
-    m_mfxBS.Data = new mfxU8[MSDK_BS_INIT_SIZE];
-    m_mfxBS.MaxLength = MSDK_BS_INIT_SIZE;
+    mfxU32 init_size = MSDK_BS_INIT_SIZE;
+    if (codec_.maxBitrate > 0) {
+      init_size = MSDK_MAX(init_size, codec_.maxBitrate * 1000 / 8);
+    }
+    init_size = MSDKAlignBsSize(init_size);
+    m_mfxBS.Data = new mfxU8[init_size];
+    m_mfxBS.MaxLength = init_size;
     m_pmfxDEC = new MFXVideoDECODE(*m_mfxSession);
     if (m_pmfxDEC == nullptr) {
       return WEBRTC_VIDEO_CODEC_ERROR;
@@ -225,6 +230,32 @@ int32_t MSDKVideoDecoder::InitDecodeOnCodecThread() {
   inited_ = true;
   return WEBRTC_VIDEO_CODEC_OK;
 }
+void MSDKVideoDecoder::PrewarmDecodeResources(owt::base::VideoCodec codec) {
+  if (!GlobalConfiguration::GetVideoHardwareAccelerationEnabled())
+    return;
+  uint32_t codec_id = MFX_CODEC_AVC;
+  if (codec == owt::base::VideoCodec::kVp8) {
+    codec_id = MFX_CODEC_VP8;
+  } else if (codec == owt::base::VideoCodec::kH265) {
+    codec_id = MFX_CODEC_HEVC;
+  } else if (codec != owt::base::VideoCodec::kH264) {
+    // No hardware decode path to warm for this codec.
+    return;
+  }
+  std::thread([codec_id]() {
+    MSDKFactory* factory = MSDKFactory::Get();
+    if (factory == nullptr)
+      return;
+    // First use of the shared device manager creates the D3D9 device,
+    // the dominant cost in time-to-first-frame.
+    UINT reset_token = 0;
+    if (factory->GetD3D9DeviceManager(&reset_token) == nullptr)
+      return;
+    factory->GetSharedFrameAllocator();
+    factory->PrewarmDecodeSession(codec_id);
+  }).detach();
+}
+
 #ifdef OWT_DEBUG_DEC
 int e_count = 0;
 #endif
@@ -239,13 +270,24 @@ int32_t MSDKVideoDecoder::Decode(
   // 3. If any of the ProcessInput returns MF_E_NOTACCEPTING, intenrally
   // calls ProcessOutput until MF_E_TRANFORM_NEED_MORE_INPUT
   // 4. Invoke the callback to send decoded image to renderer.
+  // A wedged driver call inside this section is what the watchdog is
+  // there to catch.
+  ScopedWatchdogSection watchdog(watchdog_handle_, "MSDKVideoDecoder.Decode");
   mfxStatus sts = MFX_ERR_NONE;
-  HRESULT hr;
-  bool device_opened = false;
   mfxFrameSurface1 *pOutputSurface = nullptr;
+  // Wall time of the call, reported to the shared pool as this stream's
+  // per-frame cost; error paths are not representative and skip it.
+  int64_t decode_start_us = rtc::TimeMicros();
   m_mfxVideoParams.IOPattern =
       MFX_IOPATTERN_OUT_VIDEO_MEMORY;
-  m_mfxVideoParams.AsyncDepth = 1;
+  m_mfxVideoParams.AsyncDepth = kDecoderAsyncDepth;
+  if (LowLatencyMode::Active()) {
+    // Emit frames in decode order instead of display order. Streams
+    // carrying B-frames would otherwise sit in the reorder buffer until
+    // their display time resolves, which a bounded-latency subscription
+    // cannot afford.
+    m_mfxVideoParams.mfx.DecodedOrder = 1;
+  }
   ReadFromInputStream(&m_mfxBS, inputImage._buffer, inputImage._length);
 
 #ifdef OWT_DEBUG_DEC
@@ -281,26 +323,61 @@ dec_header:
         return WEBRTC_VIDEO_CODEC_ERROR;
       }
       nSurfNum = MSDK_MAX(request.NumFrameSuggested, 1);
-      sts = m_pMFXAllocator->Alloc(m_pMFXAllocator->pthis, &request,
-                                   &m_mfxResponse);
-      if (MFX_ERR_NONE != sts) {
-        RTC_LOG(LS_ERROR) << "Failed on allocator's alloc method";
-        return WEBRTC_VIDEO_CODEC_ERROR;
-      }
-      nSurfNum = m_mfxResponse.NumFrameActual;
-      // Allocate both the input and output surfaces.
-      m_pInputSurfaces = new mfxFrameSurface1[nSurfNum];
-      if (nullptr == m_pInputSurfaces) {
-        RTC_LOG(LS_ERROR) << "Failed allocating input surfaces.";
-        return WEBRTC_VIDEO_CODEC_ERROR;
-      }
+      // Reuse the existing surface pool when it is large enough for the
+      // new stream, so a mid-stream resolution change re-Inits the
+      // decoder without touching video memory.
+      bool reuse_pool = m_pInputSurfaces != nullptr &&
+                        m_mfxResponse.NumFrameActual >= nSurfNum &&
+                        m_allocWidth >= request.Info.Width &&
+                        m_allocHeight >= request.Info.Height;
+      if (!reuse_pool) {
+        if (m_pInputSurfaces != nullptr) {
+          surface_pool_.Clear();
+          MSDK_SAFE_DELETE_ARRAY(m_pInputSurfaces);
+          m_pMFXAllocator->Free(m_pMFXAllocator->pthis, &m_mfxResponse);
+          m_allocWidth = 0;
+          m_allocHeight = 0;
+        }
+        // Size the pool for the max negotiated resolution so a later
+        // switch to a higher simulcast layer still fits in it.
+        request.Info.Width = MSDK_MAX(
+            request.Info.Width, (mfxU16)MSDK_ALIGN16(codec_.width));
+        request.Info.Height = MSDK_MAX(
+            request.Info.Height, (mfxU16)MSDK_ALIGN32(codec_.height));
+        sts = m_pMFXAllocator->Alloc(m_pMFXAllocator->pthis, &request,
+                                     &m_mfxResponse);
+        if (MFX_ERR_NONE != sts) {
+          RTC_LOG(LS_ERROR) << "Failed on allocator's alloc method";
+          return WEBRTC_VIDEO_CODEC_ERROR;
+        }
+        nSurfNum = m_mfxResponse.NumFrameActual;
+        // Allocate both the input and output surfaces.
+        m_pInputSurfaces = new mfxFrameSurface1[nSurfNum];
+        if (nullptr == m_pInputSurfaces) {
+          RTC_LOG(LS_ERROR) << "Failed allocating input surfaces.";
+          return WEBRTC_VIDEO_CODEC_ERROR;
+        }
 
-      for (int i = 0; i < nSurfNum; i++) {
-        memset(&(m_pInputSurfaces[i]), 0, sizeof(mfxFrameSurface1));
-        MSDK_MEMCPY_VAR(m_pInputSurfaces[i].Info, &(request.Info),
-                        sizeof(mfxFrameInfo));
-        m_pInputSurfaces[i].Data.MemId = m_mfxResponse.mids[i];
+        for (int i = 0; i < nSurfNum; i++) {
+          memset(&(m_pInputSurfaces[i]), 0, sizeof(mfxFrameSurface1));
+          MSDK_MEMCPY_VAR(m_pInputSurfaces[i].Info, &(request.Info),
+                          sizeof(mfxFrameInfo));
+          m_pInputSurfaces[i].Data.MemId = m_mfxResponse.mids[i];
+        }
+        m_allocWidth = request.Info.Width;
+        m_allocHeight = request.Info.Height;
+      } else {
+        // Refresh the per-surface frame info for the new stream while
+        // keeping the allocated dimensions and memory.
+        for (int i = 0; i < m_mfxResponse.NumFrameActual; i++) {
+          MSDK_MEMCPY_VAR(m_pInputSurfaces[i].Info, &(request.Info),
+                          sizeof(mfxFrameInfo));
+          m_pInputSurfaces[i].Info.Width = m_allocWidth;
+          m_pInputSurfaces[i].Info.Height = m_allocHeight;
+        }
       }
+      surface_pool_.Assign(m_pInputSurfaces, m_mfxResponse.NumFrameActual);
+      surface_pool_.SetGaugeName("msdk.decoder.locked_surfaces");
       // Finally we're done with all configurations and we're OK to init the
       // decoder.
 
@@ -309,6 +386,11 @@ dec_header:
         RTC_LOG(LS_ERROR) << "Failed to init the decoder.";
         return WEBRTC_VIDEO_CODEC_ERROR;
       }
+      if (m_mfxVideoParams.mfx.FrameInfo.CropW > 0) {
+        width_ = m_mfxVideoParams.mfx.FrameInfo.CropW;
+        height_ = m_mfxVideoParams.mfx.FrameInfo.CropH;
+      }
+      ConfigureVpp();
 
       m_video_param_extracted = true;
     } else {
@@ -328,10 +410,8 @@ dec_header:
   // decoding.
   while (true) {
 more_surface:
-    mfxU16 moreIdx =
-        DecGetFreeSurface(m_pInputSurfaces, m_mfxResponse.NumFrameActual);
+    mfxU16 moreIdx = surface_pool_.WaitForFreeSurface(MSDK_DEC_WAIT_INTERVAL);
     if (moreIdx == MSDK_INVALID_SURF_IDX) {
-      MSDK_SLEEP(1);
       continue;
     }
     mfxFrameSurface1* moreFreeSurf = &m_pInputSurfaces[moreIdx];
@@ -342,53 +422,25 @@ retry:
                                       &syncp);
 
     if (sts == MFX_ERR_NONE && syncp != nullptr) {
-      sts = m_mfxSession->SyncOperation(syncp, MSDK_DEC_WAIT_INTERVAL);
-      if (sts >= MFX_ERR_NONE) {
-        // This means we have an output surface ready to be read from the
-        // stream.
-        HANDLE hHandle = nullptr;
-        if (!device_opened) {
-          hr = d3d_manager->OpenDeviceHandle(&hHandle);
-          if (FAILED(hr)) {
-            RTC_LOG(LS_ERROR) << "Failed to open d3d device handle. Not rendering.";
-            return WEBRTC_VIDEO_CODEC_ERROR;
-          }
-        }
-        IDirect3DDevice9* device;
-        hr = d3d_manager->LockDevice(hHandle, &device, false);
-        if (FAILED(hr)) {
-          return WEBRTC_VIDEO_CODEC_ERROR;
-        }
-
-        mfxHDLPair* dxMemId = (mfxHDLPair*)pOutputSurface->Data.MemId;
-
-        if (callback_) {
-          owt::base::NativeD3DSurfaceHandle* d3d_context =
-              new owt::base::NativeD3DSurfaceHandle;
-          d3d_context->dev_manager_ = d3d_manager;
-          d3d_context->dev_manager_reset_token_ = m_resetToken;
-          d3d_context->width_ = width_;
-          d3d_context->height_ = height_;
-          d3d_context->surface_ = (IDirect3DSurface9*)dxMemId->first;
-
-          rtc::scoped_refptr<owt::base::NativeHandleBuffer> buffer =
-              new rtc::RefCountedObject<owt::base::NativeHandleBuffer>(
-                  (void*)d3d_context, width_, height_);
-          webrtc::VideoFrame decoded_frame(buffer, inputImage._timeStamp, 0,
-                                           webrtc::kVideoRotation_0);
-          decoded_frame.set_ntp_time_ms(inputImage.ntp_time_ms_);
-          decoded_frame.set_timestamp(inputImage.Timestamp());
-          callback_->Decoded(decoded_frame);
-        }
-
-        d3d_manager->UnlockDevice(hHandle, false);
-        hr = d3d_manager->CloseDeviceHandle(hHandle);
-        if (FAILED(hr)) {
-          return WEBRTC_VIDEO_CODEC_ERROR;
-        }
+      // Queue the operation instead of syncing it right away. With
+      // AsyncDepth > 1 the GPU keeps decoding this frame while completed
+      // earlier operations are delivered below; we only block once the
+      // pipeline is full.
+      PendingDecodeOp op;
+      op.sync = syncp;
+      op.surface = pOutputSurface;
+      op.timestamp = inputImage._timeStamp;
+      op.ntp_time_ms = inputImage.ntp_time_ms_;
+      pending_ops_.push_back(op);
+      int32_t drain = DrainPendingOps(false);
+      if (drain != WEBRTC_VIDEO_CODEC_OK) {
+        return drain;
       }
     } else if (MFX_ERR_MORE_DATA == sts) {
-      return WEBRTC_VIDEO_CODEC_OK;
+      int32_t drain = DrainPendingOps(false);
+      DecodeThreadPool::Get()->ReportDecodeTime(
+          this, rtc::TimeMicros() - decode_start_us);
+      return drain;
     } else if (sts == MFX_WRN_DEVICE_BUSY) {
       MSDK_SLEEP(1);
       goto retry;
@@ -396,6 +448,17 @@ retry:
       goto more_surface;
     } else if (sts == MFX_WRN_VIDEO_PARAM_CHANGED) {
       goto retry;
+    } else if (sts == MFX_ERR_INCOMPATIBLE_VIDEO_PARAM) {
+      // Mid-stream resolution change (SFU simulcast layer switch).
+      // Deliver what is in flight, then re-Init the decoder in place
+      // from the refreshed header; the surface pool is kept when it is
+      // large enough, so the switch costs no reallocation.
+      DrainPendingOps(true);
+      m_pmfxDEC->Close();
+      m_mfxBS.DataLength += m_mfxBS.DataOffset - m_decBsOffset;
+      m_mfxBS.DataOffset = m_decBsOffset;
+      m_video_param_extracted = false;
+      goto dec_header;
     } else if (sts != MFX_ERR_NONE) {
       Reset();
       m_mfxBS.DataLength += m_mfxBS.DataOffset - m_decBsOffset;
@@ -404,9 +467,182 @@ retry:
       goto dec_header;
 	}
   }
+  DecodeThreadPool::Get()->ReportDecodeTime(this,
+                                            rtc::TimeMicros() - decode_start_us);
+  return WEBRTC_VIDEO_CODEC_OK;
+}
+
+// Delivers every completed operation at the head of the pipeline. When
+// |blocking| is set, or the pipeline is full, the front operation is
+// waited on; otherwise an operation still executing on the GPU ends the
+// drain.
+int32_t MSDKVideoDecoder::DrainPendingOps(bool blocking) {
+  while (!pending_ops_.empty()) {
+    bool must_wait = blocking || pending_ops_.size() >= kDecoderAsyncDepth;
+    PendingDecodeOp& op = pending_ops_.front();
+    mfxStatus sts = m_mfxSession->SyncOperation(
+        op.sync, must_wait ? MSDK_DEC_WAIT_INTERVAL : 0);
+    if (MFX_WRN_IN_EXECUTION == sts && !must_wait) {
+      return WEBRTC_VIDEO_CODEC_OK;
+    }
+    // The synced operation's work surface is unlocked by now; wake any
+    // thread waiting to acquire one.
+    surface_pool_.NotifySurfaceReleased();
+    if (sts >= MFX_ERR_NONE && callback_) {
+      mfxFrameSurface1* render_surface = op.surface;
+      int render_width = width_;
+      int render_height = height_;
+      if (m_pmfxVPP != nullptr) {
+        // Scale on the GPU before the frame leaves the decoder. Any
+        // problem in the stage delivers the full-size surface instead.
+        mfxFrameSurface1* vpp_surface = GetFreeVppSurface();
+        if (vpp_surface != nullptr) {
+          mfxSyncPoint vpp_sync = nullptr;
+          mfxStatus vpp_sts;
+          do {
+            vpp_sts = m_pmfxVPP->RunFrameVPPAsync(op.surface, vpp_surface,
+                                                  nullptr, &vpp_sync);
+            if (vpp_sts == MFX_WRN_DEVICE_BUSY) {
+              MSDK_SLEEP(1);
+            }
+          } while (vpp_sts == MFX_WRN_DEVICE_BUSY);
+          if (vpp_sts >= MFX_ERR_NONE && vpp_sync != nullptr) {
+            m_mfxSession->SyncOperation(vpp_sync, MSDK_DEC_WAIT_INTERVAL);
+            render_surface = vpp_surface;
+            render_width = m_mfxVppParams.vpp.Out.CropW;
+            render_height = m_mfxVppParams.vpp.Out.CropH;
+          }
+        }
+      }
+      // The surface flows to the renderer by reference; the renderer
+      // opens and locks the device itself, so no device transition is
+      // paid here.
+      mfxHDLPair* dxMemId = (mfxHDLPair*)render_surface->Data.MemId;
+      owt::base::NativeD3DSurfaceHandle* d3d_context =
+          new owt::base::NativeD3DSurfaceHandle;
+      d3d_context->dev_manager_ = d3d_manager;
+      d3d_context->dev_manager_reset_token_ = m_resetToken;
+      d3d_context->width_ = render_width;
+      d3d_context->height_ = render_height;
+      d3d_context->surface_ = (IDirect3DSurface9*)dxMemId->first;
+
+      rtc::scoped_refptr<owt::base::NativeHandleBuffer> buffer =
+          new rtc::RefCountedObject<owt::base::NativeHandleBuffer>(
+              (void*)d3d_context, render_width, render_height);
+      webrtc::VideoFrame decoded_frame(buffer, op.timestamp, 0,
+                                       webrtc::kVideoRotation_0);
+      decoded_frame.set_ntp_time_ms(op.ntp_time_ms);
+      freeze_detector_.RecordFrame();
+      callback_->Decoded(decoded_frame);
+    }
+    pending_ops_.pop_front();
+  }
   return WEBRTC_VIDEO_CODEC_OK;
 }
+
+// Syncs and drops every in-flight operation without delivering it. Used
+// on reset and release, where the sync points would otherwise dangle past
+// MFXVideoDECODE::Close.
+void MSDKVideoDecoder::DiscardPendingOps() {
+  for (auto& op : pending_ops_) {
+    if (m_mfxSession) {
+      m_mfxSession->SyncOperation(op.sync, MSDK_DEC_WAIT_INTERVAL);
+    }
+  }
+  pending_ops_.clear();
+  surface_pool_.NotifySurfaceReleased();
+}
+
+void MSDKVideoDecoder::ConfigureVpp() {
+  CloseVpp();
+  int target_width = GlobalConfiguration::GetDecodedFrameScalingWidth();
+  int target_height = GlobalConfiguration::GetDecodedFrameScalingHeight();
+  if (target_width <= 0 || target_height <= 0) {
+    return;
+  }
+  mfxFrameInfo& in_info = m_mfxVideoParams.mfx.FrameInfo;
+  // Never upscale; streams at or below the target go out as decoded.
+  if (in_info.CropW <= target_width || in_info.CropH <= target_height) {
+    return;
+  }
+  MSDK_ZERO_MEMORY(m_mfxVppParams);
+  m_mfxVppParams.IOPattern =
+      MFX_IOPATTERN_IN_VIDEO_MEMORY | MFX_IOPATTERN_OUT_VIDEO_MEMORY;
+  m_mfxVppParams.AsyncDepth = 1;
+  MSDK_MEMCPY_VAR(m_mfxVppParams.vpp.In, &in_info, sizeof(mfxFrameInfo));
+  MSDK_MEMCPY_VAR(m_mfxVppParams.vpp.Out, &in_info, sizeof(mfxFrameInfo));
+  m_mfxVppParams.vpp.Out.Width = (mfxU16)MSDK_ALIGN16(target_width);
+  m_mfxVppParams.vpp.Out.Height = (mfxU16)MSDK_ALIGN32(target_height);
+  m_mfxVppParams.vpp.Out.CropX = 0;
+  m_mfxVppParams.vpp.Out.CropY = 0;
+  m_mfxVppParams.vpp.Out.CropW = (mfxU16)target_width;
+  m_mfxVppParams.vpp.Out.CropH = (mfxU16)target_height;
+
+  m_pmfxVPP = new MFXVideoVPP(*m_mfxSession);
+  mfxFrameAllocRequest vpp_request[2];
+  memset(vpp_request, 0, sizeof(vpp_request));
+  mfxStatus sts = m_pmfxVPP->QueryIOSurf(&m_mfxVppParams, vpp_request);
+  if (sts < MFX_ERR_NONE) {
+    RTC_LOG(LS_WARNING) << "VPP QueryIOSurf failed; delivering unscaled.";
+    CloseVpp();
+    return;
+  }
+  // Input surfaces are the decoder's; only the scaled outputs are
+  // allocated here.
+  sts = m_pMFXAllocator->Alloc(m_pMFXAllocator->pthis, &vpp_request[1],
+                               &m_mfxVppResponse);
+  if (MFX_ERR_NONE != sts) {
+    RTC_LOG(LS_WARNING) << "VPP surface alloc failed; delivering unscaled.";
+    CloseVpp();
+    return;
+  }
+  m_nVppSurfNum = m_mfxVppResponse.NumFrameActual;
+  m_pVppSurfaces = new mfxFrameSurface1[m_nVppSurfNum];
+  for (mfxU16 i = 0; i < m_nVppSurfNum; i++) {
+    memset(&(m_pVppSurfaces[i]), 0, sizeof(mfxFrameSurface1));
+    MSDK_MEMCPY_VAR(m_pVppSurfaces[i].Info, &(m_mfxVppParams.vpp.Out),
+                    sizeof(mfxFrameInfo));
+    m_pVppSurfaces[i].Data.MemId = m_mfxVppResponse.mids[i];
+  }
+  sts = m_pmfxVPP->Init(&m_mfxVppParams);
+  if (MFX_ERR_NONE != sts) {
+    RTC_LOG(LS_WARNING) << "VPP init failed; delivering unscaled.";
+    CloseVpp();
+    return;
+  }
+  RTC_LOG(LS_INFO) << "Decoded frames scaled on GPU from "
+                   << in_info.CropW << "x" << in_info.CropH << " to "
+                   << target_width << "x" << target_height << ".";
+}
+
+void MSDKVideoDecoder::CloseVpp() {
+  if (m_pmfxVPP != nullptr) {
+    m_pmfxVPP->Close();
+    delete m_pmfxVPP;
+    m_pmfxVPP = nullptr;
+  }
+  MSDK_SAFE_DELETE_ARRAY(m_pVppSurfaces);
+  if (m_mfxVppResponse.NumFrameActual > 0 && m_pMFXAllocator) {
+    m_pMFXAllocator->Free(m_pMFXAllocator->pthis, &m_mfxVppResponse);
+  }
+  MSDK_ZERO_MEMORY(m_mfxVppResponse);
+  m_nVppSurfNum = 0;
+  m_nextVppSurface = 0;
+}
+
+mfxFrameSurface1* MSDKVideoDecoder::GetFreeVppSurface() {
+  for (mfxU16 i = 0; i < m_nVppSurfNum; i++) {
+    mfxU16 idx = (m_nextVppSurface + i) % m_nVppSurfNum;
+    if (m_pVppSurfaces[idx].Data.Locked == 0) {
+      m_nextVppSurface = (idx + 1) % m_nVppSurfNum;
+      return &m_pVppSurfaces[idx];
+    }
+  }
+  return nullptr;
+}
+
 mfxStatus MSDKVideoDecoder::ExtendMfxBitstream(mfxBitstream* pBitstream, mfxU32 nSize) {
+  nSize = MSDKAlignBsSize(nSize);
   mfxU8* pData = new mfxU8[nSize];
   memmove(pData, pBitstream->Data + pBitstream->DataOffset, pBitstream->DataLength);
 
@@ -420,14 +656,34 @@ mfxStatus MSDKVideoDecoder::ExtendMfxBitstream(mfxBitstream* pBitstream, mfxU32
 }
 
 void MSDKVideoDecoder::ReadFromInputStream(mfxBitstream* pBitstream, uint8_t *data, size_t len) {
-  if (m_mfxBS.MaxLength < len){
-      // Remaining BS size is not enough to hold current image, we enlarge it the gap*2.
-      mfxU32 newSize = static_cast<mfxU32>(m_mfxBS.MaxLength > len ? m_mfxBS.MaxLength * 2 : len * 2);
-      ExtendMfxBitstream(&m_mfxBS, newSize);
+  mfxU32 pending = m_mfxBS.DataLength;
+  if (pending == 0) {
+    // Everything was consumed; restart the window at the front for free.
+    m_mfxBS.DataOffset = 0;
+  }
+  if (pending + len > m_mfxBS.MaxLength) {
+    // Grow towards twice what decode has actually needed so far, so the
+    // size converges after the first loss burst instead of creeping up
+    // one realloc per keyframe.
+    mfxU32 needed = static_cast<mfxU32>(pending + len);
+    mfxU32 newSize = MSDK_MAX(m_mfxBS.MaxLength * 2,
+                              MSDK_MAX(needed, m_bsHighWatermark * 2));
+    ExtendMfxBitstream(&m_mfxBS, newSize);
+    RTC_LOG(LS_INFO) << "Decoder bitstream buffer grown to "
+                     << m_mfxBS.MaxLength << " bytes, high watermark "
+                     << m_bsHighWatermark << ".";
+  } else if (m_mfxBS.DataOffset + pending + len > m_mfxBS.MaxLength) {
+    // Tail ran out: compact the pending window to the front. Steady state
+    // consumes every access unit per call and never takes this branch, so
+    // no per-frame move is paid.
+    memmove(m_mfxBS.Data, m_mfxBS.Data + m_mfxBS.DataOffset, pending);
+    m_mfxBS.DataOffset = 0;
   }
-  memmove(m_mfxBS.Data + m_mfxBS.DataLength, data, len);
+  memmove(m_mfxBS.Data + m_mfxBS.DataOffset + pending, data, len);
   m_mfxBS.DataLength += static_cast<mfxU32>(len);
-  m_mfxBS.DataOffset = 0;
+  if (m_mfxBS.DataLength > m_bsHighWatermark) {
+    m_bsHighWatermark = m_mfxBS.DataLength;
+  }
   return;
 }
 
@@ -436,33 +692,6 @@ void MSDKVideoDecoder::WipeMfxBitstream(mfxBitstream* pBitstream) {
   MSDK_SAFE_DELETE_ARRAY(pBitstream->Data);
 }
 
-mfxU16 MSDKVideoDecoder::DecGetFreeSurface(mfxFrameSurface1* pSurfacesPool, mfxU16 nPoolSize) {
-  mfxU32 SleepInterval = 10; // milliseconds
-  mfxU16 idx = MSDK_INVALID_SURF_IDX;
-
-  // Wait if there's no free surface
-  for (mfxU32 i = 0; i < MSDK_WAIT_INTERVAL; i += SleepInterval) {
-    idx = DecGetFreeSurfaceIndex(pSurfacesPool, nPoolSize);
-
-    if (MSDK_INVALID_SURF_IDX != idx) {
-      break;
-    } else {
-      MSDK_SLEEP(SleepInterval);
-    }
-  }
-  return idx;
-}
-
-mfxU16 MSDKVideoDecoder::DecGetFreeSurfaceIndex(mfxFrameSurface1* pSurfacesPool, mfxU16 nPoolSize) {
-  if (pSurfacesPool) {
-    for (mfxU16 i = 0; i < nPoolSize; i++) {
-      if (0 == pSurfacesPool[i].Data.Locked) {
-          return i;
-      }
-    }
-  }
-  return MSDK_INVALID_SURF_IDX;
-}
 
 int32_t MSDKVideoDecoder::RegisterDecodeCompleteCallback(webrtc::DecodedImageCallback* callback) {
   callback_ = callback;
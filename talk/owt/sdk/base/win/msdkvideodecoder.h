@@ -4,9 +4,13 @@
 #ifndef OWT_BASE_WIN_MSDKVIDEODECODER_H_
 #define OWT_BASE_WIN_MSDKVIDEODECODER_H_
 
+#include <deque>
 #include <utility>
 #include <vector>
 
+#include "talk/owt/sdk/base/threadwatchdog.h"
+#include "talk/owt/sdk/base/videofreezedetector.h"
+#include "talk/owt/sdk/include/cpp/owt/base/commontypes.h"
 #include "webrtc/api/mediastreaminterface.h"
 #include "webrtc/api/test/fakeconstraints.h"
 #include "webrtc/rtc_base/logging.h"
@@ -35,6 +39,7 @@
 #include <dxva2api.h>
 
 #include "msdkvideobase.h"
+#include "msdksurfacepool.h"
 #include "base_allocator.h"
 
 namespace owt {
@@ -73,10 +78,18 @@ public:
 
     // rtc::MessageHandler implementation.
     void OnMessage(rtc::Message* msg) override;
+
+    // Speculatively warms the hardware decode path for |codec| on a
+    // background thread: the shared D3D9 device and frame allocator plus
+    // a parked decode session with the codec's plugin loaded. Called
+    // during subscription signaling, when the codec is known from stream
+    // metadata but no frame has arrived yet, so the first keyframe skips
+    // device and session setup. A no-op when hardware acceleration is
+    // disabled or the codec has no hardware decode path.
+    static void PrewarmDecodeResources(owt::base::VideoCodec codec);
 private:
     int32_t InitDecodeOnCodecThread();
     void CheckOnCodecThread();
-    bool CreateD3DDevice();
     int32_t Reset();
 
     // Type of video codec.
@@ -84,8 +97,22 @@ private:
     mfxStatus ExtendMfxBitstream(mfxBitstream* pBitstream, mfxU32 nSize);
     void WipeMfxBitstream(mfxBitstream* pBitstream);
     void ReadFromInputStream(mfxBitstream* pBitstream, uint8_t *data, size_t len);
-    mfxU16 DecGetFreeSurface(mfxFrameSurface1* pSurfacesPool, mfxU16 nPoolSize);
-    mfxU16 DecGetFreeSurfaceIndex(mfxFrameSurface1* pSurfacesPool, mfxU16 nPoolSize);
+
+    // One submitted decode operation whose sync point has not been waited
+    // on yet.
+    struct PendingDecodeOp {
+      mfxSyncPoint sync;
+      mfxFrameSurface1* surface;
+      uint32_t timestamp;
+      int64_t ntp_time_ms;
+    };
+    int32_t DrainPendingOps(bool blocking);
+    void DiscardPendingOps();
+    // (Re)creates the optional VPP scaling stage after decoder init.
+    // Failure falls back to unscaled delivery and is not an error.
+    void ConfigureVpp();
+    void CloseVpp();
+    mfxFrameSurface1* GetFreeVppSurface();
 
     // Begin MSDK variables
     MFXVideoSession*        m_mfxSession;
@@ -95,25 +122,50 @@ private:
     mfxBitstream            m_mfxBS; // Contains encoded data
     mfxFrameAllocResponse   m_mfxResponse; // Memory allocation response for decoder
     mfxFrameSurface1*       m_pInputSurfaces;
+    // Event-driven acquisition over m_pInputSurfaces; synced operations
+    // signal it so no sleep quantum is spent waiting for a free surface.
+    MSDKSurfacePool         surface_pool_;
+    // In-flight operations in submission order, serviced on the decode path.
+    std::deque<PendingDecodeOp> pending_ops_;
+    // Optional GPU scaling stage between decode and delivery; created
+    // when GlobalConfiguration requests a decoded-frame scaling target
+    // smaller than the stream. Output surfaces are owned here.
+    MFXVideoVPP*            m_pmfxVPP;
+    mfxVideoParam           m_mfxVppParams;
+    mfxFrameAllocResponse   m_mfxVppResponse;
+    mfxFrameSurface1*       m_pVppSurfaces;
+    mfxU16                  m_nVppSurfNum;
+    mfxU16                  m_nextVppSurface;
     mfxPluginUID            m_pluginID;
     bool                    m_video_param_extracted;
     uint32_t                m_decBsOffset;
+    // Largest number of pending bitstream bytes seen; growth targets twice
+    // this so the buffer size converges after the first loss burst.
+    mfxU32                  m_bsHighWatermark;
+    // Dimensions the surface pool was allocated with. The pool is sized
+    // for the max negotiated resolution so a mid-stream resolution change
+    // (SFU simulcast layer switch) re-Inits the decoder in place and
+    // keeps the surfaces.
+    mfxU16                  m_allocWidth;
+    mfxU16                  m_allocHeight;
     // End of MSDK variables
-    IDirect3D9Ex*               m_pD3D9;
-    IDirect3DDevice9Ex*         m_pD3DD9;
+    // Shared across decoder instances; owned by MSDKFactory.
     IDirect3DDeviceManager9*    d3d_manager;
-    D3DPRESENT_PARAMETERS       present_params;
-    UINT                        m_resetToken;;
+    UINT                        m_resetToken;
 
     rtc::CriticalSection critical_section_;
     bool inited_;
     int width_;
     int height_;
-    std::unique_ptr<rtc::Thread> decoder_thread_;  // Thread on which the decoder will be working on.
     webrtc::VideoCodec codec_;
 
     webrtc::I420BufferPool decoded_frame_pool_;
+    // Inter-frame gaps at decoder output. Decoder instances carry no
+    // stream identity, so the report is process wide.
+    VideoFreezeDetector freeze_detector_;
     webrtc::DecodedImageCallback* callback_;
+    // Stall detection over the decode path; see ThreadWatchdog.
+    ThreadWatchdog::Handle* watchdog_handle_;
     rtc::CriticalSection timestampCS_;
     std::vector<int64_t> ntp_time_ms_;
     std::vector<int32_t> timestamps_;
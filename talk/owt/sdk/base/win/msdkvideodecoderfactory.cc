@@ -2,34 +2,45 @@
 //
 // SPDX-License-Identifier: Apache-2.0
 
+#include "talk/owt/sdk/base/win/msdkvideobase.h"
 #include "talk/owt/sdk/base/win/msdkvideodecoderfactory.h"
 #include "talk/owt/sdk/base/win/msdkvideodecoder.h"
 
 namespace owt {
 namespace base {
 
-MSDKVideoDecoderFactory::MSDKVideoDecoderFactory() {
-  supported_codec_types_.clear();
-  
-  supported_codec_types_.push_back(webrtc::kVideoCodecVP8);
+MSDKVideoDecoderFactory::MSDKVideoDecoderFactory() {}
 
-  bool is_h264_hw_supported = true;
-  if (is_h264_hw_supported) {
-    supported_codec_types_.push_back(webrtc::kVideoCodecH264);
-  }
+// Deferred from the constructor so the driver probe runs on the first
+// video session instead of during PeerConnectionFactory creation.
+void MSDKVideoDecoderFactory::EnsureCodecsEnumerated() const {
+  std::call_once(enumerate_once_, [this] {
+    supported_codec_types_.clear();
+
+    supported_codec_types_.push_back(webrtc::kVideoCodecVP8);
+
+    MSDKFactory* factory = MSDKFactory::Get();
+    bool is_h264_hw_supported =
+        factory && factory->QueryDecoderSupport(MFX_CODEC_AVC);
+    if (is_h264_hw_supported) {
+      supported_codec_types_.push_back(webrtc::kVideoCodecH264);
+    }
 #ifndef DISABLE_H265
-// TODO: Add logic to detect plugin by MSDK.
-  bool is_h265_hw_supported = true;
-  if (is_h265_hw_supported) {
-    supported_codec_types_.push_back(webrtc::kVideoCodecH265);
-  }
+    // Probe the driver for the HEVC plugin instead of assuming support.
+    bool is_h265_hw_supported =
+        factory && factory->QueryDecoderSupport(MFX_CODEC_HEVC);
+    if (is_h265_hw_supported) {
+      supported_codec_types_.push_back(webrtc::kVideoCodecH265);
+    }
 #endif
+  });
 }
 
 MSDKVideoDecoderFactory::~MSDKVideoDecoderFactory() {
 }
 
 webrtc::VideoDecoder* MSDKVideoDecoderFactory::CreateVideoDecoder(webrtc::VideoCodecType type) {
+  EnsureCodecsEnumerated();
   if (supported_codec_types_.empty()) {
     return nullptr;
   }
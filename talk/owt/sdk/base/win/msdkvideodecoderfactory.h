@@ -5,6 +5,9 @@
 #ifndef OWT_BASE_WIN_MSDKVIDEODECODERFACTORY_H_
 #define OWT_BASE_WIN_MSDKVIDEODECODERFACTORY_H_
 
+#include <mutex>
+#include <vector>
+
 #include "webrtc/media/engine/webrtcvideodecoderfactory.h"
 
 namespace owt {
@@ -22,7 +25,11 @@ public:
  void DestroyVideoDecoder(webrtc::VideoDecoder* decoder) override;
 
 private:
- std::vector<webrtc::VideoCodecType> supported_codec_types_;
+ // Probing the driver is expensive on cold start, so the codec list is
+ // built on first use instead of at factory construction.
+ void EnsureCodecsEnumerated() const;
+ mutable std::once_flag enumerate_once_;
+ mutable std::vector<webrtc::VideoCodecType> supported_codec_types_;
 };
 }
 }  // namespace owt
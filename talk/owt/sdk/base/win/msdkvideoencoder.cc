@@ -5,26 +5,47 @@
 #ifdef OWT_DEBUG_MSDK_ENC
 #include <fstream>
 #endif
+#include <algorithm>
 #include <string>
+#include <thread>
 #include <vector>
 #include "libyuv/convert_from.h"
+#include "libyuv/planar_functions.h"
 #include "mfxcommon.h"
+#include "talk/owt/sdk/base/encodedstreamrecorder.h"
+#include "talk/owt/sdk/base/intrarefreshmode.h"
+#include "talk/owt/sdk/base/localloopback.h"
+#include "talk/owt/sdk/base/naluscanner.h"
+#include "talk/owt/sdk/base/nativehandlebuffer.h"
+#include "talk/owt/sdk/base/pipelinelatencytracer.h"
+#include "talk/owt/sdk/base/roihint.h"
+#include "talk/owt/sdk/base/screencontentmonitor.h"
+#include "talk/owt/sdk/base/threadwatchdog.h"
+#include "talk/owt/sdk/base/tracelog.h"
+#include "talk/owt/sdk/base/win/d3d11videoconverter.h"
 #include "talk/owt/sdk/base/win/d3d_allocator.h"
+#include "talk/owt/sdk/base/win/d3dnativeframe.h"
 #include "talk/owt/sdk/base/win/msdkvideobase.h"
 #include "talk/owt/sdk/base/win/msdkvideoencoder.h"
+#include "talk/owt/sdk/base/win/threadaffinity.h"
+#include "talk/owt/sdk/include/cpp/owt/base/globalconfiguration.h"
 #include "webrtc/rtc_base/bind.h"
 #include "webrtc/rtc_base/checks.h"
 #include "webrtc/rtc_base/logging.h"
 #include "webrtc/rtc_base/thread.h"
+#include "webrtc/rtc_base/timeutils.h"
 
 using namespace rtc;
-// H.265/H.264 start code length.
-#define NAL_SC_LENGTH 4
-#define NAL_SC_ALT_LENGTH 3
-// Maximum allowed NALUs in one output frame.
-#define MAX_NALUS_PERFRAME 32
 namespace owt {
 namespace base {
+// Number of encode operations allowed in flight on the hardware pipeline.
+// Values above one let the GPU encode frame k while the CPU scans and
+// packages frames k-1..k-N+1.
+static const mfxU16 kEncoderAsyncDepth = 4;
+// Minimum spacing between content-type driven encoder resets. The
+// monitor's hysteresis already dampens flapping; this bounds the driver
+// round trips even if it does not.
+static const int64_t kContentSwitchIntervalMs = 3000;
 
 void MSDKEncoderThread::Run() {
   ProcessMessages(kForever);
@@ -41,15 +62,30 @@ MSDKVideoEncoder::MSDKVideoEncoder()
       width_(0),
       height_(0),
       framerate_(0),
+      pending_rates_(0),
       encoder_thread_(new MSDKEncoderThread()),
       m_memType_(MSDK_SYSTEM_MEMORY),
-      inited_(false) {
+      d3d11_input_device_(nullptr),
+      d3d11_device_context_(nullptr),
+      inited_(false),
+      last_key_frame_forwarded_ms_(0),
+      key_frame_requests_received_(0),
+      key_frame_requests_forwarded_(0) {
   m_pmfxENC = nullptr;
   m_pEncSurfaces = nullptr;
   m_nFramesProcessed = 0;
+  applied_content_type_ = ScreenContentType::kUnknown;
+  last_content_switch_ms_ = 0;
+  watchdog_handle_ = ThreadWatchdog::Register("msdk.encoder");
   encoder_thread_->SetName("MSDKVideoEncoderThread", NULL);
   RTC_CHECK(encoder_thread_->Start())
       << "Failed to start encoder thread for MSDK encoder";
+  uint64_t affinity_mask = GlobalConfiguration::GetCodecThreadAffinityMask();
+  if (affinity_mask != 0) {
+    encoder_thread_->Invoke<void>(RTC_FROM_HERE, [affinity_mask] {
+      ApplyThreadAffinityMask(affinity_mask);
+    });
+  }
 #ifdef OWT_DEBUG_MSDK_ENC
   output = fopen("out.bin", "wb");
   input = fopen("in.yuv", "wb");
@@ -58,6 +94,7 @@ MSDKVideoEncoder::MSDKVideoEncoder()
 }
 
 MSDKVideoEncoder::~MSDKVideoEncoder() {
+  DiscardPendingOps();
   if (m_pmfxENC != nullptr) {
     m_pmfxENC->Close();
     delete m_pmfxENC;
@@ -72,10 +109,21 @@ MSDKVideoEncoder::~MSDKVideoEncoder() {
     }
   }
   m_pMFXAllocator.reset();
+  d3d11_converter_.reset();
+  if (d3d11_device_context_) {
+    d3d11_device_context_->Release();
+    d3d11_device_context_ = nullptr;
+  }
+  if (d3d11_input_device_) {
+    d3d11_input_device_->Release();
+    d3d11_input_device_ = nullptr;
+  }
 
   if (encoder_thread_.get()) {
     encoder_thread_->Stop();
   }
+  ThreadWatchdog::Unregister(watchdog_handle_);
+  watchdog_handle_ = nullptr;
 }
 
 int MSDKVideoEncoder::InitEncode(const webrtc::VideoCodec* codec_settings,
@@ -83,11 +131,26 @@ int MSDKVideoEncoder::InitEncode(const webrtc::VideoCodec* codec_settings,
                                  size_t max_payload_size) {
   RTC_DCHECK(codec_settings);
 
+  bool same_codec = inited_ && codecType_ == codec_settings->codecType;
   width_ = codec_settings->width;
   height_ = codec_settings->height;
   // We can only set average bitrate on the HW encoder.
   bitrate_ = codec_settings->startBitrate * 1000;
+  // The new settings supersede any rate snapshot still in flight.
+  pending_rates_.store(0, std::memory_order_relaxed);
   codecType_ = codec_settings->codecType;
+  codec_settings_ = *codec_settings;
+  // A running encoder getting new settings for the same codec first
+  // tries an in-place reset, which keeps the session, the surface
+  // allocation and the reference state, so ABR-driven resolution and
+  // framerate changes do not interrupt the stream.
+  if (same_codec) {
+    int ret = encoder_thread_->Invoke<int>(
+        RTC_FROM_HERE, rtc::Bind(&MSDKVideoEncoder::ResetOnEncoderThread,
+                                 this, codec_settings));
+    if (ret == WEBRTC_VIDEO_CODEC_OK)
+      return ret;
+  }
   // MSDK does not require all operations dispatched to the same thread.
   // We however always use dedicated thread.
   return encoder_thread_->Invoke<int>(
@@ -122,6 +185,26 @@ mfxStatus MSDKConvertFrameRate(mfxF64 dFrameRate,
   return MFX_ERR_NONE;
 }
 
+void MSDKVideoEncoder::PrewarmEncodeResources(owt::base::VideoCodec codec) {
+  if (!GlobalConfiguration::GetVideoHardwareAccelerationEnabled())
+    return;
+  uint32_t codec_id = MFX_CODEC_AVC;
+  if (codec == owt::base::VideoCodec::kH265) {
+    codec_id = MFX_CODEC_HEVC;
+  } else if (codec != owt::base::VideoCodec::kH264) {
+    // No hardware encode path to warm for this codec.
+    return;
+  }
+  std::thread([codec_id]() {
+    MSDKFactory* factory = MSDKFactory::Get();
+    if (factory == nullptr)
+      return;
+    if (!factory->QueryEncoderSupport(codec_id))
+      return;
+    factory->PrewarmEncodeSession(codec_id);
+  }).detach();
+}
+
 int MSDKVideoEncoder::InitEncodeOnEncoderThread(
     const webrtc::VideoCodec* codec_settings,
     int number_of_cores,
@@ -135,27 +218,52 @@ int MSDKVideoEncoder::InitEncodeOnEncoderThread(
   // If already inited, what we need to do is to reset the encoder,
   // instead of setting it all over again.
   if (inited_) {
+    DiscardPendingOps();
     m_pmfxENC->Close();
+    surface_pool_.Clear();
     MSDK_SAFE_DELETE_ARRAY(m_pEncSurfaces);
     m_pMFXAllocator.reset();
     // Settings change, we need to reconfigure the allocator.
     // Alternatively we totally reinitialize the encoder here.
   } else {
     MSDKFactory* factory = MSDKFactory::Get();
-    m_mfxSession = factory->CreateSession();
-    if (!m_mfxSession) {
-      return WEBRTC_VIDEO_CODEC_ERROR;
-    }
     if (codecType_ == webrtc::kVideoCodecH265) {
       codec_id = MFX_CODEC_HEVC;
     }
-
-    if (!factory->LoadEncoderPlugin(codec_id, m_mfxSession, &m_pluginID)) {
-      return WEBRTC_VIDEO_CODEC_ERROR;
+    if (m_memType_ == MSDK_D3D11_MEMORY) {
+      // D3D11 sessions are bound to the capture device and cannot be
+      // parked ahead of time.
+      m_mfxSession = factory->CreateD3D11Session(d3d11_input_device_);
+      if (!m_mfxSession) {
+        return WEBRTC_VIDEO_CODEC_ERROR;
+      }
+      if (!factory->LoadEncoderPlugin(codec_id, m_mfxSession, &m_pluginID)) {
+        return WEBRTC_VIDEO_CODEC_ERROR;
+      }
+    } else {
+      // Adopt a session parked by PrewarmEncodeResources when one
+      // exists; it already carries the codec's plugin.
+      m_mfxSession =
+          factory->TakePrewarmedEncodeSession(codec_id, &m_pluginID);
+      if (!m_mfxSession) {
+        m_mfxSession = factory->CreateSession();
+        if (!m_mfxSession) {
+          return WEBRTC_VIDEO_CODEC_ERROR;
+        }
+        if (!factory->LoadEncoderPlugin(codec_id, m_mfxSession, &m_pluginID)) {
+          return WEBRTC_VIDEO_CODEC_ERROR;
+        }
+      }
     }
 
-    // Create frame allocator, let the allocator create the param of its own
-    m_pMFXAllocator = m_pMFXAllocator = MSDKFactory::CreateFrameAllocator();
+    // Create frame allocator, let the allocator create the param of its own.
+    // D3D11 allocators are shared between sessions on the same device so
+    // surface memory pools across codecs.
+    if (m_memType_ == MSDK_D3D11_MEMORY) {
+      m_pMFXAllocator = factory->GetSharedFrameAllocator(d3d11_input_device_);
+    } else {
+      m_pMFXAllocator = MSDKFactory::CreateFrameAllocator();
+    }
     if (nullptr == m_pMFXAllocator) {
       return WEBRTC_VIDEO_CODEC_ERROR;
     }
@@ -172,12 +280,31 @@ int MSDKVideoEncoder::InitEncodeOnEncoderThread(
   }
 
   // Init the encoding params:
+  HardwareEncoderPreset preset =
+      GlobalConfiguration::GetHardwareEncoderPreset();
   MSDK_ZERO_MEMORY(m_mfxEncParams);
   m_mfxEncParams.mfx.CodecId = codec_id;
-  m_mfxEncParams.mfx.TargetUsage = MFX_TARGETUSAGE_BALANCED;
+  m_mfxEncParams.mfx.TargetUsage =
+      (preset == HardwareEncoderPreset::kUltraLowLatency)
+          ? MFX_TARGETUSAGE_BEST_SPEED
+          : MFX_TARGETUSAGE_BALANCED;
   m_mfxEncParams.mfx.TargetKbps = codec_settings->maxBitrate;  // in-kbps
   m_mfxEncParams.mfx.MaxKbps = codec_settings->maxBitrate;
   m_mfxEncParams.mfx.RateControlMethod = MFX_RATECONTROL_VBR;
+  if (codec_settings->mode == webrtc::kScreensharing &&
+      preset != HardwareEncoderPreset::kUltraLowLatency) {
+    // Screen content (detail/text content hints put the send stream in
+    // screencast mode): spend encode time on per-frame quality; WebRTC
+    // already degrades framerate instead of resolution for this mode.
+    // When the capture path has already classified the content as
+    // embedded video playback, keep the balanced target instead so the
+    // encoder sustains the full capture rate; EncodePipelined follows
+    // later classification changes with in-place resets.
+    applied_content_type_ = ScreenContentMonitor::Current();
+    if (applied_content_type_ != ScreenContentType::kMotion) {
+      m_mfxEncParams.mfx.TargetUsage = MFX_TARGETUSAGE_BEST_QUALITY;
+    }
+  }
   m_mfxEncParams.mfx.NumSlice = 0;
   MSDKConvertFrameRate(30, &m_mfxEncParams.mfx.FrameInfo.FrameRateExtN,
                        &m_mfxEncParams.mfx.FrameInfo.FrameRateExtD);
@@ -186,7 +313,9 @@ int MSDKVideoEncoder::InitEncodeOnEncoderThread(
   m_mfxEncParams.mfx.GopRefDist = 1;
   m_mfxEncParams.mfx.GopOptFlag = 0;
   m_mfxEncParams.mfx.IdrInterval = 0;
-  m_mfxEncParams.IOPattern = MFX_IOPATTERN_IN_SYSTEM_MEMORY;
+  m_mfxEncParams.IOPattern = (m_memType_ == MSDK_D3D11_MEMORY)
+                                 ? MFX_IOPATTERN_IN_VIDEO_MEMORY
+                                 : MFX_IOPATTERN_IN_SYSTEM_MEMORY;
 
   // Frame info parameters
   m_mfxEncParams.mfx.FrameInfo.FourCC = MFX_FOURCC_NV12;
@@ -201,9 +330,24 @@ int MSDKVideoEncoder::InitEncodeOnEncoderThread(
   m_mfxEncParams.mfx.FrameInfo.Height = MSDK_ALIGN16(codec_settings->height);
   m_mfxEncParams.mfx.FrameInfo.Width = MSDK_ALIGN16(codec_settings->width);
 
-  m_mfxEncParams.AsyncDepth = 1;
+  m_mfxEncParams.AsyncDepth = kEncoderAsyncDepth;
   m_mfxEncParams.mfx.NumRefFrame = 2;
 
+  // The latency presets shrink the pipeline to a single frame and drop the
+  // second reference; the ultra preset additionally replaces periodic IDR
+  // frames with intra refresh and slices each picture, so no single frame
+  // carries a full intra refresh worth of bits.
+  if (preset != HardwareEncoderPreset::kQualityStreaming) {
+    m_mfxEncParams.AsyncDepth = 1;
+    m_mfxEncParams.mfx.NumRefFrame = 1;
+  }
+  if (preset == HardwareEncoderPreset::kUltraLowLatency) {
+    // Losses are recovered by the intra-refresh column sweep configured
+    // below instead of periodic IDR frames; keyframe requests still force
+    // an IDR when a receiver joins.
+    m_mfxEncParams.mfx.NumSlice = 4;
+  }
+
   mfxExtCodingOption extendedCodingOptions;
   MSDK_ZERO_MEMORY(extendedCodingOptions);
   extendedCodingOptions.Header.BufferId = MFX_EXTBUFF_CODING_OPTION;
@@ -211,11 +355,23 @@ int MSDKVideoEncoder::InitEncodeOnEncoderThread(
   extendedCodingOptions.AUDelimiter = MFX_CODINGOPTION_OFF;
   extendedCodingOptions.PicTimingSEI = MFX_CODINGOPTION_OFF;
   extendedCodingOptions.VuiNalHrdParameters = MFX_CODINGOPTION_OFF;
+  if (preset != HardwareEncoderPreset::kQualityStreaming) {
+    extendedCodingOptions.MaxDecFrameBuffering = 1;
+  }
   mfxExtCodingOption2 extendedCodingOptions2;
   MSDK_ZERO_MEMORY(extendedCodingOptions2);
   extendedCodingOptions2.Header.BufferId = MFX_EXTBUFF_CODING_OPTION2;
   extendedCodingOptions2.Header.BufferSz = sizeof(extendedCodingOptions2);
   extendedCodingOptions2.RepeatPPS = MFX_CODINGOPTION_OFF;
+  // The ultra-low-latency preset always sweeps; otherwise a publication
+  // can request the sweep through PublishOptions::intra_refresh, which
+  // trades the periodic IDR burst of large screen-content frames for a
+  // steady column of intra blocks.
+  if (preset == HardwareEncoderPreset::kUltraLowLatency ||
+      IntraRefreshMode::Active()) {
+    extendedCodingOptions2.IntRefType = MFX_REFRESH_VERTICAL;
+    extendedCodingOptions2.IntRefCycleSize = 30;
+  }
 
   m_EncExtParams.push_back((mfxExtBuffer*)&extendedCodingOptions);
   m_EncExtParams.push_back((mfxExtBuffer*)&extendedCodingOptions2);
@@ -306,6 +462,13 @@ int MSDKVideoEncoder::InitEncodeOnEncoderThread(
     memset(&(m_pEncSurfaces[i]), 0, sizeof(mfxFrameSurface1));
     MSDK_MEMCPY_VAR(m_pEncSurfaces[i].Info, &(m_mfxEncParams.mfx.FrameInfo),
                     sizeof(mfxFrameInfo));
+    if (m_memType_ == MSDK_D3D11_MEMORY) {
+      // Video memory surfaces are shared with the SDK through the
+      // allocator; only the mid is recorded here and the pixels stay on
+      // the GPU.
+      m_pEncSurfaces[i].Data.MemId = m_EncResponse.mids[i];
+      continue;
+    }
     // Since we're not going to share it with sdk. we need to lock it here.
     sts = m_pMFXAllocator->Lock(m_pMFXAllocator->pthis, m_EncResponse.mids[i],
                                 &(m_pEncSurfaces[i].Data));
@@ -313,11 +476,58 @@ int MSDKVideoEncoder::InitEncodeOnEncoderThread(
       return WEBRTC_VIDEO_CODEC_ERROR;
     }
   }
+  surface_pool_.Assign(m_pEncSurfaces, m_EncResponse.NumFrameActual);
+  surface_pool_.SetGaugeName("msdk.encoder.locked_surfaces");
 
   inited_ = true;
   return WEBRTC_VIDEO_CODEC_OK;
 }
 
+int MSDKVideoEncoder::ResetOnEncoderThread(
+    const webrtc::VideoCodec* codec_settings) {
+  if (!inited_ || m_pmfxENC == nullptr || m_pEncSurfaces == nullptr) {
+    return WEBRTC_VIDEO_CODEC_ERROR;
+  }
+  // The surface array keeps its allocated size, so an in-place change
+  // can only crop further into it. Growing past the allocation needs
+  // the full reinitialization path.
+  if (MSDK_ALIGN16(codec_settings->width) > m_pEncSurfaces[0].Info.Width ||
+      MSDK_ALIGN16(codec_settings->height) > m_pEncSurfaces[0].Info.Height) {
+    return WEBRTC_VIDEO_CODEC_ERROR;
+  }
+  // Finish the submitted operations so nothing in flight is lost across
+  // the parameter change.
+  DrainPendingOps(true);
+  m_mfxEncParams.mfx.FrameInfo.CropW = codec_settings->width;
+  m_mfxEncParams.mfx.FrameInfo.CropH = codec_settings->height;
+  if (codec_settings->maxFramerate > 0) {
+    MSDKConvertFrameRate(codec_settings->maxFramerate,
+                         &m_mfxEncParams.mfx.FrameInfo.FrameRateExtN,
+                         &m_mfxEncParams.mfx.FrameInfo.FrameRateExtD);
+  }
+  if (codec_settings->maxBitrate > 0) {
+    m_mfxEncParams.mfx.TargetKbps = codec_settings->maxBitrate;
+    m_mfxEncParams.mfx.MaxKbps = codec_settings->maxBitrate;
+  }
+  mfxStatus sts = m_pmfxENC->Reset(&m_mfxEncParams);
+  if (MFX_WRN_INCOMPATIBLE_VIDEO_PARAM == sts) {
+    // The driver adjusted a parameter but accepted the reset.
+    sts = MFX_ERR_NONE;
+  }
+  if (MFX_ERR_NONE != sts) {
+    RTC_LOG(LS_WARNING) << "In-place encoder reset rejected with status "
+                        << sts << "; falling back to full reinitialization.";
+    return WEBRTC_VIDEO_CODEC_ERROR;
+  }
+  // Keep the surface descriptors in step with the encoder so loaded
+  // frames carry the new crop.
+  for (int i = 0; i < m_EncResponse.NumFrameActual; i++) {
+    m_pEncSurfaces[i].Info.CropW = codec_settings->width;
+    m_pEncSurfaces[i].Info.CropH = codec_settings->height;
+  }
+  return WEBRTC_VIDEO_CODEC_OK;
+}
+
 void MSDKVideoEncoder::WipeMfxBitstream(mfxBitstream* pBitstream) {
   // Free allocated memory
   MSDK_SAFE_DELETE_ARRAY(pBitstream->Data);
@@ -327,61 +537,74 @@ void MSDKVideoEncoder::WipeMfxBitstream(mfxBitstream* pBitstream) {
 int count = 0;
 #endif
 
-mfxU16 MSDKVideoEncoder::MSDKGetFreeSurface(mfxFrameSurface1* pSurfacesPool,
-                                            mfxU16 nPoolSize) {
-  mfxU32 SleepInterval = 10;  // milliseconds
-
-  mfxU16 idx = MSDK_INVALID_SURF_IDX;
-
-  // Wait if there's no free surface
-  for (mfxU32 i = 0; i < MSDK_WAIT_INTERVAL; i += SleepInterval) {
-    idx = MSDKGetFreeSurfaceIndex(pSurfacesPool, nPoolSize);
-
-    if (MSDK_INVALID_SURF_IDX != idx) {
-      break;
-    } else {
-      MSDK_SLEEP(SleepInterval);
-    }
-  }
-
-  return idx;
-}
-
-mfxU16 MSDKVideoEncoder::MSDKGetFreeSurfaceIndex(
-    mfxFrameSurface1* pSurfacesPool,
-    mfxU16 nPoolSize) {
-  if (pSurfacesPool) {
-    for (mfxU16 i = 0; i < nPoolSize; i++) {
-      if (0 == pSurfacesPool[i].Data.Locked) {
-        return i;
-      }
-    }
-  }
-
-  return MSDK_INVALID_SURF_IDX;
+int MSDKVideoEncoder::Encode(
+    const webrtc::VideoFrame& input_image,
+    const webrtc::CodecSpecificInfo* codec_specific_info,
+    const std::vector<webrtc::FrameType>* frame_types) {
+  // Runs directly on the webrtc encode thread. The frame is submitted to
+  // the asynchronous MSDK pipeline and whatever earlier operations have
+  // completed are delivered on the way out, so the thread never parks
+  // waiting for the GPU to finish this frame.
+  return EncodePipelined(input_image, codec_specific_info, frame_types);
 }
 
-int MSDKVideoEncoder::Encode(
+int MSDKVideoEncoder::EncodePipelined(
     const webrtc::VideoFrame& input_image,
     const webrtc::CodecSpecificInfo* codec_specific_info,
     const std::vector<webrtc::FrameType>* frame_types) {
-  // Delegate the encoding task to encoder thread.
+  OWT_TRACE_SCOPE("MSDKVideoEncoder.Encode");
+  // A wedged driver call inside this section is what the watchdog is
+  // there to catch.
+  ScopedWatchdogSection watchdog(watchdog_handle_, "MSDKVideoEncoder.Encode");
+  PipelineLatencyTracer::Record(
+      PipelineLatencyTracer::kHardwareEncode,
+      rtc::TimeMillis() - input_image.render_time_ms());
+  // Follow the capture path's content classification: an atomic load per
+  // frame, a driver reset only when the classification settles on the
+  // other type.
+  if (inited_ && codec_settings_.mode == webrtc::kScreensharing) {
+    ScreenContentType detected = ScreenContentMonitor::Current();
+    if (detected != ScreenContentType::kUnknown &&
+        detected != applied_content_type_ &&
+        rtc::TimeMillis() - last_content_switch_ms_ >=
+            kContentSwitchIntervalMs) {
+      ApplyScreenContentType(detected);
+    }
+  }
+  // Fold in any rate snapshot SetRates has published since the last
+  // frame. Applied here, between frames on the thread that encodes, so
+  // the rate-only Reset never contends with an encode mid-frame.
+  uint64_t pending_rates = pending_rates_.exchange(0, std::memory_order_acquire);
+  if (pending_rates != 0) {
+    ApplyRates(static_cast<uint32_t>((pending_rates >> 32) & 0x7FFFFFFFu),
+               static_cast<uint32_t>(pending_rates & 0xFFFFFFFFu));
+  }
   mfxStatus sts = MFX_ERR_NONE;
   mfxFrameSurface1* pSurf = NULL;  // dispatching pointer
   mfxU16 nEncSurfIdx = 0;
 
-  nEncSurfIdx =
-      MSDKGetFreeSurface(m_pEncSurfaces, m_EncResponse.NumFrameActual);
-  if (MSDK_INVALID_SURF_IDX == nEncSurfIdx) {
-    return WEBRTC_VIDEO_CODEC_ERROR;
+  // See Encode(): D3D11 texture frames stay in video memory end to end.
+  rtc::scoped_refptr<webrtc::VideoFrameBuffer> frame_buffer(
+      input_image.video_frame_buffer());
+  D3D11ImageHandle* d3d11_handle = nullptr;
+  if (frame_buffer->type() == webrtc::VideoFrameBuffer::Type::kNative &&
+      static_cast<NativeHandleBuffer*>(frame_buffer.get())->handle_type() ==
+          NativeHandleBuffer::kD3D11Texture) {
+    d3d11_handle = reinterpret_cast<D3D11ImageHandle*>(
+        static_cast<NativeHandleBuffer*>(frame_buffer.get())->native_handle());
+    if (m_memType_ != MSDK_D3D11_MEMORY &&
+        SwitchToD3D11Input(d3d11_handle->d3d11_device) !=
+            WEBRTC_VIDEO_CODEC_OK) {
+      return WEBRTC_VIDEO_CODEC_ERROR;
+    }
   }
 
-  pSurf = &m_pEncSurfaces[nEncSurfIdx];
-  sts = m_pMFXAllocator->Lock(m_pMFXAllocator->pthis, pSurf->Data.MemId,
-                              &(pSurf->Data));
-  if (MFX_ERR_NONE != sts) {
+  nEncSurfIdx = surface_pool_.WaitForFreeSurface(MSDK_ENC_WAIT_INTERVAL);
+  if (MSDK_INVALID_SURF_IDX == nEncSurfIdx) {
     return WEBRTC_VIDEO_CODEC_ERROR;
   }
+  pSurf = &m_pEncSurfaces[nEncSurfIdx];
+
   // Load the image onto surface. Check the frame info first to format.
   mfxFrameInfo& pInfo = pSurf->Info;
   mfxFrameData& pData = pSurf->Data;
@@ -391,7 +614,6 @@ int MSDKVideoEncoder::Encode(
     return WEBRTC_VIDEO_CODEC_ERROR;
   }
   mfxU16 w, h, pitch;
-  mfxU8* ptr;
   if (pInfo.CropH > 0 && pInfo.CropW > 0) {
     w = pInfo.CropW;
     h = pInfo.CropH;
@@ -400,14 +622,34 @@ int MSDKVideoEncoder::Encode(
     h = pInfo.Height;
   }
 
-  pitch = pData.Pitch;
-  ptr = pData.Y + pInfo.CropX + pInfo.CropY * pData.Pitch;
-
-  if (MFX_FOURCC_NV12 == pInfo.FourCC) {
-    // TODO: As an optimization target, later we will use VPP for CSC
-    // conversion. For now I420 to NV12 CSC is AVX2 instruction optimized.
+  if (d3d11_handle != nullptr) {
+    // Wait for the producer's GPU work on the shared texture instead of
+    // requiring the producer to flush. A frame whose producer is still
+    // busy after several frame intervals is stale and gets dropped.
+    if (!d3d11_handle->AcquireSync(100)) {
+      RTC_LOG(LS_WARNING) << "Timed out acquiring shared input texture.";
+      return WEBRTC_VIDEO_CODEC_ERROR;
+    }
+    int load_result = LoadD3D11Texture(*d3d11_handle, pSurf);
+    d3d11_handle->ReleaseSync();
+    if (load_result != WEBRTC_VIDEO_CODEC_OK) {
+      return WEBRTC_VIDEO_CODEC_ERROR;
+    }
+  } else if (MFX_FOURCC_NV12 == pInfo.FourCC &&
+             frame_buffer->type() ==
+                 webrtc::VideoFrameBuffer::Type::kNative) {
+    pitch = pData.Pitch;
+    // Native NV12 input: load the planes without color space conversion.
+    NV12ImageHandle* handle = reinterpret_cast<NV12ImageHandle*>(
+        static_cast<NativeHandleBuffer*>(frame_buffer.get())
+            ->native_handle());
+    libyuv::CopyPlane(handle->data_y, handle->stride_y, pData.Y, pitch, w, h);
+    libyuv::CopyPlane(handle->data_uv, handle->stride_uv, pData.UV, pitch, w,
+                      (h + 1) / 2);
+  } else if (MFX_FOURCC_NV12 == pInfo.FourCC) {
+    pitch = pData.Pitch;
     rtc::scoped_refptr<webrtc::I420BufferInterface> buffer(
-        input_image.video_frame_buffer()->ToI420());
+        frame_buffer->ToI420());
 #ifdef OWT_DEBUG_MSDK_ENC
     if (input != nullptr && count < 30) {
       fwrite((void*)(buffer->DataY()), w * h, 1, input);
@@ -428,28 +670,20 @@ int MSDKVideoEncoder::Encode(
     // Do not support it.
     return WEBRTC_VIDEO_CODEC_ERROR;
   }
-
-  // Our input is YUV420p and needs to convert to nv12
-  //...we're done with the frame
-  sts = m_pMFXAllocator->Unlock(m_pMFXAllocator->pthis, pSurf->Data.MemId,
-                                &(pSurf->Data));
-  if (MFX_ERR_NONE != sts) {
-    return WEBRTC_VIDEO_CODEC_ERROR;
-  }
-
   // Prepare done. Start encode.
   mfxEncodeCtrl ctrl;
   memset((void*)&ctrl, 0, sizeof(ctrl));
   bool is_keyframe_required = false;
   if (frame_types) {
     for (auto frame_type : *frame_types) {
-      if (frame_type == webrtc::kVideoFrameKey ||
-          m_nFramesProcessed % 30 == 0) {
+      if (frame_type == webrtc::kVideoFrameKey) {
         is_keyframe_required = true;
         break;
       }
     }
   }
+  if (is_keyframe_required && !AllowKeyFrameRequest())
+    is_keyframe_required = false;
   mfxBitstream bs;
   mfxSyncPoint sync;
   // Allocate enough buffer for output stream.
@@ -463,19 +697,57 @@ int MSDKVideoEncoder::Encode(
   MSDK_ZERO_MEMORY(bs);
   mfxU32 bsDataSize = param.mfx.BufferSizeInKB * 1000;
   mfxU8* pbsData = new mfxU8[bsDataSize];
-  mfxU8* newPbsData = nullptr;
   if (pbsData == nullptr) {
     return WEBRTC_VIDEO_CODEC_ERROR;
   }
   memset((void*)pbsData, 0, bsDataSize);
   bs.Data = pbsData;
   bs.MaxLength = bsDataSize;
-  // If the encoder does not prompt about need more data, we continue the same
-  // process.
 
-  memset(&ctrl, 0, sizeof(ctrl));
-  if (is_keyframe_required) {
-    ctrl.FrameType = MFX_FRAMETYPE_I | MFX_FRAMETYPE_REF | MFX_FRAMETYPE_IDR;
+  ctrl.FrameType = is_keyframe_required
+                       ? MFX_FRAMETYPE_I | MFX_FRAMETYPE_REF | MFX_FRAMETYPE_IDR
+                       : MFX_FRAMETYPE_P | MFX_FRAMETYPE_REF;
+  // Attach the application's region-of-interest hint when one is set
+  // (LocalStream::SetRegionOfInterest), so the rate controller spends
+  // bits where the application says content changes. |roi_buffer| must
+  // stay alive until EncodeFrameAsync returns.
+  mfxExtEncoderROI roi_buffer;
+  mfxExtBuffer* ctrl_ext_params[1];
+  RoiHint::Region roi_region;
+  if (RoiHint::Get(&roi_region)) {
+    // Clamp to the coded picture and align to the macroblock grid; an
+    // empty result after clamping drops the hint for this frame.
+    mfxU32 pic_width = m_mfxEncParams.mfx.FrameInfo.CropW;
+    mfxU32 pic_height = m_mfxEncParams.mfx.FrameInfo.CropH;
+    mfxU32 roi_left = (std::max)(roi_region.left, 0) & ~15;
+    mfxU32 roi_top = (std::max)(roi_region.top, 0) & ~15;
+    mfxU32 roi_right =
+        (std::min)(static_cast<mfxU32>(MSDK_ALIGN16(roi_region.right)),
+                   pic_width);
+    mfxU32 roi_bottom =
+        (std::min)(static_cast<mfxU32>(MSDK_ALIGN16(roi_region.bottom)),
+                   pic_height);
+    if (roi_left < roi_right && roi_top < roi_bottom) {
+      MSDK_ZERO_MEMORY(roi_buffer);
+      roi_buffer.Header.BufferId = MFX_EXTBUFF_ENCODER_ROI;
+      roi_buffer.Header.BufferSz = sizeof(roi_buffer);
+      roi_buffer.NumROI = 1;
+      roi_buffer.ROI[0].Left = roi_left;
+      roi_buffer.ROI[0].Top = roi_top;
+      roi_buffer.ROI[0].Right = roi_right;
+      roi_buffer.ROI[0].Bottom = roi_bottom;
+#if (MFX_VERSION >= 1022)
+      roi_buffer.ROIMode = MFX_ROI_MODE_QP_DELTA;
+      roi_buffer.ROI[0].DeltaQP = static_cast<mfxI16>(
+          (std::min)((std::max)(roi_region.quality_delta, -51), 51));
+#else
+      roi_buffer.ROI[0].Priority = static_cast<mfxI16>(
+          (std::min)((std::max)(-roi_region.quality_delta, -3), 3));
+#endif
+      ctrl_ext_params[0] = reinterpret_cast<mfxExtBuffer*>(&roi_buffer);
+      ctrl.ExtParam = ctrl_ext_params;
+      ctrl.NumExtParam = 1;
+    }
   }
 retry:
   sts = m_pmfxENC->EncodeFrameAsync(&ctrl, pSurf, &bs, &sync);
@@ -483,304 +755,238 @@ retry:
     MSDK_SLEEP(1);
     goto retry;
   } else if (MFX_ERR_NOT_ENOUGH_BUFFER == sts) {
+    // The encoder raised its buffer requirement; regrow and resubmit.
     m_pmfxENC->GetVideoParam(&param);
     mfxU32 newBsDataSize = param.mfx.BufferSizeInKB * 1000;
-    newPbsData = new mfxU8[newBsDataSize];
+    mfxU8* newPbsData = new mfxU8[newBsDataSize];
     if (bs.DataLength > 0) {
       CopyMemory(newPbsData, bs.Data + bs.DataOffset, bs.DataLength);
       bs.DataOffset = 0;
     }
     delete[] pbsData;
-    pbsData = nullptr;
-    bs.Data = newPbsData;
+    pbsData = newPbsData;
+    bs.Data = pbsData;
     bs.MaxLength = newBsDataSize;
     goto retry;
-  } else if (MFX_ERR_NONE != sts) {
+  } else if (MFX_ERR_MORE_DATA == sts) {
+    // Encoder buffered the input without producing output for it yet;
+    // nothing to sync.
+    m_nFramesProcessed++;
     delete[] pbsData;
-    pbsData = nullptr;
     return WEBRTC_VIDEO_CODEC_OK;
-  }
-
-  sts = m_mfxSession->SyncOperation(sync, MSDK_ENC_WAIT_INTERVAL);
-  if (MFX_ERR_NONE != sts) {
-    if (pbsData != nullptr) {
-      delete[] pbsData;
-      pbsData = nullptr;
-    }
-    if (newPbsData != nullptr) {
-      delete[] newPbsData;
-      newPbsData = nullptr;
-    }
+  } else if (MFX_ERR_NONE != sts) {
+    m_nFramesProcessed++;
+    delete[] pbsData;
     return WEBRTC_VIDEO_CODEC_ERROR;
   }
+  m_nFramesProcessed++;
+  // Queue the operation instead of syncing it right away. With
+  // AsyncDepth > 1 the GPU keeps working on this frame while completed
+  // earlier operations are scanned and delivered below; we only block
+  // once the pipeline is full.
+  PendingEncodeOp op;
+  op.bs = bs;
+  op.sync = sync;
+  op.bs_data = pbsData;
+  op.is_keyframe = is_keyframe_required;
+  op.width = input_image.width();
+  op.height = input_image.height();
+  op.render_time_ms = input_image.render_time_ms();
+  op.timestamp = input_image.timestamp();
+  pending_ops_.push_back(op);
+  return DrainPendingOps(false);
+}
 
-  uint8_t* encoded_data = static_cast<uint8_t*>(bs.Data) + bs.DataOffset;
-  int encoded_data_size = bs.DataLength;
+// Packages one synced encode operation and hands it to the callback.
+int MSDKVideoEncoder::DeliverEncodedOp(PendingEncodeOp& op) {
+  uint8_t* encoded_data = static_cast<uint8_t*>(op.bs.Data) + op.bs.DataOffset;
+  int encoded_data_size = op.bs.DataLength;
+  webrtc::EncodedImage encodedFrame(encoded_data, encoded_data_size,
+                                    encoded_data_size);
 #ifdef OWT_DEBUG_MSDK_ENC
   count++;
-  if (output != nullptr && count <= 20) {
+  if (output != nullptr && count < 30) {
     fwrite((void*)(encoded_data), encoded_data_size, 1, output);
   } else if (count == 30) {
     fclose(output);
     output = nullptr;
   }
 #endif
-  webrtc::EncodedImage encodedFrame(encoded_data, encoded_data_size,
-                                    encoded_data_size);
 
-  // For current MSDK, AUD and SEI can be removed so we don't explicitly remove
-  // them.
-  encodedFrame._encodedHeight = input_image.height();
-  encodedFrame._encodedWidth = input_image.width();
+  encodedFrame._encodedHeight = op.height;
+  encodedFrame._encodedWidth = op.width;
   encodedFrame._completeFrame = true;
-  encodedFrame.capture_time_ms_ = input_image.render_time_ms();
-  encodedFrame._timeStamp = input_image.timestamp();
+  encodedFrame.capture_time_ms_ = op.render_time_ms;
+  encodedFrame._timeStamp = op.timestamp;
   encodedFrame._frameType =
-      is_keyframe_required ? webrtc::kVideoFrameKey : webrtc::kVideoFrameDelta;
+      op.is_keyframe ? webrtc::kVideoFrameKey : webrtc::kVideoFrameDelta;
 
   webrtc::CodecSpecificInfo info;
   memset(&info, 0, sizeof(info));
   info.codecType = codecType_;
-  // Generate a header describing a single fragment.
-  webrtc::RTPFragmentationHeader header;
-  memset(&header, 0, sizeof(header));
-
-  int32_t scPositions[MAX_NALUS_PERFRAME + 1] = {};
-  uint8_t scLengths[MAX_NALUS_PERFRAME + 1] = {};
-  int32_t scPositionsLength = 0;
-  int32_t scPosition = 0;
-  while (scPositionsLength < MAX_NALUS_PERFRAME) {
-    uint8_t sc_length = 0;
-    int32_t naluPosition = NextNaluPosition(
-        encoded_data + scPosition, encoded_data_size - scPosition, &sc_length);
-    if (naluPosition < 0) {
-      break;
-    }
-    scPosition += naluPosition;
-    scLengths[scPositionsLength] = sc_length;
-    scPositions[scPositionsLength] = scPosition;
-    scPositionsLength++;
-    scPosition += sc_length;
-  }
-  if (scPositionsLength == 0) {
+  webrtc::RTPFragmentationHeader& header = frag_header_;
+
+  if (ScanNaluFragments(encoded_data, encoded_data_size, &header) == 0) {
     RTC_LOG(LS_ERROR) << "Start code is not found for codec!";
-    delete[] pbsData;
     return WEBRTC_VIDEO_CODEC_ERROR;
   }
-  scPositions[scPositionsLength] = encoded_data_size;
-  header.VerifyAndAllocateFragmentationHeader(scPositionsLength);
-  for (int i = 0; i < scPositionsLength; i++) {
-    header.fragmentationOffset[i] = scPositions[i] + scLengths[i];
-    header.fragmentationLength[i] =
-        scPositions[i + 1] - header.fragmentationOffset[i];
-    header.fragmentationPlType[i] = 0;
-    header.fragmentationTimeDiff[i] = 0;
-  }
+
   const auto result = callback_->OnEncodedImage(encodedFrame, &info, &header);
-  if (result.error != webrtc::EncodedImageCallback::Result::Error::OK) {
-    delete[] pbsData;
-    bs.DataLength = 0;  // Mark we don't need the data anymore.
-    bs.DataOffset = 0;
-    return WEBRTC_VIDEO_CODEC_ERROR;
+  // The recording tap reads the bitstream before the operation's buffer
+  // is released by the drain loop.
+  if (EncodedStreamRecorder::Active()) {
+    EncodedStreamRecorder::Record(codecType_, encodedFrame._timeStamp,
+                                  encodedFrame.capture_time_ms_,
+                                  op.is_keyframe, encoded_data,
+                                  encoded_data_size);
   }
-  if (pbsData != nullptr) {
-    delete[] pbsData;
-    pbsData = nullptr;
+  if (LocalLoopbackSender::Active()) {
+    LocalLoopbackSender::Deliver(encodedFrame._timeStamp, op.is_keyframe,
+                                 encoded_data, encoded_data_size);
   }
-  if (newPbsData != nullptr) {
-    delete[] newPbsData;
-    newPbsData = nullptr;
+  if (result.error != webrtc::EncodedImageCallback::Result::Error::OK) {
+    RTC_LOG(LS_ERROR) << "Deliver encoded frame callback failed: "
+                      << result.error;
+    return WEBRTC_VIDEO_CODEC_ERROR;
   }
-  m_nFramesProcessed++;
-
-  bs.DataLength = 0;  // Mark we don't need the data anymore.
-  bs.DataOffset = 0;
   return WEBRTC_VIDEO_CODEC_OK;
 }
 
-// This version of encode implementation is reserved here in case we have
-// further demand to encode the same thread. For MSDK, it's not mandatory to
-// encode in same thread...And it's not good practice to allow blocking call on
-// worker thread.
-int MSDKVideoEncoder::EncodeOnEncoderThread(
-    const webrtc::VideoFrame& input_image,
-    const webrtc::CodecSpecificInfo* codec_specific_info,
-    const std::vector<webrtc::FrameType>* frame_types) {
-  mfxStatus sts = MFX_ERR_NONE;
-  mfxFrameSurface1* pSurf = NULL;  // dispatching pointer
-  mfxU16 nEncSurfIdx = 0;
-  nEncSurfIdx =
-      MSDKGetFreeSurface(m_pEncSurfaces, m_EncResponse.NumFrameActual);
-  if (MSDK_INVALID_SURF_IDX == nEncSurfIdx) {
-    return WEBRTC_VIDEO_CODEC_ERROR;
-  }
-  pSurf = &m_pEncSurfaces[nEncSurfIdx];
-
-  // Load the image onto surface. Check the frame info first to format.
-  mfxFrameInfo& pInfo = pSurf->Info;
-  mfxFrameData& pData = pSurf->Data;
-  pData.FrameOrder = m_nFramesProcessed;
-
-  if (MFX_FOURCC_NV12 != pInfo.FourCC && MFX_FOURCC_YV12 != pInfo.FourCC) {
-    return WEBRTC_VIDEO_CODEC_ERROR;
-  }
-  mfxU16 w, h, pitch;
-  mfxU8* ptr;
-  if (pInfo.CropH > 0 && pInfo.CropW > 0) {
-    w = pInfo.CropW;
-    h = pInfo.CropH;
-  } else {
-    w = pInfo.Width;
-    h = pInfo.Height;
-  }
-
-  pitch = pData.Pitch;
-  ptr = pData.Y + pInfo.CropX + pInfo.CropY * pData.Pitch;
-
-  if (MFX_FOURCC_NV12 == pInfo.FourCC) {
-    rtc::scoped_refptr<webrtc::I420BufferInterface> buffer(
-        input_image.video_frame_buffer()->ToI420());
-#ifdef OWT_DEBUG_MSDK_ENC
-    if (input != nullptr && count < 30) {
-      fwrite((void*)(buffer->DataY()), w * h, 1, input);
-      fwrite((void*)(buffer->DataU()), w * h / 4, 1, input);
-      fwrite((void*)(buffer->DataV()), w * h / 4, 1, input);
+// Delivers every completed operation at the head of the pipeline. When
+// |blocking| is set, or the pipeline is full, the front operation is waited
+// on; otherwise an operation still executing on the GPU ends the drain.
+int MSDKVideoEncoder::DrainPendingOps(bool blocking) {
+  while (!pending_ops_.empty()) {
+    // The pipeline is bounded by the session's configured depth, which the
+    // latency presets shrink down to a single frame.
+    bool must_wait = blocking || pending_ops_.size() >= m_mfxEncParams.AsyncDepth;
+    PendingEncodeOp& op = pending_ops_.front();
+    mfxStatus sts = m_mfxSession->SyncOperation(
+        op.sync, must_wait ? MSDK_ENC_WAIT_INTERVAL : 0);
+    if (MFX_WRN_IN_EXECUTION == sts && !must_wait) {
+      return WEBRTC_VIDEO_CODEC_OK;
     }
-#endif
-    libyuv::I420ToNV12(buffer->DataY(), buffer->StrideY(), buffer->DataU(),
-                       buffer->StrideU(), buffer->DataV(), buffer->StrideV(),
-                       pData.Y, pitch, pData.UV, pitch, w, h);
-#ifdef OWT_DEBUG_MSDK_ENC
-    if (count == 30) {
-      fclose(input);
-      input = nullptr;
+    // The completed operation's input surface is unlocked by now; wake any
+    // thread waiting to acquire one.
+    surface_pool_.NotifySurfaceReleased();
+    int delivery = WEBRTC_VIDEO_CODEC_ERROR;
+    if (MFX_ERR_NONE == sts) {
+      delivery = DeliverEncodedOp(op);
     }
-#endif
-  } else if (MFX_FOURCC_YV12 == pInfo.FourCC) {
-    // Do not support it.
-    return WEBRTC_VIDEO_CODEC_ERROR;
-  }
-  // Prepare done. Start encode.
-  mfxEncodeCtrl ctrl;
-  memset((void*)&ctrl, 0, sizeof(ctrl));
-  bool is_keyframe_required = false;
-  if (frame_types) {
-    for (auto frame_type : *frame_types) {
-      if (frame_type == webrtc::kVideoFrameKey) {
-        is_keyframe_required = true;
-        break;
-      }
+    delete[] op.bs_data;
+    pending_ops_.pop_front();
+    if (delivery != WEBRTC_VIDEO_CODEC_OK) {
+      return delivery;
     }
   }
-  mfxBitstream bs;
-  mfxSyncPoint sync;
-  // Allocate enough buffer for output stream.
-  mfxVideoParam param;
-  MSDK_ZERO_MEMORY(param);
-  sts = m_pmfxENC->GetVideoParam(&param);
-  if (MFX_ERR_NONE != sts) {
-    return WEBRTC_VIDEO_CODEC_ERROR;
-  }
-
-  MSDK_ZERO_MEMORY(bs);
-  mfxU32 bsDataSize = param.mfx.BufferSizeInKB * 1000;
-  mfxU8* pbsData = new mfxU8[bsDataSize];
-  if (pbsData == nullptr) {
-    return WEBRTC_VIDEO_CODEC_ERROR;
-  }
-  memset((void*)pbsData, 0, bsDataSize);
-  bs.Data = pbsData;
-  bs.MaxLength = bsDataSize;
+  return WEBRTC_VIDEO_CODEC_OK;
+}
 
-  ctrl.FrameType = is_keyframe_required
-                       ? MFX_FRAMETYPE_I | MFX_FRAMETYPE_REF | MFX_FRAMETYPE_IDR
-                       : MFX_FRAMETYPE_P | MFX_FRAMETYPE_REF;
-  sts = m_pmfxENC->EncodeFrameAsync(&ctrl, pSurf, &bs, &sync);
-  if (MFX_ERR_NONE != sts) {
-    m_nFramesProcessed++;
-    delete[] pbsData;
-    return WEBRTC_VIDEO_CODEC_ERROR;
+// Syncs and frees every in-flight operation without delivering it. Used
+// when the encoder is reset or released, where the sync points would
+// otherwise dangle past MFXVideoENCODE::Close.
+void MSDKVideoEncoder::DiscardPendingOps() {
+  for (auto& op : pending_ops_) {
+    if (m_mfxSession) {
+      m_mfxSession->SyncOperation(op.sync, MSDK_ENC_WAIT_INTERVAL);
+    }
+    delete[] op.bs_data;
   }
+  pending_ops_.clear();
+  surface_pool_.NotifySurfaceReleased();
+}
 
-  sts = m_mfxSession->SyncOperation(sync, MSDK_ENC_WAIT_INTERVAL);
-  if (MFX_ERR_NONE != sts) {
-    // Get the output buffer from bs.
-    m_nFramesProcessed++;
-    delete[] pbsData;
-    return WEBRTC_VIDEO_CODEC_ERROR;
+// Rebuilds the encode pipeline around video memory surfaces on |device|.
+// The session and the encoder were created for system memory input, so
+// both are torn down and recreated with the D3D11 accelerator attached.
+int MSDKVideoEncoder::SwitchToD3D11Input(ID3D11Device* device) {
+  RTC_LOG(LS_INFO) << "Rebuilding MSDK encoder for D3D11 texture input.";
+  DiscardPendingOps();
+  if (m_pmfxENC != nullptr) {
+    m_pmfxENC->Close();
+    delete m_pmfxENC;
+    m_pmfxENC = nullptr;
   }
-  uint8_t* encoded_data = static_cast<uint8_t*>(bs.Data);
-  int encoded_data_size = bs.DataLength;
-  webrtc::EncodedImage encodedFrame(encoded_data, encoded_data_size,
-                                    encoded_data_size);
-#ifdef OWT_DEBUG_MSDK_ENC
-  count++;
-  if (output != nullptr && count < 30) {
-    fwrite((void*)(encoded_data), encoded_data_size, 1, output);
-  } else if (count == 30) {
-    fclose(output);
-    output = nullptr;
+  surface_pool_.Clear();
+  MSDK_SAFE_DELETE_ARRAY(m_pEncSurfaces);
+  if (m_mfxSession) {
+    MSDKFactory* factory = MSDKFactory::Get();
+    if (factory) {
+      factory->UnloadMSDKPlugin(m_mfxSession, &m_pluginID);
+      factory->DestroySession(m_mfxSession);
+    }
+    m_mfxSession = nullptr;
   }
-#endif
-
-  encodedFrame._encodedHeight = input_image.height();
-  encodedFrame._encodedWidth = input_image.width();
-  encodedFrame._completeFrame = true;
-  encodedFrame.capture_time_ms_ = input_image.render_time_ms();
-  encodedFrame._timeStamp = input_image.timestamp();
-  encodedFrame._frameType =
-      is_keyframe_required ? webrtc::kVideoFrameKey : webrtc::kVideoFrameDelta;
+  m_pMFXAllocator.reset();
+  m_EncExtParams.clear();
+  inited_ = false;
+
+  d3d11_input_device_ = device;
+  d3d11_input_device_->AddRef();
+  d3d11_input_device_->GetImmediateContext(&d3d11_device_context_);
+  m_memType_ = MSDK_D3D11_MEMORY;
+  return InitEncodeOnEncoderThread(&codec_settings_, 0, 0);
+}
 
-  webrtc::CodecSpecificInfo info;
-  memset(&info, 0, sizeof(info));
-  info.codecType = codecType_;
-  webrtc::RTPFragmentationHeader header;
-  memset(&header, 0, sizeof(header));
-
-  int32_t scPositions[MAX_NALUS_PERFRAME + 1] = {};
-  int32_t scLengths[MAX_NALUS_PERFRAME + 1] = {};
-  int32_t scPositionsLength = 0;
-  int32_t scPosition = 0;
-  uint8_t start_code_length = 0;
-  while (scPositionsLength < MAX_NALUS_PERFRAME) {
-    int32_t naluPosition =
-        NextNaluPosition(encoded_data + scPosition,
-                         encoded_data_size - scPosition, &start_code_length);
-    if (naluPosition < 0) {
-      break;
+// Copies |handle|'s texture into |surface| entirely on the GPU. BGRA input
+// is first converted to NV12 by the video processor; in either case the
+// pixels never cross back to system memory.
+int MSDKVideoEncoder::LoadD3D11Texture(const D3D11ImageHandle& handle,
+                                       mfxFrameSurface1* surface) {
+  ID3D11Texture2D* texture = handle.texture;
+  UINT subresource = handle.array_index < 0 ? 0 : handle.array_index;
+  D3D11_TEXTURE2D_DESC desc;
+  texture->GetDesc(&desc);
+  if (desc.Format != DXGI_FORMAT_NV12) {
+    if (!d3d11_converter_) {
+      d3d11_converter_.reset(new D3D11VideoConverter());
+      if (!d3d11_converter_->Init(d3d11_input_device_)) {
+        RTC_LOG(LS_ERROR)
+            << "No video processor available to convert input texture.";
+        d3d11_converter_.reset();
+        return WEBRTC_VIDEO_CODEC_ERROR;
+      }
     }
-    scPosition += naluPosition;
-    scPositions[scPositionsLength++] = scPosition;
-    scPosition += start_code_length;
-    scLengths[scPositionsLength - 1] = start_code_length;
-  }
-  if (scPositionsLength == 0) {
-    RTC_LOG(LS_ERROR) << "Start code is not found for codec!";
-    delete[] pbsData;
-    return WEBRTC_VIDEO_CODEC_ERROR;
-  }
-  scPositions[scPositionsLength] = encoded_data_size;
-  header.VerifyAndAllocateFragmentationHeader(scPositionsLength);
-  for (int i = 0; i < scPositionsLength; i++) {
-    header.fragmentationOffset[i] = scPositions[i] + scLengths[i];
-    header.fragmentationLength[i] =
-        scPositions[i + 1] - header.fragmentationOffset[i];
-    header.fragmentationPlType[i] = 0;
-    header.fragmentationTimeDiff[i] = 0;
+    texture = d3d11_converter_->Convert(texture);
+    if (texture == nullptr) {
+      return WEBRTC_VIDEO_CODEC_ERROR;
+    }
+    subresource = 0;
   }
 
-  const auto result = callback_->OnEncodedImage(encodedFrame, &info, &header);
-  if (result.error != webrtc::EncodedImageCallback::Result::Error::OK) {
-    RTC_LOG(LS_ERROR) << "Deliver encoded frame callback failed: "
-                      << result.error;
-    delete[] pbsData;
+  mfxHDLPair pair = {};
+  mfxStatus sts = m_pMFXAllocator->GetHDL(
+      m_pMFXAllocator->pthis, surface->Data.MemId,
+      reinterpret_cast<mfxHDL*>(&pair));
+  if (MFX_ERR_NONE != sts) {
     return WEBRTC_VIDEO_CODEC_ERROR;
   }
-  delete[] pbsData;
-  m_nFramesProcessed++;
+  ID3D11Texture2D* dst = reinterpret_cast<ID3D11Texture2D*>(pair.first);
+  UINT dst_subresource = (UINT)(UINT_PTR)pair.second;
+  d3d11_device_context_->CopySubresourceRegion(dst, dst_subresource, 0, 0, 0,
+                                               texture, subresource, nullptr);
   return WEBRTC_VIDEO_CODEC_OK;
 }
 
+// Decides whether a keyframe request is forwarded to the encoder. During
+// loss bursts several requests arrive back to back; requests landing inside
+// the configured window are collapsed into the one already forwarded.
+bool MSDKVideoEncoder::AllowKeyFrameRequest() {
+  key_frame_requests_received_++;
+  int window_ms = GlobalConfiguration::GetKeyFrameRequestCoalescingWindowMs();
+  int64_t now_ms = rtc::TimeMillis();
+  if (window_ms > 0 && key_frame_requests_forwarded_ > 0 &&
+      now_ms - last_key_frame_forwarded_ms_ < window_ms) {
+    RTC_LOG(LS_INFO) << "Coalesced keyframe request; forwarded "
+                     << key_frame_requests_forwarded_ << " of "
+                     << key_frame_requests_received_ << " requests.";
+    return false;
+  }
+  last_key_frame_forwarded_ms_ = now_ms;
+  key_frame_requests_forwarded_++;
+  return true;
+}
+
 int MSDKVideoEncoder::RegisterEncodeCompleteCallback(
     webrtc::EncodedImageCallback* callback) {
   callback_ = callback;
@@ -793,50 +999,109 @@ int MSDKVideoEncoder::SetChannelParameters(uint32_t packet_loss, int64_t rtt) {
 }
 
 int MSDKVideoEncoder::SetRates(uint32_t new_bitrate_kbit, uint32_t frame_rate) {
+  if (!inited_) {
+    return WEBRTC_VIDEO_CODEC_UNINITIALIZED;
+  }
+  // The rate controller calls in every estimate update; only deviations
+  // above 5% (or a framerate change) are worth a driver round trip, the
+  // rest ride on the current parameters.
+  uint32_t current_kbps = static_cast<uint32_t>(bitrate_ / 1000);
+  bool bitrate_changed = new_bitrate_kbit * 20 < current_kbps * 19 ||
+                         new_bitrate_kbit * 20 > current_kbps * 21;
+  bool framerate_changed =
+      frame_rate > 0 && static_cast<int32_t>(frame_rate) != framerate_;
+  if (!bitrate_changed && !framerate_changed) {
+    return WEBRTC_VIDEO_CODEC_OK;
+  }
+  bitrate_ = new_bitrate_kbit * 1000;
+  if (frame_rate > 0) {
+    framerate_ = frame_rate;
+  }
+  // Publish the snapshot for the encode path to fold in at the next
+  // frame boundary. The old blocking Invoke parked the bandwidth
+  // estimator behind the encoder thread right when congestion made that
+  // thread busiest; a single release store never does.
+  pending_rates_.store((1ull << 63) |
+                           (static_cast<uint64_t>(new_bitrate_kbit) << 32) |
+                           frame_rate,
+                       std::memory_order_release);
+  return WEBRTC_VIDEO_CODEC_OK;
+}
+
+int MSDKVideoEncoder::ApplyRates(uint32_t bitrate_kbps, uint32_t frame_rate) {
+  if (m_pmfxENC == nullptr) {
+    return WEBRTC_VIDEO_CODEC_ERROR;
+  }
+  // Rate-only resets keep the reference frames, so the stream continues
+  // without an IDR; the pipeline is drained first because MSDK requires
+  // no cached operations across a Reset.
+  DrainPendingOps(true);
+  m_mfxEncParams.mfx.TargetKbps = static_cast<mfxU16>(bitrate_kbps);
+  if (m_mfxEncParams.mfx.MaxKbps < m_mfxEncParams.mfx.TargetKbps) {
+    m_mfxEncParams.mfx.MaxKbps = m_mfxEncParams.mfx.TargetKbps;
+  }
+  if (frame_rate > 0) {
+    MSDKConvertFrameRate(frame_rate,
+                         &m_mfxEncParams.mfx.FrameInfo.FrameRateExtN,
+                         &m_mfxEncParams.mfx.FrameInfo.FrameRateExtD);
+  }
+  mfxStatus sts = m_pmfxENC->Reset(&m_mfxEncParams);
+  if (MFX_WRN_INCOMPATIBLE_VIDEO_PARAM == sts) {
+    sts = MFX_ERR_NONE;
+  }
+  if (MFX_ERR_NONE != sts) {
+    RTC_LOG(LS_WARNING) << "Encoder rate reset rejected with status " << sts;
+    return WEBRTC_VIDEO_CODEC_ERROR;
+  }
+  return WEBRTC_VIDEO_CODEC_OK;
+}
+
+int MSDKVideoEncoder::ApplyScreenContentType(ScreenContentType content_type) {
+  // Stamped even when nothing changes or the reset fails, so a rejecting
+  // driver is not asked again every frame.
+  last_content_switch_ms_ = rtc::TimeMillis();
+  applied_content_type_ = content_type;
+  if (GlobalConfiguration::GetHardwareEncoderPreset() ==
+      HardwareEncoderPreset::kUltraLowLatency) {
+    // The speed preset pins the target usage; only track the type.
+    return WEBRTC_VIDEO_CODEC_OK;
+  }
+  if (!inited_ || m_pmfxENC == nullptr) {
+    return WEBRTC_VIDEO_CODEC_UNINITIALIZED;
+  }
+  mfxU16 target_usage = (content_type == ScreenContentType::kMotion)
+                            ? MFX_TARGETUSAGE_BALANCED
+                            : MFX_TARGETUSAGE_BEST_QUALITY;
+  if (m_mfxEncParams.mfx.TargetUsage == target_usage) {
+    return WEBRTC_VIDEO_CODEC_OK;
+  }
+  DrainPendingOps(true);
+  mfxU16 previous_usage = m_mfxEncParams.mfx.TargetUsage;
+  m_mfxEncParams.mfx.TargetUsage = target_usage;
+  mfxStatus sts = m_pmfxENC->Reset(&m_mfxEncParams);
+  if (MFX_WRN_INCOMPATIBLE_VIDEO_PARAM == sts) {
+    sts = MFX_ERR_NONE;
+  }
+  if (MFX_ERR_NONE != sts) {
+    m_mfxEncParams.mfx.TargetUsage = previous_usage;
+    RTC_LOG(LS_WARNING) << "Content-type encoder reset rejected with status "
+                        << sts;
+    return WEBRTC_VIDEO_CODEC_ERROR;
+  }
+  RTC_LOG(LS_INFO) << "Encoder retuned for "
+                   << (content_type == ScreenContentType::kMotion ? "motion"
+                                                                  : "static")
+                   << " screen content.";
   return WEBRTC_VIDEO_CODEC_OK;
 }
 
 int MSDKVideoEncoder::Release() {
+  DiscardPendingOps();
   callback_ = nullptr;
   // Need to reset to that the session is invalidated and won't use the
   // callback anymore.
   return WEBRTC_VIDEO_CODEC_OK;
 }
 
-int32_t MSDKVideoEncoder::NextNaluPosition(uint8_t* buffer,
-                                           size_t buffer_size,
-                                           uint8_t* sc_length) {
-  if (buffer_size < NAL_SC_LENGTH) {
-    return -1;
-  }
-  *sc_length = 0;
-  uint8_t* head = buffer;
-  // Set end buffer pointer to 4 bytes before actual buffer end so we can
-  // access head[1], head[2] and head[3] in a loop without buffer overrun.
-  uint8_t* end = buffer + buffer_size - NAL_SC_LENGTH;
-
-  while (head < end) {
-    if (head[0]) {
-      head++;
-      continue;
-    }
-    if (head[1]) {  // got 00xx
-      head += 2;
-      continue;
-    }
-    if (head[2] > 1) {  // got 0000xx
-      head += 3;
-      continue;
-    }
-    if (head[2] != 1 && head[3] != 0x01) {  // got 000000xx
-      head++;                               // xx != 1, continue searching.
-      continue;
-    }
-
-    *sc_length = (head[2] == 1) ? 3 : 4;
-    return (int32_t)(head - buffer);
-  }
-  return -1;
-}
 }  // namespace base
 }  // namespace owt
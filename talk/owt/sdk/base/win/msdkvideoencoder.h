@@ -5,17 +5,27 @@
 #ifndef OWT_BASE_WIN_MSDKVIDEOENCODER_H_
 #define OWT_BASE_WIN_MSDKVIDEOENCODER_H_
 
+#include <d3d11.h>
 #include "base_allocator.h"
+#include "msdksurfacepool.h"
 #include "mfxvideo.h"
 #include "mfxvideo++.h"
 #include "mfxplugin++.h"
 #include "sysmem_allocator.h"
+#include <atomic>
+#include <deque>
 #include <vector>
+#include "talk/owt/sdk/base/screencontentmonitor.h"
+#include "talk/owt/sdk/base/threadwatchdog.h"
+#include "talk/owt/sdk/include/cpp/owt/base/commontypes.h"
+#include "webrtc/modules/include/module_common_types.h"
 #include "webrtc/modules/video_coding/codecs/h264/include/h264.h"
 #include "webrtc/rtc_base/thread.h"
 
 namespace owt {
 namespace base {
+struct D3D11ImageHandle;
+class D3D11VideoConverter;
 enum MemType {
   MSDK_SYSTEM_MEMORY = 0x00,
   MSDK_D3D9_MEMORY = 0x01,
@@ -40,19 +50,73 @@ class MSDKVideoEncoder : public webrtc::VideoEncoder {
         const std::vector<webrtc::FrameType>* frame_types) override;
   int RegisterEncodeCompleteCallback(webrtc::EncodedImageCallback* callback) override;
   int SetChannelParameters(uint32_t packet_loss, int64_t rtt) override;
+  // Applies rate-controller updates with an in-place MSDK Reset; the
+  // stream keeps its reference frames, so no IDR is forced and no frame
+  // is dropped. Small deviations are absorbed without touching the
+  // encoder.
   int SetRates(uint32_t new_bitrate_kbit, uint32_t frame_rate) override;
-  bool SupportsNativeHandle() const override { return false; }
+  bool SupportsNativeHandle() const override { return true; }
   int Release() override;
+  // Speculatively warms the hardware encode path for |codec| on a
+  // background thread by parking a session with the codec's encoder
+  // plugin loaded. Called when a publication starts, so the expensive
+  // session setup in InitEncodeOnEncoderThread overlaps the signaling
+  // round trip instead of running on the first frame. A no-op when
+  // hardware acceleration is disabled or the codec has no hardware
+  // encode path.
+  static void PrewarmEncodeResources(owt::base::VideoCodec codec);
  private:
   int InitEncodeOnEncoderThread(const webrtc::VideoCodec* codec_settings,
         int number_of_cores,
         size_t max_payload_size);
+  // In-place reconfiguration for a codec-compatible settings change:
+  // drains the in-flight operations, issues an MSDK Reset with the new
+  // resolution, frame rate and bitrate, and keeps the allocated surface
+  // array when the new dimensions crop into it. Returns an error when
+  // the change cannot be applied in place (dimensions grew past the
+  // allocation, or the driver rejects the reset), in which case
+  // InitEncode falls back to the full teardown path.
+  int ResetOnEncoderThread(const webrtc::VideoCodec* codec_settings);
+  // Rate-only reset for a snapshot published by SetRates; runs on the
+  // webrtc encode thread between frames, where the drain and the driver
+  // Reset cannot contend with an encode in flight.
+  int ApplyRates(uint32_t bitrate_kbps, uint32_t frame_rate);
+  // Retunes the encoder for the screen content type the capture path
+  // classified (ScreenContentMonitor): per-frame quality for static
+  // documents, throughput for embedded video playback. Applied with an
+  // in-place MSDK Reset between frames, so the stream keeps its
+  // references and no IDR is forced.
+  int ApplyScreenContentType(ScreenContentType content_type);
   void CheckOnEncoderThread();
-  int EncodeOnEncoderThread(const webrtc::VideoFrame& frame, const webrtc::CodecSpecificInfo* codec_specific_info,
+  // Submits |frame| to the asynchronous encode pipeline and delivers the
+  // operations that have completed; blocks only when the pipeline is full.
+  int EncodePipelined(const webrtc::VideoFrame& frame, const webrtc::CodecSpecificInfo* codec_specific_info,
         const std::vector<webrtc::FrameType>* frame_types);
-  int32_t NextNaluPosition(uint8_t *buffer, size_t buffer_size, uint8_t *sc_length);
-  mfxU16 MSDKGetFreeSurface(mfxFrameSurface1* pSurfacesPool, mfxU16 nPoolSize);
-  mfxU16 MSDKGetFreeSurfaceIndex(mfxFrameSurface1* pSurfacesPool, mfxU16 nPoolSize);
+  // Returns false when a keyframe request lands in the coalescing window
+  // and should not reach the encoder. Also maintains the IDR counters.
+  bool AllowKeyFrameRequest();
+  // One submitted encode operation whose sync point has not been waited on.
+  struct PendingEncodeOp {
+    mfxBitstream bs;
+    mfxSyncPoint sync;
+    mfxU8* bs_data;
+    bool is_keyframe;
+    int width;
+    int height;
+    int64_t render_time_ms;
+    uint32_t timestamp;
+  };
+  int DeliverEncodedOp(PendingEncodeOp& op);
+  int DrainPendingOps(bool blocking);
+  void DiscardPendingOps();
+  // Tears down the system-memory pipeline and rebuilds it around video
+  // memory surfaces on |device|. Called when the first frame carrying a
+  // D3D11 texture arrives.
+  int SwitchToD3D11Input(ID3D11Device* device);
+  // Copies |handle|'s texture into |surface| entirely on the GPU; non-NV12
+  // input is first converted by the video processor.
+  int LoadD3D11Texture(const D3D11ImageHandle& handle,
+                       mfxFrameSurface1* surface);
   void WipeMfxBitstream(mfxBitstream* pBitstream);
   
   webrtc::EncodedImageCallback* callback_;
@@ -60,21 +124,51 @@ class MSDKVideoEncoder : public webrtc::VideoEncoder {
   int32_t width_;
   int32_t height_;
   int32_t framerate_;
+  // Rate snapshot published wait-free by SetRates and consumed by the
+  // encode path at the next frame boundary: bit 63 marks a pending
+  // update, bits 62..32 hold the bitrate in kbps and bits 31..0 the
+  // frame rate (zero keeps the current one). Zero means nothing pending;
+  // a newer snapshot simply overwrites an unconsumed older one.
+  std::atomic<uint64_t> pending_rates_;
   webrtc::VideoCodecType codecType_;
+  // Reused across frames on the encoder thread; its fragment arrays only
+  // grow, so the steady state encode path performs no allocation for it.
+  webrtc::RTPFragmentationHeader frag_header_;
+  int64_t last_key_frame_forwarded_ms_;
+  int64_t key_frame_requests_received_;
+  int64_t key_frame_requests_forwarded_;
+  // In-flight operations in submission order, serviced on the encode path.
+  std::deque<PendingEncodeOp> pending_ops_;
 
   MFXVideoSession* m_mfxSession;
   mfxPluginUID m_pluginID;
   MFXVideoENCODE* m_pmfxENC;
-  std::shared_ptr<SysMemFrameAllocator> m_pMFXAllocator;
+  std::shared_ptr<BaseFrameAllocator> m_pMFXAllocator;
   mfxVideoParam m_mfxEncParams;
   mfxExtHEVCParam m_ExtHEVCParam;
   std::vector<mfxExtBuffer*> m_EncExtParams;
   mfxFrameAllocResponse m_EncResponse;
   mfxFrameSurface1* m_pEncSurfaces; // frames array for encoder
+  // Event-driven acquisition over m_pEncSurfaces; completed operations
+  // signal it so no sleep quantum is spent waiting for a free surface.
+  MSDKSurfacePool surface_pool_;
   mfxBitstream            m_mfxBS; // contains encoded data
   mfxU32 m_nFramesProcessed;
   std::unique_ptr<MSDKEncoderThread> encoder_thread_;
   MemType m_memType_;
+  // Device that produced the incoming D3D11 textures; referenced so the
+  // session and allocator outlive the frame source.
+  ID3D11Device* d3d11_input_device_;
+  ID3D11DeviceContext* d3d11_device_context_;
+  std::unique_ptr<D3D11VideoConverter> d3d11_converter_;
+  // Kept so the pipeline can be rebuilt when the input memory type changes.
+  webrtc::VideoCodec codec_settings_;
+  // Stall detection over the encode path; see ThreadWatchdog.
+  ThreadWatchdog::Handle* watchdog_handle_;
+  // Screen content type the encoder is currently tuned for; only
+  // meaningful in screen-sharing mode.
+  ScreenContentType applied_content_type_;
+  int64_t last_content_switch_ms_;
   bool inited_;
 #ifdef OWT_DEBUG_MSDK_ENC
   FILE *output;
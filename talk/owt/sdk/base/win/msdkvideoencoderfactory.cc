@@ -2,23 +2,41 @@
 //
 // SPDX-License-Identifier: Apache-2.0
 
+#include "talk/owt/sdk/base/win/msdkvideobase.h"
 #include "talk/owt/sdk/base/win/msdkvideoencoder.h"
 #include "talk/owt/sdk/base/win/msdkvideoencoderfactory.h"
+#include "talk/owt/sdk/base/win/softwarefallbackencoder.h"
 #include "webrtc/common_video/h264/profile_level_id.h"
+#include "webrtc/rtc_base/logging.h"
 
 namespace owt {
 namespace base {
 
-MSDKVideoEncoderFactory::MSDKVideoEncoderFactory(){
+MSDKVideoEncoderFactory::MSDKVideoEncoderFactory(){}
+
+// Deferred from the constructor: the factory is built during
+// PeerConnectionFactory creation on every client, including receive-only
+// viewers that may never negotiate video. The driver probe (dispatcher
+// load plus session init) only runs once a codec list is actually needed,
+// which keeps viewer cold start off the Media SDK path entirely.
+void MSDKVideoEncoderFactory::EnsureCodecsEnumerated() const {
+  std::call_once(enumerate_once_, [this] {
     supported_codecs_.clear();
   // We will not turn on VP8 encoding HW support at present.
   bool is_vp8_hw_supported = false;
+  // H.264 profiles are advertised either way - the software fallback
+  // covers platforms whose driver cannot encode AVC - but remember the
+  // probe result so CreateVideoEncoder hands out the right encoder.
+  h264_hw_supported_ = MSDKFactory::Get() &&
+                       MSDKFactory::Get()->QueryEncoderSupport(MFX_CODEC_AVC);
 
 #ifndef DISABLE_H265
-  // TODO(jianlin): Find a way from MSDK to check h265 HW encoding support.
-  // As we have SW, GAA & HW h265 encoding support, try loading plugins might be
-  // a good way to determine that.
-  bool is_h265_hw_supported = true;
+  // Probe the driver instead of assuming support: the HEVC plugin only
+  // loads on platforms that can actually encode it, so the codec is not
+  // offered in SDP on GPUs that would fail at InitEncode time.
+  bool is_h265_hw_supported =
+      MSDKFactory::Get() &&
+      MSDKFactory::Get()->QueryEncoderSupport(MFX_CODEC_HEVC);
 #endif
 
   if (is_vp8_hw_supported) {
@@ -77,18 +95,31 @@ MSDKVideoEncoderFactory::MSDKVideoEncoderFactory(){
     supported_codecs_.push_back(main10_high);
   }
 #endif
+  });
 }
 
 MSDKVideoEncoderFactory::~MSDKVideoEncoderFactory(){}
 
 webrtc::VideoEncoder* MSDKVideoEncoderFactory::CreateVideoEncoder(
     const cricket::VideoCodec& codec) {
+  EnsureCodecsEnumerated();
   if (supported_codecs_.empty()) {
     return nullptr;
   }
 
   if (FindMatchingCodec(supported_codecs_, codec) &&
       (!_stricmp(codec.name.c_str(), "H264") ||!_stricmp(codec.name.c_str(), "H265")) ) {
+    if (!_stricmp(codec.name.c_str(), "H264") && !h264_hw_supported_) {
+      // Hand out the tuned software encoder here instead of letting an
+      // MSDKVideoEncoder fail InitEncode first, so the configured
+      // fallback thread count and effort preset actually apply.
+      webrtc::VideoEncoder* fallback = SoftwareFallbackEncoder::Create(codec);
+      if (fallback != nullptr) {
+        RTC_LOG(LS_INFO)
+            << "Hardware H.264 encode unavailable; using software fallback.";
+        return fallback;
+      }
+    }
     return new MSDKVideoEncoder();
   }
 
@@ -97,6 +128,7 @@ webrtc::VideoEncoder* MSDKVideoEncoderFactory::CreateVideoEncoder(
 
 const std::vector<cricket::VideoCodec>&
 MSDKVideoEncoderFactory::supported_codecs() const {
+  EnsureCodecsEnumerated();
   return supported_codecs_;
 }
 
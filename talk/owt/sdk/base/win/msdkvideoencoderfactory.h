@@ -7,6 +7,7 @@
 
 #include "webrtc/media/base/codec.h"
 #include "webrtc/media/engine/webrtcvideoencoderfactory.h"
+#include <mutex>
 #include <vector>
 
 namespace owt {
@@ -23,7 +24,15 @@ public:
  void DestroyVideoEncoder(webrtc::VideoEncoder* encoder) override;
 
 private:
- std::vector<cricket::VideoCodec> supported_codecs_;
+ // Probing the driver is expensive on cold start, so the codec list is
+ // built on first use instead of at factory construction.
+ void EnsureCodecsEnumerated() const;
+ mutable std::once_flag enumerate_once_;
+ mutable std::vector<cricket::VideoCodec> supported_codecs_;
+ // Whether the driver probe found hardware AVC encode; filled during
+ // enumeration. H.264 is advertised regardless and served by the
+ // software fallback when this is false.
+ mutable bool h264_hw_supported_ = true;
 };
 }
 }  // namespace owt
@@ -0,0 +1,121 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "talk/owt/sdk/base/win/softwarefallbackencoder.h"
+#include "talk/owt/sdk/include/cpp/owt/base/globalconfiguration.h"
+#include "webrtc/modules/video_coding/codecs/h264/include/h264.h"
+#include "webrtc/modules/video_coding/codecs/vp8/include/vp8.h"
+#include "webrtc/modules/video_coding/codecs/vp9/include/vp9.h"
+#include "webrtc/rtc_base/logging.h"
+
+namespace owt {
+namespace base {
+
+webrtc::VideoEncoder* SoftwareFallbackEncoder::Create(
+    const cricket::VideoCodec& codec) {
+  std::unique_ptr<webrtc::VideoEncoder> encoder;
+  if (!_stricmp(codec.name.c_str(), "H264")) {
+    if (webrtc::H264Encoder::IsSupported()) {
+      encoder = webrtc::H264Encoder::Create(codec);
+    }
+  } else if (!_stricmp(codec.name.c_str(), "VP8")) {
+    encoder = webrtc::VP8Encoder::Create();
+  } else if (!_stricmp(codec.name.c_str(), "VP9")) {
+    encoder = webrtc::VP9Encoder::Create();
+  }
+  if (encoder == nullptr) {
+    RTC_LOG(LS_WARNING) << "No software fallback encoder for "
+                        << codec.name;
+    return nullptr;
+  }
+  return new SoftwareFallbackEncoder(std::move(encoder));
+}
+
+SoftwareFallbackEncoder::SoftwareFallbackEncoder(
+    std::unique_ptr<webrtc::VideoEncoder> encoder)
+    : encoder_(std::move(encoder)) {}
+
+SoftwareFallbackEncoder::~SoftwareFallbackEncoder() {}
+
+int32_t SoftwareFallbackEncoder::InitEncode(
+    const webrtc::VideoCodec* codec_settings,
+    int32_t number_of_cores,
+    size_t max_payload_size) {
+  webrtc::VideoCodec settings = *codec_settings;
+  // Software encoders size their thread pool - and the slice or tile
+  // split of each frame - from the core count they are handed; the
+  // configured count replaces the machine-wide count the engine reports.
+  int32_t cores = number_of_cores;
+  int configured = GlobalConfiguration::GetSoftwareFallbackThreadCount();
+  if (configured > 0) {
+    cores = configured;
+  }
+  // The effort preset maps onto the knobs the codec's settings expose;
+  // codecs without a complexity setting take only the thread count.
+  SoftwareEncoderPreset preset =
+      GlobalConfiguration::GetSoftwareFallbackPreset();
+  if (settings.codecType == webrtc::kVideoCodecVP8) {
+    if (preset == SoftwareEncoderPreset::kSpeed) {
+      settings.VP8()->complexity = webrtc::kComplexityNormal;
+      // The source denoiser is the costliest optional stage.
+      settings.VP8()->denoisingOn = false;
+    } else if (preset == SoftwareEncoderPreset::kQuality) {
+      settings.VP8()->complexity = webrtc::kComplexityHigher;
+    }
+  } else if (settings.codecType == webrtc::kVideoCodecVP9) {
+    if (preset == SoftwareEncoderPreset::kSpeed) {
+      settings.VP9()->complexity = webrtc::kComplexityNormal;
+      settings.VP9()->denoisingOn = false;
+    } else if (preset == SoftwareEncoderPreset::kQuality) {
+      settings.VP9()->complexity = webrtc::kComplexityHigher;
+    }
+  }
+  RTC_LOG(LS_INFO) << "Software fallback encode with " << cores
+                   << " cores for " << settings.width << "x"
+                   << settings.height;
+  return encoder_->InitEncode(&settings, cores, max_payload_size);
+}
+
+int32_t SoftwareFallbackEncoder::Encode(
+    const webrtc::VideoFrame& input_image,
+    const webrtc::CodecSpecificInfo* codec_specific_info,
+    const std::vector<webrtc::FrameType>* frame_types) {
+  return encoder_->Encode(input_image, codec_specific_info, frame_types);
+}
+
+int32_t SoftwareFallbackEncoder::RegisterEncodeCompleteCallback(
+    webrtc::EncodedImageCallback* callback) {
+  return encoder_->RegisterEncodeCompleteCallback(callback);
+}
+
+int32_t SoftwareFallbackEncoder::SetChannelParameters(uint32_t packet_loss,
+                                                      int64_t rtt) {
+  return encoder_->SetChannelParameters(packet_loss, rtt);
+}
+
+int32_t SoftwareFallbackEncoder::SetRateAllocation(
+    const webrtc::VideoBitrateAllocation& allocation,
+    uint32_t framerate) {
+  return encoder_->SetRateAllocation(allocation, framerate);
+}
+
+int32_t SoftwareFallbackEncoder::Release() {
+  return encoder_->Release();
+}
+
+webrtc::VideoEncoder::ScalingSettings
+SoftwareFallbackEncoder::GetScalingSettings() const {
+  return encoder_->GetScalingSettings();
+}
+
+bool SoftwareFallbackEncoder::SupportsNativeHandle() const {
+  return encoder_->SupportsNativeHandle();
+}
+
+const char* SoftwareFallbackEncoder::ImplementationName() const {
+  return encoder_->ImplementationName();
+}
+
+}  // namespace base
+}  // namespace owt
@@ -0,0 +1,55 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef OWT_BASE_WIN_SOFTWAREFALLBACKENCODER_H_
+#define OWT_BASE_WIN_SOFTWAREFALLBACKENCODER_H_
+
+#include <memory>
+#include <vector>
+#include "webrtc/media/base/codec.h"
+#include "webrtc/api/video_codecs/video_encoder.h"
+
+namespace owt {
+namespace base {
+
+/// Software encoder used when the platform cannot hardware-encode a
+/// codec the factory advertised. Wraps the engine's software encoder and
+/// applies the GlobalConfiguration fallback tuning at InitEncode: the
+/// configured thread count replaces the core count the engine reports,
+/// which sizes both the encoder's thread pool and its slice split, and
+/// the effort preset maps onto the codec's complexity and denoising
+/// settings where the codec exposes them.
+class SoftwareFallbackEncoder : public webrtc::VideoEncoder {
+ public:
+  /// Creates a tuned software encoder for |codec|, or nullptr when the
+  /// engine has no software implementation of it.
+  static webrtc::VideoEncoder* Create(const cricket::VideoCodec& codec);
+  ~SoftwareFallbackEncoder() override;
+
+  int32_t InitEncode(const webrtc::VideoCodec* codec_settings,
+                     int32_t number_of_cores,
+                     size_t max_payload_size) override;
+  int32_t Encode(const webrtc::VideoFrame& input_image,
+                 const webrtc::CodecSpecificInfo* codec_specific_info,
+                 const std::vector<webrtc::FrameType>* frame_types) override;
+  int32_t RegisterEncodeCompleteCallback(
+      webrtc::EncodedImageCallback* callback) override;
+  int32_t SetChannelParameters(uint32_t packet_loss, int64_t rtt) override;
+  int32_t SetRateAllocation(const webrtc::VideoBitrateAllocation& allocation,
+                            uint32_t framerate) override;
+  int32_t Release() override;
+  ScalingSettings GetScalingSettings() const override;
+  bool SupportsNativeHandle() const override;
+  const char* ImplementationName() const override;
+
+ private:
+  explicit SoftwareFallbackEncoder(
+      std::unique_ptr<webrtc::VideoEncoder> encoder);
+  std::unique_ptr<webrtc::VideoEncoder> encoder_;
+};
+
+}  // namespace base
+}  // namespace owt
+
+#endif  // OWT_BASE_WIN_SOFTWAREFALLBACKENCODER_H_
@@ -21,7 +21,10 @@ or https://software.intel.com/en-us/media-client-solutions-support.
 //
 // SPDX-License-Identifier: Apache-2.0
 
+#include <string.h>
+
 #include "sysmem_allocator.h"
+#include "talk/owt/sdk/base/memoryaccounting.h"
 
 #define ID_BUFFER MFX_MAKEFOURCC('B','U','F','F')
 #define ID_FRAME  MFX_MAKEFOURCC('F','R','M','E')
@@ -73,28 +76,10 @@ mfxStatus SysMemFrameAllocator::Close() {
   return sts;
 }
 
-mfxStatus SysMemFrameAllocator::LockFrame(mfxMemId mid, mfxFrameData *ptr) {
-  if (!m_pBufferAllocator)
-    return MFX_ERR_NOT_INITIALIZED;
-
-  if (!ptr)
-    return MFX_ERR_NULL_PTR;
-
-  // If allocator uses pointers instead of mids, no further action is required
-  if (!mid && ptr->Y)
-    return MFX_ERR_NONE;
-
-  sFrame *fs = 0;
-  mfxStatus sts = m_pBufferAllocator->Lock(m_pBufferAllocator->pthis, mid,(mfxU8 **)&fs);
-
-  if (MFX_ERR_NONE != sts)
-    return sts;
-
-  if (ID_FRAME != fs->id) {
-    m_pBufferAllocator->Unlock(m_pBufferAllocator->pthis, mid);
-    return MFX_ERR_INVALID_HANDLE;
-  }
-
+// Computes the plane pointers and pitch for |fs| into |ptr|. Runs the
+// per-FourCC switch once per surface at allocation; after that LockFrame
+// serves the cached result.
+static mfxStatus FillFrameLayout(sFrame *fs, mfxFrameData *ptr) {
   mfxU16 Width2 = (mfxU16)MSDK_ALIGN32(fs->info.Width);
   mfxU16 Height2 = (mfxU16)MSDK_ALIGN32(fs->info.Height);
   ptr->B = ptr->Y = (mfxU8 *)fs + MSDK_ALIGN32(sizeof(sFrame));
@@ -166,6 +151,67 @@ mfxStatus SysMemFrameAllocator::LockFrame(mfxMemId mid, mfxFrameData *ptr) {
   return MFX_ERR_NONE;
 }
 
+mfxStatus SysMemFrameAllocator::LockFrame(mfxMemId mid, mfxFrameData *ptr) {
+  if (!m_pBufferAllocator)
+    return MFX_ERR_NOT_INITIALIZED;
+
+  if (!ptr)
+    return MFX_ERR_NULL_PTR;
+
+  // If allocator uses pointers instead of mids, no further action is required
+  if (!mid && ptr->Y)
+    return MFX_ERR_NONE;
+
+  sFrame *fs = 0;
+  mfxStatus sts = m_pBufferAllocator->Lock(m_pBufferAllocator->pthis, mid,(mfxU8 **)&fs);
+
+  if (MFX_ERR_NONE != sts)
+    return sts;
+
+  if (ID_FRAME != fs->id) {
+    m_pBufferAllocator->Unlock(m_pBufferAllocator->pthis, mid);
+    return MFX_ERR_INVALID_HANDLE;
+  }
+
+  // The layout cached at allocation is valid as long as the frame still
+  // sits at the address it was computed against; our own buffer
+  // allocator never moves a buffer, so this is the steady-state path.
+  // Only the pointer fields are copied back; the rest of |ptr|
+  // (timestamps, frame order, lock counters) belongs to the caller.
+  if (fs->mapped_base == (mfxU8 *)fs) {
+    ptr->B = fs->layout.B;
+    ptr->R = fs->layout.R;
+    ptr->G = fs->layout.G;
+    ptr->Y = fs->layout.Y;
+    ptr->U = fs->layout.U;
+    ptr->V = fs->layout.V;
+    ptr->A = fs->layout.A;
+    ptr->Y16 = fs->layout.Y16;
+    ptr->Pitch = fs->layout.Pitch;
+    return MFX_ERR_NONE;
+  }
+
+  mfxFrameData layout = {};
+  sts = FillFrameLayout(fs, &layout);
+  if (MFX_ERR_NONE != sts) {
+    m_pBufferAllocator->Unlock(m_pBufferAllocator->pthis, mid);
+    return sts;
+  }
+  fs->layout = layout;
+  fs->mapped_base = (mfxU8 *)fs;
+  ptr->B = layout.B;
+  ptr->R = layout.R;
+  ptr->G = layout.G;
+  ptr->Y = layout.Y;
+  ptr->U = layout.U;
+  ptr->V = layout.V;
+  ptr->A = layout.A;
+  ptr->Y16 = layout.Y16;
+  ptr->Pitch = layout.Pitch;
+
+  return MFX_ERR_NONE;
+}
+
 mfxStatus SysMemFrameAllocator::UnlockFrame(mfxMemId mid, mfxFrameData *ptr) {
   if (!m_pBufferAllocator)
     return MFX_ERR_NOT_INITIALIZED;
@@ -272,6 +318,18 @@ mfxStatus SysMemFrameAllocator::AllocImpl(mfxFrameAllocRequest *request, mfxFram
 
     fs->id = ID_FRAME;
     fs->info = request->Info;
+    // Resolve the plane layout once here so every subsequent LockFrame
+    // is a handful of pointer copies, and touch each page of the
+    // payload so the first frames through the pool do not pay the
+    // soft faults of freshly committed zero pages mid-encode.
+    fs->mapped_base = 0;
+    memset(&fs->layout, 0, sizeof(fs->layout));
+    if (MFX_ERR_NONE == FillFrameLayout(fs, &fs->layout)) {
+      fs->mapped_base = (mfxU8 *)fs;
+      volatile mfxU8 *payload = (mfxU8 *)fs + MSDK_ALIGN32(sizeof(sFrame));
+      for (mfxU32 offset = 0; offset < nbytes; offset += 4096)
+        payload[offset] = 0;
+    }
     m_pBufferAllocator->Unlock(m_pBufferAllocator->pthis, mids.get()[numAllocated]);
   }
 
@@ -337,6 +395,7 @@ mfxStatus SysMemBufferAllocator::AllocBuffer(mfxU32 nbytes, mfxU16 type, mfxMemI
   bs->type = type;
   bs->nbytes = nbytes;
   *mid = (mfxHDL) bs;
+  MemoryAccounting::Add("msdk.sysmem_buffers", header_size + nbytes + 32);
   return MFX_ERR_NONE;
 }
 
@@ -369,6 +428,8 @@ mfxStatus SysMemBufferAllocator::FreeBuffer(mfxMemId mid) {
   if (!bs || ID_BUFFER != bs->id)
     return MFX_ERR_INVALID_HANDLE;
 
+  MemoryAccounting::Release("msdk.sysmem_buffers",
+                            MSDK_ALIGN32(sizeof(sBuffer)) + bs->nbytes + 32);
   free(bs);
   return MFX_ERR_NONE;
 }
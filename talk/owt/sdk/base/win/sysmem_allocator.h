@@ -39,6 +39,15 @@ struct sBuffer {
 struct sFrame {
   mfxU32          id;
   mfxFrameInfo    info;
+  // Plane layout computed once at allocation. The payload never moves
+  // for the lifetime of the surface, so LockFrame can hand out these
+  // pointers with a struct copy instead of redoing the per-FourCC
+  // pointer arithmetic on every frame. |mapped_base| records the
+  // address the layout was computed against; if an external buffer
+  // allocator ever returns the frame at a different address the layout
+  // is recomputed instead of trusted.
+  mfxU8          *mapped_base;
+  mfxFrameData    layout;
 };
 
 struct SysMemAllocatorParams : mfxAllocatorParams {
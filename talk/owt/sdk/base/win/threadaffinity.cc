@@ -0,0 +1,22 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "talk/owt/sdk/base/win/threadaffinity.h"
+#include <windows.h>
+#include "webrtc/rtc_base/logging.h"
+namespace owt {
+namespace base {
+void ApplyThreadAffinityMask(uint64_t mask) {
+  if (mask == 0)
+    return;
+  // The mask addresses the processor group the thread is currently
+  // scheduled in; on machines with more than 64 logical processors the
+  // application is expected to express its policy within one group.
+  if (!::SetThreadAffinityMask(::GetCurrentThread(),
+                               static_cast<DWORD_PTR>(mask))) {
+    RTC_LOG(LS_WARNING) << "Failed to apply thread affinity mask "
+                        << mask << ", error " << ::GetLastError();
+  }
+}
+}  // namespace base
+}  // namespace owt
@@ -0,0 +1,16 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_WIN_THREADAFFINITY_H_
+#define OWT_BASE_WIN_THREADAFFINITY_H_
+#include <stdint.h>
+namespace owt {
+namespace base {
+// Pins the calling thread to the logical processors in |mask|. A zero
+// mask is a no-op, so call sites can pass the configured policy value
+// unconditionally. Failures are logged and otherwise ignored; an
+// unpinned thread is correct, just slower on multi-socket machines.
+void ApplyThreadAffinityMask(uint64_t mask);
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_WIN_THREADAFFINITY_H_
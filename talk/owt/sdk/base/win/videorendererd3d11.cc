@@ -0,0 +1,475 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "talk/owt/sdk/base/nativehandlebuffer.h"
+#include "talk/owt/sdk/base/win/videorendererd3d11.h"
+#include "talk/owt/sdk/base/win/d3dnativeframe.h"
+#include "webrtc/rtc_base/logging.h"
+
+// Solve conflict in FOURCC def with libyuv
+#ifdef FOURCC
+#undef FOURCC
+#endif
+#include "third_party/libyuv/include/libyuv.h"
+
+namespace owt {
+namespace base {
+
+// Upper bound on waiting for the swapchain to accept a present. Longer
+// stalls mean the window is not being composited; the frame is shown
+// late rather than dropped.
+static const DWORD kPresentWaitMs = 100;
+
+WebrtcVideoRendererD3D11Impl::WebrtcVideoRendererD3D11Impl(HWND wnd)
+    : wnd_(wnd),
+      init_failed_(false),
+      device_(nullptr),
+      context_(nullptr),
+      swap_chain_(nullptr),
+      frame_latency_waitable_(nullptr),
+      swap_chain_width_(0),
+      swap_chain_height_(0),
+      video_device_(nullptr),
+      video_context_(nullptr),
+      processor_enum_(nullptr),
+      processor_(nullptr),
+      processor_input_width_(0),
+      processor_input_height_(0),
+      processor_output_width_(0),
+      processor_output_height_(0),
+      upload_texture_(nullptr),
+      staging_texture_(nullptr),
+      upload_width_(0),
+      upload_height_(0),
+      interop_surface_(nullptr),
+      interop_texture_(nullptr),
+      interop_width_(0),
+      interop_height_(0) {}
+
+void WebrtcVideoRendererD3D11Impl::Destroy() {
+  ReleaseInteropResources();
+  if (staging_texture_) {
+    staging_texture_->Release();
+    staging_texture_ = nullptr;
+  }
+  if (upload_texture_) {
+    upload_texture_->Release();
+    upload_texture_ = nullptr;
+  }
+  if (processor_) {
+    processor_->Release();
+    processor_ = nullptr;
+  }
+  if (processor_enum_) {
+    processor_enum_->Release();
+    processor_enum_ = nullptr;
+  }
+  if (video_context_) {
+    video_context_->Release();
+    video_context_ = nullptr;
+  }
+  if (video_device_) {
+    video_device_->Release();
+    video_device_ = nullptr;
+  }
+  if (swap_chain_) {
+    swap_chain_->Release();
+    swap_chain_ = nullptr;
+  }
+  frame_latency_waitable_ = nullptr;
+  if (context_) {
+    context_->Release();
+    context_ = nullptr;
+  }
+  if (device_) {
+    device_->Release();
+    device_ = nullptr;
+  }
+}
+
+void WebrtcVideoRendererD3D11Impl::ReleaseInteropResources() {
+  if (interop_texture_) {
+    interop_texture_->Release();
+    interop_texture_ = nullptr;
+  }
+  if (interop_surface_) {
+    interop_surface_->Release();
+    interop_surface_ = nullptr;
+  }
+  interop_width_ = 0;
+  interop_height_ = 0;
+}
+
+bool WebrtcVideoRendererD3D11Impl::InitDevice(ID3D11Device* external_device) {
+  if (external_device) {
+    // Frames already live on this device; rendering on it avoids a
+    // cross-device copy.
+    device_ = external_device;
+    device_->AddRef();
+    device_->GetImmediateContext(&context_);
+  } else {
+    static const D3D_FEATURE_LEVEL feature_levels[] = {D3D_FEATURE_LEVEL_11_1,
+                                                       D3D_FEATURE_LEVEL_11_0};
+    HRESULT hr = D3D11CreateDevice(
+        nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr,
+        D3D11_CREATE_DEVICE_BGRA_SUPPORT | D3D11_CREATE_DEVICE_VIDEO_SUPPORT,
+        feature_levels, sizeof(feature_levels) / sizeof(feature_levels[0]),
+        D3D11_SDK_VERSION, &device_, nullptr, &context_);
+    if (FAILED(hr)) {
+      RTC_LOG(LS_ERROR) << "Failed to create D3D11 rendering device: " << hr;
+      return false;
+    }
+  }
+  HRESULT hr = device_->QueryInterface(
+      __uuidof(ID3D11VideoDevice), reinterpret_cast<void**>(&video_device_));
+  if (FAILED(hr)) {
+    RTC_LOG(LS_ERROR) << "Rendering device exposes no D3D11 video interface.";
+    return false;
+  }
+  hr = context_->QueryInterface(__uuidof(ID3D11VideoContext),
+                                reinterpret_cast<void**>(&video_context_));
+  if (FAILED(hr))
+    return false;
+  return true;
+}
+
+bool WebrtcVideoRendererD3D11Impl::EnsureSwapChain() {
+  RECT rect;
+  if (!GetClientRect(wnd_, &rect))
+    return false;
+  int width = rect.right - rect.left;
+  int height = rect.bottom - rect.top;
+  if (width <= 0 || height <= 0)
+    return false;
+  if (swap_chain_ && width == swap_chain_width_ &&
+      height == swap_chain_height_)
+    return true;
+  if (swap_chain_) {
+    // Back-buffer views are released every frame, so a resize never sees
+    // outstanding references.
+    HRESULT hr = swap_chain_->ResizeBuffers(
+        0, width, height, DXGI_FORMAT_UNKNOWN,
+        DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT);
+    if (FAILED(hr)) {
+      RTC_LOG(LS_ERROR) << "Failed to resize swapchain: " << hr;
+      return false;
+    }
+    swap_chain_width_ = width;
+    swap_chain_height_ = height;
+    return true;
+  }
+  IDXGIDevice* dxgi_device = nullptr;
+  HRESULT hr = device_->QueryInterface(__uuidof(IDXGIDevice),
+                                       reinterpret_cast<void**>(&dxgi_device));
+  if (FAILED(hr))
+    return false;
+  IDXGIAdapter* adapter = nullptr;
+  hr = dxgi_device->GetAdapter(&adapter);
+  dxgi_device->Release();
+  if (FAILED(hr))
+    return false;
+  IDXGIFactory2* factory = nullptr;
+  hr = adapter->GetParent(__uuidof(IDXGIFactory2),
+                          reinterpret_cast<void**>(&factory));
+  adapter->Release();
+  if (FAILED(hr))
+    return false;
+  DXGI_SWAP_CHAIN_DESC1 desc = {};
+  desc.Width = width;
+  desc.Height = height;
+  desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+  desc.SampleDesc.Count = 1;
+  desc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+  desc.BufferCount = 3;
+  desc.Scaling = DXGI_SCALING_STRETCH;
+  desc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+  desc.Flags = DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
+  IDXGISwapChain1* swap_chain1 = nullptr;
+  hr = factory->CreateSwapChainForHwnd(device_, wnd_, &desc, nullptr, nullptr,
+                                       &swap_chain1);
+  if (FAILED(hr)) {
+    // Flip-discard needs Windows 10; fall back to flip-sequential on
+    // Windows 8.x, which still avoids the blit-model present queue.
+    desc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL;
+    hr = factory->CreateSwapChainForHwnd(device_, wnd_, &desc, nullptr,
+                                         nullptr, &swap_chain1);
+  }
+  factory->Release();
+  if (FAILED(hr)) {
+    RTC_LOG(LS_ERROR) << "Failed to create flip-model swapchain: " << hr;
+    return false;
+  }
+  hr = swap_chain1->QueryInterface(__uuidof(IDXGISwapChain2),
+                                   reinterpret_cast<void**>(&swap_chain_));
+  swap_chain1->Release();
+  if (FAILED(hr)) {
+    RTC_LOG(LS_ERROR) << "Waitable swapchain interface unavailable: " << hr;
+    return false;
+  }
+  // One frame queued at most: presents block in WaitForSingleObjectEx
+  // below instead of stacking latency in the present queue.
+  swap_chain_->SetMaximumFrameLatency(1);
+  frame_latency_waitable_ = swap_chain_->GetFrameLatencyWaitableObject();
+  swap_chain_width_ = width;
+  swap_chain_height_ = height;
+  return true;
+}
+
+bool WebrtcVideoRendererD3D11Impl::EnsureProcessor(int input_width,
+                                                   int input_height) {
+  if (processor_ && input_width == processor_input_width_ &&
+      input_height == processor_input_height_ &&
+      swap_chain_width_ == processor_output_width_ &&
+      swap_chain_height_ == processor_output_height_)
+    return true;
+  if (processor_) {
+    processor_->Release();
+    processor_ = nullptr;
+  }
+  if (processor_enum_) {
+    processor_enum_->Release();
+    processor_enum_ = nullptr;
+  }
+  D3D11_VIDEO_PROCESSOR_CONTENT_DESC desc = {};
+  desc.InputFrameFormat = D3D11_VIDEO_FRAME_FORMAT_PROGRESSIVE;
+  desc.InputWidth = input_width;
+  desc.InputHeight = input_height;
+  desc.OutputWidth = swap_chain_width_;
+  desc.OutputHeight = swap_chain_height_;
+  desc.Usage = D3D11_VIDEO_USAGE_PLAYBACK_NORMAL;
+  HRESULT hr =
+      video_device_->CreateVideoProcessorEnumerator(&desc, &processor_enum_);
+  if (FAILED(hr))
+    return false;
+  hr = video_device_->CreateVideoProcessor(processor_enum_, 0, &processor_);
+  if (FAILED(hr))
+    return false;
+  processor_input_width_ = input_width;
+  processor_input_height_ = input_height;
+  processor_output_width_ = swap_chain_width_;
+  processor_output_height_ = swap_chain_height_;
+  return true;
+}
+
+ID3D11Texture2D* WebrtcVideoRendererD3D11Impl::UploadSoftwareFrame(
+    const webrtc::VideoFrame& frame) {
+  int width = frame.width();
+  int height = frame.height();
+  if (!upload_texture_ || width != upload_width_ || height != upload_height_) {
+    if (upload_texture_) {
+      upload_texture_->Release();
+      upload_texture_ = nullptr;
+    }
+    if (staging_texture_) {
+      staging_texture_->Release();
+      staging_texture_ = nullptr;
+    }
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = width;
+    desc.Height = height;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = DXGI_FORMAT_NV12;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    if (FAILED(device_->CreateTexture2D(&desc, nullptr, &upload_texture_))) {
+      RTC_LOG(LS_ERROR) << "Failed to allocate NV12 upload texture.";
+      return nullptr;
+    }
+    desc.Usage = D3D11_USAGE_STAGING;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    if (FAILED(device_->CreateTexture2D(&desc, nullptr, &staging_texture_))) {
+      upload_texture_->Release();
+      upload_texture_ = nullptr;
+      return nullptr;
+    }
+    upload_width_ = width;
+    upload_height_ = height;
+  }
+  D3D11_MAPPED_SUBRESOURCE mapped;
+  if (FAILED(context_->Map(staging_texture_, 0, D3D11_MAP_WRITE, 0, &mapped)))
+    return nullptr;
+  const webrtc::I420BufferInterface* i420 =
+      frame.video_frame_buffer()->GetI420();
+  uint8_t* dst_y = static_cast<uint8_t*>(mapped.pData);
+  uint8_t* dst_uv = dst_y + mapped.RowPitch * height;
+  libyuv::I420ToNV12(i420->DataY(), i420->StrideY(), i420->DataU(),
+                     i420->StrideU(), i420->DataV(), i420->StrideV(), dst_y,
+                     mapped.RowPitch, dst_uv, mapped.RowPitch, width, height);
+  context_->Unmap(staging_texture_, 0);
+  context_->CopyResource(upload_texture_, staging_texture_);
+  return upload_texture_;
+}
+
+ID3D11Texture2D* WebrtcVideoRendererD3D11Impl::CopyD3D9Surface(
+    NativeD3DSurfaceHandle* handle) {
+  IDirect3DDeviceManager9* dev_manager = handle->dev_manager_;
+  HANDLE device_handle = nullptr;
+  HRESULT hr = dev_manager->OpenDeviceHandle(&device_handle);
+  if (FAILED(hr)) {
+    RTC_LOG(LS_ERROR) << "Failed to open the d3d device handle";
+    return nullptr;
+  }
+  IDirect3DDevice9* device9 = nullptr;
+  hr = dev_manager->LockDevice(device_handle, &device9, FALSE);
+  if (FAILED(hr)) {
+    RTC_LOG(LS_ERROR) << "Failed to lock device";
+    dev_manager->CloseDeviceHandle(device_handle);
+    return nullptr;
+  }
+  if (!interop_surface_ || handle->width_ != interop_width_ ||
+      handle->height_ != interop_height_) {
+    ReleaseInteropResources();
+    // A D3D9Ex render target created with a share handle is the same
+    // video memory as a D3D11 texture opened from that handle, so the
+    // StretchRect below is the only copy on the path to the screen.
+    HANDLE shared_handle = nullptr;
+    hr = device9->CreateRenderTarget(
+        handle->width_, handle->height_, D3DFMT_X8R8G8B8, D3DMULTISAMPLE_NONE,
+        0, FALSE, &interop_surface_, &shared_handle);
+    if (SUCCEEDED(hr)) {
+      hr = device_->OpenSharedResource(
+          shared_handle, __uuidof(ID3D11Texture2D),
+          reinterpret_cast<void**>(&interop_texture_));
+    }
+    if (FAILED(hr)) {
+      RTC_LOG(LS_ERROR) << "Failed to create shared interop target: " << hr;
+      ReleaseInteropResources();
+      dev_manager->UnlockDevice(device_handle, FALSE);
+      dev_manager->CloseDeviceHandle(device_handle);
+      return nullptr;
+    }
+    interop_width_ = handle->width_;
+    interop_height_ = handle->height_;
+  }
+  // Converts NV12 to RGB while staying on the decoder's device.
+  hr = device9->StretchRect(handle->surface_, nullptr, interop_surface_,
+                            nullptr, D3DTEXF_NONE);
+  dev_manager->UnlockDevice(device_handle, FALSE);
+  dev_manager->CloseDeviceHandle(device_handle);
+  if (FAILED(hr)) {
+    RTC_LOG(LS_ERROR) << "Failed to stretch the rectangle";
+    // The device may have been reset; surfaces from before the reset are
+    // unusable, so rebuild them on the next frame.
+    ReleaseInteropResources();
+    return nullptr;
+  }
+  return interop_texture_;
+}
+
+void WebrtcVideoRendererD3D11Impl::RenderTexture(ID3D11Texture2D* texture,
+                                                 int array_index) {
+  D3D11_TEXTURE2D_DESC texture_desc;
+  texture->GetDesc(&texture_desc);
+  if (!EnsureSwapChain() ||
+      !EnsureProcessor(texture_desc.Width, texture_desc.Height))
+    return;
+  if (frame_latency_waitable_)
+    WaitForSingleObjectEx(frame_latency_waitable_, kPresentWaitMs, FALSE);
+  ID3D11Texture2D* back_buffer = nullptr;
+  HRESULT hr = swap_chain_->GetBuffer(0, __uuidof(ID3D11Texture2D),
+                                      reinterpret_cast<void**>(&back_buffer));
+  if (FAILED(hr)) {
+    RTC_LOG(LS_ERROR) << "Failed to get back buffer";
+    return;
+  }
+  D3D11_VIDEO_PROCESSOR_INPUT_VIEW_DESC input_view_desc = {};
+  input_view_desc.FourCC = 0;
+  input_view_desc.ViewDimension = D3D11_VPIV_DIMENSION_TEXTURE2D;
+  input_view_desc.Texture2D.MipSlice = 0;
+  input_view_desc.Texture2D.ArraySlice = array_index;
+  ID3D11VideoProcessorInputView* input_view = nullptr;
+  hr = video_device_->CreateVideoProcessorInputView(
+      texture, processor_enum_, &input_view_desc, &input_view);
+  if (FAILED(hr)) {
+    back_buffer->Release();
+    return;
+  }
+  D3D11_VIDEO_PROCESSOR_OUTPUT_VIEW_DESC output_view_desc = {};
+  output_view_desc.ViewDimension = D3D11_VPOV_DIMENSION_TEXTURE2D;
+  output_view_desc.Texture2D.MipSlice = 0;
+  ID3D11VideoProcessorOutputView* output_view = nullptr;
+  hr = video_device_->CreateVideoProcessorOutputView(
+      back_buffer, processor_enum_, &output_view_desc, &output_view);
+  if (FAILED(hr)) {
+    input_view->Release();
+    back_buffer->Release();
+    return;
+  }
+  D3D11_VIDEO_PROCESSOR_STREAM stream = {};
+  stream.Enable = TRUE;
+  stream.pInputSurface = input_view;
+  hr = video_context_->VideoProcessorBlt(processor_, output_view, 0, 1,
+                                         &stream);
+  input_view->Release();
+  output_view->Release();
+  back_buffer->Release();
+  if (FAILED(hr)) {
+    RTC_LOG(LS_ERROR) << "VideoProcessorBlt failed: " << hr;
+    return;
+  }
+  // Sync interval 0 on a flip-model swapchain replaces any still-queued
+  // frame instead of waiting behind it; the waitable object above is what
+  // paces us.
+  swap_chain_->Present(0, 0);
+}
+
+void WebrtcVideoRendererD3D11Impl::OnFrame(const webrtc::VideoFrame& frame) {
+  if (init_failed_)
+    return;
+  if (frame.video_frame_buffer()->type() ==
+      webrtc::VideoFrameBuffer::Type::kNative) {
+    NativeHandleBuffer* native_buffer = static_cast<NativeHandleBuffer*>(
+        frame.video_frame_buffer().get());
+    if (native_buffer->handle_type() == NativeHandleBuffer::kD3D11Texture) {
+      D3D11ImageHandle* handle =
+          reinterpret_cast<D3D11ImageHandle*>(native_buffer->native_handle());
+      if (!device_ && !InitDevice(handle->d3d11_device)) {
+        init_failed_ = true;
+        return;
+      }
+      if (handle->d3d11_device != device_) {
+        RTC_LOG(LS_WARNING)
+            << "Dropping frame from a different D3D11 device.";
+        return;
+      }
+      // Bounded by one frame interval; a later frame supersedes one whose
+      // producer still holds the texture.
+      if (!handle->AcquireSync(16)) {
+        RTC_LOG(LS_WARNING) << "Timed out acquiring shared frame texture.";
+        return;
+      }
+      RenderTexture(handle->texture, handle->array_index);
+      handle->ReleaseSync();
+      return;
+    }
+    if (native_buffer->handle_type() != NativeHandleBuffer::kUnspecified)
+      return;
+    // Hardware decoder output: a D3D9 surface owned by the decoder pool.
+    NativeD3DSurfaceHandle* handle = reinterpret_cast<NativeD3DSurfaceHandle*>(
+        native_buffer->native_handle());
+    if (!handle)
+      return;
+    if (!device_ && !InitDevice(nullptr)) {
+      init_failed_ = true;
+      delete handle;
+      return;
+    }
+    ID3D11Texture2D* texture = CopyD3D9Surface(handle);
+    if (texture)
+      RenderTexture(texture, 0);
+    // The sink owns the per-frame handle, matching the D3D9 renderer.
+    delete handle;
+    return;
+  }
+  if (!device_ && !InitDevice(nullptr)) {
+    init_failed_ = true;
+    return;
+  }
+  ID3D11Texture2D* texture = UploadSoftwareFrame(frame);
+  if (texture)
+    RenderTexture(texture, 0);
+}
+}  // namespace base
+}  // namespace owt
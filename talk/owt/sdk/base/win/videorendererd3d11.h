@@ -0,0 +1,84 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_WIN_VIDEORENDERER_D3D11_H
+#define OWT_BASE_WIN_VIDEORENDERER_D3D11_H
+#include <d3d9.h>
+#include <d3d11.h>
+#include <dxgi1_3.h>
+#include <dxva2api.h>
+#include <Windows.h>
+#include "webrtc/api/video/video_frame.h"
+#include "webrtc/api/video/video_sink_interface.h"
+namespace owt {
+namespace base {
+struct NativeD3DSurfaceHandle;
+// DXGI flip-model renderer. Presents through a waitable flip-model
+// swapchain with a maximum frame latency of one, so frames hit the screen
+// without the extra present-queue frame the legacy D3D9 blit path adds,
+// and color conversion runs on the GPU through the fixed-function video
+// processor instead of a CPU ARGB pass. Hardware-decoded D3D9 surfaces
+// are brought over with one on-GPU StretchRect into a shared render
+// target, so decoded pixels never touch system memory.
+class WebrtcVideoRendererD3D11Impl
+    : public rtc::VideoSinkInterface<webrtc::VideoFrame> {
+ public:
+  explicit WebrtcVideoRendererD3D11Impl(HWND wnd);
+  virtual void OnFrame(const webrtc::VideoFrame& frame) override;
+  virtual ~WebrtcVideoRendererD3D11Impl() { Destroy(); }
+
+ private:
+  // Creates the rendering device, or adopts |external_device| so frames
+  // produced on it render with zero copies.
+  bool InitDevice(ID3D11Device* external_device);
+  // (Re)creates the swapchain when the window client size changes.
+  // Returns false when the window is not presentable yet.
+  bool EnsureSwapChain();
+  bool EnsureProcessor(int input_width, int input_height);
+  // Copies an I420 frame into a GPU NV12 texture through the staging
+  // texture; returns nullptr on failure.
+  ID3D11Texture2D* UploadSoftwareFrame(const webrtc::VideoFrame& frame);
+  // Blits a decoder-owned D3D9 surface into a render target shared with
+  // the D3D11 device, staying on the GPU throughout.
+  ID3D11Texture2D* CopyD3D9Surface(NativeD3DSurfaceHandle* handle);
+  void RenderTexture(ID3D11Texture2D* texture, int array_index);
+  void ReleaseInteropResources();
+  void Destroy();
+
+  HWND wnd_;
+  // Set after an unrecoverable setup failure so a broken environment does
+  // not retry device creation on every frame.
+  bool init_failed_;
+  ID3D11Device* device_;
+  ID3D11DeviceContext* context_;
+  IDXGISwapChain2* swap_chain_;
+  // Signaled by DXGI when presenting will not queue; owned by the
+  // swapchain, never closed here.
+  HANDLE frame_latency_waitable_;
+  int swap_chain_width_;
+  int swap_chain_height_;
+  ID3D11VideoDevice* video_device_;
+  ID3D11VideoContext* video_context_;
+  ID3D11VideoProcessorEnumerator* processor_enum_;
+  ID3D11VideoProcessor* processor_;
+  int processor_input_width_;
+  int processor_input_height_;
+  int processor_output_width_;
+  int processor_output_height_;
+  // Software-frame upload pair: CPU writes land in |staging_texture_| and
+  // are copied on-GPU into |upload_texture_| for the video processor.
+  ID3D11Texture2D* upload_texture_;
+  ID3D11Texture2D* staging_texture_;
+  int upload_width_;
+  int upload_height_;
+  // D3D9 interop pair backed by the same video memory: the decoder device
+  // StretchRects into |interop_surface_|, the video processor samples
+  // |interop_texture_|.
+  IDirect3DSurface9* interop_surface_;
+  ID3D11Texture2D* interop_texture_;
+  int interop_width_;
+  int interop_height_;
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_WIN_VIDEORENDERER_D3D11_H
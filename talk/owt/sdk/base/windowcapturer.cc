@@ -14,9 +14,52 @@
 #include "webrtc/system_wrappers/include/clock.h"
 #include "webrtc/system_wrappers/include/sleep.h"
 #include "talk/owt/sdk/base/desktopcapturer.h"
+#include "talk/owt/sdk/base/modulelogging.h"
 using namespace rtc;
 namespace owt {
 namespace base {
+// Process-wide pool of RGBA staging buffers shared by every window capturer
+// in the process. The odd-dimension scaling path recycles buffers by
+// capacity instead of allocating a full RGBA frame per capture. The
+// conversion itself is libyuv and already runs on the widest SIMD level the
+// CPU offers, so the allocation churn is what this removes.
+static const size_t kMaxPooledRgbaBuffers = 8;
+struct RgbaStagingBuffer {
+  size_t capacity = 0;
+  std::unique_ptr<uint8_t[]> data;
+};
+static rtc::CriticalSection* RgbaPoolLock() {
+  static rtc::CriticalSection* const lock = new rtc::CriticalSection();
+  return lock;
+}
+static std::vector<RgbaStagingBuffer>* RgbaPool() {
+  static std::vector<RgbaStagingBuffer>* const pool =
+      new std::vector<RgbaStagingBuffer>();
+  return pool;
+}
+static RgbaStagingBuffer TakeRgbaBuffer(size_t capacity) {
+  {
+    rtc::CritScope cs(RgbaPoolLock());
+    std::vector<RgbaStagingBuffer>* pool = RgbaPool();
+    for (auto it = pool->begin(); it != pool->end(); ++it) {
+      if (it->capacity >= capacity) {
+        RgbaStagingBuffer buffer = std::move(*it);
+        pool->erase(it);
+        return buffer;
+      }
+    }
+  }
+  RgbaStagingBuffer buffer;
+  buffer.capacity = capacity;
+  buffer.data.reset(new uint8_t[capacity]);
+  return buffer;
+}
+static void ReturnRgbaBuffer(RgbaStagingBuffer buffer) {
+  rtc::CritScope cs(RgbaPoolLock());
+  std::vector<RgbaStagingBuffer>* pool = RgbaPool();
+  if (pool->size() < kMaxPooledRgbaBuffers)
+    pool->push_back(std::move(buffer));
+}
 /////////////////////////////////////////////////////////////////////
 // Implementation of class BasicWindowCapturer. Window capturer is
 // different from window capturer as the window may be disposed
@@ -194,7 +237,8 @@ int BasicWindowCapturer::I420DataSize(int height,
 }
 void BasicWindowCapturer::AdjustFrameBuffer(int32_t width, int32_t height) {
   if (width_ != width || height != height_ || !frame_buffer_) {
-    RTC_LOG(LS_VERBOSE) << "Allocate new memory for frame buffer.";
+    OWT_MODULE_LOG(kBase, kVerbose)
+        << "Allocate new memory for frame buffer.";
     width_ = width;
     height_ = height;
     int stride_y = width_;
@@ -235,6 +279,7 @@ void BasicWindowCapturer::OnCaptureResult(
   // On hosts with GEN & NV gfx co-existing, frame must be of even both
   // for width and height. So we will always scale for that.
   bool scale_required = false;
+  RgbaStagingBuffer staging_buffer;
   int32_t old_frame_width = frame_width;
   int32_t old_frame_height = frame_height;
   int new_frame_stride = frame_stride;
@@ -246,18 +291,17 @@ void BasicWindowCapturer::OnCaptureResult(
     frame_height -= 1;
     scale_required = true;
   }
-  std::unique_ptr<uint8_t []> new_frame_data_rgba;
   if (scale_required) {
-    new_frame_data_rgba.reset(new uint8_t[frame_width * frame_height * 4]);
+    staging_buffer = TakeRgbaBuffer(frame_width * frame_height * 4);
     new_frame_stride = frame_width * 4;
     libyuv::ARGBScale(frame_data_rgba, frame_stride, old_frame_width, old_frame_height,
-      new_frame_data_rgba.get(), new_frame_stride, frame_width, frame_height, libyuv::FilterMode::kFilterBilinear);
+      staging_buffer.data.get(), new_frame_stride, frame_width, frame_height, libyuv::FilterMode::kFilterBilinear);
   }
   // The captured frame is of memory layout ABRG. convert it to I420 as
   // required.
   AdjustFrameBuffer(frame_width, frame_height);
   if (scale_required) {
-    libyuv::ARGBToI420(new_frame_data_rgba.get(), new_frame_stride,
+    libyuv::ARGBToI420(staging_buffer.data.get(), new_frame_stride,
       frame_buffer_->MutableDataY(), frame_buffer_->StrideY(),
       frame_buffer_->MutableDataU(), frame_buffer_->StrideU(),
       frame_buffer_->MutableDataV(), frame_buffer_->StrideV(),
@@ -269,6 +313,8 @@ void BasicWindowCapturer::OnCaptureResult(
       frame_buffer_->MutableDataV(), frame_buffer_->StrideV(),
       frame_width, frame_height);
   }
+  if (scale_required)
+    ReturnRgbaBuffer(std::move(staging_buffer));
   webrtc::VideoFrame capturedFrame(frame_buffer_, 0, rtc::TimeMillis(),
                                    webrtc::kVideoRotation_0);
   OnFrame(capturedFrame, frame_width, frame_height);
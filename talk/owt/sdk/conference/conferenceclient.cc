@@ -2,10 +2,18 @@
 //
 // SPDX-License-Identifier: Apache-2.0
 #include <algorithm>
+#include <functional>
 #include <string>
+#include <thread>
 #include "talk/owt/sdk/base/mediautils.h"
+#include "talk/owt/sdk/base/memoryaccounting.h"
+#include "talk/owt/sdk/base/queuedepthgauges.h"
+#include "talk/owt/sdk/base/threadloadmonitor.h"
+#include "talk/owt/sdk/base/networkchangenotifier.h"
+#include "talk/owt/sdk/base/peerconnectiondependencyfactory.h"
 #include "talk/owt/sdk/base/stringutils.h"
 #include "talk/owt/sdk/conference/conferencepeerconnectionchannel.h"
+#include "talk/owt/sdk/include/cpp/owt/base/columnarstats.h"
 #include "talk/owt/sdk/include/cpp/owt/base/stream.h"
 #include "talk/owt/sdk/include/cpp/owt/conference/conferenceclient.h"
 #include "talk/owt/sdk/include/cpp/owt/conference/remotemixedstream.h"
@@ -29,6 +37,69 @@ static const std::unordered_map<std::string, VideoSourceInfo>
                           {"raw-file", VideoSourceInfo::kFile},
                           {"encoded-file", VideoSourceInfo::kFile},
                           {"mcu", VideoSourceInfo::kMixed}};
+// Bound on |stream_info_cache_| entries. The cache is cleared wholesale
+// when it grows past this; a coarse prune is fine since entries are
+// rebuilt on the next parse.
+static const size_t kMaxCachedStreamInfos = 4096;
+// FNV-1a fingerprint of a serialized sio message, standing in for the
+// version/etag the signaling protocol does not provide. Streams whose
+// info fingerprint is unchanged across a rejoin reuse their parsed state.
+static void FingerprintBytes(const char* data, size_t size, uint64_t* hash) {
+  for (size_t i = 0; i < size; i++) {
+    *hash ^= static_cast<unsigned char>(data[i]);
+    *hash *= 1099511628211ull;
+  }
+}
+static void FingerprintSioMessage(const sio::message::ptr& message,
+                                  uint64_t* hash) {
+  if (message == nullptr) {
+    FingerprintBytes("\0", 1, hash);
+    return;
+  }
+  char flag = static_cast<char>(message->get_flag());
+  FingerprintBytes(&flag, 1, hash);
+  switch (message->get_flag()) {
+    case sio::message::flag_integer: {
+      int64_t value = message->get_int();
+      FingerprintBytes(reinterpret_cast<const char*>(&value), sizeof(value),
+                       hash);
+      break;
+    }
+    case sio::message::flag_double: {
+      double value = message->get_double();
+      FingerprintBytes(reinterpret_cast<const char*>(&value), sizeof(value),
+                       hash);
+      break;
+    }
+    case sio::message::flag_string:
+      FingerprintBytes(message->get_string().data(),
+                       message->get_string().size(), hash);
+      break;
+    case sio::message::flag_binary:
+      if (message->get_binary()) {
+        FingerprintBytes(message->get_binary()->data(),
+                         message->get_binary()->size(), hash);
+      }
+      break;
+    case sio::message::flag_array:
+      for (const auto& item : message->get_vector())
+        FingerprintSioMessage(item, hash);
+      break;
+    case sio::message::flag_object:
+      for (const auto& item : message->get_map()) {
+        FingerprintBytes(item.first.data(), item.first.size(), hash);
+        FingerprintSioMessage(item.second, hash);
+      }
+      break;
+    default:
+      break;
+  }
+}
+static uint64_t FingerprintSioMessage(const sio::message::ptr& message) {
+  uint64_t hash = 14695981039346656037ull;
+  FingerprintSioMessage(message, &hash);
+  return hash;
+}
 void Participant::AddObserver(ParticipantObserver& observer) {
   const std::lock_guard<std::mutex> lock(observer_mutex_);
   std::vector<std::reference_wrapper<ParticipantObserver>>::iterator it =
@@ -62,6 +133,50 @@ void ConferenceInfo::AddParticipant(std::shared_ptr<Participant> participant) {
   }
   return;
 }
+void ConferenceInfo::AddPendingParticipant(
+    const std::string& participant_id,
+    std::shared_ptr<sio::message> user_info) {
+  const std::lock_guard<std::mutex> lock(participants_mutex_);
+  for (auto& it : participants_) {
+    if (it->Id() == participant_id)
+      return;
+  }
+  pending_participants_[participant_id] = user_info;
+}
+std::shared_ptr<Participant> ConferenceInfo::MaterializeParticipant(
+    const std::string& participant_id) const {
+  auto pending = pending_participants_.find(participant_id);
+  if (pending == pending_participants_.end())
+    return nullptr;
+  Participant* participant_raw = nullptr;
+  std::shared_ptr<Participant> participant;
+  if (ConferenceClient::ParseUser(pending->second, &participant_raw)) {
+    participant.reset(participant_raw);
+    participants_.push_back(participant);
+  }
+  pending_participants_.erase(pending);
+  return participant;
+}
+std::vector<std::shared_ptr<Participant>> ConferenceInfo::Participants() const {
+  const std::lock_guard<std::mutex> lock(participants_mutex_);
+  while (!pending_participants_.empty()) {
+    MaterializeParticipant(pending_participants_.begin()->first);
+  }
+  return participants_;
+}
+size_t ConferenceInfo::ParticipantCount() const {
+  const std::lock_guard<std::mutex> lock(participants_mutex_);
+  return participants_.size() + pending_participants_.size();
+}
+std::shared_ptr<Participant> ConferenceInfo::FindParticipant(
+    const std::string& participant_id) const {
+  const std::lock_guard<std::mutex> lock(participants_mutex_);
+  for (auto& it : participants_) {
+    if (it->Id() == participant_id)
+      return it;
+  }
+  return MaterializeParticipant(participant_id);
+}
 void ConferenceInfo::AddOrUpdateStream(
     std::shared_ptr<RemoteStream> remote_stream,
     bool& update) {
@@ -76,8 +191,10 @@ void ConferenceInfo::AddOrUpdateStream(
                            return match;
                          });
   if (update && it != remote_streams_.end()) {
-    (*it)->Capabilities(remote_stream->Capabilities());
-    (*it)->Settings(remote_stream->Settings());
+    // Carry over capability info without forcing the deferred parse to
+    // run; repeated mixed stream updates would otherwise re-walk the same
+    // format lists on every layout change.
+    (*it)->AdoptCapabilityInfo(*remote_stream);
     // Attributes is not supported to be updated so we will not update it.
     TriggerOnStreamUpdated(stream_id);
   } else {
@@ -86,9 +203,13 @@ void ConferenceInfo::AddOrUpdateStream(
 }
 void ConferenceInfo::RemoveParticipantById(const std::string& id) {
   const std::lock_guard<std::mutex> lock(participants_mutex_);
-  participants_.erase(std::find_if(
+  if (pending_participants_.erase(id) > 0)
+    return;
+  auto it = std::find_if(
       participants_.begin(), participants_.end(),
-      [&](std::shared_ptr<Participant> o) -> bool { return o->Id() == id; }));
+      [&](std::shared_ptr<Participant> o) -> bool { return o->Id() == id; });
+  if (it != participants_.end())
+    participants_.erase(it);
 }
 void ConferenceInfo::RemoveStreamById(const std::string& stream_id) {
   const std::lock_guard<std::mutex> lock(remote_streams_mutex_);
@@ -100,6 +221,8 @@ void ConferenceInfo::RemoveStreamById(const std::string& stream_id) {
 }
 bool ConferenceInfo::ParticipantPresent(const std::string& participant_id) {
   const std::lock_guard<std::mutex> lock(participants_mutex_);
+  if (pending_participants_.find(participant_id) != pending_participants_.end())
+    return true;
   for (auto& it : participants_) {
     if (it->Id() == participant_id)
       return true;
@@ -161,6 +284,90 @@ enum ConferenceClient::StreamType : int {
 };
 const std::string play_pause_failure_message =
     "Cannot play/pause a stream that have not been published or subscribed.";
+// Number of queues stream events are spread over. Events for one stream
+// always map to the same queue.
+const int kStreamEventQueueCount = 4;
+// Layout updates for one mixed stream arriving within this window are
+// collapsed into a single diff notification.
+const int kLayoutBatchWindowMs = 30;
+// Lowest send cap the bandwidth orchestrator pushes to a publication, so
+// a low-weight stream keeps enough rate to stay decodable instead of
+// being starved outright on a constrained uplink.
+const int kMinOrchestratedBitrateBps = 50000;
+// Region coordinates arrive as numbers or as rational strings ("1/3")
+// depending on the server version.
+static double ParseRegionCoordinate(sio::message::ptr value) {
+  if (value == nullptr) {
+    return 0;
+  }
+  if (value->get_flag() == sio::message::flag_double) {
+    return value->get_double();
+  }
+  if (value->get_flag() == sio::message::flag_integer) {
+    return static_cast<double>(value->get_int());
+  }
+  if (value->get_flag() == sio::message::flag_string) {
+    std::string text = value->get_string();
+    auto slash = text.find('/');
+    try {
+      if (slash == std::string::npos) {
+        return std::stod(text);
+      }
+      double denominator = std::stod(text.substr(slash + 1));
+      if (denominator == 0) {
+        return 0;
+      }
+      return std::stod(text.substr(0, slash)) / denominator;
+    } catch (const std::exception&) {
+      return 0;
+    }
+  }
+  return 0;
+}
+// Parses the value of a video.layout update into region descriptions.
+// Unrecognized entries are skipped so newer servers do not break parsing.
+static std::vector<VideoLayoutRegion> ParseVideoLayout(
+    sio::message::ptr value) {
+  std::vector<VideoLayoutRegion> regions;
+  if (value == nullptr || value->get_flag() != sio::message::flag_array) {
+    return regions;
+  }
+  for (auto& entry : value->get_vector()) {
+    if (entry == nullptr || entry->get_flag() != sio::message::flag_object) {
+      continue;
+    }
+    auto& entry_map = entry->get_map();
+    VideoLayoutRegion region;
+    if (entry_map["stream"] != nullptr &&
+        entry_map["stream"]->get_flag() == sio::message::flag_string) {
+      region.stream_id = entry_map["stream"]->get_string();
+    }
+    auto region_info = entry_map["region"];
+    if (region_info == nullptr ||
+        region_info->get_flag() != sio::message::flag_object) {
+      continue;
+    }
+    auto& region_map = region_info->get_map();
+    if (region_map["id"] != nullptr &&
+        region_map["id"]->get_flag() == sio::message::flag_string) {
+      region.region_id = region_map["id"]->get_string();
+    }
+    if (region_map["shape"] != nullptr &&
+        region_map["shape"]->get_flag() == sio::message::flag_string) {
+      region.shape = region_map["shape"]->get_string();
+    }
+    auto area = region_map["area"];
+    if (area != nullptr && area->get_flag() == sio::message::flag_object) {
+      auto& area_map = area->get_map();
+      region.left = ParseRegionCoordinate(area_map["left"]);
+      region.top = ParseRegionCoordinate(area_map["top"]);
+      region.width = ParseRegionCoordinate(area_map["width"]);
+      region.height = ParseRegionCoordinate(area_map["height"]);
+    }
+    regions.push_back(region);
+  }
+  return regions;
+}
 std::shared_ptr<ConferenceClient> ConferenceClient::Create(
     const ConferenceClientConfiguration& configuration) {
   return std::shared_ptr<ConferenceClient>(new ConferenceClient(configuration));
@@ -170,56 +377,110 @@ ConferenceClient::ConferenceClient(
     : configuration_(configuration),
       event_queue_(new rtc::TaskQueue("ConferenceClientEventQueue")),
       signaling_channel_(new ConferenceSocketSignalingChannel()),
-      signaling_channel_connected_(false) {}
+      signaling_channel_connected_(false),
+      channel_pool_active_(false),
+      stats_sampling_active_(false),
+      stats_sampling_interval_ms_(0),
+      bandwidth_orchestration_active_(false),
+      bandwidth_orchestration_interval_ms_(0),
+      audio_focus_active_(false),
+      audio_focus_interval_ms_(0),
+      audio_focus_max_active_(0),
+      publish_pcs_(std::make_shared<ChannelList>()),
+      subscribe_pcs_(std::make_shared<ChannelList>()),
+      session_routing_(std::make_shared<SessionRoutingMap>()),
+      observers_(std::make_shared<ObserverList>()),
+      stream_update_observers_(std::make_shared<StreamUpdateObserverList>()) {
+  for (int i = 0; i < kStreamEventQueueCount; i++) {
+    stream_event_queues_.push_back(std::make_shared<rtc::TaskQueue>(
+        "ConferenceClientStreamEventQueue"));
+  }
+  // An interface change (WiFi to wired, VPN toggle) would otherwise leave
+  // sessions black until ICE times out; restart immediately instead.
+  // IceRestart only posts to the channel threads, so the notifier's
+  // monitor thread is not blocked.
+  network_change_callback_id_ =
+      NetworkChangeNotifier::Get()->AddCallback([this] {
+        if (!signaling_channel_connected_) {
+          return;
+        }
+        RTC_LOG(LS_INFO) << "Restart ICE for all sessions on network change.";
+        RestartIceForAllSessions();
+      });
+}
 ConferenceClient::~ConferenceClient() {
+  // Joins the sampler, orchestrator and focus threads before any member
+  // they touch is destroyed.
+  StopAudioFocusControl();
+  StopBandwidthOrchestration();
+  StopStatsSampling();
+  // Blocks until an in-flight notification returns, so the callback can
+  // never observe a destroyed client.
+  NetworkChangeNotifier::Get()->RemoveCallback(network_change_callback_id_);
   signaling_channel_->RemoveObserver(*this);
 }
 void ConferenceClient::AddObserver(ConferenceClientObserver& observer) {
   const std::lock_guard<std::mutex> lock(observer_mutex_);
-  std::vector<std::reference_wrapper<ConferenceClientObserver>>::iterator it =
-      std::find_if(
-          observers_.begin(), observers_.end(),
-          [&](std::reference_wrapper<ConferenceClientObserver> o) -> bool {
-            return &observer == &(o.get());
-          });
-  if (it != observers_.end()) {
+  auto current = std::atomic_load(&observers_);
+  auto it = std::find_if(
+      current->begin(), current->end(),
+      [&](std::reference_wrapper<ConferenceClientObserver> o) -> bool {
+        return &observer == &(o.get());
+      });
+  if (it != current->end()) {
     RTC_LOG(LS_INFO) << "Adding duplicate observer.";
     return;
   }
-  observers_.push_back(observer);
+  auto new_list = std::make_shared<ObserverList>(*current);
+  new_list->push_back(observer);
+  std::atomic_store(&observers_,
+                    std::shared_ptr<const ObserverList>(std::move(new_list)));
 }
 void ConferenceClient::RemoveObserver(ConferenceClientObserver& observer) {
   const std::lock_guard<std::mutex> lock(observer_mutex_);
-  observers_.erase(std::find_if(
-      observers_.begin(), observers_.end(),
+  auto new_list = std::make_shared<ObserverList>(*std::atomic_load(&observers_));
+  new_list->erase(std::find_if(
+      new_list->begin(), new_list->end(),
       [&](std::reference_wrapper<ConferenceClientObserver> o) -> bool {
         return &observer == &(o.get());
       }));
+  std::atomic_store(&observers_,
+                    std::shared_ptr<const ObserverList>(std::move(new_list)));
 }
 void ConferenceClient::AddStreamUpdateObserver(
     ConferenceStreamUpdateObserver& observer) {
   const std::lock_guard<std::mutex> lock(stream_update_observer_mutex_);
-  std::vector<std::reference_wrapper<ConferenceStreamUpdateObserver>>::iterator
-      it = std::find_if(
-          stream_update_observers_.begin(), stream_update_observers_.end(),
-          [&](std::reference_wrapper<ConferenceStreamUpdateObserver> o)
-              -> bool { return &observer == &(o.get()); });
-  if (it != stream_update_observers_.end()) {
+  auto current = std::atomic_load(&stream_update_observers_);
+  auto it = std::find_if(
+      current->begin(), current->end(),
+      [&](std::reference_wrapper<ConferenceStreamUpdateObserver> o) -> bool {
+        return &observer == &(o.get());
+      });
+  if (it != current->end()) {
     RTC_LOG(LS_INFO) << "Adding duplicate observer.";
     return;
   }
-  stream_update_observers_.push_back(observer);
+  auto new_list = std::make_shared<StreamUpdateObserverList>(*current);
+  new_list->push_back(observer);
+  std::atomic_store(
+      &stream_update_observers_,
+      std::shared_ptr<const StreamUpdateObserverList>(std::move(new_list)));
 }
 void ConferenceClient::RemoveStreamUpdateObserver(
     ConferenceStreamUpdateObserver& observer) {
   const std::lock_guard<std::mutex> lock(stream_update_observer_mutex_);
+  auto new_list = std::make_shared<StreamUpdateObserverList>(
+      *std::atomic_load(&stream_update_observers_));
   auto it = std::find_if(
-      stream_update_observers_.begin(), stream_update_observers_.end(),
+      new_list->begin(), new_list->end(),
       [&](std::reference_wrapper<ConferenceStreamUpdateObserver> o) -> bool {
         return &observer == &(o.get());
       });
-  if (it != stream_update_observers_.end())
-    stream_update_observers_.erase(it);
+  if (it != new_list->end())
+    new_list->erase(it);
+  std::atomic_store(
+      &stream_update_observers_,
+      std::shared_ptr<const StreamUpdateObserverList>(std::move(new_list)));
 }
 void ConferenceClient::Join(
     const std::string& token,
@@ -243,6 +504,11 @@ void ConferenceClient::Join(
     token_base64 = rtc::Base64::Encode(token);
   }
   signaling_channel_->AddObserver(*this);
+  // Warm up in parallel with the socket connection: the PeerConnection
+  // factory and the pre-warmed channels are built while the TLS handshake
+  // and login are still in flight, so the first Publish/Subscribe after
+  // join claims a ready channel.
+  Preconnect();
   signaling_channel_->Connect(
       token_base64,
       [=](sio::message::ptr info) {
@@ -324,16 +590,22 @@ void ConferenceClient::Join(
       },
       on_failure);
 }
+void ConferenceClient::Preconnect() {
+  // Creating the factory here covers the case where the pool size is 0:
+  // certificate generation and thread setup still run off the join path.
+  PeerConnectionDependencyFactory::Get();
+  channel_pool_active_ = true;
+  RefillChannelPool();
+}
 void ConferenceClient::Publish(
     std::shared_ptr<LocalStream> stream,
     std::function<void(std::shared_ptr<ConferencePublication>)> on_success,
     std::function<void(std::unique_ptr<Exception>)> on_failure) {
-  PublishOptions options;
-  Publish(stream, options, on_success, on_failure);
+  Publish(stream, PublishOptions(), on_success, on_failure);
 }
 void ConferenceClient::Publish(
     std::shared_ptr<LocalStream> stream,
-    const PublishOptions& options,
+    PublishOptions options,
     std::function<void(std::shared_ptr<ConferencePublication>)> on_success,
     std::function<void(std::unique_ptr<Exception>)> on_failure) {
   if (!CheckNullPointer((uintptr_t)stream.get(), on_failure)) {
@@ -365,20 +637,19 @@ void ConferenceClient::Publish(
   // Reorder SDP according to perference list.
   PeerConnectionChannelConfiguration config =
       GetPeerConnectionChannelConfiguration();
-  for (auto codec : options.video) {
-    config.video.push_back(VideoEncodingParameters(codec));
-  }
-  for (auto codec : options.audio) {
-    config.audio.push_back(AudioEncodingParameters(codec));
-  }
-  std::shared_ptr<ConferencePeerConnectionChannel> pcc(
-      new ConferencePeerConnectionChannel(config, signaling_channel_,
-                                          event_queue_));
+  // The options were taken by value, so the encoding vectors transfer
+  // into the channel configuration without per-element copies.
+  bool default_options = options.video.empty() && options.audio.empty();
+  config.video = std::move(options.video);
+  config.audio = std::move(options.audio);
+  config.simulcast_layer_count = options.simulcast_layer_count;
+  config.intra_refresh = options.intra_refresh;
+  config.max_pacing_bitrate_bps = options.max_pacing_bitrate_bps;
+  config.bandwidth_priority = options.bandwidth_priority;
+  std::shared_ptr<ConferencePeerConnectionChannel> pcc =
+      CreateChannel(std::move(config), default_options);
   pcc->AddObserver(*this);
-  {
-    std::lock_guard<std::mutex> lock(publish_pcs_mutex_);
-    publish_pcs_.push_back(pcc);
-  }
+  AddToChannelList(publish_pcs_, publish_pcs_mutex_, pcc);
   std::weak_ptr<ConferenceClient> weak_this = shared_from_this();
   std::string stream_id = stream->Id();
   pcc->Publish(stream,
@@ -393,18 +664,17 @@ void ConferenceClient::Publish(
                    on_success(cp);
                  }
                },
-               on_failure);
+               std::move(on_failure));
 }
 void ConferenceClient::Subscribe(
     std::shared_ptr<RemoteStream> stream,
     std::function<void(std::shared_ptr<ConferenceSubscription>)> on_success,
     std::function<void(std::unique_ptr<Exception>)> on_failure) {
-  SubscribeOptions options;
-  Subscribe(stream, options, on_success, on_failure);
+  Subscribe(stream, SubscribeOptions(), on_success, on_failure);
 }
 void ConferenceClient::Subscribe(
     std::shared_ptr<RemoteStream> stream,
-    const SubscribeOptions& options,
+    SubscribeOptions options,
     std::function<void(std::shared_ptr<ConferenceSubscription>)> on_success,
     std::function<void(std::unique_ptr<Exception>)> on_failure) {
   if (!CheckNullPointer((uintptr_t)stream.get(), on_failure)) {
@@ -415,7 +685,14 @@ void ConferenceClient::Subscribe(
     return;
   }
   RTC_LOG(LS_INFO) << "Stream ID: " << stream->Id();
-  if (added_stream_type_.find(stream->Id()) == added_stream_type_.end()) {
+  bool stream_added = false;
+  {
+    std::lock_guard<std::mutex> lock(added_streams_mutex_);
+    stream_added =
+        added_stream_type_.find(InternedString::Intern(stream->Id())) !=
+        added_stream_type_.end();
+  }
+  if (!stream_added) {
     std::string failure_message(
         "Subscribing an invalid stream. Please check whether this stream is "
         "removed.");
@@ -442,14 +719,15 @@ void ConferenceClient::Subscribe(
   }
   // Avoid subscribing the same stream twice.
   {
-    std::lock_guard<std::mutex> lock(subscribe_pcs_mutex_);
-    // Search subscirbe pcs
+    // Search subscirbe pcs on a lock-free snapshot.
+    std::shared_ptr<const ChannelList> subscribe_pcs =
+        ChannelSnapshot(subscribe_pcs_);
     auto it = std::find_if(
-        subscribe_pcs_.begin(), subscribe_pcs_.end(),
+        subscribe_pcs->begin(), subscribe_pcs->end(),
         [&](std::shared_ptr<ConferencePeerConnectionChannel> o) -> bool {
           return o->GetSubStreamId() == stream->Id();
         });
-    if (it != subscribe_pcs_.end()) {
+    if (it != subscribe_pcs->end()) {
       std::string failure_message(
           "The same remote stream has already been subscribed. Subcribe after "
           "it is "
@@ -467,24 +745,37 @@ void ConferenceClient::Subscribe(
   // Reorder SDP according to perference list.
   PeerConnectionChannelConfiguration config =
       GetPeerConnectionChannelConfiguration();
-  for (auto codec : options.video.codecs) {
+  for (const auto& codec : options.video.codecs) {
     config.video.push_back(VideoEncodingParameters(codec, 0, false));
   }
-  for (auto codec : options.audio.codecs) {
+  for (const auto& codec : options.audio.codecs) {
     config.audio.push_back(AudioEncodingParameters(codec, 0));
   }
-  std::shared_ptr<ConferencePeerConnectionChannel> pcc(
-      new ConferencePeerConnectionChannel(config, signaling_channel_,
-                                          event_queue_));
+  if (options.low_latency) {
+    // Playout smoothing trades latency for cadence; a low-latency
+    // subscription wants frames on screen the moment they decode.
+    config.set_prerenderer_smoothing(false);
+  }
+  // Playout delay hints map onto the smoothing queue, the one playout
+  // buffer this engine revision lets a receiver control. A zero latency
+  // ceiling turns it off; a positive floor keeps it on even when
+  // |low_latency| on the same subscription turned it off above.
+  if (options.playout_delay.min_ms > 0) {
+    config.set_prerenderer_smoothing(true);
+  } else if (options.playout_delay.max_ms == 0) {
+    config.set_prerenderer_smoothing(false);
+  }
+  std::shared_ptr<ConferencePeerConnectionChannel> pcc = CreateChannel(
+      std::move(config),
+      options.video.codecs.empty() && options.audio.codecs.empty() &&
+          !options.low_latency && options.playout_delay.min_ms < 0 &&
+          options.playout_delay.max_ms < 0);
   pcc->AddObserver(*this);
-  {
-    std::lock_guard<std::mutex> lock(subscribe_pcs_mutex_);
-    subscribe_pcs_.push_back(pcc);
-  }
+  AddToChannelList(subscribe_pcs_, subscribe_pcs_mutex_, pcc);
   std::weak_ptr<ConferenceClient> weak_this = shared_from_this();
   std::string stream_id = stream->Id();
   pcc->Subscribe(
-      stream, options,
+      stream, std::move(options),
       [on_success, weak_this, stream_id](std::string session_id) {
         auto that = weak_this.lock();
         if (!that)
@@ -496,7 +787,28 @@ void ConferenceClient::Subscribe(
           on_success(cp);
         }
       },
-      on_failure);
+      std::move(on_failure));
+}
+void ConferenceClient::SubscribeBatch(
+    const std::vector<std::shared_ptr<RemoteStream>>& streams,
+    const SubscribeOptions& options,
+    std::function<void(std::shared_ptr<ConferenceSubscription>)> on_success,
+    std::function<void(std::shared_ptr<RemoteStream>,
+                       std::unique_ptr<Exception>)> on_failure) {
+  // Subscribe returns as soon as the subscription request is queued on
+  // the socket, so issuing the whole batch here puts every request on the
+  // wire before the first answer comes back and the channels run
+  // offer/answer and ICE concurrently. Waiting for each subscription to
+  // complete before starting the next is what made large joins serial.
+  for (auto stream : streams) {
+    std::function<void(std::unique_ptr<Exception>)> stream_failure = nullptr;
+    if (on_failure != nullptr) {
+      stream_failure = [on_failure, stream](std::unique_ptr<Exception> e) {
+        on_failure(stream, std::move(e));
+      };
+    }
+    Subscribe(stream, options, on_success, stream_failure);
+  }
 }
 void ConferenceClient::UnPublish(
     const std::string& session_id,
@@ -520,17 +832,8 @@ void ConferenceClient::UnPublish(
                  [=]() {
                    if (on_success != nullptr)
                      event_queue_->PostTask([on_success]() { on_success(); });
-                   {
-                     std::lock_guard<std::mutex> lock(publish_pcs_mutex_);
-                     auto it = publish_pcs_.begin();
-                     while (it != publish_pcs_.end()) {
-                       if ((*it)->GetSessionId() == session_id) {
-                         publish_pcs_.erase(it);
-                         break;
-                       }
-                       ++it;
-                     }
-                   }
+                   RemoveFromChannelList(publish_pcs_, publish_pcs_mutex_,
+                                         session_id);
                  },
                  on_failure);
 }
@@ -556,17 +859,12 @@ void ConferenceClient::UnSubscribe(
                    [=]() {
                      if (on_success != nullptr)
                        event_queue_->PostTask([on_success]() { on_success(); });
+                     RemoveFromChannelList(subscribe_pcs_,
+                                           subscribe_pcs_mutex_, session_id);
                      {
                        std::lock_guard<std::mutex> lock(subscribe_pcs_mutex_);
-                       auto it = subscribe_pcs_.begin();
-                       while (it != subscribe_pcs_.end()) {
-                         if ((*it)->GetSessionId() == session_id) {
-                           subscribe_pcs_.erase(it);
-                           break;
-                         }
-                         ++it;
-                       }
-                       subscribe_id_label_map_.erase(session_id);
+                       subscribe_id_label_map_.erase(
+                           InternedString::Intern(session_id));
                      }
                    },
                    on_failure);
@@ -592,6 +890,17 @@ void ConferenceClient::Send(
   signaling_channel_->SendCustomMessage(
       message, receiver, RunInEventQueue(on_success), on_failure);
 }
+void ConferenceClient::Send(
+    std::shared_ptr<const std::string> data,
+    const std::string& receiver,
+    std::function<void()> on_success,
+    std::function<void(std::unique_ptr<Exception>)> on_failure) {
+  if (!CheckSignalingChannelOnline(on_failure)) {
+    return;
+  }
+  signaling_channel_->SendCustomMessage(
+      data, receiver, RunInEventQueue(on_success), on_failure);
+}
 void ConferenceClient::UpdateSubscription(
     const std::string& session_id,
     const std::string& stream_id,
@@ -639,6 +948,10 @@ void ConferenceClient::UpdateSubscription(
     video_params->get_map()["bitrate"] =
         sio::string_message::create(multiplier);
   }
+  if (option.video.temporalLayerId >= 0) {
+    video_params->get_map()["temporalLayerId"] =
+        sio::int_message::create(option.video.temporalLayerId);
+  }
   sio::message::ptr video_update = sio::object_message::create();
   video_update->get_map()["parameters"] = video_params;
   video_update->get_map()["from"] = sio::string_message::create(stream_id);
@@ -719,47 +1032,247 @@ void ConferenceClient::Unmute(
       break;
   }
 }
-void ConferenceClient::Leave(
+void ConferenceClient::Mute(
+    const std::vector<std::string>& session_ids,
+    TrackKind track_kind,
     std::function<void()> on_success,
     std::function<void(std::unique_ptr<Exception>)> on_failure) {
-  if (!CheckSignalingChannelOnline(on_failure)) {
+  SendBulkTrackControl(session_ids, track_kind, "pause", on_success,
+                       on_failure);
+}
+void ConferenceClient::SetPlayoutDelay(const std::string& session_id,
+                                       int min_ms,
+                                       int max_ms) {
+  auto pcc = GetConferencePeerConnectionChannel(session_id);
+  if (pcc == nullptr) {
+    RTC_LOG(LS_WARNING) << "Ignore playout delay hint on unknown session "
+                        << session_id;
     return;
   }
-  {
-    std::lock_guard<std::mutex> lock(publish_pcs_mutex_);
-    publish_id_label_map_.clear();
-    publish_pcs_.clear();
+  pcc->SetPlayoutDelay(min_ms, max_ms);
+}
+void ConferenceClient::Unmute(
+    const std::vector<std::string>& session_ids,
+    TrackKind track_kind,
+    std::function<void()> on_success,
+    std::function<void(std::unique_ptr<Exception>)> on_failure) {
+  SendBulkTrackControl(session_ids, track_kind, "play", on_success,
+                       on_failure);
+}
+void ConferenceClient::Suspend(
+    const std::string& session_id,
+    std::function<void()> on_success,
+    std::function<void(std::unique_ptr<Exception>)> on_failure) {
+  if (!CheckSignalingChannelOnline(on_failure)) {
+    return;
   }
-  {
-    std::lock_guard<std::mutex> lock(subscribe_pcs_mutex_);
-    subscribe_pcs_.clear();
+  auto pcc = GetConferencePeerConnectionChannel(session_id);
+  if (pcc == nullptr) {
+    if (on_failure) {
+      event_queue_->PostTask([on_failure]() {
+        std::unique_ptr<Exception> e(new Exception(
+            ExceptionType::kConferenceUnknown, "Invalid session id."));
+        on_failure(std::move(e));
+      });
+    }
+    return;
   }
-  signaling_channel_->Disconnect(RunInEventQueue(on_success), on_failure);
+  // Tracks go quiet immediately; frames the server forwards until the
+  // pause lands stop at the disabled track instead of being rendered.
+  pcc->SetReceiveTracksEnabled(false);
+  pcc->PauseAudioVideo(on_success, on_failure);
 }
-void ConferenceClient::GetConnectionStats(
+void ConferenceClient::Resume(
     const std::string& session_id,
-    std::function<void(std::shared_ptr<ConnectionStats>)> on_success,
+    std::function<void()> on_success,
     std::function<void(std::unique_ptr<Exception>)> on_failure) {
+  if (!CheckSignalingChannelOnline(on_failure)) {
+    return;
+  }
   auto pcc = GetConferencePeerConnectionChannel(session_id);
   if (pcc == nullptr) {
     if (on_failure) {
       event_queue_->PostTask([on_failure]() {
-        std::unique_ptr<Exception> e(
-            new Exception(ExceptionType::kConferenceUnknown,
-                          "Stream is not published or subscribed."));
+        std::unique_ptr<Exception> e(new Exception(
+            ExceptionType::kConferenceUnknown, "Invalid session id."));
         on_failure(std::move(e));
       });
     }
-    RTC_LOG(LS_WARNING)
-        << "Tried to get connection statistowt from unknown stream.";
     return;
   }
-  pcc->GetConnectionStats(on_success, on_failure);
+  // Tracks first: the first frame the server forwards after the play
+  // message must find an enabled track and the warm decoder behind it.
+  pcc->SetReceiveTracksEnabled(true);
+  pcc->PlayAudioVideo(on_success, on_failure);
 }
-void ConferenceClient::GetStats(
+void ConferenceClient::SendBulkTrackControl(
+    const std::vector<std::string>& session_ids,
+    TrackKind track_kind,
+    const std::string& operation,
+    std::function<void()> on_success,
+    std::function<void(std::unique_ptr<Exception>)> on_failure) {
+  if (!CheckSignalingChannelOnline(on_failure)) {
+    return;
+  }
+  std::string action;
+  switch (track_kind) {
+    case TrackKind::kAudio:
+      action = "audio";
+      break;
+    case TrackKind::kVideo:
+      action = "video";
+      break;
+    case TrackKind::kAudioAndVideo:
+      action = "av";
+      break;
+    default:
+      if (on_failure) {
+        event_queue_->PostTask([on_failure]() {
+          std::unique_ptr<Exception> e(
+              new Exception(ExceptionType::kConferenceUnknown,
+                            "Invalid track kind."));
+          on_failure(std::move(e));
+        });
+      }
+      return;
+  }
+  // Split the sessions into published and subscribed ones; each group is
+  // controlled by a different signaling event.
+  std::vector<std::string> publish_ids;
+  std::vector<std::string> subscribe_ids;
+  auto publish_channels = ChannelSnapshot(publish_pcs_);
+  auto subscribe_channels = ChannelSnapshot(subscribe_pcs_);
+  for (auto& session_id : session_ids) {
+    bool found = false;
+    for (auto& channel : *publish_channels) {
+      if (channel->GetSessionId() == session_id) {
+        publish_ids.push_back(session_id);
+        found = true;
+        break;
+      }
+    }
+    if (found) {
+      continue;
+    }
+    for (auto& channel : *subscribe_channels) {
+      if (channel->GetSessionId() == session_id) {
+        subscribe_ids.push_back(session_id);
+        found = true;
+        break;
+      }
+    }
+    if (!found) {
+      if (on_failure) {
+        event_queue_->PostTask([on_failure, session_id]() {
+          std::unique_ptr<Exception> e(
+              new Exception(ExceptionType::kConferenceUnknown,
+                            "Session " + session_id +
+                                " is not published or subscribed."));
+          on_failure(std::move(e));
+        });
+      }
+      return;
+    }
+  }
+  if (publish_ids.empty() && subscribe_ids.empty()) {
+    if (on_success) {
+      event_queue_->PostTask([on_success]() { on_success(); });
+    }
+    return;
+  }
+  // One bulk message per group; the batch succeeds when both groups are
+  // acknowledged and fails on the first group failure.
+  struct BulkProgress {
+    std::mutex mutex;
+    int remaining;
+    bool failed = false;
+  };
+  auto progress = std::make_shared<BulkProgress>();
+  progress->remaining =
+      (publish_ids.empty() ? 0 : 1) + (subscribe_ids.empty() ? 0 : 1);
+  auto finish_success = [progress, on_success]() {
+    bool done = false;
+    {
+      std::lock_guard<std::mutex> lock(progress->mutex);
+      progress->remaining--;
+      done = (progress->remaining == 0 && !progress->failed);
+    }
+    if (done && on_success) {
+      on_success();
+    }
+  };
+  auto finish_failure = [progress,
+                         on_failure](std::unique_ptr<Exception> e) {
+    bool first_failure = false;
+    {
+      std::lock_guard<std::mutex> lock(progress->mutex);
+      progress->remaining--;
+      first_failure = !progress->failed;
+      progress->failed = true;
+    }
+    if (first_failure && on_failure) {
+      on_failure(std::move(e));
+    }
+  };
+  if (!publish_ids.empty()) {
+    signaling_channel_->SendBulkStreamControlMessage(
+        publish_ids, action, operation, RunInEventQueue(finish_success),
+        finish_failure);
+  }
+  if (!subscribe_ids.empty()) {
+    signaling_channel_->SendBulkSubscriptionControlMessage(
+        subscribe_ids, action, operation, RunInEventQueue(finish_success),
+        finish_failure);
+  }
+}
+void ConferenceClient::Leave(
+    std::function<void()> on_success,
+    std::function<void(std::unique_ptr<Exception>)> on_failure) {
+  if (!CheckSignalingChannelOnline(on_failure)) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(publish_pcs_mutex_);
+    publish_id_label_map_.clear();
+  }
+  // Keep the channels alive past the list swap so their teardown can be
+  // taken off this thread.
+  auto publish_channels = ChannelSnapshot(publish_pcs_);
+  auto subscribe_channels = ChannelSnapshot(subscribe_pcs_);
+  ClearChannelList(publish_pcs_, publish_pcs_mutex_);
+  ClearChannelList(subscribe_pcs_, subscribe_pcs_mutex_);
+  // The disconnect below is the one message the server needs to drop
+  // every session, so each channel closes without its own
+  // unpublish/unsubscribe round trip.
+  std::vector<std::shared_ptr<ConferencePeerConnectionChannel>> channels(
+      publish_channels->begin(), publish_channels->end());
+  channels.insert(channels.end(), subscribe_channels->begin(),
+                  subscribe_channels->end());
+  for (auto& channel : channels) {
+    channel->CloseWithoutSignaling();
+  }
+  // Destroying a channel blocks on closing its connection and joining
+  // its connection thread, which used to make leaving a large room take
+  // seconds on the calling thread. Shard the final releases across
+  // detached threads so teardown runs in parallel and Leave returns as
+  // soon as the disconnect is queued.
+  if (!channels.empty()) {
+    const size_t kTeardownShards = 4;
+    size_t shard_count = (std::min)(kTeardownShards, channels.size());
+    for (size_t shard = 0; shard < shard_count; shard++) {
+      std::vector<std::shared_ptr<ConferencePeerConnectionChannel>> part;
+      for (size_t i = shard; i < channels.size(); i += shard_count) {
+        part.push_back(channels[i]);
+      }
+      std::thread([part]() mutable { part.clear(); }).detach();
+    }
+    channels.clear();
+  }
+  signaling_channel_->Disconnect(RunInEventQueue(on_success), on_failure);
+}
+void ConferenceClient::GetConnectionStats(
     const std::string& session_id,
-    std::function<void(const std::vector<const webrtc::StatsReport*>& reports)>
-        on_success,
+    std::function<void(std::shared_ptr<ConnectionStats>)> on_success,
     std::function<void(std::unique_ptr<Exception>)> on_failure) {
   auto pcc = GetConferencePeerConnectionChannel(session_id);
   if (pcc == nullptr) {
@@ -775,41 +1288,522 @@ void ConferenceClient::GetStats(
         << "Tried to get connection statistowt from unknown stream.";
     return;
   }
-  pcc->GetStats(on_success, on_failure);
-}
-void ConferenceClient::OnStreamAdded(sio::message::ptr stream) {
-  TriggerOnStreamAdded(stream);
+  pcc->GetConnectionStats(on_success, on_failure);
 }
-void ConferenceClient::OnCustomMessage(std::string& from,
-                                       std::string& message,
-                                       std::string& to) {
-  RTC_LOG(LS_INFO) << "ConferenceClient OnCustomMessage";
-  for (auto its = observers_.begin(); its != observers_.end(); ++its) {
-    (*its).get().OnMessageReceived(message, from, to);
+void ConferenceClient::GetAllConnectionStats(
+    std::function<
+        void(std::shared_ptr<
+             std::unordered_map<std::string, std::shared_ptr<ConnectionStats>>>)>
+        on_complete) {
+  if (on_complete == nullptr) {
+    return;
+  }
+  // Collect the channels from both snapshots first so the session count is
+  // known before any async stats request completes.
+  auto publish_channels = ChannelSnapshot(publish_pcs_);
+  auto subscribe_channels = ChannelSnapshot(subscribe_pcs_);
+  std::vector<std::shared_ptr<ConferencePeerConnectionChannel>> channels(
+      publish_channels->begin(), publish_channels->end());
+  channels.insert(channels.end(), subscribe_channels->begin(),
+                  subscribe_channels->end());
+  // Shared by the per-session callbacks; |on_complete| fires once when the
+  // last session reports, successful or not.
+  struct StatsAggregation {
+    std::mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<ConnectionStats>> stats;
+    size_t remaining;
+  };
+  auto aggregation = std::make_shared<StatsAggregation>();
+  aggregation->remaining = channels.size();
+  if (channels.empty()) {
+    event_queue_->PostTask([on_complete] {
+      on_complete(std::make_shared<
+                  std::unordered_map<std::string,
+                                     std::shared_ptr<ConnectionStats>>>());
+    });
+    return;
+  }
+  std::weak_ptr<ConferenceClient> weak_this = shared_from_this();
+  for (auto it = channels.begin(); it != channels.end(); ++it) {
+    std::string session_id = (*it)->GetSessionId();
+    auto finish_one = [weak_this, aggregation, on_complete] {
+      bool done = false;
+      {
+        std::lock_guard<std::mutex> lock(aggregation->mutex);
+        done = (--aggregation->remaining == 0);
+      }
+      if (!done) {
+        return;
+      }
+      auto that = weak_this.lock();
+      if (!that) {
+        return;
+      }
+      that->event_queue_->PostTask([aggregation, on_complete] {
+        on_complete(std::make_shared<
+                    std::unordered_map<std::string,
+                                       std::shared_ptr<ConnectionStats>>>(
+            std::move(aggregation->stats)));
+      });
+    };
+    (*it)->GetConnectionStats(
+        [aggregation, session_id,
+         finish_one](std::shared_ptr<ConnectionStats> stats) {
+          {
+            std::lock_guard<std::mutex> lock(aggregation->mutex);
+            aggregation->stats[session_id] = stats;
+          }
+          finish_one();
+        },
+        [finish_one](std::unique_ptr<Exception>) { finish_one(); });
   }
 }
-void ConferenceClient::OnSignalingMessage(sio::message::ptr message) {
-  // MCU returns inconsistent format for this event. :(
-  std::string stream_id = (message->get_map()["peerId"] == nullptr)
-                              ? message->get_map()["id"]->get_string()
-                              : message->get_map()["peerId"]->get_string();
-  // Check the status before delivering to pcc.
-  auto soac_status = message->get_map()["status"];
-  if (soac_status == nullptr ||
-      soac_status->get_flag() != sio::message::flag_string ||
-      (soac_status->get_string() != "soac" &&
-       soac_status->get_string() != "ready" &&
-       soac_status->get_string() != "error")) {
-    RTC_NOTREACHED();
-    RTC_LOG(LS_WARNING) << "Ignore signaling status except soac/ready/error.";
+void ConferenceClient::StartStatsSampling(int interval_ms) {
+  if (interval_ms <= 0) {
+    RTC_LOG(LS_WARNING) << "Ignored invalid stats sampling interval: "
+                        << interval_ms;
     return;
   }
-  auto pcc = GetConferencePeerConnectionChannel(stream_id);
-  if (pcc == nullptr) {
-    RTC_LOG(LS_WARNING) << "Received signaling message from unknown sender.";
+  std::lock_guard<std::mutex> lock(stats_sampling_mutex_);
+  stats_sampling_interval_ms_ = interval_ms;
+  if (stats_sampling_active_) {
+    // The running thread picks up the new interval on its next wakeup.
     return;
   }
-  if (soac_status->get_string() == "ready") {
+  if (stats_sampling_thread_.joinable()) {
+    stats_sampling_thread_.join();
+  }
+  stats_sampling_active_ = true;
+  stats_sampling_thread_ = std::thread([this] { StatsSamplingLoop(); });
+}
+void ConferenceClient::StopStatsSampling() {
+  std::thread sampler;
+  {
+    std::lock_guard<std::mutex> lock(stats_sampling_mutex_);
+    if (!stats_sampling_active_) {
+      return;
+    }
+    stats_sampling_active_ = false;
+    stats_sampling_cv_.notify_all();
+    sampler = std::move(stats_sampling_thread_);
+  }
+  if (sampler.joinable()) {
+    sampler.join();
+  }
+}
+std::shared_ptr<
+    const std::unordered_map<std::string, std::shared_ptr<ConnectionStats>>>
+ConferenceClient::GetSampledConnectionStats() {
+  return std::atomic_load(&sampled_stats_);
+}
+std::vector<uint8_t> ConferenceClient::ExportSampledStatsBinary() {
+  auto snapshot = std::atomic_load(&sampled_stats_);
+  if (snapshot == nullptr) {
+    return std::vector<uint8_t>();
+  }
+  return ColumnarStatsWriter::Serialize(*snapshot);
+}
+void ConferenceClient::StatsSamplingLoop() {
+  std::unique_lock<std::mutex> lock(stats_sampling_mutex_);
+  while (stats_sampling_active_) {
+    int interval_ms = stats_sampling_interval_ms_;
+    lock.unlock();
+    SampleConnectionStatsOnce();
+    lock.lock();
+    stats_sampling_cv_.wait_for(lock, std::chrono::milliseconds(interval_ms),
+                                [this] { return !stats_sampling_active_; });
+  }
+}
+void ConferenceClient::SampleConnectionStatsOnce() {
+  auto publish_channels = ChannelSnapshot(publish_pcs_);
+  auto subscribe_channels = ChannelSnapshot(subscribe_pcs_);
+  std::vector<std::shared_ptr<ConferencePeerConnectionChannel>> channels(
+      publish_channels->begin(), publish_channels->end());
+  channels.insert(channels.end(), subscribe_channels->begin(),
+                  subscribe_channels->end());
+  if (channels.empty()) {
+    std::atomic_store(&sampled_stats_,
+                      std::shared_ptr<const SampledStatsMap>(
+                          std::make_shared<SampledStatsMap>()));
+    return;
+  }
+  // Owned only by the per-session callbacks and this frame, so a report
+  // arriving after the sampler gave up still has somewhere safe to land.
+  struct Sample {
+    std::mutex mutex;
+    std::condition_variable cv;
+    SampledStatsMap stats;
+    size_t remaining;
+  };
+  auto sample = std::make_shared<Sample>();
+  sample->remaining = channels.size();
+  for (auto it = channels.begin(); it != channels.end(); ++it) {
+    std::string session_id = (*it)->GetSessionId();
+    (*it)->GetConnectionStats(
+        [sample, session_id](std::shared_ptr<ConnectionStats> stats) {
+          std::lock_guard<std::mutex> lock(sample->mutex);
+          sample->stats[session_id] = stats;
+          if (--sample->remaining == 0) {
+            sample->cv.notify_all();
+          }
+        },
+        [sample](std::unique_ptr<Exception>) {
+          std::lock_guard<std::mutex> lock(sample->mutex);
+          if (--sample->remaining == 0) {
+            sample->cv.notify_all();
+          }
+        });
+  }
+  // Bounded wait: a session torn down mid-sample must not wedge the
+  // sampler; its entry is simply absent from this snapshot.
+  std::unique_lock<std::mutex> lock(sample->mutex);
+  sample->cv.wait_for(lock, std::chrono::seconds(1),
+                      [&sample] { return sample->remaining == 0; });
+  auto snapshot = std::make_shared<SampledStatsMap>(std::move(sample->stats));
+  lock.unlock();
+  std::atomic_store(&sampled_stats_,
+                    std::shared_ptr<const SampledStatsMap>(std::move(snapshot)));
+}
+void ConferenceClient::StartBandwidthOrchestration(int interval_ms) {
+  if (interval_ms <= 0) {
+    RTC_LOG(LS_WARNING)
+        << "Ignored invalid bandwidth orchestration interval: " << interval_ms;
+    return;
+  }
+  std::lock_guard<std::mutex> lock(bandwidth_orchestration_mutex_);
+  bandwidth_orchestration_interval_ms_ = interval_ms;
+  if (bandwidth_orchestration_active_) {
+    // The running thread picks up the new interval on its next wakeup.
+    return;
+  }
+  if (bandwidth_orchestration_thread_.joinable()) {
+    bandwidth_orchestration_thread_.join();
+  }
+  bandwidth_orchestration_active_ = true;
+  bandwidth_orchestration_thread_ =
+      std::thread([this] { BandwidthOrchestrationLoop(); });
+}
+void ConferenceClient::StopBandwidthOrchestration() {
+  std::thread orchestrator;
+  {
+    std::lock_guard<std::mutex> lock(bandwidth_orchestration_mutex_);
+    if (!bandwidth_orchestration_active_) {
+      return;
+    }
+    bandwidth_orchestration_active_ = false;
+    bandwidth_orchestration_cv_.notify_all();
+    orchestrator = std::move(bandwidth_orchestration_thread_);
+  }
+  if (orchestrator.joinable()) {
+    orchestrator.join();
+  }
+  // Leave no orchestrated cap behind.
+  auto publish_channels = ChannelSnapshot(publish_pcs_);
+  for (auto& channel : *publish_channels) {
+    channel->SetMaxSendBitrateBps(0);
+  }
+}
+void ConferenceClient::BandwidthOrchestrationLoop() {
+  std::unique_lock<std::mutex> lock(bandwidth_orchestration_mutex_);
+  while (bandwidth_orchestration_active_) {
+    int interval_ms = bandwidth_orchestration_interval_ms_;
+    lock.unlock();
+    OrchestrateBandwidthOnce();
+    lock.lock();
+    bandwidth_orchestration_cv_.wait_for(
+        lock, std::chrono::milliseconds(interval_ms),
+        [this] { return !bandwidth_orchestration_active_; });
+  }
+}
+void ConferenceClient::OrchestrateBandwidthOnce() {
+  auto publish_channels = ChannelSnapshot(publish_pcs_);
+  if (publish_channels->size() < 2) {
+    // Nothing to arbitrate; hand the uplink back to the engine's own
+    // estimation and any configured caps.
+    for (auto& channel : *publish_channels) {
+      channel->SetMaxSendBitrateBps(0);
+    }
+    return;
+  }
+  // Bounded estimate gathering, same shape as SampleConnectionStatsOnce.
+  struct Estimates {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::unordered_map<std::string, int> bandwidth_bps;
+    size_t remaining;
+  };
+  auto estimates = std::make_shared<Estimates>();
+  estimates->remaining = publish_channels->size();
+  for (auto& channel : *publish_channels) {
+    std::string session_id = channel->GetSessionId();
+    channel->GetConnectionStats(
+        [estimates, session_id](std::shared_ptr<ConnectionStats> stats) {
+          std::lock_guard<std::mutex> lock(estimates->mutex);
+          estimates->bandwidth_bps[session_id] =
+              stats->video_bandwidth_stats.available_send_bandwidth;
+          if (--estimates->remaining == 0) {
+            estimates->cv.notify_all();
+          }
+        },
+        [estimates](std::unique_ptr<Exception>) {
+          std::lock_guard<std::mutex> lock(estimates->mutex);
+          if (--estimates->remaining == 0) {
+            estimates->cv.notify_all();
+          }
+        });
+  }
+  std::unordered_map<std::string, int> bandwidth_bps;
+  {
+    std::unique_lock<std::mutex> lock(estimates->mutex);
+    estimates->cv.wait_for(lock, std::chrono::seconds(1),
+                           [&estimates] { return estimates->remaining == 0; });
+    bandwidth_bps = estimates->bandwidth_bps;
+  }
+  // The connections share one bottleneck, so the sum of what their
+  // estimators are currently granted is the usable uplink; splitting that
+  // sum by weight redistributes the link each round without assuming any
+  // absolute capacity.
+  int64_t total_bps = 0;
+  int64_t total_weight = 0;
+  for (auto& channel : *publish_channels) {
+    auto it = bandwidth_bps.find(channel->GetSessionId());
+    if (it == bandwidth_bps.end() || it->second <= 0) {
+      // A session without an estimate this round keeps its current cap.
+      continue;
+    }
+    total_bps += it->second;
+    total_weight += channel->BandwidthPriority();
+  }
+  if (total_bps <= 0 || total_weight <= 0) {
+    return;
+  }
+  for (auto& channel : *publish_channels) {
+    auto it = bandwidth_bps.find(channel->GetSessionId());
+    if (it == bandwidth_bps.end() || it->second <= 0) {
+      continue;
+    }
+    int share_bps = static_cast<int>(total_bps * channel->BandwidthPriority() /
+                                     total_weight);
+    if (share_bps < kMinOrchestratedBitrateBps) {
+      share_bps = kMinOrchestratedBitrateBps;
+    }
+    channel->SetMaxSendBitrateBps(share_bps);
+  }
+}
+void ConferenceClient::StartAudioFocusControl(int max_active_streams,
+                                              int interval_ms) {
+  if (max_active_streams <= 0 || interval_ms <= 0) {
+    RTC_LOG(LS_WARNING) << "Ignored invalid audio focus parameters: "
+                        << max_active_streams << ", " << interval_ms;
+    return;
+  }
+  std::lock_guard<std::mutex> lock(audio_focus_mutex_);
+  audio_focus_max_active_ = max_active_streams;
+  audio_focus_interval_ms_ = interval_ms;
+  if (audio_focus_active_) {
+    // The running thread picks up the new parameters on its next wakeup.
+    return;
+  }
+  if (audio_focus_thread_.joinable()) {
+    audio_focus_thread_.join();
+  }
+  audio_focus_active_ = true;
+  audio_focus_thread_ = std::thread([this] { AudioFocusControlLoop(); });
+}
+void ConferenceClient::StopAudioFocusControl() {
+  std::thread controller;
+  {
+    std::lock_guard<std::mutex> lock(audio_focus_mutex_);
+    if (!audio_focus_active_) {
+      return;
+    }
+    audio_focus_active_ = false;
+    audio_focus_cv_.notify_all();
+    controller = std::move(audio_focus_thread_);
+  }
+  if (controller.joinable()) {
+    controller.join();
+  }
+  // No subscription stays muted by a controller that no longer runs.
+  auto subscribe_channels = ChannelSnapshot(subscribe_pcs_);
+  for (auto& channel : *subscribe_channels) {
+    channel->SetReceiveAudioTrackEnabled(true);
+  }
+}
+void ConferenceClient::SetAudioPlayoutGain(const std::string& session_id,
+                                           double gain) {
+  auto pcc = GetConferencePeerConnectionChannel(session_id);
+  if (pcc == nullptr) {
+    RTC_LOG(LS_WARNING) << "Tried to set playout gain on unknown session.";
+    return;
+  }
+  pcc->SetAudioPlayoutGain(gain);
+}
+void ConferenceClient::AudioFocusControlLoop() {
+  std::unique_lock<std::mutex> lock(audio_focus_mutex_);
+  while (audio_focus_active_) {
+    int interval_ms = audio_focus_interval_ms_;
+    lock.unlock();
+    ApplyAudioFocusOnce();
+    lock.lock();
+    audio_focus_cv_.wait_for(lock, std::chrono::milliseconds(interval_ms),
+                             [this] { return !audio_focus_active_; });
+  }
+}
+void ConferenceClient::ApplyAudioFocusOnce() {
+  int max_active;
+  {
+    std::lock_guard<std::mutex> lock(audio_focus_mutex_);
+    max_active = audio_focus_max_active_;
+  }
+  auto subscribe_channels = ChannelSnapshot(subscribe_pcs_);
+  if (static_cast<int>(subscribe_channels->size()) <= max_active) {
+    for (auto& channel : *subscribe_channels) {
+      channel->SetReceiveAudioTrackEnabled(true);
+    }
+    return;
+  }
+  // Bounded level gathering, same shape as the bandwidth orchestrator.
+  struct Levels {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::unordered_map<std::string, int32_t> level;
+    size_t remaining;
+  };
+  auto levels = std::make_shared<Levels>();
+  levels->remaining = subscribe_channels->size();
+  for (auto& channel : *subscribe_channels) {
+    std::string session_id = channel->GetSessionId();
+    channel->GetConnectionStats(
+        [levels, session_id](std::shared_ptr<ConnectionStats> stats) {
+          int32_t loudest = 0;
+          for (const auto& report : stats->audio_receiver_reports) {
+            if (report->audio_output_level > loudest) {
+              loudest = report->audio_output_level;
+            }
+          }
+          std::lock_guard<std::mutex> lock(levels->mutex);
+          levels->level[session_id] = loudest;
+          if (--levels->remaining == 0) {
+            levels->cv.notify_all();
+          }
+        },
+        [levels](std::unique_ptr<Exception>) {
+          std::lock_guard<std::mutex> lock(levels->mutex);
+          if (--levels->remaining == 0) {
+            levels->cv.notify_all();
+          }
+        });
+  }
+  std::unordered_map<std::string, int32_t> level;
+  {
+    std::unique_lock<std::mutex> lock(levels->mutex);
+    levels->cv.wait_for(lock, std::chrono::seconds(1),
+                        [&levels] { return levels->remaining == 0; });
+    level = levels->level;
+  }
+  // The |max_active| loudest sessions keep their audio; the rest are
+  // gated until they rank again. Sessions without a report this round
+  // stay enabled rather than being silenced on missing data.
+  std::vector<int32_t> ranked;
+  ranked.reserve(level.size());
+  for (const auto& entry : level) {
+    ranked.push_back(entry.second);
+  }
+  std::sort(ranked.begin(), ranked.end(), std::greater<int32_t>());
+  int32_t threshold =
+      static_cast<int>(ranked.size()) > max_active ? ranked[max_active - 1] : 0;
+  int enabled_count = 0;
+  for (auto& channel : *subscribe_channels) {
+    auto it = level.find(channel->GetSessionId());
+    if (it == level.end()) {
+      channel->SetReceiveAudioTrackEnabled(true);
+      continue;
+    }
+    bool enable = it->second >= threshold && enabled_count < max_active;
+    if (enable) {
+      enabled_count++;
+    }
+    channel->SetReceiveAudioTrackEnabled(enable);
+  }
+}
+void ConferenceClient::GetStats(
+    const std::string& session_id,
+    std::function<void(const std::vector<const webrtc::StatsReport*>& reports)>
+        on_success,
+    std::function<void(std::unique_ptr<Exception>)> on_failure) {
+  auto pcc = GetConferencePeerConnectionChannel(session_id);
+  if (pcc == nullptr) {
+    if (on_failure) {
+      event_queue_->PostTask([on_failure]() {
+        std::unique_ptr<Exception> e(
+            new Exception(ExceptionType::kConferenceUnknown,
+                          "Stream is not published or subscribed."));
+        on_failure(std::move(e));
+      });
+    }
+    RTC_LOG(LS_WARNING)
+        << "Tried to get connection statistowt from unknown stream.";
+    return;
+  }
+  pcc->GetStats(on_success, on_failure);
+}
+std::vector<MemoryStatsEntry> ConferenceClient::GetMemoryStats() {
+  return MemoryAccounting::Snapshot();
+}
+std::vector<QueueDepthEntry> ConferenceClient::GetQueueDepthStats() {
+  return QueueDepthGauges::Snapshot();
+}
+std::vector<ThreadLoadEntry> ConferenceClient::GetThreadLoadStats() {
+  return ThreadLoadMonitor::Snapshot();
+}
+void ConferenceClient::OnStreamAdded(sio::message::ptr stream) {
+  // Stream events are handled off the socket.io receive thread so a slow
+  // stream parse cannot delay the SDP and ICE messages delivered through
+  // OnSignalingMessage, which stay on the receive thread.
+  std::string id = StreamIdFromMessage(stream);
+  if (id.empty()) {
+    RTC_DCHECK(false);
+    return;
+  }
+  std::weak_ptr<ConferenceClient> weak_this = shared_from_this();
+  StreamEventQueue(id)->PostTask([weak_this, stream] {
+    auto that = weak_this.lock();
+    if (that)
+      that->TriggerOnStreamAdded(stream);
+  });
+}
+void ConferenceClient::OnCustomMessage(std::string& from,
+                                       std::string& message,
+                                       std::string& to) {
+  RTC_LOG(LS_INFO) << "ConferenceClient OnCustomMessage";
+  auto observers = std::atomic_load(&observers_);
+  for (auto its = observers->begin(); its != observers->end(); ++its) {
+    (*its).get().OnMessageReceived(message, from, to);
+  }
+}
+void ConferenceClient::OnSignalingMessage(sio::message::ptr message) {
+  // MCU returns inconsistent format for this event. :(
+  std::string stream_id = (message->get_map()["peerId"] == nullptr)
+                              ? message->get_map()["id"]->get_string()
+                              : message->get_map()["peerId"]->get_string();
+  // Check the status before delivering to pcc.
+  auto soac_status = message->get_map()["status"];
+  if (soac_status == nullptr ||
+      soac_status->get_flag() != sio::message::flag_string ||
+      (soac_status->get_string() != "soac" &&
+       soac_status->get_string() != "ready" &&
+       soac_status->get_string() != "error")) {
+    RTC_NOTREACHED();
+    RTC_LOG(LS_WARNING) << "Ignore signaling status except soac/ready/error.";
+    return;
+  }
+  auto pcc = GetConferencePeerConnectionChannel(stream_id);
+  if (pcc == nullptr) {
+    RTC_LOG(LS_WARNING) << "Received signaling message from unknown sender.";
+    return;
+  }
+  if (soac_status->get_string() == "ready") {
     sio::message::ptr success_msg = sio::string_message::create("success");
     pcc->OnSignalingMessage(success_msg);
     return;
@@ -830,10 +1824,29 @@ void ConferenceClient::OnSignalingMessage(sio::message::ptr message) {
 }
 void ConferenceClient::OnStreamRemoved(sio::message::ptr stream) {
   RTC_LOG(LS_INFO) << "Stream removed.";
-  TriggerOnStreamRemoved(stream);
+  std::string id = StreamIdFromMessage(stream);
+  if (id.empty()) {
+    RTC_DCHECK(false);
+    return;
+  }
+  std::weak_ptr<ConferenceClient> weak_this = shared_from_this();
+  StreamEventQueue(id)->PostTask([weak_this, id] {
+    auto that = weak_this.lock();
+    if (that)
+      that->TriggerOnStreamRemoved(id);
+  });
 }
 void ConferenceClient::OnStreamUpdated(sio::message::ptr stream) {
-  TriggerOnStreamUpdated(stream);
+  StreamUpdateEvent event;
+  if (!ParseStreamUpdate(stream, &event)) {
+    return;
+  }
+  std::weak_ptr<ConferenceClient> weak_this = shared_from_this();
+  StreamEventQueue(event.stream_id)->PostTask([weak_this, event] {
+    auto that = weak_this.lock();
+    if (that)
+      that->TriggerOnStreamUpdated(event);
+  });
 }
 // ConferencePeerConnectionChannel observer implemenation.
 void ConferenceClient::OnStreamError(sio::message::ptr stream) {
@@ -855,20 +1868,44 @@ void ConferenceClient::OnStreamError(sio::message::ptr stream) {
 }
 void ConferenceClient::OnServerDisconnected() {
   signaling_channel_connected_ = false;
+  channel_pool_active_ = false;
   {
     std::lock_guard<std::mutex> lock(publish_pcs_mutex_);
     publish_id_label_map_.clear();
-    publish_pcs_.clear();
   }
+  ClearChannelList(publish_pcs_, publish_pcs_mutex_);
   {
     std::lock_guard<std::mutex> lock(subscribe_pcs_mutex_);
-    subscribe_pcs_.clear();
     subscribe_id_label_map_.clear();
   }
-  for (auto its = observers_.begin(); its != observers_.end(); ++its) {
+  ClearChannelList(subscribe_pcs_, subscribe_pcs_mutex_);
+  {
+    std::lock_guard<std::mutex> lock(channel_pool_mutex_);
+    channel_pool_.clear();
+  }
+  auto observers = std::atomic_load(&observers_);
+  for (auto its = observers->begin(); its != observers->end(); ++its) {
     (*its).get().OnServerDisconnected();
   }
 }
+void ConferenceClient::OnServerReconnectionSucceeded() {
+  // Sessions survived on server side, so resume every publication and
+  // subscription with an ICE restart instead of a full renegotiation.
+  RTC_LOG(LS_INFO) << "Restart ICE for all sessions after reconnection.";
+  RestartIceForAllSessions();
+}
+void ConferenceClient::RestartIceForAllSessions() {
+  auto publish_channels = ChannelSnapshot(publish_pcs_);
+  for (auto it = publish_channels->begin(); it != publish_channels->end();
+       ++it) {
+    (*it)->IceRestart();
+  }
+  auto subscribe_channels = ChannelSnapshot(subscribe_pcs_);
+  for (auto it = subscribe_channels->begin(); it != subscribe_channels->end();
+       ++it) {
+    (*it)->IceRestart();
+  }
+}
 void ConferenceClient::OnStreamError(
     std::shared_ptr<Stream> stream,
     std::shared_ptr<const Exception> exception) {
@@ -878,7 +1915,8 @@ void ConferenceClient::OnStreamId(const std::string& id,
                                   const std::string& publish_stream_label) {
   {
     std::lock_guard<std::mutex> lock(publish_pcs_mutex_);
-    publish_id_label_map_[id] = publish_stream_label;
+    publish_id_label_map_[InternedString::Intern(id)] =
+        InternedString::Intern(publish_stream_label);
   }
   auto pcc = GetConferencePeerConnectionChannel(id);
   RTC_CHECK(pcc != nullptr);
@@ -887,21 +1925,33 @@ void ConferenceClient::OnSubscriptionId(const std::string& subscription_id,
                                         const std::string& stream_id) {
   {
     std::lock_guard<std::mutex> lock(subscribe_pcs_mutex_);
-    subscribe_id_label_map_[subscription_id] = stream_id;
+    subscribe_id_label_map_[InternedString::Intern(subscription_id)] =
+        InternedString::Intern(stream_id);
   }
   auto pcc = GetConferencePeerConnectionChannel(stream_id);
   RTC_CHECK(pcc != nullptr);
 }
 bool ConferenceClient::CheckNullPointer(
     uintptr_t pointer,
-    std::function<void(std::unique_ptr<Exception>)> on_failure) {
-  std::string failure_message = "Null pointer is not allowed.";
-  return CheckNullPointer(pointer, failure_message, on_failure);
+    const std::function<void(std::unique_ptr<Exception>)>& on_failure) {
+  if (pointer)
+    return true;
+  if (on_failure != nullptr) {
+    // The literal travels by pointer; no string is built unless the
+    // application asks the exception for one.
+    event_queue_->PostTask([on_failure]() {
+      std::unique_ptr<Exception> e(
+          new Exception(ExceptionType::kConferenceUnknown,
+                        "Null pointer is not allowed."));
+      on_failure(std::move(e));
+    });
+  }
+  return false;
 }
 bool ConferenceClient::CheckNullPointer(
     uintptr_t pointer,
     const std::string& failure_message,
-    std::function<void(std::unique_ptr<Exception>)> on_failure) {
+    const std::function<void(std::unique_ptr<Exception>)>& on_failure) {
   if (pointer)
     return true;
   if (on_failure != nullptr) {
@@ -914,7 +1964,7 @@ bool ConferenceClient::CheckNullPointer(
   return false;
 }
 bool ConferenceClient::CheckSignalingChannelOnline(
-    std::function<void(std::unique_ptr<Exception>)> on_failure) {
+    const std::function<void(std::unique_ptr<Exception>)>& on_failure) {
   if (signaling_channel_connected_)
     return true;
   if (on_failure != nullptr) {
@@ -927,69 +1977,20 @@ bool ConferenceClient::CheckSignalingChannelOnline(
   }
   return false;
 }
-void ConferenceClient::ParseStreamInfo(sio::message::ptr stream_info,
-                                       bool joining) {
-  std::string id = stream_info->get_map()["id"]->get_string();
-  std::string view("");
-  // owner_id here stands for participantID
-  std::string owner_id("");
-  std::string video_source("");
-  std::string audio_source("");
-  bool has_audio = false, has_video = false;
-  std::unordered_map<std::string, std::string> attributes;
-  auto media_info = stream_info->get_map()["media"];
-  if (media_info == nullptr ||
-      media_info->get_flag() != sio::message::flag_object) {
-    RTC_DCHECK(false);
-    RTC_LOG(LS_ERROR) << "Invalid media info from stream " << id
-                      << ", this stream will be ignored.";
-    return;
-  }
-  auto type = stream_info->get_map()["type"]->get_string();
-  if (type != "mixed" && type != "forward") {
-    RTC_LOG(LS_ERROR) << "Invalid stream type.";
-    return;
-  } else if (type == "mixed") {
-    // Get the view info for mixed stream.
-    auto view_info_obj = stream_info->get_map()["info"];
-    if (view_info_obj != nullptr &&
-        view_info_obj->get_flag() == sio::message::flag_object) {
-      auto label_obj = view_info_obj->get_map()["label"];
-      if (label_obj != nullptr &&
-          label_obj->get_flag() == sio::message::flag_string) {
-        view = label_obj->get_string();
-      }
-    }
-  } else if (type == "forward") {
-    // Get the stream attributes and owner id;
-    auto pub_info = stream_info->get_map()["info"];
-    if (pub_info == nullptr ||
-        pub_info->get_flag() != sio::message::flag_object) {
-      RTC_LOG(LS_ERROR) << "Invalid publication info from stream " << id
-                        << ", this stream will be ignored";
-      return;
-    }
-    owner_id = pub_info->get_map()["owner"]->get_string();
-    attributes = AttributesFromStreamInfo(pub_info);
-  }
-  SubscriptionCapabilities subscription_capabilities;
-  PublicationSettings publication_settings;
+bool ConferenceClient::ParseStreamCapabilities(
+    sio::message::ptr media_info,
+    SubscriptionCapabilities& subscription_capabilities,
+    PublicationSettings& publication_settings) {
   auto audio_info = media_info->get_map()["audio"];
   if (audio_info == nullptr ||
       audio_info->get_flag() != sio::message::flag_object) {
-    RTC_LOG(LS_INFO) << "No audio in stream " << id;
+    RTC_LOG(LS_INFO) << "No audio in stream media info.";
   } else {
-    // Parse the VideoInfo structure.
-    auto audio_source_obj = audio_info->get_map()["source"];
-    if (audio_source_obj != nullptr &&
-        audio_source_obj->get_flag() == sio::message::flag_string) {
-      audio_source = audio_source_obj->get_string();
-    }
     auto audio_format_obj = audio_info->get_map()["format"];
     if (audio_format_obj == nullptr ||
         audio_format_obj->get_flag() != sio::message::flag_object) {
       RTC_LOG(LS_ERROR) << "Invalid audio format info in media info";
-      return;
+      return false;
     }
     // Main audio capability
     std::string codec;
@@ -1000,9 +2001,8 @@ void ConferenceClient::ParseStreamInfo(sio::message::ptr stream_info,
     if (codec_obj == nullptr ||
         codec_obj->get_flag() != sio::message::flag_string) {
       RTC_LOG(LS_ERROR) << "codec name in optional audio info invalid.";
-      return;
+      return false;
     }
-    has_audio = true;
     codec = codec_obj->get_string();
     if (sample_rate_obj != nullptr)
       sample_rate = sample_rate_obj->get_int();
@@ -1033,7 +2033,7 @@ void ConferenceClient::ParseStreamInfo(sio::message::ptr stream_info,
           if (optional_codec_obj == nullptr ||
               optional_codec_obj->get_flag() != sio::message::flag_string) {
             RTC_LOG(LS_ERROR) << "codec name in optional audio info invalid.";
-            return;
+            return false;
           }
           codec = optional_codec_obj->get_string();
           if (codec == "nellymoser") {
@@ -1055,19 +2055,12 @@ void ConferenceClient::ParseStreamInfo(sio::message::ptr stream_info,
       video_info->get_flag() != sio::message::flag_object) {
     RTC_LOG(LS_INFO) << "No audio info in the media info";
   } else {
-    // Parse the VideoInfo structure.
-    auto video_source_obj = video_info->get_map()["source"];
-    if (video_source_obj != nullptr &&
-        video_source_obj->get_flag() == sio::message::flag_string) {
-      video_source = video_source_obj->get_string();
-    }
     auto video_format_obj = video_info->get_map()["format"];
     if (video_format_obj == nullptr ||
         video_format_obj->get_flag() != sio::message::flag_object) {
       RTC_LOG(LS_ERROR) << "Invalid video format info.";
-      return;
+      return false;
     } else {
-      has_video = true;
       VideoSubscriptionCapabilities video_subscription_capabilities;
       // Parse the video publication settings.
       std::string codec_name =
@@ -1198,6 +2191,179 @@ void ConferenceClient::ParseStreamInfo(sio::message::ptr stream_info,
       }
     }
   }
+  return true;
+}
+void ConferenceClient::ParseStreamInfo(sio::message::ptr stream_info,
+                                       bool joining) {
+  // The payload comes off the wire; required fields are verified before
+  // use rather than assumed.
+  if (stream_info == nullptr ||
+      stream_info->get_flag() != sio::message::flag_object) {
+    RTC_LOG(LS_ERROR) << "Invalid stream info, this stream will be ignored.";
+    return;
+  }
+  auto id_obj = stream_info->get_map()["id"];
+  if (id_obj == nullptr || id_obj->get_flag() != sio::message::flag_string) {
+    RTC_LOG(LS_ERROR) << "Stream info without a valid id, this stream will "
+                         "be ignored.";
+    return;
+  }
+  std::string id = id_obj->get_string();
+  // One shared copy of the UUID for every map key and callback below.
+  InternedString interned_id = InternedString::Intern(id);
+  std::string view("");
+  // owner_id here stands for participantID
+  std::string owner_id("");
+  std::string video_source("");
+  std::string audio_source("");
+  bool has_audio = false, has_video = false;
+  std::shared_ptr<const std::unordered_map<std::string, std::string>>
+      attributes;
+  auto media_info = stream_info->get_map()["media"];
+  if (media_info == nullptr ||
+      media_info->get_flag() != sio::message::flag_object) {
+    RTC_LOG(LS_ERROR) << "Invalid media info from stream " << id
+                      << ", this stream will be ignored.";
+    return;
+  }
+  // Fingerprint of the whole serialized stream info; used as the
+  // validation token for |stream_info_cache_| across leave/rejoin.
+  uint64_t fingerprint = FingerprintSioMessage(stream_info);
+  auto type_obj = stream_info->get_map()["type"];
+  if (type_obj == nullptr ||
+      type_obj->get_flag() != sio::message::flag_string) {
+    RTC_LOG(LS_ERROR) << "Invalid stream type.";
+    return;
+  }
+  auto type = type_obj->get_string();
+  if (type != "mixed" && type != "forward") {
+    RTC_LOG(LS_ERROR) << "Invalid stream type.";
+    return;
+  } else if (type == "mixed") {
+    // Get the view info for mixed stream.
+    auto view_info_obj = stream_info->get_map()["info"];
+    if (view_info_obj != nullptr &&
+        view_info_obj->get_flag() == sio::message::flag_object) {
+      auto label_obj = view_info_obj->get_map()["label"];
+      if (label_obj != nullptr &&
+          label_obj->get_flag() == sio::message::flag_string) {
+        view = label_obj->get_string();
+      }
+    }
+  } else if (type == "forward") {
+    // Get the stream attributes and owner id;
+    auto pub_info = stream_info->get_map()["info"];
+    if (pub_info == nullptr ||
+        pub_info->get_flag() != sio::message::flag_object) {
+      RTC_LOG(LS_ERROR) << "Invalid publication info from stream " << id
+                        << ", this stream will be ignored";
+      return;
+    }
+    auto owner_obj = pub_info->get_map()["owner"];
+    if (owner_obj == nullptr ||
+        owner_obj->get_flag() != sio::message::flag_string) {
+      RTC_LOG(LS_ERROR) << "Stream " << id
+                        << " carries no owner, this stream will be ignored.";
+      return;
+    }
+    owner_id = owner_obj->get_string();
+    {
+      std::lock_guard<std::mutex> lock(stream_info_cache_mutex_);
+      auto cached = stream_info_cache_.find(interned_id);
+      if (cached != stream_info_cache_.end() &&
+          cached->second.fingerprint == fingerprint) {
+        // Unchanged since the last session; the attribute map is
+        // immutable and can be shared.
+        attributes = cached->second.attributes;
+      }
+    }
+    if (!attributes) {
+      attributes = AttributesFromStreamInfo(pub_info);
+    }
+  }
+  // (Re)seed the cache entry for this stream. A changed fingerprint
+  // replaces the entry, which also invalidates cached capabilities.
+  {
+    std::lock_guard<std::mutex> lock(stream_info_cache_mutex_);
+    auto cached = stream_info_cache_.find(interned_id);
+    if (cached == stream_info_cache_.end() ||
+        cached->second.fingerprint != fingerprint) {
+      if (stream_info_cache_.size() >= kMaxCachedStreamInfos)
+        stream_info_cache_.clear();
+      CachedStreamInfo entry;
+      entry.fingerprint = fingerprint;
+      entry.attributes = attributes;
+      entry.capabilities_valid = false;
+      stream_info_cache_[interned_id] = entry;
+    }
+  }
+  SubscriptionCapabilities subscription_capabilities;
+  PublicationSettings publication_settings;
+  // Only the cheap top-level fields are read here. Format and parameter
+  // lists are parsed on first access to the stream's Capabilities() or
+  // Settings(); joining a large room would otherwise spend most of its
+  // time building capability vectors that may never be read.
+  auto audio_info = media_info->get_map()["audio"];
+  if (audio_info == nullptr ||
+      audio_info->get_flag() != sio::message::flag_object) {
+    RTC_LOG(LS_INFO) << "No audio in stream " << id;
+  } else {
+    auto audio_source_obj = audio_info->get_map()["source"];
+    if (audio_source_obj != nullptr &&
+        audio_source_obj->get_flag() == sio::message::flag_string) {
+      audio_source = audio_source_obj->get_string();
+    }
+    auto audio_format_obj = audio_info->get_map()["format"];
+    has_audio = audio_format_obj != nullptr &&
+                audio_format_obj->get_flag() == sio::message::flag_object &&
+                audio_format_obj->get_map()["codec"] != nullptr;
+  }
+  auto video_info = media_info->get_map()["video"];
+  if (video_info == nullptr ||
+      video_info->get_flag() != sio::message::flag_object) {
+    RTC_LOG(LS_INFO) << "No video info in the media info";
+  } else {
+    auto video_source_obj = video_info->get_map()["source"];
+    if (video_source_obj != nullptr &&
+        video_source_obj->get_flag() == sio::message::flag_string) {
+      video_source = video_source_obj->get_string();
+    }
+    auto video_format_obj = video_info->get_map()["format"];
+    has_video = video_format_obj != nullptr &&
+                video_format_obj->get_flag() == sio::message::flag_object;
+  }
+  std::function<void(RemoteStream&)> capability_parser(
+      [this, interned_id, fingerprint, media_info](RemoteStream& stream) {
+        {
+          std::lock_guard<std::mutex> lock(stream_info_cache_mutex_);
+          auto cached = stream_info_cache_.find(interned_id);
+          if (cached != stream_info_cache_.end() &&
+              cached->second.fingerprint == fingerprint &&
+              cached->second.capabilities_valid) {
+            stream.subscription_capabilities_ =
+                cached->second.subscription_capabilities;
+            stream.publication_settings_ =
+                cached->second.publication_settings;
+            return;
+          }
+        }
+        SubscriptionCapabilities subscription_capabilities;
+        PublicationSettings publication_settings;
+        if (ParseStreamCapabilities(media_info, subscription_capabilities,
+                                    publication_settings)) {
+          stream.subscription_capabilities_ = subscription_capabilities;
+          stream.publication_settings_ = publication_settings;
+          std::lock_guard<std::mutex> lock(stream_info_cache_mutex_);
+          auto cached = stream_info_cache_.find(interned_id);
+          if (cached != stream_info_cache_.end() &&
+              cached->second.fingerprint == fingerprint) {
+            cached->second.subscription_capabilities =
+                subscription_capabilities;
+            cached->second.publication_settings = publication_settings;
+            cached->second.capabilities_valid = true;
+          }
+        }
+      });
   // Now that all information needed for PublicationSettings and
   // SubscriptionCapabilities have been gathered, we construct remote streams.
   bool updated = false;
@@ -1215,18 +2381,23 @@ void ConferenceClient::ParseStreamInfo(sio::message::ptr stream_info,
     if (video_source != "screen-cast") {
       auto remote_stream = std::make_shared<RemoteStream>(
           id, owner_id, subscription_capabilities, publication_settings);
+      remote_stream->pending_capability_parser_ = capability_parser;
       remote_stream->has_audio_ = has_audio;
       remote_stream->has_video_ = has_video;
       remote_stream->Attributes(attributes);
       remote_stream->source_.audio = audio_source_info;
       remote_stream->source_.video = video_source_info;
-      added_streams_[id] = remote_stream;
-      added_stream_type_[id] = StreamType::kStreamTypeCamera;
+      {
+        std::lock_guard<std::mutex> lock(added_streams_mutex_);
+        added_streams_[interned_id] = remote_stream;
+        added_stream_type_[interned_id] = StreamType::kStreamTypeCamera;
+      }
       {
         const std::lock_guard<std::mutex> lock(stream_update_observer_mutex_);
         current_conference_info_->AddOrUpdateStream(remote_stream, updated);
         if (!joining && !updated) {
-          for (auto its = observers_.begin(); its != observers_.end(); ++its) {
+          auto observers = std::atomic_load(&observers_);
+          for (auto its = observers->begin(); its != observers->end(); ++its) {
             auto& o = (*its).get();
             event_queue_->PostTask(
                 [&o, remote_stream] { o.OnStreamAdded(remote_stream); });
@@ -1236,19 +2407,24 @@ void ConferenceClient::ParseStreamInfo(sio::message::ptr stream_info,
     } else {
       auto remote_stream = std::make_shared<RemoteStream>(
           id, owner_id, subscription_capabilities, publication_settings);
+      remote_stream->pending_capability_parser_ = capability_parser;
       RTC_LOG(LS_INFO) << "OnStreamAdded: screen stream.";
       remote_stream->has_audio_ = has_audio;
       remote_stream->has_video_ = true;
       remote_stream->Attributes(attributes);
       remote_stream->source_.audio = audio_source_info;
       remote_stream->source_.video = video_source_info;
-      added_streams_[id] = remote_stream;
-      added_stream_type_[id] = StreamType::kStreamTypeScreen;
+      {
+        std::lock_guard<std::mutex> lock(added_streams_mutex_);
+        added_streams_[interned_id] = remote_stream;
+        added_stream_type_[interned_id] = StreamType::kStreamTypeScreen;
+      }
       {
         const std::lock_guard<std::mutex> lock(stream_update_observer_mutex_);
         current_conference_info_->AddOrUpdateStream(remote_stream, updated);
         if (!joining && !updated) {
-          for (auto its = observers_.begin(); its != observers_.end(); ++its) {
+          auto observers = std::atomic_load(&observers_);
+          for (auto its = observers->begin(); its != observers->end(); ++its) {
             auto& o = (*its).get();
             event_queue_->PostTask(
                 [&o, remote_stream] { o.OnStreamAdded(remote_stream); });
@@ -1261,18 +2437,23 @@ void ConferenceClient::ParseStreamInfo(sio::message::ptr stream_info,
     owner_id = "mcu";
     auto remote_stream = std::make_shared<RemoteMixedStream>(
         id, owner_id, view, subscription_capabilities, publication_settings);
+    remote_stream->pending_capability_parser_ = capability_parser;
     RTC_LOG(LS_INFO) << "OnStreamAdded: mixed stream.";
     remote_stream->has_audio_ = has_audio;
     remote_stream->has_video_ = has_video;
     remote_stream->source_.audio = AudioSourceInfo::kMixed;
     remote_stream->source_.video = VideoSourceInfo::kMixed;
-    added_streams_[id] = remote_stream;
-    added_stream_type_[id] = StreamType::kStreamTypeMix;
+    {
+      std::lock_guard<std::mutex> lock(added_streams_mutex_);
+      added_streams_[interned_id] = remote_stream;
+      added_stream_type_[interned_id] = StreamType::kStreamTypeMix;
+    }
     {
       const std::lock_guard<std::mutex> lock(stream_update_observer_mutex_);
       current_conference_info_->AddOrUpdateStream(remote_stream, updated);
       if (!joining) {
-        for (auto its = observers_.begin(); its != observers_.end(); ++its) {
+        auto observers = std::atomic_load(&observers_);
+        for (auto its = observers->begin(); its != observers->end(); ++its) {
           auto& o = (*its).get();
           event_queue_->PostTask(
               [&o, remote_stream] { o.OnStreamAdded(remote_stream); });
@@ -1287,13 +2468,28 @@ void ConferenceClient::TriggerOnStreamAdded(sio::message::ptr stream_info,
 }
 void ConferenceClient::TriggerOnUserJoined(sio::message::ptr user_info,
                                            bool joining) {
+  if (joining) {
+    // The join roster can be huge; store the raw info and let
+    // ConferenceInfo build the Participant when it is first looked up, so
+    // the join cost does not grow with the room size.
+    if (user_info == nullptr ||
+        user_info->get_flag() != sio::message::flag_object ||
+        user_info->get_map()["id"] == nullptr ||
+        user_info->get_map()["id"]->get_flag() != sio::message::flag_string) {
+      RTC_DCHECK(false);
+      return;
+    }
+    current_conference_info_->AddPendingParticipant(
+        user_info->get_map()["id"]->get_string(), user_info);
+    return;
+  }
   Participant* user_raw;
   if (ParseUser(user_info, &user_raw)) {
     std::shared_ptr<Participant> user(user_raw);
     current_conference_info_->AddParticipant(user);
     if (!joining) {
-      const std::lock_guard<std::mutex> lock(observer_mutex_);
-      for (auto its = observers_.begin(); its != observers_.end(); ++its) {
+      auto observers = std::atomic_load(&observers_);
+      for (auto its = observers->begin(); its != observers->end(); ++its) {
         auto& o = (*its).get();
         event_queue_->PostTask([&o, user] { o.OnParticipantJoined(user); });
       }
@@ -1311,7 +2507,7 @@ void ConferenceClient::TriggerOnUserLeft(sio::message::ptr user_info) {
   current_conference_info_->RemoveParticipantById(user_id);
 }
 bool ConferenceClient::ParseUser(sio::message::ptr user_message,
-                                 Participant** participant) const {
+                                 Participant** participant) {
   if (user_message == nullptr ||
       user_message->get_flag() != sio::message::flag_object ||
       user_message->get_map()["id"] == nullptr ||
@@ -1322,7 +2518,9 @@ bool ConferenceClient::ParseUser(sio::message::ptr user_message,
       user_message->get_map()["role"] == nullptr ||
       user_message->get_map()["role"]->get_flag() !=
           sio::message::flag_string) {
-    RTC_DCHECK(false);
+    // Malformed server payloads must not assert: this parser is also
+    // exercised with intentionally broken inputs by the fuzz target.
+    RTC_LOG(LS_ERROR) << "Invalid user message.";
     return false;
   }
   std::string id = user_message->get_map()["id"]->get_string();
@@ -1331,36 +2529,207 @@ bool ConferenceClient::ParseUser(sio::message::ptr user_message,
   *participant = new Participant(id, role, user_name);
   return true;
 }
+rtc::TaskQueue* ConferenceClient::StreamEventQueue(
+    const std::string& stream_id) {
+  return stream_event_queues_[std::hash<std::string>()(stream_id) %
+                              stream_event_queues_.size()]
+      .get();
+}
+std::string ConferenceClient::StreamIdFromMessage(
+    sio::message::ptr stream_info) {
+  if (stream_info == nullptr ||
+      stream_info->get_flag() != sio::message::flag_object) {
+    return "";
+  }
+  auto id_obj = stream_info->get_map()["id"];
+  if (id_obj == nullptr || id_obj->get_flag() != sio::message::flag_string) {
+    return "";
+  }
+  return id_obj->get_string();
+}
 std::shared_ptr<ConferencePeerConnectionChannel>
 ConferenceClient::GetConferencePeerConnectionChannel(
     const std::string& session_id) const {
   {
-    std::lock_guard<std::mutex> lock(subscribe_pcs_mutex_);
-    // Search subscribe pcs.
+    // One lock-free hash lookup resolves a session that has routed
+    // before, so media events scale with subscription count instead of
+    // scanning both lists each time. A channel's session ID can change
+    // once the server assigns the final one, so a hit is verified and a
+    // stale entry treated as a miss.
+    std::shared_ptr<const SessionRoutingMap> routes =
+        std::atomic_load(&session_routing_);
+    auto it = routes->find(session_id);
+    if (it != routes->end()) {
+      if (it->second->GetSessionId() == session_id) {
+        return it->second;
+      }
+      // The key predates the server-assigned session ID; drop it so the
+      // entry does not pin the channel.
+      ForgetSessionRoute(session_id);
+    }
+  }
+  {
+    // Search subscribe pcs on a lock-free snapshot. Stats polling and
+    // signaling events land here frequently, so they must not contend
+    // with Subscribe/UnSubscribe holding the list mutex.
+    std::shared_ptr<const ChannelList> subscribe_pcs =
+        ChannelSnapshot(subscribe_pcs_);
     auto it = std::find_if(
-        subscribe_pcs_.begin(), subscribe_pcs_.end(),
+        subscribe_pcs->begin(), subscribe_pcs->end(),
         [&](std::shared_ptr<ConferencePeerConnectionChannel> o) -> bool {
           return o->GetSessionId() == session_id;
         });
-    if (it != subscribe_pcs_.end()) {
+    if (it != subscribe_pcs->end()) {
+      MemoizeSessionRoute(session_id, *it);
       return *it;
     }
   }
   {
-    std::lock_guard<std::mutex> lock(publish_pcs_mutex_);
     // Search publish pcs
+    std::shared_ptr<const ChannelList> publish_pcs =
+        ChannelSnapshot(publish_pcs_);
     auto it = std::find_if(
-        publish_pcs_.begin(), publish_pcs_.end(),
+        publish_pcs->begin(), publish_pcs->end(),
         [&](std::shared_ptr<ConferencePeerConnectionChannel> o) -> bool {
           return o->GetSessionId() == session_id;
         });
-    if (it != publish_pcs_.end()) {
+    if (it != publish_pcs->end()) {
+      MemoizeSessionRoute(session_id, *it);
       return *it;
     }
   }
   RTC_LOG(LS_ERROR) << "Cannot find PeerConnectionChannel for specific session";
   return nullptr;
 }
+void ConferenceClient::MemoizeSessionRoute(
+    const std::string& session_id,
+    std::shared_ptr<ConferencePeerConnectionChannel> channel) const {
+  std::lock_guard<std::mutex> lock(session_routing_mutex_);
+  std::shared_ptr<SessionRoutingMap> new_routes(
+      std::make_shared<SessionRoutingMap>(*std::atomic_load(&session_routing_)));
+  (*new_routes)[session_id] = std::move(channel);
+  std::atomic_store(&session_routing_, std::shared_ptr<const SessionRoutingMap>(
+                                           std::move(new_routes)));
+}
+void ConferenceClient::ForgetSessionRoute(const std::string& session_id) const {
+  std::lock_guard<std::mutex> lock(session_routing_mutex_);
+  std::shared_ptr<const SessionRoutingMap> routes =
+      std::atomic_load(&session_routing_);
+  if (routes->find(session_id) == routes->end()) {
+    return;
+  }
+  std::shared_ptr<SessionRoutingMap> new_routes(
+      std::make_shared<SessionRoutingMap>(*routes));
+  new_routes->erase(session_id);
+  std::atomic_store(&session_routing_, std::shared_ptr<const SessionRoutingMap>(
+                                           std::move(new_routes)));
+}
+void ConferenceClient::ClearSessionRoutes() {
+  std::lock_guard<std::mutex> lock(session_routing_mutex_);
+  std::atomic_store(&session_routing_,
+                    std::shared_ptr<const SessionRoutingMap>(
+                        std::make_shared<SessionRoutingMap>()));
+}
+std::shared_ptr<const ConferenceClient::ChannelList>
+ConferenceClient::ChannelSnapshot(
+    const std::shared_ptr<const ChannelList>& list) {
+  return std::atomic_load(&list);
+}
+void ConferenceClient::AddToChannelList(
+    std::shared_ptr<const ChannelList>& list,
+    std::mutex& mutex,
+    std::shared_ptr<ConferencePeerConnectionChannel> channel) {
+  std::lock_guard<std::mutex> lock(mutex);
+  std::shared_ptr<ChannelList> new_list(
+      std::make_shared<ChannelList>(*std::atomic_load(&list)));
+  new_list->push_back(channel);
+  std::atomic_store(&list,
+                    std::shared_ptr<const ChannelList>(std::move(new_list)));
+}
+void ConferenceClient::RemoveFromChannelList(
+    std::shared_ptr<const ChannelList>& list,
+    std::mutex& mutex,
+    const std::string& session_id) {
+  std::lock_guard<std::mutex> lock(mutex);
+  std::shared_ptr<ChannelList> new_list(
+      std::make_shared<ChannelList>(*std::atomic_load(&list)));
+  auto it = std::find_if(
+      new_list->begin(), new_list->end(),
+      [&](std::shared_ptr<ConferencePeerConnectionChannel> o) -> bool {
+        return o->GetSessionId() == session_id;
+      });
+  if (it == new_list->end()) {
+    return;
+  }
+  new_list->erase(it);
+  std::atomic_store(&list,
+                    std::shared_ptr<const ChannelList>(std::move(new_list)));
+  ForgetSessionRoute(session_id);
+}
+void ConferenceClient::ClearChannelList(
+    std::shared_ptr<const ChannelList>& list,
+    std::mutex& mutex) {
+  std::lock_guard<std::mutex> lock(mutex);
+  std::atomic_store(
+      &list,
+      std::shared_ptr<const ChannelList>(std::make_shared<ChannelList>()));
+  // Clears happen on leave/disconnect where both lists go; dropping the
+  // whole routing cache with them keeps no channel alive through a
+  // stale route.
+  ClearSessionRoutes();
+}
+std::shared_ptr<ConferencePeerConnectionChannel>
+ConferenceClient::CreateChannel(PeerConnectionChannelConfiguration config,
+                                bool default_configuration) {
+  if (default_configuration &&
+      configuration_.prewarmed_connection_pool_size > 0) {
+    std::shared_ptr<ConferencePeerConnectionChannel> pcc;
+    {
+      std::lock_guard<std::mutex> lock(channel_pool_mutex_);
+      if (!channel_pool_.empty()) {
+        pcc = channel_pool_.back();
+        channel_pool_.pop_back();
+      }
+    }
+    if (pcc != nullptr) {
+      RefillChannelPool();
+      return pcc;
+    }
+  }
+  return std::shared_ptr<ConferencePeerConnectionChannel>(
+      new ConferencePeerConnectionChannel(std::move(config),
+                                          signaling_channel_, event_queue_));
+}
+void ConferenceClient::RefillChannelPool() {
+  if (configuration_.prewarmed_connection_pool_size <= 0)
+    return;
+  std::weak_ptr<ConferenceClient> weak_this = shared_from_this();
+  event_queue_->PostTask([weak_this]() {
+    auto that = weak_this.lock();
+    if (!that || !that->channel_pool_active_)
+      return;
+    while (true) {
+      {
+        std::lock_guard<std::mutex> lock(that->channel_pool_mutex_);
+        if (static_cast<int>(that->channel_pool_.size()) >=
+            that->configuration_.prewarmed_connection_pool_size)
+          return;
+      }
+      // The expensive part of channel construction - PeerConnection
+      // setup and certificate generation in InitializePeerConnection -
+      // runs here on the event queue instead of on a Publish/Subscribe
+      // call.
+      PeerConnectionChannelConfiguration config =
+          that->GetPeerConnectionChannelConfiguration();
+      std::shared_ptr<ConferencePeerConnectionChannel> pcc(
+          new ConferencePeerConnectionChannel(std::move(config),
+                                              that->signaling_channel_,
+                                              that->event_queue_));
+      std::lock_guard<std::mutex> lock(that->channel_pool_mutex_);
+      that->channel_pool_.push_back(pcc);
+    }
+  });
+}
 PeerConnectionChannelConfiguration
 ConferenceClient::GetPeerConnectionChannelConfiguration() const {
   PeerConnectionChannelConfiguration config;
@@ -1383,6 +2752,9 @@ ConferenceClient::GetPeerConnectionChannelConfiguration() const {
                 kCandidateNetworkPolicyAll;
   config.continual_gathering_policy =
       PeerConnectionInterface::ContinualGatheringPolicy::GATHER_CONTINUALLY;
+  // Pre-gathered allocations let the first offer go out with candidates
+  // already in hand; see ClientConfiguration::ice_candidate_pool_size.
+  config.ice_candidate_pool_size = configuration_.ice_candidate_pool_size;
   return config;
 }
 void ConferenceClient::OnUserJoined(std::shared_ptr<sio::message> user) {
@@ -1391,109 +2763,266 @@ void ConferenceClient::OnUserJoined(std::shared_ptr<sio::message> user) {
 void ConferenceClient::OnUserLeft(std::shared_ptr<sio::message> user) {
   TriggerOnUserLeft(user);
 }
-void ConferenceClient::TriggerOnStreamRemoved(sio::message::ptr stream_info) {
-  std::string id = stream_info->get_map()["id"]->get_string();
-  auto stream_it = added_streams_.find(id);
-  auto stream_type = added_stream_type_.find(id);
-  if (stream_it == added_streams_.end() ||
-      stream_type == added_stream_type_.end()) {
-    RTC_LOG(LS_WARNING) << "Invalid stream or type.";
-    return;
+void ConferenceClient::TriggerOnStreamRemoved(const std::string& id) {
+  {
+    std::lock_guard<std::mutex> lock(added_streams_mutex_);
+    InternedString interned_id = InternedString::Intern(id);
+    auto stream_it = added_streams_.find(interned_id);
+    auto stream_type = added_stream_type_.find(interned_id);
+    if (stream_it == added_streams_.end() ||
+        stream_type == added_stream_type_.end()) {
+      RTC_LOG(LS_WARNING) << "Invalid stream or type.";
+      return;
+    }
+    added_streams_.erase(stream_it);
+    added_stream_type_.erase(stream_type);
   }
-  added_streams_.erase(stream_it);
-  added_stream_type_.erase(stream_type);
   current_conference_info_->TriggerOnStreamEnded(id);
   current_conference_info_->RemoveStreamById(id);
-  const std::lock_guard<std::mutex> lock(stream_update_observer_mutex_);
-  for (auto its = stream_update_observers_.begin();
-       its != stream_update_observers_.end(); ++its) {
+  auto stream_update_observers = std::atomic_load(&stream_update_observers_);
+  for (auto its = stream_update_observers->begin();
+       its != stream_update_observers->end(); ++its) {
     (*its).get().OnStreamRemoved(id);
   }
 }
 void ConferenceClient::TriggerOnStreamError(
     std::shared_ptr<Stream> stream,
     std::shared_ptr<const Exception> exception) {
-  const std::lock_guard<std::mutex> lock(stream_update_observer_mutex_);
-  for (auto its = stream_update_observers_.begin();
-       its != stream_update_observers_.end(); ++its) {
+  auto stream_update_observers = std::atomic_load(&stream_update_observers_);
+  for (auto its = stream_update_observers->begin();
+       its != stream_update_observers->end(); ++its) {
     (*its).get().OnStreamError(exception->Message());
   }
 }
 
-void ConferenceClient::TriggerOnStreamUpdated(sio::message::ptr stream_info) {
+bool ConferenceClient::ParseStreamUpdate(sio::message::ptr stream_info,
+                                         StreamUpdateEvent* event) {
   if (!(stream_info && stream_info->get_flag() == sio::message::flag_object &&
         stream_info->get_map()["id"] && stream_info->get_map()["event"] &&
         stream_info->get_map()["id"]->get_flag() == sio::message::flag_string &&
         stream_info->get_map()["event"]->get_flag() ==
             sio::message::flag_object)) {
     RTC_DCHECK(false);
-    return;
-  }
-  std::string id = stream_info->get_map()["id"]->get_string();
-  auto event = stream_info->get_map()["event"];
-  auto stream_it = added_streams_.find(id);
-  auto stream_type = added_stream_type_.find(id);
-  if (stream_it == added_streams_.end() ||
-      stream_type == added_stream_type_.end()) {
-    RTC_DCHECK(false);
-    RTC_LOG(LS_WARNING) << "Invalid stream or type.";
-    return;
+    return false;
   }
-  auto stream = stream_it->second;
-  auto type = stream_type->second;
-  if (event == nullptr || event->get_flag() != sio::message::flag_object ||
-      event->get_map()["field"] == nullptr ||
-      event->get_map()["field"]->get_flag() != sio::message::flag_string) {
+  event->stream_id = stream_info->get_map()["id"]->get_string();
+  auto update = stream_info->get_map()["event"];
+  if (update->get_map()["field"] == nullptr ||
+      update->get_map()["field"]->get_flag() != sio::message::flag_string) {
     RTC_LOG(LS_WARNING) << "Invalid stream update event";
-    return;
+    return false;
   }
-  // TODO(jianlin): Add notification of audio/video active/inactive.
-  std::string event_field = event->get_map()["field"]->get_string();
-  if (type == kStreamTypeMix && event_field == "video.layout") {
-    std::shared_ptr<RemoteMixedStream> stream_ptr =
-        std::static_pointer_cast<RemoteMixedStream>(stream);
-    stream_ptr->OnVideoLayoutChanged();
-    return;
-  } else if (type == kStreamTypeMix && event_field == "activeInput") {
-    auto value = event->get_map()["value"];
-    std::string activeAudioInputStreamId = value->get_string();
-    std::shared_ptr<RemoteMixedStream> stream_ptr = std::static_pointer_cast<RemoteMixedStream>(stream);
-    stream_ptr->OnActiveInputChanged(activeAudioInputStreamId);
-    return;
+  std::string event_field = update->get_map()["field"]->get_string();
+  auto value = update->get_map()["value"];
+  if (event_field == "video.layout") {
+    event->kind = StreamUpdateEvent::kUpdateKindVideoLayout;
+    event->payload = value;
+  } else if (event_field == "activeInput") {
+    if (value == nullptr || value->get_flag() != sio::message::flag_string) {
+      RTC_LOG(LS_WARNING) << "Invalid stream update data value";
+      return false;
+    }
+    event->kind = StreamUpdateEvent::kUpdateKindActiveInput;
+    event->value = value->get_string();
   } else if (event_field == "audio.status" || event_field == "video.status") {
-    auto value = event->get_map()["value"];
     if (value == nullptr || value->get_flag() != sio::message::flag_string) {
       RTC_LOG(LS_WARNING) << "Invalid stream update data value";
-      return;
+      return false;
     }
     std::string status_value = value->get_string();
     if (status_value != "active" && status_value != "inactive") {
       RTC_LOG(LS_WARNING) << "Invalid stream update status";
-      return;
-    }
-    TrackKind track_kind =
-        (event_field == "audio.status") ? TrackKind::kAudio : TrackKind::kVideo;
-    bool muted = (status_value == "inactive") ? true : false;
-    for (auto its = stream_update_observers_.begin();
-         its != stream_update_observers_.end(); ++its) {
-      (*its).get().OnStreamMuteOrUnmute(id, track_kind, muted);
+      return false;
     }
-    current_conference_info_->TriggerOnStreamMuteOrUnmute(id, track_kind, muted);
+    event->kind = (event_field == "audio.status")
+                      ? StreamUpdateEvent::kUpdateKindAudioStatus
+                      : StreamUpdateEvent::kUpdateKindVideoStatus;
+    event->muted = (status_value == "inactive");
   } else if (event_field == ".") {
-    // The value field contains an update to stream info
-    auto value = event->get_map()["value"];
     if (value == nullptr || value->get_flag() != sio::message::flag_object) {
       RTC_LOG(LS_WARNING) << "Invalid VideoInfo update value";
+      return false;
+    }
+    event->kind = StreamUpdateEvent::kUpdateKindInfo;
+    event->payload = value;
+  } else if (event_field == "info.delta") {
+    // Delta-encoded update: a field mask plus only the changed values,
+    // so a one-field change does not ship or re-parse the whole stream
+    // info. Servers without delta support keep sending full "." events,
+    // which take the branch above unchanged.
+    if (value == nullptr || value->get_flag() != sio::message::flag_object ||
+        value->get_map()["mask"] == nullptr ||
+        value->get_map()["mask"]->get_flag() != sio::message::flag_array ||
+        value->get_map()["values"] == nullptr ||
+        value->get_map()["values"]->get_flag() != sio::message::flag_object) {
+      RTC_LOG(LS_WARNING) << "Invalid stream delta update value";
+      return false;
+    }
+    event->kind = StreamUpdateEvent::kUpdateKindInfoDelta;
+    event->payload = value;
+  }
+  return true;
+}
+void ConferenceClient::TriggerOnStreamUpdated(const StreamUpdateEvent& event) {
+  const std::string& id = event.stream_id;
+  std::shared_ptr<RemoteStream> stream;
+  StreamType type;
+  {
+    std::lock_guard<std::mutex> lock(added_streams_mutex_);
+    InternedString interned_id = InternedString::Intern(id);
+    auto stream_it = added_streams_.find(interned_id);
+    auto stream_type = added_stream_type_.find(interned_id);
+    if (stream_it == added_streams_.end() ||
+        stream_type == added_stream_type_.end()) {
+      RTC_DCHECK(false);
+      RTC_LOG(LS_WARNING) << "Invalid stream or type.";
       return;
+    }
+    stream = stream_it->second;
+    type = stream_type->second;
+  }
+  // TODO(jianlin): Add notification of audio/video active/inactive.
+  if (type == kStreamTypeMix &&
+      event.kind == StreamUpdateEvent::kUpdateKindVideoLayout) {
+    // A relayout arrives as a burst of full-layout events. Keep only the
+    // newest layout per stream and deliver one region diff when the
+    // batching window closes.
+    bool flush_scheduled;
+    {
+      std::lock_guard<std::mutex> lock(pending_layout_mutex_);
+      flush_scheduled = pending_layouts_.find(id) != pending_layouts_.end();
+      pending_layouts_[id] = event.payload;
+    }
+    if (!flush_scheduled) {
+      std::weak_ptr<ConferenceClient> weak_this = shared_from_this();
+      event_queue_->PostDelayedTask(
+          [weak_this, id] {
+            auto that = weak_this.lock();
+            if (that) {
+              that->FlushPendingLayout(id);
+            }
+          },
+          kLayoutBatchWindowMs);
+    }
+    return;
+  } else if (type == kStreamTypeMix &&
+             event.kind == StreamUpdateEvent::kUpdateKindActiveInput) {
+    std::shared_ptr<RemoteMixedStream> stream_ptr =
+        std::static_pointer_cast<RemoteMixedStream>(stream);
+    stream_ptr->OnActiveInputChanged(event.value);
+    return;
+  } else if (event.kind == StreamUpdateEvent::kUpdateKindAudioStatus ||
+             event.kind == StreamUpdateEvent::kUpdateKindVideoStatus) {
+    TrackKind track_kind =
+        (event.kind == StreamUpdateEvent::kUpdateKindAudioStatus)
+            ? TrackKind::kAudio
+            : TrackKind::kVideo;
+    auto stream_update_observers = std::atomic_load(&stream_update_observers_);
+    for (auto its = stream_update_observers->begin();
+         its != stream_update_observers->end(); ++its) {
+      (*its).get().OnStreamMuteOrUnmute(id, track_kind, event.muted);
+    }
+    current_conference_info_->TriggerOnStreamMuteOrUnmute(id, track_kind,
+                                                          event.muted);
+  } else if (event.kind == StreamUpdateEvent::kUpdateKindInfoDelta) {
+    ApplyStreamInfoDelta(id, stream, event.payload);
+  } else if (event.kind == StreamUpdateEvent::kUpdateKindInfo) {
+    // The value field contains an update to stream info.
+    ParseStreamInfo(event.payload);
+  }
+}
+void ConferenceClient::ApplyStreamInfoDelta(
+    const std::string& id,
+    std::shared_ptr<RemoteStream> stream,
+    std::shared_ptr<sio::message> delta) {
+  // |mask| and |values| were validated in ParseStreamUpdate.
+  auto mask = delta->get_map()["mask"];
+  auto values = delta->get_map()["values"];
+  for (auto& field_obj : mask->get_vector()) {
+    if (field_obj == nullptr ||
+        field_obj->get_flag() != sio::message::flag_string) {
+      continue;
+    }
+    const std::string field = field_obj->get_string();
+    auto value = values->get_map()[field];
+    if (field == "audio.status" || field == "video.status") {
+      if (value == nullptr || value->get_flag() != sio::message::flag_string) {
+        RTC_LOG(LS_WARNING) << "Stream delta masks " << field
+                            << " without a status value.";
+        continue;
+      }
+      const std::string status = value->get_string();
+      if (status != "active" && status != "inactive") {
+        RTC_LOG(LS_WARNING) << "Invalid status in stream delta update.";
+        continue;
+      }
+      TrackKind track_kind =
+          (field == "audio.status") ? TrackKind::kAudio : TrackKind::kVideo;
+      bool muted = (status == "inactive");
+      auto stream_update_observers = std::atomic_load(&stream_update_observers_);
+      for (auto its = stream_update_observers->begin();
+           its != stream_update_observers->end(); ++its) {
+        (*its).get().OnStreamMuteOrUnmute(id, track_kind, muted);
+      }
+      current_conference_info_->TriggerOnStreamMuteOrUnmute(id, track_kind,
+                                                            muted);
+    } else if (field == "attributes") {
+      if (value == nullptr || value->get_flag() != sio::message::flag_object) {
+        RTC_LOG(LS_WARNING)
+            << "Stream delta masks attributes without an attribute map.";
+        continue;
+      }
+      // AttributesFromStreamInfo expects the map one level down, the way
+      // it sits in a publication info object.
+      sio::message::ptr wrapper = sio::object_message::create();
+      wrapper->get_map()["attributes"] = value;
+      stream->Attributes(AttributesFromStreamInfo(wrapper));
     } else {
-      ParseStreamInfo(value);
+      // A field this client cannot patch in place. Servers attach the
+      // full stream info under "full" for exactly this case; without it
+      // the update is dropped, matching what an unrecognized "." field
+      // did before deltas existed.
+      auto full = delta->get_map()["full"];
+      if (full != nullptr && full->get_flag() == sio::message::flag_object) {
+        ParseStreamInfo(full);
+        return;
+      }
+      RTC_LOG(LS_WARNING) << "Stream delta masks unsupported field " << field
+                          << " and carries no full info; field dropped.";
     }
   }
 }
-std::unordered_map<std::string, std::string>
+void ConferenceClient::FlushPendingLayout(const std::string& stream_id) {
+  sio::message::ptr value;
+  {
+    std::lock_guard<std::mutex> lock(pending_layout_mutex_);
+    auto it = pending_layouts_.find(stream_id);
+    if (it == pending_layouts_.end()) {
+      return;
+    }
+    value = it->second;
+    pending_layouts_.erase(it);
+  }
+  std::shared_ptr<RemoteStream> stream;
+  {
+    std::lock_guard<std::mutex> lock(added_streams_mutex_);
+    auto it = added_streams_.find(InternedString::Intern(stream_id));
+    if (it == added_streams_.end()) {
+      return;
+    }
+    stream = it->second;
+  }
+  // Only mixed stream layouts are queued, so the cast is safe.
+  std::static_pointer_cast<RemoteMixedStream>(stream)->OnVideoLayoutChanged(
+      ParseVideoLayout(value));
+}
+std::shared_ptr<const std::unordered_map<std::string, std::string>>
 ConferenceClient::AttributesFromStreamInfo(
     std::shared_ptr<sio::message> stream_info) {
-  std::unordered_map<std::string, std::string> attributes;
+  // The returned map is shared by the RemoteStream and everyone holding
+  // an attribute snapshot, so it is built once and never mutated after.
+  std::shared_ptr<std::unordered_map<std::string, std::string>> attributes(
+      new std::unordered_map<std::string, std::string>());
   if (stream_info->get_map().find("attributes") ==
       stream_info->get_map().end()) {
     // TODO: CHECK here. However, to compatible with old version, no CHECK at
@@ -1510,11 +3039,12 @@ ConferenceClient::AttributesFromStreamInfo(
   }
   auto attribute_map = attributes_info->get_map();
   for (auto const& attribute_pair : attribute_map) {
-    if (attribute_pair.second->get_flag() != sio::message::flag_string) {
-      RTC_DCHECK(false);
+    if (attribute_pair.second == nullptr ||
+        attribute_pair.second->get_flag() != sio::message::flag_string) {
+      RTC_LOG(LS_WARNING) << "Skipping non-string stream attribute.";
       continue;
     }
-    attributes[attribute_pair.first] = attribute_pair.second->get_string();
+    (*attributes)[attribute_pair.first] = attribute_pair.second->get_string();
   }
   return attributes;
 }
@@ -0,0 +1,127 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include "talk/owt/sdk/include/cpp/owt/conference/conferenceclient.h"
+#include "talk/owt/sdk/test/signalingfixtures.h"
+#include "testing/gtest/include/gtest/gtest.h"
+namespace owt {
+namespace conference {
+using owt::conference::test::BuildForwardStreamInfo;
+using owt::conference::test::BuildMixedStreamInfo;
+using owt::conference::test::BuildRoomSnapshot;
+using owt::conference::test::BuildUserInfo;
+using owt::conference::test::FixtureRng;
+using owt::conference::test::MutateMessage;
+// Friend of ConferenceClient; reaches the private parsers directly so
+// the corpus can be driven without a signaling connection.
+class ConferenceClientParserTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    client_ = ConferenceClient::Create(ConferenceClientConfiguration());
+    // Join normally creates the conference info; the parser expects it.
+    client_->current_conference_info_.reset(new ConferenceInfo());
+  }
+  void ParseStreamInfo(sio::message::ptr stream_info) {
+    // joining = true keeps observer events off the event queue.
+    client_->ParseStreamInfo(stream_info, true);
+  }
+  size_t RemoteStreamCount() {
+    return client_->current_conference_info_->RemoteStreams().size();
+  }
+  static bool ParseUser(sio::message::ptr user_info,
+                        Participant** participant) {
+    return ConferenceClient::ParseUser(user_info, participant);
+  }
+  // Parses a fresh |stream_count|-stream snapshot into its own client
+  // and returns the wall time per stream in microseconds.
+  static double MicrosPerStream(int stream_count, uint64_t seed) {
+    auto client = ConferenceClient::Create(ConferenceClientConfiguration());
+    client->current_conference_info_.reset(new ConferenceInfo());
+    auto snapshot = BuildRoomSnapshot(stream_count, seed);
+    auto start = std::chrono::steady_clock::now();
+    for (auto& stream_info : snapshot) {
+      client->ParseStreamInfo(stream_info, true);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(client->current_conference_info_->RemoteStreams().size(),
+              static_cast<size_t>(stream_count));
+    return std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
+               .count() /
+           static_cast<double>(stream_count);
+  }
+  std::shared_ptr<ConferenceClient> client_;
+};
+TEST_F(ConferenceClientParserTest, ValidSnapshotParses) {
+  auto snapshot = BuildRoomSnapshot(10, 0x5eed);
+  for (auto& stream_info : snapshot) {
+    ParseStreamInfo(stream_info);
+  }
+  EXPECT_EQ(RemoteStreamCount(), 10u);
+  // Re-parsing the same snapshot updates in place instead of duplicating.
+  for (auto& stream_info : snapshot) {
+    ParseStreamInfo(stream_info);
+  }
+  EXPECT_EQ(RemoteStreamCount(), 10u);
+}
+TEST_F(ConferenceClientParserTest, ParseUserRoundTrip) {
+  Participant* participant = nullptr;
+  ASSERT_TRUE(ParseUser(BuildUserInfo(7), &participant));
+  ASSERT_NE(participant, nullptr);
+  EXPECT_EQ(participant->Id(), "participant-7");
+  EXPECT_EQ(participant->UserId(), "user7");
+  EXPECT_EQ(participant->Role(), "viewer");
+  delete participant;
+  participant = nullptr;
+  EXPECT_FALSE(ParseUser(nullptr, &participant));
+  auto incomplete = sio::object_message::create();
+  incomplete->get_map()["id"] = sio::string_message::create("participant-1");
+  EXPECT_FALSE(ParseUser(incomplete, &participant));
+  EXPECT_EQ(participant, nullptr);
+}
+TEST_F(ConferenceClientParserTest, JoinScalesWithRoomSize) {
+  double small = MicrosPerStream(10, 0x5eed);
+  double large = MicrosPerStream(1000, 0x5eed);
+  printf("ParseStreamInfo: %.2f us/stream at 10 streams, %.2f us/stream at "
+         "1000 streams\n",
+         small, large);
+  // Guards against per-stream work that grows with room size beyond the
+  // known linear AddOrUpdateStream scan. The bound is generous so the
+  // scan and timer noise fit under it; per-stream quadratic work would
+  // not.
+  EXPECT_LT(large, small * 40.0 + 50.0);
+}
+TEST_F(ConferenceClientParserTest, FuzzedStreamInfoDoesNotCrash) {
+  FixtureRng rng(0xf00d);
+  for (int i = 0; i < 300; i++) {
+    sio::message::ptr seed_stream = i % 2 == 0
+                                        ? BuildForwardStreamInfo(i, &rng)
+                                        : BuildMixedStreamInfo(i);
+    ParseStreamInfo(MutateMessage(seed_stream, &rng));
+  }
+  // A broken payload must not poison the client for later valid ones.
+  FixtureRng fresh(1);
+  ParseStreamInfo(BuildForwardStreamInfo(100000, &fresh));
+  auto streams = client_->current_conference_info_->RemoteStreams();
+  bool found = false;
+  for (auto& stream : streams) {
+    if (stream->Id() == "stream-100000") {
+      found = true;
+    }
+  }
+  EXPECT_TRUE(found);
+}
+TEST_F(ConferenceClientParserTest, FuzzedUserInfoDoesNotCrash) {
+  FixtureRng rng(0xf00d + 1);
+  for (int i = 0; i < 300; i++) {
+    Participant* participant = nullptr;
+    if (ParseUser(MutateMessage(BuildUserInfo(i), &rng), &participant)) {
+      ASSERT_NE(participant, nullptr);
+      delete participant;
+    }
+  }
+}
+}  // namespace conference
+}  // namespace owt
@@ -5,9 +5,17 @@
 #include <future>
 #include <thread>
 #include <vector>
+#include "talk/owt/sdk/base/eventjournal.h"
 #include "talk/owt/sdk/base/functionalobserver.h"
+#include "talk/owt/sdk/base/intrarefreshmode.h"
+#include "talk/owt/sdk/base/lowlatencymode.h"
 #include "talk/owt/sdk/base/mediautils.h"
 #include "talk/owt/sdk/base/peerconnectiondependencyfactory.h"
+#include "talk/owt/sdk/base/videofreezedetector.h"
+#if defined(WEBRTC_WIN)
+#include "talk/owt/sdk/base/win/msdkvideodecoder.h"
+#include "talk/owt/sdk/base/win/msdkvideoencoder.h"
+#endif
 #include "talk/owt/sdk/include/cpp/owt/conference/remotemixedstream.h"
 #include "webrtc/rtc_base/logging.h"
 #include "webrtc/rtc_base/task_queue.h"
@@ -57,16 +65,20 @@ const string kIceCandidateSdpMidKey = "sdpMid";
 const string kIceCandidateSdpMLineIndexKey = "sdpMLineIndex";
 const string kIceCandidateSdpNameKey = "candidate";
 ConferencePeerConnectionChannel::ConferencePeerConnectionChannel(
-    PeerConnectionChannelConfiguration& configuration,
+    PeerConnectionChannelConfiguration configuration,
     std::shared_ptr<ConferenceSocketSignalingChannel> signaling_channel,
     std::shared_ptr<rtc::TaskQueue> event_queue)
-    : PeerConnectionChannel(configuration),
+    : PeerConnectionChannel(std::move(configuration)),
       signaling_channel_(signaling_channel),
       session_id_(""),
       ice_restart_needed_(false),
       connected_(false),
       sub_stream_added_(false),
       sub_server_ready_(false),
+      low_latency_(false),
+      intra_refresh_(false),
+      max_send_bitrate_bps_(0),
+      receive_suspended_(false),
       event_queue_(event_queue) {
   InitializePeerConnection();
   RTC_CHECK(signaling_channel_);
@@ -77,6 +89,10 @@ ConferencePeerConnectionChannel::~ConferencePeerConnectionChannel() {
     Unpublish(GetSessionId(), nullptr, nullptr);
   if (subscribed_stream_)
     Unsubscribe(GetSessionId(), nullptr, nullptr);
+  if (low_latency_)
+    LowLatencyMode::RemoveSubscription();
+  if (intra_refresh_)
+    IntraRefreshMode::RemovePublication();
 }
 void ConferencePeerConnectionChannel::AddObserver(
     ConferencePeerConnectionChannelObserver& observer) {
@@ -124,6 +140,22 @@ void ConferencePeerConnectionChannel::IceRestart() {
     ice_restart_needed_ = true;
   }
 }
+void ConferencePeerConnectionChannel::SetPlayoutDelay(int min_ms, int max_ms) {
+  // Playout smoothing lives in the media engine and is fixed when the
+  // connection is created, so what can move at runtime is membership in
+  // the process-wide low-latency mode that drives drop-late rendering
+  // and decode-order decoder output.
+  bool want_low_latency = max_ms == 0 && min_ms <= 0;
+  if (want_low_latency && !low_latency_) {
+    low_latency_ = true;
+    LowLatencyMode::AddSubscription();
+  } else if (!want_low_latency && low_latency_) {
+    low_latency_ = false;
+    LowLatencyMode::RemoveSubscription();
+  }
+  RTC_LOG(LS_INFO) << "Playout delay hint on session " << GetSessionId()
+                   << ": min " << min_ms << " ms, max " << max_ms << " ms.";
+}
 void ConferencePeerConnectionChannel::DoIceRestart() {
   RTC_LOG(LS_INFO) << "ICE restart";
   RTC_DCHECK(SignalingState() ==
@@ -202,6 +234,8 @@ void ConferencePeerConnectionChannel::OnRenegotiationNeeded() {}
 void ConferencePeerConnectionChannel::OnIceConnectionChange(
     PeerConnectionInterface::IceConnectionState new_state) {
   RTC_LOG(LS_INFO) << "Ice connection state changed: " << new_state;
+  EventJournal::Append(EventJournal::kIceConnectionChange, new_state,
+                       GetSessionId().c_str());
   if (new_state == PeerConnectionInterface::kIceConnectionConnected ||
       new_state == PeerConnectionInterface::kIceConnectionCompleted) {
     connected_ = true;
@@ -283,6 +317,10 @@ void ConferencePeerConnectionChannel::OnIceCandidatesRemoved(
 void ConferencePeerConnectionChannel::OnCreateSessionDescriptionSuccess(
     webrtc::SessionDescriptionInterface* desc) {
   RTC_LOG(LS_INFO) << "Create sdp success.";
+  // The restart constraint is one shot; clear it so a later offer does
+  // not restart ICE again.
+  media_constraints_.SetMandatory(webrtc::MediaConstraintsInterface::kIceRestart,
+                                  false);
   scoped_refptr<FunctionalSetSessionDescriptionObserver> observer =
       FunctionalSetSessionDescriptionObserver::Create(
           std::bind(&ConferencePeerConnectionChannel::
@@ -400,7 +438,24 @@ void ConferencePeerConnectionChannel::Publish(
     }
     return;
   }
-  publish_success_callback_ = on_success;
+  if (configuration_.intra_refresh && !intra_refresh_) {
+    intra_refresh_ = true;
+    IntraRefreshMode::AddPublication();
+  }
+#if defined(WEBRTC_WIN)
+  // Encoder initialization is independent of the signaling round trip
+  // for a known codec; start warming the hardware encode session now so
+  // the publication can emit its first frame as soon as the answer
+  // lands instead of paying session setup then.
+  if (!stream->MediaStream()->GetVideoTracks().empty()) {
+    VideoCodec prewarm_codec = VideoCodec::kH264;
+    if (!configuration_.video.empty()) {
+      prewarm_codec = configuration_.video.front().codec.name;
+    }
+    MSDKVideoEncoder::PrewarmEncodeResources(prewarm_codec);
+  }
+#endif
+  publish_success_callback_ = std::move(on_success);
   failure_callback_ = on_failure;
   offer_answer_options_.offer_to_receive_audio = false;
   offer_answer_options_.offer_to_receive_video = false;
@@ -440,7 +495,7 @@ void ConferencePeerConnectionChannel::Publish(
     media_ptr->get_map()["video"] = video_options;
   }
   options->get_map()["media"] = media_ptr;
-  SendPublishMessage(options, stream, on_failure);
+  SendPublishMessage(options, stream, std::move(on_failure));
 }
 static bool SubOptionAllowed(
     const SubscribeOptions& subscribe_options,
@@ -496,7 +551,7 @@ static bool SubOptionAllowed(
 }
 void ConferencePeerConnectionChannel::Subscribe(
     std::shared_ptr<RemoteStream> stream,
-    const SubscribeOptions& subscribe_options,
+    SubscribeOptions subscribe_options,
     std::function<void(std::string)> on_success,
     std::function<void(std::unique_ptr<Exception>)> on_failure) {
   RTC_LOG(LS_INFO) << "Subscribe a remote stream. It has audio? "
@@ -520,6 +575,31 @@ void ConferencePeerConnectionChannel::Subscribe(
     RTC_LOG(LS_ERROR) << "Remote stream cannot be nullptr.";
     return;
   }
+  // A zero playout-delay ceiling is the same request as |low_latency|:
+  // drop rather than buffer. Join the process-wide low-latency mode for
+  // either spelling, unless a positive floor asks for smoothness.
+  if ((subscribe_options.low_latency ||
+       (subscribe_options.playout_delay.max_ms == 0 &&
+        subscribe_options.playout_delay.min_ms <= 0)) &&
+      !low_latency_) {
+    low_latency_ = true;
+    LowLatencyMode::AddSubscription();
+  }
+#if defined(WEBRTC_WIN)
+  // The codec is known from the subscription before any frame arrives;
+  // warm the hardware decode path while the signaling round trip is in
+  // flight so the first keyframe decodes without waiting on D3D device
+  // and decode session creation.
+  if (stream->has_video_ && !subscribe_options.video.disabled) {
+    VideoCodec prewarm_codec = VideoCodec::kH264;
+    if (!subscribe_options.video.codecs.empty()) {
+      prewarm_codec = subscribe_options.video.codecs.front().name;
+    } else if (!stream->Capabilities().video.codecs.empty()) {
+      prewarm_codec = stream->Capabilities().video.codecs.front().name;
+    }
+    MSDKVideoDecoder::PrewarmDecodeResources(prewarm_codec);
+  }
+#endif
   if (subscribe_success_callback_) {
     if (on_failure) {
       event_queue_->PostTask([on_failure]() {
@@ -529,7 +609,7 @@ void ConferencePeerConnectionChannel::Subscribe(
       });
     }
   }
-  subscribe_success_callback_ = on_success;
+  subscribe_success_callback_ = std::move(on_success);
   failure_callback_ = on_failure;
   sio::message::ptr sio_options = sio::object_message::create();
   sio::message::ptr media_options = sio::object_message::create();
@@ -575,6 +655,13 @@ void ConferencePeerConnectionChannel::Subscribe(
       video_spec->get_map()["framerate"] =
           sio::int_message::create(subscribe_options.video.frameRate);
     }
+    // Capabilities do not enumerate temporal layers, so the value is not
+    // checked in SubOptionAllowed; the server clamps it to the layers the
+    // publication carries.
+    if (subscribe_options.video.temporalLayerId >= 0) {
+      video_spec->get_map()["temporalLayerId"] =
+          sio::int_message::create(subscribe_options.video.temporalLayerId);
+    }
     video_options->get_map()["parameters"] = video_spec;
     media_options->get_map()["video"] = video_options;
   } else {
@@ -592,7 +679,7 @@ void ConferencePeerConnectionChannel::Subscribe(
         SetSessionId(session_id);
         CreateOffer();
       },
-      on_failure);  // TODO: on_failure
+      std::move(on_failure));  // TODO: on_failure
 }
 void ConferencePeerConnectionChannel::Unpublish(
     const std::string& session_id,
@@ -647,6 +734,14 @@ void ConferencePeerConnectionChannel::Unsubscribe(
                                       RunInEventQueue(on_success), on_failure);
   this->ClosePeerConnection();
 }
+void ConferencePeerConnectionChannel::CloseWithoutSignaling() {
+  connected_ = false;
+  // Dropping the stream references keeps the destructor from issuing the
+  // per-session unpublish/unsubscribe this path exists to avoid.
+  published_stream_.reset();
+  subscribed_stream_.reset();
+  this->ClosePeerConnection();
+}
 void ConferencePeerConnectionChannel::SendStreamControlMessage(
     const std::string& in_action,
     const std::string& out_action,
@@ -675,6 +770,46 @@ void ConferencePeerConnectionChannel::PauseAudioVideo(
     std::function<void(std::unique_ptr<Exception>)> on_failure) {
   SendStreamControlMessage("av", "av", "pause", on_success, on_failure);
 }
+void ConferencePeerConnectionChannel::SetReceiveTracksEnabled(bool enabled) {
+  if (subscribed_stream_ == nullptr ||
+      subscribed_stream_->MediaStream() == nullptr) {
+    return;
+  }
+  receive_suspended_ = !enabled;
+  auto stream = subscribed_stream_->MediaStream();
+  for (const auto& track : stream->GetAudioTracks()) {
+    track->set_enabled(enabled);
+  }
+  for (const auto& track : stream->GetVideoTracks()) {
+    track->set_enabled(enabled);
+  }
+}
+void ConferencePeerConnectionChannel::SetReceiveAudioTrackEnabled(
+    bool enabled) {
+  if (subscribed_stream_ == nullptr ||
+      subscribed_stream_->MediaStream() == nullptr || receive_suspended_) {
+    return;
+  }
+  auto stream = subscribed_stream_->MediaStream();
+  for (const auto& track : stream->GetAudioTracks()) {
+    track->set_enabled(enabled);
+  }
+}
+void ConferencePeerConnectionChannel::SetAudioPlayoutGain(double gain) {
+  if (subscribed_stream_ == nullptr ||
+      subscribed_stream_->MediaStream() == nullptr) {
+    return;
+  }
+  if (gain < 0) {
+    gain = 0;
+  }
+  auto stream = subscribed_stream_->MediaStream();
+  for (const auto& track : stream->GetAudioTracks()) {
+    if (track->GetSource() != nullptr) {
+      track->GetSource()->SetVolume(gain);
+    }
+  }
+}
 void ConferencePeerConnectionChannel::PlayAudio(
     std::function<void()> on_success,
     std::function<void(std::unique_ptr<Exception>)> on_failure) {
@@ -715,8 +850,19 @@ void ConferencePeerConnectionChannel::GetConnectionStats(
     return;
   }
   if (subscribed_stream_) {
+    // Attach the SDK-side freeze reports measured at this stream's decode
+    // and render points before the stats reach the application.
+    std::string stream_id = subscribed_stream_->Id();
+    std::function<void(std::shared_ptr<ConnectionStats>)> on_complete =
+        [on_success, stream_id](std::shared_ptr<ConnectionStats> stats) {
+          stats->video_freeze_reports =
+              VideoFreezeDetector::ReportsForStream(stream_id);
+          if (on_success) {
+            on_success(stats);
+          }
+        };
     scoped_refptr<FunctionalStatsObserver> observer =
-        FunctionalStatsObserver::Create(on_success);
+        FunctionalStatsObserver::Create(on_complete);
     GetStatsMessage* stats_message = new GetStatsMessage(
         observer.get(), subscribed_stream_->MediaStream(),
         webrtc::PeerConnectionInterface::kStatsOutputLevelStandard);
@@ -848,6 +994,37 @@ void ConferencePeerConnectionChannel::SetSessionId(const std::string& id) {
 std::string ConferencePeerConnectionChannel::GetSessionId() const {
   return session_id_;
 }
+int ConferencePeerConnectionChannel::BandwidthPriority() const {
+  return configuration_.bandwidth_priority > 1 ? configuration_.bandwidth_priority
+                                               : 1;
+}
+void ConferencePeerConnectionChannel::SetMaxSendBitrateBps(int bps) {
+  if (bps < 0) {
+    bps = 0;
+  }
+  // The orchestrated cap never exceeds an explicitly configured one.
+  if (configuration_.max_pacing_bitrate_bps > 0 &&
+      (bps == 0 || bps > configuration_.max_pacing_bitrate_bps)) {
+    bps = configuration_.max_pacing_bitrate_bps;
+  }
+  {
+    std::lock_guard<std::mutex> lock(max_send_bitrate_mutex_);
+    if (bps == max_send_bitrate_bps_) {
+      return;
+    }
+    max_send_bitrate_bps_ = bps;
+  }
+  if (peer_connection_ == nullptr) {
+    return;
+  }
+  // An unset maximum removes the cap; |peer_connection_| is a proxy, so
+  // the call marshals to the signaling thread itself.
+  webrtc::PeerConnectionInterface::BitrateParameters bitrate;
+  if (bps > 0) {
+    bitrate.max_bitrate_bps = absl::optional<int>(bps);
+  }
+  peer_connection_->SetBitrate(bitrate);
+}
 void ConferencePeerConnectionChannel::SendPublishMessage(
     sio::message::ptr options,
     std::shared_ptr<LocalStream> stream,
@@ -862,7 +1039,7 @@ void ConferencePeerConnectionChannel::SendPublishMessage(
         pc_thread_->Post(RTC_FROM_HERE, this, kMessageTypeAddStream, param);
         CreateOffer();
       },
-      on_failure);
+      std::move(on_failure));
 }
 void ConferencePeerConnectionChannel::OnNetworksChanged() {
   RTC_LOG(LS_INFO) << "ConferencePeerConnectionChannel::OnNetworksChanged";
@@ -23,7 +23,7 @@ class ConferencePeerConnectionChannel
       public std::enable_shared_from_this<ConferencePeerConnectionChannel> {
  public:
   explicit ConferencePeerConnectionChannel(
-      PeerConnectionChannelConfiguration& configuration,
+      PeerConnectionChannelConfiguration configuration,
       std::shared_ptr<ConferenceSocketSignalingChannel> signaling_channel,
       std::shared_ptr<rtc::TaskQueue> event_queue);
   ~ConferencePeerConnectionChannel();
@@ -43,13 +43,19 @@ class ConferencePeerConnectionChannel
       const std::string& session_id,
       std::function<void()> on_success,
       std::function<void(std::unique_ptr<Exception>)> on_failure);
-  // Subscribe a stream from the conference.
+  // Subscribe a stream from the conference. Options are taken by value;
+  // the caller moves them in and this channel is their single owner.
   void Subscribe(
       std::shared_ptr<RemoteStream> stream,
-      const SubscribeOptions& options,
+      SubscribeOptions options,
       std::function<void(std::string)> on_success,
       std::function<void(std::unique_ptr<Exception>)> on_failure);
   // Unsubscribe a remote stream from the conference.
+  // Close the connection without per-session signaling. Used when leaving
+  // the conference: the single leave message already covers every session
+  // on the server, so per-session unpublish/unsubscribe round trips would
+  // be redundant.
+  void CloseWithoutSignaling();
   void Unsubscribe(
       const std::string& session_id,
       std::function<void()> on_success,
@@ -83,6 +89,20 @@ class ConferencePeerConnectionChannel
   void PlayAudioVideo(
       std::function<void()> on_success,
       std::function<void(std::unique_ptr<Exception>)> on_failure);
+  // Enable or disable the subscribed stream's receive tracks locally.
+  // Disabled tracks stop feeding sinks and audio playout, so frames
+  // still in flight after the server paused forwarding cost nothing;
+  // the connection and decoder state are untouched. No-op on publish
+  // channels.
+  void SetReceiveTracksEnabled(bool enabled);
+  // Enable or disable only the audio receive tracks. Used by the
+  // client's audio focus control; ignored while the subscription is
+  // suspended so focus changes cannot wake a suspended session.
+  void SetReceiveAudioTrackEnabled(bool enabled);
+  // Set the playout gain of the subscribed audio, applied at the source
+  // feeding the engine's shared mixer. 1.0 is unity; values below zero
+  // clamp to silence. No-op on publish channels.
+  void SetAudioPlayoutGain(double gain);
   void PauseAudioVideo(
       std::function<void()> on_success,
       std::function<void(std::unique_ptr<Exception>)> on_failure);
@@ -92,12 +112,25 @@ class ConferencePeerConnectionChannel
       std::function<void(std::unique_ptr<Exception>)> on_failure);
   // Initialize an ICE restarat.
   void IceRestart();
+  // Update this subscription's playout delay hints at runtime. A zero
+  // |max_ms| with no floor joins the process-wide low-latency mode; any
+  // other combination leaves it.
+  void SetPlayoutDelay(int min_ms, int max_ms);
   // Get the associated stream id if it is a subscription channel.
   std::string GetSubStreamId();
   // Set stream's session ID. This ID is returned by MCU per publish/subscribe.
   void SetSessionId(const std::string& id);
   // Get published or subscribed stream's publicationID or subcriptionID.
   std::string GetSessionId() const;
+  // Relative weight used by the client's bandwidth orchestrator when it
+  // splits the uplink estimate between concurrent publications.
+  int BandwidthPriority() const;
+  // Cap this connection's total send rate at runtime, in bits per second.
+  // The cap feeds the send-side bandwidth allocator like the
+  // configuration-time pacing cap does; zero or a negative value restores
+  // the configured behavior. Never raises the cap above a configured
+  // max_pacing_bitrate_bps. Safe to call from any thread.
+  void SetMaxSendBitrateBps(int bps);
   // Socket.IO event
   virtual void OnSignalingMessage(sio::message::ptr message);
   // Get statistowt data for the specific stream.
@@ -195,6 +228,21 @@ class ConferencePeerConnectionChannel
   std::mutex sub_stream_added_mutex_;
   bool sub_stream_added_;
   bool sub_server_ready_;
+  // This subscription holds a reference on the process-wide low-latency
+  // mode (SubscribeOptions::low_latency).
+  bool low_latency_;
+  // This publication holds a reference on the process-wide intra-refresh
+  // mode (PublishOptions::intra_refresh).
+  bool intra_refresh_;
+  // Last cap pushed through SetMaxSendBitrateBps, guarded by
+  // |max_send_bitrate_mutex_|; zero means the configured behavior is in
+  // effect. Used to skip redundant SetBitrate round trips when the
+  // orchestrator recomputes the same split.
+  int max_send_bitrate_bps_;
+  std::mutex max_send_bitrate_mutex_;
+  // Receive tracks disabled by Suspend; audio focus control leaves
+  // suspended sessions alone.
+  bool receive_suspended_;
   // Queue for callbacks and events.
   std::shared_ptr<rtc::TaskQueue> event_queue_;
 };
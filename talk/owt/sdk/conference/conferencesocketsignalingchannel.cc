@@ -4,14 +4,20 @@
 #include <iostream>
 #include <thread>
 #include <algorithm>
+#include <chrono>
 #include <ctime>
 #if defined(WEBRTC_IOS)
 #include <CoreFoundation/CFDate.h>
 #endif
 #include "talk/owt/sdk/base/mediautils.h"
+#include "talk/owt/sdk/base/memoryaccounting.h"
+#include "talk/owt/sdk/base/tracelog.h"
 #include "talk/owt/sdk/base/stringutils.h"
 #include "talk/owt/sdk/base/sysinfo.h"
+#include "talk/owt/sdk/base/threadwatchdog.h"
 #include "talk/owt/sdk/conference/conferencesocketsignalingchannel.h"
+#include "talk/owt/sdk/conference/siomsgpack.h"
+#include "talk/owt/sdk/conference/sioutils.h"
 #include "webrtc/rtc_base/third_party/base64/base64.h"
 #include "webrtc/rtc_base/checks.h"
 #include "webrtc/rtc_base/logging.h"
@@ -64,15 +70,124 @@ const std::string kEventNameConnectionFailed = "connection_failed";
 const uint64_t kMachLinuxTimeDelta = 978307200;
 #endif
 const int kReconnectionAttempts = 10;
-const int kReconnectionDelay = 2000;
+// The first retry fires almost immediately: a network roam usually
+// restores connectivity within tens of milliseconds, and waiting a flat
+// delay before every attempt added seconds to reconnect-to-media-resume
+// for mobile users. The transport backs the delay off exponentially from
+// here, bounded by the max, so a server that is actually down is not
+// hammered.
+const int kReconnectionDelay = 100;
+const int kReconnectionDelayMax = 10000;
+const std::string kEventNameBatch = "batch";
+// Emits issued within this window are packed into one batch packet.
+const int kBatchWindowMs = 2;
+// Binary custom messages larger than this are split into chunks so a
+// single payload never exceeds one websocket frame.
+const size_t kMaxBinaryChunkSize = 512 * 1024;
+const int64_t ConferenceSocketSignalingChannel::kRttBucketBoundsMs
+    [ConferenceSocketSignalingChannel::kRttBucketCount - 1] = {
+        10, 25, 50, 100, 250, 500, 1000, 2500};
+// Category the outgoing message queue reports its footprint under.
+static const char kOutgoingQueueCategory[] = "signaling.outgoing_queue";
+// Ring capacity and window for incoming custom message deduplication.
+// The ring only needs to span what a reconnect replay can duplicate,
+// so a small fixed ring keeps the check O(1).
+static const size_t kRecentDigestRingCapacity = 32;
+static const int64_t kDuplicateSuppressWindowMs = 10000;
+// FNV-1a over sender and payload. The wire protocol has no envelope
+// field for a sequence number, so this digest serves as the message ID
+// for duplicate suppression.
+static uint64_t CustomMessageDigest(const std::string& from,
+                                    const std::string& payload) {
+  uint64_t hash = 1469598103934665603ull;
+  for (size_t i = 0; i < from.size(); i++) {
+    hash ^= static_cast<uint8_t>(from[i]);
+    hash *= 1099511628211ull;
+  }
+  hash ^= 0xffu;
+  hash *= 1099511628211ull;
+  for (size_t i = 0; i < payload.size(); i++) {
+    hash ^= static_cast<uint8_t>(payload[i]);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+// Estimates the heap footprint of one sio message: payload bytes for
+// strings and binaries, recursion for containers, a pointer-sized floor
+// for scalars. Used to account the outgoing queue, whose unbounded growth
+// during long reconnections is otherwise invisible.
+static size_t EstimateMessageSize(const sio::message::ptr& message) {
+  if (!message)
+    return 0;
+  switch (message->get_flag()) {
+    case sio::message::flag_string:
+      return sizeof(sio::string_message) + message->get_string().size();
+    case sio::message::flag_binary:
+      return sizeof(sio::binary_message) +
+             (message->get_binary() ? message->get_binary()->size() : 0);
+    case sio::message::flag_array: {
+      size_t size = sizeof(sio::array_message);
+      for (const auto& item : message->get_vector())
+        size += EstimateMessageSize(item);
+      return size;
+    }
+    case sio::message::flag_object: {
+      size_t size = sizeof(sio::object_message);
+      for (const auto& item : message->get_map())
+        size += item.first.size() + EstimateMessageSize(item.second);
+      return size;
+    }
+    default:
+      return sizeof(sio::message);
+  }
+}
+static size_t EstimateMessageListSize(const sio::message::list& message) {
+  size_t size = 0;
+  for (unsigned int i = 0; i < message.size(); i++)
+    size += EstimateMessageSize(message.at(i));
+  return size;
+}
+// Wraps a socket.io listener so binary msgpack payloads are transparently
+// decoded before the listener runs. Text mode messages pass through
+// unchanged.
+static sio::socket::event_listener_aux BinaryAwareListener(
+    sio::socket::event_listener_aux listener) {
+  return [listener](std::string const& name, sio::message::ptr const& data,
+                    bool is_ack, sio::message::list& ack_resp) {
+    // Every conference socket event funnels through here on the sio
+    // receive thread, so one shared watchdog handle covers the whole
+    // signaling receive path.
+    static owt::base::ThreadWatchdog::Handle* watchdog_handle =
+        owt::base::ThreadWatchdog::Register("conference.signaling.receive");
+    owt::base::ScopedWatchdogSection watchdog(watchdog_handle,
+                                              "ConferenceSignaling.Receive");
+    listener(name, SioMsgpack::DecodeIfBinary(data), is_ack, ack_resp);
+  };
+}
 ConferenceSocketSignalingChannel::ConferenceSocketSignalingChannel()
     : socket_client_(new sio::client()),
       reconnection_ticket_(""),
       participant_id_(""),
+      connect_candidate_index_(0),
+      connect_attempt_start_ms_(0),
       reconnection_attempted_(0),
       is_reconnection_(false),
-      outgoing_message_id_(1) {}
+      binary_signaling_enabled_(false),
+      batch_signaling_enabled_(false),
+      batch_thread_stop_(false),
+      recent_digest_index_(0),
+      next_binary_message_id_(1),
+      outgoing_message_id_(1),
+      last_drain_duration_ms_(0) {}
 ConferenceSocketSignalingChannel::~ConferenceSocketSignalingChannel() {
+  {
+    std::lock_guard<std::mutex> lock(batch_mutex_);
+    batch_thread_stop_ = true;
+  }
+  batch_wake_.notify_one();
+  if (batch_thread_.joinable()) {
+    batch_thread_.join();
+  }
   delete socket_client_;
 }
 void ConferenceSocketSignalingChannel::AddObserver(
@@ -114,6 +229,8 @@ void ConferenceSocketSignalingChannel::Connect(
   }
   reconnection_ticket_ = "";
   is_reconnection_ = false;
+  binary_signaling_enabled_ = false;
+  batch_signaling_enabled_ = false;
   Json::Value json_token;
   Json::Reader reader;
   if (!reader.parse(token_decoded, json_token)) {
@@ -125,14 +242,43 @@ void ConferenceSocketSignalingChannel::Connect(
     }
     return;
   }
-  std::string scheme("http://");
   std::string host;
   rtc::GetStringFromJsonObject(json_token, "host", &host);
+  // The host field may carry several comma-separated endpoints. They are
+  // walked in order by the initial connect; see |connect_candidates_|.
+  connect_candidates_.clear();
+  connect_candidate_index_ = 0;
+  size_t candidate_start = 0;
+  while (candidate_start <= host.size()) {
+    size_t comma = host.find(',', candidate_start);
+    size_t candidate_end = comma == std::string::npos ? host.size() : comma;
+    std::string candidate =
+        host.substr(candidate_start, candidate_end - candidate_start);
+    while (!candidate.empty() && candidate.front() == ' ')
+      candidate.erase(0, 1);
+    while (!candidate.empty() && candidate.back() == ' ')
+      candidate.pop_back();
+    if (!candidate.empty())
+      connect_candidates_.push_back(candidate);
+    if (comma == std::string::npos)
+      break;
+    candidate_start = comma + 1;
+  }
+  if (connect_candidates_.empty()) {
+    RTC_LOG(LS_ERROR) << "Token carries no signaling host.";
+    if (on_failure != nullptr) {
+      std::unique_ptr<Exception> e(new Exception(
+          ExceptionType::kConferenceInvalidToken, "Invalid token."));
+      on_failure(std::move(e));
+    }
+    return;
+  }
   std::weak_ptr<ConferenceSocketSignalingChannel> weak_this =
       shared_from_this();
   socket_client_->socket();
   socket_client_->set_reconnect_attempts(kReconnectionAttempts);
   socket_client_->set_reconnect_delay(kReconnectionDelay);
+  socket_client_->set_reconnect_delay_max(kReconnectionDelayMax);
   socket_client_->set_socket_close_listener(
       [weak_this](std::string const& nsp) {
         RTC_LOG(LS_INFO) << "Socket.IO disconnected.";
@@ -146,6 +292,8 @@ void ConferenceSocketSignalingChannel::Connect(
     RTC_LOG(LS_ERROR) << "Socket.IO connection failed.";
     auto that = weak_this.lock();
     if (that) {
+      if (that->TryNextConnectCandidate())
+        return;
       that->DropQueuedMessages();
       if (that->reconnection_attempted_ >= kReconnectionAttempts) {
         that->TriggerOnServerDisconnected();
@@ -161,38 +309,61 @@ void ConferenceSocketSignalingChannel::Connect(
         // fail (fail listener).
         that->is_reconnection_ = true;
         that->reconnection_attempted_++;
+        {
+          std::lock_guard<std::mutex> lock(that->outgoing_message_mutex_);
+          that->signaling_stats_.reconnect_count++;
+        }
       }
     }
   });
   socket_client_->set_open_listener([=](void) {
     // At this time the connect failure callback is still in pending list. No
     // need to add a new entry in the pending list.
+    {
+      std::lock_guard<std::mutex> lock(outgoing_message_mutex_);
+      signaling_stats_.connect_duration_ms =
+          rtc::TimeMillis() - connect_attempt_start_ms_;
+    }
     if (!is_reconnection_) {
-      owt::base::SysInfo sys_info(owt::base::SysInfo::GetInstance());
       sio::message::ptr login_message = sio::object_message::create();
       login_message->get_map()["token"] = sio::string_message::create(token);
-      sio::message::ptr ua_message = sio::object_message::create();
-      sio::message::ptr sdk_message = sio::object_message::create();
-      sdk_message->get_map()["type"] =
-          sio::string_message::create(sys_info.sdk.type);
-      sdk_message->get_map()["version"] =
-          sio::string_message::create(sys_info.sdk.version);
-      ua_message->get_map()["sdk"] = sdk_message;
-      sio::message::ptr os_message = sio::object_message::create();
-      os_message->get_map()["name"] =
-          sio::string_message::create(sys_info.os.name);
-      os_message->get_map()["version"] =
-          sio::string_message::create(sys_info.os.version);
-      ua_message->get_map()["os"] = os_message;
-      sio::message::ptr runtime_message = sio::object_message::create();
-      runtime_message->get_map()["name"] =
-          sio::string_message::create(sys_info.runtime.name);
-      runtime_message->get_map()["version"] =
-          sio::string_message::create(sys_info.runtime.version);
-      ua_message->get_map()["runtime"] = runtime_message;
+      // The user-agent block never changes while the process runs, so it
+      // is built once and attached by reference to every login.
+      static const sio::message::ptr ua_message = []() {
+        const owt::base::SysInfo& sys_info =
+            owt::base::SysInfo::GetInstance();
+        sio::message::ptr ua = sio::object_message::create();
+        sio::message::ptr sdk_message = sio::object_message::create();
+        sdk_message->get_map()["type"] =
+            sio::string_message::create(sys_info.sdk.type);
+        sdk_message->get_map()["version"] =
+            sio::string_message::create(sys_info.sdk.version);
+        ua->get_map()["sdk"] = sdk_message;
+        sio::message::ptr os_message = sio::object_message::create();
+        os_message->get_map()["name"] =
+            sio::string_message::create(sys_info.os.name);
+        os_message->get_map()["version"] =
+            sio::string_message::create(sys_info.os.version);
+        ua->get_map()["os"] = os_message;
+        sio::message::ptr runtime_message = sio::object_message::create();
+        runtime_message->get_map()["name"] =
+            sio::string_message::create(sys_info.runtime.name);
+        runtime_message->get_map()["version"] =
+            sio::string_message::create(sys_info.runtime.version);
+        ua->get_map()["runtime"] = runtime_message;
+        return ua;
+      }();
       login_message->get_map()["userAgent"] = ua_message;
       std::string protocol_version = SIGNALING_PROTOCOL_VERSION;
       login_message->get_map()["protocol"] = sio::string_message::create(protocol_version);
+      // Advertise msgpack support. Servers without binary signaling
+      // ignore this field and everything stays JSON text.
+      login_message->get_map()["supportedEncodings"] =
+          sio::string_message::create("msgpack");
+      // Advertise support for batched emits; servers without it ignore
+      // the field and every message stays its own packet.
+      login_message->get_map()["supportsBatching"] =
+          sio::bool_message::create(true);
       Emit("login", login_message,
            [=](sio::message::list const& msg) {
              connect_failure_callback_ = nullptr;
@@ -239,6 +410,24 @@ void ConferenceSocketSignalingChannel::Connect(
              if (participant_id_ptr) {
                participant_id_ = participant_id_ptr->get_string();
              }
+             auto encoding_ptr = message->get_map()["encoding"];
+             if (encoding_ptr != nullptr &&
+                 encoding_ptr->get_flag() == sio::message::flag_string &&
+                 encoding_ptr->get_string() == "msgpack") {
+               RTC_LOG(LS_INFO) << "Binary (msgpack) signaling enabled.";
+               binary_signaling_enabled_ = true;
+             }
+             auto batching_ptr = message->get_map()["batching"];
+             if (batching_ptr != nullptr &&
+                 batching_ptr->get_flag() == sio::message::flag_boolean &&
+                 batching_ptr->get_bool()) {
+               RTC_LOG(LS_INFO) << "Batched signaling enabled.";
+               batch_signaling_enabled_ = true;
+               if (!batch_thread_.joinable()) {
+                 batch_thread_ = std::thread(
+                     &ConferenceSocketSignalingChannel::BatchLoop, this);
+               }
+             }
              if (on_success != nullptr) {
                on_success(message);
              }
@@ -275,23 +464,25 @@ void ConferenceSocketSignalingChannel::Connect(
             }
             RTC_LOG(LS_VERBOSE) << "Reconnection success";
             DrainQueuedMessages();
+            // Sessions are still alive on server side; observers restart
+            // ICE on existing PeerConnections instead of renegotiating.
+            for (auto it = observers_.begin(); it != observers_.end(); ++it) {
+              (*it)->OnServerReconnectionSucceeded();
+            }
           });
     }
   });
   socket_client_->socket()->on(
       kEventNameStreamMessage,
-      sio::socket::event_listener_aux(
+      BinaryAwareListener(sio::socket::event_listener_aux(
           [&](std::string const& name, sio::message::ptr const& data,
               bool is_ack, sio::message::list& ack_resp) {
             RTC_LOG(LS_VERBOSE) << "Received stream event.";
-            if (data->get_map()["status"] != nullptr &&
-                data->get_map()["status"]->get_flag() == sio::message::flag_string &&
-                data->get_map()["id"] != nullptr &&
-                data->get_map()["id"]->get_flag() == sio::message::flag_string) {
-              std::string stream_status = data->get_map()["status"]->get_string();
-              std::string stream_id = data->get_map()["id"]->get_string();
+            std::string stream_status = GetStringField(data, "status");
+            std::string stream_id = GetStringField(data, "id");
+            if (!stream_status.empty() && !stream_id.empty()) {
               if (stream_status == "add") {
-                auto stream_info = data->get_map()["data"];
+                auto stream_info = GetField(data, "data");
                 if (stream_info != nullptr && stream_info->get_flag() == sio::message::flag_object) {
                   for (auto it = observers_.begin(); it != observers_.end(); ++it) {
                     (*it)->OnStreamAdded(stream_info);
@@ -300,7 +491,7 @@ void ConferenceSocketSignalingChannel::Connect(
               } else if (stream_status == "update") {
                 sio::message::ptr update_message = sio::object_message::create();
                 update_message->get_map()["id"] = sio::string_message::create(stream_id);
-                auto stream_update = data->get_map()["data"];
+                auto stream_update = GetField(data, "data");
                 if (stream_update != nullptr && stream_update->get_flag() == sio::message::flag_object) {
                   update_message->get_map()["event"] = stream_update;
                 }
@@ -315,49 +506,39 @@ void ConferenceSocketSignalingChannel::Connect(
                 }
               }
             }
-          }));
+          })));
   socket_client_->socket()->on(
       kEventNameOnCustomMessage,
-      sio::socket::event_listener_aux(
+      BinaryAwareListener(sio::socket::event_listener_aux(
           [&](std::string const& name, sio::message::ptr const& data,
               bool is_ack, sio::message::list& ack_resp) {
             RTC_LOG(LS_VERBOSE) << "Received custom message.";
-            std::string from = data->get_map()["from"]->get_string();
-            std::string message = data->get_map()["message"]->get_string();
-            std::string to = "me";
-            auto target = data->get_map()["to"];
-            if (target != nullptr && target->get_flag() == sio::message::flag_string) {
-              to = target->get_string();
-            }
-            for (auto it = observers_.begin(); it != observers_.end(); ++it) {
-              (*it)->OnCustomMessage(from, message, to);
-            }
-          }));
+            std::string from = GetStringField(data, "from");
+            std::string to = GetStringField(data, "to", "me");
+            OnCustomMessageData(from, to, data);
+          })));
   socket_client_->socket()->on(
       kEventNameOnUserPresence,
-      sio::socket::event_listener_aux([&](
+      BinaryAwareListener(sio::socket::event_listener_aux([&](
           std::string const& name, sio::message::ptr const& data, bool is_ack,
           sio::message::list& ack_resp) {
         RTC_LOG(LS_VERBOSE) << "Received user join/leave message.";
-        if (data == nullptr || data->get_flag() != sio::message::flag_object ||
-            data->get_map()["action"] == nullptr ||
-            data->get_map()["action"]->get_flag() != sio::message::flag_string) {
+        std::string participant_action = GetStringField(data, "action");
+        if (participant_action.empty()) {
           RTC_DCHECK(false);
           return;
         }
-        auto participant_action = data->get_map()["action"]->get_string();
         if (participant_action == "join") {
           // Get the pariticipant ID from data;
-          auto participant_info = data->get_map()["data"];
+          auto participant_info = GetField(data, "data");
           if (participant_info != nullptr && participant_info->get_flag() == sio::message::flag_object
-              && participant_info->get_map()["id"] != nullptr
-              && participant_info->get_map()["id"]->get_flag() == sio::message::flag_string) {
+              && !GetStringField(participant_info, "id").empty()) {
             for (auto it = observers_.begin(); it != observers_.end(); ++it) {
               (*it)->OnUserJoined(participant_info);
             }
           }
         } else if (participant_action == "leave") {
-          auto participant_info = data->get_map()["data"];
+          auto participant_info = GetField(data, "data");
           if (participant_info != nullptr && participant_info->get_flag() == sio::message::flag_string) {
             for (auto it = observers_.begin(); it != observers_.end(); ++it) {
               (*it)->OnUserLeft(participant_info);
@@ -366,20 +547,20 @@ void ConferenceSocketSignalingChannel::Connect(
         } else {
           RTC_NOTREACHED();
         }
-      }));
+      })));
   socket_client_->socket()->on(
       kEventNameOnSignalingMessage,
-      sio::socket::event_listener_aux(
+      BinaryAwareListener(sio::socket::event_listener_aux(
           [&](std::string const& name, sio::message::ptr const& data,
               bool is_ack, sio::message::list& ack_resp) {
             RTC_LOG(LS_VERBOSE) << "Received signaling message from erizo.";
             for (auto it = observers_.begin(); it != observers_.end(); ++it) {
               (*it)->OnSignalingMessage(data);
             }
-          }));
+          })));
   socket_client_->socket()->on(
       kEventNameOnDrop,
-      sio::socket::event_listener_aux(
+      BinaryAwareListener(sio::socket::event_listener_aux(
           [&](std::string const& name, sio::message::ptr const& data,
               bool is_ack, sio::message::list& ack_resp) {
             RTC_LOG(LS_INFO) << "Received drop message.";
@@ -387,19 +568,48 @@ void ConferenceSocketSignalingChannel::Connect(
             for (auto it = observers_.begin(); it != observers_.end(); ++it) {
               (*it)->OnServerDisconnected();
             }
-          }));
+          })));
   socket_client_->socket()->on(
       kEventNameConnectionFailed,
-      sio::socket::event_listener_aux(
+      BinaryAwareListener(sio::socket::event_listener_aux(
           [&](std::string const& name, sio::message::ptr const& data,
               bool is_ack, sio::message::list& ack_resp) {
             for (auto it = observers_.begin(); it != observers_.end(); ++it) {
               (*it)->OnStreamError(data);
             }
-          }));
+          })));
   // Store |on_failure| so it can be invoked if connect failed.
   connect_failure_callback_ = on_failure;
-  socket_client_->connect(scheme.append(host));
+  ConnectToCandidate();
+}
+void ConferenceSocketSignalingChannel::ConnectToCandidate() {
+  {
+    std::lock_guard<std::mutex> lock(outgoing_message_mutex_);
+    signaling_stats_.connect_attempt_count++;
+  }
+  connect_attempt_start_ms_ = rtc::TimeMillis();
+  const std::string& host = connect_candidates_[connect_candidate_index_];
+  RTC_LOG(LS_INFO) << "Connecting to signaling endpoint " << host << " ("
+                   << connect_candidate_index_ + 1 << " of "
+                   << connect_candidates_.size() << ").";
+  socket_client_->connect("http://" + host);
+}
+bool ConferenceSocketSignalingChannel::TryNextConnectCandidate() {
+  // Failover applies to the initial connect only: once a session exists,
+  // the reconnection ticket is bound to the endpoint that issued it, so
+  // reconnects must return there.
+  if (reconnection_ticket_ != "" || connect_candidates_.empty())
+    return false;
+  RTC_LOG(LS_WARNING) << "Signaling endpoint "
+                      << connect_candidates_[connect_candidate_index_]
+                      << " failed after "
+                      << rtc::TimeMillis() - connect_attempt_start_ms_
+                      << "ms.";
+  if (connect_candidate_index_ + 1 >= connect_candidates_.size())
+    return false;
+  connect_candidate_index_++;
+  ConnectToCandidate();
+  return true;
 }
 void ConferenceSocketSignalingChannel::Disconnect(
     std::function<void()> on_success,
@@ -427,14 +637,100 @@ void ConferenceSocketSignalingChannel::SendSubscriptionUpdateMessage(
   sio::message::ptr options,
   std::function<void()> on_success,
   std::function<void(std::unique_ptr<Exception>)> on_failure) {
+  std::string session_id("");
+  if (options != nullptr &&
+      options->get_flag() == sio::message::flag_object &&
+      options->get_map()["id"] != nullptr &&
+      options->get_map()["id"]->get_flag() == sio::message::flag_string) {
+    session_id = options->get_map()["id"]->get_string();
+  }
+  std::vector<std::function<void()>> on_successes;
+  std::vector<std::function<void(std::unique_ptr<Exception>)>> on_failures;
+  if (on_success) {
+    on_successes.push_back(on_success);
+  }
+  if (on_failure) {
+    on_failures.push_back(on_failure);
+  }
+  if (!session_id.empty()) {
+    std::lock_guard<std::mutex> lock(subscription_update_mutex_);
+    auto it = subscription_updates_.find(session_id);
+    if (it != subscription_updates_.end()) {
+      // An update for this session is waiting for its ack. Hold only the
+      // newest options; every held caller is answered by the ack of the
+      // message that carries them.
+      it->second.pending_options = options;
+      if (on_success) {
+        it->second.pending_successes.push_back(on_success);
+      }
+      if (on_failure) {
+        it->second.pending_failures.push_back(on_failure);
+      }
+      return;
+    }
+    subscription_updates_[session_id] = SubscriptionUpdateState();
+  }
+  SendSubscriptionUpdateInternal(session_id, options, on_successes,
+                                 on_failures);
+}
+void ConferenceSocketSignalingChannel::SendSubscriptionUpdateInternal(
+    const std::string& session_id,
+    sio::message::ptr options,
+    std::vector<std::function<void()>> on_successes,
+    std::vector<std::function<void(std::unique_ptr<Exception>)>> on_failures) {
   std::weak_ptr<ConferenceSocketSignalingChannel> weak_this =
     shared_from_this();
+  // Runs after the server answered (or the message was dropped); sends
+  // the update held for this session while this one was in flight.
+  auto complete = [weak_this, session_id]() {
+    auto that = weak_this.lock();
+    if (!that || session_id.empty()) {
+      return;
+    }
+    sio::message::ptr next_options;
+    std::vector<std::function<void()>> next_successes;
+    std::vector<std::function<void(std::unique_ptr<Exception>)>> next_failures;
+    {
+      std::lock_guard<std::mutex> lock(that->subscription_update_mutex_);
+      auto it = that->subscription_updates_.find(session_id);
+      if (it == that->subscription_updates_.end()) {
+        return;
+      }
+      if (it->second.pending_options == nullptr) {
+        that->subscription_updates_.erase(it);
+        return;
+      }
+      next_options = it->second.pending_options;
+      it->second.pending_options = nullptr;
+      next_successes.swap(it->second.pending_successes);
+      next_failures.swap(it->second.pending_failures);
+    }
+    that->SendSubscriptionUpdateInternal(session_id, next_options,
+                                         next_successes, next_failures);
+  };
+  auto success_all = [on_successes, complete]() {
+    for (auto& callback : on_successes) {
+      callback();
+    }
+    complete();
+  };
+  auto failure_all = [on_failures, complete](std::unique_ptr<Exception> e) {
+    for (auto& callback : on_failures) {
+      std::unique_ptr<Exception> exception(
+          new Exception(e->Type(), e->Message()));
+      callback(std::move(exception));
+    }
+    complete();
+  };
+  // Successive updates for the same session within the batching window
+  // still coalesce into one message; only the newest options are sent.
   Emit(kEventNameSubscriptionControl, options,
-    [weak_this, on_success, on_failure](sio::message::list const& msg) {
+    [weak_this, success_all, failure_all](sio::message::list const& msg) {
     if (auto that = weak_this.lock()) {
-      that->OnEmitAck(msg, on_success, on_failure);
+      that->OnEmitAck(msg, success_all, failure_all);
     }
-  }, on_failure);
+  }, failure_all,
+  session_id.empty() ? "" : kEventNameSubscriptionControl + "/" + session_id);
 }
 void ConferenceSocketSignalingChannel::SendInitializationMessage(
     sio::message::ptr options,
@@ -556,6 +852,189 @@ void ConferenceSocketSignalingChannel::SendCustomMessage(
        },
        on_failure);
 }
+void ConferenceSocketSignalingChannel::SendCustomMessage(
+    std::shared_ptr<const std::string> data,
+    const std::string& receiver,
+    std::function<void()> on_success,
+    std::function<void(std::unique_ptr<Exception>)> on_failure) {
+  if (data == nullptr) {
+    if (on_failure != nullptr) {
+      std::unique_ptr<Exception> e(new Exception(
+          ExceptionType::kConferenceUnknown, "Data cannot be nullptr."));
+      on_failure(std::move(e));
+    }
+    return;
+  }
+  std::string to = receiver == "" ? "all" : receiver;
+  std::weak_ptr<ConferenceSocketSignalingChannel> weak_this =
+      shared_from_this();
+  if (data->size() <= kMaxBinaryChunkSize) {
+    sio::message::ptr send_message = sio::object_message::create();
+    send_message->get_map()["to"] = sio::string_message::create(to);
+    // The payload shared_ptr travels to the socket layer as a binary
+    // attachment; it is neither copied nor escaped into JSON text.
+    send_message->get_map()["data"] = sio::binary_message::create(data);
+    Emit(kEventNameTextMessage, send_message,
+         [weak_this, on_success, on_failure](sio::message::list const& msg) {
+           if (auto that = weak_this.lock()) {
+             that->OnEmitAck(msg, on_success, on_failure);
+           }
+         },
+         on_failure);
+    return;
+  }
+  // Chunked path: every chunk is one emit; the message completes when all
+  // chunk acks arrived and fails on the first chunk failure.
+  size_t total =
+      (data->size() + kMaxBinaryChunkSize - 1) / kMaxBinaryChunkSize;
+  int message_id = 0;
+  {
+    std::lock_guard<std::mutex> lock(chunked_message_mutex_);
+    message_id = next_binary_message_id_++;
+  }
+  struct ChunkProgress {
+    std::mutex mutex;
+    size_t remaining;
+    bool failed = false;
+  };
+  auto progress = std::make_shared<ChunkProgress>();
+  progress->remaining = total;
+  for (size_t index = 0; index < total; index++) {
+    size_t offset = index * kMaxBinaryChunkSize;
+    auto chunk = std::make_shared<const std::string>(
+        data->substr(offset, kMaxBinaryChunkSize));
+    sio::message::ptr chunk_info = sio::object_message::create();
+    chunk_info->get_map()["id"] = sio::int_message::create(message_id);
+    chunk_info->get_map()["index"] =
+        sio::int_message::create(static_cast<int64_t>(index));
+    chunk_info->get_map()["total"] =
+        sio::int_message::create(static_cast<int64_t>(total));
+    sio::message::ptr send_message = sio::object_message::create();
+    send_message->get_map()["to"] = sio::string_message::create(to);
+    send_message->get_map()["data"] = sio::binary_message::create(chunk);
+    send_message->get_map()["chunk"] = chunk_info;
+    auto chunk_failure = [progress,
+                          on_failure](std::unique_ptr<Exception> e) {
+      {
+        std::lock_guard<std::mutex> lock(progress->mutex);
+        if (progress->failed) {
+          return;
+        }
+        progress->failed = true;
+      }
+      if (on_failure != nullptr) {
+        on_failure(std::move(e));
+      }
+    };
+    Emit(kEventNameTextMessage, send_message,
+         [weak_this, progress, on_success,
+          chunk_failure](sio::message::list const& msg) {
+           auto that = weak_this.lock();
+           if (!that) {
+             return;
+           }
+           that->OnEmitAck(
+               msg,
+               [progress, on_success] {
+                 bool done = false;
+                 {
+                   std::lock_guard<std::mutex> lock(progress->mutex);
+                   done = (--progress->remaining == 0) && !progress->failed;
+                 }
+                 if (done && on_success != nullptr) {
+                   on_success();
+                 }
+               },
+               chunk_failure);
+         },
+         chunk_failure);
+  }
+}
+void ConferenceSocketSignalingChannel::OnCustomMessageData(
+    std::string from,
+    std::string to,
+    sio::message::ptr data) {
+  std::string message;
+  auto text = GetField(data, "message");
+  auto binary = GetField(data, "data");
+  if (text != nullptr && text->get_flag() == sio::message::flag_string) {
+    message = text->get_string();
+  } else if (binary != nullptr &&
+             binary->get_flag() == sio::message::flag_binary) {
+    auto chunk_info = GetField(data, "chunk");
+    auto chunk_id = GetField(chunk_info, "id");
+    auto chunk_index = GetField(chunk_info, "index");
+    auto chunk_total = GetField(chunk_info, "total");
+    if (chunk_id != nullptr && chunk_index != nullptr &&
+        chunk_total != nullptr) {
+      int64_t id = chunk_id->get_int();
+      size_t index = static_cast<size_t>(chunk_index->get_int());
+      size_t total = static_cast<size_t>(chunk_total->get_int());
+      if (total == 0 || index >= total) {
+        RTC_LOG(LS_WARNING) << "Invalid chunk info in custom message.";
+        return;
+      }
+      std::string key = from + "/" + std::to_string(id);
+      {
+        std::lock_guard<std::mutex> lock(chunked_message_mutex_);
+        ChunkedMessage& chunked = incoming_chunked_messages_[key];
+        if (chunked.chunks.empty()) {
+          chunked.chunks.resize(total);
+        }
+        if (chunked.chunks.size() != total) {
+          RTC_LOG(LS_WARNING) << "Inconsistent chunk count for " << key;
+          incoming_chunked_messages_.erase(key);
+          return;
+        }
+        if (chunked.chunks[index].empty()) {
+          chunked.chunks[index] = *binary->get_binary();
+          chunked.received++;
+        }
+        if (chunked.received < total) {
+          return;
+        }
+        for (auto it = chunked.chunks.begin(); it != chunked.chunks.end();
+             ++it) {
+          message.append(*it);
+        }
+        incoming_chunked_messages_.erase(key);
+      }
+    } else {
+      message = *binary->get_binary();
+    }
+  } else {
+    RTC_LOG(LS_WARNING) << "Custom message carries no payload.";
+    return;
+  }
+  // Delivery is at least once: a queue replay after reconnect can
+  // re-send a message the server already relayed, and applications used
+  // to deduplicate the result with full-payload comparisons. A digest
+  // match inside the suppression window drops the duplicate here.
+  uint64_t digest = CustomMessageDigest(from, message);
+  {
+    std::lock_guard<std::mutex> lock(recent_digest_mutex_);
+    int64_t now_ms = rtc::TimeMillis();
+    if (recent_message_digests_.empty())
+      recent_message_digests_.resize(kRecentDigestRingCapacity);
+    for (const RecentMessageDigest& recent : recent_message_digests_) {
+      if (recent.time_ms != 0 && recent.digest == digest &&
+          now_ms - recent.time_ms < kDuplicateSuppressWindowMs) {
+        RTC_LOG(LS_INFO) << "Suppressed duplicate custom message from "
+                         << from;
+        std::lock_guard<std::mutex> stats_lock(outgoing_message_mutex_);
+        signaling_stats_.duplicate_messages_suppressed++;
+        return;
+      }
+    }
+    recent_message_digests_[recent_digest_index_].digest = digest;
+    recent_message_digests_[recent_digest_index_].time_ms = now_ms;
+    recent_digest_index_ =
+        (recent_digest_index_ + 1) % kRecentDigestRingCapacity;
+  }
+  for (auto it = observers_.begin(); it != observers_.end(); ++it) {
+    (*it)->OnCustomMessage(from, message, to);
+  }
+}
 void ConferenceSocketSignalingChannel::SendStreamControlMessage(
     const std::string& stream_id,
     const std::string& action,
@@ -604,6 +1083,58 @@ void ConferenceSocketSignalingChannel::SendSubscriptionControlMessage(
     },
         on_failure);
 }
+void ConferenceSocketSignalingChannel::SendBulkStreamControlMessage(
+    const std::vector<std::string>& session_ids,
+    const std::string& action,
+    const std::string& operation,
+    std::function<void()> on_success,
+    std::function<void(std::unique_ptr<Exception>)> on_failure) {
+  sio::message::ptr payload = sio::object_message::create();
+  sio::message::ptr ids = sio::array_message::create();
+  for (auto& session_id : session_ids) {
+    ids->get_vector().push_back(sio::string_message::create(session_id));
+  }
+  payload->get_map()["ids"] = ids;
+  payload->get_map()["operation"] = sio::string_message::create(operation);
+  if (operation == "pause" || operation == "play") {
+    payload->get_map()["data"] = sio::string_message::create(action);
+  }
+  std::weak_ptr<ConferenceSocketSignalingChannel> weak_this =
+      shared_from_this();
+  Emit(kEventNameStreamControl, payload,
+       [weak_this, on_success, on_failure](sio::message::list const& msg) {
+         if (auto that = weak_this.lock()) {
+           that->OnEmitAck(msg, on_success, on_failure);
+         }
+       },
+       on_failure);
+}
+void ConferenceSocketSignalingChannel::SendBulkSubscriptionControlMessage(
+    const std::vector<std::string>& session_ids,
+    const std::string& action,
+    const std::string& operation,
+    std::function<void()> on_success,
+    std::function<void(std::unique_ptr<Exception>)> on_failure) {
+  sio::message::ptr payload = sio::object_message::create();
+  sio::message::ptr ids = sio::array_message::create();
+  for (auto& session_id : session_ids) {
+    ids->get_vector().push_back(sio::string_message::create(session_id));
+  }
+  payload->get_map()["ids"] = ids;
+  payload->get_map()["operation"] = sio::string_message::create(operation);
+  if (operation == "pause" || operation == "play") {
+    payload->get_map()["data"] = sio::string_message::create(action);
+  }
+  std::weak_ptr<ConferenceSocketSignalingChannel> weak_this =
+      shared_from_this();
+  Emit(kEventNameSubscriptionControl, payload,
+       [weak_this, on_success, on_failure](sio::message::list const& msg) {
+         if (auto that = weak_this.lock()) {
+           that->OnEmitAck(msg, on_success, on_failure);
+         }
+       },
+       on_failure);
+}
 void ConferenceSocketSignalingChannel::Unsubscribe(
     const std::string& id,
     std::function<void()> on_success,
@@ -734,6 +1265,152 @@ void ConferenceSocketSignalingChannel::TriggerOnServerDisconnected() {
   }
 }
 void ConferenceSocketSignalingChannel::Emit(
+    const std::string& name,
+    const sio::message::list& message,
+    const std::function<void(sio::message::list const&)> ack,
+    const std::function<void(std::unique_ptr<Exception>)> on_failure,
+    const std::string& coalesce_key) {
+  if (!batch_signaling_enabled_) {
+    EmitOnSocket(name, message, ack, on_failure);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(batch_mutex_);
+    if (!coalesce_key.empty()) {
+      for (auto it = pending_batch_.begin(); it != pending_batch_.end();
+           ++it) {
+        if (it->name == name && it->coalesce_key == coalesce_key) {
+          // A newer update for the same session supersedes the queued
+          // one; both callers are acked when the merged message is.
+          it->message = message;
+          it->acks.push_back(ack);
+          it->failures.push_back(on_failure);
+          return;
+        }
+      }
+    }
+    PendingEmit pending;
+    pending.name = name;
+    pending.message = message;
+    pending.acks.push_back(ack);
+    pending.failures.push_back(on_failure);
+    pending.coalesce_key = coalesce_key;
+    pending_batch_.push_back(pending);
+  }
+  batch_wake_.notify_one();
+}
+void ConferenceSocketSignalingChannel::BatchLoop() {
+  std::unique_lock<std::mutex> lock(batch_mutex_);
+  while (!batch_thread_stop_) {
+    if (pending_batch_.empty()) {
+      batch_wake_.wait(lock);
+      continue;
+    }
+    // Let emits issued during the window join this flush; connection
+    // setup typically produces a burst of SOAC and candidate messages
+    // within a couple of milliseconds.
+    batch_wake_.wait_until(
+        lock,
+        std::chrono::steady_clock::now() +
+            std::chrono::milliseconds(kBatchWindowMs),
+        [this] { return batch_thread_stop_; });
+    if (batch_thread_stop_) {
+      break;
+    }
+    std::vector<PendingEmit> batch;
+    batch.swap(pending_batch_);
+    lock.unlock();
+    FlushBatch(std::move(batch));
+    lock.lock();
+  }
+}
+void ConferenceSocketSignalingChannel::FlushBatch(
+    std::vector<PendingEmit> batch) {
+  if (batch.empty()) {
+    return;
+  }
+  if (batch.size() == 1) {
+    const PendingEmit& pending = batch[0];
+    auto acks = pending.acks;
+    auto failures = pending.failures;
+    EmitOnSocket(pending.name, pending.message,
+                 [acks](sio::message::list const& msg) {
+                   for (auto& ack : acks) {
+                     if (ack) {
+                       ack(msg);
+                     }
+                   }
+                 },
+                 [failures](std::unique_ptr<Exception> e) {
+                   for (auto& failure : failures) {
+                     if (failure) {
+                       failure(std::unique_ptr<Exception>(new Exception(
+                           e->Type(), e->Message())));
+                     }
+                   }
+                 });
+    return;
+  }
+  // Pack all pending messages into a single batch packet. Each element
+  // carries the original event name and argument list; the server acks
+  // with an array of per-message ack lists in the same order. Control
+  // plane messages go first so the server handles them before any
+  // application data collected in the same window.
+  std::stable_partition(batch.begin(), batch.end(), [](const PendingEmit& p) {
+    return IsControlPlaneEvent(p.name);
+  });
+  sio::message::ptr payload = sio::array_message::create();
+  std::vector<std::vector<std::function<void(sio::message::list const&)>>>
+      batch_acks;
+  std::vector<std::function<void(std::unique_ptr<Exception>)>> batch_failures;
+  for (auto it = batch.begin(); it != batch.end(); ++it) {
+    sio::message::ptr element = sio::object_message::create();
+    element->get_map()["name"] = sio::string_message::create(it->name);
+    sio::message::ptr data = sio::array_message::create();
+    for (unsigned int i = 0; i < it->message.size(); i++) {
+      data->get_vector().push_back(it->message.at(i));
+    }
+    element->get_map()["data"] = data;
+    payload->get_vector().push_back(element);
+    batch_acks.push_back(it->acks);
+    for (auto& failure : it->failures) {
+      batch_failures.push_back(failure);
+    }
+  }
+  EmitOnSocket(
+      kEventNameBatch, payload,
+      [batch_acks](sio::message::list const& msg) {
+        if (msg.size() < 1 || msg.at(0) == nullptr ||
+            msg.at(0)->get_flag() != sio::message::flag_array) {
+          RTC_LOG(LS_WARNING) << "Invalid ack for batched messages.";
+          return;
+        }
+        auto& results = msg.at(0)->get_vector();
+        for (size_t i = 0; i < batch_acks.size() && i < results.size(); i++) {
+          sio::message::list sub_ack;
+          if (results[i] != nullptr &&
+              results[i]->get_flag() == sio::message::flag_array) {
+            for (auto& item : results[i]->get_vector()) {
+              sub_ack.push(item);
+            }
+          }
+          for (auto& ack : batch_acks[i]) {
+            if (ack) {
+              ack(sub_ack);
+            }
+          }
+        }
+      },
+      [batch_failures](std::unique_ptr<Exception> e) {
+        for (auto& failure : batch_failures) {
+          if (failure) {
+            failure(std::unique_ptr<Exception>(
+                new Exception(e->Type(), e->Message())));
+          }
+        }
+      });
+}
+void ConferenceSocketSignalingChannel::EmitOnSocket(
     const std::string& name,
     const sio::message::list& message,
     const std::function<void(sio::message::list const&)> ack,
@@ -751,12 +1428,35 @@ void ConferenceSocketSignalingChannel::Emit(
   new_message.insert(0, request_name);
 #endif
   // SioMessage sio_message(message_id, sio_name, new_message, ack, on_failure);
-  SioMessage sio_message(message_id, name, message, ack, on_failure);
+  // The queue keeps the original message so a replay after reconnect
+  // re-negotiates the encoding instead of double-packing the payload.
+  OWT_TRACE_INSTANT("Signaling.Emit");
+  size_t accounted_bytes = EstimateMessageListSize(message);
+  MemoryAccounting::Add(kOutgoingQueueCategory, accounted_bytes);
+  SioMessage sio_message(message_id, name, message, ack, on_failure,
+                         accounted_bytes, rtc::TimeMillis());
   outgoing_messages_.push(sio_message);
+  {
+    std::lock_guard<std::mutex> lock(outgoing_message_mutex_);
+    if (outgoing_messages_.size() > signaling_stats_.max_outstanding_acks)
+      signaling_stats_.max_outstanding_acks = outgoing_messages_.size();
+  }
+  sio::message::list wire_message(message);
+  if (binary_signaling_enabled_) {
+    // Pack the whole argument list into one msgpack binary frame.
+    sio::message::ptr packed = sio::array_message::create();
+    for (unsigned int i = 0; i < message.size(); i++) {
+      packed->get_vector().push_back(message.at(i));
+    }
+    wire_message = sio::message::list(
+        sio::binary_message::create(SioMsgpack::Encode(packed)));
+  }
   std::weak_ptr<ConferenceSocketSignalingChannel> weak_this =
       shared_from_this();
   socket_client_->socket()->emit(
-      name, message, [weak_this, message_id](sio::message::list const& msg) {
+      name, wire_message,
+      [weak_this, message_id](sio::message::list const& msg) {
+        OWT_TRACE_INSTANT("Signaling.Ack");
         RTC_LOG(LS_INFO) << "Received ack for message ID: " << message_id;
         auto that = weak_this.lock();
         if (!that) {
@@ -774,13 +1474,33 @@ void ConferenceSocketSignalingChannel::Emit(
               << "Unordered Socket.IO message.";*/
           while (that->outgoing_messages_.front().id < message_id) {
             RTC_LOG(LS_WARNING) << "Potential unordered Socket.IO message.";
+            MemoryAccounting::Release(
+                kOutgoingQueueCategory,
+                that->outgoing_messages_.front().accounted_bytes);
             that->outgoing_messages_.pop();
           }
           if (that->outgoing_messages_.front().id > message_id) {
             RTC_LOG(LS_ERROR) << "Original message for " << message_id
                           << " is not found.";
           }
+          const SioMessage& acked = that->outgoing_messages_.front();
+          // Record the emit-to-ack round trip under the event name.
+          int64_t rtt_ms = rtc::TimeMillis() - acked.emit_time_ms;
+          MessageRttStats& rtt_stats =
+              that->signaling_stats_.rtt_by_type[acked.name];
+          rtt_stats.count++;
+          rtt_stats.total_ms += rtt_ms;
+          if (rtt_ms > rtt_stats.max_ms)
+            rtt_stats.max_ms = rtt_ms;
+          int bucket = 0;
+          while (bucket < kRttBucketCount - 1 &&
+                 rtt_ms > kRttBucketBoundsMs[bucket])
+            bucket++;
+          rtt_stats.buckets[bucket]++;
           callback = that->outgoing_messages_.front().ack;
+          MemoryAccounting::Release(
+              kOutgoingQueueCategory,
+              that->outgoing_messages_.front().accounted_bytes);
           that->outgoing_messages_.pop();
         }
         if (callback) {
@@ -792,16 +1512,43 @@ void ConferenceSocketSignalingChannel::DropQueuedMessages() {
   // TODO(jianjunz): Trigger on_failure in another thread. In current
   // implementation, failure callback MUST NOT acquire
   // |outgoing_message_mutex_|. Otherwise, deadlock may happen.
-  std::lock_guard<std::mutex> lock(outgoing_message_mutex_);
-  while (!outgoing_messages_.empty()) {
-    if (outgoing_messages_.front().on_failure != nullptr) {
-      std::unique_ptr<Exception> e(new Exception(
-          ExceptionType::kConferenceInvalidSession,
-          "Failed to delivery message."));
-      outgoing_messages_.front().on_failure(std::move(e));
+  {
+    std::lock_guard<std::mutex> lock(outgoing_message_mutex_);
+    signaling_stats_.drop_events++;
+    signaling_stats_.dropped_messages += outgoing_messages_.size();
+    while (!outgoing_messages_.empty()) {
+      if (outgoing_messages_.front().on_failure != nullptr) {
+        std::unique_ptr<Exception> e(new Exception(
+            ExceptionType::kConferenceInvalidSession,
+            "Failed to delivery message."));
+        outgoing_messages_.front().on_failure(std::move(e));
+      }
+      MemoryAccounting::Release(kOutgoingQueueCategory,
+                                outgoing_messages_.front().accounted_bytes);
+      outgoing_messages_.pop();
     }
-    outgoing_messages_.pop();
   }
+  std::vector<PendingEmit> dropped;
+  {
+    std::lock_guard<std::mutex> lock(batch_mutex_);
+    dropped.swap(pending_batch_);
+  }
+  for (auto it = dropped.begin(); it != dropped.end(); ++it) {
+    for (auto& failure : it->failures) {
+      if (failure != nullptr) {
+        std::unique_ptr<Exception> e(new Exception(
+            ExceptionType::kConferenceInvalidSession,
+            "Failed to delivery message."));
+        failure(std::move(e));
+      }
+    }
+  }
+}
+bool ConferenceSocketSignalingChannel::IsControlPlaneEvent(
+    const std::string& name) {
+  // Custom messages carry the application's own traffic (chat, file
+  // notifications, ...); everything else sets up or tears down sessions.
+  return name != kEventNameCustomMessage;
 }
 void ConferenceSocketSignalingChannel::DrainQueuedMessages() {
   std::queue<SioMessage> temp_queue;
@@ -809,16 +1556,71 @@ void ConferenceSocketSignalingChannel::DrainQueuedMessages() {
     std::lock_guard<std::mutex> lock(outgoing_message_mutex_);
     std::swap(temp_queue, outgoing_messages_);
   }
-  RTC_LOG(LS_INFO) << "outgoing_messages_ number after swap: "
-               << outgoing_messages_.size();
+  // Replay control plane messages before application data so a queued SDP
+  // or ICE message is not stuck behind bulk custom messages. Order within
+  // each priority class is preserved.
+  std::vector<SioMessage> control_messages;
+  std::vector<SioMessage> data_messages;
+  size_t queued_count = temp_queue.size();
   while (!temp_queue.empty()) {
-    auto sio_message = temp_queue.front();
-    // MUST release |outgoing_message_mutex_| before Emit because Emit acquires
-    // mutex.
-    Emit(sio_message.name, sio_message.message, sio_message.ack,
-         sio_message.on_failure);
+    auto& sio_message = temp_queue.front();
+    if (IsControlPlaneEvent(sio_message.name)) {
+      control_messages.push_back(sio_message);
+    } else {
+      data_messages.push_back(sio_message);
+    }
+    // The message leaves the queue here; replaying it below goes through
+    // Emit and is accounted again.
+    MemoryAccounting::Release(kOutgoingQueueCategory,
+                              sio_message.accounted_bytes);
     temp_queue.pop();
   }
+  int64_t drain_start_ms = rtc::TimeMillis();
+  // MUST NOT hold |outgoing_message_mutex_| here because Emit acquires
+  // mutex.
+  for (auto it = control_messages.begin(); it != control_messages.end(); ++it) {
+    Emit(it->name, it->message, it->ack, it->on_failure);
+  }
+  for (auto it = data_messages.begin(); it != data_messages.end(); ++it) {
+    Emit(it->name, it->message, it->ack, it->on_failure);
+  }
+  int64_t drain_duration_ms = rtc::TimeMillis() - drain_start_ms;
+  {
+    std::lock_guard<std::mutex> lock(outgoing_message_mutex_);
+    last_drain_duration_ms_ = drain_duration_ms;
+  }
+  RTC_LOG(LS_INFO) << "Drained " << queued_count << " queued messages ("
+                   << control_messages.size() << " control plane, "
+                   << data_messages.size() << " data) in " << drain_duration_ms
+                   << "ms.";
+}
+void ConferenceSocketSignalingChannel::GetSignalingStats(
+    std::function<void(const SignalingStats&)> callback) {
+  if (!callback)
+    return;
+  SignalingStats snapshot;
+  {
+    std::lock_guard<std::mutex> lock(outgoing_message_mutex_);
+    snapshot = signaling_stats_;
+    snapshot.outstanding_acks = outgoing_messages_.size();
+  }
+  callback(snapshot);
+}
+int ConferenceSocketSignalingChannel::OutgoingQueueDepth() {
+  size_t depth = 0;
+  {
+    std::lock_guard<std::mutex> lock(outgoing_message_mutex_);
+    depth = outgoing_messages_.size();
+  }
+  {
+    std::lock_guard<std::mutex> lock(batch_mutex_);
+    depth += pending_batch_.size();
+  }
+  return static_cast<int>(depth);
+}
+int64_t ConferenceSocketSignalingChannel::LastDrainDurationMs() {
+  std::lock_guard<std::mutex> lock(outgoing_message_mutex_);
+  return last_drain_duration_ms_;
 }
 sio::message::ptr ConferenceSocketSignalingChannel::ResolutionMessage(
     const owt::base::Resolution& resolution) {
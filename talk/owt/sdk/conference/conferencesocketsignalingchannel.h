@@ -3,11 +3,14 @@
 // SPDX-License-Identifier: Apache-2.0
 #ifndef conference_ConferenceSocketSignalingChannel_h
 #define conference_ConferenceSocketSignalingChannel_h
+#include <condition_variable>
 #include <memory>
 #include <future>
 #include <queue>
 #include <random>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 #include "talk/owt/include/sio_client.h"
 #include "talk/owt/include/sio_message.h"
 #include "talk/owt/sdk/include/cpp/owt/conference/conferenceclient.h"
@@ -56,6 +59,15 @@ class ConferenceSocketSignalingChannel
       const std::string& receiver,
       std::function<void()> on_success,
       std::function<void(std::unique_ptr<Exception>)> on_failure);
+  // Send a binary payload to |receiver|. The payload is handed to the
+  // socket layer as a binary attachment without being copied or escaped
+  // into JSON text. Payloads larger than one websocket frame are split
+  // into chunks and reassembled on the receiving side.
+  virtual void SendCustomMessage(
+      std::shared_ptr<const std::string> data,
+      const std::string& receiver,
+      std::function<void()> on_success,
+      std::function<void(std::unique_ptr<Exception>)> on_failure);
   virtual void SendStreamControlMessage(
       const std::string& stream_id,
       const std::string& action,
@@ -68,6 +80,21 @@ class ConferenceSocketSignalingChannel
       const std::string& operation,
       std::function<void()> on_success,
       std::function<void(std::unique_ptr<Exception>)> on_failure);
+  // Send one control message carrying many session IDs, so bulk
+  // operations (e.g. muting a whole room) cost one round trip instead of
+  // one per session.
+  virtual void SendBulkStreamControlMessage(
+      const std::vector<std::string>& session_ids,
+      const std::string& action,
+      const std::string& operation,
+      std::function<void()> on_success,
+      std::function<void(std::unique_ptr<Exception>)> on_failure);
+  virtual void SendBulkSubscriptionControlMessage(
+      const std::vector<std::string>& session_ids,
+      const std::string& action,
+      const std::string& operation,
+      std::function<void()> on_success,
+      std::function<void(std::unique_ptr<Exception>)> on_failure);
   virtual void SendSubscriptionUpdateMessage(
       sio::message::ptr options,
       std::function<void()> on_success,
@@ -79,6 +106,62 @@ class ConferenceSocketSignalingChannel
   virtual void Disconnect(
       std::function<void()> on_success,
       std::function<void(std::unique_ptr<Exception>)> on_failure);
+  /// Number of outgoing messages waiting for an ack or a replay,
+  /// including messages still in the batching window.
+  virtual int OutgoingQueueDepth();
+  /// Wall time the last |DrainQueuedMessages| replay took, or 0 if no
+  /// replay happened yet.
+  virtual int64_t LastDrainDurationMs();
+  /// Number of RTT histogram buckets. The bucket upper bounds in
+  /// milliseconds are |kRttBucketBoundsMs|; the last bucket is unbounded.
+  static const int kRttBucketCount = 9;
+  static const int64_t kRttBucketBoundsMs[kRttBucketCount - 1];
+  /// Emit-to-ack round trip statistics for one message type.
+  struct MessageRttStats {
+    MessageRttStats() : count(0), total_ms(0), max_ms(0), buckets() {}
+    uint64_t count;
+    int64_t total_ms;
+    int64_t max_ms;
+    uint64_t buckets[kRttBucketCount];
+  };
+  /// Snapshot of signaling transport health counters. RTT histograms
+  /// separate server-side slowness (growing RTTs) from client-side
+  /// queueing (growing outstanding acks with stable RTTs).
+  struct SignalingStats {
+    SignalingStats()
+        : outstanding_acks(0),
+          max_outstanding_acks(0),
+          reconnect_count(0),
+          drop_events(0),
+          dropped_messages(0),
+          duplicate_messages_suppressed(0),
+          connect_attempt_count(0),
+          connect_duration_ms(0) {}
+    /// Emit-to-ack RTT histogram per socket.io event name.
+    std::unordered_map<std::string, MessageRttStats> rtt_by_type;
+    /// Messages currently waiting for an ack.
+    size_t outstanding_acks;
+    /// Largest number of simultaneously outstanding acks observed.
+    size_t max_outstanding_acks;
+    /// Socket.IO reconnection attempts since connect.
+    uint64_t reconnect_count;
+    /// Times the outgoing queue was dropped (DropQueuedMessages).
+    uint64_t drop_events;
+    /// Messages discarded across all drop events.
+    uint64_t dropped_messages;
+    /// Incoming custom messages dropped as duplicates of a recently
+    /// delivered message (at-least-once replays after reconnect).
+    uint64_t duplicate_messages_suppressed;
+    /// Connection attempts made by the last Connect, counting endpoint
+    /// failovers.
+    uint32_t connect_attempt_count;
+    /// Time from the last attempt's start to the socket opening.
+    int64_t connect_duration_ms;
+  };
+  /// Invokes |callback| synchronously with a snapshot of the current
+  /// counters.
+  virtual void GetSignalingStats(
+      std::function<void(const SignalingStats&)> callback);
  protected:
   virtual void OnEmitAck(
       sio::message::list const& msg,
@@ -93,30 +176,106 @@ class ConferenceSocketSignalingChannel
         const sio::message::list& message,
         const std::function<void(sio::message::list const&)> ack,
         const std::function<void(std::unique_ptr<Exception>)>
-            on_failure)
+            on_failure,
+        const size_t accounted_bytes,
+        const int64_t emit_time_ms)
         : id(id),
           name(name),
           message(message),
           ack(ack),
-          on_failure(on_failure){};
+          on_failure(on_failure),
+          accounted_bytes(accounted_bytes),
+          emit_time_ms(emit_time_ms){};
     const int id;
     const std::string name;
     const sio::message::list message;
     const std::function<void(sio::message::list const&)> ack;
     const std::function<void(std::unique_ptr<Exception>)> on_failure;
+    // Estimated payload size reported to MemoryAccounting while the
+    // message waits in |outgoing_messages_|; released on ack or drop.
+    const size_t accounted_bytes;
+    // When the message was first emitted; ack arrival minus this is the
+    // RTT recorded in |signaling_stats_|.
+    const int64_t emit_time_ms;
+  };
+  // Coalescing state for subscription updates on one session. While an
+  // update is waiting for its ack, later updates are held here with
+  // last-write-wins semantics and sent as one message when the ack
+  // arrives, so a burst of updates costs at most two round trips.
+  struct SubscriptionUpdateState {
+    sio::message::ptr pending_options;
+    std::vector<std::function<void()>> pending_successes;
+    std::vector<std::function<void(std::unique_ptr<Exception>)>>
+        pending_failures;
   };
+  // Sends one subscription update and, once it completes, sends the
+  // newest update held for the session while it was in flight.
+  void SendSubscriptionUpdateInternal(
+      const std::string& session_id,
+      sio::message::ptr options,
+      std::vector<std::function<void()>> on_successes,
+      std::vector<std::function<void(std::unique_ptr<Exception>)>>
+          on_failures);
+  // Reassembly state for one incoming chunked binary message.
+  struct ChunkedMessage {
+    std::vector<std::string> chunks;
+    size_t received = 0;
+  };
+  // Handles one incoming custom message, reassembling chunked binary
+  // payloads, and dispatches it to the observers.
+  void OnCustomMessageData(std::string from,
+                           std::string to,
+                           sio::message::ptr data);
+  // Starts a socket.io connect to the current endpoint candidate and
+  // records the attempt.
+  void ConnectToCandidate();
+  // Advances to the next endpoint candidate after a failed initial
+  // connect. Returns false when no candidate is left or the session is
+  // past its initial connect, in which case the caller proceeds with the
+  // normal failure path.
+  bool TryNextConnectCandidate();
   /// Fires upon a new ticket is received.
   void OnReconnectionTicket(const std::string& ticket);
   void RefreshReconnectionTicket();
   void TriggerOnServerDisconnected();
+  // An emit waiting in the batching window. |acks| and |failures| hold
+  // the callbacks of every message coalesced into this entry.
+  struct PendingEmit {
+    std::string name;
+    sio::message::list message;
+    std::vector<std::function<void(sio::message::list const&)>> acks;
+    std::vector<std::function<void(std::unique_ptr<Exception>)>> failures;
+    std::string coalesce_key;
+  };
+  // Emit |message| under event |name|. When batching is negotiated,
+  // messages queued within the batching window are packed into a single
+  // batch packet. A non-empty |coalesce_key| makes the message replace a
+  // pending message with the same key instead of appending another
+  // packet; successive subscription updates for one session use this.
   void Emit(const std::string& name,
             const sio::message::list& message,
             const std::function<void(sio::message::list const&)> ack,
-            const std::function<void(std::unique_ptr<Exception>)>
-                on_failure);
+            const std::function<void(std::unique_ptr<Exception>)> on_failure,
+            const std::string& coalesce_key = "");
+  // Sends one message (or one packed batch) on the socket immediately.
+  void EmitOnSocket(const std::string& name,
+                    const sio::message::list& message,
+                    const std::function<void(sio::message::list const&)> ack,
+                    const std::function<void(std::unique_ptr<Exception>)>
+                        on_failure);
+  // Runs on |batch_thread_|; flushes the pending batch when the batching
+  // window closes.
+  void BatchLoop();
+  void FlushBatch(std::vector<PendingEmit> batch);
+  // Returns false for application data events (custom messages) and true
+  // for everything that drives session setup (SDP, publish, subscribe,
+  // stream control, ...). Control plane messages are replayed first after
+  // a reconnection.
+  static bool IsControlPlaneEvent(const std::string& name);
   // Clean message queue and triggered failure callback for all queued messages.
   void DropQueuedMessages();
-  // Re-emit queued message.
+  // Re-emit queued message. Control plane messages are emitted before
+  // application data so media setup does not wait behind bulk traffic.
   void DrainQueuedMessages();
   // Convert an resolution object to a sio message.
   sio::message::ptr ResolutionMessage(
@@ -128,13 +287,62 @@ class ConferenceSocketSignalingChannel
   std::function<void()> disconnect_complete_;
   std::string reconnection_ticket_;
   std::string participant_id_;
+  // Signaling endpoints parsed from the token's host field, which may
+  // carry several comma-separated entries when edge clusters front the
+  // room behind more than one VIP. The initial connect walks the list so
+  // a dead VIP costs one attempt instead of the whole connect budget;
+  // reconnection sticks to the endpoint that issued the ticket.
+  std::vector<std::string> connect_candidates_;
+  size_t connect_candidate_index_;
+  int64_t connect_attempt_start_ms_;
   int reconnection_attempted_;
   bool is_reconnection_;
+  // True if the server accepted msgpack encoding during login. Outgoing
+  // messages are then packed into binary frames and binary frames from
+  // the server are decoded before dispatch; see SioMsgpack.
+  bool binary_signaling_enabled_;
+  // True if the server accepted batched emits during login.
+  bool batch_signaling_enabled_;
+  std::vector<PendingEmit> pending_batch_;
+  std::mutex batch_mutex_;
+  std::condition_variable batch_wake_;
+  std::thread batch_thread_;
+  bool batch_thread_stop_;
   // Messages may be lost if during Socket.IO reconnection. We maintain a
   // message queue here so we can emit un-acked messages after connected.
+  // Partially received chunked binary messages, keyed by sender and
+  // message ID. Guarded by |chunked_message_mutex_|.
+  std::unordered_map<std::string, ChunkedMessage> incoming_chunked_messages_;
+  std::mutex chunked_message_mutex_;
+  // Ring of digests of recently delivered custom messages, guarded by
+  // |recent_digest_mutex_|. Delivery is at least once - a replay after
+  // reconnect can re-send a message the server already relayed - and
+  // the protocol has no envelope field for a sequence number, so the
+  // digest of sender and payload stands in as the message ID; a match
+  // inside the suppression window is dropped before dispatch.
+  struct RecentMessageDigest {
+    RecentMessageDigest() : digest(0), time_ms(0) {}
+    uint64_t digest;
+    int64_t time_ms;
+  };
+  std::vector<RecentMessageDigest> recent_message_digests_;
+  size_t recent_digest_index_;
+  std::mutex recent_digest_mutex_;
+  // Sessions with a subscription update in flight, guarded by
+  // |subscription_update_mutex_|.
+  std::unordered_map<std::string, SubscriptionUpdateState>
+      subscription_updates_;
+  std::mutex subscription_update_mutex_;
+  int next_binary_message_id_;
   std::queue<SioMessage> outgoing_messages_;
   int outgoing_message_id_;
   std::mutex outgoing_message_mutex_;
+  // Duration of the last queue replay, guarded by |outgoing_message_mutex_|.
+  int64_t last_drain_duration_ms_;
+  // Transport health counters, guarded by |outgoing_message_mutex_|.
+  // |outstanding_acks| is computed from |outgoing_messages_| at snapshot
+  // time rather than maintained here.
+  SignalingStats signaling_stats_;
 };
 }
 }
@@ -17,6 +17,7 @@ ConferenceSubscription::ConferenceSubscription(std::shared_ptr<ConferenceClient>
       : id_(sub_id),
         stream_id_(stream_id),
         ended_(false),
+        suspended_(false),
         conference_client_(client) {
   auto that = conference_client_.lock();
   if (that != nullptr)
@@ -93,6 +94,58 @@ void ConferenceSubscription::Unmute(
    }
 }
 
+void ConferenceSubscription::Suspend(
+    std::function<void()> on_success,
+    std::function<void(std::unique_ptr<Exception>)> on_failure) {
+  auto that = conference_client_.lock();
+  if (that == nullptr || ended_) {
+    std::string failure_message("Session ended.");
+    if (on_failure != nullptr && event_queue_.get()) {
+      event_queue_->PostTask([on_failure, failure_message]() {
+        std::unique_ptr<Exception> e(new Exception(
+            ExceptionType::kConferenceInvalidParam, failure_message));
+        on_failure(std::move(e));
+      });
+    }
+  } else {
+    std::weak_ptr<ConferenceSubscription> weak_this = shared_from_this();
+    that->Suspend(id_,
+                  [on_success, weak_this]() {
+                    auto that_cs = weak_this.lock();
+                    if (that_cs && !that_cs->Ended())
+                      that_cs->suspended_ = true;
+                    if (on_success != nullptr)
+                      on_success();
+                  },
+                  on_failure);
+  }
+}
+void ConferenceSubscription::Resume(
+    std::function<void()> on_success,
+    std::function<void(std::unique_ptr<Exception>)> on_failure) {
+  auto that = conference_client_.lock();
+  if (that == nullptr || ended_) {
+    std::string failure_message("Session ended.");
+    if (on_failure != nullptr && event_queue_.get()) {
+      event_queue_->PostTask([on_failure, failure_message]() {
+        std::unique_ptr<Exception> e(new Exception(
+            ExceptionType::kConferenceInvalidParam, failure_message));
+        on_failure(std::move(e));
+      });
+    }
+  } else {
+    std::weak_ptr<ConferenceSubscription> weak_this = shared_from_this();
+    that->Resume(id_,
+                 [on_success, weak_this]() {
+                   auto that_cs = weak_this.lock();
+                   if (that_cs && !that_cs->Ended())
+                     that_cs->suspended_ = false;
+                   if (on_success != nullptr)
+                     on_success();
+                 },
+                 on_failure);
+  }
+}
 void ConferenceSubscription::GetStats(
     std::function<void(std::shared_ptr<ConnectionStats>)> on_success,
     std::function<void(std::unique_ptr<Exception>)> on_failure) {
@@ -150,11 +203,140 @@ void ConferenceSubscription::GetNativeStats(
      that->GetStats(id_, on_success, on_failure);
    }
 }
+void ConferenceSubscription::EnableAdaptiveQos(
+    const SubscriptionQosPolicy& policy) {
+  uint64_t generation = 0;
+  {
+    const std::lock_guard<std::mutex> lock(qos_mutex_);
+    qos_policy_ = policy;
+    generation = ++qos_generation_;
+    qos_have_baseline_ = false;
+    qos_bitrate_multiplier_ = 1.0;
+    qos_hold_remaining_ = 0;
+  }
+  if (event_queue_.get()) {
+    std::weak_ptr<ConferenceSubscription> weak_this = shared_from_this();
+    event_queue_->PostDelayedTask(
+        [weak_this, generation]() {
+          auto that_cs = weak_this.lock();
+          if (that_cs)
+            that_cs->QosTick(generation);
+        },
+        policy.poll_interval_ms);
+  }
+}
+void ConferenceSubscription::DisableAdaptiveQos() {
+  const std::lock_guard<std::mutex> lock(qos_mutex_);
+  // Pending ticks observe the stale generation and stop themselves.
+  ++qos_generation_;
+}
+void ConferenceSubscription::SetPlayoutDelay(int min_ms, int max_ms) {
+  auto that = conference_client_.lock();
+  if (that == nullptr || ended_)
+    return;
+  that->SetPlayoutDelay(id_, min_ms, max_ms);
+}
+void ConferenceSubscription::SetAudioPlayoutGain(double gain) {
+  auto that = conference_client_.lock();
+  if (that == nullptr || ended_)
+    return;
+  that->SetAudioPlayoutGain(id_, gain);
+}
+void ConferenceSubscription::QosTick(uint64_t generation) {
+  {
+    const std::lock_guard<std::mutex> lock(qos_mutex_);
+    if (generation != qos_generation_)
+      return;
+  }
+  if (ended_)
+    return;
+  std::weak_ptr<ConferenceSubscription> weak_this = shared_from_this();
+  GetStats(
+      [weak_this, generation](std::shared_ptr<ConnectionStats> stats) {
+        auto that_cs = weak_this.lock();
+        if (that_cs)
+          that_cs->OnQosStats(generation, stats);
+      },
+      [weak_this, generation](std::unique_ptr<Exception> e) {
+        // Stats can fail transiently around renegotiation; keep polling.
+        auto that_cs = weak_this.lock();
+        if (that_cs)
+          that_cs->OnQosStats(generation, nullptr);
+      });
+}
+void ConferenceSubscription::OnQosStats(
+    uint64_t generation,
+    std::shared_ptr<ConnectionStats> stats) {
+  double new_multiplier = 0;
+  int poll_interval_ms = 0;
+  {
+    const std::lock_guard<std::mutex> lock(qos_mutex_);
+    if (generation != qos_generation_)
+      return;
+    poll_interval_ms = qos_policy_.poll_interval_ms;
+    if (stats != nullptr && !stats->video_receiver_reports.empty()) {
+      const VideoReceiverReport& report =
+          *stats->video_receiver_reports.front();
+      int64_t delta_rcvd = report.packets_rcvd - qos_last_packets_rcvd_;
+      int64_t delta_lost = report.packets_lost - qos_last_packets_lost_;
+      bool have_baseline = qos_have_baseline_;
+      qos_last_packets_rcvd_ = report.packets_rcvd;
+      qos_last_packets_lost_ = report.packets_lost;
+      qos_have_baseline_ = true;
+      if (have_baseline && delta_rcvd + delta_lost > 0 && delta_lost >= 0) {
+        double loss_percent =
+            100.0 * delta_lost / static_cast<double>(delta_rcvd + delta_lost);
+        // Rendering stalled while packets keep arriving counts as a
+        // freeze and triggers a downgrade like excessive delay does.
+        bool frozen = report.framerate_output == 0 && delta_rcvd > 0;
+        if (qos_hold_remaining_ > 0) {
+          qos_hold_remaining_--;
+        } else if (loss_percent > qos_policy_.downgrade_loss_percent ||
+                   report.delay > qos_policy_.downgrade_delay_ms || frozen) {
+          double lowered = qos_bitrate_multiplier_ / 2;
+          if (lowered < qos_policy_.min_bitrate_multiplier)
+            lowered = qos_policy_.min_bitrate_multiplier;
+          if (lowered != qos_bitrate_multiplier_) {
+            qos_bitrate_multiplier_ = lowered;
+            new_multiplier = lowered;
+            qos_hold_remaining_ = qos_policy_.hold_intervals;
+          }
+        } else if (loss_percent < qos_policy_.upgrade_loss_percent &&
+                   qos_bitrate_multiplier_ < 1.0) {
+          double raised = qos_bitrate_multiplier_ * 2;
+          if (raised > 1.0)
+            raised = 1.0;
+          qos_bitrate_multiplier_ = raised;
+          new_multiplier = raised;
+          qos_hold_remaining_ = qos_policy_.hold_intervals;
+        }
+      }
+    }
+  }
+  if (new_multiplier != 0) {
+    RTC_LOG(LS_INFO) << "Adaptive QoS sets bitrate multiplier to "
+                     << new_multiplier << " on subscription " << id_;
+    SubscriptionUpdateOptions options;
+    options.video.bitrateMultiplier = new_multiplier;
+    ApplyOptions(options, nullptr, nullptr);
+  }
+  if (event_queue_.get()) {
+    std::weak_ptr<ConferenceSubscription> weak_this = shared_from_this();
+    event_queue_->PostDelayedTask(
+        [weak_this, generation]() {
+          auto that_cs = weak_this.lock();
+          if (that_cs)
+            that_cs->QosTick(generation);
+        },
+        poll_interval_ms);
+  }
+}
 void ConferenceSubscription::Stop() {
   auto that = conference_client_.lock();
   if (that == nullptr || ended_) {
     return;
   } else {
+    DisableAdaptiveQos();
     that->UnSubscribe(id_, nullptr, nullptr);
     ended_ = true;
     const std::lock_guard<std::mutex> lock(observer_mutex_);
@@ -33,6 +33,37 @@ void RemoteMixedStream::OnVideoLayoutChanged() {
     (*its).get().OnVideoLayoutChanged();
   }
 }
+void RemoteMixedStream::OnVideoLayoutChanged(
+    const std::vector<VideoLayoutRegion>& layout) {
+  std::vector<VideoLayoutRegion> changed_regions;
+  {
+    std::lock_guard<std::mutex> lock(layout_mutex_);
+    std::unordered_map<std::string, VideoLayoutRegion> new_layout;
+    for (auto& region : layout) {
+      new_layout[region.region_id] = region;
+      auto it = last_layout_.find(region.region_id);
+      if (it == last_layout_.end() || !(it->second == region)) {
+        changed_regions.push_back(region);
+      }
+    }
+    // Regions dropped from the layout are reported once with an empty
+    // stream ID.
+    for (auto& old_region : last_layout_) {
+      if (new_layout.find(old_region.first) == new_layout.end()) {
+        VideoLayoutRegion removed = old_region.second;
+        removed.stream_id = "";
+        changed_regions.push_back(removed);
+      }
+    }
+    last_layout_ = std::move(new_layout);
+  }
+  if (changed_regions.empty()) {
+    return;
+  }
+  for (auto its = observers_.begin(); its != observers_.end(); ++its) {
+    (*its).get().OnVideoLayoutChanged(changed_regions);
+  }
+}
 void RemoteMixedStream::OnActiveInputChanged(const std::string& stream_id) {
   for (auto its = observers_.begin(); its != observers_.end(); ++its) {
     (*its).get().OnActiveInputChanged(stream_id);
@@ -0,0 +1,318 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include <cstring>
+#include "talk/owt/sdk/conference/siomsgpack.h"
+#include "webrtc/rtc_base/logging.h"
+namespace owt {
+namespace conference {
+static void AppendBigEndian(std::string& out, uint64_t value, int bytes) {
+  for (int i = bytes - 1; i >= 0; i--) {
+    out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+static bool ReadBigEndian(const std::string& payload,
+                          size_t& offset,
+                          int bytes,
+                          uint64_t* value) {
+  if (offset + bytes > payload.size()) {
+    return false;
+  }
+  uint64_t result = 0;
+  for (int i = 0; i < bytes; i++) {
+    result = (result << 8) | static_cast<uint8_t>(payload[offset + i]);
+  }
+  offset += bytes;
+  *value = result;
+  return true;
+}
+static void AppendStringHeader(std::string& out, size_t length) {
+  if (length < 32) {
+    out.push_back(static_cast<char>(0xa0 | length));
+  } else if (length <= 0xff) {
+    out.push_back(static_cast<char>(0xd9));
+    AppendBigEndian(out, length, 1);
+  } else if (length <= 0xffff) {
+    out.push_back(static_cast<char>(0xda));
+    AppendBigEndian(out, length, 2);
+  } else {
+    out.push_back(static_cast<char>(0xdb));
+    AppendBigEndian(out, length, 4);
+  }
+}
+std::shared_ptr<const std::string> SioMsgpack::Encode(
+    sio::message::ptr message) {
+  auto out = std::make_shared<std::string>();
+  EncodeTo(message, *out);
+  return out;
+}
+void SioMsgpack::EncodeTo(const sio::message::ptr& message, std::string& out) {
+  if (message == nullptr) {
+    out.push_back(static_cast<char>(0xc0));
+    return;
+  }
+  switch (message->get_flag()) {
+    case sio::message::flag_null:
+      out.push_back(static_cast<char>(0xc0));
+      break;
+    case sio::message::flag_boolean:
+      out.push_back(static_cast<char>(message->get_bool() ? 0xc3 : 0xc2));
+      break;
+    case sio::message::flag_integer: {
+      int64_t value = message->get_int();
+      if (value >= 0) {
+        uint64_t unsigned_value = static_cast<uint64_t>(value);
+        if (unsigned_value < 0x80) {
+          out.push_back(static_cast<char>(unsigned_value));
+        } else if (unsigned_value <= 0xff) {
+          out.push_back(static_cast<char>(0xcc));
+          AppendBigEndian(out, unsigned_value, 1);
+        } else if (unsigned_value <= 0xffff) {
+          out.push_back(static_cast<char>(0xcd));
+          AppendBigEndian(out, unsigned_value, 2);
+        } else if (unsigned_value <= 0xffffffff) {
+          out.push_back(static_cast<char>(0xce));
+          AppendBigEndian(out, unsigned_value, 4);
+        } else {
+          out.push_back(static_cast<char>(0xcf));
+          AppendBigEndian(out, unsigned_value, 8);
+        }
+      } else if (value >= -32) {
+        out.push_back(static_cast<char>(value));
+      } else if (value >= INT8_MIN) {
+        out.push_back(static_cast<char>(0xd0));
+        AppendBigEndian(out, static_cast<uint8_t>(value), 1);
+      } else if (value >= INT16_MIN) {
+        out.push_back(static_cast<char>(0xd1));
+        AppendBigEndian(out, static_cast<uint16_t>(value), 2);
+      } else if (value >= INT32_MIN) {
+        out.push_back(static_cast<char>(0xd2));
+        AppendBigEndian(out, static_cast<uint32_t>(value), 4);
+      } else {
+        out.push_back(static_cast<char>(0xd3));
+        AppendBigEndian(out, static_cast<uint64_t>(value), 8);
+      }
+      break;
+    }
+    case sio::message::flag_double: {
+      double value = message->get_double();
+      uint64_t bits = 0;
+      std::memcpy(&bits, &value, sizeof(bits));
+      out.push_back(static_cast<char>(0xcb));
+      AppendBigEndian(out, bits, 8);
+      break;
+    }
+    case sio::message::flag_string: {
+      const std::string& value = message->get_string();
+      AppendStringHeader(out, value.size());
+      out.append(value);
+      break;
+    }
+    case sio::message::flag_binary: {
+      auto value = message->get_binary();
+      size_t length = value == nullptr ? 0 : value->size();
+      if (length <= 0xff) {
+        out.push_back(static_cast<char>(0xc4));
+        AppendBigEndian(out, length, 1);
+      } else if (length <= 0xffff) {
+        out.push_back(static_cast<char>(0xc5));
+        AppendBigEndian(out, length, 2);
+      } else {
+        out.push_back(static_cast<char>(0xc6));
+        AppendBigEndian(out, length, 4);
+      }
+      if (value != nullptr) {
+        out.append(*value);
+      }
+      break;
+    }
+    case sio::message::flag_array: {
+      const std::vector<sio::message::ptr>& items = message->get_vector();
+      if (items.size() < 16) {
+        out.push_back(static_cast<char>(0x90 | items.size()));
+      } else if (items.size() <= 0xffff) {
+        out.push_back(static_cast<char>(0xdc));
+        AppendBigEndian(out, items.size(), 2);
+      } else {
+        out.push_back(static_cast<char>(0xdd));
+        AppendBigEndian(out, items.size(), 4);
+      }
+      for (auto it = items.begin(); it != items.end(); ++it) {
+        EncodeTo(*it, out);
+      }
+      break;
+    }
+    case sio::message::flag_object: {
+      const std::map<std::string, sio::message::ptr>& members =
+          message->get_map();
+      if (members.size() < 16) {
+        out.push_back(static_cast<char>(0x80 | members.size()));
+      } else if (members.size() <= 0xffff) {
+        out.push_back(static_cast<char>(0xde));
+        AppendBigEndian(out, members.size(), 2);
+      } else {
+        out.push_back(static_cast<char>(0xdf));
+        AppendBigEndian(out, members.size(), 4);
+      }
+      for (auto it = members.begin(); it != members.end(); ++it) {
+        AppendStringHeader(out, it->first.size());
+        out.append(it->first);
+        EncodeTo(it->second, out);
+      }
+      break;
+    }
+  }
+}
+sio::message::ptr SioMsgpack::Decode(
+    const std::shared_ptr<const std::string>& payload) {
+  if (payload == nullptr) {
+    return nullptr;
+  }
+  size_t offset = 0;
+  sio::message::ptr result = DecodeOne(*payload, offset);
+  if (result == nullptr || offset != payload->size()) {
+    RTC_LOG(LS_WARNING) << "Malformed msgpack signaling payload.";
+    return nullptr;
+  }
+  return result;
+}
+sio::message::ptr SioMsgpack::DecodeOne(const std::string& payload,
+                                        size_t& offset) {
+  if (offset >= payload.size()) {
+    return nullptr;
+  }
+  uint8_t marker = static_cast<uint8_t>(payload[offset++]);
+  // Positive and negative fixint.
+  if (marker < 0x80) {
+    return sio::int_message::create(marker);
+  }
+  if (marker >= 0xe0) {
+    return sio::int_message::create(static_cast<int8_t>(marker));
+  }
+  uint64_t length = 0;
+  // Fixstr, fixarray and fixmap markers carry their length inline.
+  if ((marker & 0xf0) == 0x80 || (marker & 0xf0) == 0x90) {
+    length = marker & 0x0f;
+  } else if ((marker & 0xe0) == 0xa0) {
+    length = marker & 0x1f;
+  }
+  if ((marker & 0xe0) == 0xa0 || marker == 0xd9 || marker == 0xda ||
+      marker == 0xdb) {
+    if (marker == 0xd9 && !ReadBigEndian(payload, offset, 1, &length))
+      return nullptr;
+    if (marker == 0xda && !ReadBigEndian(payload, offset, 2, &length))
+      return nullptr;
+    if (marker == 0xdb && !ReadBigEndian(payload, offset, 4, &length))
+      return nullptr;
+    if (offset + length > payload.size())
+      return nullptr;
+    sio::message::ptr result =
+        sio::string_message::create(payload.substr(offset, length));
+    offset += length;
+    return result;
+  }
+  if (marker == 0xc4 || marker == 0xc5 || marker == 0xc6) {
+    int length_bytes = marker == 0xc4 ? 1 : marker == 0xc5 ? 2 : 4;
+    if (!ReadBigEndian(payload, offset, length_bytes, &length))
+      return nullptr;
+    if (offset + length > payload.size())
+      return nullptr;
+    auto binary =
+        std::make_shared<const std::string>(payload.substr(offset, length));
+    offset += length;
+    return sio::binary_message::create(binary);
+  }
+  if ((marker & 0xf0) == 0x90 || marker == 0xdc || marker == 0xdd) {
+    if (marker == 0xdc && !ReadBigEndian(payload, offset, 2, &length))
+      return nullptr;
+    if (marker == 0xdd && !ReadBigEndian(payload, offset, 4, &length))
+      return nullptr;
+    sio::message::ptr result = sio::array_message::create();
+    for (uint64_t i = 0; i < length; i++) {
+      sio::message::ptr item = DecodeOne(payload, offset);
+      if (item == nullptr)
+        return nullptr;
+      result->get_vector().push_back(item);
+    }
+    return result;
+  }
+  if ((marker & 0xf0) == 0x80 || marker == 0xde || marker == 0xdf) {
+    if (marker == 0xde && !ReadBigEndian(payload, offset, 2, &length))
+      return nullptr;
+    if (marker == 0xdf && !ReadBigEndian(payload, offset, 4, &length))
+      return nullptr;
+    sio::message::ptr result = sio::object_message::create();
+    for (uint64_t i = 0; i < length; i++) {
+      sio::message::ptr key = DecodeOne(payload, offset);
+      if (key == nullptr || key->get_flag() != sio::message::flag_string)
+        return nullptr;
+      sio::message::ptr value = DecodeOne(payload, offset);
+      if (value == nullptr)
+        return nullptr;
+      result->get_map()[key->get_string()] = value;
+    }
+    return result;
+  }
+  switch (marker) {
+    case 0xc0:
+      return sio::null_message::create();
+    case 0xc2:
+      return sio::bool_message::create(false);
+    case 0xc3:
+      return sio::bool_message::create(true);
+    case 0xcb: {
+      uint64_t bits = 0;
+      if (!ReadBigEndian(payload, offset, 8, &bits))
+        return nullptr;
+      double value = 0;
+      std::memcpy(&value, &bits, sizeof(value));
+      return sio::double_message::create(value);
+    }
+    case 0xcc:
+    case 0xcd:
+    case 0xce:
+    case 0xcf: {
+      int bytes = 1 << (marker - 0xcc);
+      uint64_t value = 0;
+      if (!ReadBigEndian(payload, offset, bytes, &value))
+        return nullptr;
+      return sio::int_message::create(static_cast<int64_t>(value));
+    }
+    case 0xd0:
+    case 0xd1:
+    case 0xd2:
+    case 0xd3: {
+      int bytes = 1 << (marker - 0xd0);
+      uint64_t value = 0;
+      if (!ReadBigEndian(payload, offset, bytes, &value))
+        return nullptr;
+      int64_t signed_value = 0;
+      switch (bytes) {
+        case 1:
+          signed_value = static_cast<int8_t>(value);
+          break;
+        case 2:
+          signed_value = static_cast<int16_t>(value);
+          break;
+        case 4:
+          signed_value = static_cast<int32_t>(value);
+          break;
+        default:
+          signed_value = static_cast<int64_t>(value);
+          break;
+      }
+      return sio::int_message::create(signed_value);
+    }
+    default:
+      return nullptr;
+  }
+}
+sio::message::ptr SioMsgpack::DecodeIfBinary(sio::message::ptr message) {
+  if (message == nullptr || message->get_flag() != sio::message::flag_binary) {
+    return message;
+  }
+  sio::message::ptr decoded = Decode(message->get_binary());
+  return decoded == nullptr ? message : decoded;
+}
+}
+}
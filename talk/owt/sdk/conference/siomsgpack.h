@@ -0,0 +1,36 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef conference_SioMsgpack_h
+#define conference_SioMsgpack_h
+#include <memory>
+#include <string>
+#include "talk/owt/include/sio_message.h"
+namespace owt {
+namespace conference {
+// Encoder and decoder between sio::message trees and msgpack payloads.
+// Used by ConferenceSocketSignalingChannel when the server negotiates
+// binary signaling at login time. Encoding the message tree directly
+// skips the JSON text serialization inside the socket.io client and
+// roughly halves signaling size for format-heavy messages.
+class SioMsgpack {
+ public:
+  // Encode |message| into a msgpack payload.
+  static std::shared_ptr<const std::string> Encode(sio::message::ptr message);
+  // Decode a msgpack |payload| back into a message tree. Returns nullptr
+  // if the payload is malformed.
+  static sio::message::ptr Decode(
+      const std::shared_ptr<const std::string>& payload);
+  // Returns the decoded tree if |message| is a binary msgpack payload,
+  // otherwise returns |message| unchanged. Listeners use this so they
+  // handle both encodings transparently.
+  static sio::message::ptr DecodeIfBinary(sio::message::ptr message);
+
+ private:
+  static void EncodeTo(const sio::message::ptr& message, std::string& out);
+  static sio::message::ptr DecodeOne(const std::string& payload,
+                                     size_t& offset);
+};
+}
+}
+#endif  // conference_SioMsgpack_h
@@ -0,0 +1,39 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef conference_SioUtils_h
+#define conference_SioUtils_h
+#include <string>
+#include "talk/owt/include/sio_message.h"
+namespace owt {
+namespace conference {
+// Non-mutating field access for sio::message trees.
+//
+// sio::message exposes object fields through get_map(), whose operator[]
+// default-inserts a null entry for every missing key it is probed with.
+// Inbound handlers that inspect optional fields this way allocate one
+// map node per probe on every event, which adds up during join storms
+// in large rooms. These helpers use find() and never grow the tree.
+// Returns the field named |key|, or nullptr when |message| is not an
+// object or the field is absent.
+inline sio::message::ptr GetField(const sio::message::ptr& message,
+                                  const std::string& key) {
+  if (message == nullptr || message->get_flag() != sio::message::flag_object)
+    return nullptr;
+  const std::map<std::string, sio::message::ptr>& fields = message->get_map();
+  auto it = fields.find(key);
+  return it == fields.end() ? nullptr : it->second;
+}
+// Returns the string field named |key|, or |default_value| when the
+// field is absent or not a string.
+inline std::string GetStringField(const sio::message::ptr& message,
+                                  const std::string& key,
+                                  const std::string& default_value = "") {
+  sio::message::ptr field = GetField(message, key);
+  if (field == nullptr || field->get_flag() != sio::message::flag_string)
+    return default_value;
+  return field->get_string();
+}
+}
+}
+#endif  // conference_SioUtils_h
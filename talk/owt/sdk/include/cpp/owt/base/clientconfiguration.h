@@ -13,7 +13,8 @@ namespace base{
 struct ClientConfiguration {
   enum class CandidateNetworkPolicy : int { kAll = 1, kLowCost };
   ClientConfiguration()
-       : candidate_network_policy(CandidateNetworkPolicy::kAll) {};
+       : candidate_network_policy(CandidateNetworkPolicy::kAll),
+         ice_candidate_pool_size(0) {};
   /// List of ICE servers
   std::vector<IceServer> ice_servers;
   /**
@@ -23,6 +24,17 @@ struct ClientConfiguration {
    network experience. Default policy is collecting all candidates.
    */
   CandidateNetworkPolicy candidate_network_policy;
+  /**
+   @brief Number of ICE candidate allocations to gather ahead of need.
+   @details With a value above zero, candidate gathering for that many
+   sessions starts when a peer connection is created instead of after
+   the first offer, so it overlaps signaling and takes the gathering
+   round trips - easily a few hundred milliseconds with TURN - off
+   session setup. Each pooled allocation holds sockets and TURN
+   allocations while unused, so size the pool to the number of sessions
+   expected to start back to back. Default 0 gathers on demand.
+   */
+  int ice_candidate_pool_size;
 };
 }
 }
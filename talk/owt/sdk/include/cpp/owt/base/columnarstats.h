@@ -0,0 +1,53 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_COLUMNARSTATS_H_
+#define OWT_BASE_COLUMNARSTATS_H_
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "owt/base/connectionstats.h"
+namespace owt {
+namespace base {
+/**
+ @brief Serializes a multi-session statistics snapshot into one columnar
+ binary buffer.
+ @details The buffer holds flat little-endian arrays, one per metric, so
+ an exporter ships the statistics of every session with a single write
+ instead of converting object graphs field by field. Layout:
+
+   0   "OWTC" magic
+   4   uint32 format version
+   8   uint64 serialization time, milliseconds since the Unix epoch
+   16  uint32 session count
+   20  uint32 audio sender, audio receiver, video sender and video
+       receiver report counts, one uint32 each
+   36  uint32 string blob offset from the buffer start
+   40  uint32 string blob size
+   44  session table: per session one (uint32 offset, uint32 length)
+       pair into the string blob, sorted by session id
+
+ Four report groups follow, one per report kind in the order above. A
+ group is a sequence of arrays, each as long as its report count:
+ uint32 session index (into the session table), the numeric metrics of
+ the report struct in declaration order (int64 byte counters and round
+ trip times, int32 everything else, resolutions as width then height
+ arrays), then (uint32 offset, uint32 length) pairs referencing the
+ codec name in the string blob. The deduplicated string blob closes the
+ buffer; all offsets into it are blob relative.
+*/
+class ColumnarStatsWriter {
+ public:
+  /// Format version written into the buffer header.
+  static const uint32_t kFormatVersion = 1;
+  /// Serialize |snapshot|, mapping session IDs to their statistics, into
+  /// one self-contained buffer.
+  static std::vector<uint8_t> Serialize(
+      const std::unordered_map<std::string, std::shared_ptr<ConnectionStats>>&
+          snapshot);
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_COLUMNARSTATS_H_
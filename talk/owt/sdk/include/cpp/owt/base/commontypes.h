@@ -29,6 +29,16 @@ enum class VideoCodec : int {
   kH265,
   kUnknown
 };
+/// Content hint for a local video track.
+/// Tells the engine what to preserve when the connection degrades:
+/// motion content drops resolution first, detail and text content drop
+/// framerate first and keep encoded frames legible.
+enum class VideoContentHint : int {
+  kNone = 0,  ///< Let the engine decide (default).
+  kMotion,    ///< Smooth motion matters most, e.g. camera video.
+  kDetail,    ///< Spatial detail matters most, e.g. screen sharing.
+  kText       ///< Text legibility matters most, e.g. document sharing.
+};
 /// Track kind
 enum class TrackKind : int{
   kAudio = 1,
@@ -72,6 +82,10 @@ struct AudioEncodingParameters {
       : codec(codec_param), max_bitrate(bitrate_bps) {}
   AudioEncodingParameters(const AudioEncodingParameters& aep) = default;
   AudioEncodingParameters& operator=(const AudioEncodingParameters&) = default;
+  // The declared copy operations above suppress the implicit moves;
+  // restore them so option structs can transfer these by move.
+  AudioEncodingParameters(AudioEncodingParameters&&) = default;
+  AudioEncodingParameters& operator=(AudioEncodingParameters&&) = default;
   AudioCodecParameters codec;
   unsigned long max_bitrate;
 };
@@ -99,6 +113,10 @@ struct VideoEncodingParameters {
         hardware_accelerated(hw) {}
   VideoEncodingParameters(const VideoEncodingParameters& aep) = default;
   VideoEncodingParameters& operator=(const VideoEncodingParameters&) = default;
+  // See AudioEncodingParameters: keep the moves the copy declarations
+  // would otherwise suppress; moving avoids copying |codec.profile|.
+  VideoEncodingParameters(VideoEncodingParameters&&) = default;
+  VideoEncodingParameters& operator=(VideoEncodingParameters&&) = default;
   VideoCodecParameters codec;
   unsigned long max_bitrate;
   bool hardware_accelerated;
@@ -31,9 +31,11 @@ struct AudioSenderReport {
 /// Define audio receiver report
 struct AudioReceiverReport {
   AudioReceiverReport(int64_t bytes_rcvd, int32_t packets_rcvd,
-                      int32_t packets_lost, int32_t estimated_delay, std::string codec_name)
+                      int32_t packets_lost, int32_t estimated_delay,
+                      int32_t audio_output_level, std::string codec_name)
       : bytes_rcvd(bytes_rcvd), packets_rcvd(packets_rcvd), packets_lost(packets_lost)
-      , estimated_delay(estimated_delay), codec_name(codec_name) {}
+      , estimated_delay(estimated_delay), audio_output_level(audio_output_level)
+      , codec_name(codec_name) {}
   /// Audio bytes received
   int64_t bytes_rcvd;
   /// Audio packets received
@@ -42,6 +44,8 @@ struct AudioReceiverReport {
   int32_t packets_lost;
   /// Audio delay estimated with unit of millisecond
   int32_t estimated_delay;
+  /// Playout level of the received track, 0 - 32767; 0 when silent
+  int32_t audio_output_level;
   /// Audio codec name for receiving
   std::string codec_name;
 };
@@ -129,7 +133,8 @@ struct VideoReceiverReport {
 struct VideoBandwidthStats {
   VideoBandwidthStats() : available_send_bandwidth(0), available_receive_bandwidth(0)
                         , transmit_bitrate(0), retransmit_bitrate(0)
-                        , target_encoding_bitrate(0), actual_encoding_bitrate(0) {}
+                        , target_encoding_bitrate(0), actual_encoding_bitrate(0)
+                        , pacer_queue_delay_ms(0), padding_bitrate(0) {}
   /// Available video bandwidth for sending, unit: bps
   int32_t available_send_bandwidth;
   /// Available video bandwidth for receiving, unit: bps
@@ -142,6 +147,14 @@ struct VideoBandwidthStats {
   int32_t target_encoding_bitrate;
   /// Actual encoding bitrate, unit: bps
   int32_t actual_encoding_bitrate;
+  /// Time packets currently spend waiting in the send pacer's queue,
+  /// unit: millisecond. A sustained rise after screen-content keyframes
+  /// means the pacer cap is throttling bursts; see
+  /// PublishOptions::max_pacing_bitrate_bps.
+  int32_t pacer_queue_delay_ms;
+  /// Send bitrate spent on padding, unit: bps. Derived as transmit
+  /// bitrate minus media and retransmissions, floored at zero.
+  int32_t padding_bitrate;
 };
 /// Define ICE candidate report
 struct IceCandidateReport {
@@ -191,6 +204,78 @@ struct IceCandidatePairReport {
   /// Remote candidate of this pair.
   std::shared_ptr<IceCandidateReport> remote_ice_candidate;
 };
+/// Inter-frame-gap distribution of one receive-pipeline measuring point.
+struct VideoFreezeReport {
+  VideoFreezeReport() : freeze_count(0), max_gap_ms(0) {}
+  /// Stage the gaps were measured at, "decode" or "render".
+  std::string stage;
+  /// Stream the report belongs to. Empty when the measuring stage cannot
+  /// be tied to one stream (hardware decoder instances carry no stream
+  /// identity); such a report covers the whole process and appears in
+  /// every session's statistics.
+  std::string stream_id;
+  /// Upper bound of each histogram bucket with unit of millisecond.
+  std::vector<int64_t> gap_bounds_ms;
+  /// Observed inter-frame gaps per bucket. The final entry counts gaps
+  /// above the last bound, so this is one entry longer than
+  /// |gap_bounds_ms|.
+  std::vector<int64_t> gap_counts;
+  /// Gaps at or above the configured freeze threshold.
+  int64_t freeze_count;
+  /// Longest observed inter-frame gap with unit of millisecond.
+  int64_t max_gap_ms;
+};
+typedef std::vector<VideoFreezeReport> VideoFreezeReports;
+/// Latency percentiles of one internal media pipeline stage.
+struct PipelineStageReport {
+  PipelineStageReport(const std::string& stage, int64_t p50_latency_ms,
+                      int64_t p99_latency_ms, int64_t sample_count)
+      : stage(stage), p50_latency_ms(p50_latency_ms),
+        p99_latency_ms(p99_latency_ms), sample_count(sample_count) {}
+  /// Stage name, e.g. "capture" or "hardware_encode".
+  std::string stage;
+  /// Median stage latency with unit of millisecond.
+  int64_t p50_latency_ms;
+  /// 99th percentile stage latency with unit of millisecond.
+  int64_t p99_latency_ms;
+  /// Number of samples the percentiles were computed over.
+  int64_t sample_count;
+};
+/**
+ @brief Queries latency metrics of the internal media pipeline.
+ @details The SDK continuously timestamps frames at capture, encode and
+ render and keeps recent samples in per-stage ring buffers. Collection is
+ always on and cheap enough for production use.
+*/
+class PipelineLatencyStats {
+ public:
+  /// Returns p50/p99 latency reports over the recent samples of each stage.
+  static std::vector<PipelineStageReport> GetStageReports();
+};
+/// Deadline statistics for one customized audio capturer.
+struct AudioCapturePacingReport {
+  AudioCapturePacingReport(int64_t late_wakeup_count, int64_t max_drift_ms,
+                           int64_t underrun_count)
+      : late_wakeup_count(late_wakeup_count), max_drift_ms(max_drift_ms),
+        underrun_count(underrun_count) {}
+  /// Number of 10ms deliveries that started noticeably after their deadline.
+  int64_t late_wakeup_count;
+  /// Largest observed delivery drift with unit of millisecond.
+  int64_t max_drift_ms;
+  /// Number of deliveries skipped because no generated frame was ready.
+  int64_t underrun_count;
+};
+/**
+ @brief Queries pacing health of the customized audio capture path.
+ @details Counters are accumulated on the audio delivery path without
+ waiting and indicate whether the 10ms cadence is holding under load,
+ before drift becomes an audible glitch.
+*/
+class AudioCapturePacingStats {
+ public:
+  /// Returns one report per audio capturer currently recording.
+  static std::vector<AudioCapturePacingReport> GetReports();
+};
 typedef std::unique_ptr<AudioSenderReport> AudioSenderReportPtr;
 typedef std::vector<AudioSenderReportPtr> AudioSenderReports;
 typedef std::unique_ptr<AudioReceiverReport> AudioReceiverReportPtr;
@@ -224,6 +309,9 @@ struct ConnectionStats {
   IceCandidateReports remote_ice_candidate_reports;
   /// ICE candidate pair reports
   IceCandidatePairReports ice_candidate_pair_reports;
+  /// Inter-frame-gap and freeze reports for the session's subscribed
+  /// video; empty when the session carries no subscribed video.
+  VideoFreezeReports video_freeze_reports;
 };
 } // namespace base
 } // namespace owt
@@ -11,6 +11,9 @@ namespace base {
 class DeviceUtils {
  public:
   /// Get video capturer IDs.
+  /// Results are cached for a few seconds because OS device enumeration
+  /// can cost tens to hundreds of milliseconds; call
+  /// InvalidateCachedDeviceInfo() to force a fresh enumeration earlier.
   static std::vector<std::string> VideoCapturerIds();
   /**
    Get supported resolutions for a specific video capturer.
@@ -20,6 +23,15 @@ class DeviceUtils {
    */
   static std::vector<Resolution> VideoCapturerSupportedResolutions(
       const std::string& id);
+  /**
+   Drop cached device enumeration results.
+   @details The next VideoCapturerIds() or
+   VideoCapturerSupportedResolutions() call re-enumerates. Applications
+   that receive device hot-plug notifications (WM_DEVICECHANGE, udev)
+   should call this when the notification fires so the cache never
+   serves unplugged devices.
+   */
+  static void InvalidateCachedDeviceInfo();
 };
 }
 }
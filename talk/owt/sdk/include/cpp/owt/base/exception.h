@@ -42,12 +42,29 @@ class Exception {
     @param message Exception message.
   */
   Exception(const ExceptionType& type, const std::string& message);
+  /**
+    @brief Constructor with type and a literal message.
+    @details The literal is stored by pointer, so constructing the
+    exception does not allocate; the string is materialized only when
+    Message() is called. Expected high-frequency failures (a reconnect
+    storm rejecting every queued request, for example) stay cheap when
+    the application ignores the message. |message| must be a string
+    literal or otherwise outlive the exception.
+    @param type Exception type.
+    @param message Exception message literal.
+  */
+  Exception(const ExceptionType& type, const char* message);
   virtual ~Exception() {}
   /**
     @brief Get exception type.
     @return Exception type.
   */
   ExceptionType Type() const;
+  /**
+    @brief Get the exception type's numeric code.
+    @return Numeric code, e.g. 2403 for kP2PClientInvalidState.
+  */
+  int Code() const;
   /**
     @brief Get exception message.
     @return Exception message.
@@ -55,6 +72,9 @@ class Exception {
   std::string Message() const;
  private:
   const ExceptionType type_;
+  // Set by the literal constructor; Message() reads it before
+  // |message_| so no string is built until asked for.
+  const char* literal_message_;
   const std::string message_;
 };
 }
@@ -24,12 +24,65 @@ class AudioFrameGeneratorInterface {
    */
   virtual uint32_t GenerateFramesForNext10Ms(uint8_t* buffer,
                                              const uint32_t capacity) = 0;
+  /**
+   @brief Generate frames for the next |frame_count| x 10ms in one call.
+   @details Batching amortizes the per-call and per-wakeup overhead when many
+   injected audio streams run in one process. The default implementation
+   loops over GenerateFramesForNext10Ms so existing generators keep working;
+   implementations serving many streams should override it.
+   @param buffer Points to the start address of the arena. The memory is
+   allocated and owned by SDK. Frames are written back to back, each
+   capacity / frame_count bytes long.
+   @param capacity Arena capacity. It will be equal or greater to
+   frame_count times the expected 10ms frame size.
+   @param frame_count Number of 10ms frames requested.
+   @return The total number of bytes actually written.
+   */
+  virtual uint32_t GenerateFramesForNextNx10Ms(uint8_t* buffer,
+                                               const uint32_t capacity,
+                                               const uint32_t frame_count) {
+    uint32_t frame_capacity = frame_count == 0 ? 0 : capacity / frame_count;
+    uint32_t written = 0;
+    for (uint32_t i = 0; i < frame_count; i++) {
+      uint32_t frame_size =
+          GenerateFramesForNext10Ms(buffer + written, frame_capacity);
+      if (frame_size == 0)
+        break;
+      written += frame_size;
+    }
+    return written;
+  }
   /// Get sample rate for frames generated.
   virtual int GetSampleRate() = 0;
   /// Get numbers of channel for frames generated.
   virtual int GetChannelNumber() = 0;
   virtual ~AudioFrameGeneratorInterface(){};
 };
+/**
+ @brief Writable I420 plane set handed to a video frame generator.
+ @details Plane pointers reference memory allocated and owned by SDK. The
+ buffer described here is the very buffer delivered downstream, so filling it
+ directly avoids any intermediate frame copy. Strides may be larger than the
+ visible width; implementations must honor them when writing rows.
+*/
+struct VideoFramePlaneSet {
+  /// Start address of the Y plane.
+  uint8_t* data_y;
+  /// Start address of the U plane.
+  uint8_t* data_u;
+  /// Start address of the V plane.
+  uint8_t* data_v;
+  /// Stride in bytes of the Y plane.
+  int stride_y;
+  /// Stride in bytes of the U plane.
+  int stride_u;
+  /// Stride in bytes of the V plane.
+  int stride_v;
+  /// Visible width of the frame, in pixels.
+  int width;
+  /// Visible height of the frame, in pixels.
+  int height;
+};
 /**
  @brief frame generator interface for users to generates frame.
  FrameGeneratorInterface is the virtual class to implement its own frame generator.
@@ -40,6 +93,19 @@ class VideoFrameGeneratorInterface {
     I420,
     VP8,
     H264,
+    /// Raw NV12 frames. When the stream is consumed by a hardware encoder
+    /// this avoids the NV12 to I420 and back conversions on CPU.
+    NV12,
+    /// Frames produced as D3D11 textures. GenerateNextFrame fills a
+    /// D3D11ImageHandle structure instead of pixel data; the texture itself
+    /// never touches system memory. Windows only.
+    D3D11Handle,
+    /// Frames produced as CVPixelBuffers. GenerateNextFrame writes a
+    /// retained CVPixelBufferRef instead of pixel data; ownership of the
+    /// reference transfers to the SDK, which releases it when the frame
+    /// leaves the pipeline. IOSurface-backed buffers reach the
+    /// VideoToolbox encoder without a plane copy. Apple platforms only.
+    CVPixelBufferHandle,
   };
   /**
    @brief This function generates one frame data.
@@ -53,6 +119,40 @@ class VideoFrameGeneratorInterface {
   VideoFrameGeneratorInterface() {};
   virtual uint32_t GenerateNextFrame(uint8_t* buffer,
                                      const uint32_t capacity) = 0;
+  /**
+   @brief Indicates whether this generator writes frames in-place.
+   @details Only valid for I420 generators. When it returns true, SDK calls
+   GenerateNextFrame(const VideoFramePlaneSet&) with the buffer that is
+   delivered to the encoder instead of the contiguous-buffer overload, which
+   removes the intermediate frame copies on the injection path.
+   @return true if in-place generation is supported.
+   */
+  virtual bool SupportsPlaneSetGeneration() { return false; }
+  /**
+   @brief This function generates one frame directly into |planes|.
+   @details Called only when SupportsPlaneSetGeneration() returns true.
+   Implementations fill exactly planes.width x planes.height pixels,
+   respecting each plane's stride.
+   @param planes Writable I420 plane set allocated and owned by SDK.
+   @return true if a frame was written; false to skip this capture cycle.
+   */
+  virtual bool GenerateNextFrame(const VideoFramePlaneSet& planes) {
+    return false;
+  }
+  /**
+   @brief Timestamp of the frame the next GenerateNextFrame call returns.
+   @details Applications that stamp frames at the source - a pipeline
+   that knows when the original event happened - can return that time
+   here to carry it into the captured frame instead of having the SDK
+   stamp local read time. The engine preserves the spacing of these
+   timestamps when translating them onto its own clock, so the RTP
+   timestamps a subscriber sees track the application clock and rendered
+   frames can be correlated with source events for end-to-end latency
+   accounting.
+   @return Frame timestamp in milliseconds on the application's clock,
+   or -1 (the default) to keep SDK capture-time stamping.
+   */
+  virtual int64_t GetNextFrameTimestampMs() { return -1; }
   virtual ~VideoFrameGeneratorInterface() {};
   /**
    @brief This function gets the size of next video frame.
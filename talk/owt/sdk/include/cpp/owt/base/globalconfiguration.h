@@ -3,7 +3,11 @@
 // SPDX-License-Identifier: Apache-2.0
 #ifndef OWT_BASE_GLOBALCONFIGURATION_H_
 #define OWT_BASE_GLOBALCONFIGURATION_H_
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 #include "owt/base/framegeneratorinterface.h"
 #if defined(WEBRTC_WIN) || defined(WEBRTC_LINUX)
 #include "owt/base/videodecoderinterface.h"
@@ -11,6 +15,7 @@
 #if defined(WEBRTC_WIN)
 #include <windows.h>
 #endif
+class EncodedVideoEncoder;
 namespace owt {
 namespace base{
 /** @cond */
@@ -39,13 +44,283 @@ struct AudioProcessingSettings {
   bool AEC3Enabled;
 };
 /** @endcond */
+#if defined(WEBRTC_WIN)
+/// Latency/quality presets for hardware video encoders.
+enum class HardwareEncoderPreset : int {
+  /**
+   Balanced quality with a pipelined encoder. This is the default and
+   matches the previous hard-coded behavior.
+  */
+  kQualityStreaming = 0,
+  /**
+   Single-frame pipeline without frame reordering. Trades some
+   quality-per-bit for one pipeline depth less of encode latency.
+  */
+  kLowLatency,
+  /**
+   Everything in kLowLatency plus speed-optimized target usage, sliced
+   encoding and intra refresh instead of periodic IDR frames, keeping
+   per-frame size - and therefore one-way delay - flat. Intended for
+   remote-desktop style interactivity.
+  */
+  kUltraLowLatency,
+};
+/// Effort presets for the software encoders used when hardware encode is
+/// unavailable.
+enum class SoftwareEncoderPreset : int {
+  /// The engine's default software encoder settings.
+  kBalanced = 0,
+  /**
+   Cheapest settings that still produce a conformant stream: lowest
+   search complexity and no source denoising. Intended for many-core
+   nodes packing many fallback encodes, where throughput matters more
+   than quality-per-bit.
+  */
+  kSpeed,
+  /// Highest search complexity the encoder offers in real-time mode.
+  kQuality,
+};
+/// GPU surface pool usage for one resolution.
+struct GpuSurfacePoolStats {
+  /// Surface width in pixels.
+  int width;
+  /// Surface height in pixels.
+  int height;
+  /// Surfaces currently allocated at this resolution.
+  int allocated_surfaces;
+  /// Highest number of surfaces ever allocated at this resolution.
+  int peak_surfaces;
+  /// Approximate bytes of GPU memory the allocated surfaces occupy.
+  uint64_t allocated_bytes;
+};
+#endif
 /**
  @brief configuration of global using.
  GlobalConfiguration class of setting for encoded frame and hardware accecleartion configuration.
 */
 class GlobalConfiguration {
   friend class PeerConnectionDependencyFactory;
+  friend class PeerConnectionChannel;
+  friend class CustomizedFramesCapturer;
+  friend class CustomizedAudioCapturer;
+  friend class CustomizedVideoEncoderProxy;
+  friend class MSDKVideoEncoder;
+  friend class MSDKVideoDecoder;
+  friend class MSDKFactory;
+  friend class MSDKMemoryBudget;
+  friend class WebrtcVideoRendererImpl;
+  friend class ::EncodedVideoEncoder;
  public:
+  /**
+   @brief This function warms up WebRTC internals in the background.
+   @details The first stream or connection created in a process pays for
+   lazy construction of the peer connection factory - SSL initialization,
+   audio device setup and codec factory probing - which can take several
+   hundred milliseconds. Calling this once at application startup performs
+   that construction on a background thread, and warms the capture device
+   enumeration cache, so the first call that needs either finds it ready.
+   Hardware codec probing is deferred separately until the first video
+   session; this call warms it too, so clients that know they will publish
+   or subscribe video should call it, while receive-only audio clients can
+   skip it and never touch the driver. Calling it more than once, or not at
+   all, is harmless.
+   */
+  static void Prewarm();
+  /**
+   @brief Apply a configuration snapshot file written by deployment
+   tooling.
+   @details The snapshot is a flat binary table of key/value records
+   (see sdk/base/configurationsnapshot.h for the layout and key ids)
+   covering the SDK's performance knobs, so an experiment can be rolled
+   out to a fraction of a fleet by shipping a file instead of a binary.
+   The file is read once in a single bulk read and the values land in
+   the same static fields every steady-state lookup already reads, so a
+   deployed snapshot adds no per-lookup cost. Call before creating any
+   client or stream - like the individual setters, values applied after
+   PeerConnectionDependencyFactory initialization only affect later
+   sessions. Unknown keys are skipped, so newer tooling can ship keys an
+   older SDK ignores.
+   @param path Path of the snapshot file.
+   @return true when the file parsed and its known keys were applied.
+   */
+  static bool LoadConfigurationSnapshot(const std::string& path);
+  /**
+   @brief Enable or disable hot-path trace event collection.
+   @details Only effective when the SDK is built with owt_enable_trace=true;
+   in default builds the instrumentation is compiled out and this is a
+   no-op. Events are recorded into per-thread ring buffers, so enabling
+   collection in an instrumented build adds only the cost of timestamping
+   the instrumented paths.
+   @param enabled Trace collection is enabled or not.
+   */
+  static void SetTraceLogEnabled(bool enabled);
+  /**
+   @brief Write collected trace events to a file in chrome://tracing JSON
+   format. Open the file with chrome://tracing or Perfetto.
+   @param path Path of the file to write.
+   @return true when the file was written successfully.
+   */
+  static bool ExportTraceLog(const std::string& path);
+  /**
+   @brief Register a callback fired when a pipeline queue gauge reaches
+   |depth| items.
+   @details Gauges cover the queues between pipeline stages: the hardware
+   codec surface pools, the renderer mailbox and the capturer's frame
+   pool. The callback fires once per upward crossing and re-arms when the
+   gauge drains below |depth| again; it runs on the reporting media
+   thread and must return quickly. Current depths and high watermarks are
+   pulled through GetQueueDepthStats on the clients.
+   @param depth Queue depth that triggers the callback; 0 disables.
+   @param callback Invoked with the gauge name and its depth; pass nullptr
+   to disable.
+   */
+  static void SetQueueDepthThresholdCallback(
+      int depth,
+      std::function<void(const std::string& gauge, int depth)> callback);
+  /**
+   @brief Set the inter-frame gap length that counts as a video freeze.
+   @details The SDK measures the gap between consecutive frames at the
+   decoder output and at the renderer sink; gaps at or above the
+   threshold are counted as freeze events in the per-subscription
+   ConnectionStats. The default is 500 ms.
+   @param threshold_ms Freeze threshold with unit of millisecond; zero or
+   a negative value restores the default.
+   */
+  static void SetVideoFreezeThreshold(int threshold_ms);
+  /**
+   @brief Open a memory-mapped event journal for post-mortem analysis.
+   @details Key subsystems append fixed-size records of state transitions
+   (session state, ICE connection state, hardware decoder resets) into a
+   ring mapped over |path|. Records survive a process crash, so the file
+   can be read by offline tooling afterwards. Appends are wait-free and
+   cost one atomic increment plus a 64-byte write, so the journal can
+   stay on in production. The file is overwritten on open and the mapping
+   lives until process exit.
+   @param path Path of the journal file to create.
+   @param record_capacity Number of records the ring holds before the
+   newest overwrite the oldest; zero or a negative value selects the
+   default of 4096.
+   @return true when the journal was mapped successfully.
+   */
+  static bool OpenEventJournal(const std::string& path, int record_capacity);
+  /**
+   @brief Start the thread watchdog for the codec and signaling threads.
+   @details The hardware encode and decode paths and the signaling
+   receive path check in with a wait-free sequence counter on every unit
+   of work; a monitor thread detects a thread stuck inside one unit with
+   constant work per thread per tick. A detected stall is logged,
+   recorded in the event journal, and reported through |callback| with
+   the thread name, the last checkpoint the thread passed, and the stall
+   duration in milliseconds. Check-ins are cheap enough to always run;
+   only the monitor thread is added by this call. The callback runs on
+   the monitor thread and must not block.
+   @param stall_threshold_ms A thread making no progress for this long
+   is reported; rounded up to the monitor tick. Values below one tick
+   report after one tick.
+   @param callback Invoked once per detected stall. May be null to only
+   log and journal stalls.
+   */
+  static void StartThreadWatchdog(
+      int stall_threshold_ms,
+      std::function<void(const std::string& thread_name,
+                         const std::string& last_checkpoint,
+                         int stalled_ms)> callback);
+  /**
+   @brief Stop the thread watchdog monitor. Check-in counters keep
+   running at negligible cost.
+   */
+  static void StopThreadWatchdog();
+  /**
+   @brief Start the overload governor that sheds encode load near
+   saturation.
+   @details The governor polls the SDK's own instrumentation - pipeline
+   latency percentiles and engine thread load - and walks a ladder of
+   shedding levels with hysteresis instead of letting encode latency
+   collapse: level 1 drops the hardware encoder preset to the fastest
+   one, level 2 halves injected capture framerate, level 3 quarters it
+   and asks the application through |on_level_changed| to suspend
+   publications it can live without, such as thumbnails. Levels are
+   stepped one at a time, escalation after a few consecutive overloaded
+   polls and recovery deliberately slower, so the governor does not
+   oscillate around a threshold. Only the monitor thread is added by
+   this call.
+   @param encode_p99_overload_ms Escalate while 99th percentile
+   capture-to-encode latency exceeds this value; zero or negative
+   selects the default of 80.
+   @param on_level_changed Invoked on the monitor thread with the new
+   level, 0 meaning normal, after every level change. May be null.
+   */
+  static void StartOverloadGovernor(
+      int encode_p99_overload_ms,
+      std::function<void(int level)> on_level_changed);
+  /**
+   @brief Stop the overload governor, restoring the encoder preset and
+   normal capture pacing.
+   */
+  static void StopOverloadGovernor();
+  /**
+   @brief Start recording the encoded output of published streams.
+   @details Every encoded frame leaving a video encoder is appended, as
+   produced and without re-encoding, to rolling segment files in
+   |directory| by a dedicated writer thread. The encode path pays one
+   buffer copy and one queue push per frame; when the writer cannot keep
+   up, frames are dropped rather than queued without bound. The tap is
+   process wide and covers every active publication. Recording runs
+   until StopEncodedFrameRecording is called.
+   @param directory Existing directory the segment files are created in.
+   @return true when the first segment file was created successfully.
+   */
+  static bool StartEncodedFrameRecording(const std::string& directory);
+  /**
+   @brief Stop encoded frame recording and flush the current segment.
+   */
+  static void StopEncodedFrameRecording();
+  /**
+   @brief This function sets whether customized frame capturers share one
+   capture thread.
+   @details By default every capturer drives its own pacing thread. When many
+   injected streams run in one process, enabling this multiplexes all frame
+   generators onto a single shared thread with per-stream deadlines, cutting
+   the per-stream thread and context-switch cost. Must be set before streams
+   are created.
+   @param enabled Shared capture thread is enabled or not.
+   */
+  static void SetSharedCaptureThreadEnabled(bool enabled) {
+    shared_capture_thread_ = enabled;
+  }
+  /**
+   @brief This function sets how many peer connection factory instances
+   share the load.
+   @details By default one factory, and thus one set of WebRTC signaling,
+   worker and network threads, carries every channel. On many-core
+   machines the single worker thread becomes the bottleneck once tens of
+   channels run concurrently; with a count above one, channels are spread
+   round-robin over that many factories, each owning its own thread set.
+   Media tracks stay bound to the factory that created them, so the pool
+   is intended for receive-dominated workloads. Must be set before the
+   first connection is created.
+   @param count Number of factory instances. Values below one are ignored.
+   */
+  static void SetPeerConnectionFactoryCount(int count) {
+    if (count > 0) {
+      pc_factory_count_ = count;
+    }
+  }
+  /**
+   @brief This function enables latest-frame-wins delivery to attached
+   renderers.
+   @details By default frames are handed to VideoRendererInterface::
+   RenderFrame synchronously on the delivery thread, so a slow renderer
+   makes frames queue upstream and latency grow with the stall. When
+   enabled, each renderer gets a dedicated delivery thread fed from a
+   single-slot mailbox: a new frame replaces an undelivered one instead of
+   queueing behind it, so a momentarily stalled UI costs freshness rather
+   than accumulated delay. Must be set before renderers are attached.
+   @param enabled Latest-frame-wins delivery is enabled or not.
+   */
+  static void SetLatestFrameRenderingEnabled(bool enabled) {
+    latest_frame_rendering_enabled_ = enabled;
+  }
 #if defined(WEBRTC_WIN)
   /**
   @brief This function sets hardware acceleration is enabled for video decoding.
@@ -54,6 +329,149 @@ class GlobalConfiguration {
   static void SetVideoHardwareAccelerationEnabled(bool enabled) {
     hardware_acceleration_enabled_ = enabled;
   }
+  /**
+  @brief This function sets the latency/quality preset used by hardware
+  video encoders.
+  @details Presets map to complete encoder parameter sets instead of single
+  knobs, so pipeline depth, GOP structure and the loss-recovery mechanism
+  stay consistent with each other. Must be set before streams are
+  published; encoders that are already running are not reconfigured.
+  @param preset The preset to apply.
+  */
+  static void SetHardwareEncoderPreset(HardwareEncoderPreset preset) {
+    hardware_encoder_preset_ = preset;
+  }
+  /**
+  @brief This function caps the GPU memory hardware codecs may hold in
+  surface pools.
+  @details When a decoder or encoder would allocate a surface pool that
+  pushes total usage past the budget, the allocation is refused and the
+  codec fails over cleanly instead of exhausting GPU memory with an
+  opaque driver error. The default of 0 disables the cap.
+  @param budget_mb Budget in megabytes; 0 means unlimited.
+  */
+  static void SetGpuSurfaceBudgetMB(int budget_mb) {
+    gpu_surface_budget_mb_ = budget_mb;
+  }
+  /**
+  @brief This function returns GPU surface pool usage per resolution.
+  @details Intended for load-packing decisions: a client running many
+  decodes on one GPU can compare current and peak usage against the
+  configured budget before subscribing to more streams.
+  @return One entry per resolution that has ever had a pool, largest
+  resolution first.
+  */
+  static std::vector<GpuSurfacePoolStats> GetGpuSurfacePoolStats();
+  /**
+  @brief This function sets the resolution decoded frames are scaled to
+  on the GPU before they leave the hardware decoder.
+  @details Applications rendering most remote streams as thumbnails pay
+  full-resolution color conversion and CPU scaling in the render path.
+  With a target set, hardware decoders run an MSDK VPP scaling stage and
+  deliver frames at the target size instead. Streams whose decoded size
+  is already at or below the target are delivered unscaled, and decoding
+  falls back to unscaled delivery if the VPP stage cannot be created.
+  Applies to decoders (re)initialized after the call.
+  @param width Target width in pixels; 0 disables scaling.
+  @param height Target height in pixels; 0 disables scaling.
+  */
+  static void SetDecodedFrameScalingResolution(int width, int height) {
+    decoded_frame_scaling_width_ = width;
+    decoded_frame_scaling_height_ = height;
+  }
+  /**
+  @brief This function pins the threads hardware codecs run on to a set
+  of logical processors.
+  @details On multi-socket machines codec throughput depends on the
+  threads landing on the NUMA node closest to the GPU; left to the
+  scheduler they migrate across sockets and pay remote-memory latency on
+  every surface access. The mask is applied to the dedicated encoder and
+  decoder threads and to the media worker thread when they are created.
+  Must be set before the first ConferenceClient or P2PClient is
+  constructed; already-running threads are not moved.
+  @param mask Bit i selects logical processor i; 0 disables pinning.
+  */
+  static void SetCodecThreadAffinityMask(uint64_t mask) {
+    codec_thread_affinity_mask_ = mask;
+  }
+  /**
+  @brief This function pins capture threads to a set of logical
+  processors.
+  @details Companion to SetCodecThreadAffinityMask for the threads that
+  pace frame generators, which are best placed near the device or memory
+  producing the frames. Applied when a capture thread is created.
+  @param mask Bit i selects logical processor i; 0 disables pinning.
+  */
+  static void SetCaptureThreadAffinityMask(uint64_t mask) {
+    capture_thread_affinity_mask_ = mask;
+  }
+  /**
+  @brief This function pins hardware codec sessions to one GPU adapter.
+  @details By default sessions are spread across the hardware adapters
+  the Media SDK dispatcher reports, placing each new codec on the
+  adapter with the fewest live sessions. Setting an index pins every
+  session to that adapter instead; an index no adapter answers to falls
+  back to balanced placement. Applies to sessions created after the
+  call.
+  @param index Zero-based adapter index; -1 restores balanced placement.
+  */
+  static void SetCodecAdapterIndex(int index) {
+    codec_adapter_index_ = index;
+  }
+  /**
+  @brief This function enables D3D11 camera capture through Media
+  Foundation.
+  @details By default camera frames are captured into system memory. When
+  enabled, cameras are opened through the Media Foundation source reader
+  with a DXGI device manager attached, so frames arrive as D3D11 NV12
+  textures and reach the hardware encoder on the same GPU without ever
+  touching system memory. Capture falls back to the system memory path
+  per device when the GPU capture pipeline cannot be built. Must be set
+  before local camera streams are created.
+  @param enabled D3D11 camera capture is enabled or not.
+  */
+  static void SetD3D11CameraCaptureEnabled(bool enabled) {
+    d3d11_camera_capture_enabled_ = enabled;
+  }
+  /**
+  @brief This function sets the number of shared decoder lanes.
+  @details Each hardware decoder instance used to start a dedicated
+  codec thread, so a client with many subscriptions paid one mostly idle
+  thread per stream. Decoders share a fixed pool of lanes instead,
+  assigned by measured decode cost: streams whose frames are expensive
+  are steered toward lanes of their own while cheap thumbnail streams
+  pack together. Must be set before the first decoder is created; the
+  pool size is fixed once the pool is built.
+  @param size Number of decoder lanes; values below one keep the default.
+  */
+  static void SetDecodeThreadPoolSize(int size) {
+    decode_thread_pool_size_ = size;
+  }
+  /**
+  @brief This function sets the number of threads software fallback
+  encoders may use.
+  @details When hardware encode is unavailable and a publication falls
+  back to a software codec, the encoder sizes its thread pool - and with
+  it the slice or tile split of each frame - from the core count it is
+  handed. The default hands over the machine's core count; a smaller
+  value confines each fallback encode so many publications can share a
+  many-core node predictably. Applies to encoders created after the
+  call.
+  @param count Number of threads; 0 keeps the engine default.
+  */
+  static void SetSoftwareFallbackThreadCount(int count) {
+    software_fallback_thread_count_ = count;
+  }
+  /**
+  @brief This function selects the effort preset for software fallback
+  encoders.
+  @details Must be set before the fallback encoder is created; running
+  encoders are not reconfigured.
+  @param preset The preset to apply.
+  */
+  static void SetSoftwareFallbackPreset(SoftwareEncoderPreset preset) {
+    software_fallback_preset_ = preset;
+  }
 #endif
   /** @cond */
   /**
@@ -127,6 +545,73 @@ class GlobalConfiguration {
   static void SetNSEnabled(bool enabled) {
     audio_processing_settings_.NSEnabled = enabled;
   }
+  /**
+  @breif This function disables/enables audio processing for customized audio
+  input.
+  @details Machine-generated PCM injected through an AudioFrameGenerator is
+  already clean, so AEC, AGC and NS only burn CPU on it. When bypass is
+  enabled, audio tracks created from customized audio input skip audio
+  processing entirely. It has no effect when audio is captured from mic.
+  @param bypassed Audio processing is bypassed or not.
+  */
+  static void SetAudioProcessingBypassedForCustomizedInput(bool bypassed) {
+    customized_audio_processing_bypassed_ = bypassed;
+  }
+  /**
+  @brief This function disables/enables silence suppression for customized
+  audio input.
+  @details With many injected streams most are silent at any moment, yet
+  each one still pushes full 10ms buffers through audio processing and
+  encode. When enabled, the capturer runs a cheap energy check on every
+  generated frame: after a short run of silent frames it stops delivering
+  them into the send pipeline, and Opus DTX is negotiated so the far end
+  expects the gap. The first non-silent frame is delivered immediately.
+  It has no effect when audio is captured from mic.
+  @param enabled Silence suppression is enabled or not.
+  */
+  static void SetInjectedAudioSilenceSuppressionEnabled(bool enabled) {
+    injected_audio_silence_suppression_enabled_ = enabled;
+  }
+  /**
+  @brief This function sets the keyframe request coalescing window.
+  @details During packet loss spikes several keyframe requests can reach an
+  encoder back to back, producing bursts of IDR frames that blow the bitrate
+  budget. Requests arriving within |window_ms| of the last forwarded one are
+  collapsed into it. Set to 0 to forward every request unchanged, which is
+  the default.
+  @param window_ms Coalescing window in milliseconds.
+  */
+  static void SetKeyFrameRequestCoalescingWindowMs(int window_ms) {
+    key_frame_request_coalescing_window_ms_ = window_ms;
+  }
+  /**
+  @brief This function sets the number of temporal layers announced for
+  encoded video frame input.
+  @details Applies to VP8 streams injected as pre-encoded frames. The SDK
+  does not re-encode them, so it only annotates RTP metadata with the
+  temporal cadence the frames were actually produced with: {0,1} for two
+  layers, {0,2,1,2} for three. This lets an SFU drop upper layers for slow
+  receivers. With the default of 1 no temporal structure is signaled.
+  @param layers Number of temporal layers. Valid range is 1 to 3.
+  */
+  static void SetEncodedVideoTemporalLayers(int layers) {
+    encoded_video_temporal_layers_ = layers;
+  }
+  /**
+  @brief This function enables validation of injected encoded bitstreams.
+  @details Applies to H.264/H.265 streams published through
+  VideoEncoderInterface. Each frame is copied to a background thread
+  that checks Annex-B well-formedness and that parameter sets precede
+  the first IDR; defects are reported to the producing encoder through
+  VideoEncoderInterface::OnBitstreamValidationError on the frame that
+  carried them, instead of surfacing as a decode failure on the far
+  side. Costs one frame copy per encode while enabled. Disabled by
+  default.
+  @param enabled Bitstream validation is enabled or not.
+  */
+  static void SetEncodedBitstreamValidationEnabled(bool enabled) {
+    encoded_bitstream_validation_enabled_ = enabled;
+  }
  private:
   GlobalConfiguration() {}
   virtual ~GlobalConfiguration() {}
@@ -139,6 +624,57 @@ class GlobalConfiguration {
     return hardware_acceleration_enabled_;
   }
   static bool hardware_acceleration_enabled_;
+  /**
+   @brief This function gets whether D3D11 camera capture is enabled.
+   @return true or false.
+   */
+  static bool GetD3D11CameraCaptureEnabled() {
+    return d3d11_camera_capture_enabled_;
+  }
+  static bool d3d11_camera_capture_enabled_;
+  /**
+   @brief This function gets the latency/quality preset for hardware
+   video encoders.
+   @return The configured preset.
+   */
+  static HardwareEncoderPreset GetHardwareEncoderPreset() {
+    return hardware_encoder_preset_;
+  }
+  static HardwareEncoderPreset hardware_encoder_preset_;
+  /**
+   @brief This function gets the GPU surface pool budget.
+   @return Budget in megabytes; 0 when unlimited.
+   */
+  static int GetGpuSurfaceBudgetMB() { return gpu_surface_budget_mb_; }
+  static int gpu_surface_budget_mb_;
+  static int GetDecodedFrameScalingWidth() {
+    return decoded_frame_scaling_width_;
+  }
+  static int GetDecodedFrameScalingHeight() {
+    return decoded_frame_scaling_height_;
+  }
+  static int decoded_frame_scaling_width_;
+  static int decoded_frame_scaling_height_;
+  static uint64_t GetCodecThreadAffinityMask() {
+    return codec_thread_affinity_mask_;
+  }
+  static uint64_t GetCaptureThreadAffinityMask() {
+    return capture_thread_affinity_mask_;
+  }
+  static uint64_t codec_thread_affinity_mask_;
+  static uint64_t capture_thread_affinity_mask_;
+  static int GetCodecAdapterIndex() { return codec_adapter_index_; }
+  static int codec_adapter_index_;
+  static int GetDecodeThreadPoolSize() { return decode_thread_pool_size_; }
+  static int decode_thread_pool_size_;
+  static int GetSoftwareFallbackThreadCount() {
+    return software_fallback_thread_count_;
+  }
+  static int software_fallback_thread_count_;
+  static SoftwareEncoderPreset GetSoftwareFallbackPreset() {
+    return software_fallback_preset_;
+  }
+  static SoftwareEncoderPreset software_fallback_preset_;
 #endif
   /**
    @brief This function gets whether encoded video frame input is enabled or not.
@@ -182,12 +718,79 @@ class GlobalConfiguration {
   static bool GetNSEnabled() {
     return audio_processing_settings_.NSEnabled ? true : false;
   }
+  /**
+  @brief This function gets whether audio processing is bypassed for
+  customized audio input.
+  @return true or false.
+  */
+  static bool GetAudioProcessingBypassedForCustomizedInput() {
+    return customized_audio_processing_bypassed_;
+  }
+  static bool customized_audio_processing_bypassed_;
+  /**
+  @brief This function gets whether silence suppression is enabled for
+  customized audio input.
+  @return true or false.
+  */
+  static bool GetInjectedAudioSilenceSuppressionEnabled() {
+    return injected_audio_silence_suppression_enabled_;
+  }
+  static bool injected_audio_silence_suppression_enabled_;
+  /**
+  @brief This function gets the keyframe request coalescing window.
+  @return Coalescing window in milliseconds; 0 when disabled.
+  */
+  static int GetKeyFrameRequestCoalescingWindowMs() {
+    return key_frame_request_coalescing_window_ms_;
+  }
+  static int key_frame_request_coalescing_window_ms_;
+  /**
+  @brief This function gets the number of temporal layers announced for
+  encoded video frame input.
+  @return Number of temporal layers.
+  */
+  static int GetEncodedVideoTemporalLayers() {
+    return encoded_video_temporal_layers_;
+  }
+  static int encoded_video_temporal_layers_;
+  /**
+  @brief This function gets whether injected bitstream validation is
+  enabled.
+  @return true or false.
+  */
+  static bool GetEncodedBitstreamValidationEnabled() {
+    return encoded_bitstream_validation_enabled_;
+  }
+  static bool encoded_bitstream_validation_enabled_;
   /**
    @brief This function returns audio frame generator.
    */
   static std::unique_ptr<AudioFrameGeneratorInterface> GetAudioFrameGenerator(){
     return std::move(audio_frame_generator_);
   }
+  /**
+   @brief This function gets whether capturers share one capture thread.
+   @return true or false.
+   */
+  static bool GetSharedCaptureThreadEnabled() {
+    return shared_capture_thread_;
+  }
+  static bool shared_capture_thread_;
+  /**
+   @brief This function gets how many peer connection factories share the
+   load.
+   @return Number of factory instances.
+   */
+  static int GetPeerConnectionFactoryCount() { return pc_factory_count_; }
+  static int pc_factory_count_;
+  /**
+   @brief This function gets whether latest-frame-wins delivery is enabled.
+   @return true or false.
+   */
+  static bool GetLatestFrameRenderingEnabled() {
+    return latest_frame_rendering_enabled_;
+  }
+  static bool latest_frame_rendering_enabled_;
   // Encoded video frame flag.
    /**
    * Default is false. If it is set to true, only streams with encoded frame can
@@ -0,0 +1,50 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_INTERNEDSTRING_H_
+#define OWT_BASE_INTERNEDSTRING_H_
+#include <memory>
+#include <string>
+namespace owt {
+namespace base {
+/**
+  @brief Immutable shared string for identifier values.
+  @details Stream, session and participant IDs are 36-character UUIDs
+  that the SDK stores in several maps and captures into callbacks at
+  once. Interning keeps a single shared copy of each distinct value:
+  every InternedString for the same text points at the same allocation,
+  so holding one in a map key or a lambda costs one pointer and equality
+  between interned values is a pointer comparison.
+*/
+class InternedString {
+ public:
+  /// Creates an empty value. Equal to Intern("") after comparison by
+  /// content, but not by pointer; prefer Intern for values used as keys.
+  InternedString() = default;
+  /// Returns the shared instance for |value|, creating it if needed.
+  static InternedString Intern(const std::string& value);
+  /// The interned text. Returns an empty string for a default-constructed
+  /// value.
+  const std::string& str() const;
+  bool operator==(const InternedString& other) const {
+    return value_ == other.value_;
+  }
+  bool operator!=(const InternedString& other) const {
+    return value_ != other.value_;
+  }
+  /// Hashes the identity of the shared instance, not its characters.
+  /// Lookups must intern the probe value first.
+  struct Hash {
+    size_t operator()(const InternedString& value) const {
+      return std::hash<const std::string*>()(value.value_.get());
+    }
+  };
+
+ private:
+  explicit InternedString(std::shared_ptr<const std::string> value)
+      : value_(std::move(value)) {}
+  std::shared_ptr<const std::string> value_;
+};
+}
+}
+#endif  // OWT_BASE_INTERNEDSTRING_H_
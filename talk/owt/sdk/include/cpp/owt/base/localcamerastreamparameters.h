@@ -88,6 +88,7 @@ class LocalCustomizedStreamParameters final {
      fps_ = 0;
      bitrate_kbps_ = 0;
      resolution_width_ = resolution_height_ = 0;
+     content_hint_ = VideoContentHint::kNone;
   }
   ~LocalCustomizedStreamParameters() {}
   /**
@@ -117,7 +118,17 @@ class LocalCustomizedStreamParameters final {
   void Bitrate(int bitrate_kbps) {
     bitrate_kbps_ = bitrate_kbps;
   }
+  /**
+    @brief Set the content hint of the video.
+    @details The hint is applied to the created video track and steers
+    what the engine preserves under bandwidth or CPU pressure.
+    @param content_hint The content hint of the video.
+  */
+  void ContentHint(VideoContentHint content_hint) {
+    content_hint_ = content_hint;
+  }
   /** @cond */
+  VideoContentHint ContentHint() const { return content_hint_; }
   int ResolutionWidth() const { return resolution_width_; }
   int ResolutionHeight() const { return resolution_height_; }
   int Fps() const { return fps_; }
@@ -140,6 +151,7 @@ class LocalCustomizedStreamParameters final {
   int resolution_height_;
   uint32_t fps_;
   uint32_t bitrate_kbps_;
+  VideoContentHint content_hint_;
 };
 /**
 @brief This class contains parameters and methods that's needed for creating a
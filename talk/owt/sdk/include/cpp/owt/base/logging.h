@@ -19,6 +19,16 @@ enum class LoggingSeverity : int {
   /// Don't log.
   kNone
 };
+/// SDK modules whose logging can be tuned independently.
+enum class LoggingModule : int {
+  kBase = 0,
+  kConference,
+  kP2P,
+  kVideoCodec,
+};
+/** @cond */
+const int kLoggingModuleCount = 4;
+/** @endcond */
 /// Logger configuration class. Choose either LogToConsole or LogToFileRotate in
 /// your application for logging to console or file.
 class Logging final {
@@ -32,8 +42,19 @@ class Logging final {
   static void LogToConsole(LoggingSeverity severity);
   /// Set logging to files under provided dir rotately.
   static void LogToFileRotate(LoggingSeverity severity, std::string& dir, size_t max_log_size);
+  /// Set logging severity for one SDK module. Messages from that module
+  /// with lower severity are suppressed even when the global severity
+  /// would log them; other modules are unaffected.
+  static void ModuleSeverity(LoggingModule module, LoggingSeverity severity);
+  /// Get current logging severity of one SDK module.
+  static LoggingSeverity ModuleSeverity(LoggingModule module);
+  /** @cond */
+  /// Used by the module logging macros.
+  static bool ModuleEnabled(LoggingModule module, LoggingSeverity severity);
+  /** @endcond */
  private:
   static LoggingSeverity min_severity_;
+  static LoggingSeverity module_severity_[kLoggingModuleCount];
 };
 }
 }
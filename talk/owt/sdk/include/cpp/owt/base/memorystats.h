@@ -0,0 +1,22 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_MEMORYSTATS_H_
+#define OWT_BASE_MEMORYSTATS_H_
+#include <cstdint>
+#include <string>
+namespace owt {
+namespace base {
+/// Memory currently held by one SDK subsystem.
+struct MemoryStatsEntry {
+  /// Subsystem owning the memory, e.g. "capturer.frame_buffers",
+  /// "msdk.sysmem_buffers" or "signaling.outgoing_queue".
+  std::string category;
+  /// Bytes currently allocated.
+  uint64_t bytes;
+  /// Number of live allocations the bytes are spread over.
+  uint64_t allocations;
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_MEMORYSTATS_H_
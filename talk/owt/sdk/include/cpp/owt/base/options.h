@@ -3,11 +3,42 @@
 // SPDX-License-Identifier: Apache-2.0
 #ifndef OWT_BASE_OPTIONS_H_
 #define OWT_BASE_OPTIONS_H_
+#include <atomic>
+#include <cstdint>
 #include <vector>
 #include "owt/base/commontypes.h"
 #include "owt/base/mediaconstraints.h"
 namespace owt {
 namespace base {
+/**
+ @brief Debug tally of option-struct copies.
+ @details PublishOptions and SubscribeOptions carry codec parameter
+ vectors, so every copy allocates. Their copy operations bump this
+ counter in debug builds; release builds count nothing and Count()
+ returns zero. Bracket a call path with Reset()/Count() in a test to
+ assert the path moves instead of copying.
+*/
+class OptionsCopyAudit {
+ public:
+  /// Number of option-struct copies since process start or last Reset().
+  static uint64_t Count() {
+    return Counter().load(std::memory_order_relaxed);
+  }
+  /// Reset the counter so a test can meter one call path.
+  static void Reset() { Counter().store(0, std::memory_order_relaxed); }
+  /// Called by option-struct copy operations. Not for application use.
+  static void RecordCopy() {
+#if !defined(NDEBUG)
+    Counter().fetch_add(1, std::memory_order_relaxed);
+#endif
+  }
+
+ private:
+  static std::atomic<uint64_t>& Counter() {
+    static std::atomic<uint64_t> counter(0);
+    return counter;
+  }
+};
 /// Audio subscription capabilities. Empty means not setting corresponding capability.
 struct AudioSubscriptionCapabilities {
   std::vector<AudioCodecParameters>    codecs;
@@ -44,8 +75,62 @@ struct PublicationSettings {
  @details Set encoding constraint on video or video using this option.
 */
 struct PublishOptions {
+  PublishOptions() = default;
+  /// Copies are tallied by OptionsCopyAudit in debug builds. Hand the
+  /// options to Publish with std::move to transfer the codec vectors
+  /// instead of copying them.
+  PublishOptions(const PublishOptions& other)
+      : audio(other.audio),
+        video(other.video),
+        simulcast_layer_count(other.simulcast_layer_count),
+        intra_refresh(other.intra_refresh),
+        max_pacing_bitrate_bps(other.max_pacing_bitrate_bps),
+        bandwidth_priority(other.bandwidth_priority) {
+    OptionsCopyAudit::RecordCopy();
+  }
+  PublishOptions& operator=(const PublishOptions& other) {
+    audio = other.audio;
+    video = other.video;
+    simulcast_layer_count = other.simulcast_layer_count;
+    intra_refresh = other.intra_refresh;
+    max_pacing_bitrate_bps = other.max_pacing_bitrate_bps;
+    bandwidth_priority = other.bandwidth_priority;
+    OptionsCopyAudit::RecordCopy();
+    return *this;
+  }
+  PublishOptions(PublishOptions&&) = default;
+  PublishOptions& operator=(PublishOptions&&) = default;
   std::vector<AudioEncodingParameters>  audio;
   std::vector<VideoEncodingParameters>  video;
+  /// Number of simulcast layers to send for video. When above one, the
+  /// publication offers that many send SSRCs grouped for simulcast so
+  /// layer selection happens at the SFU without transcoding. The value
+  /// is capped by what the encoder supports for the negotiated codec.
+  int simulcast_layer_count = 1;
+  /// Replace periodic IDR frames with gradual decoder refresh. An
+  /// intra-refresh column sweep spreads a keyframe's worth of intra
+  /// bits across the refresh cycle, flattening the bitrate profile of
+  /// large screen-content frames whose IDR bursts overflow constrained
+  /// uplinks; keyframe requests still force an IDR. Applies to hardware
+  /// encoders, which are shared process resources, so the refresh
+  /// setting affects all publications while any publication with this
+  /// option is active.
+  bool intra_refresh = false;
+  /// Upper bound on this publication's total send rate, in bits per
+  /// second, including retransmissions and padding. The value caps the
+  /// send-side bandwidth allocator, which sets the pacer's budget, so it
+  /// is the per-connection control over how fast bursts - screen-content
+  /// keyframes in particular - are allowed to drain onto the wire. Zero
+  /// or a negative value keeps the engine default. Observe the effect
+  /// through VideoBandwidthStats::pacer_queue_delay_ms.
+  int max_pacing_bitrate_bps = 0;
+  /// Relative weight of this publication when the cross-publication
+  /// bandwidth orchestrator splits the uplink estimate between several
+  /// concurrent publications (ConferenceClient::StartBandwidthOrchestration).
+  /// A publication with weight 2 is offered twice the share of one with
+  /// weight 1. Values below one are treated as one. Has no effect while
+  /// orchestration is not running.
+  int bandwidth_priority = 1;
 };
 
 } // namespace base
@@ -0,0 +1,21 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_QUEUESTATS_H_
+#define OWT_BASE_QUEUESTATS_H_
+#include <string>
+namespace owt {
+namespace base {
+/// Depth of one pipeline queue.
+struct QueueDepthEntry {
+  /// Queue identity, e.g. "msdk.encoder.locked_surfaces" or
+  /// "renderer.<stream id>.mailbox_depth".
+  std::string gauge;
+  /// Current depth in queued items.
+  int depth;
+  /// Highest depth observed since the gauge first reported.
+  int high_watermark;
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_QUEUESTATS_H_
@@ -3,6 +3,8 @@
 // SPDX-License-Identifier: Apache-2.0
 #ifndef OWT_BASE_STREAM_H_
 #define OWT_BASE_STREAM_H_
+#include <functional>
+#include <memory>
 #include <mutex>
 #include <unordered_map>
 #include <vector>
@@ -51,6 +53,8 @@ class StreamObserver {
 class WebrtcVideoRendererImpl;
 #if defined(WEBRTC_WIN)
 class WebrtcVideoRendererD3D9Impl;
+class WebrtcVideoRendererD3D11Impl;
+class CompositedStreamSink;
 #endif
 /// Base class of all streams with media stream
 class Stream {
@@ -83,8 +87,21 @@ class Stream {
   */
   virtual const std::unordered_map<std::string, std::string> Attributes()
       const {
-    return attributes_;
+    std::shared_ptr<const std::unordered_map<std::string, std::string>>
+        attributes = std::atomic_load(&attributes_);
+    if (!attributes)
+      return std::unordered_map<std::string, std::string>();
+    return *attributes;
   }
+  /** @cond */
+  /// Returns the attribute map without copying it. The returned map is
+  /// immutable; attribute updates swap in a whole new map, so holders of
+  /// an old snapshot keep reading consistent data.
+  std::shared_ptr<const std::unordered_map<std::string, std::string>>
+  SharedAttributes() const {
+    return std::atomic_load(&attributes_);
+  }
+  /** @endcond */
   /**
     @brief Returns the audio/video source info of the stream
     @details The source info of video/audio indicates the device source type of
@@ -114,10 +131,15 @@ class Stream {
   void TriggerOnStreamMute(owt::base::TrackKind track_kind);
   void TriggerOnStreamUnmute(owt::base::TrackKind track_kind);
   MediaStreamInterface* media_stream_;
-  std::unordered_map<std::string, std::string> attributes_;
+  // Immutable attribute map shared between streams, ConferenceInfo and
+  // update events; replaced as a whole on update via std::atomic_store.
+  std::shared_ptr<const std::unordered_map<std::string, std::string>>
+      attributes_;
   WebrtcVideoRendererImpl* renderer_impl_;
 #if defined(WEBRTC_WIN)
   WebrtcVideoRendererD3D9Impl* d3d9_renderer_impl_;
+  WebrtcVideoRendererD3D11Impl* d3d11_renderer_impl_;
+  CompositedStreamSink* composited_sink_;
 #endif
   StreamSourceInfo source_;
  private:
@@ -159,7 +181,10 @@ class LocalStream : public Stream {
   */
   virtual void Attributes(
       const std::unordered_map<std::string, std::string>& attributes) {
-    attributes_ = attributes;
+    std::atomic_store(
+        &attributes_,
+        std::shared_ptr<const std::unordered_map<std::string, std::string>>(
+            new std::unordered_map<std::string, std::string>(attributes)));
   }
   /**
    @brief Close a local stream
@@ -167,6 +192,38 @@ class LocalStream : public Stream {
    sink previously attached.
   */
   void Close();
+  /**
+   @brief Set the content hint on this stream's video tracks.
+   @details The hint steers the engine's degradation behavior: motion
+   content lowers resolution under pressure, detail and text content
+   lower framerate and keep the frames legible. Screen streams default
+   to detail; streams created from other sources default to letting the
+   engine decide.
+   @param hint Content hint to apply.
+  */
+  void ContentHint(VideoContentHint hint);
+  /**
+   @brief Hint the encoder at the frame region where content changes.
+   @details Applications that know where activity happens - a whiteboard
+   knows where the presenter draws - can concentrate encoder bits there.
+   Hardware encoders apply the region with a QP offset on every frame
+   until the hint is cleared; software encoders ignore it. The encoder
+   is a shared process resource, so the hint applies to all hardware
+   encoded publications while set.
+   @param left Left edge of the region in pixels of the captured frame.
+   @param top Top edge of the region in pixels.
+   @param right Right edge of the region in pixels.
+   @param bottom Bottom edge of the region in pixels.
+   @param quality_delta QP delta inside the region; negative values
+   spend more bits there at the cost of the rest of the picture.
+  */
+  void SetRegionOfInterest(int left,
+                           int top,
+                           int right,
+                           int bottom,
+                           int quality_delta);
+  /// Remove the region-of-interest hint set by SetRegionOfInterest.
+  void ClearRegionOfInterest();
   /**
    @brief Create a local camera stream.
    @detail This creates a local camera stream with specified device
@@ -273,7 +330,16 @@ class RemoteStream : public Stream {
   explicit RemoteStream(MediaStreamInterface* media_stream,
                         const std::string& from);
   virtual void Attributes(const std::unordered_map<std::string, std::string>& attributes) {
-                          attributes_ = attributes;
+    std::atomic_store(
+        &attributes_,
+        std::shared_ptr<const std::unordered_map<std::string, std::string>>(
+            new std::unordered_map<std::string, std::string>(attributes)));
+  }
+  /// Share an already built immutable attribute map instead of copying it.
+  virtual void Attributes(
+      std::shared_ptr<const std::unordered_map<std::string, std::string>>
+          attributes) {
+    std::atomic_store(&attributes_, std::move(attributes));
   }
   /** @endcond */
   /// Return the remote user ID, indicates who published this stream.
@@ -281,31 +347,36 @@ class RemoteStream : public Stream {
   std::string Origin();
   using Stream::Attributes;
   /// Get the subscription capabilities on the stream.
-  SubscriptionCapabilities Capabilities() { return subscription_capabilities_; }
+  SubscriptionCapabilities Capabilities();
   /// Get the publication settings of the stream.
-  PublicationSettings Settings() { return publication_settings_; }
+  PublicationSettings Settings();
   /// Stop the remote stream.
   /** @cond */
   /// Setter for subscription capabilities
-  void Capabilities(
-      owt::base::SubscriptionCapabilities subscription_capabilities) {
-    subscription_capabilities_ = subscription_capabilities;
-  }
+  void Capabilities(owt::base::SubscriptionCapabilities subscription_capabilities);
   /// Setter for publication settings
-  void Settings(PublicationSettings publication_settings) {
-    publication_settings_ = publication_settings;
-  }
+  void Settings(PublicationSettings publication_settings);
   /** @endcond */
   void Stop() {};
  protected:
   MediaStreamInterface* MediaStream();
   void MediaStream(MediaStreamInterface* media_stream);
  private:
+  // Run the deferred capability parse, if any. Capability and settings
+  // info of conference streams is parsed on first access instead of at
+  // join time; see ConferenceClient::ParseStreamInfo. Callers must hold
+  // |capability_info_mutex_|.
+  void RunPendingCapabilityParse();
+  // Take over |other|'s capability info, including a still-pending parse,
+  // without forcing the parse to run.
+  void AdoptCapabilityInfo(RemoteStream& other);
   std::string origin_;
   bool has_audio_ = true;
   bool has_video_ = true;
   owt::base::SubscriptionCapabilities subscription_capabilities_;
   owt::base::PublicationSettings publication_settings_;
+  std::function<void(RemoteStream&)> pending_capability_parser_;
+  mutable std::mutex capability_info_mutex_;
 };
 } // namespace base
 } // namespace owt
@@ -0,0 +1,31 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_BASE_THREADSTATS_H_
+#define OWT_BASE_THREADSTATS_H_
+#include <cstdint>
+#include <string>
+namespace owt {
+namespace base {
+/// Load sample for one SDK thread.
+struct ThreadLoadEntry {
+  /// Thread identity, e.g. "signaling_thread" or "worker_thread#2" when
+  /// a factory pool runs several trios.
+  std::string thread_name;
+  /// Fraction of wall time the thread spent on-CPU over the last probe
+  /// interval, 0.0 to 1.0. Negative when the platform cannot report
+  /// per-thread CPU time.
+  double utilization;
+  /// Queue delay of the most recent probe: time from posting a task to
+  /// the thread until the thread ran it, in microseconds.
+  int64_t post_to_run_us;
+  /// Smoothed queue delay over recent probes, in microseconds.
+  int64_t post_to_run_avg_us;
+  /// Worst queue delay since the previous snapshot, in microseconds. A
+  /// probe still waiting in the queue is counted with its age so far,
+  /// so a saturated thread shows a growing value instead of a stale one.
+  int64_t post_to_run_max_us;
+};
+}  // namespace base
+}  // namespace owt
+#endif  // OWT_BASE_THREADSTATS_H_
@@ -8,6 +8,22 @@
 #include "owt/base/commontypes.h"
 namespace owt {
 namespace base {
+/**
+ @brief Reference to an encoder-owned buffer holding one complete encoded
+ frame.
+ @details Used by the zero-copy encode path. The encoder keeps ownership of
+ |data|; the SDK only borrows it and hands |buffer_id| back through
+ VideoEncoderInterface::RecycleEncodedFrame once the frame has been sent.
+*/
+struct EncodedFrameHandle {
+  /// Pointer to the encoded bitstream. Owned by the encoder.
+  uint8_t* data;
+  /// Size of the encoded bitstream in bytes.
+  size_t size;
+  /// Opaque tag chosen by the encoder, returned unchanged when the buffer
+  /// is recycled.
+  intptr_t buffer_id;
+};
 /**
   @brief Video encoder interface
   @details Internal webrtc encoder will request from this
@@ -46,6 +62,36 @@ class VideoEncoderInterface {
    */
   virtual bool EncodeOneFrame(std::vector<uint8_t>& buffer, bool key_frame) = 0;
 #endif
+  /**
+   @brief Whether this encoder hands its encoded buffers over without copy.
+   @details When it returns true, the SDK calls EncodeOneFrameZeroCopy
+   instead of EncodeOneFrame and sends the encoder-owned buffer on the wire
+   directly, recycling it through RecycleEncodedFrame afterwards.
+   @return Return true if zero-copy handover is supported; the default
+   implementation returns false.
+   */
+  virtual bool SupportsZeroCopyEncoding() { return false; }
+  /**
+   @brief Retrieve a handle to an encoder-owned buffer holding one complete
+   frame.
+   @details Unlike EncodeOneFrame, the buffer is not copied. It must stay
+   valid until RecycleEncodedFrame is called with its buffer_id, which
+   happens once per successful handover.
+   @param handle Output handle describing the encoded buffer.
+   @param key_frame Indicates whether we're requesting an AU representing an key frame.
+   @return Returns true if the encoder successfully returns one frame; returns false
+   if the encoder fails to encode one frame.
+   */
+  virtual bool EncodeOneFrameZeroCopy(EncodedFrameHandle& handle,
+                                      bool key_frame) {
+    return false;
+  }
+  /**
+   @brief Returns a buffer obtained from EncodeOneFrameZeroCopy to the
+   encoder for reuse.
+   @param buffer_id The tag the encoder stored in the handle.
+   */
+  virtual void RecycleEncodedFrame(intptr_t buffer_id) {}
   /**
    @brief Release the resources that current encoder holds.
    @return Return true if successfully released the encoder; return false if
@@ -57,6 +103,19 @@ class VideoEncoderInterface {
    @return The newly created VideoEncoderInterface instance.
    */
   virtual VideoEncoderInterface* Copy() = 0;
+  /**
+   @brief Notifies the encoder that a frame it delivered failed bitstream
+   validation.
+   @details Only called when bitstream validation is enabled through
+   GlobalConfiguration::SetEncodedBitstreamValidationEnabled. Malformed
+   frames are still rejected by the SDK either way; this callback makes
+   the rejection visible to the producer immediately instead of
+   surfacing as a decode failure on the far side. Called on the
+   validation thread, so the implementation must not block or call back
+   into the SDK. The default implementation ignores the report.
+   @param reason Human-readable description of the first defect found.
+   */
+  virtual void OnBitstreamValidationError(const std::string& reason) {}
 };
 }
 }
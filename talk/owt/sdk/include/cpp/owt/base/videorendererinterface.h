@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: Apache-2.0
 #ifndef OWT_BASE_VIDEORENDERERINTERFACE_H_
 #define OWT_BASE_VIDEORENDERERINTERFACE_H_
+#include <functional>
 #include <memory>
 #include "owt/base/commontypes.h"
 #if defined(WEBRTC_WIN)
@@ -11,6 +12,10 @@
 #if defined(WEBRTC_LINUX)
 #include <X11/Xlib.h>
 #endif
+#if defined(WEBRTC_WIN)
+struct IDirect3DSurface9;
+struct IDirect3DDeviceManager9;
+#endif
 namespace owt {
 namespace base {
 enum class VideoBufferType {
@@ -20,7 +25,26 @@ enum class VideoBufferType {
 enum class VideoRendererType {
   kI420,
   kARGB,
+  /// Renderer consumes hardware frames without a CPU download. Windows
+  /// only; frames are delivered through RenderNativeFrame.
+  kNative,
+};
+#if defined(WEBRTC_WIN)
+/// Hardware-decoded frame handed to a native renderer. The pixels stay in
+/// GPU memory; the compositor samples the surface directly.
+struct NativeVideoBuffer {
+  /// Decoded frame as a D3D9 surface. Valid only for the duration of the
+  /// RenderNativeFrame call; the surface is recycled by the decoder
+  /// afterwards, so a compositor that needs it longer must copy on GPU.
+  IDirect3DSurface9* surface;
+  /// Device manager owning the device that |surface| lives on.
+  IDirect3DDeviceManager9* dev_manager;
+  /// Reset token for opening a device handle on |dev_manager|.
+  unsigned int dev_manager_reset_token;
+  /// Resolution of the frame.
+  Resolution resolution;
 };
+#endif
 /// Video buffer and its information
 struct VideoBuffer {
   /// Video buffer
@@ -29,13 +53,48 @@ struct VideoBuffer {
   Resolution resolution;
   // Buffer type
   VideoBufferType type;
-  ~VideoBuffer() { delete[] buffer; }
+  /// When set, destruction hands |buffer| back to its owner for reuse
+  /// instead of freeing it; the SDK uses this to recycle frame buffers so
+  /// steady-state rendering performs no allocation.
+  std::function<void(uint8_t*)> recycler;
+  /// RTP timestamp of the frame (90 kHz). Assigned on the sending side
+  /// and carried unchanged across the network, so it is the stable key
+  /// for correlating a rendered frame with sender-side records when a
+  /// frame source stamps its frames (VideoFrameGeneratorInterface::
+  /// GetNextFrameTimestampMs).
+  uint32_t rtp_timestamp;
+  /// Local time this buffer was handed to the renderer, in milliseconds
+  /// on the SDK clock.
+  int64_t render_time_ms;
+  ~VideoBuffer() {
+    if (recycler) {
+      recycler(buffer);
+    } else {
+      delete[] buffer;
+    }
+  }
 };
 /// VideoRenderWindow wraps a native Window handle
 #if defined(WEBRTC_WIN)
 class VideoRenderWindow {
  public:
-  VideoRenderWindow() : wnd_(nullptr) {}
+  /// Rendering backend used when a stream is attached to this window.
+  enum class Backend {
+    /// Legacy D3D9 blit path. Available on every supported Windows
+    /// version, but presents through a copy-model swapchain that adds a
+    /// queue frame of latency.
+    kD3D9,
+    /// DXGI flip-model swapchain with GPU color conversion and a waitable
+    /// swapchain capping present latency at one frame. Requires
+    /// Windows 8.1 or newer.
+    kD3D11,
+    /// Like kD3D11, but every stream attached to the same window handle is
+    /// composited onto a uniform grid in one GPU pass with a single
+    /// present per vsync, instead of one renderer, conversion and present
+    /// per stream. Intended for viewing walls with many subscriptions.
+    kD3D11Composited,
+  };
+  VideoRenderWindow() : wnd_(nullptr), backend_(Backend::kD3D9) {}
   virtual ~VideoRenderWindow() {}
   /**
     Set the render window handle for VideoRenderWindow instance.
@@ -47,8 +106,21 @@ class VideoRenderWindow {
     @return Returns the window handle.
   */
   HWND GetWindowHandle() { return wnd_; }
+  /**
+    Select the rendering backend. Takes effect at the next
+    AttachVideoRenderer call; defaults to kD3D9 so existing applications
+    keep their behavior on older systems.
+    @param backend Backend that will be used for rendering.
+  */
+  void SetBackend(Backend backend) { backend_ = backend; }
+  /**
+    Get the rendering backend that will be used.
+    @return Returns the rendering backend.
+  */
+  Backend GetBackend() { return backend_; }
  private:
   HWND wnd_;
+  Backend backend_;
 };
 #endif
 #if defined(WEBRTC_LINUX)
@@ -75,6 +147,12 @@ class VideoRendererInterface {
  public:
   /// Passes video buffer to renderer.
   virtual void RenderFrame(std::unique_ptr<VideoBuffer> buffer) = 0;
+#if defined(WEBRTC_WIN)
+  /// Passes a hardware frame to a renderer of type kNative. Only invoked
+  /// for such renderers, and only for frames decoded on the GPU; software
+  /// frames keep arriving through RenderFrame.
+  virtual void RenderNativeFrame(const NativeVideoBuffer& buffer) {}
+#endif
   virtual ~VideoRendererInterface() {}
   /// Render type that indicates the VideoBufferType the renderer would receive.
   virtual VideoRendererType Type() = 0;
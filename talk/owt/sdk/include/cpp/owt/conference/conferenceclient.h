@@ -3,18 +3,25 @@
 // SPDX-License-Identifier: Apache-2.0
 #ifndef OWT_CONFERENCE_CONFERENCECLIENT_H_
 #define OWT_CONFERENCE_CONFERENCECLIENT_H_
+#include <condition_variable>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 #include <set>
 #include "owt/base/commontypes.h"
 #include "owt/base/clientconfiguration.h"
 #include "owt/base/connectionstats.h"
+#include "owt/base/memorystats.h"
+#include "owt/base/queuestats.h"
+#include "owt/base/threadstats.h"
 #include "owt/base/options.h"
 #include "owt/base/stream.h"
 #include "owt/base/exception.h"
+#include "owt/base/internedstring.h"
 #include "owt/conference/conferencepublication.h"
 #include "owt/conference/conferencesubscription.h"
 #include "owt/conference/streamupdateobserver.h"
@@ -40,7 +47,20 @@ using namespace owt::base;
   Changing this configuration does NOT impact ConferenceClient already
   created.
 */
-struct ConferenceClientConfiguration : ClientConfiguration {};
+struct ConferenceClientConfiguration : ClientConfiguration {
+  /**
+   @brief Number of peer connection channels kept pre-created for
+   publish/subscribe.
+   @details Creating a channel at request time pays for PeerConnection
+   setup and certificate generation on the critical path of
+   time-to-first-frame. With a pool size above 0, that many channels are
+   constructed in the background after joining and claimed instantly by
+   Publish/Subscribe calls that use default codec preferences; the pool
+   refills itself after each claim. Default is 0, which disables
+   pre-warming.
+  */
+  int prewarmed_connection_pool_size = 0;
+};
 class RemoteMixedStream;
 class ConferencePeerConnectionChannel;
 class ConferenceSocketSignalingChannel;
@@ -105,9 +125,17 @@ class ConferenceInfo {
       return remote_streams_;
     }
     /// Current participant list in the conference.
-    std::vector<std::shared_ptr<Participant>> Participants() const {
-      return participants_;
-    }
+    /// @details Materializes every participant that is still held in lazy
+    /// form, so in very large rooms prefer ParticipantCount() and
+    /// FindParticipant().
+    std::vector<std::shared_ptr<Participant>> Participants() const;
+    /// Number of participants in the conference, including the ones that
+    /// have not been materialized yet.
+    size_t ParticipantCount() const;
+    /// Find a participant by ID, materializing it on demand. Returns
+    /// nullptr if no such participant is present.
+    std::shared_ptr<Participant> FindParticipant(
+        const std::string& participant_id) const;
     /// Conference ID.
     std::string Id() const { return id_; }
     /// The participant info of current conference client.
@@ -117,6 +145,11 @@ class ConferenceInfo {
    protected:
     // Add participant.
     void AddParticipant(std::shared_ptr<Participant> participant);
+    // Record a participant in lazy form. The Participant object is only
+    // built when the participant is looked up, which keeps the join cost
+    // of large rooms independent of the room size.
+    void AddPendingParticipant(const std::string& participant_id,
+                               std::shared_ptr<sio::message> user_info);
     // Remove participant.
     void RemoveParticipantById(const std::string& id);
     // Add remote stream.
@@ -134,9 +167,18 @@ class ConferenceInfo {
   private:
     bool ParticipantPresent(const std::string& participant_id);
     bool RemoteStreamPresent(const std::string& stream_id);
+    // Builds the Participant for |participant_id| from its pending user
+    // info and moves it into |participants_|. Callers must hold
+    // |participants_mutex_|. Returns nullptr if there is no pending entry.
+    std::shared_ptr<Participant> MaterializeParticipant(
+        const std::string& participant_id) const;
     std::string id_;                           // Unique id that identifies the conference.
     mutable std::mutex participants_mutex_;
-    std::vector<std::shared_ptr<Participant>> participants_;    // Participants in the conference
+    mutable std::vector<std::shared_ptr<Participant>> participants_;    // Participants in the conference
+    // Participants known only by their raw user info, keyed by ID. They
+    // move to |participants_| when materialized.
+    mutable std::unordered_map<std::string, std::shared_ptr<sio::message>>
+        pending_participants_;
     mutable std::mutex remote_streams_mutex_;
     std::vector<std::shared_ptr<RemoteStream>> remote_streams_; // Remote streams in the conference.
     std::shared_ptr<Participant> self_;                           // Self participant in the conference.
@@ -151,6 +193,9 @@ class ConferenceSocketSignalingChannelObserver {
   virtual void OnStreamRemoved(std::shared_ptr<sio::message> stream) = 0;
   virtual void OnStreamUpdated(std::shared_ptr<sio::message> stream) = 0;
   virtual void OnServerDisconnected() = 0;
+  // Triggered when the socket reconnects and relogin with the reconnection
+  // ticket succeeds, i.e., sessions are still alive on server side.
+  virtual void OnServerReconnectionSucceeded() = 0;
   virtual void OnCustomMessage(std::string& from, std::string& message, std::string& to) = 0;
   virtual void OnSignalingMessage(std::shared_ptr<sio::message> message) = 0;
   virtual void OnStreamError(std::shared_ptr<sio::message> stream) = 0;
@@ -215,6 +260,12 @@ class ConferenceClient final
       public std::enable_shared_from_this<ConferenceClient> {
   friend class ConferencePublication;
   friend class ConferenceSubscription;
+  // ConferenceInfo materializes lazily stored participants with
+  // ConferenceClient::ParseUser.
+  friend class ConferenceInfo;
+  // Drives ParseStreamInfo and ParseUser against the generated
+  // signaling fixture corpus.
+  friend class ConferenceClientParserTest;
  public:
   /**
     @brief Create a ConferenceClient instance with specific configuration
@@ -237,6 +288,16 @@ class ConferenceClient final
       const std::string& token,
       std::function<void(std::shared_ptr<ConferenceInfo>)> on_success,
       std::function<void(std::unique_ptr<Exception>)> on_failure);
+  /**
+    @brief Warm up connection resources before joining a conference.
+    @details Creates the PeerConnection factory and starts filling the
+    pre-warmed channel pool, so a later Join only spends time on the
+    network round trips. Join starts the same warm-up in parallel with the
+    socket connection, so calling Preconnect is optional; it helps when
+    the application can predict a join, e.g. while the user hovers over
+    the join button.
+  */
+  void Preconnect();
   /**
     @brief Leave current conference.
   */
@@ -254,11 +315,13 @@ class ConferenceClient final
   /**
     @brief Publish the stream to the current room.
     @param stream The stream to be published.
-    @param options Options for publishing the stream.
+    @param options Options for publishing the stream. Taken by value:
+    pass with std::move to transfer ownership of the codec vectors
+    without copying; they are consumed by the publication setup.
   */
   void Publish(
       std::shared_ptr<LocalStream> stream,
-      const PublishOptions& options,
+      PublishOptions options,
       std::function<void(std::shared_ptr<ConferencePublication>)> on_success,
       std::function<void(std::unique_ptr<Exception>)> on_failure);
   /**
@@ -273,14 +336,35 @@ class ConferenceClient final
   /**
     @brief Subscribe a stream from the current room.
     @param stream The remote stream to be subscribed.
-    @param options Options for subscribing the stream.
+    @param options Options for subscribing the stream. Taken by value:
+    pass with std::move to transfer ownership of the codec vectors
+    without copying; they are consumed by the subscription setup.
     @param onSuccess Success callback with a stream that contains media stream.
   */
   void Subscribe(
       std::shared_ptr<RemoteStream> stream,
-      const SubscribeOptions& options,
+      SubscribeOptions options,
       std::function<void(std::shared_ptr<ConferenceSubscription>)> on_success,
       std::function<void(std::unique_ptr<Exception>)> on_failure);
+  /**
+    @brief Subscribe many streams from the current room in one batch.
+    @details All subscription requests are queued on the socket
+    back-to-back before any answer arrives, so the peer connection
+    channels negotiate offer/answer and ICE concurrently instead of one
+    join-storm round trip per stream. Use this when entering a room with
+    many streams; it behaves like calling Subscribe per stream but without
+    waiting in between.
+    @param streams The remote streams to be subscribed.
+    @param options Options applied to every subscription in the batch.
+    @param on_success Invoked once per stream that subscribes successfully.
+    @param on_failure Invoked once per stream that fails, with that stream.
+  */
+  void SubscribeBatch(
+      const std::vector<std::shared_ptr<RemoteStream>>& streams,
+      const SubscribeOptions& options,
+      std::function<void(std::shared_ptr<ConferenceSubscription>)> on_success,
+      std::function<void(std::shared_ptr<RemoteStream>,
+                         std::unique_ptr<Exception>)> on_failure);
   /**
     @brief Send messsage to all participants in the conference.
     @param message The message to be sent.
@@ -299,6 +383,21 @@ class ConferenceClient final
       const std::string& receiver,
       std::function<void()> on_success,
       std::function<void(std::unique_ptr<Exception>)> on_failure);
+  /**
+    @brief Send a binary message to a participant in the conference.
+    @details The payload is handed to the socket layer as a binary
+    attachment without being copied or escaped into JSON text. Payloads
+    larger than one websocket frame are split into chunks and reassembled
+    transparently on the receiving client.
+    @param data The binary payload to be sent.
+    @param receiver Receiver's user ID. An empty string sends to all
+    participants.
+  */
+  void Send(
+      std::shared_ptr<const std::string> data,
+      const std::string& receiver,
+      std::function<void()> on_success,
+      std::function<void(std::unique_ptr<Exception>)> on_failure);
  protected:
   ConferenceClient(const ConferenceClientConfiguration& configuration);
   // Implementing ConferenceSocketSignalingChannelObserver.
@@ -314,6 +413,7 @@ class ConferenceClient final
   virtual void OnStreamUpdated(std::shared_ptr<sio::message> stream) override;
   virtual void OnStreamError(std::shared_ptr<sio::message> stream) override;
   virtual void OnServerDisconnected() override;
+  virtual void OnServerReconnectionSucceeded() override;
   virtual void OnStreamId(const std::string& id,
                           const std::string& publish_stream_label) override;
   virtual void OnSubscriptionId(const std::string& subscription_id,
@@ -355,11 +455,119 @@ class ConferenceClient final
       const std::string& session_id,
       std::function<void(std::shared_ptr<ConnectionStats>)> on_success,
       std::function<void(std::unique_ptr<Exception>)> on_failure);
+  /**
+    @brief Get connection statistics for all active publications and
+    subscriptions in one pass.
+    @details Traverses every session once and invokes |on_complete| with a
+    single snapshot mapping session IDs to their statistics, instead of one
+    async round trip per session. Sessions whose statistics could not be
+    collected are omitted from the snapshot.
+  */
+  void GetAllConnectionStats(
+      std::function<
+          void(std::shared_ptr<
+               std::unordered_map<std::string, std::shared_ptr<ConnectionStats>>>)>
+          on_complete);
+  /**
+    @brief Start sampling connection statistics periodically.
+    @details Every |interval_ms| milliseconds the sampler collects the
+    statistics of all active publications and subscriptions and publishes
+    them as one immutable snapshot. Exporters poll the newest snapshot
+    through GetSampledConnectionStats instead of issuing one async stats
+    request per session, so a frequent exporter no longer marshals work
+    through the signaling thread. Calling this while sampling is already
+    running adjusts the interval.
+  */
+  void StartStatsSampling(int interval_ms);
+  /// Stop periodic sampling. The last published snapshot stays readable.
+  void StopStatsSampling();
+  /**
+    @brief Get the newest complete sampled statistics snapshot.
+    @details Returns the snapshot most recently published by the sampler,
+    mapping session IDs to their statistics, or null if sampling has not
+    produced one yet. A snapshot is immutable once published and the read
+    is a single atomic pointer load, so callers never block the sampler
+    or any media thread.
+  */
+  std::shared_ptr<
+      const std::unordered_map<std::string, std::shared_ptr<ConnectionStats>>>
+  GetSampledConnectionStats();
+  /**
+    @brief Serialize the newest sampled statistics snapshot into one
+    columnar binary buffer.
+    @details Flat little-endian arrays, one per metric across all
+    sessions; see ColumnarStatsWriter for the exact layout. An exporter
+    ships the buffer as-is instead of converting the object graph of
+    every session. Empty when sampling has not produced a snapshot yet.
+  */
+  std::vector<uint8_t> ExportSampledStatsBinary();
+  /**
+    @brief Start orchestrating uplink bandwidth across publications.
+    @details Every |interval_ms| milliseconds the orchestrator reads the
+    available send bandwidth of every active publication, treats their sum
+    as the usable uplink, and splits it between the publications by their
+    PublishOptions::bandwidth_priority weights. Each share is pushed as a
+    runtime cap on that connection's send-side bandwidth allocator, so
+    concurrent publications — camera plus screen share, typically — stop
+    probing against each other on a constrained link and settle at the
+    requested ratio. With fewer than two publications the orchestrator
+    leaves the engine's own estimation alone. Calling this while
+    orchestration is already running adjusts the interval.
+  */
+  void StartBandwidthOrchestration(int interval_ms);
+  /// Stop orchestrating and restore every publication's configured caps.
+  void StopBandwidthOrchestration();
+  /**
+    @brief Start active-speaker audio focus control across subscriptions.
+    @details The engine already mixes every subscribed audio stream into
+    one shared playout path; with many subscriptions the cost is the
+    per-stream sources feeding that mixer, most of which are silent at
+    any moment. Every |interval_ms| milliseconds the controller ranks
+    subscriptions by their reported playout level and keeps only the
+    |max_active_streams| loudest audio tracks enabled; the rest are
+    disabled until they rank again. Suspended subscriptions are never
+    woken by focus changes. Calling this while control is already running
+    adjusts both parameters.
+  */
+  void StartAudioFocusControl(int max_active_streams, int interval_ms);
+  /// Stop focus control and re-enable every subscription's audio.
+  void StopAudioFocusControl();
+  /**
+    @brief Set the playout gain of one subscribed session's audio.
+    @details Applied at the source feeding the engine's shared mixer, so
+    per-participant balance costs no extra processing stage. 1.0 is
+    unity; 0 silences the stream without touching its decode state.
+    Unknown session IDs are ignored.
+  */
+  void SetAudioPlayoutGain(const std::string& session_id, double gain);
   void GetStats(
       const std::string& session_id,
       std::function<void(
           const std::vector<const webrtc::StatsReport*>& reports)> on_success,
       std::function<void(std::unique_ptr<Exception>)> on_failure);
+  /**
+    @brief Get the SDK's current memory footprint grouped by subsystem.
+    @details Returns the bytes held by accounted allocation sites (frame
+    buffer pools, hardware codec surfaces, queued signaling messages).
+    Counters are process wide and returned synchronously.
+  */
+  std::vector<MemoryStatsEntry> GetMemoryStats();
+  /**
+    @brief Get current pipeline queue depths and their high watermarks.
+    @details Gauges cover the queues between pipeline stages (hardware
+    codec surface pools, the renderer mailbox, the capturer's frame
+    pool), so backpressure can be localized to the stage whose queue is
+    backing up. Counters are process wide and returned synchronously.
+  */
+  std::vector<QueueDepthEntry> GetQueueDepthStats();
+  /**
+    @brief Get load samples for the SDK's signaling/worker/network threads.
+    @details Each entry carries the thread's CPU utilization over the
+    last probe interval and the queue delay posted tasks experience on
+    it, so an API latency spike can be attributed to the thread that is
+    saturated. Counters are process wide and returned synchronously.
+  */
+  std::vector<ThreadLoadEntry> GetThreadLoadStats();
   /**
     @brief Mute a session's track specified by |track_kind|.
   */
@@ -376,40 +584,189 @@ class ConferenceClient final
       TrackKind track_kind,
       std::function<void()> on_success,
       std::function<void(std::unique_ptr<Exception>)> on_failure);
+  /**
+    @brief Mute a track on many sessions with one server round trip.
+    @details All sessions are carried in a single control message, so
+    muting a whole room does not cost one round trip per session.
+    |on_success| fires when the server has acknowledged the whole batch.
+  */
+  void Mute(
+      const std::vector<std::string>& session_ids,
+      TrackKind track_kind,
+      std::function<void()> on_success,
+      std::function<void(std::unique_ptr<Exception>)> on_failure);
+  /**
+    @brief Unmute a track on many sessions with one server round trip.
+  */
+  void Unmute(
+      const std::vector<std::string>& session_ids,
+      TrackKind track_kind,
+      std::function<void()> on_success,
+      std::function<void(std::unique_ptr<Exception>)> on_failure);
+  /**
+    @brief Suspend a subscribed session.
+    @details The server stops forwarding the stream (same control message
+    as pausing both tracks) and the local receive tracks are disabled, so
+    an off-screen tile costs neither decode nor render. ICE, DTLS and the
+    decoder stay warm; only publish/subscribe state is torn down by Stop.
+  */
+  void Suspend(const std::string& session_id,
+               std::function<void()> on_success,
+               std::function<void(std::unique_ptr<Exception>)> on_failure);
+  /**
+    @brief Resume a suspended session.
+    @details Re-enables the receive tracks before asking the server to
+    forward again, so the first forwarded frame reaches the
+    still-initialized decoder without renegotiation.
+  */
+  void Resume(const std::string& session_id,
+              std::function<void()> on_success,
+              std::function<void(std::unique_ptr<Exception>)> on_failure);
+  /**
+    @brief Update playout delay hints for a subscribed session.
+    @details Takes effect locally without a server round trip; see
+    PlayoutDelayConstraints for what each bound maps onto. Unknown
+    session IDs are ignored.
+  */
+  void SetPlayoutDelay(const std::string& session_id, int min_ms, int max_ms);
  private:
+  typedef std::vector<std::shared_ptr<ConferencePeerConnectionChannel>>
+      ChannelList;
+  // Copy-on-write access to the channel lists below. Readers get the
+  // current immutable snapshot without locking; writers serialize on the
+  // list's mutex, clone, mutate the clone and publish it atomically.
+  static std::shared_ptr<const ChannelList> ChannelSnapshot(
+      const std::shared_ptr<const ChannelList>& list);
+  // Shared implementation of the bulk Mute/Unmute overloads. Splits
+  // |session_ids| into published and subscribed sessions and sends one
+  // bulk control message for each group.
+  // Delivers the newest queued video.layout update for |stream_id| as a
+  // region diff. Runs on |event_queue_| when the layout batching window
+  // closes.
+  void FlushPendingLayout(const std::string& stream_id);
+  // Restarts ICE on every publication and subscription, reusing the
+  // existing DTLS and SRTP contexts while candidates are regathered.
+  // Used after signaling reconnection and on network interface changes.
+  void RestartIceForAllSessions();
+  void SendBulkTrackControl(
+      const std::vector<std::string>& session_ids,
+      TrackKind track_kind,
+      const std::string& operation,
+      std::function<void()> on_success,
+      std::function<void(std::unique_ptr<Exception>)> on_failure);
+  static void AddToChannelList(
+      std::shared_ptr<const ChannelList>& list,
+      std::mutex& mutex,
+      std::shared_ptr<ConferencePeerConnectionChannel> channel);
+  static void RemoveFromChannelList(std::shared_ptr<const ChannelList>& list,
+                                    std::mutex& mutex,
+                                    const std::string& session_id);
+  static void ClearChannelList(std::shared_ptr<const ChannelList>& list,
+                               std::mutex& mutex);
   /// Return true if |pointer| is not a null pointer, else return false and
   /// trigger |on_failure| with |failure_message|.
   bool CheckNullPointer(
       uintptr_t pointer,
-      std::function<void(std::unique_ptr<Exception>)> on_failure);
+      const std::function<void(std::unique_ptr<Exception>)>& on_failure);
   bool CheckNullPointer(
       uintptr_t pointer,
       const std::string& failure_message,
-      std::function<void(std::unique_ptr<Exception>)> on_failure);
+      const std::function<void(std::unique_ptr<Exception>)>& on_failure);
   /// Return true if signaling channel is connected, else return false and
   /// trigger |on_failure|
   bool CheckSignalingChannelOnline(
-      std::function<void(std::unique_ptr<Exception>)> on_failure);
+      const std::function<void(std::unique_ptr<Exception>)>& on_failure);
   PeerConnectionChannelConfiguration GetPeerConnectionChannelConfiguration()
       const;
+  // Returns a channel for a new publish or subscribe. When
+  // |default_configuration| is true and pre-warming is enabled, a channel
+  // from the pool is claimed instead of constructed; custom codec
+  // preferences always build a fresh channel because SDP reordering is
+  // fixed at construction.
+  std::shared_ptr<ConferencePeerConnectionChannel> CreateChannel(
+      PeerConnectionChannelConfiguration config,
+      bool default_configuration);
+  // Asynchronously constructs channels until the pool holds the
+  // configured number again.
+  void RefillChannelPool();
   // Get the |ConferencePeerConnectionChannel| instance associated with specific
   // |session_id|. Return |nullptr| if not found.
   std::shared_ptr<ConferencePeerConnectionChannel>
   GetConferencePeerConnectionChannel(const std::string& session_id) const;
+  // Routing cache maintenance; see |session_routing_|.
+  void MemoizeSessionRoute(
+      const std::string& session_id,
+      std::shared_ptr<ConferencePeerConnectionChannel> channel) const;
+  void ForgetSessionRoute(const std::string& session_id) const;
+  void ClearSessionRoutes();
+  // Flat, pre-parsed form of a stream update notification. Built once on
+  // the socket.io receive thread, so the stream event queue carries a
+  // small value instead of a shared sio tree that is re-walked when the
+  // task runs. Fixed-shape fields are extracted; only the variable-size
+  // layout region list and full-info updates keep a sio subtree.
+  struct StreamUpdateEvent {
+    enum UpdateKind : int {
+      kUpdateKindNone = 0,  // Unrecognized field; delivered nowhere.
+      kUpdateKindVideoLayout,
+      kUpdateKindActiveInput,
+      kUpdateKindAudioStatus,
+      kUpdateKindVideoStatus,
+      kUpdateKindInfo,  // "." event carrying full stream info.
+      // "info.delta" event carrying a field mask plus only the changed
+      // values; applied in place without re-parsing the stream info.
+      kUpdateKindInfoDelta,
+    };
+    StreamUpdateEvent() : kind(kUpdateKindNone), muted(false) {}
+    std::string stream_id;
+    UpdateKind kind;
+    // Active input stream ID for |kUpdateKindActiveInput|.
+    std::string value;
+    // Valid for the two status kinds.
+    bool muted;
+    // Layout region list or stream info subtree; null for other kinds.
+    std::shared_ptr<sio::message> payload;
+  };
   void TriggerOnUserJoined(std::shared_ptr<sio::message> user_info, bool joining = false);
   void TriggerOnUserLeft(std::shared_ptr<sio::message> user_info);
   void TriggerOnStreamAdded(std::shared_ptr<sio::message> stream_info, bool joining = false);
-  void TriggerOnStreamRemoved(std::shared_ptr<sio::message> stream_info);
-  void TriggerOnStreamUpdated(std::shared_ptr<sio::message> stream_info);
+  void TriggerOnStreamRemoved(const std::string& stream_id);
+  void TriggerOnStreamUpdated(const StreamUpdateEvent& event);
+  // Applies a delta-encoded stream update to |stream| field by field.
+  // Falls back to a full ParseStreamInfo when the delta masks a field
+  // this client cannot patch incrementally and the server attached the
+  // full info alongside.
+  void ApplyStreamInfoDelta(const std::string& id,
+                            std::shared_ptr<RemoteStream> stream,
+                            std::shared_ptr<sio::message> delta);
+  // Validates and flattens a stream update notification on the receive
+  // thread. Returns false if |stream_info| is malformed.
+  static bool ParseStreamUpdate(std::shared_ptr<sio::message> stream_info,
+                                StreamUpdateEvent* event);
   void TriggerOnStreamError(std::shared_ptr<Stream> stream,
                             std::shared_ptr<const Exception> exception);
   // Return true if |user_info| is correct, and |*participant| points to the participant
   // object
-  bool ParseUser(std::shared_ptr<sio::message> user_info, Participant** participant) const;
+  static bool ParseUser(std::shared_ptr<sio::message> user_info,
+                        Participant** participant);
   void ParseStreamInfo(std::shared_ptr<sio::message> stream_info, bool joining = false);
-  std::unordered_map<std::string, std::string> AttributesFromStreamInfo(
+  // Parse the capability and settings part of a stream's media info.
+  // This is the expensive part of ParseStreamInfo and runs deferred, on
+  // first access to a remote stream's Capabilities() or Settings().
+  // Return false if |media_info| is malformed.
+  static bool ParseStreamCapabilities(
+      std::shared_ptr<sio::message> media_info,
+      SubscriptionCapabilities& subscription_capabilities,
+      PublicationSettings& publication_settings);
+  std::shared_ptr<const std::unordered_map<std::string, std::string>>
+  AttributesFromStreamInfo(
       std::shared_ptr<sio::message> stream_info);
   std::function<void()> RunInEventQueue(std::function<void()> func);
+  // Returns the event queue that handles stream events for |stream_id|.
+  rtc::TaskQueue* StreamEventQueue(const std::string& stream_id);
+  // Cheap classifier run on the socket.io receive thread; returns an
+  // empty string if |stream_info| carries no stream ID.
+  static std::string StreamIdFromMessage(
+      std::shared_ptr<sio::message> stream_info);
   // Check if all characters are base 64 allowed or '='.
   bool IsBase64EncodedString(const std::string str) const;
   /// Add an observer for conferenc client.
@@ -424,30 +781,141 @@ class ConferenceClient final
   std::shared_ptr<ConferenceSocketSignalingChannel> signaling_channel_;
   std::mutex observer_mutex_;
   bool signaling_channel_connected_;
-  // Key publish(session) ID from server, value is MediaStream's label
-  std::unordered_map<std::string, std::string> publish_id_label_map_;
-  // Store the peer connection channels created.
-  std::vector<std::shared_ptr<ConferencePeerConnectionChannel>>
-      publish_pcs_;
+  // Registration with the process-wide network change notifier, removed
+  // on destruction.
+  int network_change_callback_id_;
+  // Key publish(session) ID from server, value is MediaStream's label.
+  // ID-keyed maps use InternedString so each UUID is stored once no
+  // matter how many maps and callbacks hold it.
+  std::unordered_map<InternedString, InternedString, InternedString::Hash>
+      publish_id_label_map_;
+  // Store the peer connection channels created. The channel lists are
+  // immutable snapshots: writers clone the current list and publish the
+  // copy atomically under the corresponding mutex, readers load the
+  // snapshot without taking any lock, so read-mostly paths like stats
+  // polling and stream events never contend with subscription churn. The
+  // mutexes also keep guarding the id/label maps next to each list.
+  std::shared_ptr<const ChannelList> publish_pcs_;
   mutable std::mutex publish_pcs_mutex_;
   // Key is subcription ID from server.
-  std::vector<std::shared_ptr<ConferencePeerConnectionChannel>>
-      subscribe_pcs_;
+  std::shared_ptr<const ChannelList> subscribe_pcs_;
+  // Session-id routing cache over both channel lists. The map is an
+  // immutable snapshot like the lists themselves: readers load it
+  // without locking and resolve a session in one hash lookup instead of
+  // scanning both lists per media event; misses fall back to the scan
+  // and memoize the hit. Entries are dropped with their channel and the
+  // whole map is cleared with the lists.
+  using SessionRoutingMap =
+      std::unordered_map<std::string,
+                         std::shared_ptr<ConferencePeerConnectionChannel>>;
+  mutable std::shared_ptr<const SessionRoutingMap> session_routing_;
+  mutable std::mutex session_routing_mutex_;
+  // Pre-warmed channels waiting to be claimed; see
+  // ConferenceClientConfiguration::prewarmed_connection_pool_size.
+  std::vector<std::shared_ptr<ConferencePeerConnectionChannel>> channel_pool_;
+  // True while the pool may be (re)filled: set by Preconnect and Join,
+  // cleared when the server connection ends.
+  bool channel_pool_active_;
+  mutable std::mutex channel_pool_mutex_;
   // Key is subscription ID, value is streamID.
-  std::unordered_map<std::string, std::string> subscribe_id_label_map_;
+  std::unordered_map<InternedString, InternedString, InternedString::Hash>
+      subscribe_id_label_map_;
   mutable std::mutex subscribe_pcs_mutex_;
+  // Queues for handling stream added/updated/removed events off the
+  // socket.io receive thread. Events for the same stream always land on
+  // the same queue so their order is preserved; events for independent
+  // streams are handled in parallel. SDP and ICE messages are dispatched
+  // inline on the receive thread and never wait behind stream parsing.
+  std::vector<std::shared_ptr<rtc::TaskQueue>> stream_event_queues_;
   // Key is the stream ID(publication ID or mixed stream ID).
-  std::unordered_map<std::string, std::shared_ptr<RemoteStream>>
+  std::unordered_map<InternedString, std::shared_ptr<RemoteStream>,
+                     InternedString::Hash>
       added_streams_;
-  std::unordered_map<std::string, StreamType> added_stream_type_;
+  std::unordered_map<InternedString, StreamType, InternedString::Hash>
+      added_stream_type_;
+  // Guards |added_streams_| and |added_stream_type_|, which are accessed
+  // from the stream event queues and from application threads.
+  mutable std::mutex added_streams_mutex_;
+  // Snapshot of parsed stream information kept across leave/rejoin.
+  // Keyed by stream ID and validated by a fingerprint of the stream's
+  // serialized info (the signaling protocol carries no version or etag,
+  // so the payload fingerprint plays that role): a rejoin to the same
+  // room reuses the parsed attributes, publication settings and
+  // subscription capabilities of every stream whose info is unchanged.
+  struct CachedStreamInfo {
+    uint64_t fingerprint;
+    std::shared_ptr<const std::unordered_map<std::string, std::string>>
+        attributes;
+    // Set once the deferred capability parse ran for this info.
+    bool capabilities_valid;
+    SubscriptionCapabilities subscription_capabilities;
+    PublicationSettings publication_settings;
+  };
+  std::unordered_map<InternedString, CachedStreamInfo, InternedString::Hash>
+      stream_info_cache_;
+  mutable std::mutex stream_info_cache_mutex_;
+  // Newest undelivered video.layout update per mixed stream, guarded by
+  // |pending_layout_mutex_|. Layout events arriving within the batching
+  // window collapse to the newest layout before a diff is delivered.
+  std::unordered_map<std::string, std::shared_ptr<sio::message>>
+      pending_layouts_;
+  std::mutex pending_layout_mutex_;
   mutable std::mutex conference_info_mutex_;
   // Store current conference info.
   std::shared_ptr<ConferenceInfo> current_conference_info_;
+  // Periodic stats sampling (StartStatsSampling). The sampler thread wakes
+  // every interval and collects all sessions into a fresh buffer, then
+  // publishes it with an atomic pointer store; the sample under
+  // construction and the published sample are always distinct buffers, so
+  // readers see complete snapshots only. |stats_sampling_mutex_| guards
+  // the thread lifetime and interval, never the published snapshot.
+  typedef std::unordered_map<std::string, std::shared_ptr<ConnectionStats>>
+      SampledStatsMap;
+  void StatsSamplingLoop();
+  void SampleConnectionStatsOnce();
+  std::thread stats_sampling_thread_;
+  std::mutex stats_sampling_mutex_;
+  std::condition_variable stats_sampling_cv_;
+  bool stats_sampling_active_;
+  int stats_sampling_interval_ms_;
+  std::shared_ptr<const SampledStatsMap> sampled_stats_;
+  // Cross-publication bandwidth orchestration
+  // (StartBandwidthOrchestration). Same thread shape as the stats
+  // sampler: the loop wakes every interval, gathers each publication's
+  // bandwidth estimate with a bounded wait and pushes the weighted split
+  // back as runtime send caps. |bandwidth_orchestration_mutex_| guards
+  // the thread lifetime and interval only.
+  void BandwidthOrchestrationLoop();
+  void OrchestrateBandwidthOnce();
+  std::thread bandwidth_orchestration_thread_;
+  std::mutex bandwidth_orchestration_mutex_;
+  std::condition_variable bandwidth_orchestration_cv_;
+  bool bandwidth_orchestration_active_;
+  int bandwidth_orchestration_interval_ms_;
+  // Active-speaker audio focus control (StartAudioFocusControl). Same
+  // thread shape as the orchestrator; the loop ranks subscriptions by
+  // reported playout level and gates their audio tracks.
+  void AudioFocusControlLoop();
+  void ApplyAudioFocusOnce();
+  std::thread audio_focus_thread_;
+  std::mutex audio_focus_mutex_;
+  std::condition_variable audio_focus_cv_;
+  bool audio_focus_active_;
+  int audio_focus_interval_ms_;
+  int audio_focus_max_active_;
   // Capturing observer in |event_queue_| is not 100% safe although above queue
   // is excepted to be ended after ConferenceClient is destroyed.
-  std::vector<std::reference_wrapper<ConferenceClientObserver>> observers_;
+  // Observer lists are immutable snapshots like the channel lists:
+  // registration clones the current list and publishes the copy atomically
+  // under the corresponding mutex, while event fan-out loads the snapshot
+  // without locking, so dispatch never contends with registration.
+  typedef std::vector<std::reference_wrapper<ConferenceClientObserver>>
+      ObserverList;
+  typedef std::vector<std::reference_wrapper<ConferenceStreamUpdateObserver>>
+      StreamUpdateObserverList;
+  std::shared_ptr<const ObserverList> observers_;
   mutable std::mutex stream_update_observer_mutex_;
-  std::vector <std::reference_wrapper<ConferenceStreamUpdateObserver>> stream_update_observers_;
+  std::shared_ptr<const StreamUpdateObserverList> stream_update_observers_;
 };
 }
 }
@@ -36,6 +36,22 @@ class ConferenceSubscription : public ConferenceStreamUpdateObserver,
     void Unmute(TrackKind track_kind,
                 std::function<void()> on_success,
                 std::function<void(std::unique_ptr<Exception>)> on_failure);
+    /**
+      @brief Suspend this subscription while keeping the session warm.
+      @details The server stops forwarding (the same control machinery as
+      muting both tracks) and the local receive tracks are disabled, so an
+      off-screen tile costs neither decode nor render CPU. The transport,
+      DTLS context and decoder stay initialized, which keeps Resume a
+      single control message away from the first frame. Mute state and
+      suspension are independent.
+    */
+    void Suspend(std::function<void()> on_success,
+                 std::function<void(std::unique_ptr<Exception>)> on_failure);
+    /// Resume a suspended subscription.
+    void Resume(std::function<void()> on_success,
+                std::function<void(std::unique_ptr<Exception>)> on_failure);
+    /// If the subscription is currently suspended.
+    bool Suspended() const { return suspended_; }
     /// Get conneciton stats of current subscription
     void GetStats(
         std::function<void(std::shared_ptr<ConnectionStats>)> on_success,
@@ -59,17 +75,63 @@ class ConferenceSubscription : public ConferenceStreamUpdateObserver,
     void AddObserver(SubscriptionObserver& observer);
     /// Remove observer on the subscription.
     void RemoveObserver(SubscriptionObserver& observer);
+    /**
+      @brief Enable the built-in adaptive QoS controller.
+      @details The controller polls this subscription's connection stats on
+      the client's event queue and applies debounced subscription updates:
+      it lowers the bitrate multiplier when packet loss or video delay
+      crosses the policy's downgrade thresholds and raises it again once
+      the connection recovers. Thresholds and pacing come from |policy|.
+      Calling this again replaces the active policy.
+    */
+    void EnableAdaptiveQos(const SubscriptionQosPolicy& policy);
+    /// Disable the adaptive QoS controller. The last applied subscription
+    /// update stays in effect.
+    void DisableAdaptiveQos();
+    /**
+      @brief Update this subscription's playout delay hints.
+      @details Takes effect locally without a server round trip, so the
+      latency/smoothness trade can follow the stream's role, e.g. drop
+      |max_ms| to zero while a participant is the active speaker and
+      restore it afterwards. See PlayoutDelayConstraints for what each
+      bound maps onto at this engine revision.
+    */
+    void SetPlayoutDelay(int min_ms, int max_ms);
+    /**
+      @brief Set the playout gain of this subscription's audio.
+      @details Applied at the source feeding the engine's shared mixer,
+      so per-participant balance costs no extra processing stage. 1.0 is
+      unity; 0 silences the stream without touching its decode state.
+    */
+    void SetAudioPlayoutGain(double gain);
   private:
     void OnStreamMuteOrUnmute(const std::string& stream_id, TrackKind track_kind, bool muted);
+    // Schedules the next QoS poll. |generation| detects stale ticks after
+    // the controller is disabled or reconfigured.
+    void QosTick(uint64_t generation);
+    // Evaluates one stats sample and applies a subscription update when a
+    // threshold is crossed and the hold-off expired.
+    void OnQosStats(uint64_t generation, std::shared_ptr<ConnectionStats> stats);
     void OnStreamRemoved(const std::string& stream_id);
     void OnStreamError(const std::string& error_msg);
     std::string id_;
     std::string stream_id_;
     bool ended_;
+    bool suspended_;
     mutable std::mutex observer_mutex_;
     std::vector<std::reference_wrapper<SubscriptionObserver>> observers_;
     std::weak_ptr<ConferenceClient>  conference_client_;   // Weak ref to associated conference client
     std::shared_ptr<rtc::TaskQueue> event_queue_;
+    // Adaptive QoS controller state, guarded by |qos_mutex_|. The polling
+    // loop runs on |event_queue_|; Enable/Disable may come from any thread.
+    mutable std::mutex qos_mutex_;
+    SubscriptionQosPolicy qos_policy_;
+    uint64_t qos_generation_ = 0;
+    bool qos_have_baseline_ = false;
+    int64_t qos_last_packets_rcvd_ = 0;
+    int64_t qos_last_packets_lost_ = 0;
+    double qos_bitrate_multiplier_ = 1.0;
+    int qos_hold_remaining_ = 0;
 };
 
 } // namespace conference
@@ -3,14 +3,49 @@
 // SPDX-License-Identifier: Apache-2.0
 #ifndef OWT_CONFERENCE_REMOTEMIXEDSTREAM_H_
 #define OWT_CONFERENCE_REMOTEMIXEDSTREAM_H_
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include "owt/base/commontypes.h"
 #include "owt/base/stream.h"
 namespace owt {
 namespace conference {
+/// One region of the mixed video layout.
+struct VideoLayoutRegion {
+  /// Input stream shown in this region. Empty if the region was removed
+  /// from the layout.
+  std::string stream_id;
+  std::string region_id;
+  std::string shape;
+  /// Position and size relative to the mixed frame, in [0, 1].
+  double left = 0;
+  double top = 0;
+  double width = 0;
+  double height = 0;
+};
+inline bool operator==(const VideoLayoutRegion& lhs,
+                       const VideoLayoutRegion& rhs) {
+  return lhs.stream_id == rhs.stream_id && lhs.region_id == rhs.region_id &&
+         lhs.shape == rhs.shape && lhs.left == rhs.left && lhs.top == rhs.top &&
+         lhs.width == rhs.width && lhs.height == rhs.height;
+}
 /// Observer class for remote mixed stream.
 class RemoteMixedStreamObserver : public owt::base::StreamObserver {
  public:
   virtual void OnVideoLayoutChanged(){};
+  /**
+    @brief Triggered with the regions that changed since the last
+    notification. Layout events arriving in one burst are collapsed into
+    a single call carrying only the difference, so a relayout of a large
+    mix does not deliver dozens of full-layout events.
+    @details The default implementation falls back to the parameterless
+    OnVideoLayoutChanged for existing observers.
+  */
+  virtual void OnVideoLayoutChanged(
+      const std::vector<VideoLayoutRegion>& changed_regions) {
+    OnVideoLayoutChanged();
+  }
   virtual void OnActiveInputChanged(const std::string& stream_id){};
 };
 /// This class represent a mixed remote stream.
@@ -41,10 +76,16 @@ class RemoteMixedStream : public owt::base::RemoteStream {
   std::string Viewport();
  protected:
   virtual void OnVideoLayoutChanged();
+  // Diffs |layout| against the last delivered layout and notifies
+  // observers with the changed regions only. No-op if nothing changed.
+  virtual void OnVideoLayoutChanged(const std::vector<VideoLayoutRegion>& layout);
   virtual void OnActiveInputChanged(const std::string& stream_id);
  private:
   const std::string viewport_;
   std::vector<std::reference_wrapper<RemoteMixedStreamObserver>> observers_;
+  // Last delivered layout keyed by region ID, guarded by |layout_mutex_|.
+  std::unordered_map<std::string, VideoLayoutRegion> last_layout_;
+  std::mutex layout_mutex_;
   friend class owt::conference::ConferenceClient;
 };
 }
@@ -4,6 +4,7 @@
 #ifndef OWT_CONFERENCE_SUBSCRIBEOPTIONS_H_
 #define OWT_CONFERENCE_SUBSCRIBEOPTIONS_H_
 #include "owt/base/commontypes.h"
+#include "owt/base/options.h"
 namespace owt {
 namespace conference {
 /// Audio subscription contraints.
@@ -28,18 +29,101 @@ struct VideoSubscriptionConstraints {
         resolution(0, 0),
         frameRate(0),
         bitrateMultiplier(0),
-        keyFrameInterval(0) {}
+        keyFrameInterval(0),
+        temporalLayerId(-1) {}
   bool disabled;
   std::vector<owt::base::VideoCodecParameters> codecs;
   owt::base::Resolution resolution;
   double frameRate;
   double bitrateMultiplier;
   unsigned long keyFrameInterval;
+  /**
+   @brief Highest temporal layer the server should forward, starting at 0
+   for the base layer.
+   @details A publication encoded with temporal scalability halves its
+   framerate with each layer dropped, so subscribing a thumbnail at layer
+   0 of a two-layer 30fps stream decodes 7.5fps instead of 30. The server
+   clamps the value to the layers the publication actually carries; on a
+   publication without temporal scalability it has no effect. Negative
+   means all layers, the publication default.
+  */
+  int temporalLayerId;
+};
+/// Playout delay preferences for one subscription.
+struct PlayoutDelayConstraints {
+  /**
+   @brief Construct PlayoutDelayConstraints with no preference.
+   @details With both bounds unset the engine keeps its default playout
+   behavior.
+  */
+  explicit PlayoutDelayConstraints() : min_ms(-1), max_ms(-1) {}
+  /**
+   @brief Lower bound on playout delay, in milliseconds.
+   @details A positive value states that this subscription prefers
+   smoothness over latency: playout smoothing stays enabled for it even
+   when other options on the same subscription would turn it off. The
+   engine treats the value as a hint, not a guarantee. Negative means no
+   preference.
+  */
+  int min_ms;
+  /**
+   @brief Upper bound on playout delay, in milliseconds.
+   @details Zero requests playout with no buffering at all and selects
+   the same no-buffer path as |low_latency|. Positive values are
+   recorded as a hint; this engine revision exposes no finer-grained
+   receive-side delay target, so they currently keep default buffering.
+   Negative means no preference.
+  */
+  int max_ms;
 };
 /// Subscribe options
 struct SubscribeOptions {
+  /**
+   @brief Construct SubscribeOptions with default settings.
+   @details By default the subscription favors smooth playback.
+  */
+  explicit SubscribeOptions() : low_latency(false) {}
+  /// Copies are tallied by owt::base::OptionsCopyAudit in debug builds.
+  /// Hand the options to Subscribe with std::move to transfer the codec
+  /// vectors instead of copying them; SubscribeBatch still copies once
+  /// per stream because every subscription needs its own options.
+  SubscribeOptions(const SubscribeOptions& other)
+      : audio(other.audio),
+        video(other.video),
+        playout_delay(other.playout_delay),
+        low_latency(other.low_latency) {
+    owt::base::OptionsCopyAudit::RecordCopy();
+  }
+  SubscribeOptions& operator=(const SubscribeOptions& other) {
+    audio = other.audio;
+    video = other.video;
+    playout_delay = other.playout_delay;
+    low_latency = other.low_latency;
+    owt::base::OptionsCopyAudit::RecordCopy();
+    return *this;
+  }
+  SubscribeOptions(SubscribeOptions&&) = default;
+  SubscribeOptions& operator=(SubscribeOptions&&) = default;
   AudioSubscriptionConstraints audio;
   VideoSubscriptionConstraints video;
+  /**
+   @brief Per-subscription playout delay preferences.
+   @details Lets different streams in one conference trade latency
+   against smoothness individually, e.g. zero |max_ms| for the active
+   speaker and a positive |min_ms| for a screen share.
+  */
+  PlayoutDelayConstraints playout_delay;
+  /**
+   @brief Prefer a hard latency bound over smooth playback.
+   @details When enabled the subscription drops frames rather than
+   buffering them: playout smoothing is disabled, hardware decoders emit
+   frames in decode order instead of display order, and the renderer
+   delivers the latest frame and discards stale ones. Decoders and
+   renderers are shared process resources, so these decode and render
+   settings apply to all subscriptions while any low-latency
+   subscription is active.
+  */
+  bool low_latency;
 };
 /// Video subscription update constrains used by subscription's ApplyOptions
 /// API.
@@ -51,17 +135,51 @@ struct VideoSubscriptionUpdateConstraints {
       : resolution(0, 0),
         frameRate(0),
         bitrateMultiplier(0),
-        keyFrameInterval(0) {}
+        keyFrameInterval(0),
+        temporalLayerId(-1) {}
   owt::base::Resolution resolution;
   double frameRate;
   double bitrateMultiplier;
   unsigned long keyFrameInterval;
+  /**
+   @brief Highest temporal layer the server should forward; see
+   VideoSubscriptionConstraints::temporalLayerId. Negative leaves the
+   subscription's current layer selection unchanged.
+  */
+  int temporalLayerId;
 };
 /// Subscription update option used by subscription's ApplyOptions API.
 struct SubscriptionUpdateOptions {
   /// Options for updating a subscription.
   VideoSubscriptionUpdateConstraints video;
 };
+/// Policy for the built-in adaptive QoS controller on a subscription.
+/// See ConferenceSubscription::EnableAdaptiveQos. All thresholds can be
+/// overridden; the defaults react within roughly one RTCP interval.
+struct SubscriptionQosPolicy {
+  /**
+   @brief Construct SubscriptionQosPolicy with default thresholds.
+   */
+  explicit SubscriptionQosPolicy()
+      : downgrade_loss_percent(5.0),
+        upgrade_loss_percent(1.0),
+        downgrade_delay_ms(400),
+        poll_interval_ms(1000),
+        hold_intervals(3),
+        min_bitrate_multiplier(0.25) {}
+  /// Step the subscription down when packet loss exceeds this percentage.
+  double downgrade_loss_percent;
+  /// Step the subscription back up when loss stays below this percentage.
+  double upgrade_loss_percent;
+  /// Step the subscription down when video delay exceeds this value.
+  int downgrade_delay_ms;
+  /// Interval between stats polls, in milliseconds.
+  int poll_interval_ms;
+  /// Number of polls a change is held before another change may apply.
+  int hold_intervals;
+  /// Lower bound for the bitrate multiplier the controller may request.
+  double min_bitrate_multiplier;
+};
 }  // namespace conference
 }  // namespace owt
 #endif  // OWT_CONFERENCE_SUBSCRIBEOPTIONS_H_
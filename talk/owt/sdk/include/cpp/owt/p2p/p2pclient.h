@@ -11,6 +11,9 @@
 #include <set>
 #include "owt/base/commontypes.h"
 #include "owt/base/connectionstats.h"
+#include "owt/base/memorystats.h"
+#include "owt/base/queuestats.h"
+#include "owt/base/threadstats.h"
 #include "owt/base/stream.h"
 #include "owt/p2p/p2ppublication.h"
 #include "owt/p2p/p2psignalingchannelinterface.h"
@@ -22,6 +25,8 @@ namespace rtc {
 }
 namespace owt {
 namespace base {
+  class LocalLoopbackReceiver;
+  class ObserverEventQueue;
   struct PeerConnectionChannelConfiguration;
 }
 namespace p2p{
@@ -33,6 +38,16 @@ namespace p2p{
 struct P2PClientConfiguration : owt::base::ClientConfiguration {
   std::vector<AudioEncodingParameters> audio_encodings;
   std::vector<VideoEncodingParameters> video_encodings;
+  /**
+   @brief Offer a shared memory loopback when publishing.
+   When enabled, Publish additionally offers the remote side a shared
+   memory segment carrying the encoded frames. A subscriber on the same
+   machine that registered a loopback frame listener attaches to the
+   segment and receives the frames without the network round trip or a
+   second decode; a remote subscriber ignores the offer and the WebRTC
+   session is unaffected either way.
+  */
+  bool allow_same_host_loopback = false;
 };
 class P2PPeerConnectionChannelObserverCppImpl;
 class P2PPeerConnectionChannel;
@@ -46,6 +61,14 @@ class P2PClientObserver {
    */
   virtual void OnMessageReceived(const std::string& remote_user_id,
                                  const std::string message){};
+  /**
+   @brief This function will be invoked when binary data is received from a
+   remote user.
+   @param remote_user_id Remote user’s ID
+   @param message Binary payload received
+   */
+  virtual void OnBinaryMessageReceived(const std::string& remote_user_id,
+                                       const std::string& message){};
   /**
    @brief This function will be invoked when a remote stream is available.
    @param stream The remote stream added.
@@ -73,6 +96,7 @@ class P2PClient final
    */
   P2PClient(P2PClientConfiguration& configuration,
             std::shared_ptr<P2PSignalingChannelInterface> signaling_channel);
+  ~P2PClient();
   /*! Add an observer for peer client.
    @param observer Add this object to observer list.
           Do not delete this object until it is removed from observer list.
@@ -172,6 +196,29 @@ class P2PClient final
             const std::string& message,
             std::function<void()> on_success,
             std::function<void(std::unique_ptr<Exception>)> on_failure);
+  /**
+   @brief Send binary data to remote client through a data channel.
+   @details The payload travels without a JSON envelope and is kept as a
+   shared buffer while queued, so bulk transfer does not copy every
+   chunk. Sends beyond the channel's buffer limit are queued and drained
+   as the buffer empties; |on_success| fires once the payload is
+   accepted by the channel and can be used as a drain signal for flow
+   control.
+   @param target_id Remote user's ID.
+   @param data The binary payload to be sent.
+   @param max_retransmits A value below zero sends reliably; otherwise
+   the payload travels on a partially reliable channel retransmitting at
+   most this many times.
+   @param on_success Success callback will be invoked when the payload is
+   handed to the data channel.
+   @param on_failure Failure callback will be invoked if the remote user
+   is not allowed or the payload is empty.
+   */
+  void Send(const std::string& target_id,
+            std::shared_ptr<const std::string> data,
+            int max_retransmits,
+            std::function<void()> on_success,
+            std::function<void(std::unique_ptr<Exception>)> on_failure);
   /**
    @brief Get the connection statistowt with target client.
    @param target_id Remote user's ID.
@@ -187,6 +234,44 @@ class P2PClient final
       const std::string& target_id,
       std::function<void(std::shared_ptr<owt::base::ConnectionStats>)> on_success,
       std::function<void(std::unique_ptr<Exception>)> on_failure);
+  /**
+   @brief Get the SDK's current memory footprint grouped by subsystem.
+   @details Returns the bytes held by accounted allocation sites (frame
+   buffer pools, hardware codec surfaces, queued signaling messages).
+   Counters are process wide and returned synchronously.
+   */
+  std::vector<owt::base::MemoryStatsEntry> GetMemoryStats();
+  /**
+   @brief Get current pipeline queue depths and their high watermarks.
+   @details Gauges cover the queues between pipeline stages (hardware
+   codec surface pools, the renderer mailbox, the capturer's frame
+   pool). Counters are process wide and returned synchronously.
+   */
+  std::vector<owt::base::QueueDepthEntry> GetQueueDepthStats();
+  /**
+   @brief Get load samples for the SDK's signaling/worker/network threads.
+   @details Each entry carries the thread's CPU utilization over the
+   last probe interval and the queue delay posted tasks experience on
+   it, so an API latency spike can be attributed to the thread that is
+   saturated. Counters are process wide and returned synchronously.
+   */
+  std::vector<owt::base::ThreadLoadEntry> GetThreadLoadStats();
+  /**
+   @brief Register a listener for frames arriving over the same-host
+   loopback.
+   @details When a publisher on the same machine offers a shared memory
+   loopback, this client attaches to it only if a listener is
+   registered. The listener receives each encoded frame; |data| is valid
+   only inside the call, which runs on the loopback's poll thread and
+   must not block. Register the listener before the remote side
+   publishes; passing nullptr unregisters it and detaches an active
+   loopback.
+   */
+  void SetLoopbackFrameListener(
+      std::function<void(const uint8_t* data,
+                         size_t size,
+                         uint32_t rtp_timestamp,
+                         bool is_keyframe)> listener);
   /** @cond */
   void SetLocalId(const std::string& local_id);
   /** @endcond */
@@ -202,6 +287,8 @@ class P2PClient final
   // Handle events from P2PPeerConnectionChannel
   // Triggered when remote user send data via data channel.
   // Currently, data is string.
+  virtual void OnBinaryMessageReceived(const std::string& remote_id,
+                                       const std::string& message);
   virtual void OnMessageReceived(const std::string& remote_id,
                                  const std::string& message);
   // Triggered when a new stream is added.
@@ -215,18 +302,56 @@ class P2PClient final
   std::shared_ptr<P2PPeerConnectionChannel> GetPeerConnectionChannel(
       const std::string& target_id);
   bool IsPeerConnectionChannelCreated(const std::string& target_id);
+  // One slice of the channel registry. Channels are spread over
+  // |kChannelShardCount| shards by a hash of the peer ID, so lookups and
+  // channel construction for different peers do not contend on one lock.
+  struct ChannelShard {
+    std::mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<P2PPeerConnectionChannel>>
+        channels;
+  };
+  ChannelShard& ChannelShardFor(const std::string& target_id);
+  void ErasePeerConnectionChannel(const std::string& target_id);
   owt::base::PeerConnectionChannelConfiguration GetPeerConnectionChannelConfiguration();
+  // Intercepts shm-loopback-* signaling messages. Returns true when the
+  // message was a loopback negotiation and must not reach the peer
+  // connection channel.
+  bool HandleLoopbackMessage(const std::string& message,
+                             const std::string& remote_id);
+  // Creates the loopback segment and sends the shm-loopback-offer for an
+  // outgoing publication; no-op unless the configuration enables it.
+  void MaybeOfferLoopback(const std::string& target_id);
+  void StopLoopback();
   // Queue for callbacks and events. Shared among P2PClient and all of it's
   // P2PPeerConnectionChannel.
   std::shared_ptr<rtc::TaskQueue> event_queue_;
   std::shared_ptr<P2PSignalingChannelInterface> signaling_channel_;
-  std::unordered_map<std::string, std::shared_ptr<P2PPeerConnectionChannel>>
-      pc_channels_;
+  static const int kChannelShardCount = 16;
+  ChannelShard pc_channel_shards_[kChannelShardCount];
+  // Registration with the process-wide network change notifier, removed
+  // on destruction.
+  int network_change_callback_id_;
   std::string local_id_;
   std::vector<std::reference_wrapper<P2PClientObserver>> observers_;
+  // One event queue per registered observer, aligned with |observers_|,
+  // so a slow observer does not delay events for the other observers.
+  std::vector<std::shared_ptr<owt::base::ObserverEventQueue>>
+      observer_event_queues_;
   P2PClientConfiguration configuration_;
   mutable std::mutex remote_ids_mutex_;
   std::vector<std::string> allowed_remote_ids_;
+  // Same-host loopback state, guarded by |loopback_mutex_|. The sender
+  // side owns at most one offered segment; the receiver side holds the
+  // attached poller while a loopback session is up.
+  mutable std::mutex loopback_mutex_;
+  std::function<void(const uint8_t* data,
+                     size_t size,
+                     uint32_t rtp_timestamp,
+                     bool is_keyframe)>
+      loopback_listener_;
+  std::unique_ptr<owt::base::LocalLoopbackReceiver> loopback_receiver_;
+  std::string loopback_segment_;
+  std::string loopback_peer_id_;
 };
 }
 }
@@ -1,6 +1,7 @@
 // Copyright (C) <2018> Intel Corporation
 //
 // SPDX-License-Identifier: Apache-2.0
+#import <CoreVideo/CoreVideo.h>
 #import <Foundation/Foundation.h>
 #import <UIKit/UIKit.h>
 #import <WebRTC/RTCMacros.h>
@@ -53,5 +54,16 @@ RTC_EXPORT
  @brief frame rate, unit: fps
 */
 - (NSUInteger)frameRate;
+@optional
+/**
+ @brief Generate the next video frame as a CVPixelBuffer.
+ @details When a generator implements this method the SDK pulls frames
+ through it instead of nextFrame:capacity:, and the buffer travels to the
+ encoder by reference - an IOSurface-backed buffer is never copied.
+ Return a +1 (retained) reference; ownership transfers to the SDK, which
+ releases the buffer once the frame leaves the pipeline.
+ @return The next frame, or NULL to skip this capture cycle.
+*/
+- (nullable CVPixelBufferRef)nextPixelBuffer;
 @end
 NS_ASSUME_NONNULL_END
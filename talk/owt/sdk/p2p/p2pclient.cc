@@ -2,14 +2,26 @@
 //
 // SPDX-License-Identifier: Apache-2.0
 #include <algorithm>
+#include <cctype>
 #include <future>
+#if defined(WEBRTC_WIN)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
 #include "webrtc/rtc_base/third_party/base64/base64.h"
 #include "webrtc/rtc_base/checks.h"
 #include "webrtc/rtc_base/criticalsection.h"
 #include "webrtc/rtc_base/json.h"
 #include "webrtc/rtc_base/logging.h"
 #include "webrtc/rtc_base/task_queue.h"
+#include "webrtc/rtc_base/timeutils.h"
 #include "talk/owt/sdk/base/eventtrigger.h"
+#include "talk/owt/sdk/base/localloopback.h"
+#include "talk/owt/sdk/base/memoryaccounting.h"
+#include "talk/owt/sdk/base/queuedepthgauges.h"
+#include "talk/owt/sdk/base/threadloadmonitor.h"
+#include "talk/owt/sdk/base/networkchangenotifier.h"
 #include "talk/owt/sdk/base/stringutils.h"
 #include "talk/owt/sdk/include/cpp/owt/base/stream.h"
 #include "talk/owt/sdk/include/cpp/owt/p2p/p2pclient.h"
@@ -22,6 +34,33 @@ namespace p2p {
 enum IcsP2PError : int {
   kWebrtcIceGatheringPolicyUnsupported = 2601,
 };
+namespace {
+// The hostname travels in the loopback offer as a cheap pre-filter; a
+// receiver on another machine skips the negotiation without touching
+// shared memory. Opening the segment stays the authoritative check -
+// two containers can share a hostname without sharing /dev/shm.
+std::string LocalHostFingerprint() {
+  char hostname[256] = {0};
+#if defined(WEBRTC_WIN)
+  DWORD size = sizeof(hostname);
+  if (!GetComputerNameA(hostname, &size))
+    return "";
+#else
+  if (gethostname(hostname, sizeof(hostname) - 1) != 0)
+    return "";
+#endif
+  return hostname;
+}
+// Shared memory names cannot carry arbitrary user IDs; keep the
+// alphanumeric characters and replace the rest.
+std::string SanitizeSegmentToken(const std::string& raw) {
+  std::string token;
+  for (char c : raw) {
+    token.push_back(isalnum(static_cast<unsigned char>(c)) ? c : '_');
+  }
+  return token;
+}
+}  // namespace
 P2PClient::P2PClient(
     P2PClientConfiguration& configuration,
     std::shared_ptr<P2PSignalingChannelInterface> signaling_channel)
@@ -30,6 +69,28 @@ P2PClient::P2PClient(
       configuration_(configuration) {
   RTC_CHECK(signaling_channel_);
   signaling_channel_->AddObserver(*this);
+  // A NIC change would otherwise leave sessions black until ICE times
+  // out; restart every session as soon as the OS reports the change.
+  // IceRestart only posts to the channel threads, so the notifier's
+  // monitor thread is not blocked.
+  network_change_callback_id_ =
+      owt::base::NetworkChangeNotifier::Get()->AddCallback([this] {
+        RTC_LOG(LS_INFO)
+            << "Restart ICE for all P2P sessions on network change.";
+        for (int i = 0; i < kChannelShardCount; i++) {
+          std::lock_guard<std::mutex> lock(pc_channel_shards_[i].mutex);
+          for (auto& entry : pc_channel_shards_[i].channels) {
+            entry.second->IceRestart();
+          }
+        }
+      });
+}
+P2PClient::~P2PClient() {
+  StopLoopback();
+  // Blocks until an in-flight notification returns, so the callback can
+  // never observe a destroyed client.
+  owt::base::NetworkChangeNotifier::Get()->RemoveCallback(
+      network_change_callback_id_);
 }
 void P2PClient::Connect(
     const std::string& host,
@@ -116,6 +177,7 @@ void P2PClient::Publish(
     std::shared_ptr<P2PPublication> publication(new P2PPublication(that, target_id, stream));
     that->event_queue_->PostTask([on_success, publication] {on_success(publication); });
   }, on_failure);
+  MaybeOfferLoopback(target_id);
 }
 void P2PClient::Send(
     const std::string& target_id,
@@ -139,6 +201,29 @@ void P2PClient::Send(
   auto pcc = GetPeerConnectionChannel(target_id);
   pcc->Send(message, on_success, on_failure);
 }
+void P2PClient::Send(
+    const std::string& target_id,
+    std::shared_ptr<const std::string> data,
+    int max_retransmits,
+    std::function<void()> on_success,
+    std::function<void(std::unique_ptr<Exception>)> on_failure) {
+  // Firstly check whether target_id is in the allowed_remote_ids_ list.
+  if (std::find(allowed_remote_ids_.begin(), allowed_remote_ids_.end(),
+                target_id) == allowed_remote_ids_.end()) {
+    if (on_failure) {
+      event_queue_->PostTask([on_failure] {
+        std::unique_ptr<Exception> e(
+            new Exception(ExceptionType::kP2PClientRemoteNotAllowed,
+                          "Sending a message cannot be done since the remote user is not allowed."));
+        on_failure(std::move(e));
+      });
+    }
+    return;
+  }
+  // Secondly use pcc to send the binary payload.
+  auto pcc = GetPeerConnectionChannel(target_id);
+  pcc->Send(data, max_retransmits, on_success, on_failure);
+}
 void P2PClient::Stop(
     const std::string& target_id,
     std::function<void()> on_success,
@@ -156,7 +241,13 @@ void P2PClient::Stop(
   }
   auto pcc = GetPeerConnectionChannel(target_id);
   pcc->Stop(on_success, on_failure);
-  pc_channels_.erase(target_id);
+  ErasePeerConnectionChannel(target_id);
+  {
+    std::lock_guard<std::mutex> lock(loopback_mutex_);
+    if (target_id != loopback_peer_id_)
+      return;
+  }
+  StopLoopback();
 }
 void P2PClient::GetConnectionStats(
     const std::string& target_id,
@@ -176,9 +267,128 @@ void P2PClient::GetConnectionStats(
   auto pcc = GetPeerConnectionChannel(target_id);
   pcc->GetConnectionStats(on_success, on_failure);
 }
+std::vector<owt::base::MemoryStatsEntry> P2PClient::GetMemoryStats() {
+  return owt::base::MemoryAccounting::Snapshot();
+}
+std::vector<owt::base::QueueDepthEntry> P2PClient::GetQueueDepthStats() {
+  return owt::base::QueueDepthGauges::Snapshot();
+}
+std::vector<owt::base::ThreadLoadEntry> P2PClient::GetThreadLoadStats() {
+  return owt::base::ThreadLoadMonitor::Snapshot();
+}
 void P2PClient::SetLocalId(const std::string& local_id) {
   local_id_ = local_id;
 }
+void P2PClient::SetLoopbackFrameListener(
+    std::function<void(const uint8_t* data,
+                       size_t size,
+                       uint32_t rtp_timestamp,
+                       bool is_keyframe)> listener) {
+  std::unique_ptr<owt::base::LocalLoopbackReceiver> detached;
+  {
+    std::lock_guard<std::mutex> lock(loopback_mutex_);
+    loopback_listener_ = listener;
+    if (!listener)
+      detached = std::move(loopback_receiver_);
+  }
+  // The poll thread joins outside the lock; its callback never takes it.
+  detached.reset();
+}
+void P2PClient::MaybeOfferLoopback(const std::string& target_id) {
+  if (!configuration_.allow_same_host_loopback)
+    return;
+  std::string segment = "owt-loop-" + SanitizeSegmentToken(local_id_) + "-" +
+                        std::to_string(rtc::TimeMillis());
+  {
+    std::lock_guard<std::mutex> lock(loopback_mutex_);
+    if (!loopback_segment_.empty()) {
+      // One loopback session per client; a second publication keeps the
+      // normal path.
+      return;
+    }
+    loopback_segment_ = segment;
+    loopback_peer_id_ = target_id;
+  }
+  // The segment must exist before the offer goes out, because opening it
+  // is the remote side's same-machine check. Frames mirrored before a
+  // reader attaches fill the ring and are dropped, which is harmless.
+  if (!owt::base::LocalLoopbackSender::Start(segment)) {
+    std::lock_guard<std::mutex> lock(loopback_mutex_);
+    loopback_segment_.clear();
+    loopback_peer_id_.clear();
+    return;
+  }
+  Json::Value json;
+  json["type"] = "shm-loopback-offer";
+  Json::Value data;
+  data["host"] = LocalHostFingerprint();
+  data["segment"] = segment;
+  json["data"] = data;
+  SendSignalingMessage(rtc::JsonValueToString(json), target_id, nullptr,
+                       nullptr);
+}
+bool P2PClient::HandleLoopbackMessage(const std::string& message,
+                                      const std::string& remote_id) {
+  if (message.find("\"shm-loopback-") == std::string::npos)
+    return false;
+  Json::Reader reader;
+  Json::Value json_message;
+  std::string type;
+  if (!reader.parse(message, json_message) ||
+      !rtc::GetStringFromJsonObject(json_message, "type", &type) ||
+      type.compare(0, 13, "shm-loopback-") != 0) {
+    return false;
+  }
+  if (type == "shm-loopback-offer") {
+    Json::Value data;
+    std::string host;
+    std::string segment;
+    rtc::GetValueFromJsonObject(json_message, "data", &data);
+    rtc::GetStringFromJsonObject(data, "host", &host);
+    rtc::GetStringFromJsonObject(data, "segment", &segment);
+    std::lock_guard<std::mutex> lock(loopback_mutex_);
+    if (!loopback_listener_ || segment.empty() ||
+        host != LocalHostFingerprint() || loopback_receiver_) {
+      return true;
+    }
+    std::unique_ptr<owt::base::LocalLoopbackReceiver> receiver(
+        new owt::base::LocalLoopbackReceiver());
+    if (!receiver->Start(segment, loopback_listener_)) {
+      // The segment does not exist here: same hostname, different
+      // machine. Fall back to the regular stream silently.
+      return true;
+    }
+    loopback_receiver_ = std::move(receiver);
+    loopback_peer_id_ = remote_id;
+    Json::Value reply;
+    reply["type"] = "shm-loopback-accept";
+    Json::Value reply_data;
+    reply_data["segment"] = segment;
+    reply["data"] = reply_data;
+    SendSignalingMessage(rtc::JsonValueToString(reply), remote_id, nullptr,
+                         nullptr);
+  } else if (type == "shm-loopback-accept") {
+    RTC_LOG(LS_INFO) << "Remote side " << remote_id
+                     << " attached to the loopback segment.";
+  } else if (type == "shm-loopback-stop") {
+    StopLoopback();
+  }
+  return true;
+}
+void P2PClient::StopLoopback() {
+  std::unique_ptr<owt::base::LocalLoopbackReceiver> detached;
+  std::string segment;
+  {
+    std::lock_guard<std::mutex> lock(loopback_mutex_);
+    detached = std::move(loopback_receiver_);
+    segment = loopback_segment_;
+    loopback_segment_.clear();
+    loopback_peer_id_.clear();
+  }
+  detached.reset();
+  if (!segment.empty())
+    owt::base::LocalLoopbackSender::Stop();
+}
 void P2PClient::OnSignalingMessage(const std::string& message,
                                    const std::string& remote_id) {
   // First to check whether remote_id is in the allowed_remote_ids_ list.
@@ -187,6 +397,10 @@ void P2PClient::OnSignalingMessage(const std::string& message,
     RTC_LOG(LS_WARNING) << "Chat cannot be setup since the remote user is not allowed.";
     return;
   }
+  // Loopback negotiation rides the same signaling channel but is handled
+  // here; the peer connection channel never sees these messages.
+  if (HandleLoopbackMessage(message, remote_id))
+    return;
   if (!IsPeerConnectionChannelCreated(remote_id)) {
     if (message.find("\"type\":\"chat-closed\"") != std::string::npos) {
       RTC_LOG(LS_WARNING) << "Non-existed chat cannot be stopped.";
@@ -201,7 +415,7 @@ void P2PClient::OnSignalingMessage(const std::string& message,
           pcc->GetLatestPublishSuccessCallback();
       std::function<void(std::unique_ptr<Exception>)> failure_callback =
           pcc->GetLatestPublishFailureCallback();
-      pc_channels_.erase(remote_id);
+      ErasePeerConnectionChannel(remote_id);
 	    auto new_pcc = GetPeerConnectionChannel(remote_id);
 	    new_pcc->OnIncomingSignalingMessage(message);
 	    new_pcc->Publish(stream, success_callback, failure_callback);
@@ -224,7 +438,7 @@ void P2PClient::OnSignalingMessage(const std::string& message,
             pcc->GetLatestPublishSuccessCallback();
         std::function<void(std::unique_ptr<Exception>)> failure_callback =
             pcc->GetLatestPublishFailureCallback();
-        pc_channels_.erase(remote_id);
+        ErasePeerConnectionChannel(remote_id);
         auto new_pcc = GetPeerConnectionChannel(remote_id);
         new_pcc->Publish(stream, success_callback, failure_callback);
         return;
@@ -236,8 +450,8 @@ void P2PClient::OnSignalingMessage(const std::string& message,
   pcc->OnIncomingSignalingMessage(message);
 }
 void P2PClient::OnServerDisconnected() {
-  EventTrigger::OnEvent0(observers_, event_queue_,
-                         &P2PClientObserver::OnServerDisconnected);
+  EventTrigger::OnEvent(observers_, observer_event_queues_,
+                        &P2PClientObserver::OnServerDisconnected);
 }
 void P2PClient::SendSignalingMessage(const std::string& message,
                                      const std::string& remote_id,
@@ -247,13 +461,20 @@ void P2PClient::SendSignalingMessage(const std::string& message,
 }
 void P2PClient::AddObserver(P2PClientObserver& observer) {
   observers_.push_back(observer);
+  observer_event_queues_.push_back(
+      std::make_shared<ObserverEventQueue>("P2PClientObserverQueue"));
 }
 void P2PClient::RemoveObserver(P2PClientObserver& observer) {
-  observers_.erase(std::find_if(
+  auto it = std::find_if(
       observers_.begin(), observers_.end(),
       [&](std::reference_wrapper<P2PClientObserver> o) -> bool {
         return &observer == &(o.get());
-      }));
+      });
+  if (it != observers_.end()) {
+    observer_event_queues_.erase(observer_event_queues_.begin() +
+                                 (it - observers_.begin()));
+    observers_.erase(it);
+  }
 }
 void P2PClient::Unpublish(
     const std::string& target_id,
@@ -275,20 +496,36 @@ void P2PClient::Unpublish(
   pcc->Unpublish(stream, on_success, on_failure);
 }
 bool P2PClient::IsPeerConnectionChannelCreated(const std::string& target_id) {
-  if (pc_channels_.find(target_id) == pc_channels_.end())
+  ChannelShard& shard = ChannelShardFor(target_id);
+  const std::lock_guard<std::mutex> lock(shard.mutex);
+  if (shard.channels.find(target_id) == shard.channels.end())
     return false;
   return true;
 }
+P2PClient::ChannelShard& P2PClient::ChannelShardFor(
+    const std::string& target_id) {
+  return pc_channel_shards_[std::hash<std::string>()(target_id) %
+                            kChannelShardCount];
+}
+void P2PClient::ErasePeerConnectionChannel(const std::string& target_id) {
+  ChannelShard& shard = ChannelShardFor(target_id);
+  const std::lock_guard<std::mutex> lock(shard.mutex);
+  shard.channels.erase(target_id);
+}
 std::shared_ptr<P2PPeerConnectionChannel> P2PClient::GetPeerConnectionChannel(
     const std::string& target_id) {
-  auto pcc_it = pc_channels_.find(target_id);
+  // Only the shard owning |target_id| is locked, so channels for other
+  // peers can be looked up and constructed concurrently.
+  ChannelShard& shard = ChannelShardFor(target_id);
+  const std::lock_guard<std::mutex> lock(shard.mutex);
+  auto pcc_it = shard.channels.find(target_id);
   // if the channel has already been abandoned
-  if (pcc_it != pc_channels_.end() && pcc_it->second->IsAbandoned()) {
-    pc_channels_.erase(target_id);
-    pcc_it = pc_channels_.end();
+  if (pcc_it != shard.channels.end() && pcc_it->second->IsAbandoned()) {
+    shard.channels.erase(pcc_it);
+    pcc_it = shard.channels.end();
   }
   // Create new channel if it doesn't exist.
-  if (pcc_it == pc_channels_.end()) {
+  if (pcc_it == shard.channels.end()) {
     PeerConnectionChannelConfiguration config =
         GetPeerConnectionChannelConfiguration();
     P2PSignalingSenderInterface* signaling_sender =
@@ -299,10 +536,7 @@ std::shared_ptr<P2PPeerConnectionChannel> P2PClient::GetPeerConnectionChannel(
     P2PPeerConnectionChannelObserverCppImpl* pcc_observer =
         new P2PPeerConnectionChannelObserverCppImpl(*this);
     pcc->AddObserver(pcc_observer);
-    auto pcc_pair =
-        std::pair<std::string, std::shared_ptr<P2PPeerConnectionChannel>>(
-            target_id, pcc);
-    pc_channels_.insert(pcc_pair);
+    shard.channels[target_id] = pcc;
     return pcc;
   } else {
     return pcc_it->second;
@@ -326,6 +560,9 @@ PeerConnectionChannelConfiguration P2PClient::GetPeerConnectionChannelConfigurat
                 kCandidateNetworkPolicyLowCost
           : webrtc::PeerConnectionInterface::CandidateNetworkPolicy::
                 kCandidateNetworkPolicyAll;
+  // Pre-gathered allocations let the first offer go out with candidates
+  // already in hand; see ClientConfiguration::ice_candidate_pool_size.
+  config.ice_candidate_pool_size = configuration_.ice_candidate_pool_size;
   for (auto codec : configuration_.video_encodings) {
     config.video.push_back(VideoEncodingParameters(codec));
   }
@@ -340,13 +577,19 @@ PeerConnectionChannelConfiguration P2PClient::GetPeerConnectionChannelConfigurat
 }
 void P2PClient::OnMessageReceived(const std::string& remote_id,
                                   const std::string& message) {
-  EventTrigger::OnEvent2(observers_, event_queue_,
-                         &P2PClientObserver::OnMessageReceived,
-                         remote_id, message);
+  EventTrigger::OnEvent(observers_, observer_event_queues_,
+                        &P2PClientObserver::OnMessageReceived, remote_id,
+                        message);
+}
+void P2PClient::OnBinaryMessageReceived(const std::string& remote_id,
+                                        const std::string& message) {
+  EventTrigger::OnEvent(observers_, observer_event_queues_,
+                        &P2PClientObserver::OnBinaryMessageReceived, remote_id,
+                        message);
 }
 void P2PClient::OnStreamAdded(std::shared_ptr<RemoteStream> stream) {
-  EventTrigger::OnEvent1(
-      observers_, event_queue_,
+  EventTrigger::OnEvent(
+      observers_, observer_event_queues_,
       (void (P2PClientObserver::*)(std::shared_ptr<RemoteStream>))(
           &P2PClientObserver::OnStreamAdded),
       stream);
@@ -1,13 +1,16 @@
 // Copyright (C) <2018> Intel Corporation
 //
 // SPDX-License-Identifier: Apache-2.0
+#include <algorithm>
 #include <thread>
 #include <vector>
+#include "talk/owt/sdk/base/eventjournal.h"
 #include "talk/owt/sdk/base/eventtrigger.h"
 #include "talk/owt/sdk/base/functionalobserver.h"
 #include "talk/owt/sdk/base/sysinfo.h"
 #include "talk/owt/sdk/p2p/p2ppeerconnectionchannel.h"
 #include "webrtc/rtc_base/logging.h"
+#include "webrtc/rtc_base/timeutils.h"
 using namespace rtc;
 namespace owt {
 namespace p2p {
@@ -47,6 +50,8 @@ const string kStreamSourceKey = "source";
 // Session description member key
 const string kSessionDescriptionTypeKey = "type";
 const string kSessionDescriptionSdpKey = "sdp";
+// Candidates bundled with a session description.
+const string kSessionDescriptionCandidatesKey = "candidates";
 // ICE candidate member key
 const string kIceCandidateSdpNameKey = "candidate";
 const string kIceCandidateSdpMidKey = "sdpMid";
@@ -69,17 +74,122 @@ const string kUaCapabilitiesKey = "capabilities";
 const string kUaContinualGatheringKey = "continualIceGathering";
 const string kUaUnifiedPlanKey = "unifiedPlan";
 const string kUaStreamRemovableKey = "streamRemovable";
+const string kUaBundledCandidatesKey = "bundledCandidates";
 // Text message sent through data channel
 const string kDataChannelLabelForTextMessage = "message";
+const string kDataChannelLabelForBinaryMessage = "data";
+// Pending text messages at most this large count as control traffic and
+// drain ahead of bulk payloads.
+const size_t kControlMessageMaxSize = 1024;
+// For every batch of control messages drained, one bulk message is
+// interleaved so bulk transfer is not starved.
+const size_t kControlDrainBurst = 4;
+// Further sends fail with a backpressure error once this many text
+// messages are waiting for the channel.
+const size_t kPendingMessageHighWater = 256;
+// Extracts a top-level string member from |json| without building a
+// DOM. Only used on flat objects (no nesting), where a key cannot occur
+// at a deeper level; returns false on escapes or anything unusual so
+// the caller falls back to the full parser.
+static bool FindTopLevelStringValue(const std::string& json,
+                                    const std::string& key,
+                                    std::string* value) {
+  std::string needle = "\"" + key + "\"";
+  size_t pos = json.find(needle);
+  if (pos == std::string::npos)
+    return false;
+  pos = json.find_first_not_of(" \t\r\n", pos + needle.size());
+  if (pos == std::string::npos || json[pos] != ':')
+    return false;
+  pos = json.find_first_not_of(" \t\r\n", pos + 1);
+  if (pos == std::string::npos || json[pos] != '"')
+    return false;
+  size_t end = pos + 1;
+  while (end < json.size() && json[end] != '"') {
+    if (json[end] == '\\')
+      return false;
+    end++;
+  }
+  if (end >= json.size())
+    return false;
+  value->assign(json, pos + 1, end - pos - 1);
+  return true;
+}
+// True if |json| is a flat object: no nested objects or arrays.
+static bool IsFlatJsonObject(const std::string& json) {
+  if (json.empty() || json[0] != '{')
+    return false;
+  return json.find('{', 1) == std::string::npos &&
+         json.find('[') == std::string::npos;
+}
+// Binary sends are queued once a channel buffers more than this.
+const uint64_t kMaxDataChannelBufferedAmount = 16 * 1024 * 1024;
+// Returns true for labels of binary channels, including the partially
+// reliable variants.
+static bool IsBinaryChannelLabel(const std::string& label) {
+  return label.compare(0, kDataChannelLabelForBinaryMessage.size(),
+                       kDataChannelLabelForBinaryMessage) == 0;
+}
+// Each reliability setting gets its own SCTP channel; the retransmit
+// limit is encoded in the label so both sides derive the same setup.
+static std::string BinaryChannelLabel(int max_retransmits) {
+  if (max_retransmits < 0) {
+    return kDataChannelLabelForBinaryMessage;
+  }
+  return kDataChannelLabelForBinaryMessage + "-r" +
+         std::to_string(max_retransmits);
+}
+static int MaxRetransmitsFromLabel(const std::string& label) {
+  auto pos = label.find("-r");
+  if (!IsBinaryChannelLabel(label) || pos == std::string::npos) {
+    return -1;
+  }
+  try {
+    return std::stoi(label.substr(pos + 2));
+  } catch (const std::exception&) {
+    return -1;
+  }
+}
+// FNV-1a over the fields identifying a remote candidate, the same
+// fingerprint scheme the SDP codec-selection cache uses. Deduplication
+// compares these 64-bit values instead of composed key strings, so a
+// resend storm costs neither an allocation nor a candidate parse.
+static uint64_t CandidateFingerprint(const std::string& sdp_mid,
+                                     int sdp_mline_index,
+                                     const std::string& candidate) {
+  const uint64_t kFnvOffset = 1469598103934665603ull;
+  const uint64_t kFnvPrime = 1099511628211ull;
+  uint64_t hash = kFnvOffset;
+  for (char c : sdp_mid) {
+    hash = (hash ^ static_cast<uint8_t>(c)) * kFnvPrime;
+  }
+  // Separator so adjacent fields cannot shift into each other.
+  hash = (hash ^ 0xff) * kFnvPrime;
+  hash = (hash ^ static_cast<uint64_t>(sdp_mline_index)) * kFnvPrime;
+  for (char c : candidate) {
+    hash = (hash ^ static_cast<uint8_t>(c)) * kFnvPrime;
+  }
+  return hash;
+}
 const string kTextMessageDataKey = "data";
 const string kTextMessageIdKey = "id";
+// Message ID for flushing a held local description; not part of the
+// MessageType enum shared with the conference channel.
+const int kMessageTypeFlushBundledSignal = 301;
+// A held local description is sent after this timeout even if ICE
+// gathering has not completed; remaining candidates are trickled.
+const int kCandidateBundleTimeoutMs = 500;
+// Message ID for the end of the negotiation coalescing window.
+const int kMessageTypeNegotiationWindowClosed = 302;
+// Negotiation-needed events within this window collapse into one offer.
+const int kNegotiationCoalesceWindowMs = 50;
 P2PPeerConnectionChannel::P2PPeerConnectionChannel(
     PeerConnectionChannelConfiguration configuration,
     const std::string& local_id,
     const std::string& remote_id,
     P2PSignalingSenderInterface* sender,
     std::shared_ptr<rtc::TaskQueue> event_queue)
-    : PeerConnectionChannel(configuration),
+    : PeerConnectionChannel(std::move(configuration)),
       signaling_sender_(sender),
       local_id_(local_id),
       remote_id_(remote_id),
@@ -94,7 +204,11 @@ P2PPeerConnectionChannel::P2PPeerConnectionChannel(
       remote_side_supports_remove_stream_(false),
       remote_side_supports_unified_plan_(true),
       is_creating_offer_(false),
+      negotiation_scheduled_(false),
       remote_side_supports_continual_ice_gathering_(true),
+      remote_side_supports_bundled_candidates_(false),
+      has_pending_local_sdp_(false),
+      remote_description_applied_(false),
       event_queue_(event_queue),
       ua_sent_(false),
       stop_send_needed_(true),
@@ -118,6 +232,12 @@ P2PPeerConnectionChannel::P2PPeerConnectionChannel(
 P2PPeerConnectionChannel::~P2PPeerConnectionChannel() {
   if (set_remote_sdp_task_)
     delete set_remote_sdp_task_;
+  {
+    std::lock_guard<std::mutex> lock(remote_candidates_mutex_);
+    for (webrtc::IceCandidateInterface* candidate : staged_remote_candidates_)
+      delete candidate;
+    staged_remote_candidates_.clear();
+  }
   if (signaling_sender_)
     delete signaling_sender_;
   ended_ = true;
@@ -225,9 +345,28 @@ void P2PPeerConnectionChannel::Send(
   } else {
     {
       std::lock_guard<std::mutex> lock(pending_messages_mutex_);
+      if (pending_control_messages_.size() + pending_bulk_messages_.size() >=
+          kPendingMessageHighWater) {
+        // Backpressure: tell the caller instead of growing the backlog
+        // without bound.
+        RTC_LOG(LS_WARNING) << "Pending message queue is full.";
+        if (on_failure) {
+          event_queue_->PostTask([on_failure] {
+            std::unique_ptr<Exception> e(new Exception(
+                ExceptionType::kP2PClientInvalidState,
+                "Too many messages are waiting for the data channel."));
+            on_failure(std::move(e));
+          });
+        }
+        return;
+      }
       std::shared_ptr<std::string> data_copy(
           std::make_shared<std::string>(data));
-      pending_messages_.push_back(data_copy);
+      if (data_copy->size() <= kControlMessageMaxSize) {
+        pending_control_messages_.push_back(data_copy);
+      } else {
+        pending_bulk_messages_.push_back(data_copy);
+      }
     }
     if (data_channel_ == nullptr) // Otherwise, wait for data channel ready.
       CreateDataChannel(kDataChannelLabelForTextMessage);
@@ -240,9 +379,112 @@ void P2PPeerConnectionChannel::Send(
     failure_callbacks_[id_value] = on_failure;
   }
 }
+void P2PPeerConnectionChannel::Send(
+    std::shared_ptr<const std::string> data,
+    int max_retransmits,
+    std::function<void()> on_success,
+    std::function<void(std::unique_ptr<Exception>)> on_failure) {
+  if (stop_send_needed_) {
+    SendStop(nullptr, nullptr);
+    stop_send_needed_ = false;
+  }
+  if (!ua_sent_) {
+    SendUaInfo();
+    ua_sent_ = true;
+  }
+  if (data == nullptr || data->empty()) {
+    if (on_failure) {
+      event_queue_->PostTask([on_failure] {
+        std::unique_ptr<Exception> e(
+            new Exception(ExceptionType::kP2PClientInvalidArgument,
+                          "Binary message is empty."));
+        on_failure(std::move(e));
+      });
+    }
+    return;
+  }
+  std::string label = BinaryChannelLabel(max_retransmits);
+  bool create_channel = false;
+  {
+    std::lock_guard<std::mutex> lock(pending_messages_mutex_);
+    auto it = binary_data_channels_.find(label);
+    if (it != binary_data_channels_.end() &&
+        it->second->state() ==
+            webrtc::DataChannelInterface::DataState::kOpen &&
+        pending_binary_messages_.empty() &&
+        it->second->buffered_amount() + data->size() <=
+            kMaxDataChannelBufferedAmount) {
+      // The channel can take the payload right away; the shared buffer
+      // is handed to the channel without an intermediate copy.
+      it->second->Send(webrtc::DataBuffer(
+          rtc::CopyOnWriteBuffer(data->data(), data->size()), true));
+      if (on_success) {
+        event_queue_->PostTask([on_success] { on_success(); });
+      }
+      return;
+    }
+    create_channel = (it == binary_data_channels_.end());
+    PendingBinaryMessage pending;
+    pending.label = label;
+    pending.data = data;
+    pending.on_success = on_success;
+    pending_binary_messages_.push_back(pending);
+  }
+  if (create_channel) {
+    CreateDataChannel(label);
+  }
+}
+namespace {
+// Explicit session transition table. Transitions not listed here are
+// contradictory - most importantly matching a session that is already
+// negotiating or connected, which is how glare used to corrupt state -
+// and are rejected instead of applied last-writer-wins.
+bool SessionTransitionAllowed(int from, int to) {
+  switch (to) {
+    case P2PPeerConnectionChannel::kSessionStateReady:
+      // Stop and close reset the session from any state.
+      return true;
+    case P2PPeerConnectionChannel::kSessionStateOffered:
+    case P2PPeerConnectionChannel::kSessionStatePending:
+      return from == P2PPeerConnectionChannel::kSessionStateReady;
+    case P2PPeerConnectionChannel::kSessionStateMatched:
+      return from == P2PPeerConnectionChannel::kSessionStateReady ||
+             from == P2PPeerConnectionChannel::kSessionStateOffered ||
+             from == P2PPeerConnectionChannel::kSessionStatePending;
+    case P2PPeerConnectionChannel::kSessionStateConnecting:
+      // Entered when negotiation starts, including renegotiation of a
+      // connected session and pending-stream drains before matching.
+      return true;
+    case P2PPeerConnectionChannel::kSessionStateConnected:
+      // ICE state is ground truth; accept it from anywhere.
+      return true;
+    default:
+      return false;
+  }
+}
+}  // namespace
 void P2PPeerConnectionChannel::ChangeSessionState(SessionState state) {
+  // Wait-free transition: a compare-and-swap against the transition
+  // table means concurrent transitions - re-entrant callbacks, glare
+  // between a local and a remote offer - resolve to exactly one winner,
+  // with no lock to deadlock on.
+  int current = session_state_.load(std::memory_order_acquire);
+  while (true) {
+    if (current == state)
+      return;
+    if (!SessionTransitionAllowed(current, state)) {
+      RTC_LOG(LS_WARNING) << "Rejecting session state transition " << current
+                          << " -> " << state << ".";
+      return;
+    }
+    if (session_state_.compare_exchange_weak(current, state,
+                                             std::memory_order_acq_rel,
+                                             std::memory_order_acquire))
+      break;
+  }
   RTC_LOG(LS_INFO) << "PeerConnectionChannel change session state : " << state;
-  session_state_ = state;
+  EventJournal::Append(EventJournal::kSessionStateChange, state,
+                       remote_id_.c_str());
 }
 void P2PPeerConnectionChannel::AddObserver(
     P2PPeerConnectionChannelObserver* observer) {
@@ -253,6 +495,18 @@ void P2PPeerConnectionChannel::RemoveObserver(
   observers_.erase(std::remove(observers_.begin(), observers_.end(), observer),
                    observers_.end());
 }
+void P2PPeerConnectionChannel::IceRestart() {
+  RTC_LOG(LS_INFO) << "ICE restart";
+  media_constraints_.SetMandatory(
+      webrtc::MediaConstraintsInterface::kIceRestart, true);
+  if (SignalingState() == PeerConnectionInterface::SignalingState::kStable) {
+    CreateOffer();
+  } else {
+    // Picked up by the stable-state transition like any pending
+    // renegotiation.
+    negotiation_needed_ = true;
+  }
+}
 void P2PPeerConnectionChannel::CreateOffer() {
   {
     std::lock_guard<std::mutex> lock(is_creating_offer_mutex_);
@@ -338,6 +592,25 @@ void P2PPeerConnectionChannel::OnIncomingSignalingMessage(
     return;
   RTC_LOG(LS_INFO) << "OnIncomingMessage: " << message;
   RTC_DCHECK(!message.empty());
+  // Fast path for the flat high-frequency messages (per-message acks and
+  // stop): read the fields in place instead of building a DOM. Anything
+  // unexpected falls through to the full parser below.
+  if (IsFlatJsonObject(message)) {
+    std::string flat_type;
+    if (FindTopLevelStringValue(message, kMessageTypeKey, &flat_type)) {
+      if (flat_type == kChatDataReceived) {
+        std::string id;
+        if (FindTopLevelStringValue(message, kMessageDataKey, &id)) {
+          OnMessageDataReceived(id);
+          return;
+        }
+      } else if (flat_type == kChatClosed &&
+                 message.find(kMessageDataKey) == std::string::npos) {
+        OnMessageStop();
+        return;
+      }
+    }
+  }
   Json::Reader reader;
   Json::Value json_message;
   if (!reader.parse(message, json_message)) {
@@ -357,24 +630,21 @@ void P2PPeerConnectionChannel::OnIncomingSignalingMessage(
       ua_sent_ = true;
       stop_send_needed_ = false;
     }
-    Json::Value ua;
-    rtc::GetValueFromJsonObject(json_message, kMessageDataKey, &ua);
+    // Access the data subtree in place; GetValueFromJsonObject would
+    // deep-copy it for every message.
+    Json::Value& ua = json_message[kMessageDataKey];
     OnMessageUserAgent(ua);
   } else if (message_type == kChatTrackSources) {
-    Json::Value track_sources;
-    rtc::GetValueFromJsonObject(json_message, kMessageDataKey, &track_sources);
+    Json::Value& track_sources = json_message[kMessageDataKey];
     OnMessageTrackSources(track_sources);
   } else if (message_type == kChatStreamInfo) {
-    Json::Value stream_info;
-    rtc::GetValueFromJsonObject(json_message, kMessageDataKey, &stream_info);
+    Json::Value& stream_info = json_message[kMessageDataKey];
     OnMessageStreamInfo(stream_info);
   } else if (message_type == kChatSignal) {
-    Json::Value signal;
-    rtc::GetValueFromJsonObject(json_message, kMessageDataKey, &signal);
+    Json::Value& signal = json_message[kMessageDataKey];
     OnMessageSignal(signal);
   } else if (message_type == kChatTracksAdded) {
-    Json::Value tracks;
-    rtc::GetValueFromJsonObject(json_message, kMessageDataKey, &tracks);
+    Json::Value& tracks = json_message[kMessageDataKey];
     OnMessageTracksAdded(tracks);
   } else if (message_type == kChatDataReceived) {
     std::string id;
@@ -467,6 +737,17 @@ void P2PPeerConnectionChannel::OnMessageSignal(Json::Value& message) {
       RTC_LOG(LS_INFO) << "Post set remote desc";
       pc_thread_->Post(RTC_FROM_HERE, this, kMessageTypeSetRemoteDescription, msg);
     }
+    // A bundled message also carries the candidates the remote side
+    // gathered before sending its description.
+    Json::Value bundled_candidates;
+    if (rtc::GetValueFromJsonObject(message, kSessionDescriptionCandidatesKey,
+                                    &bundled_candidates) &&
+        bundled_candidates.isArray()) {
+      for (Json::Value::ArrayIndex idx = 0; idx != bundled_candidates.size();
+           idx++) {
+        OnMessageSignal(bundled_candidates[idx]);
+      }
+    }
   } else if (type == "candidates") {
     string sdp_mid;
     string candidate;
@@ -475,12 +756,54 @@ void P2PPeerConnectionChannel::OnMessageSignal(Json::Value& message) {
     rtc::GetStringFromJsonObject(message, kIceCandidateSdpNameKey, &candidate);
     rtc::GetIntFromJsonObject(message, kIceCandidateSdpMLineIndexKey,
                               &sdp_mline_index);
+    // Deduplication runs first, on a fingerprint computed in place over
+    // the parsed fields: TURN-heavy remote sides commonly resend
+    // candidates across reconnect attempts, and a repeat is rejected
+    // before a key string or candidate object is ever built. A
+    // fingerprint is recorded even for candidates that then turn out
+    // malformed, so their resends are dropped just as cheaply.
+    uint64_t fingerprint =
+        CandidateFingerprint(sdp_mid, sdp_mline_index, candidate);
+    {
+      std::lock_guard<std::mutex> lock(remote_candidates_mutex_);
+      if (std::find(seen_remote_candidates_.begin(),
+                    seen_remote_candidates_.end(),
+                    fingerprint) != seen_remote_candidates_.end()) {
+        return;
+      }
+      seen_remote_candidates_.push_back(fingerprint);
+    }
+    // Only novel candidates reach the engine's parser; validation still
+    // happens on the signaling thread so a malformed candidate never
+    // costs a connection-thread hop.
     webrtc::IceCandidateInterface* ice_candidate = webrtc::CreateIceCandidate(
         sdp_mid, sdp_mline_index, candidate, nullptr);
-    rtc::TypedMessageData<webrtc::IceCandidateInterface*>* param =
-        new rtc::TypedMessageData<webrtc::IceCandidateInterface*>(
-            ice_candidate);
-    pc_thread_->Post(RTC_FROM_HERE, this, kMessageTypeSetRemoteIceCandidate, param);
+    if (ice_candidate == nullptr) {
+      RTC_LOG(LS_WARNING) << "Discarding malformed remote candidate.";
+      return;
+    }
+    bool apply_now = false;
+    {
+      std::lock_guard<std::mutex> lock(remote_candidates_mutex_);
+      if (!remote_description_applied_) {
+        // The connection rejects candidates until the remote description
+        // is in place, so candidates racing the description used to be
+        // lost. Stage them; OnSetRemoteSessionDescriptionSuccess applies
+        // the whole set in one batch.
+        staged_remote_candidates_.push_back(ice_candidate);
+        staged_candidate_arrival_ms_.push_back(rtc::TimeMillis());
+      } else {
+        apply_now = true;
+      }
+    }
+    if (apply_now) {
+      std::vector<webrtc::IceCandidateInterface*>* batch =
+          new std::vector<webrtc::IceCandidateInterface*>(1, ice_candidate);
+      pc_thread_->Post(
+          RTC_FROM_HERE, this, kMessageTypeBatchSetRemoteIceCandidates,
+          new rtc::TypedMessageData<
+              std::vector<webrtc::IceCandidateInterface*>*>(batch));
+    }
   }
 }
 void P2PPeerConnectionChannel::OnMessageTracksAdded(
@@ -584,13 +907,12 @@ void P2PPeerConnectionChannel::OnAddStream(
   }
   std::shared_ptr<RemoteStream> remote_stream(
       new RemoteStream(stream, remote_id_));
-  EventTrigger::OnEvent1<P2PPeerConnectionChannelObserver*,
-                         std::allocator<P2PPeerConnectionChannelObserver*>,
-                         void (owt::p2p::P2PPeerConnectionChannelObserver::*)(
-                             std::shared_ptr<RemoteStream>),
-                         std::shared_ptr<RemoteStream>>(
+  EventTrigger::OnEvent(
       observers_, event_queue_,
-      &P2PPeerConnectionChannelObserver::OnStreamAdded, remote_stream);
+      (void (P2PPeerConnectionChannelObserver::*)(
+          std::shared_ptr<RemoteStream>))(
+          &P2PPeerConnectionChannelObserver::OnStreamAdded),
+      remote_stream);
   remote_streams_[stream->id()] = remote_stream;
   // Send the ack for the newly added stream tracks.
   Json::Value json_tracks;
@@ -616,10 +938,18 @@ void P2PPeerConnectionChannel::OnRemoveStream(
 }
 void P2PPeerConnectionChannel::OnDataChannel(
     rtc::scoped_refptr<webrtc::DataChannelInterface> data_channel) {
+  // Binary channels carry bulk data and are kept in a map keyed by
+  // label; the text channel keeps the single-channel behavior.
+  if (IsBinaryChannelLabel(data_channel->label())) {
+    {
+      std::lock_guard<std::mutex> lock(pending_messages_mutex_);
+      binary_data_channels_[data_channel->label()] = data_channel;
+    }
+    data_channel->RegisterObserver(this);
+    DrainPendingBinaryMessages();
+    return;
+  }
   // If a new data channel is create, delete the old one to save resource.
-  // Currently only one data channel for one connection. If we are going to
-  // support multiple data channels(one for text, one for large files), replace
-  // |data_channel_| with a map.
   if (data_channel_)
     data_channel_ = nullptr;
   data_channel_ = data_channel;
@@ -631,7 +961,19 @@ void P2PPeerConnectionChannel::OnNegotiationNeeded() {
     return;
   RTC_LOG(LS_INFO) << "On negotiation needed.";
   if (SignalingState() == PeerConnectionInterface::SignalingState::kStable) {
-    CreateOffer();
+    // Track changes often arrive in bursts; collapse the events within
+    // the coalescing window into one offer. The pending stream lists and
+    // |negotiation_needed_| keep the changes, so none is lost by
+    // waiting.
+    {
+      std::lock_guard<std::mutex> lock(negotiation_schedule_mutex_);
+      if (negotiation_scheduled_) {
+        return;
+      }
+      negotiation_scheduled_ = true;
+    }
+    pc_thread_->PostDelayed(RTC_FROM_HERE, kNegotiationCoalesceWindowMs, this,
+                            kMessageTypeNegotiationWindowClosed);
   } else {
     negotiation_needed_ = true;
   }
@@ -639,6 +981,8 @@ void P2PPeerConnectionChannel::OnNegotiationNeeded() {
 void P2PPeerConnectionChannel::OnIceConnectionChange(
     PeerConnectionInterface::IceConnectionState new_state) {
   RTC_LOG(LS_INFO) << "Ice connection state changed: " << new_state;
+  EventJournal::Append(EventJournal::kIceConnectionChange, new_state,
+                       remote_id_.c_str());
   switch (new_state) {
     case webrtc::PeerConnectionInterface::kIceConnectionConnected:
     case webrtc::PeerConnectionInterface::kIceConnectionCompleted:
@@ -684,6 +1028,9 @@ void P2PPeerConnectionChannel::OnIceConnectionChange(
 void P2PPeerConnectionChannel::OnIceGatheringChange(
     PeerConnectionInterface::IceGatheringState new_state) {
   RTC_LOG(LS_INFO) << "Ice gathering state changed: " << new_state;
+  if (new_state == PeerConnectionInterface::kIceGatheringComplete) {
+    FlushBundledSignal();
+  }
 }
 void P2PPeerConnectionChannel::OnIceCandidate(
     const webrtc::IceCandidateInterface* candidate) {
@@ -698,11 +1045,66 @@ void P2PPeerConnectionChannel::OnIceCandidate(
     return;
   }
   signal[kIceCandidateSdpNameKey] = sdp;
+  {
+    std::lock_guard<std::mutex> lock(pending_signal_mutex_);
+    if (has_pending_local_sdp_) {
+      // The local description is being held for bundling; the candidate
+      // travels with it instead of in its own message.
+      pending_candidate_signals_.push_back(signal);
+      return;
+    }
+  }
   Json::Value json;
   json[kMessageTypeKey] = kChatSignal;
   json[kMessageDataKey] = signal;
   SendSignalingMessage(json);
 }
+void P2PPeerConnectionChannel::OnMessage(rtc::Message* msg) {
+  switch (msg->message_id) {
+    case kMessageTypeFlushBundledSignal:
+      FlushBundledSignal();
+      break;
+    case kMessageTypeNegotiationWindowClosed:
+      {
+        std::lock_guard<std::mutex> lock(negotiation_schedule_mutex_);
+        negotiation_scheduled_ = false;
+      }
+      if (SignalingState() ==
+          PeerConnectionInterface::SignalingState::kStable) {
+        CreateOffer();
+      } else {
+        negotiation_needed_ = true;
+      }
+      break;
+    default:
+      PeerConnectionChannel::OnMessage(msg);
+  }
+}
+void P2PPeerConnectionChannel::FlushBundledSignal() {
+  Json::Value signal;
+  std::vector<Json::Value> candidate_signals;
+  {
+    std::lock_guard<std::mutex> lock(pending_signal_mutex_);
+    if (!has_pending_local_sdp_) {
+      return;
+    }
+    signal = pending_local_sdp_signal_;
+    candidate_signals.swap(pending_candidate_signals_);
+    pending_local_sdp_signal_ = Json::Value();
+    has_pending_local_sdp_ = false;
+  }
+  Json::Value candidates(Json::arrayValue);
+  for (auto& candidate_signal : candidate_signals) {
+    candidates.append(candidate_signal);
+  }
+  signal[kSessionDescriptionCandidatesKey] = candidates;
+  Json::Value json;
+  json[kMessageTypeKey] = kChatSignal;
+  json[kMessageDataKey] = signal;
+  RTC_LOG(LS_INFO) << "Sending local description bundled with "
+                   << candidate_signals.size() << " candidates.";
+  SendSignalingMessage(json);
+}
 void P2PPeerConnectionChannel::OnCreateSessionDescriptionSuccess(
     webrtc::SessionDescriptionInterface* desc) {
   RTC_LOG(LS_INFO) << "Create sdp success.";
@@ -757,6 +1159,19 @@ void P2PPeerConnectionChannel::OnSetLocalSessionDescriptionSuccess() {
   Json::Value signal;
   signal[kSessionDescriptionTypeKey] = desc->type();
   signal[kSessionDescriptionSdpKey] = sdp;
+  if (remote_side_supports_bundled_candidates_) {
+    // Half-trickle: hold the description until gathering completes (or
+    // the timeout fires) and send one message carrying the candidates
+    // collected so far, instead of one message per candidate.
+    {
+      std::lock_guard<std::mutex> lock(pending_signal_mutex_);
+      pending_local_sdp_signal_ = signal;
+      has_pending_local_sdp_ = true;
+    }
+    pc_thread_->PostDelayed(RTC_FROM_HERE, kCandidateBundleTimeoutMs, this,
+                            kMessageTypeFlushBundledSignal);
+    return;
+  }
   Json::Value json;
   json[kMessageTypeKey] = kChatSignal;
   json[kMessageDataKey] = signal;
@@ -787,6 +1202,29 @@ void P2PPeerConnectionChannel::OnSetLocalSessionDescriptionFailure(
   Stop(nullptr, nullptr);
 }
 void P2PPeerConnectionChannel::OnSetRemoteSessionDescriptionSuccess() {
+  std::vector<webrtc::IceCandidateInterface*>* batch = nullptr;
+  int64_t oldest_arrival_ms = 0;
+  {
+    std::lock_guard<std::mutex> lock(remote_candidates_mutex_);
+    remote_description_applied_ = true;
+    if (!staged_remote_candidates_.empty()) {
+      batch = new std::vector<webrtc::IceCandidateInterface*>(
+          std::move(staged_remote_candidates_));
+      staged_remote_candidates_.clear();
+      oldest_arrival_ms = staged_candidate_arrival_ms_.front();
+      staged_candidate_arrival_ms_.clear();
+    }
+  }
+  if (batch != nullptr) {
+    RTC_LOG(LS_INFO) << "Applying " << batch->size()
+                     << " staged remote candidate(s) in one batch; oldest "
+                     << "waited " << rtc::TimeMillis() - oldest_arrival_ms
+                     << " ms for the remote description.";
+    pc_thread_->Post(RTC_FROM_HERE, this,
+                     kMessageTypeBatchSetRemoteIceCandidates,
+                     new rtc::TypedMessageData<
+                         std::vector<webrtc::IceCandidateInterface*>*>(batch));
+  }
   PeerConnectionChannel::OnSetRemoteSessionDescriptionSuccess();
 }
 void P2PPeerConnectionChannel::OnSetRemoteSessionDescriptionFailure(
@@ -1114,16 +1552,22 @@ void P2PPeerConnectionChannel::CheckWaitedList() {
   }
 }
 void P2PPeerConnectionChannel::OnDataChannelStateChange() {
-  RTC_CHECK(data_channel_);
-  if (data_channel_->state() ==
-      webrtc::DataChannelInterface::DataState::kOpen) {
+  if (data_channel_ != nullptr &&
+      data_channel_->state() ==
+          webrtc::DataChannelInterface::DataState::kOpen) {
     DrainPendingMessages();
   }
+  DrainPendingBinaryMessages();
 }
 void P2PPeerConnectionChannel::OnDataChannelMessage(
     const webrtc::DataBuffer& buffer) {
   if (buffer.binary) {
-    RTC_LOG(LS_WARNING) << "Binary data is not supported.";
+    std::string data(buffer.data.data<char>(), buffer.data.size());
+    for (std::vector<P2PPeerConnectionChannelObserver*>::iterator it =
+             observers_.begin();
+         it != observers_.end(); ++it) {
+      (*it)->OnBinaryMessageReceived(remote_id_, data);
+    }
     return;
   }
   std::string data = std::string(buffer.data.data<char>(), buffer.data.size());
@@ -1171,45 +1615,121 @@ webrtc::DataBuffer P2PPeerConnectionChannel::CreateDataBuffer(
   return data_buffer;
 }
 void P2PPeerConnectionChannel::DrainPendingMessages() {
-  RTC_LOG(LS_INFO) << "Draining pending messages. Message queue size: "
-                   << pending_messages_.size();
   RTC_CHECK(data_channel_);
+  std::lock_guard<std::mutex> lock(pending_messages_mutex_);
+  RTC_LOG(LS_INFO) << "Draining pending messages. Control queue size: "
+                   << pending_control_messages_.size()
+                   << ", bulk queue size: " << pending_bulk_messages_.size();
+  // Control messages go first, but one bulk message is interleaved after
+  // every burst of control messages so neither class is starved.
+  auto control = pending_control_messages_.begin();
+  auto bulk = pending_bulk_messages_.begin();
+  while (control != pending_control_messages_.end() ||
+         bulk != pending_bulk_messages_.end()) {
+    for (size_t i = 0;
+         i < kControlDrainBurst && control != pending_control_messages_.end();
+         ++i, ++control) {
+      data_channel_->Send(CreateDataBuffer(**control));
+    }
+    if (bulk != pending_bulk_messages_.end()) {
+      data_channel_->Send(CreateDataBuffer(**bulk));
+      ++bulk;
+    }
+  }
+  pending_control_messages_.clear();
+  pending_bulk_messages_.clear();
+}
+void P2PPeerConnectionChannel::DrainPendingBinaryMessages() {
+  std::vector<std::function<void()>> sent_callbacks;
   {
     std::lock_guard<std::mutex> lock(pending_messages_mutex_);
-    for (auto it = pending_messages_.begin(); it != pending_messages_.end();
-         ++it) {
-      data_channel_->Send(CreateDataBuffer(**it));
+    // Labels that cannot take data right now stay blocked for the rest
+    // of the pass so messages on one channel keep their order.
+    std::unordered_map<std::string, bool> blocked_labels;
+    auto it = pending_binary_messages_.begin();
+    while (it != pending_binary_messages_.end()) {
+      if (blocked_labels.find(it->label) != blocked_labels.end()) {
+        ++it;
+        continue;
+      }
+      auto channel_it = binary_data_channels_.find(it->label);
+      if (channel_it == binary_data_channels_.end() ||
+          channel_it->second->state() !=
+              webrtc::DataChannelInterface::DataState::kOpen ||
+          channel_it->second->buffered_amount() + it->data->size() >
+              kMaxDataChannelBufferedAmount) {
+        blocked_labels[it->label] = true;
+        ++it;
+        continue;
+      }
+      channel_it->second->Send(webrtc::DataBuffer(
+          rtc::CopyOnWriteBuffer(it->data->data(), it->data->size()), true));
+      if (it->on_success) {
+        sent_callbacks.push_back(it->on_success);
+      }
+      it = pending_binary_messages_.erase(it);
     }
-    pending_messages_.clear();
+  }
+  for (auto& callback : sent_callbacks) {
+    event_queue_->PostTask(callback);
+  }
+}
+void P2PPeerConnectionChannel::ConfigureDataChannel(
+    const std::string& label,
+    webrtc::DataChannelInit* config) {
+  int max_retransmits = MaxRetransmitsFromLabel(label);
+  if (max_retransmits >= 0) {
+    config->maxRetransmits = max_retransmits;
   }
 }
+void P2PPeerConnectionChannel::OnDataChannelCreated(
+    const std::string& label,
+    rtc::scoped_refptr<webrtc::DataChannelInterface> data_channel) {
+  if (IsBinaryChannelLabel(label)) {
+    std::lock_guard<std::mutex> lock(pending_messages_mutex_);
+    binary_data_channels_[label] = data_channel;
+    return;
+  }
+  data_channel_ = data_channel;
+}
+void P2PPeerConnectionChannel::OnDataChannelBufferedAmountChange(
+    uint64_t previous_amount) {
+  // Buffer space may have been freed; try to push queued binary data.
+  DrainPendingBinaryMessages();
+}
 Json::Value P2PPeerConnectionChannel::UaInfo() {
-  Json::Value ua;
-  // SDK info includes verison and type.
-  Json::Value sdk;
-  SysInfo sys_info = SysInfo::GetInstance();
-  sdk[kUaSdkVersionKey] = sys_info.sdk.version;
-  sdk[kUaSdkTypeKey] = sys_info.sdk.type;
-  // Runtime values  with system information.
-  Json::Value runtime;
-  runtime[kUaRuntimeNameKey] = sys_info.runtime.name;
-  runtime[kUaRuntimeVersionKey] = sys_info.runtime.version;
-  // OS info includes OS name and OS version.
-  Json::Value os;
-  os[kUaOsNameKey] = sys_info.os.name;
-  os[kUaOsVersionKey] = sys_info.os.version;
-  // Capabilities and customized configuration
-  // TODO: currently default to support continual ICE gathering,
-  // Plan-B, and stream removable.
-  Json::Value capabilities;
-  capabilities[kUaContinualGatheringKey] = true;
-  capabilities[kUaUnifiedPlanKey] = true;
-  capabilities[kUaStreamRemovableKey] = true;
-  ua[kUaSdkKey] = sdk;
-  ua[kUaRuntimeKey] = runtime;
-  ua[kUaOsKey] = os;
-  ua[kUaCapabilitiesKey] = capabilities;
-  return ua;
+  // The UA block is identical for every channel in the process, so it is
+  // assembled once and copied from the cache afterwards.
+  static const Json::Value* cached_ua = []() {
+    Json::Value* ua = new Json::Value();
+    // SDK info includes verison and type.
+    Json::Value sdk;
+    const SysInfo& sys_info = SysInfo::GetInstance();
+    sdk[kUaSdkVersionKey] = sys_info.sdk.version;
+    sdk[kUaSdkTypeKey] = sys_info.sdk.type;
+    // Runtime values  with system information.
+    Json::Value runtime;
+    runtime[kUaRuntimeNameKey] = sys_info.runtime.name;
+    runtime[kUaRuntimeVersionKey] = sys_info.runtime.version;
+    // OS info includes OS name and OS version.
+    Json::Value os;
+    os[kUaOsNameKey] = sys_info.os.name;
+    os[kUaOsVersionKey] = sys_info.os.version;
+    // Capabilities and customized configuration
+    // TODO: currently default to support continual ICE gathering,
+    // Plan-B, and stream removable.
+    Json::Value capabilities;
+    capabilities[kUaContinualGatheringKey] = true;
+    capabilities[kUaUnifiedPlanKey] = true;
+    capabilities[kUaStreamRemovableKey] = true;
+    capabilities[kUaBundledCandidatesKey] = true;
+    (*ua)[kUaSdkKey] = sdk;
+    (*ua)[kUaRuntimeKey] = runtime;
+    (*ua)[kUaOsKey] = os;
+    (*ua)[kUaCapabilitiesKey] = capabilities;
+    return ua;
+  }();
+  return *cached_ua;
 }
 void P2PPeerConnectionChannel::HandleRemoteCapability(Json::Value& ua) {
   Json::Value capabilities;
@@ -1221,6 +1741,8 @@ void P2PPeerConnectionChannel::HandleRemoteCapability(Json::Value& ua) {
   remote_side_supports_plan_b_ = !remote_side_supports_unified_plan_;
   rtc::GetBoolFromJsonObject(capabilities, kUaStreamRemovableKey,
                              &remote_side_supports_remove_stream_);
+  rtc::GetBoolFromJsonObject(capabilities, kUaBundledCandidatesKey,
+                             &remote_side_supports_bundled_candidates_);
   RTC_LOG(LS_INFO) << "Remote side supports removing stream? "
                    << remote_side_supports_remove_stream_;
   RTC_LOG(LS_INFO) << "Remote side supports WebRTC Plan B? "
@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: Apache-2.0
 #ifndef WOOGEEN_P2P_P2PPEERCONNECTIONCHANNEL_H_
 #define WOOGEEN_P2P_P2PPEERCONNECTIONCHANNEL_H_
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
@@ -30,6 +31,9 @@ class P2PPeerConnectionChannelObserver {
   // Currently, data is string.
   virtual void OnMessageReceived(const std::string& remote_id,
                                  const std::string& message) = 0;
+  // Triggered when remote user sends binary data via data channel.
+  virtual void OnBinaryMessageReceived(const std::string& remote_id,
+                                       const std::string& message){};
   // Triggered when a new stream is added.
   virtual void OnStreamAdded(
       std::shared_ptr<RemoteStream> stream) = 0;
@@ -76,6 +80,18 @@ class P2PPeerConnectionChannel : public P2PSignalingReceiverInterface,
   void Send(const std::string& message,
             std::function<void()> on_success,
             std::function<void(std::unique_ptr<Exception>)> on_failure);
+  // Send binary data to remote user. The payload is handed to the data
+  // channel without a JSON envelope and is kept as a shared buffer while
+  // queued, so bulk transfer does not copy every chunk. Sends above the
+  // channel's buffered-amount limit are queued and drained as the buffer
+  // empties; |on_success| fires once the payload is accepted by the
+  // channel, which callers can use as a drain signal for flow control.
+  // |max_retransmits| below zero sends reliably; otherwise the payload
+  // travels on a partially reliable channel with that retransmit limit.
+  void Send(std::shared_ptr<const std::string> data,
+            int max_retransmits,
+            std::function<void()> on_success,
+            std::function<void(std::unique_ptr<Exception>)> on_failure);
   // Stop current WebRTC session.
   void Stop(std::function<void()> on_success,
             std::function<void(std::unique_ptr<Exception>)> on_failure);
@@ -91,12 +107,23 @@ class P2PPeerConnectionChannel : public P2PSignalingReceiverInterface,
   std::function<void()> GetLatestPublishSuccessCallback();
   std::function<void(std::unique_ptr<Exception>)> GetLatestPublishFailureCallback();
   bool IsAbandoned();
+  // Restart ICE on this session, regathering candidates while reusing the
+  // existing DTLS and SRTP contexts. Triggered on network interface
+  // changes; deferred until signaling is stable when a negotiation is in
+  // flight.
+  void IceRestart();
  protected:
   void CreateOffer() override;
   void CreateAnswer() override;
   void OnNegotiationNeeded();
   // Received messages from remote client.
   void OnMessageUserAgent(Json::Value& ua);
+  // MessageHandler override; handles the bundled-signal flush timeout
+  // and forwards everything else to PeerConnectionChannel.
+  virtual void OnMessage(rtc::Message* msg) override;
+  // Sends the held local description bundled with the candidates
+  // gathered so far. No-op if nothing is held.
+  void FlushBundledSignal();
   void OnMessageStop();
   void OnMessageSignal(Json::Value& signal);
   void OnMessageTrackSources(Json::Value& track_sources);
@@ -157,10 +184,26 @@ class P2PPeerConnectionChannel : public P2PSignalingReceiverInterface,
   // Set remote capability flags based on UA.
   void HandleRemoteCapability(Json::Value& ua);
   void SendUaInfo();
+  // Sends queued binary messages whose channel is open and under the
+  // buffered-amount limit, preserving order per channel.
+  void DrainPendingBinaryMessages();
+  // PeerConnectionChannel data channel hooks.
+  virtual void ConfigureDataChannel(const std::string& label,
+                                    webrtc::DataChannelInit* config) override;
+  virtual void OnDataChannelCreated(
+      const std::string& label,
+      rtc::scoped_refptr<webrtc::DataChannelInterface> data_channel) override;
+  virtual void OnDataChannelBufferedAmountChange(
+      uint64_t previous_amount) override;
   P2PSignalingSenderInterface* signaling_sender_;
   std::string local_id_;
   std::string remote_id_;
-  SessionState session_state_;
+  // Session state as an atomic word. Checks are wait-free loads and
+  // transitions go through a compare-and-swap against an explicit
+  // transition table in ChangeSessionState, so racing transitions -
+  // glare in particular - resolve to exactly one winner without a lock
+  // that re-entrant callbacks could deadlock on.
+  std::atomic<int> session_state_;
   // Indicates if negotiation needed event is triggered or received negotiation
   // request from remote side, but haven't send out offer.
   bool negotiation_needed_;
@@ -196,11 +239,24 @@ class P2PPeerConnectionChannel : public P2PSignalingReceiverInterface,
                          // "disconnect"
   int reconnect_timeout_;  // Unit: second
   long message_seq_num_; // Message ID to be sent through data channel
-  std::vector<std::shared_ptr<std::string>> pending_messages_;  // Messages need
-                                                                // to be sent
-                                                                // once data
-                                                                // channel is
-                                                                // ready.
+  // A binary message waiting for its channel to open or to drain below
+  // the buffered-amount limit.
+  struct PendingBinaryMessage {
+    std::string label;
+    std::shared_ptr<const std::string> data;
+    std::function<void()> on_success;
+  };
+  // Binary channels keyed by label; one channel per reliability setting.
+  // Guarded by |pending_messages_mutex_|.
+  std::unordered_map<std::string,
+                     rtc::scoped_refptr<webrtc::DataChannelInterface>>
+      binary_data_channels_;
+  std::vector<PendingBinaryMessage> pending_binary_messages_;
+  // Messages waiting for the text channel, split by size: small control
+  // messages must not queue behind bulk payloads. Guarded by
+  // |pending_messages_mutex_|.
+  std::vector<std::shared_ptr<std::string>> pending_control_messages_;
+  std::vector<std::shared_ptr<std::string>> pending_bulk_messages_;
   std::mutex pending_messages_mutex_;
   std::unordered_map<std::string, std::function<void()>> message_success_callbacks_;
   // Indicates whether remote client supports WebRTC Plan B
@@ -210,8 +266,39 @@ class P2PPeerConnectionChannel : public P2PSignalingReceiverInterface,
   bool remote_side_supports_remove_stream_;
   bool remote_side_supports_unified_plan_;
   bool is_creating_offer_;  // It will be true during creating and setting offer.
+  // True while an offer is scheduled for the end of the negotiation
+  // coalescing window. Guarded by |negotiation_schedule_mutex_|.
+  bool negotiation_scheduled_;
+  std::mutex negotiation_schedule_mutex_;
   bool remote_side_supports_continual_ice_gathering_;
+  // True if the remote side announced support for a description bundled
+  // with its candidates. Remote sides that did not announce it keep
+  // receiving fully trickled candidates.
+  bool remote_side_supports_bundled_candidates_;
   std::mutex is_creating_offer_mutex_;
+  // Half-trickle signaling state, guarded by |pending_signal_mutex_|:
+  // the local description is held back while candidates gather and both
+  // are sent as one message. Candidates arriving after the flush are
+  // trickled individually.
+  Json::Value pending_local_sdp_signal_;
+  std::vector<Json::Value> pending_candidate_signals_;
+  bool has_pending_local_sdp_;
+  std::mutex pending_signal_mutex_;
+  // Remote candidate staging, guarded by |remote_candidates_mutex_|.
+  // Candidates arriving while the remote description is still being
+  // negotiated are validated and deduplicated on the signaling thread
+  // and held here; once the description is applied the whole set goes
+  // to the connection thread in one batch. |seen_remote_candidates_|
+  // keeps filtering duplicates trickled after the flush; it holds
+  // 64-bit fingerprints of (mid, m-line index, candidate line) rather
+  // than key strings, so deduplication during a join storm allocates
+  // nothing and duplicates are rejected before the candidate object is
+  // ever parsed.
+  std::vector<webrtc::IceCandidateInterface*> staged_remote_candidates_;
+  std::vector<int64_t> staged_candidate_arrival_ms_;
+  std::vector<uint64_t> seen_remote_candidates_;
+  bool remote_description_applied_;
+  std::mutex remote_candidates_mutex_;
   // Queue for callbacks and events.
   std::shared_ptr<rtc::TaskQueue> event_queue_;
   std::mutex failure_callbacks_mutex_;
@@ -9,6 +9,11 @@ void P2PPeerConnectionChannelObserverCppImpl::OnMessageReceived(
     const std::string& message) {
   peer_client_.OnMessageReceived(remote_id, message);
 }
+void P2PPeerConnectionChannelObserverCppImpl::OnBinaryMessageReceived(
+    const std::string& remote_id,
+    const std::string& message) {
+  peer_client_.OnBinaryMessageReceived(remote_id, message);
+}
 void P2PPeerConnectionChannelObserverCppImpl::OnStreamAdded(
     std::shared_ptr<RemoteStream> stream) {
   peer_client_.OnStreamAdded(stream);
@@ -21,6 +21,9 @@ class P2PPeerConnectionChannelObserverCppImpl
   // Triggered when remote user send data via data channel.
   // Currently, data is string type.
   virtual void OnMessageReceived(const std::string& remote_id, const std::string& message);
+  // Triggered when remote user send binary data via data channel.
+  virtual void OnBinaryMessageReceived(const std::string& remote_id,
+                                       const std::string& message);
   // Triggered when a new stream is added.
   virtual void OnStreamAdded(std::shared_ptr<RemoteStream> stream);
  private:
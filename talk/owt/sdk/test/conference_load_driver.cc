@@ -0,0 +1,247 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Conference load driver. Instantiates N in-process ConferenceClients
+// with synthetic customized video sources against a real server, so SDK
+// scalability changes (pooled capture threads, batched subscribes,
+// channel pre-warming) can be regression-tested before touching a
+// deployment. Clients join on a fixed ramp for run-to-run comparability;
+// per-client join latency and per-subscription time-to-first-frame are
+// reported as distributions, and each client's sampled statistics
+// snapshot is written in the columnar binary format for offline diffing.
+//
+// The server side cannot mint tokens for us, so the driver reads them
+// from a file, one base64 token per line; the line count is the client
+// count. Create the tokens against one room through the REST API.
+//
+// Usage: owt_conference_load_driver <token_file> [duration_seconds]
+//        [ramp_ms] [stats_prefix]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "owt/base/framegeneratorinterface.h"
+#include "owt/base/localcamerastreamparameters.h"
+#include "owt/base/stream.h"
+#include "owt/base/videorendererinterface.h"
+#include "owt/conference/conferenceclient.h"
+namespace {
+using namespace owt::base;
+using namespace owt::conference;
+int64_t NowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+// Generates I420 frames with a moving bar so every encoder sees
+// realistic inter-frame change; the phase offset keeps the N encoders
+// from producing identical bitstreams.
+class SyntheticFrameGenerator : public VideoFrameGeneratorInterface {
+ public:
+  SyntheticFrameGenerator(int width, int height, int fps, int phase)
+      : width_(width), height_(height), fps_(fps), frame_count_(phase) {}
+  uint32_t GenerateNextFrame(uint8_t* buffer,
+                             const uint32_t capacity) override {
+    uint32_t size = GetNextFrameSize();
+    if (capacity < size)
+      return 0;
+    memset(buffer, 128, size);
+    int bar_x = (frame_count_ * 4) % (width_ - 32);
+    for (int row = 0; row < height_; row++) {
+      memset(buffer + row * width_ + bar_x, 220, 32);
+    }
+    frame_count_++;
+    return size;
+  }
+  uint32_t GetNextFrameSize() override {
+    return static_cast<uint32_t>(width_ * height_ * 3 / 2);
+  }
+  int GetHeight() override { return height_; }
+  int GetWidth() override { return width_; }
+  int GetFps() override { return fps_; }
+  VideoFrameCodec GetType() override { return VideoFrameCodec::I420; }
+
+ private:
+  int width_;
+  int height_;
+  int fps_;
+  int frame_count_;
+};
+// Records the time from subscription start to the first rendered frame.
+class TtffRenderer : public VideoRendererInterface {
+ public:
+  TtffRenderer(int64_t subscribe_start_us,
+               std::vector<int64_t>* ttff_us,
+               std::mutex* mutex)
+      : subscribe_start_us_(subscribe_start_us),
+        ttff_us_(ttff_us),
+        mutex_(mutex),
+        got_first_frame_(false) {}
+  void RenderFrame(std::unique_ptr<VideoBuffer> buffer) override {
+    if (got_first_frame_.exchange(true))
+      return;
+    std::lock_guard<std::mutex> lock(*mutex_);
+    ttff_us_->push_back(NowUs() - subscribe_start_us_);
+  }
+  VideoRendererType Type() override { return VideoRendererType::kI420; }
+
+ private:
+  int64_t subscribe_start_us_;
+  std::vector<int64_t>* ttff_us_;
+  std::mutex* mutex_;
+  std::atomic<bool> got_first_frame_;
+};
+// One simulated participant: a client, its published stream, and the
+// renderers pinning TTFF measurements for every subscription.
+struct LoadClient {
+  std::shared_ptr<ConferenceClient> client;
+  std::shared_ptr<LocalStream> stream;
+  std::vector<std::unique_ptr<TtffRenderer>> renderers;
+  int64_t join_latency_us = -1;
+};
+std::mutex g_ttff_mutex;
+std::vector<int64_t> g_ttff_us;
+// Subscribes |remote| on |load| and attaches a TTFF renderer when the
+// subscription lands.
+void SubscribeAndMeasure(LoadClient* load,
+                         std::shared_ptr<RemoteStream> remote) {
+  int64_t start_us = NowUs();
+  std::unique_ptr<TtffRenderer> renderer(
+      new TtffRenderer(start_us, &g_ttff_us, &g_ttff_mutex));
+  TtffRenderer* renderer_ptr = renderer.get();
+  load->renderers.push_back(std::move(renderer));
+  load->client->Subscribe(
+      remote,
+      [remote, renderer_ptr](std::shared_ptr<ConferenceSubscription>) {
+        remote->AttachVideoRenderer(*renderer_ptr);
+      },
+      [](std::unique_ptr<Exception> exception) {
+        printf("Subscribe failed: %s\n", exception->Message().c_str());
+      });
+}
+void ReportDistribution(const char* label, std::vector<int64_t> values_us) {
+  if (values_us.empty()) {
+    printf("%s: no samples.\n", label);
+    return;
+  }
+  std::sort(values_us.begin(), values_us.end());
+  auto percentile = [&](double p) {
+    size_t index = static_cast<size_t>(p * (values_us.size() - 1));
+    return values_us[index] / 1000.0;
+  };
+  printf("%s (ms, %zu samples): p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n",
+         label, values_us.size(), percentile(0.50), percentile(0.90),
+         percentile(0.99), values_us.back() / 1000.0);
+}
+}  // namespace
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    printf("Usage: owt_conference_load_driver <token_file> "
+           "[duration_seconds] [ramp_ms] [stats_prefix]\n");
+    return 1;
+  }
+  std::vector<std::string> tokens;
+  {
+    std::ifstream token_file(argv[1]);
+    std::string line;
+    while (std::getline(token_file, line)) {
+      if (!line.empty())
+        tokens.push_back(line);
+    }
+  }
+  if (tokens.empty()) {
+    printf("No tokens in %s.\n", argv[1]);
+    return 1;
+  }
+  int duration_seconds = argc > 2 ? atoi(argv[2]) : 60;
+  if (duration_seconds <= 0)
+    duration_seconds = 60;
+  int ramp_ms = argc > 3 ? atoi(argv[3]) : 200;
+  if (ramp_ms < 0)
+    ramp_ms = 0;
+  std::string stats_prefix = argc > 4 ? argv[4] : "load_stats_";
+  const int width = 640;
+  const int height = 480;
+  const int fps = 30;
+  printf("Driving %zu clients, %ds steady state, %dms join ramp...\n",
+         tokens.size(), duration_seconds, ramp_ms);
+  std::vector<std::unique_ptr<LoadClient>> clients;
+  for (size_t i = 0; i < tokens.size(); i++) {
+    std::unique_ptr<LoadClient> load(new LoadClient());
+    ConferenceClientConfiguration configuration;
+    load->client = ConferenceClient::Create(configuration);
+    auto parameters = std::make_shared<LocalCustomizedStreamParameters>(
+        false /* audio */, true /* video */);
+    parameters->Resolution(width, height);
+    std::unique_ptr<VideoFrameGeneratorInterface> generator(
+        new SyntheticFrameGenerator(width, height, fps,
+                                    static_cast<int>(i) * 7));
+    load->stream = LocalStream::Create(parameters, std::move(generator));
+    LoadClient* load_ptr = load.get();
+    int64_t join_start_us = NowUs();
+    load->client->Join(
+        tokens[i],
+        [load_ptr, join_start_us](std::shared_ptr<ConferenceInfo> info) {
+          load_ptr->join_latency_us = NowUs() - join_start_us;
+          load_ptr->client->Publish(
+              load_ptr->stream, nullptr,
+              [](std::unique_ptr<Exception> exception) {
+                printf("Publish failed: %s\n",
+                       exception->Message().c_str());
+              });
+          for (auto& remote : info->RemoteStreams()) {
+            SubscribeAndMeasure(load_ptr, remote);
+          }
+        },
+        [](std::unique_ptr<Exception> exception) {
+          printf("Join failed: %s\n", exception->Message().c_str());
+        });
+    load->client->StartStatsSampling(1000);
+    clients.push_back(std::move(load));
+    // Fixed ramp keeps the join storm identical between runs, so two
+    // builds see the same arrival pattern.
+    std::this_thread::sleep_for(std::chrono::milliseconds(ramp_ms));
+  }
+  std::this_thread::sleep_for(std::chrono::seconds(duration_seconds));
+  std::vector<int64_t> join_latencies_us;
+  for (size_t i = 0; i < clients.size(); i++) {
+    if (clients[i]->join_latency_us >= 0)
+      join_latencies_us.push_back(clients[i]->join_latency_us);
+    std::vector<uint8_t> snapshot =
+        clients[i]->client->ExportSampledStatsBinary();
+    if (!snapshot.empty()) {
+      std::string path =
+          stats_prefix + "client" + std::to_string(i) + ".owtc";
+      std::ofstream out(path, std::ios::binary);
+      out.write(reinterpret_cast<const char*>(snapshot.data()),
+                snapshot.size());
+    }
+    clients[i]->client->StopStatsSampling();
+  }
+  ReportDistribution("Join latency", std::move(join_latencies_us));
+  {
+    std::lock_guard<std::mutex> lock(g_ttff_mutex);
+    ReportDistribution("Time to first frame", g_ttff_us);
+  }
+  // Gauges are process wide; one client's view covers every pipeline
+  // stage of the run.
+  printf("Queue depth gauges (current/high watermark):\n");
+  for (auto& entry : clients[0]->client->GetQueueDepthStats()) {
+    printf("  %s: %d/%d\n", entry.gauge.c_str(), entry.depth,
+           entry.high_watermark);
+  }
+  for (auto& load : clients) {
+    load->client->Leave(nullptr, nullptr);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  return 0;
+}
@@ -0,0 +1,306 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// In-process capture-to-render latency harness. Two P2PClients are
+// connected through an in-memory loopback signaling channel; the sender
+// publishes a customized stream whose frame generator stamps the capture
+// time into the luma plane, and the receiver attaches a renderer that
+// reads the stamp back and records the elapsed time. The full SDK
+// pipeline - capturer, encoder, RTP loopback, decoder, renderer - runs
+// exactly as in production, so the reported distribution reflects what
+// an application would see, without two machines and a photodiode.
+//
+// Usage: owt_latency_harness [duration_seconds]
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "owt/base/framegeneratorinterface.h"
+#include "owt/base/localcamerastreamparameters.h"
+#include "owt/base/stream.h"
+#include "owt/base/videorendererinterface.h"
+#include "owt/p2p/p2pclient.h"
+#include "owt/p2p/p2psignalingchannelinterface.h"
+namespace {
+using namespace owt::base;
+using namespace owt::p2p;
+int64_t NowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+// The capture timestamp is written into the top-left of the luma plane as
+// 64 bits, one kStampBlockSize x kStampBlockSize block per bit, white for
+// one and black for zero. Block-sized marks survive lossy encoding; the
+// reader averages each block and thresholds at mid gray.
+const int kStampBlockSize = 8;
+const int kStampBits = 64;
+void WriteTimestamp(uint8_t* y_plane, int width, int64_t timestamp_us) {
+  for (int bit = 0; bit < kStampBits; bit++) {
+    uint8_t value = (timestamp_us >> (kStampBits - 1 - bit)) & 1 ? 235 : 16;
+    int x0 = bit * kStampBlockSize;
+    for (int row = 0; row < kStampBlockSize; row++) {
+      memset(y_plane + row * width + x0, value, kStampBlockSize);
+    }
+  }
+}
+int64_t ReadTimestamp(const uint8_t* y_plane, int width) {
+  int64_t timestamp_us = 0;
+  for (int bit = 0; bit < kStampBits; bit++) {
+    int x0 = bit * kStampBlockSize;
+    int sum = 0;
+    for (int row = 0; row < kStampBlockSize; row++) {
+      for (int col = 0; col < kStampBlockSize; col++) {
+        sum += y_plane[row * width + x0 + col];
+      }
+    }
+    int mean = sum / (kStampBlockSize * kStampBlockSize);
+    timestamp_us = (timestamp_us << 1) | (mean > 128 ? 1 : 0);
+  }
+  return timestamp_us;
+}
+// Generates I420 frames carrying the capture timestamp plus a moving bar
+// so the encoder sees realistic inter-frame change.
+class TimestampFrameGenerator : public VideoFrameGeneratorInterface {
+ public:
+  TimestampFrameGenerator(int width, int height, int fps)
+      : width_(width), height_(height), fps_(fps), frame_count_(0) {}
+  uint32_t GenerateNextFrame(uint8_t* buffer, const uint32_t capacity) override {
+    uint32_t size = GetNextFrameSize();
+    if (capacity < size)
+      return 0;
+    memset(buffer, 128, size);
+    // Moving vertical bar below the stamp rows.
+    int bar_x = (frame_count_ * 4) % (width_ - 32);
+    for (int row = kStampBlockSize; row < height_; row++) {
+      memset(buffer + row * width_ + bar_x, 220, 32);
+    }
+    WriteTimestamp(buffer, width_, NowUs());
+    frame_count_++;
+    return size;
+  }
+  uint32_t GetNextFrameSize() override {
+    return static_cast<uint32_t>(width_ * height_ * 3 / 2);
+  }
+  int GetHeight() override { return height_; }
+  int GetWidth() override { return width_; }
+  int GetFps() override { return fps_; }
+  VideoFrameCodec GetType() override { return VideoFrameCodec::I420; }
+
+ private:
+  int width_;
+  int height_;
+  int fps_;
+  int frame_count_;
+};
+// Reads the stamp out of every rendered frame and records the elapsed
+// time since capture.
+class MeasuringRenderer : public VideoRendererInterface {
+ public:
+  MeasuringRenderer() {}
+  void RenderFrame(std::unique_ptr<VideoBuffer> buffer) override {
+    int64_t now_us = NowUs();
+    if (buffer->type != VideoBufferType::kI420)
+      return;
+    int64_t stamped_us =
+        ReadTimestamp(buffer->buffer,
+                      static_cast<int>(buffer->resolution.width));
+    int64_t latency_us = now_us - stamped_us;
+    // A corrupted stamp decodes to a wild value; drop it rather than
+    // polluting the distribution.
+    if (latency_us < 0 || latency_us > 10 * 1000 * 1000)
+      return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    latencies_us_.push_back(latency_us);
+  }
+  VideoRendererType Type() override { return VideoRendererType::kI420; }
+  std::vector<int64_t> Latencies() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return latencies_us_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<int64_t> latencies_us_;
+};
+// In-memory signaling channel. Two instances are paired; SendMessage
+// enqueues the message for the peer, and a delivery thread per channel
+// hands it to the P2PClient observer. Delivering on a separate thread
+// keeps the loopback from re-entering the client while it is still
+// processing the message that triggered the send.
+class LoopbackSignalingChannel : public P2PSignalingChannelInterface {
+ public:
+  LoopbackSignalingChannel()
+      : peer_(nullptr), observer_(nullptr), stop_(false) {
+    delivery_thread_ =
+        std::thread(&LoopbackSignalingChannel::DeliverLoop, this);
+  }
+  ~LoopbackSignalingChannel() override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    delivery_thread_.join();
+  }
+  void SetPeer(LoopbackSignalingChannel* peer) { peer_ = peer; }
+  void AddObserver(P2PSignalingChannelObserver& observer) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    observer_ = &observer;
+  }
+  void RemoveObserver(P2PSignalingChannelObserver& observer) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (observer_ == &observer)
+      observer_ = nullptr;
+  }
+  void Connect(const std::string& host,
+               const std::string& token,
+               std::function<void(const std::string&)> on_success,
+               std::function<void(std::unique_ptr<Exception>)> on_failure)
+      override {
+    client_id_ = token;
+    if (on_success)
+      on_success(token);
+  }
+  void Disconnect(std::function<void()> on_success,
+                  std::function<void(std::unique_ptr<Exception>)> on_failure)
+      override {
+    if (on_success)
+      on_success();
+  }
+  void SendMessage(const std::string& message,
+                   const std::string& target_id,
+                   std::function<void()> on_success,
+                   std::function<void(std::unique_ptr<Exception>)> on_failure)
+      override {
+    peer_->Enqueue(message, client_id_);
+    if (on_success)
+      on_success();
+  }
+
+ private:
+  void Enqueue(const std::string& message, const std::string& sender) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_.push_back(std::make_pair(message, sender));
+    }
+    wake_.notify_all();
+  }
+  void DeliverLoop() {
+    while (true) {
+      std::pair<std::string, std::string> next;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+        if (stop_ && pending_.empty())
+          return;
+        if (pending_.empty())
+          continue;
+        next = pending_.front();
+        pending_.pop_front();
+        if (!observer_) {
+          // The client has not attached yet; put the message back and
+          // retry shortly.
+          pending_.push_front(next);
+          lock.unlock();
+          std::this_thread::sleep_for(std::chrono::milliseconds(10));
+          continue;
+        }
+      }
+      observer_->OnSignalingMessage(next.first, next.second);
+    }
+  }
+  LoopbackSignalingChannel* peer_;
+  P2PSignalingChannelObserver* observer_;
+  std::string client_id_;
+  bool stop_;
+  std::deque<std::pair<std::string, std::string>> pending_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::thread delivery_thread_;
+};
+class ReceiverObserver : public P2PClientObserver {
+ public:
+  explicit ReceiverObserver(MeasuringRenderer* renderer)
+      : renderer_(renderer) {}
+  void OnStreamAdded(std::shared_ptr<RemoteStream> stream) override {
+    stream->AttachVideoRenderer(*renderer_);
+  }
+
+ private:
+  MeasuringRenderer* renderer_;
+};
+void ReportDistribution(std::vector<int64_t> latencies_us, int64_t elapsed_us) {
+  if (latencies_us.empty()) {
+    printf("No frames rendered; latency distribution unavailable.\n");
+    return;
+  }
+  std::sort(latencies_us.begin(), latencies_us.end());
+  auto percentile = [&](double p) {
+    size_t index = static_cast<size_t>(p * (latencies_us.size() - 1));
+    return latencies_us[index] / 1000.0;
+  };
+  printf("Rendered frames: %zu (%.1f fps)\n", latencies_us.size(),
+         latencies_us.size() * 1e6 / elapsed_us);
+  printf("Capture-to-render latency (ms): p50 %.1f  p90 %.1f  p99 %.1f  "
+         "max %.1f\n",
+         percentile(0.50), percentile(0.90), percentile(0.99),
+         latencies_us.back() / 1000.0);
+}
+}  // namespace
+int main(int argc, char* argv[]) {
+  int duration_seconds = argc > 1 ? atoi(argv[1]) : 10;
+  if (duration_seconds <= 0)
+    duration_seconds = 10;
+  const int width = 640;
+  const int height = 480;
+  const int fps = 30;
+  auto sender_channel = std::make_shared<LoopbackSignalingChannel>();
+  auto receiver_channel = std::make_shared<LoopbackSignalingChannel>();
+  sender_channel->SetPeer(receiver_channel.get());
+  receiver_channel->SetPeer(sender_channel.get());
+  P2PClientConfiguration configuration;
+  auto sender = std::make_shared<P2PClient>(configuration, sender_channel);
+  auto receiver = std::make_shared<P2PClient>(configuration, receiver_channel);
+  MeasuringRenderer renderer;
+  ReceiverObserver receiver_observer(&renderer);
+  receiver->AddObserver(receiver_observer);
+  sender->AddAllowedRemoteId("receiver");
+  receiver->AddAllowedRemoteId("sender");
+  sender->Connect("", "sender", nullptr, nullptr);
+  receiver->Connect("", "receiver", nullptr, nullptr);
+  auto parameters = std::make_shared<LocalCustomizedStreamParameters>(
+      false /* audio */, true /* video */);
+  parameters->Resolution(width, height);
+  std::unique_ptr<VideoFrameGeneratorInterface> generator(
+      new TimestampFrameGenerator(width, height, fps));
+  std::shared_ptr<LocalStream> stream =
+      LocalStream::Create(parameters, std::move(generator));
+  printf("Publishing %dx%d@%dfps over loopback for %d seconds...\n", width,
+         height, fps, duration_seconds);
+  int64_t start_us = NowUs();
+  sender->Publish("receiver", stream,
+                  nullptr,
+                  [](std::unique_ptr<Exception> exception) {
+                    printf("Publish failed: %s\n",
+                           exception->Message().c_str());
+                  });
+  std::this_thread::sleep_for(std::chrono::seconds(duration_seconds));
+  int64_t elapsed_us = NowUs() - start_us;
+  ReportDistribution(renderer.Latencies(), elapsed_us);
+  sender->Stop("receiver", nullptr, nullptr);
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  sender->Disconnect(nullptr, nullptr);
+  receiver->Disconnect(nullptr, nullptr);
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  return 0;
+}
@@ -0,0 +1,180 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "talk/owt/sdk/test/signalingfixtures.h"
+#include <string>
+namespace owt {
+namespace conference {
+namespace test {
+namespace {
+// Codec pools mirror what the MCU advertises; the parser only needs
+// plausible names, not a working pipeline behind them.
+const char* const kAudioCodecs[] = {"opus", "pcmu", "pcma", "g722"};
+const char* const kVideoCodecs[] = {"vp8", "vp9", "h264"};
+const char* const kAudioSources[] = {"mic", "screen-cast"};
+const char* const kVideoSources[] = {"camera", "screen-cast"};
+std::string IndexedId(const char* prefix, int index) {
+  return std::string(prefix) + std::to_string(index);
+}
+sio::message::ptr BuildAudioInfo(FixtureRng* rng) {
+  auto audio = sio::object_message::create();
+  audio->get_map()["source"] = sio::string_message::create(
+      kAudioSources[rng->Next(sizeof(kAudioSources) / sizeof(char*))]);
+  auto format = sio::object_message::create();
+  format->get_map()["codec"] = sio::string_message::create(
+      kAudioCodecs[rng->Next(sizeof(kAudioCodecs) / sizeof(char*))]);
+  audio->get_map()["format"] = format;
+  return audio;
+}
+sio::message::ptr BuildVideoInfo(FixtureRng* rng) {
+  auto video = sio::object_message::create();
+  video->get_map()["source"] = sio::string_message::create(
+      kVideoSources[rng->Next(sizeof(kVideoSources) / sizeof(char*))]);
+  auto format = sio::object_message::create();
+  format->get_map()["codec"] = sio::string_message::create(
+      kVideoCodecs[rng->Next(sizeof(kVideoCodecs) / sizeof(char*))]);
+  video->get_map()["format"] = format;
+  return video;
+}
+}  // namespace
+FixtureRng::FixtureRng(uint64_t seed) : state_(seed != 0 ? seed : 1) {}
+uint32_t FixtureRng::Next(uint32_t bound) {
+  // xorshift64; quality does not matter, determinism does.
+  state_ ^= state_ << 13;
+  state_ ^= state_ >> 7;
+  state_ ^= state_ << 17;
+  return static_cast<uint32_t>(state_ % bound);
+}
+sio::message::ptr BuildForwardStreamInfo(int index, FixtureRng* rng) {
+  auto stream = sio::object_message::create();
+  stream->get_map()["id"] =
+      sio::string_message::create(IndexedId("stream-", index));
+  stream->get_map()["type"] = sio::string_message::create("forward");
+  auto media = sio::object_message::create();
+  media->get_map()["audio"] = BuildAudioInfo(rng);
+  media->get_map()["video"] = BuildVideoInfo(rng);
+  stream->get_map()["media"] = media;
+  auto info = sio::object_message::create();
+  info->get_map()["owner"] =
+      sio::string_message::create(IndexedId("participant-", index));
+  auto attributes = sio::object_message::create();
+  int attribute_count = rng->Next(3);
+  for (int i = 0; i < attribute_count; i++) {
+    attributes->get_map()[IndexedId("attr", i)] =
+        sio::string_message::create(IndexedId("value", rng->Next(100)));
+  }
+  info->get_map()["attributes"] = attributes;
+  stream->get_map()["info"] = info;
+  return stream;
+}
+sio::message::ptr BuildMixedStreamInfo(int index) {
+  auto stream = sio::object_message::create();
+  stream->get_map()["id"] =
+      sio::string_message::create(IndexedId("mixed-stream-", index));
+  stream->get_map()["type"] = sio::string_message::create("mixed");
+  auto media = sio::object_message::create();
+  auto audio = sio::object_message::create();
+  audio->get_map()["source"] = sio::string_message::create("mixed");
+  auto audio_format = sio::object_message::create();
+  audio_format->get_map()["codec"] = sio::string_message::create("opus");
+  audio->get_map()["format"] = audio_format;
+  media->get_map()["audio"] = audio;
+  auto video = sio::object_message::create();
+  video->get_map()["source"] = sio::string_message::create("mixed");
+  auto video_format = sio::object_message::create();
+  video_format->get_map()["codec"] = sio::string_message::create("vp8");
+  video->get_map()["format"] = video_format;
+  media->get_map()["video"] = video;
+  stream->get_map()["media"] = media;
+  auto info = sio::object_message::create();
+  info->get_map()["label"] =
+      sio::string_message::create(IndexedId("common", index));
+  stream->get_map()["info"] = info;
+  return stream;
+}
+std::vector<sio::message::ptr> BuildRoomSnapshot(int stream_count,
+                                                 uint64_t seed) {
+  FixtureRng rng(seed);
+  std::vector<sio::message::ptr> snapshot;
+  snapshot.reserve(stream_count);
+  if (stream_count > 0) {
+    snapshot.push_back(BuildMixedStreamInfo(0));
+  }
+  for (int i = 1; i < stream_count; i++) {
+    snapshot.push_back(BuildForwardStreamInfo(i, &rng));
+  }
+  return snapshot;
+}
+sio::message::ptr BuildUserInfo(int index) {
+  auto user = sio::object_message::create();
+  user->get_map()["id"] =
+      sio::string_message::create(IndexedId("participant-", index));
+  user->get_map()["user"] =
+      sio::string_message::create(IndexedId("user", index));
+  user->get_map()["role"] =
+      sio::string_message::create(index % 2 == 0 ? "presenter" : "viewer");
+  return user;
+}
+sio::message::ptr MutateMessage(const sio::message::ptr& message,
+                                FixtureRng* rng) {
+  if (message == nullptr) {
+    return nullptr;
+  }
+  switch (message->get_flag()) {
+    case sio::message::flag_object: {
+      switch (rng->Next(6)) {
+        case 0:
+          // Flatten the whole object to a scalar.
+          return sio::string_message::create("mutated");
+        case 1:
+          return sio::int_message::create(rng->Next(1000));
+        default:
+          break;
+      }
+      auto copy = sio::object_message::create();
+      for (const auto& entry : message->get_map()) {
+        switch (rng->Next(5)) {
+          case 0:
+            // Drop the key entirely.
+            continue;
+          case 1:
+            copy->get_map()[entry.first] =
+                sio::int_message::create(rng->Next(1000));
+            break;
+          default:
+            copy->get_map()[entry.first] = MutateMessage(entry.second, rng);
+            break;
+        }
+      }
+      return copy;
+    }
+    case sio::message::flag_string:
+      if (rng->Next(4) == 0) {
+        return sio::string_message::create("");
+      }
+      if (rng->Next(4) == 0) {
+        return sio::int_message::create(rng->Next(1000));
+      }
+      return sio::string_message::create(message->get_string());
+    case sio::message::flag_array: {
+      auto copy = sio::array_message::create();
+      for (const auto& element : message->get_vector()) {
+        if (rng->Next(4) != 0) {
+          copy->get_vector().push_back(MutateMessage(element, rng));
+        }
+      }
+      return copy;
+    }
+    case sio::message::flag_integer:
+      return sio::int_message::create(message->get_int());
+    case sio::message::flag_double:
+      return sio::double_message::create(message->get_double());
+    case sio::message::flag_boolean:
+      return sio::bool_message::create(message->get_bool());
+    default:
+      return sio::null_message::create();
+  }
+}
+}  // namespace test
+}  // namespace conference
+}  // namespace owt
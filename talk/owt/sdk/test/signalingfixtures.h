@@ -0,0 +1,53 @@
+// Copyright (C) <2018> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OWT_TEST_SIGNALINGFIXTURES_H_
+#define OWT_TEST_SIGNALINGFIXTURES_H_
+#include <cstdint>
+#include <vector>
+#include "talk/owt/include/sio_message.h"
+// Synthetic signaling fixture corpus for the conference parsers.
+// Captured production payloads cannot ship with the SDK, so room
+// snapshots are generated to the MCU's stream-info schema instead: a
+// corpus entry is the (stream_count, seed) pair, which reproduces the
+// exact same payloads on every run and machine. Snapshots carry one
+// mixed stream per view plus forward streams with owners, sources,
+// formats and attributes, the shape ParseStreamInfo sees when joining a
+// room. The mutator derives schema-breaking variants - dropped fields,
+// retyped fields, emptied strings - from the same seed stream, for
+// fuzzing the parsers with reproducible inputs.
+namespace owt {
+namespace conference {
+namespace test {
+// Deterministic xorshift generator so fixtures do not depend on the
+// platform's rand().
+class FixtureRng {
+ public:
+  explicit FixtureRng(uint64_t seed);
+  // Uniform value in [0, bound).
+  uint32_t Next(uint32_t bound);
+
+ private:
+  uint64_t state_;
+};
+// One forward stream info: id, owner, media with audio/video sources
+// and formats, and a small attribute map. |index| individualizes ids
+// and owners; |rng| varies sources and attribute counts.
+sio::message::ptr BuildForwardStreamInfo(int index, FixtureRng* rng);
+// One mixed stream info with the view label "common<index>".
+sio::message::ptr BuildMixedStreamInfo(int index);
+// A room snapshot of |stream_count| stream infos: one mixed stream and
+// stream_count - 1 forward streams.
+std::vector<sio::message::ptr> BuildRoomSnapshot(int stream_count,
+                                                 uint64_t seed);
+// One participant payload as delivered with user join events.
+sio::message::ptr BuildUserInfo(int index);
+// Deep-copies |message| and applies random structural damage on the
+// way: dropped keys, values retyped to integers, objects flattened to
+// strings, emptied strings. The copy shares nothing with the input.
+sio::message::ptr MutateMessage(const sio::message::ptr& message,
+                                FixtureRng* rng);
+}  // namespace test
+}  // namespace conference
+}  // namespace owt
+#endif  // OWT_TEST_SIGNALINGFIXTURES_H_